@@ -1168,7 +1168,7 @@ static void test_trace_event_params(void)
     }
 
     uret = pEventRegister(NULL, NULL, NULL, &reg_handle);
-    todo_wine ok(uret == ERROR_INVALID_PARAMETER, "EventRegister gave wrong error: %#x\n", uret);
+    ok(uret == ERROR_INVALID_PARAMETER, "EventRegister gave wrong error: %#x\n", uret);
 
     uret = pEventRegister(&test_guid, NULL, NULL, NULL);
     ok(uret == ERROR_INVALID_PARAMETER, "EventRegister gave wrong error: %#x\n", uret);
@@ -1177,13 +1177,13 @@ static void test_trace_event_params(void)
     ok(uret == ERROR_SUCCESS, "EventRegister gave wrong error: %#x\n", uret);
 
     uret = pEventWriteString(0, 0, 0, emptyW);
-    todo_wine ok(uret == ERROR_INVALID_HANDLE, "EventWriteString gave wrong error: %#x\n", uret);
+    ok(uret == ERROR_INVALID_HANDLE, "EventWriteString gave wrong error: %#x\n", uret);
 
     uret = pEventWriteString(reg_handle, 0, 0, NULL);
-    todo_wine ok(uret == ERROR_INVALID_PARAMETER, "EventWriteString gave wrong error: %#x\n", uret);
+    ok(uret == ERROR_INVALID_PARAMETER, "EventWriteString gave wrong error: %#x\n", uret);
 
     uret = pEventUnregister(0);
-    todo_wine ok(uret == ERROR_INVALID_HANDLE, "EventUnregister gave wrong error: %#x\n", uret);
+    ok(uret == ERROR_INVALID_HANDLE, "EventUnregister gave wrong error: %#x\n", uret);
 
     uret = pEventUnregister(reg_handle);
     ok(uret == ERROR_SUCCESS, "EventUnregister gave wrong error: %#x\n", uret);
@@ -0,0 +1,480 @@
+/*
+ * In-process AES-NI implementation of the symmetric AES modes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ */
+
+#include <stdarg.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winbase.h"
+#include "bcrypt.h"
+
+#include "bcrypt_internal.h"
+
+#include "wine/debug.h"
+#include "wine/heap.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(bcrypt);
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+#include <immintrin.h>
+#include <intrin.h>
+
+#define AES_TARGET __attribute__((target("aes,pclmul,ssse3")))
+
+struct aes_key
+{
+    __m128i      enc[15];
+    __m128i      dec[15];
+    __m128i      iv;         /* CBC chaining value */
+    __m128i      h;          /* GCM hash key, byte reversed */
+    __m128i      j0;         /* GCM pre-counter block */
+    __m128i      ctr;        /* GCM counter, byte reversed */
+    __m128i      ghash;      /* GCM hash state, byte reversed */
+    __m128i      keystream;  /* GCM keystream for a partial block */
+    ULONG64      aad_len;
+    ULONG64      data_len;
+    UCHAR        partial[16];
+    ULONG        rounds;
+    enum mode_id mode;
+    BOOL         ready;
+    BOOL         aad_done;
+    void        *mem;
+};
+
+static BOOL have_aes_ni(void)
+{
+    static int supported = -1;
+    int regs[4];
+
+    if (supported != -1) return supported;
+
+    __cpuid( regs, 1 );
+    /* AES-NI, PCLMULQDQ and SSSE3 */
+    return supported = (regs[2] & (1 << 25)) && (regs[2] & (1 << 1)) && (regs[2] & (1 << 9));
+}
+
+static inline AES_TARGET __m128i load_block( const UCHAR *src )
+{
+    return _mm_loadu_si128( (const __m128i *)src );
+}
+
+static inline AES_TARGET void store_block( UCHAR *dst, __m128i block )
+{
+    _mm_storeu_si128( (__m128i *)dst, block );
+}
+
+static inline AES_TARGET __m128i byte_reverse( __m128i block )
+{
+    return _mm_shuffle_epi8( block, _mm_set_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ) );
+}
+
+static inline AES_TARGET __m128i encrypt_block( const struct aes_key *aes, __m128i block )
+{
+    ULONG i;
+
+    block = _mm_xor_si128( block, aes->enc[0] );
+    for (i = 1; i < aes->rounds; i++) block = _mm_aesenc_si128( block, aes->enc[i] );
+    return _mm_aesenclast_si128( block, aes->enc[aes->rounds] );
+}
+
+static inline AES_TARGET __m128i decrypt_block( const struct aes_key *aes, __m128i block )
+{
+    ULONG i;
+
+    block = _mm_xor_si128( block, aes->dec[0] );
+    for (i = 1; i < aes->rounds; i++) block = _mm_aesdec_si128( block, aes->dec[i] );
+    return _mm_aesdeclast_si128( block, aes->dec[aes->rounds] );
+}
+
+static AES_TARGET DWORD sub_word( DWORD word )
+{
+    return _mm_cvtsi128_si32( _mm_aeskeygenassist_si128( _mm_set1_epi32( word ), 0 ) );
+}
+
+static AES_TARGET void expand_key( struct aes_key *aes, const UCHAR *secret, ULONG secret_len )
+{
+    DWORD w[60], tmp, rcon = 1;
+    ULONG i, nk = secret_len / 4;
+
+    aes->rounds = nk + 6;
+    memcpy( w, secret, secret_len );
+    for (i = nk; i < 4 * (aes->rounds + 1); i++)
+    {
+        tmp = w[i - 1];
+        if (!(i % nk))
+        {
+            tmp = sub_word( (tmp >> 8) | (tmp << 24) ) ^ rcon;
+            rcon = ((rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0)) & 0xff;
+        }
+        else if (nk > 6 && i % nk == 4) tmp = sub_word( tmp );
+        w[i] = w[i - nk] ^ tmp;
+    }
+
+    for (i = 0; i <= aes->rounds; i++) aes->enc[i] = load_block( (const UCHAR *)&w[4 * i] );
+    aes->dec[0] = aes->enc[aes->rounds];
+    for (i = 1; i < aes->rounds; i++) aes->dec[i] = _mm_aesimc_si128( aes->enc[aes->rounds - i] );
+    aes->dec[aes->rounds] = aes->enc[0];
+}
+
+/* carry-less multiplication in GF(2^128) on byte reversed operands, see Intel's
+ * "Carry-Less Multiplication Instruction and its Usage for Computing the GCM Mode" */
+static AES_TARGET __m128i gf_mul( __m128i a, __m128i b )
+{
+    __m128i lo, mid, hi, t1, t2, t3;
+
+    lo  = _mm_clmulepi64_si128( a, b, 0x00 );
+    mid = _mm_xor_si128( _mm_clmulepi64_si128( a, b, 0x10 ), _mm_clmulepi64_si128( a, b, 0x01 ) );
+    hi  = _mm_clmulepi64_si128( a, b, 0x11 );
+    lo  = _mm_xor_si128( lo, _mm_slli_si128( mid, 8 ) );
+    hi  = _mm_xor_si128( hi, _mm_srli_si128( mid, 8 ) );
+
+    /* shift the 256-bit product left by one to account for the bit reflection */
+    t1 = _mm_srli_epi32( lo, 31 );
+    t2 = _mm_srli_epi32( hi, 31 );
+    lo = _mm_slli_epi32( lo, 1 );
+    hi = _mm_slli_epi32( hi, 1 );
+    t3 = _mm_srli_si128( t1, 12 );
+    t2 = _mm_slli_si128( t2, 4 );
+    t1 = _mm_slli_si128( t1, 4 );
+    lo = _mm_or_si128( lo, t1 );
+    hi = _mm_or_si128( hi, t2 );
+    hi = _mm_or_si128( hi, t3 );
+
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    t1 = _mm_xor_si128( _mm_xor_si128( _mm_slli_epi32( lo, 31 ), _mm_slli_epi32( lo, 30 ) ),
+                        _mm_slli_epi32( lo, 25 ) );
+    t2 = _mm_srli_si128( t1, 4 );
+    t1 = _mm_slli_si128( t1, 12 );
+    lo = _mm_xor_si128( lo, t1 );
+    t3 = _mm_xor_si128( _mm_xor_si128( _mm_srli_epi32( lo, 1 ), _mm_srli_epi32( lo, 2 ) ),
+                        _mm_srli_epi32( lo, 7 ) );
+    t3 = _mm_xor_si128( t3, t2 );
+    lo = _mm_xor_si128( lo, t3 );
+    return _mm_xor_si128( hi, lo );
+}
+
+static inline AES_TARGET void ghash_block( struct aes_key *aes, const UCHAR *block )
+{
+    aes->ghash = gf_mul( _mm_xor_si128( aes->ghash, byte_reverse( load_block( block ) ) ), aes->h );
+}
+
+static AES_TARGET void ghash_lengths( struct aes_key *aes, ULONG64 len1, ULONG64 len2 )
+{
+    UCHAR block[16];
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        block[7 - i]  = (len1 * 8) >> (8 * i);
+        block[15 - i] = (len2 * 8) >> (8 * i);
+    }
+    ghash_block( aes, block );
+}
+
+static AES_TARGET void gcm_init( struct aes_key *aes, const UCHAR *nonce, ULONG nonce_len )
+{
+    ULONG len = nonce_len;
+    UCHAR block[16];
+
+    aes->h = byte_reverse( encrypt_block( aes, _mm_setzero_si128() ) );
+    aes->ghash = _mm_setzero_si128();
+    if (nonce_len == 12)
+    {
+        memcpy( block, nonce, 12 );
+        block[12] = block[13] = block[14] = 0;
+        block[15] = 1;
+        aes->j0 = load_block( block );
+    }
+    else
+    {
+        for (; nonce_len >= 16; nonce_len -= 16, nonce += 16) ghash_block( aes, nonce );
+        if (nonce_len)
+        {
+            memset( block, 0, sizeof(block) );
+            memcpy( block, nonce, nonce_len );
+            ghash_block( aes, block );
+        }
+        ghash_lengths( aes, 0, len );
+        aes->j0 = byte_reverse( aes->ghash );
+        aes->ghash = _mm_setzero_si128();
+    }
+    aes->ctr = byte_reverse( aes->j0 );
+    aes->aad_len = aes->data_len = 0;
+    aes->aad_done = FALSE;
+}
+
+static AES_TARGET NTSTATUS init_state( struct key *key )
+{
+    struct aes_key *aes = key->u.s.aes;
+
+    if (aes->ready && aes->mode == key->u.s.mode) return STATUS_SUCCESS;
+
+    switch (key->u.s.mode)
+    {
+    case MODE_ID_ECB:
+        break;
+
+    case MODE_ID_CBC:
+        if (key->u.s.vector && key->u.s.vector_len != 16)
+        {
+            WARN( "invalid vector length %u\n", key->u.s.vector_len );
+            return STATUS_INTERNAL_ERROR;
+        }
+        if (key->u.s.vector) aes->iv = load_block( key->u.s.vector );
+        else aes->iv = _mm_setzero_si128();
+        break;
+
+    case MODE_ID_GCM:
+        if (!key->u.s.vector || !key->u.s.vector_len) return STATUS_INTERNAL_ERROR;
+        gcm_init( aes, key->u.s.vector, key->u.s.vector_len );
+        break;
+
+    default:
+        FIXME( "mode %u not supported\n", key->u.s.mode );
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    aes->mode  = key->u.s.mode;
+    aes->ready = TRUE;
+    return STATUS_SUCCESS;
+}
+
+static AES_TARGET void gcm_finish_aad( struct aes_key *aes )
+{
+    ULONG pos = aes->aad_len & 15;
+
+    if (aes->aad_done) return;
+    if (pos)
+    {
+        memset( aes->partial + pos, 0, 16 - pos );
+        ghash_block( aes, aes->partial );
+    }
+    aes->aad_done = TRUE;
+}
+
+static AES_TARGET void gcm_crypt( struct aes_key *aes, const UCHAR *input, ULONG len, UCHAR *output, BOOL encrypt )
+{
+    const __m128i one = _mm_set_epi32( 0, 0, 0, 1 );
+    UCHAR keystream[16];
+    ULONG pos, i, count;
+
+    gcm_finish_aad( aes );
+
+    while (len)
+    {
+        pos = aes->data_len & 15;
+        if (!pos && len >= 16)
+        {
+            __m128i in = load_block( input ), out;
+
+            aes->ctr = _mm_add_epi32( aes->ctr, one );
+            out = _mm_xor_si128( in, encrypt_block( aes, byte_reverse( aes->ctr ) ) );
+            store_block( output, out );
+            aes->ghash = gf_mul( _mm_xor_si128( aes->ghash, byte_reverse( encrypt ? out : in ) ), aes->h );
+            count = 16;
+        }
+        else
+        {
+            if (!pos)
+            {
+                aes->ctr = _mm_add_epi32( aes->ctr, one );
+                aes->keystream = encrypt_block( aes, byte_reverse( aes->ctr ) );
+            }
+            store_block( keystream, aes->keystream );
+            count = min( 16 - pos, len );
+            for (i = 0; i < count; i++)
+            {
+                aes->partial[pos + i] = encrypt ? input[i] ^ keystream[pos + i] : input[i];
+                output[i] = input[i] ^ keystream[pos + i];
+            }
+            if (pos + count == 16) ghash_block( aes, aes->partial );
+        }
+        aes->data_len += count;
+        input += count;
+        output += count;
+        len -= count;
+    }
+}
+
+AES_TARGET NTSTATUS aes_set_auth_data( struct key *key, UCHAR *auth_data, ULONG len )
+{
+    struct aes_key *aes = key->u.s.aes;
+    ULONG pos, count;
+    NTSTATUS status;
+
+    if (!auth_data) return STATUS_SUCCESS;
+    if ((status = init_state( key ))) return status;
+    if (aes->mode != MODE_ID_GCM || aes->aad_done) return STATUS_INTERNAL_ERROR;
+
+    while (len)
+    {
+        pos = aes->aad_len & 15;
+        count = min( 16 - pos, len );
+        memcpy( aes->partial + pos, auth_data, count );
+        if (pos + count == 16) ghash_block( aes, aes->partial );
+        aes->aad_len += count;
+        auth_data += count;
+        len -= count;
+    }
+    return STATUS_SUCCESS;
+}
+
+static AES_TARGET NTSTATUS aes_crypt( struct key *key, const UCHAR *input, ULONG input_len, UCHAR *output,
+                                      ULONG output_len, BOOL encrypt )
+{
+    struct aes_key *aes = key->u.s.aes;
+    NTSTATUS status;
+    __m128i block;
+
+    if ((status = init_state( key ))) return status;
+    if (output_len < input_len) return STATUS_BUFFER_TOO_SMALL;
+
+    if (aes->mode == MODE_ID_GCM)
+    {
+        gcm_crypt( aes, input, input_len, output, encrypt );
+        return STATUS_SUCCESS;
+    }
+
+    if (input_len & 15) return STATUS_INVALID_BUFFER_SIZE;
+    for (; input_len; input_len -= 16, input += 16, output += 16)
+    {
+        block = load_block( input );
+        if (aes->mode == MODE_ID_ECB)
+            block = encrypt ? encrypt_block( aes, block ) : decrypt_block( aes, block );
+        else if (encrypt)
+            block = aes->iv = encrypt_block( aes, _mm_xor_si128( block, aes->iv ) );
+        else
+        {
+            __m128i next = block;
+            block = _mm_xor_si128( decrypt_block( aes, block ), aes->iv );
+            aes->iv = next;
+        }
+        store_block( output, block );
+    }
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS aes_encrypt( struct key *key, const UCHAR *input, ULONG input_len, UCHAR *output, ULONG output_len )
+{
+    return aes_crypt( key, input, input_len, output, output_len, TRUE );
+}
+
+NTSTATUS aes_decrypt( struct key *key, const UCHAR *input, ULONG input_len, UCHAR *output, ULONG output_len )
+{
+    return aes_crypt( key, input, input_len, output, output_len, FALSE );
+}
+
+AES_TARGET NTSTATUS aes_get_tag( struct key *key, UCHAR *tag, ULONG len )
+{
+    struct aes_key *aes = key->u.s.aes;
+    ULONG pos;
+    UCHAR buf[16];
+    NTSTATUS status;
+
+    if ((status = init_state( key ))) return status;
+    if (aes->mode != MODE_ID_GCM) return STATUS_INTERNAL_ERROR;
+
+    gcm_finish_aad( aes );
+    if ((pos = aes->data_len & 15))
+    {
+        memset( aes->partial + pos, 0, 16 - pos );
+        ghash_block( aes, aes->partial );
+    }
+    ghash_lengths( aes, aes->aad_len, aes->data_len );
+    store_block( buf, _mm_xor_si128( byte_reverse( aes->ghash ), encrypt_block( aes, aes->j0 ) ) );
+    memcpy( tag, buf, min( len, sizeof(buf) ) );
+
+    /* the tag finalizes the hash, further data needs a new vector */
+    aes->ready = FALSE;
+    return STATUS_SUCCESS;
+}
+
+void aes_vector_reset( struct key *key )
+{
+    key->u.s.aes->ready = FALSE;
+}
+
+AES_TARGET NTSTATUS aes_init( struct key *key )
+{
+    struct aes_key *aes;
+    void *mem;
+
+    if (key->alg_id != ALG_ID_AES || !have_aes_ni()) return STATUS_NOT_SUPPORTED;
+    if (key->u.s.secret_len != 16 && key->u.s.secret_len != 24 && key->u.s.secret_len != 32)
+        return STATUS_NOT_SUPPORTED;
+
+    /* the heap only guarantees 8-byte alignment on 32-bit */
+    if (!(mem = heap_alloc_zero( sizeof(*aes) + 15 ))) return STATUS_NO_MEMORY;
+    aes = (struct aes_key *)(((ULONG_PTR)mem + 15) & ~(ULONG_PTR)15);
+    aes->mem = mem;
+    expand_key( aes, key->u.s.secret, key->u.s.secret_len );
+
+    TRACE( "using AES-NI for key %p\n", key );
+    key->u.s.aes = aes;
+    return STATUS_SUCCESS;
+}
+
+void aes_destroy( struct key *key )
+{
+    struct aes_key *aes = key->u.s.aes;
+
+    if (!aes) return;
+    SecureZeroMemory( aes, sizeof(*aes) - sizeof(aes->mem) );
+    heap_free( aes->mem );
+    key->u.s.aes = NULL;
+}
+
+#else
+
+NTSTATUS aes_init( struct key *key )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+void aes_vector_reset( struct key *key )
+{
+}
+
+NTSTATUS aes_set_auth_data( struct key *key, UCHAR *auth_data, ULONG len )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS aes_encrypt( struct key *key, const UCHAR *input, ULONG input_len, UCHAR *output, ULONG output_len )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS aes_decrypt( struct key *key, const UCHAR *input, ULONG input_len, UCHAR *output, ULONG output_len )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS aes_get_tag( struct key *key, UCHAR *tag, ULONG len )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+void aes_destroy( struct key *key )
+{
+}
+
+#endif
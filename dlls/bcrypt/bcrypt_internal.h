@@ -158,6 +158,8 @@ struct algorithm
     ULONG         flags;
 };
 
+struct aes_key;
+
 struct key_symmetric
 {
     enum mode_id mode;
@@ -166,6 +168,7 @@ struct key_symmetric
     ULONG        vector_len;
     UCHAR       *secret;
     ULONG        secret_len;
+    struct aes_key *aes;      /* in-process AES-NI state, if supported */
     CRITICAL_SECTION cs;
 };
 
@@ -228,4 +231,12 @@ struct key_funcs
     NTSTATUS (CDECL *key_secret_agreement)( struct key *, struct key *, struct secret * );
 };
 
+NTSTATUS aes_init( struct key * ) DECLSPEC_HIDDEN;
+void     aes_vector_reset( struct key * ) DECLSPEC_HIDDEN;
+NTSTATUS aes_set_auth_data( struct key *, UCHAR *, ULONG ) DECLSPEC_HIDDEN;
+NTSTATUS aes_encrypt( struct key *, const UCHAR *, ULONG, UCHAR *, ULONG ) DECLSPEC_HIDDEN;
+NTSTATUS aes_decrypt( struct key *, const UCHAR *, ULONG, UCHAR *, ULONG ) DECLSPEC_HIDDEN;
+NTSTATUS aes_get_tag( struct key *, UCHAR *, ULONG ) DECLSPEC_HIDDEN;
+void     aes_destroy( struct key * ) DECLSPEC_HIDDEN;
+
 #endif /* __BCRYPT_INTERNAL_H */
@@ -1051,7 +1051,11 @@ static NTSTATUS key_symmetric_set_vector( struct key *key, UCHAR *vector, ULONG
         memcpy( key->u.s.vector, vector, vector_len );
         key->u.s.vector_len = vector_len;
     }
-    if (needs_reset) key_funcs->key_symmetric_vector_reset( key );
+    if (needs_reset)
+    {
+        if (key->u.s.aes) aes_vector_reset( key );
+        else key_funcs->key_symmetric_vector_reset( key );
+    }
     return STATUS_SUCCESS;
 }
 
@@ -1164,6 +1168,39 @@ static NTSTATUS key_export( struct key *key, const WCHAR *type, UCHAR *output, U
     return STATUS_NOT_IMPLEMENTED;
 }
 
+/* AES keys are handled in-process when the CPU supports it, avoiding a backend call per block */
+static NTSTATUS symmetric_set_auth_data( struct key *key, UCHAR *auth_data, ULONG len )
+{
+    if (key->u.s.aes) return aes_set_auth_data( key, auth_data, len );
+    return key_funcs->key_symmetric_set_auth_data( key, auth_data, len );
+}
+
+static NTSTATUS symmetric_encrypt( struct key *key, const UCHAR *input, ULONG input_len, UCHAR *output,
+                                   ULONG output_len )
+{
+    if (key->u.s.aes) return aes_encrypt( key, input, input_len, output, output_len );
+    return key_funcs->key_symmetric_encrypt( key, input, input_len, output, output_len );
+}
+
+static NTSTATUS symmetric_decrypt( struct key *key, const UCHAR *input, ULONG input_len, UCHAR *output,
+                                   ULONG output_len )
+{
+    if (key->u.s.aes) return aes_decrypt( key, input, input_len, output, output_len );
+    return key_funcs->key_symmetric_decrypt( key, input, input_len, output, output_len );
+}
+
+static NTSTATUS symmetric_get_tag( struct key *key, UCHAR *tag, ULONG len )
+{
+    if (key->u.s.aes) return aes_get_tag( key, tag, len );
+    return key_funcs->key_symmetric_get_tag( key, tag, len );
+}
+
+/* ECB through the backend needs a vector reset per block, everything else keeps its chaining state */
+static BOOL can_batch_blocks( const struct key *key )
+{
+    return key->u.s.aes || key->u.s.mode != MODE_ID_ECB;
+}
+
 static NTSTATUS key_symmetric_encrypt( struct key *key,  UCHAR *input, ULONG input_len, void *padding, UCHAR *iv,
                                        ULONG iv_len, UCHAR *output, ULONG output_len, ULONG *ret_len, ULONG flags )
 {
@@ -1196,11 +1233,11 @@ static NTSTATUS key_symmetric_encrypt( struct key *key,  UCHAR *input, ULONG inp
         if (input && !output) return STATUS_SUCCESS;
         if (output_len < *ret_len) return STATUS_BUFFER_TOO_SMALL;
 
-        if ((status = key_funcs->key_symmetric_set_auth_data( key, auth_info->pbAuthData, auth_info->cbAuthData )))
+        if ((status = symmetric_set_auth_data( key, auth_info->pbAuthData, auth_info->cbAuthData )))
             return status;
-        if ((status = key_funcs->key_symmetric_encrypt( key, input, input_len, output, output_len ))) return status;
+        if ((status = symmetric_encrypt( key, input, input_len, output, output_len ))) return status;
 
-        return key_funcs->key_symmetric_get_tag( key, auth_info->pbTag, auth_info->cbTag );
+        return symmetric_get_tag( key, auth_info->pbTag, auth_info->cbTag );
     }
 
     *ret_len = input_len;
@@ -1217,9 +1254,18 @@ static NTSTATUS key_symmetric_encrypt( struct key *key,  UCHAR *input, ULONG inp
 
     src = input;
     dst = output;
+    if (can_batch_blocks( key ) && bytes_left >= key->u.s.block_size)
+    {
+        ULONG len = bytes_left & ~(key->u.s.block_size - 1);
+
+        if ((status = symmetric_encrypt( key, src, len, dst, len ))) return status;
+        bytes_left -= len;
+        src += len;
+        dst += len;
+    }
     while (bytes_left >= key->u.s.block_size)
     {
-        if ((status = key_funcs->key_symmetric_encrypt( key, src, key->u.s.block_size, dst, key->u.s.block_size )))
+        if ((status = symmetric_encrypt( key, src, key->u.s.block_size, dst, key->u.s.block_size )))
             return status;
         if (key->u.s.mode == MODE_ID_ECB && (status = key_symmetric_set_vector( key, NULL, 0 )))
             return status;
@@ -1233,7 +1279,7 @@ static NTSTATUS key_symmetric_encrypt( struct key *key,  UCHAR *input, ULONG inp
         if (!(buf = heap_alloc( key->u.s.block_size ))) return STATUS_NO_MEMORY;
         memcpy( buf, src, bytes_left );
         memset( buf + bytes_left, key->u.s.block_size - bytes_left, key->u.s.block_size - bytes_left );
-        status = key_funcs->key_symmetric_encrypt( key, buf, key->u.s.block_size, dst, key->u.s.block_size );
+        status = symmetric_encrypt( key, buf, key->u.s.block_size, dst, key->u.s.block_size );
         heap_free( buf );
     }
 
@@ -1265,11 +1311,11 @@ static NTSTATUS key_symmetric_decrypt( struct key *key, UCHAR *input, ULONG inpu
         if (!output) return STATUS_SUCCESS;
         if (output_len < *ret_len) return STATUS_BUFFER_TOO_SMALL;
 
-        if ((status = key_funcs->key_symmetric_set_auth_data( key, auth_info->pbAuthData, auth_info->cbAuthData )))
+        if ((status = symmetric_set_auth_data( key, auth_info->pbAuthData, auth_info->cbAuthData )))
             return status;
-        if ((status = key_funcs->key_symmetric_decrypt( key, input, input_len, output, output_len ))) return status;
+        if ((status = symmetric_decrypt( key, input, input_len, output, output_len ))) return status;
 
-        if ((status = key_funcs->key_symmetric_get_tag( key, tag, sizeof(tag) ))) return status;
+        if ((status = symmetric_get_tag( key, tag, sizeof(tag) ))) return status;
         if (memcmp( tag, auth_info->pbTag, auth_info->cbTag )) return STATUS_AUTH_TAG_MISMATCH;
 
         return STATUS_SUCCESS;
@@ -1292,9 +1338,18 @@ static NTSTATUS key_symmetric_decrypt( struct key *key, UCHAR *input, ULONG inpu
 
     src = input;
     dst = output;
+    if (can_batch_blocks( key ) && bytes_left >= key->u.s.block_size)
+    {
+        ULONG len = bytes_left & ~(key->u.s.block_size - 1);
+
+        if ((status = symmetric_decrypt( key, src, len, dst, len ))) return status;
+        bytes_left -= len;
+        src += len;
+        dst += len;
+    }
     while (bytes_left >= key->u.s.block_size)
     {
-        if ((status = key_funcs->key_symmetric_decrypt( key, src, key->u.s.block_size, dst, key->u.s.block_size )))
+        if ((status = symmetric_decrypt( key, src, key->u.s.block_size, dst, key->u.s.block_size )))
             return status;
         if (key->u.s.mode == MODE_ID_ECB && (status = key_symmetric_set_vector( key, NULL, 0 )))
             return status;
@@ -1306,7 +1361,7 @@ static NTSTATUS key_symmetric_decrypt( struct key *key, UCHAR *input, ULONG inpu
     if (flags & BCRYPT_BLOCK_PADDING)
     {
         if (!(buf = heap_alloc( key->u.s.block_size ))) return STATUS_NO_MEMORY;
-        status = key_funcs->key_symmetric_decrypt( key, src, key->u.s.block_size, buf, key->u.s.block_size );
+        status = symmetric_decrypt( key, src, key->u.s.block_size, buf, key->u.s.block_size );
         if (!status && buf[ key->u.s.block_size - 1 ] <= key->u.s.block_size)
         {
             *ret_len -= buf[ key->u.s.block_size - 1 ];
@@ -1594,6 +1649,7 @@ NTSTATUS WINAPI BCryptGenerateSymmetricKey( BCRYPT_ALG_HANDLE algorithm, BCRYPT_
         heap_free( key );
         return status;
     }
+    aes_init( key );
 
     *handle = key;
     return STATUS_SUCCESS;
@@ -1688,6 +1744,7 @@ static NTSTATUS key_duplicate( struct key *key_orig, struct key *key_copy )
         key_copy->u.s.secret     = buffer;
         key_copy->u.s.secret_len = key_orig->u.s.secret_len;
         InitializeCriticalSection( &key_copy->u.s.cs );
+        aes_init( key_copy );
     }
     else
     {
@@ -1718,6 +1775,7 @@ static void key_destroy( struct key *key )
     if (key_is_symmetric( key ))
     {
         key_funcs->key_symmetric_destroy( key );
+        aes_destroy( key );
         heap_free( key->u.s.vector );
         heap_free( key->u.s.secret );
         DeleteCriticalSection( &key->u.s.cs );
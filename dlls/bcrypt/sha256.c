@@ -22,6 +22,12 @@
 
 #include "bcrypt_internal.h"
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#include <intrin.h>
+#define HAVE_SHA_EXT
+#endif
+
 static DWORD ror(DWORD n, int k) { return (n >> k) | (n << (32-k)); }
 #define Ch(x,y,z)  (z ^ (x & (y ^ z)))
 #define Maj(x,y,z) ((x & y) | (z & (x | y)))
@@ -91,6 +97,90 @@ static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
     ctx->h[7] += h;
 }
 
+#ifdef HAVE_SHA_EXT
+
+static BOOL have_sha_ext(void)
+{
+    static int supported = -1;
+    int regs[4], ecx;
+
+    if (supported != -1) return supported;
+
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return supported = FALSE;
+    __cpuid(regs, 1);
+    ecx = regs[2];
+    __cpuidex(regs, 7, 0);
+    /* SHA extensions, SSSE3 and SSE4.1 */
+    return supported = (regs[1] & (1 << 29)) && (ecx & (1 << 9)) && (ecx & (1 << 19));
+}
+
+/* Processes four rounds per step, the message schedule for step i + 4 is computed
+ * from the words of steps i to i + 3 while they are in flight. */
+__attribute__((target("sha,sse4.1")))
+static void processblocks_sha_ext(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abef, cdgh, msg, tmp, w[4];
+    int i;
+
+    tmp    = _mm_loadu_si128((const __m128i *)&ctx->h[0]);
+    state1 = _mm_loadu_si128((const __m128i *)&ctx->h[4]);
+    tmp    = _mm_shuffle_epi32(tmp, 0xb1);          /* CDAB */
+    state1 = _mm_shuffle_epi32(state1, 0x1b);       /* EFGH */
+    state0 = _mm_alignr_epi8(tmp, state1, 8);       /* ABEF */
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);    /* CDGH */
+
+    while (count--)
+    {
+        abef = state0;
+        cdgh = state1;
+
+        for (i = 0; i < 4; i++)
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 16 * i)), mask);
+
+        for (i = 0; i < 16; i++)
+        {
+            msg    = _mm_add_epi32(w[i & 3], _mm_loadu_si128((const __m128i *)&K[4 * i]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg    = _mm_shuffle_epi32(msg, 0x0e);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+            if (i >= 12) continue;
+            tmp = _mm_add_epi32(_mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]),
+                                _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+            w[i & 3] = _mm_sha256msg2_epu32(tmp, w[(i + 3) & 3]);
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        buffer += 64;
+    }
+
+    tmp    = _mm_shuffle_epi32(state0, 0x1b);       /* FEBA */
+    state1 = _mm_shuffle_epi32(state1, 0xb1);       /* DCHG */
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0);    /* DCBA */
+    state1 = _mm_alignr_epi8(state1, tmp, 8);       /* HGFE */
+
+    _mm_storeu_si128((__m128i *)&ctx->h[0], state0);
+    _mm_storeu_si128((__m128i *)&ctx->h[4], state1);
+}
+
+#endif
+
+static void processblocks(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+#ifdef HAVE_SHA_EXT
+    if (have_sha_ext())
+    {
+        processblocks_sha_ext(ctx, buffer, count);
+        return;
+    }
+#endif
+    for (; count; count--, buffer += 64)
+        processblock(ctx, buffer);
+}
+
 static void pad(SHA256_CTX *ctx)
 {
     ULONG64 r = ctx->len % 64;
@@ -101,7 +191,7 @@ static void pad(SHA256_CTX *ctx)
     {
         memset(ctx->buf + r, 0, 64 - r);
         r = 0;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
 
     memset(ctx->buf + r, 0, 56 - r);
@@ -115,7 +205,7 @@ static void pad(SHA256_CTX *ctx)
     ctx->buf[62] = ctx->len >> 8;
     ctx->buf[63] = ctx->len;
 
-    processblock(ctx, ctx->buf);
+    processblocks(ctx, ctx->buf, 1);
 }
 
 void sha256_init(SHA256_CTX *ctx)
@@ -147,10 +237,11 @@ void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
         memcpy(ctx->buf + r, p, 64 - r);
         len -= 64 - r;
         p += 64 - r;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
-    for (; len >= 64; len -= 64, p += 64)
-        processblock(ctx, p);
+    processblocks(ctx, p, len / 64);
+    p += len & ~63;
+    len &= 63;
     memcpy(ctx->buf, p, len);
 }
 
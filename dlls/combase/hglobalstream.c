@@ -33,9 +33,26 @@ struct handle_wrapper
     LONG ref;
     HGLOBAL hglobal;
     ULONG size;
+    ULONG capacity;
     BOOL delete_on_release;
 };
 
+/* give back the slack left by geometric growth, the hglobal may be used
+ * directly by the caller once it's out of our hands */
+static void handle_trim(struct handle_wrapper *handle)
+{
+    HGLOBAL hglobal;
+
+    if (handle->capacity == handle->size)
+        return;
+
+    if ((hglobal = GlobalReAlloc(handle->hglobal, handle->size, GMEM_MOVEABLE)))
+    {
+        handle->hglobal = hglobal;
+        handle->capacity = handle->size;
+    }
+}
+
 static void handle_addref(struct handle_wrapper *handle)
 {
     InterlockedIncrement(&handle->ref);
@@ -48,6 +65,7 @@ static void handle_release(struct handle_wrapper *handle)
     if (!ref)
     {
         if (handle->delete_on_release) GlobalFree(handle->hglobal);
+        else handle_trim(handle);
         HeapFree(GetProcessHeap(), 0, handle);
     }
 }
@@ -69,6 +87,7 @@ static struct handle_wrapper *handle_create(HGLOBAL hglobal, BOOL delete_on_rele
     handle->ref = 1;
     handle->hglobal = hglobal;
     handle->size = GlobalSize(hglobal);
+    handle->capacity = handle->size;
     handle->delete_on_release = delete_on_release;
 
     return handle;
@@ -191,16 +210,28 @@ static HRESULT WINAPI stream_Write(IStream *iface, const void *pv, ULONG cb, ULO
     size.u.HighPart = 0;
     size.u.LowPart = stream->position.u.LowPart + cb;
 
-    if (size.u.LowPart > stream->handle->size)
+    if (size.u.LowPart > stream->handle->capacity)
     {
-        /* grow stream */
-        HRESULT hr = IStream_SetSize(iface, size);
-        if (FAILED(hr))
+        /* grow stream, doubling the allocation so that a series of small
+         * writes doesn't reallocate each time */
+        ULONG capacity = max(size.u.LowPart, 256);
+        HGLOBAL hglobal;
+
+        if (stream->handle->capacity < 0x80000000)
+            capacity = max(capacity, stream->handle->capacity * 2);
+
+        hglobal = GlobalReAlloc(stream->handle->hglobal, capacity, GMEM_MOVEABLE);
+        if (!hglobal)
         {
-            ERR("IStream_SetSize failed with error 0x%08x\n", hr);
-            return hr;
+            ERR("Failed to grow hglobal %p to %u bytes\n", stream->handle->hglobal, capacity);
+            return E_OUTOFMEMORY;
         }
+
+        stream->handle->hglobal = hglobal;
+        stream->handle->capacity = capacity;
     }
+    if (size.u.LowPart > stream->handle->size)
+        stream->handle->size = size.u.LowPart;
 
     buffer = GlobalLock(stream->handle->hglobal);
     if (!buffer)
@@ -278,22 +309,18 @@ static HRESULT WINAPI stream_SetSize(IStream *iface, ULARGE_INTEGER size)
 
     stream->handle->hglobal = hglobal;
     stream->handle->size = size.u.LowPart;
+    stream->handle->capacity = size.u.LowPart;
 
     return S_OK;
 }
 
-static HRESULT WINAPI stream_CopyTo(IStream *iface, IStream *dest, ULARGE_INTEGER cb,
+static HRESULT stream_copy_buffered(IStream *iface, IStream *dest, ULARGE_INTEGER cb,
         ULARGE_INTEGER *read_len, ULARGE_INTEGER *written)
 {
     ULARGE_INTEGER total_read, total_written;
     HRESULT hr = S_OK;
     BYTE buffer[128];
 
-    TRACE("%p, %p, %d, %p, %p\n", iface, dest, cb.u.LowPart, read_len, written);
-
-    if (!dest)
-        return STG_E_INVALIDPOINTER;
-
     total_read.QuadPart = 0;
     total_written.QuadPart = 0;
 
@@ -331,6 +358,54 @@ static HRESULT WINAPI stream_CopyTo(IStream *iface, IStream *dest, ULARGE_INTEGE
     return hr;
 }
 
+static HRESULT WINAPI stream_CopyTo(IStream *iface, IStream *dest, ULARGE_INTEGER cb,
+        ULARGE_INTEGER *read_len, ULARGE_INTEGER *written)
+{
+    struct hglobal_stream *stream = impl_from_IStream(iface);
+    ULONG len, chunk_written = 0;
+    HRESULT hr = S_OK;
+    char *buffer;
+
+    TRACE("%p, %p, %d, %p, %p\n", iface, dest, cb.u.LowPart, read_len, written);
+
+    if (!dest)
+        return STG_E_INVALIDPOINTER;
+
+    /* writing may move our own block, so copying within the same handle has
+     * to go through an intermediate buffer */
+    if (dest->lpVtbl == &hglobalstreamvtbl && impl_from_IStream(dest)->handle == stream->handle)
+        return stream_copy_buffered(iface, dest, cb, read_len, written);
+
+    if (stream->position.u.LowPart < stream->handle->size)
+        len = min(stream->handle->size - stream->position.u.LowPart, cb.QuadPart);
+    else
+        len = 0;
+
+    /* hand the whole range to the destination straight from our block */
+    if (len)
+    {
+        if (!(buffer = GlobalLock(stream->handle->hglobal)))
+        {
+            WARN("Failed to lock hglobal %p\n", stream->handle->hglobal);
+            len = 0;
+        }
+        else
+        {
+            hr = IStream_Write(dest, buffer + stream->position.u.LowPart, len, &chunk_written);
+            GlobalUnlock(stream->handle->hglobal);
+            stream->position.u.LowPart += len;
+            if (FAILED(hr)) chunk_written = 0;
+        }
+    }
+
+    if (read_len)
+        read_len->QuadPart = len;
+    if (written)
+        written->QuadPart = chunk_written;
+
+    return hr;
+}
+
 static HRESULT WINAPI stream_Commit(IStream *iface, DWORD flags)
 {
     return S_OK;
@@ -444,7 +519,10 @@ HRESULT WINAPI GetHGlobalFromStream(IStream *stream, HGLOBAL *phglobal)
     object = impl_from_IStream(stream);
 
     if (object->IStream_iface.lpVtbl == &hglobalstreamvtbl)
+    {
+        handle_trim(object->handle);
         *phglobal = object->handle->hglobal;
+    }
     else
     {
         *phglobal = 0;
@@ -123,6 +123,7 @@ struct message_state
     /* client only */
     HWND target_hwnd;
     DWORD target_tid;
+    BOOL target_mta; /* object lives in the multi-threaded apartment of this process */
     struct dispatch_params params;
 };
 
@@ -1105,6 +1106,7 @@ static HRESULT WINAPI ClientRpcChannelBuffer_GetBuffer(LPRPCCHANNELBUFFER iface,
     message_state->channel_hook_info.pObject = NULL; /* only present on server-side */
     message_state->target_hwnd = NULL;
     message_state->target_tid = 0;
+    message_state->target_mta = FALSE;
     memset(&message_state->params, 0, sizeof(message_state->params));
 
     extensions_size = ChannelHooks_ClientGetSize(&message_state->channel_hook_info,
@@ -1125,15 +1127,13 @@ static HRESULT WINAPI ClientRpcChannelBuffer_GetBuffer(LPRPCCHANNELBUFFER iface,
                                   &message_state->params.iface);
     if (hr == S_OK)
     {
-        /* stub, chan, iface and iid are unneeded in multi-threaded case as we go
-         * via the RPC runtime */
+        /* the object is in the MTA of this process, so any of our threads can
+         * execute the call once it has joined the MTA - no need to go through
+         * the RPC runtime */
         if (apt->multi_threaded)
         {
-            IRpcStubBuffer_Release(message_state->params.stub);
-            message_state->params.stub = NULL;
-            IRpcChannelBuffer_Release(message_state->params.chan);
-            message_state->params.chan = NULL;
-            message_state->params.iface = NULL;
+            message_state->params.bypass_rpcrt = TRUE;
+            message_state->target_mta = TRUE;
         }
         else
         {
@@ -1152,7 +1152,7 @@ static HRESULT WINAPI ClientRpcChannelBuffer_GetBuffer(LPRPCCHANNELBUFFER iface,
      * ClientRpcChannelBuffer_SendReceive */
 
     /* shortcut the RPC runtime */
-    if (message_state->target_hwnd)
+    if (message_state->target_hwnd || message_state->target_mta)
     {
         msg->Buffer = HeapAlloc(GetProcessHeap(), 0, msg->BufferLength);
         if (msg->Buffer)
@@ -1243,6 +1243,31 @@ static DWORD WINAPI rpc_sendreceive_thread(LPVOID param)
     return 0;
 }
 
+/* this thread executes a call to an object in the MTA of this process */
+static DWORD WINAPI rpc_execute_mta_call_thread(LPVOID param)
+{
+    struct dispatch_params *params = param;
+    struct tlsdata *tlsdata;
+    BOOL joined = FALSE;
+
+    if (FAILED(params->hr = com_get_tlsdata(&tlsdata)))
+    {
+        SetEvent(params->handle);
+        return 0;
+    }
+
+    if (!tlsdata->apt)
+    {
+        enter_apartment(tlsdata, COINIT_MULTITHREADED);
+        joined = TRUE;
+    }
+    rpc_execute_call(params);
+    if (joined)
+        leave_apartment(tlsdata);
+
+    return 0;
+}
+
 static inline HRESULT ClientRpcChannelBuffer_IsCorrectApartment(ClientRpcChannelBuffer *This, const struct apartment *apt)
 {
     if (!apt)
@@ -1309,7 +1334,21 @@ static HRESULT WINAPI ClientRpcChannelBuffer_SendReceive(LPRPCCHANNELBUFFER ifac
      * from DllMain */
 
     message_state->params.msg = olemsg;
-    if (message_state->params.bypass_rpcrt)
+    if (message_state->target_mta)
+    {
+        TRACE("Calling multi-threaded apartment...\n");
+
+        msg->ProcNum &= ~RPC_FLAGS_VALID_BIT;
+
+        if (!QueueUserWorkItem(rpc_execute_mta_call_thread, &message_state->params, WT_EXECUTEDEFAULT))
+        {
+            ERR("QueueUserWorkItem failed with error %u\n", GetLastError());
+            hr = E_UNEXPECTED;
+        }
+        else
+            hr = S_OK;
+    }
+    else if (message_state->params.bypass_rpcrt)
     {
         TRACE("Calling apartment thread 0x%08x...\n", message_state->target_tid);
 
@@ -150,7 +150,8 @@ static context_t *Cert_clone(context_t *context, WINECRYPT_CERTSTORE *store, BOO
 
         /* FIXME: We don't need to decode the object here, we could just clone cert info. */
         res = CryptDecodeObjectEx(cert->ctx.dwCertEncodingType, X509_CERT_TO_BE_SIGNED,
-         cert->ctx.pbCertEncoded, cert->ctx.cbCertEncoded, CRYPT_DECODE_ALLOC_FLAG, NULL,
+         cert->ctx.pbCertEncoded, cert->ctx.cbCertEncoded,
+         CRYPT_DECODE_ALLOC_FLAG | CRYPT_DECODE_NOCOPY_FLAG, NULL,
          &cert->ctx.pCertInfo, &size);
         if(!res) {
             CertFreeCertificateContext(&cert->ctx);
@@ -330,23 +331,30 @@ PCCERT_CONTEXT WINAPI CertCreateCertificateContext(DWORD dwCertEncodingType,
         return NULL;
     }
 
+    data = CryptMemAlloc(cbCertEncoded);
+    if (!data)
+        return NULL;
+    memcpy(data, pbCertEncoded, cbCertEncoded);
+
+    /* The encoded copy lives as long as the context, so the cert info can
+     * point into it instead of duplicating every blob. */
     ret = CryptDecodeObjectEx(dwCertEncodingType, X509_CERT_TO_BE_SIGNED,
-     pbCertEncoded, cbCertEncoded, CRYPT_DECODE_ALLOC_FLAG, NULL,
-     &certInfo, &size);
+     data, cbCertEncoded, CRYPT_DECODE_ALLOC_FLAG | CRYPT_DECODE_NOCOPY_FLAG,
+     NULL, &certInfo, &size);
     if (!ret)
+    {
+        CryptMemFree(data);
         return NULL;
+    }
 
     cert = (cert_t*)Context_CreateDataContext(sizeof(CERT_CONTEXT), &cert_vtbl, &empty_store);
     if (!cert)
-        return NULL;
-    data = CryptMemAlloc(cbCertEncoded);
-    if (!data)
     {
-        Context_Release(&cert->base);
+        LocalFree(certInfo);
+        CryptMemFree(data);
         return NULL;
     }
 
-    memcpy(data, pbCertEncoded, cbCertEncoded);
     cert->ctx.dwCertEncodingType = dwCertEncodingType;
     cert->ctx.pbCertEncoded      = data;
     cert->ctx.cbCertEncoded      = cbCertEncoded;
@@ -35,6 +35,11 @@ WINE_DECLARE_DEBUG_CHANNEL(chain);
 
 #define DEFAULT_CYCLE_MODULUS 7
 
+/* Chains built for the current time are kept per engine for a while, since
+ * TLS clients tend to validate the same server certificates over and over. */
+#define CHAIN_CACHE_SIZE 32
+#define CHAIN_CACHE_TIMEOUT ((ULONGLONG)60 * 10000000)
+
 /* This represents a subset of a certificate chain engine:  it doesn't include
  * the "hOther" store described by MSDN, because I'm not sure how that's used.
  * It also doesn't include the "hTrust" store, because I don't yet implement
@@ -49,8 +54,28 @@ typedef struct _CertificateChainEngine
     DWORD      dwUrlRetrievalTimeout;
     DWORD      MaximumCachedCertificates;
     DWORD      CycleDetectionModulus;
+    CRITICAL_SECTION cs;
+    struct list chain_cache;
+    DWORD      chain_cache_count;
 } CertificateChainEngine;
 
+struct chain_cache_key
+{
+    BYTE  hash[20];
+    DWORD cert_size;
+    DWORD flags;
+    BYTE *para;
+    DWORD para_size;
+};
+
+struct chain_cache_entry
+{
+    struct list entry;
+    struct chain_cache_key key;
+    ULONGLONG expires;
+    PCCERT_CHAIN_CONTEXT chain;
+};
+
 static inline void CRYPT_AddStoresToCollection(HCERTSTORE collection,
  DWORD cStores, HCERTSTORE *stores)
 {
@@ -154,6 +179,11 @@ HCERTCHAINENGINE CRYPT_CreateChainEngine(HCERTSTORE root, DWORD system_store, co
     else
         engine->CycleDetectionModulus = DEFAULT_CYCLE_MODULUS;
 
+    InitializeCriticalSection(&engine->cs);
+    engine->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": CertificateChainEngine.cs");
+    list_init(&engine->chain_cache);
+    engine->chain_cache_count = 0;
+
     return engine;
 }
 
@@ -194,11 +224,24 @@ static CertificateChainEngine *get_chain_engine(HCERTCHAINENGINE handle, BOOL al
     return (CertificateChainEngine*)handle;
 }
 
+static void free_chain_cache_entry(struct chain_cache_entry *entry)
+{
+    CertFreeCertificateChain(entry->chain);
+    CryptMemFree(entry->key.para);
+    CryptMemFree(entry);
+}
+
 static void free_chain_engine(CertificateChainEngine *engine)
 {
+    struct chain_cache_entry *entry, *next;
+
     if(!engine || InterlockedDecrement(&engine->ref))
         return;
 
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &engine->chain_cache, struct chain_cache_entry, entry)
+        free_chain_cache_entry(entry);
+    engine->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&engine->cs);
     CertCloseStore(engine->hWorld, 0);
     CertCloseStore(engine->hRoot, 0);
     CryptMemFree(engine);
@@ -2625,6 +2668,29 @@ typedef struct _CERT_CHAIN_PARA_NO_EXTRA_FIELDS {
     CERT_USAGE_MATCH RequestedUsage;
 } CERT_CHAIN_PARA_NO_EXTRA_FIELDS;
 
+struct revocation_check
+{
+    PCCERT_CONTEXT         cert;
+    DWORD                  flags;
+    CERT_REVOCATION_PARA   para;
+    CERT_REVOCATION_STATUS status;
+    BOOL                   ret;
+    LONG                  *pending;
+    HANDLE                 done;
+};
+
+static DWORD CALLBACK revocation_check_proc(void *arg)
+{
+    struct revocation_check *check = arg;
+    void *cert = (void *)check->cert;
+
+    check->ret = CertVerifyRevocation(X509_ASN_ENCODING, CERT_CONTEXT_REVOCATION_TYPE,
+     1, &cert, check->flags, &check->para, &check->status);
+    if (!InterlockedDecrement(check->pending) && check->done)
+        SetEvent(check->done);
+    return 0;
+}
+
 static void CRYPT_VerifyChainRevocation(PCERT_CHAIN_CONTEXT chain,
  LPFILETIME pTime, HCERTSTORE hAdditionalStore,
  const CERT_CHAIN_PARA *pChainPara, DWORD chainFlags)
@@ -2653,9 +2719,9 @@ static void CRYPT_VerifyChainRevocation(PCERT_CHAIN_CONTEXT chain,
     {
         DWORD i, j, iContext, revocationFlags;
         CERT_REVOCATION_PARA revocationPara = { sizeof(revocationPara), 0 };
-        CERT_REVOCATION_STATUS revocationStatus =
-         { sizeof(revocationStatus), 0 };
-        BOOL ret;
+        struct revocation_check *checks;
+        HANDLE done = NULL;
+        LONG pending;
 
         revocationFlags = CERT_VERIFY_REV_CHAIN_FLAG;
         if (chainFlags & CERT_CHAIN_REVOCATION_CHECK_CACHE_ONLY)
@@ -2678,63 +2744,91 @@ static void CRYPT_VerifyChainRevocation(PCERT_CHAIN_CONTEXT chain,
             revocationPara.dwFreshnessTime =
              pChainPara->dwRevocationFreshnessTime;
         }
+        if (!(checks = CryptMemAlloc(cContext * sizeof(*checks))))
+            return;
         for (i = 0, iContext = 0; iContext < cContext && i < chain->cChain; i++)
         {
             for (j = 0; iContext < cContext &&
              j < chain->rgpChain[i]->cElement; j++, iContext++)
             {
-                PCCERT_CONTEXT certToCheck =
-                 chain->rgpChain[i]->rgpElement[j]->pCertContext;
+                struct revocation_check *check = &checks[iContext];
 
+                check->cert = chain->rgpChain[i]->rgpElement[j]->pCertContext;
+                check->flags = revocationFlags;
+                check->para = revocationPara;
                 if (j < chain->rgpChain[i]->cElement - 1)
-                    revocationPara.pIssuerCert =
+                    check->para.pIssuerCert =
                      chain->rgpChain[i]->rgpElement[j + 1]->pCertContext;
                 else
-                    revocationPara.pIssuerCert = NULL;
-                ret = CertVerifyRevocation(X509_ASN_ENCODING,
-                 CERT_CONTEXT_REVOCATION_TYPE, 1, (void **)&certToCheck,
-                 revocationFlags, &revocationPara, &revocationStatus);
+                    check->para.pIssuerCert = NULL;
+                memset(&check->status, 0, sizeof(check->status));
+                check->status.cbSize = sizeof(check->status);
+                check->pending = &pending;
+            }
+        }
 
-                if (!ret && chainFlags & CERT_CHAIN_REVOCATION_CHECK_CHAIN
-                    && revocationStatus.dwError == CRYPT_E_NO_REVOCATION_CHECK && revocationPara.pIssuerCert == NULL)
-                    ret = TRUE;
+        /* Fetching revocation data may go to the network, so check all
+         * certificates at the same time. */
+        pending = cContext;
+        if (cContext > 1 && !(chainFlags & CERT_CHAIN_REVOCATION_CHECK_CACHE_ONLY))
+            done = CreateEventW(NULL, TRUE, FALSE, NULL);
+        for (iContext = 0; iContext < cContext; iContext++)
+        {
+            checks[iContext].done = done;
+            if (!done || !QueueUserWorkItem(revocation_check_proc, &checks[iContext], WT_EXECUTELONGFUNCTION))
+                revocation_check_proc(&checks[iContext]);
+        }
+        if (done)
+        {
+            WaitForSingleObject(done, INFINITE);
+            CloseHandle(done);
+        }
 
-                if (!ret)
-                {
-                    PCERT_CHAIN_ELEMENT element = CRYPT_FindIthElementInChain(
-                     chain, iContext);
-                    DWORD error;
+        for (iContext = 0; iContext < cContext; iContext++)
+        {
+            struct revocation_check *check = &checks[iContext];
+            BOOL ret = check->ret;
 
-                    switch (revocationStatus.dwError)
-                    {
-                    case CRYPT_E_NO_REVOCATION_CHECK:
-                    case CRYPT_E_NO_REVOCATION_DLL:
-                    case CRYPT_E_NOT_IN_REVOCATION_DATABASE:
-                        /* If the revocation status is unknown, it's assumed
-                         * to be offline too.
-                         */
-                        error = CERT_TRUST_REVOCATION_STATUS_UNKNOWN |
-                         CERT_TRUST_IS_OFFLINE_REVOCATION;
-                        break;
-                    case CRYPT_E_REVOCATION_OFFLINE:
-                        error = CERT_TRUST_IS_OFFLINE_REVOCATION;
-                        break;
-                    case CRYPT_E_REVOKED:
-                        error = CERT_TRUST_IS_REVOKED;
-                        break;
-                    default:
-                        WARN("unmapped error %08x\n", revocationStatus.dwError);
-                        error = 0;
-                    }
-                    if (element)
-                    {
-                        /* FIXME: set element's pRevocationInfo member */
-                        element->TrustStatus.dwErrorStatus |= error;
-                    }
-                    chain->TrustStatus.dwErrorStatus |= error;
+            if (!ret && chainFlags & CERT_CHAIN_REVOCATION_CHECK_CHAIN
+                && check->status.dwError == CRYPT_E_NO_REVOCATION_CHECK && check->para.pIssuerCert == NULL)
+                ret = TRUE;
+
+            if (!ret)
+            {
+                PCERT_CHAIN_ELEMENT element = CRYPT_FindIthElementInChain(
+                 chain, iContext);
+                DWORD error;
+
+                switch (check->status.dwError)
+                {
+                case CRYPT_E_NO_REVOCATION_CHECK:
+                case CRYPT_E_NO_REVOCATION_DLL:
+                case CRYPT_E_NOT_IN_REVOCATION_DATABASE:
+                    /* If the revocation status is unknown, it's assumed
+                     * to be offline too.
+                     */
+                    error = CERT_TRUST_REVOCATION_STATUS_UNKNOWN |
+                     CERT_TRUST_IS_OFFLINE_REVOCATION;
+                    break;
+                case CRYPT_E_REVOCATION_OFFLINE:
+                    error = CERT_TRUST_IS_OFFLINE_REVOCATION;
+                    break;
+                case CRYPT_E_REVOKED:
+                    error = CERT_TRUST_IS_REVOKED;
+                    break;
+                default:
+                    WARN("unmapped error %08x\n", check->status.dwError);
+                    error = 0;
                 }
+                if (element)
+                {
+                    /* FIXME: set element's pRevocationInfo member */
+                    element->TrustStatus.dwErrorStatus |= error;
+                }
+                chain->TrustStatus.dwErrorStatus |= error;
             }
         }
+        CryptMemFree(checks);
     }
 }
 
@@ -2872,14 +2966,170 @@ static void dump_chain_para(const CERT_CHAIN_PARA *pChainPara)
     }
 }
 
+static DWORD usage_key_size(const CERT_USAGE_MATCH *usage)
+{
+    DWORD i, size = 2 * sizeof(DWORD);
+
+    for (i = 0; i < usage->Usage.cUsageIdentifier; i++)
+        size += strlen(usage->Usage.rgpszUsageIdentifier[i]) + 1;
+    return size;
+}
+
+static BYTE *usage_key_write(BYTE *ptr, const CERT_USAGE_MATCH *usage)
+{
+    DWORD i, len;
+
+    memcpy(ptr, &usage->dwType, sizeof(DWORD));
+    ptr += sizeof(DWORD);
+    memcpy(ptr, &usage->Usage.cUsageIdentifier, sizeof(DWORD));
+    ptr += sizeof(DWORD);
+    for (i = 0; i < usage->Usage.cUsageIdentifier; i++)
+    {
+        len = strlen(usage->Usage.rgpszUsageIdentifier[i]) + 1;
+        memcpy(ptr, usage->Usage.rgpszUsageIdentifier[i], len);
+        ptr += len;
+    }
+    return ptr;
+}
+
+/* Fills in the cache key for a chain request, or returns FALSE if the result
+ * can't be reused: it depends on a given time, on stores that only apply to
+ * this call, or on revocation data freshness. */
+static BOOL chain_cache_key_init(struct chain_cache_key *key, PCCERT_CONTEXT cert,
+ const FILETIME *time, HCERTSTORE additional_store, const CERT_CHAIN_PARA *para, DWORD flags)
+{
+    DWORD size = sizeof(key->hash);
+    BYTE *ptr;
+
+    if (time || additional_store)
+        return FALSE;
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA) &&
+     (para->fCheckRevocationFreshnessTime || para->pftCacheResync))
+        return FALSE;
+    if (!CertGetCertificateContextProperty(cert, CERT_HASH_PROP_ID, key->hash, &size))
+        return FALSE;
+
+    key->cert_size = cert->cbCertEncoded;
+    key->flags = flags;
+    key->para_size = sizeof(DWORD);
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA_NO_EXTRA_FIELDS))
+        key->para_size += usage_key_size(&para->RequestedUsage);
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA))
+        key->para_size += usage_key_size(&para->RequestedIssuancePolicy) + sizeof(DWORD);
+    if (!(key->para = ptr = CryptMemAlloc(key->para_size)))
+        return FALSE;
+
+    memcpy(ptr, &para->cbSize, sizeof(DWORD));
+    ptr += sizeof(DWORD);
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA_NO_EXTRA_FIELDS))
+        ptr = usage_key_write(ptr, &para->RequestedUsage);
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA))
+    {
+        ptr = usage_key_write(ptr, &para->RequestedIssuancePolicy);
+        memcpy(ptr, &para->dwUrlRetrievalTimeout, sizeof(DWORD));
+    }
+    return TRUE;
+}
+
+static BOOL chain_cache_key_equal(const struct chain_cache_key *a, const struct chain_cache_key *b)
+{
+    return a->flags == b->flags && a->cert_size == b->cert_size &&
+     a->para_size == b->para_size && !memcmp(a->hash, b->hash, sizeof(a->hash)) &&
+     !memcmp(a->para, b->para, a->para_size);
+}
+
+static ULONGLONG get_current_time(void)
+{
+    FILETIME now;
+
+    GetSystemTimeAsFileTime(&now);
+    return ((ULONGLONG)now.dwHighDateTime << 32) | now.dwLowDateTime;
+}
+
+static PCCERT_CHAIN_CONTEXT chain_cache_lookup(CertificateChainEngine *engine,
+ const struct chain_cache_key *key)
+{
+    struct chain_cache_entry *entry, *next;
+    PCCERT_CHAIN_CONTEXT chain = NULL;
+    ULONGLONG now = get_current_time();
+
+    EnterCriticalSection(&engine->cs);
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &engine->chain_cache, struct chain_cache_entry, entry)
+    {
+        if (entry->expires <= now)
+        {
+            list_remove(&entry->entry);
+            engine->chain_cache_count--;
+            free_chain_cache_entry(entry);
+            continue;
+        }
+        if (chain_cache_key_equal(&entry->key, key))
+        {
+            list_remove(&entry->entry);
+            list_add_head(&engine->chain_cache, &entry->entry);
+            chain = CertDuplicateCertificateChain(entry->chain);
+            break;
+        }
+    }
+    LeaveCriticalSection(&engine->cs);
+    return chain;
+}
+
+/* Takes ownership of key->para. */
+static void chain_cache_add(CertificateChainEngine *engine, struct chain_cache_key *key,
+ PCCERT_CHAIN_CONTEXT chain)
+{
+    struct chain_cache_entry *entry;
+    ULONGLONG now = get_current_time(), expires, time;
+    const CERT_INFO *info;
+    DWORD i, j;
+
+    /* the trust status stays the same until the first certificate expires */
+    expires = now + CHAIN_CACHE_TIMEOUT;
+    for (i = 0; i < chain->cChain; i++)
+    {
+        for (j = 0; j < chain->rgpChain[i]->cElement; j++)
+        {
+            info = chain->rgpChain[i]->rgpElement[j]->pCertContext->pCertInfo;
+            time = ((ULONGLONG)info->NotBefore.dwHighDateTime << 32) | info->NotBefore.dwLowDateTime;
+            if (time > now)
+                expires = now;
+            time = ((ULONGLONG)info->NotAfter.dwHighDateTime << 32) | info->NotAfter.dwLowDateTime;
+            if (time > now && time < expires)
+                expires = time;
+        }
+    }
+
+    if (expires <= now || !(entry = CryptMemAlloc(sizeof(*entry))))
+    {
+        CryptMemFree(key->para);
+        return;
+    }
+    entry->key = *key;
+    entry->expires = expires;
+    entry->chain = CertDuplicateCertificateChain(chain);
+
+    EnterCriticalSection(&engine->cs);
+    list_add_head(&engine->chain_cache, &entry->entry);
+    if (++engine->chain_cache_count > CHAIN_CACHE_SIZE)
+    {
+        entry = LIST_ENTRY(list_tail(&engine->chain_cache), struct chain_cache_entry, entry);
+        list_remove(&entry->entry);
+        engine->chain_cache_count--;
+        free_chain_cache_entry(entry);
+    }
+    LeaveCriticalSection(&engine->cs);
+}
+
 BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
  PCCERT_CONTEXT pCertContext, LPFILETIME pTime, HCERTSTORE hAdditionalStore,
  PCERT_CHAIN_PARA pChainPara, DWORD dwFlags, LPVOID pvReserved,
  PCCERT_CHAIN_CONTEXT* ppChainContext)
 {
     CertificateChainEngine *engine;
-    BOOL ret;
+    BOOL ret, cacheable = FALSE;
     CertificateChain *chain = NULL;
+    struct chain_cache_key key;
 
     TRACE("(%p, %p, %s, %p, %p, %08x, %p, %p)\n", hChainEngine, pCertContext,
      debugstr_filetime(pTime), hAdditionalStore, pChainPara, dwFlags,
@@ -2904,6 +3154,18 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
 
     if (TRACE_ON(chain))
         dump_chain_para(pChainPara);
+
+    if (ppChainContext && (cacheable = chain_cache_key_init(&key, pCertContext, pTime,
+     hAdditionalStore, pChainPara, dwFlags)))
+    {
+        if ((*ppChainContext = chain_cache_lookup(engine, &key)))
+        {
+            TRACE("returning cached chain %p\n", *ppChainContext);
+            CryptMemFree(key.para);
+            return TRUE;
+        }
+    }
+
     /* FIXME: what about HCCE_LOCAL_MACHINE? */
     ret = CRYPT_BuildCandidateChainFromCert(engine, pCertContext, pTime,
      hAdditionalStore, dwFlags, &chain);
@@ -2932,11 +3194,18 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
         CRYPT_CheckUsages(pChain, pChainPara);
         TRACE_(chain)("error status: %08x\n",
          pChain->TrustStatus.dwErrorStatus);
+        if (cacheable)
+        {
+            chain_cache_add(engine, &key, pChain);
+            cacheable = FALSE;
+        }
         if (ppChainContext)
             *ppChainContext = pChain;
         else
             CertFreeCertificateChain(pChain);
     }
+    if (cacheable)
+        CryptMemFree(key.para);
     TRACE("returning %d\n", ret);
     return ret;
 }
@@ -64,7 +64,8 @@ static context_t *CRL_clone(context_t *context, WINECRYPT_CERTSTORE *store, BOOL
 
         /* FIXME: We don't need to decode the object here, we could just clone crl info. */
         res = CryptDecodeObjectEx(crl->ctx.dwCertEncodingType, X509_CERT_CRL_TO_BE_SIGNED,
-         crl->ctx.pbCrlEncoded, crl->ctx.cbCrlEncoded, CRYPT_DECODE_ALLOC_FLAG, NULL,
+         crl->ctx.pbCrlEncoded, crl->ctx.cbCrlEncoded,
+         CRYPT_DECODE_ALLOC_FLAG | CRYPT_DECODE_NOCOPY_FLAG, NULL,
          &crl->ctx.pCrlInfo, &size);
         if(!res) {
             CertFreeCRLContext(&crl->ctx);
@@ -98,24 +99,30 @@ PCCRL_CONTEXT WINAPI CertCreateCRLContext(DWORD dwCertEncodingType,
         SetLastError(E_INVALIDARG);
         return NULL;
     }
+    data = CryptMemAlloc(cbCrlEncoded);
+    if (!data)
+        return NULL;
+    memcpy(data, pbCrlEncoded, cbCrlEncoded);
+
+    /* Let the CRL info point into our own copy of the encoding, CRLs can
+     * have a lot of entries. */
     ret = CryptDecodeObjectEx(dwCertEncodingType, X509_CERT_CRL_TO_BE_SIGNED,
-     pbCrlEncoded, cbCrlEncoded, CRYPT_DECODE_ALLOC_FLAG, NULL,
-     &crlInfo, &size);
+     data, cbCrlEncoded, CRYPT_DECODE_ALLOC_FLAG | CRYPT_DECODE_NOCOPY_FLAG,
+     NULL, &crlInfo, &size);
     if (!ret)
+    {
+        CryptMemFree(data);
         return NULL;
+    }
 
     crl = (crl_t*)Context_CreateDataContext(sizeof(CRL_CONTEXT), &crl_vtbl, &empty_store);
     if (!crl)
-        return NULL;
-
-    data = CryptMemAlloc(cbCrlEncoded);
-    if (!data)
     {
-        Context_Release(&crl->base);
+        LocalFree(crlInfo);
+        CryptMemFree(data);
         return NULL;
     }
 
-    memcpy(data, pbCrlEncoded, cbCrlEncoded);
     crl->ctx.dwCertEncodingType = dwCertEncodingType;
     crl->ctx.pbCrlEncoded       = data;
     crl->ctx.cbCrlEncoded       = cbCrlEncoded;
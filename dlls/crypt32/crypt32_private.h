@@ -458,6 +458,7 @@ struct unix_funcs
     BOOL (WINAPI *enum_root_certs)( void *buffer, SIZE_T size, SIZE_T *needed );
     BOOL (WINAPI *import_cert_store)( CRYPT_DATA_BLOB *pfx, const WCHAR *password, DWORD flags,
                                       void **key_ret, void ***chain_ret, DWORD *count_ret );
+    BOOL (WINAPI *get_root_certs_stamp)( ULONGLONG *stamp );
 };
 
 extern const struct unix_funcs *unix_funcs DECLSPEC_HIDDEN;
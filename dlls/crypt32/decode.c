@@ -1069,7 +1069,8 @@ static BOOL WINAPI CRYPT_AsnDecodeCert(DWORD dwCertEncodingType,
             PCERT_SIGNED_CONTENT_INFO signedCert = NULL;
 
             ret = CRYPT_AsnDecodeCertSignedContent(dwCertEncodingType,
-             X509_CERT, pbEncoded, cbEncoded, CRYPT_DECODE_ALLOC_FLAG, NULL,
+             X509_CERT, pbEncoded, cbEncoded,
+             CRYPT_DECODE_ALLOC_FLAG | CRYPT_DECODE_NOCOPY_FLAG, NULL,
              &signedCert, &size);
             if (ret)
             {
@@ -1266,7 +1267,8 @@ static BOOL WINAPI CRYPT_AsnDecodeCRL(DWORD dwCertEncodingType,
             PCERT_SIGNED_CONTENT_INFO signedCrl = NULL;
 
             ret = CRYPT_AsnDecodeCertSignedContent(dwCertEncodingType,
-             X509_CERT, pbEncoded, cbEncoded, CRYPT_DECODE_ALLOC_FLAG, NULL,
+             X509_CERT, pbEncoded, cbEncoded,
+             CRYPT_DECODE_ALLOC_FLAG | CRYPT_DECODE_NOCOPY_FLAG, NULL,
              &signedCrl, &size);
             if (ret)
             {
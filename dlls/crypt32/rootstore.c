@@ -638,24 +638,105 @@ static void read_trusted_roots_from_known_locations(HCERTSTORE store)
     CertCloseStore(from, 0);
 }
 
-static HCERTSTORE create_root_store(void)
+/* Checking the host certificates means building a chain for each of them, so
+ * the resulting store is kept in the registry, along with a stamp of the host
+ * certificate locations it was built from. */
+static BOOL load_cached_root_store(HCERTSTORE store, ULONGLONG stamp)
+{
+    CRYPT_DATA_BLOB blob;
+    ULONGLONG cached_stamp;
+    DWORD size = sizeof(cached_stamp);
+    BOOL ret = FALSE;
+    HKEY key;
+
+    if (RegOpenKeyExW(HKEY_LOCAL_MACHINE, L"Software\\Wine\\Crypt32", 0, KEY_READ, &key))
+        return FALSE;
+
+    if (!RegQueryValueExW(key, L"RootStoreStamp", NULL, NULL, (BYTE *)&cached_stamp, &size) &&
+        size == sizeof(cached_stamp) && cached_stamp == stamp &&
+        !RegQueryValueExW(key, L"RootStoreCache", NULL, NULL, NULL, &blob.cbData) &&
+        (blob.pbData = CryptMemAlloc(blob.cbData)))
+    {
+        if (!RegQueryValueExW(key, L"RootStoreCache", NULL, NULL, blob.pbData, &blob.cbData))
+            ret = CRYPT_ReadSerializedStoreFromBlob(&blob, store);
+        CryptMemFree(blob.pbData);
+    }
+    RegCloseKey(key);
+
+    TRACE("cached root store %s\n", ret ? "loaded" : "not available");
+    return ret;
+}
+
+static void save_cached_root_store(HCERTSTORE store, ULONGLONG stamp)
+{
+    CRYPT_DATA_BLOB blob = { 0, NULL };
+    HKEY key;
+
+    if (!CertSaveStore(store, 0, CERT_STORE_SAVE_AS_STORE, CERT_STORE_SAVE_TO_MEMORY, &blob, 0) ||
+        !(blob.pbData = CryptMemAlloc(blob.cbData)))
+        return;
+
+    if (CertSaveStore(store, 0, CERT_STORE_SAVE_AS_STORE, CERT_STORE_SAVE_TO_MEMORY, &blob, 0) &&
+        !RegCreateKeyExW(HKEY_LOCAL_MACHINE, L"Software\\Wine\\Crypt32", 0, NULL, 0,
+                         KEY_ALL_ACCESS, NULL, &key, NULL))
+    {
+        RegSetValueExW(key, L"RootStoreCache", 0, REG_BINARY, blob.pbData, blob.cbData);
+        RegSetValueExW(key, L"RootStoreStamp", 0, REG_QWORD, (BYTE *)&stamp, sizeof(stamp));
+        RegCloseKey(key);
+    }
+    CryptMemFree(blob.pbData);
+}
+
+static HCERTSTORE create_root_store(const ULONGLONG *stamp)
 {
     HCERTSTORE memStore = CertOpenStore(CERT_STORE_PROV_MEMORY,
      X509_ASN_ENCODING, 0, CERT_STORE_CREATE_NEW_FLAG, NULL);
 
-    if (memStore)
+    if (memStore && !(stamp && load_cached_root_store(memStore, *stamp)))
     {
         read_trusted_roots_from_known_locations(memStore);
         add_ms_root_certs(memStore);
+        if (stamp) save_cached_root_store(memStore, *stamp);
     }
 
     TRACE("returning %p\n", memStore);
     return memStore;
 }
 
+/* The imported certificates are volatile, so a volatile key records that they
+ * are already present for the current session. */
+static BOOL root_certs_already_imported(ULONGLONG stamp)
+{
+    ULONGLONG imported_stamp;
+    DWORD size = sizeof(imported_stamp);
+    BOOL ret;
+    HKEY key;
+
+    if (RegOpenKeyExW(HKEY_LOCAL_MACHINE, L"Software\\Wine\\Crypt32\\RootStoreImported", 0, KEY_READ, &key))
+        return FALSE;
+    ret = !RegQueryValueExW(key, L"Stamp", NULL, NULL, (BYTE *)&imported_stamp, &size) &&
+          size == sizeof(imported_stamp) && imported_stamp == stamp;
+    RegCloseKey(key);
+    return ret;
+}
+
+static void set_root_certs_imported(ULONGLONG stamp)
+{
+    HKEY key;
+
+    if (!RegCreateKeyExW(HKEY_LOCAL_MACHINE, L"Software\\Wine\\Crypt32\\RootStoreImported", 0, NULL,
+                         REG_OPTION_VOLATILE, KEY_ALL_ACCESS, NULL, &key, NULL))
+    {
+        RegSetValueExW(key, L"Stamp", 0, REG_QWORD, (BYTE *)&stamp, sizeof(stamp));
+        RegCloseKey(key);
+    }
+}
+
 void CRYPT_ImportSystemRootCertsToReg(void)
 {
     HCERTSTORE store = NULL;
+    ULONGLONG stamp;
+    BOOL have_stamp;
     HKEY key;
     LONG rc;
     HANDLE hsem;
@@ -674,9 +755,11 @@ void CRYPT_ImportSystemRootCertsToReg(void)
 
     if(GetLastError() == ERROR_ALREADY_EXISTS)
         WaitForSingleObject(hsem, INFINITE);
+    else if ((have_stamp = unix_funcs->get_root_certs_stamp(&stamp)) && root_certs_already_imported(stamp))
+        TRACE("root certificates already imported\n");
     else
     {
-        if ((store = create_root_store()))
+        if ((store = create_root_store(have_stamp ? &stamp : NULL)))
         {
             rc = RegCreateKeyExW(HKEY_LOCAL_MACHINE, L"Software\\Microsoft\\SystemCertificates\\Root\\Certificates", 0, NULL, 0,
                 KEY_ALL_ACCESS, NULL, &key, 0);
@@ -684,6 +767,8 @@ void CRYPT_ImportSystemRootCertsToReg(void)
             {
                 if (!CRYPT_SerializeContextsToReg(key, REG_OPTION_VOLATILE, pCertInterface, store))
                     ERR("Failed to import system certs into registry, %08x\n", GetLastError());
+                else if (have_stamp)
+                    set_root_certs_imported(stamp);
                 RegCloseKey(key);
             }
             CertCloseStore(store, 0);
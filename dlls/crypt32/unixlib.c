@@ -637,10 +637,36 @@ static BOOL WINAPI enum_root_certs( void *buffer, SIZE_T size, SIZE_T *needed )
     return TRUE;
 }
 
+/* Returns a value that changes whenever the host certificates may have
+ * changed, so that the checked root store can be cached. */
+static BOOL WINAPI get_root_certs_stamp( ULONGLONG *stamp )
+{
+#ifdef HAVE_SECURITY_SECURITY_H
+    /* there is no cheap way to tell whether the keychains changed */
+    return FALSE;
+#else
+    struct stat st;
+    ULONGLONG hash = 0xcbf29ce484222325;
+    DWORD i;
+
+    for (i = 0; i < ARRAY_SIZE(CRYPT_knownLocations); i++)
+    {
+        if (stat( CRYPT_knownLocations[i], &st )) continue;
+        hash = (hash ^ i) * 0x100000001b3;
+        hash = (hash ^ (ULONGLONG)st.st_mtime) * 0x100000001b3;
+        hash = (hash ^ (ULONGLONG)st.st_size) * 0x100000001b3;
+        hash = (hash ^ (ULONGLONG)st.st_ino) * 0x100000001b3;
+    }
+    *stamp = hash;
+    return TRUE;
+#endif
+}
+
 static struct unix_funcs funcs =
 {
     enum_root_certs,
-    NULL
+    NULL,
+    get_root_certs_stamp,
 };
 
 NTSTATUS CDECL __wine_init_unix_lib( HMODULE module, DWORD reason, const void *ptr_in, void *ptr_out )
@@ -424,6 +424,21 @@ struct d2d_curve_outline_vertex
     D2D1_POINT_2F prev, next;
 };
 
+enum d2d_geometry_buffer
+{
+    D2D_GEOMETRY_BUFFER_FILL_IB,
+    D2D_GEOMETRY_BUFFER_FILL_VB,
+    D2D_GEOMETRY_BUFFER_FILL_BEZIER_VB,
+    D2D_GEOMETRY_BUFFER_FILL_ARC_VB,
+    D2D_GEOMETRY_BUFFER_OUTLINE_IB,
+    D2D_GEOMETRY_BUFFER_OUTLINE_VB,
+    D2D_GEOMETRY_BUFFER_OUTLINE_BEZIER_IB,
+    D2D_GEOMETRY_BUFFER_OUTLINE_BEZIER_VB,
+    D2D_GEOMETRY_BUFFER_OUTLINE_ARC_IB,
+    D2D_GEOMETRY_BUFFER_OUTLINE_ARC_VB,
+    D2D_GEOMETRY_BUFFER_COUNT,
+};
+
 struct d2d_geometry
 {
     ID2D1Geometry ID2D1Geometry_iface;
@@ -433,6 +448,10 @@ struct d2d_geometry
 
     D2D_MATRIX_3X2_F transform;
 
+    /* Device buffers for the fill and outline data below, created on first use. */
+    ID3D10Device *buffer_device;
+    ID3D10Buffer *buffers[D2D_GEOMETRY_BUFFER_COUNT];
+
     struct
     {
         D2D1_POINT_2F *vertices;
@@ -532,6 +551,7 @@ void d2d_transformed_geometry_init(struct d2d_geometry *geometry, ID2D1Factory *
 HRESULT d2d_geometry_group_init(struct d2d_geometry *geometry, ID2D1Factory *factory,
         D2D1_FILL_MODE fill_mode, ID2D1Geometry **src_geometries, unsigned int geometry_count) DECLSPEC_HIDDEN;
 struct d2d_geometry *unsafe_impl_from_ID2D1Geometry(ID2D1Geometry *iface) DECLSPEC_HIDDEN;
+void d2d_geometry_release_buffers(struct d2d_geometry *geometry) DECLSPEC_HIDDEN;
 
 struct d2d_device
 {
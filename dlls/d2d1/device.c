@@ -695,8 +695,47 @@ static void STDMETHODCALLTYPE d2d_device_context_FillEllipse(ID2D1DeviceContext
     ID2D1EllipseGeometry_Release(geometry);
 }
 
+/* The tessellated data of a geometry doesn't change once it is non-empty, so
+ * the buffers are created once per geometry and device instead of per draw. */
+static ID3D10Buffer *d2d_geometry_get_buffer(struct d2d_device_context *render_target,
+        struct d2d_geometry *geometry, enum d2d_geometry_buffer idx, UINT bind_flags,
+        const void *data, size_t size)
+{
+    D3D10_SUBRESOURCE_DATA buffer_data;
+    D3D10_BUFFER_DESC buffer_desc;
+    HRESULT hr;
+
+    if (geometry->buffer_device != render_target->d3d_device)
+    {
+        d2d_geometry_release_buffers(geometry);
+        geometry->buffer_device = render_target->d3d_device;
+    }
+
+    if (geometry->buffers[idx])
+        return geometry->buffers[idx];
+
+    buffer_desc.ByteWidth = size;
+    buffer_desc.Usage = D3D10_USAGE_IMMUTABLE;
+    buffer_desc.BindFlags = bind_flags;
+    buffer_desc.CPUAccessFlags = 0;
+    buffer_desc.MiscFlags = 0;
+
+    buffer_data.pSysMem = data;
+    buffer_data.SysMemPitch = 0;
+    buffer_data.SysMemSlicePitch = 0;
+
+    if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data,
+            &geometry->buffers[idx])))
+    {
+        WARN("Failed to create buffer, hr %#x.\n", hr);
+        return NULL;
+    }
+
+    return geometry->buffers[idx];
+}
+
 static void d2d_device_context_draw_geometry(struct d2d_device_context *render_target,
-        const struct d2d_geometry *geometry, struct d2d_brush *brush, float stroke_width)
+        struct d2d_geometry *geometry, struct d2d_brush *brush, float stroke_width)
 {
     ID3D10Buffer *ib, *vb, *vs_cb, *ps_cb_bezier, *ps_cb_arc;
     D3D10_SUBRESOURCE_DATA buffer_data;
@@ -771,94 +810,49 @@ static void d2d_device_context_draw_geometry(struct d2d_device_context *render_t
 
     if (geometry->outline.face_count)
     {
-        buffer_desc.ByteWidth = geometry->outline.face_count * sizeof(*geometry->outline.faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &ib)))
-        {
-            WARN("Failed to create index buffer, hr %#x.\n", hr);
+        if (!(ib = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_OUTLINE_IB,
+                D3D10_BIND_INDEX_BUFFER, geometry->outline.faces,
+                geometry->outline.face_count * sizeof(*geometry->outline.faces))))
             goto done;
-        }
-
-        buffer_desc.ByteWidth = geometry->outline.vertex_count * sizeof(*geometry->outline.vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create vertex buffer, hr %#x.\n", hr);
-            ID3D10Buffer_Release(ib);
+        if (!(vb = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_OUTLINE_VB,
+                D3D10_BIND_VERTEX_BUFFER, geometry->outline.vertices,
+                geometry->outline.vertex_count * sizeof(*geometry->outline.vertices))))
             goto done;
-        }
 
         d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_OUTLINE, ib, 3 * geometry->outline.face_count, vb,
                 sizeof(*geometry->outline.vertices), vs_cb, ps_cb_bezier, brush, NULL);
-
-        ID3D10Buffer_Release(vb);
-        ID3D10Buffer_Release(ib);
     }
 
     if (geometry->outline.bezier_face_count)
     {
-        buffer_desc.ByteWidth = geometry->outline.bezier_face_count * sizeof(*geometry->outline.bezier_faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.bezier_faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &ib)))
-        {
-            WARN("Failed to create beziers index buffer, hr %#x.\n", hr);
+        if (!(ib = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_OUTLINE_BEZIER_IB,
+                D3D10_BIND_INDEX_BUFFER, geometry->outline.bezier_faces,
+                geometry->outline.bezier_face_count * sizeof(*geometry->outline.bezier_faces))))
             goto done;
-        }
-
-        buffer_desc.ByteWidth = geometry->outline.bezier_count * sizeof(*geometry->outline.beziers);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.beziers;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create beziers vertex buffer, hr %#x.\n", hr);
-            ID3D10Buffer_Release(ib);
+        if (!(vb = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_OUTLINE_BEZIER_VB,
+                D3D10_BIND_VERTEX_BUFFER, geometry->outline.beziers,
+                geometry->outline.bezier_count * sizeof(*geometry->outline.beziers))))
             goto done;
-        }
 
         d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_BEZIER_OUTLINE, ib,
                 3 * geometry->outline.bezier_face_count, vb,
                 sizeof(*geometry->outline.beziers), vs_cb, ps_cb_bezier, brush, NULL);
-
-        ID3D10Buffer_Release(vb);
-        ID3D10Buffer_Release(ib);
     }
 
     if (geometry->outline.arc_face_count)
     {
-        buffer_desc.ByteWidth = geometry->outline.arc_face_count * sizeof(*geometry->outline.arc_faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.arc_faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &ib)))
-        {
-            WARN("Failed to create arcs index buffer, hr %#x.\n", hr);
+        if (!(ib = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_OUTLINE_ARC_IB,
+                D3D10_BIND_INDEX_BUFFER, geometry->outline.arc_faces,
+                geometry->outline.arc_face_count * sizeof(*geometry->outline.arc_faces))))
             goto done;
-        }
-
-        buffer_desc.ByteWidth = geometry->outline.arc_count * sizeof(*geometry->outline.arcs);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.arcs;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create arcs vertex buffer, hr %#x.\n", hr);
-            ID3D10Buffer_Release(ib);
+        if (!(vb = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_OUTLINE_ARC_VB,
+                D3D10_BIND_VERTEX_BUFFER, geometry->outline.arcs,
+                geometry->outline.arc_count * sizeof(*geometry->outline.arcs))))
             goto done;
-        }
 
         d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_ARC_OUTLINE, ib,
                 3 * geometry->outline.arc_face_count, vb,
                 sizeof(*geometry->outline.arcs), vs_cb, ps_cb_arc, brush, NULL);
-
-        ID3D10Buffer_Release(vb);
-        ID3D10Buffer_Release(ib);
     }
 
 done:
@@ -870,7 +864,7 @@ done:
 static void STDMETHODCALLTYPE d2d_device_context_DrawGeometry(ID2D1DeviceContext *iface,
         ID2D1Geometry *geometry, ID2D1Brush *brush, float stroke_width, ID2D1StrokeStyle *stroke_style)
 {
-    const struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
+    struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
     struct d2d_device_context *render_target = impl_from_ID2D1DeviceContext(iface);
     struct d2d_brush *brush_impl = unsafe_impl_from_ID2D1Brush(brush);
 
@@ -884,7 +878,7 @@ static void STDMETHODCALLTYPE d2d_device_context_DrawGeometry(ID2D1DeviceContext
 }
 
 static void d2d_device_context_fill_geometry(struct d2d_device_context *render_target,
-        const struct d2d_geometry *geometry, struct d2d_brush *brush, struct d2d_brush *opacity_brush)
+        struct d2d_geometry *geometry, struct d2d_brush *brush, struct d2d_brush *opacity_brush)
 {
     ID3D10Buffer *ib, *vb, *vs_cb, *ps_cb_bezier, *ps_cb_arc;
     D3D10_SUBRESOURCE_DATA buffer_data;
@@ -959,68 +953,39 @@ static void d2d_device_context_fill_geometry(struct d2d_device_context *render_t
 
     if (geometry->fill.face_count)
     {
-        buffer_desc.ByteWidth = geometry->fill.face_count * sizeof(*geometry->fill.faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &ib)))
-        {
-            WARN("Failed to create index buffer, hr %#x.\n", hr);
+        if (!(ib = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_FILL_IB,
+                D3D10_BIND_INDEX_BUFFER, geometry->fill.faces,
+                geometry->fill.face_count * sizeof(*geometry->fill.faces))))
             goto done;
-        }
-
-        buffer_desc.ByteWidth = geometry->fill.vertex_count * sizeof(*geometry->fill.vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create vertex buffer, hr %#x.\n", hr);
-            ID3D10Buffer_Release(ib);
+        if (!(vb = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_FILL_VB,
+                D3D10_BIND_VERTEX_BUFFER, geometry->fill.vertices,
+                geometry->fill.vertex_count * sizeof(*geometry->fill.vertices))))
             goto done;
-        }
 
         d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_TRIANGLE, ib, 3 * geometry->fill.face_count, vb,
                 sizeof(*geometry->fill.vertices), vs_cb, ps_cb_bezier, brush, opacity_brush);
-
-        ID3D10Buffer_Release(vb);
-        ID3D10Buffer_Release(ib);
     }
 
     if (geometry->fill.bezier_vertex_count)
     {
-        buffer_desc.ByteWidth = geometry->fill.bezier_vertex_count * sizeof(*geometry->fill.bezier_vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.bezier_vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create beziers vertex buffer, hr %#x.\n", hr);
+        if (!(vb = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_FILL_BEZIER_VB,
+                D3D10_BIND_VERTEX_BUFFER, geometry->fill.bezier_vertices,
+                geometry->fill.bezier_vertex_count * sizeof(*geometry->fill.bezier_vertices))))
             goto done;
-        }
 
         d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_CURVE, NULL, geometry->fill.bezier_vertex_count, vb,
                 sizeof(*geometry->fill.bezier_vertices), vs_cb, ps_cb_bezier, brush, opacity_brush);
-
-        ID3D10Buffer_Release(vb);
     }
 
     if (geometry->fill.arc_vertex_count)
     {
-        buffer_desc.ByteWidth = geometry->fill.arc_vertex_count * sizeof(*geometry->fill.arc_vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.arc_vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create arc vertex buffer, hr %#x.\n", hr);
+        if (!(vb = d2d_geometry_get_buffer(render_target, geometry, D2D_GEOMETRY_BUFFER_FILL_ARC_VB,
+                D3D10_BIND_VERTEX_BUFFER, geometry->fill.arc_vertices,
+                geometry->fill.arc_vertex_count * sizeof(*geometry->fill.arc_vertices))))
             goto done;
-        }
 
         d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_CURVE, NULL, geometry->fill.arc_vertex_count, vb,
                 sizeof(*geometry->fill.arc_vertices), vs_cb, ps_cb_arc, brush, opacity_brush);
-
-        ID3D10Buffer_Release(vb);
     }
 
 done:
@@ -1032,7 +997,7 @@ done:
 static void STDMETHODCALLTYPE d2d_device_context_FillGeometry(ID2D1DeviceContext *iface,
         ID2D1Geometry *geometry, ID2D1Brush *brush, ID2D1Brush *opacity_brush)
 {
-    const struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
+    struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
     struct d2d_brush *opacity_brush_impl = unsafe_impl_from_ID2D1Brush(opacity_brush);
     struct d2d_device_context *context = impl_from_ID2D1DeviceContext(iface);
     struct d2d_brush *brush_impl = unsafe_impl_from_ID2D1Brush(brush);
@@ -2422,8 +2422,24 @@ static BOOL d2d_geometry_fill_add_arc_triangle(struct d2d_geometry *geometry,
     return TRUE;
 }
 
+void d2d_geometry_release_buffers(struct d2d_geometry *geometry)
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(geometry->buffers); ++i)
+    {
+        if (geometry->buffers[i])
+        {
+            ID3D10Buffer_Release(geometry->buffers[i]);
+            geometry->buffers[i] = NULL;
+        }
+    }
+    geometry->buffer_device = NULL;
+}
+
 static void d2d_geometry_cleanup(struct d2d_geometry *geometry)
 {
+    d2d_geometry_release_buffers(geometry);
     heap_free(geometry->outline.arc_faces);
     heap_free(geometry->outline.arcs);
     heap_free(geometry->outline.bezier_faces);
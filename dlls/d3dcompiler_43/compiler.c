@@ -34,6 +34,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(d3dcompiler);
 static PFN_vkd3d_shader_compile vkd3d_shader_compile;
 static PFN_vkd3d_shader_free_messages vkd3d_shader_free_messages;
 static PFN_vkd3d_shader_free_shader_code vkd3d_shader_free_shader_code;
+static PFN_vkd3d_shader_get_version vkd3d_shader_get_version;
 
 static HMODULE vkd3d_shader_handle;
 
@@ -71,6 +72,7 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, void *reserved)
                 vkd3d_shader_compile = (void *)GetProcAddress(vkd3d_shader_handle, "vkd3d_shader_compile");
                 vkd3d_shader_free_messages = (void *)GetProcAddress(vkd3d_shader_handle, "vkd3d_shader_free_messages");
                 vkd3d_shader_free_shader_code = (void *)GetProcAddress(vkd3d_shader_handle, "vkd3d_shader_free_shader_code");
+                vkd3d_shader_get_version = (void *)GetProcAddress(vkd3d_shader_handle, "vkd3d_shader_get_version");
             }
     }
 
@@ -779,10 +781,90 @@ struct d3dcompiler_include_from_file
     ID3DInclude ID3DInclude_iface;
 };
 
+/* Includes opened while compiling, recorded so that a cached compilation can
+ * be validated against the current contents of the same includes. */
+struct cached_include
+{
+    char *name;
+    BOOL local;
+    int parent; /* index of the including file, -1 for the main source */
+    const void *code;
+    UINT size;
+    char *data;
+};
+
+struct compile_include_context
+{
+    ID3DInclude *iface;
+    struct cached_include *includes;
+    unsigned int count, capacity;
+    BOOL record_failed;
+};
+
+static void record_include(struct compile_include_context *context, const char *filename, bool local,
+        const char *parent_data, const struct vkd3d_shader_code *code)
+{
+    struct cached_include *include;
+    unsigned int i;
+
+    if (context->record_failed)
+        return;
+
+    if (context->count == context->capacity)
+    {
+        unsigned int new_capacity = max(context->capacity * 2, 8);
+        struct cached_include *new_includes;
+
+        if (!(new_includes = heap_realloc(context->includes, new_capacity * sizeof(*new_includes))))
+        {
+            context->record_failed = TRUE;
+            return;
+        }
+        context->includes = new_includes;
+        context->capacity = new_capacity;
+    }
+
+    include = &context->includes[context->count];
+    include->local = local;
+    include->parent = -1;
+    for (i = 0; i < context->count; ++i)
+    {
+        if (context->includes[i].code == parent_data)
+            include->parent = i;
+    }
+    include->code = code->code;
+    include->size = code->size;
+    include->name = heap_alloc(strlen(filename) + 1);
+    include->data = heap_alloc(code->size);
+    if (!include->name || !include->data)
+    {
+        heap_free(include->name);
+        heap_free(include->data);
+        context->record_failed = TRUE;
+        return;
+    }
+    strcpy(include->name, filename);
+    memcpy(include->data, code->code, code->size);
+    ++context->count;
+}
+
+static void free_cached_includes(struct cached_include *includes, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        heap_free(includes[i].name);
+        heap_free(includes[i].data);
+    }
+    heap_free(includes);
+}
+
 static int open_include(const char *filename, bool local, const char *parent_data, void *context,
         struct vkd3d_shader_code *code)
 {
-    ID3DInclude *iface = context;
+    struct compile_include_context *include_context = context;
+    ID3DInclude *iface = include_context->iface;
     unsigned int size = 0;
 
     if (!iface)
@@ -794,14 +876,306 @@ static int open_include(const char *filename, bool local, const char *parent_dat
         return VKD3D_ERROR;
 
     code->size = size;
+    record_include(include_context, filename, local, parent_data, code);
     return VKD3D_OK;
 }
 
 static void close_include(const struct vkd3d_shader_code *code, void *context)
 {
-    ID3DInclude *iface = context;
+    struct compile_include_context *include_context = context;
+
+    ID3DInclude_Close(include_context->iface, code->code);
+}
+
+/* On-disk cache of compiled shaders, shared by all d3dcompiler versions.
+ *
+ * Entries are named after a hash of everything the compilation depends on,
+ * and store that data in full so that a hash collision is never mistaken
+ * for a hit. The includes opened during the compilation are stored as well
+ * and opened again on lookup; the entry is only used when all of them still
+ * have the same contents. */
+
+#define SHADER_CACHE_MAGIC 0x43334457 /* "WD3C" */
+
+struct cache_buffer
+{
+    BYTE *data;
+    SIZE_T size, capacity;
+    BOOL failed;
+};
+
+static void cache_buffer_append(struct cache_buffer *buffer, const void *data, SIZE_T size)
+{
+    if (buffer->failed)
+        return;
+
+    if (size > buffer->capacity - buffer->size)
+    {
+        SIZE_T new_capacity = max(buffer->capacity * 2, buffer->size + size);
+        BYTE *new_data;
+
+        if (!(new_data = heap_realloc(buffer->data, new_capacity)))
+        {
+            buffer->failed = TRUE;
+            return;
+        }
+        buffer->data = new_data;
+        buffer->capacity = new_capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+static void cache_buffer_append_uint(struct cache_buffer *buffer, UINT value)
+{
+    cache_buffer_append(buffer, &value, sizeof(value));
+}
+
+static void cache_buffer_append_data(struct cache_buffer *buffer, const void *data, SIZE_T size)
+{
+    cache_buffer_append_uint(buffer, size);
+    cache_buffer_append(buffer, data, size);
+}
+
+static void cache_buffer_append_string(struct cache_buffer *buffer, const char *str)
+{
+    /* Distinguish NULL from empty strings. */
+    if (!str)
+        cache_buffer_append_uint(buffer, ~0u);
+    else
+        cache_buffer_append_data(buffer, str, strlen(str));
+}
+
+struct cache_reader
+{
+    const BYTE *data;
+    SIZE_T size, pos;
+};
+
+static const void *cache_read(struct cache_reader *reader, SIZE_T size)
+{
+    const void *ret;
+
+    if (size > reader->size - reader->pos)
+        return NULL;
+    ret = reader->data + reader->pos;
+    reader->pos += size;
+    return ret;
+}
+
+static BOOL cache_read_uint(struct cache_reader *reader, UINT *value)
+{
+    const UINT *ptr;
+
+    if (!(ptr = cache_read(reader, sizeof(*ptr))))
+        return FALSE;
+    memcpy(value, ptr, sizeof(*value));
+    return TRUE;
+}
+
+static const void *cache_read_data(struct cache_reader *reader, UINT *size)
+{
+    if (!cache_read_uint(reader, size))
+        return NULL;
+    return cache_read(reader, *size);
+}
+
+static BOOL get_shader_cache_path(const struct cache_buffer *key, char *path, DWORD size)
+{
+    ULONG64 hash = 0xcbf29ce484222325ull;
+    char *p;
+    DWORD len;
+    SIZE_T i;
+
+    for (i = 0; i < key->size; ++i)
+        hash = (hash ^ key->data[i]) * 0x100000001b3ull;
+
+    if (!(len = GetEnvironmentVariableA("LOCALAPPDATA", path, size)) || len + 64 > size)
+        return FALSE;
+
+    strcpy(path + len, "\\wine");
+    CreateDirectoryA(path, NULL);
+    strcat(path, "\\d3dcompiler");
+    CreateDirectoryA(path, NULL);
+    p = path + strlen(path);
+    sprintf(p, "\\%08x%08x.bin", (UINT)(hash >> 32), (UINT)hash);
+    return TRUE;
+}
+
+static void build_shader_cache_key(struct cache_buffer *key, const void *data, SIZE_T data_size,
+        const char *filename, const D3D_SHADER_MACRO *macros, ID3DInclude *include,
+        const char *entry_point, const char *profile, UINT flags, UINT effect_flags,
+        UINT secondary_flags, const void *secondary_data, SIZE_T secondary_data_size)
+{
+    const D3D_SHADER_MACRO *macro;
+    unsigned int macro_count = 0;
+
+    cache_buffer_append_uint(key, SHADER_CACHE_MAGIC);
+    cache_buffer_append_string(key, vkd3d_shader_get_version(NULL, NULL));
+    cache_buffer_append_data(key, data, data_size);
+    cache_buffer_append_string(key, filename);
+    if (macros)
+    {
+        for (macro = macros; macro->Name; ++macro)
+            ++macro_count;
+    }
+    cache_buffer_append_uint(key, macro_count);
+    for (macro = macros; macro_count--; ++macro)
+    {
+        cache_buffer_append_string(key, macro->Name);
+        cache_buffer_append_string(key, macro->Definition);
+    }
+    cache_buffer_append_uint(key, !!include);
+    cache_buffer_append_string(key, entry_point);
+    cache_buffer_append_string(key, profile);
+    cache_buffer_append_uint(key, flags);
+    cache_buffer_append_uint(key, effect_flags);
+    cache_buffer_append_uint(key, secondary_flags);
+    cache_buffer_append_data(key, secondary_data, secondary_data ? secondary_data_size : 0);
+}
+
+static BOOL check_cached_includes(struct cache_reader *reader, ID3DInclude *include, const void *source)
+{
+    const void **opened = NULL;
+    unsigned int i, count, opened_count = 0;
+    BOOL ret = FALSE;
+
+    if (!cache_read_uint(reader, &count))
+        return FALSE;
+    if (!count)
+        return TRUE;
+    if (!include || !(opened = heap_alloc(count * sizeof(*opened))))
+        return FALSE;
+
+    for (i = 0; i < count; ++i)
+    {
+        UINT name_size, local, parent, size, open_size;
+        const void *name, *data, *open_data;
+        char *name_str;
+        HRESULT hr;
+
+        if (!(name = cache_read_data(reader, &name_size)) || !cache_read_uint(reader, &local)
+                || !cache_read_uint(reader, &parent) || !(data = cache_read_data(reader, &size)))
+            goto done;
+        if (parent != ~0u && parent >= i)
+            goto done;
+        if (!(name_str = heap_alloc(name_size + 1)))
+            goto done;
+        memcpy(name_str, name, name_size);
+        name_str[name_size] = 0;
+        hr = ID3DInclude_Open(include, local ? D3D_INCLUDE_LOCAL : D3D_INCLUDE_SYSTEM, name_str,
+                parent == ~0u ? source : opened[parent], &open_data, &open_size);
+        heap_free(name_str);
+        if (FAILED(hr))
+            goto done;
+        opened[opened_count++] = open_data;
+        if (open_size != size || memcmp(open_data, data, size))
+            goto done;
+    }
+    ret = TRUE;
+
+done:
+    while (opened_count)
+        ID3DInclude_Close(include, opened[--opened_count]);
+    heap_free(opened);
+    return ret;
+}
+
+static BOOL load_cached_shader(const char *path, const struct cache_buffer *key, ID3DInclude *include,
+        const void *source, ID3DBlob **shader_blob, ID3DBlob **messages_blob)
+{
+    struct cache_reader reader;
+    UINT key_size, has_messages, messages_size, code_size;
+    const void *cached_key, *messages, *code;
+    LARGE_INTEGER file_size;
+    BYTE *buffer = NULL;
+    BOOL ret = FALSE;
+    HANDLE file;
+    DWORD read;
 
-    ID3DInclude_Close(iface, code->code);
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return FALSE;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart > 0x7fffffff
+            || !(buffer = heap_alloc(file_size.QuadPart))
+            || !ReadFile(file, buffer, file_size.QuadPart, &read, NULL) || read != file_size.QuadPart)
+        goto done;
+
+    reader.data = buffer;
+    reader.size = read;
+    reader.pos = 0;
+
+    if (!(cached_key = cache_read_data(&reader, &key_size))
+            || key_size != key->size || memcmp(cached_key, key->data, key_size))
+        goto done;
+    if (!check_cached_includes(&reader, include, source))
+        goto done;
+    if (!cache_read_uint(&reader, &has_messages) || !(messages = cache_read_data(&reader, &messages_size))
+            || !(code = cache_read_data(&reader, &code_size)))
+        goto done;
+
+    if (FAILED(D3DCreateBlob(code_size, shader_blob)))
+        goto done;
+    memcpy(ID3D10Blob_GetBufferPointer(*shader_blob), code, code_size);
+
+    if (has_messages && messages_blob)
+    {
+        if (FAILED(D3DCreateBlob(messages_size, messages_blob)))
+        {
+            ID3D10Blob_Release(*shader_blob);
+            *shader_blob = NULL;
+            goto done;
+        }
+        memcpy(ID3D10Blob_GetBufferPointer(*messages_blob), messages, messages_size);
+    }
+
+    TRACE("Using cached shader %s.\n", debugstr_a(path));
+    ret = TRUE;
+
+done:
+    heap_free(buffer);
+    CloseHandle(file);
+    return ret;
+}
+
+static void store_cached_shader(const char *path, const struct cache_buffer *key,
+        const struct compile_include_context *includes, const char *messages,
+        const struct vkd3d_shader_code *byte_code)
+{
+    struct cache_buffer entry = {0};
+    char tmp_path[MAX_PATH + 16];
+    unsigned int i;
+    HANDLE file;
+    DWORD written;
+    BOOL ret;
+
+    cache_buffer_append_data(&entry, key->data, key->size);
+    cache_buffer_append_uint(&entry, includes->count);
+    for (i = 0; i < includes->count; ++i)
+    {
+        cache_buffer_append_string(&entry, includes->includes[i].name);
+        cache_buffer_append_uint(&entry, includes->includes[i].local);
+        cache_buffer_append_uint(&entry, includes->includes[i].parent);
+        cache_buffer_append_data(&entry, includes->includes[i].data, includes->includes[i].size);
+    }
+    cache_buffer_append_uint(&entry, !!messages);
+    cache_buffer_append_data(&entry, messages, messages ? strlen(messages) : 0);
+    cache_buffer_append_data(&entry, byte_code->code, byte_code->size);
+    if (entry.failed)
+        goto done;
+
+    /* Write to a temporary file first, other processes may be looking up the same entry. */
+    sprintf(tmp_path, "%s.%x", path, GetCurrentThreadId());
+    file = CreateFileA(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        goto done;
+    ret = WriteFile(file, entry.data, entry.size, &written, NULL) && written == entry.size;
+    CloseHandle(file);
+    if (!ret || !MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+        DeleteFileA(tmp_path);
+
+done:
+    heap_free(entry.data);
 }
 
 HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filename,
@@ -816,7 +1190,11 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
     struct vkd3d_shader_compile_option options[1];
     struct vkd3d_shader_compile_info compile_info;
     struct vkd3d_shader_code byte_code;
+    struct compile_include_context include_context = {0};
+    struct cache_buffer cache_key = {0};
+    char cache_path[MAX_PATH];
     const D3D_SHADER_MACRO *macro;
+    BOOL use_cache = FALSE;
     char *messages;
     HRESULT hr;
     int ret;
@@ -844,6 +1222,18 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
     if (messages_blob)
         *messages_blob = NULL;
 
+    if (vkd3d_shader_get_version)
+    {
+        build_shader_cache_key(&cache_key, data, data_size, filename, macros, include, entry_point,
+                profile, flags, effect_flags, secondary_flags, secondary_data, secondary_data_size);
+        use_cache = !cache_key.failed && get_shader_cache_path(&cache_key, cache_path, sizeof(cache_path) - 16);
+        if (use_cache && load_cached_shader(cache_path, &cache_key, include, data, shader_blob, messages_blob))
+        {
+            heap_free(cache_key.data);
+            return S_OK;
+        }
+    }
+
     compile_info.type = VKD3D_SHADER_STRUCTURE_TYPE_COMPILE_INFO;
     compile_info.next = &preprocess_info;
     compile_info.source.code = data;
@@ -866,7 +1256,8 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
     }
     preprocess_info.pfn_open_include = open_include;
     preprocess_info.pfn_close_include = close_include;
-    preprocess_info.include_context = include;
+    include_context.iface = include;
+    preprocess_info.include_context = &include_context;
 
     hlsl_info.type = VKD3D_SHADER_STRUCTURE_TYPE_HLSL_SOURCE_INFO;
     hlsl_info.next = NULL;
@@ -879,6 +1270,12 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
         options[compile_info.option_count++].name = VKD3D_SHADER_COMPILE_OPTION_STRIP_DEBUG;
 
     ret = vkd3d_shader_compile(&compile_info, &byte_code, &messages);
+
+    if (!ret && use_cache && !include_context.record_failed)
+        store_cached_shader(cache_path, &cache_key, &include_context, messages, &byte_code);
+    free_cached_includes(include_context.includes, include_context.count);
+    heap_free(cache_key.data);
+
     if (messages)
     {
         if (messages_blob)
@@ -136,6 +136,8 @@ struct d3dx_pass
     struct d3dx_parameter *annotations;
 
     ULONG64 update_version;
+    /* Version counter value after the pass states were last applied. */
+    ULONG64 applied_version;
 };
 
 struct d3dx_technique
@@ -1729,10 +1731,18 @@ static HRESULT d3dx9_apply_pass_states(struct d3dx_effect *effect, struct d3dx_p
     unsigned int i;
     HRESULT ret;
     HRESULT hr;
-    ULONG64 new_update_version = next_effect_update_version(effect);
+    ULONG64 new_update_version;
 
     TRACE("effect %p, pass %p, state_count %u.\n", effect, pass, pass->state_count);
 
+    /* Nothing which any of the states depend on has changed since they were
+     * last applied, there is no need to walk them again. */
+    if (!update_all && !effect->light_updated && !effect->material_updated
+            && *get_version_counter_ptr(effect) == pass->applied_version)
+        return D3D_OK;
+
+    new_update_version = next_effect_update_version(effect);
+
     ret = D3D_OK;
     for (i = 0; i < pass->state_count; ++i)
     {
@@ -1766,6 +1776,7 @@ static HRESULT d3dx9_apply_pass_states(struct d3dx_effect *effect, struct d3dx_p
     effect->material_updated = FALSE;
 
     pass->update_version = new_update_version;
+    pass->applied_version = *get_version_counter_ptr(effect);
     return ret;
 }
 
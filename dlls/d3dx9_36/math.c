@@ -392,17 +392,22 @@ D3DXMATRIX * WINAPI D3DXMatrixLookAtRH(D3DXMATRIX *out, const D3DXVECTOR3 *eye,
 
 D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, const D3DXMATRIX *pm1, const D3DXMATRIX *pm2)
 {
-    D3DXMATRIX out;
+    D3DXMATRIX out, m2 = *pm2;
+    FLOAT a0, a1, a2, a3;
     int i,j;
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+    /* Broadcast each element of a row of pm1 over the rows of pm2, the inner
+     * loop is then a plain 4-wide multiply-add which the compiler vectorizes. */
     for (i=0; i<4; i++)
     {
+        a0 = pm1->u.m[i][0];
+        a1 = pm1->u.m[i][1];
+        a2 = pm1->u.m[i][2];
+        a3 = pm1->u.m[i][3];
         for (j=0; j<4; j++)
-        {
-            out.u.m[i][j] = pm1->u.m[i][0] * pm2->u.m[0][j] + pm1->u.m[i][1] * pm2->u.m[1][j] + pm1->u.m[i][2] * pm2->u.m[2][j] + pm1->u.m[i][3] * pm2->u.m[3][j];
-        }
+            out.u.m[i][j] = a0 * m2.u.m[0][j] + a1 * m2.u.m[1][j] + a2 * m2.u.m[2][j] + a3 * m2.u.m[3][j];
     }
 
     *pout = out;
@@ -1821,6 +1826,20 @@ D3DXVECTOR3* WINAPI D3DXVec3Normalize(D3DXVECTOR3 *pout, const D3DXVECTOR3 *pv)
     return pout;
 }
 
+static inline void transform_coord(D3DXVECTOR3 *v, const D3DXMATRIX *pm)
+{
+    D3DXVECTOR3 out;
+    FLOAT norm;
+
+    norm = pm->u.m[0][3] * v->x + pm->u.m[1][3] * v->y + pm->u.m[2][3] * v->z + pm->u.m[3][3];
+
+    out.x = (pm->u.m[0][0] * v->x + pm->u.m[1][0] * v->y + pm->u.m[2][0] * v->z + pm->u.m[3][0]) / norm;
+    out.y = (pm->u.m[0][1] * v->x + pm->u.m[1][1] * v->y + pm->u.m[2][1] * v->z + pm->u.m[3][1]) / norm;
+    out.z = (pm->u.m[0][2] * v->x + pm->u.m[1][2] * v->y + pm->u.m[2][2] * v->z + pm->u.m[3][2]) / norm;
+
+    *v = out;
+}
+
 D3DXVECTOR3* WINAPI D3DXVec3Project(D3DXVECTOR3 *pout, const D3DXVECTOR3 *pv, const D3DVIEWPORT9 *pviewport, const D3DXMATRIX *pprojection, const D3DXMATRIX *pview, const D3DXMATRIX *pworld)
 {
     D3DXMATRIX m;
@@ -1846,15 +1865,28 @@ D3DXVECTOR3* WINAPI D3DXVec3Project(D3DXVECTOR3 *pout, const D3DXVECTOR3 *pv, co
 D3DXVECTOR3* WINAPI D3DXVec3ProjectArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DVIEWPORT9* viewport, const D3DXMATRIX* projection, const D3DXMATRIX* view, const D3DXMATRIX* world, UINT elements)
 {
     UINT i;
+    D3DXMATRIX m;
+    D3DXVECTOR3 v;
 
     TRACE("out %p, outstride %u, in %p, instride %u, viewport %p, projection %p, view %p, world %p, elements %u\n",
         out, outstride, in, instride, viewport, projection, view, world, elements);
 
+    /* the combined matrix is the same for every element */
+    D3DXMatrixIdentity(&m);
+    if (world) D3DXMatrixMultiply(&m, &m, world);
+    if (view) D3DXMatrixMultiply(&m, &m, view);
+    if (projection) D3DXMatrixMultiply(&m, &m, projection);
+
     for (i = 0; i < elements; ++i) {
-        D3DXVec3Project(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            viewport, projection, view, world);
+        v = *(const D3DXVECTOR3*)((const char*)in + instride * i);
+        transform_coord(&v, &m);
+        if (viewport)
+        {
+            v.x = viewport->X +  ( 1.0f + v.x ) * viewport->Width / 2.0f;
+            v.y = viewport->Y +  ( 1.0f - v.y ) * viewport->Height / 2.0f;
+            v.z = viewport->MinZ + v.z * ( viewport->MaxZ - viewport->MinZ );
+        }
+        *(D3DXVECTOR3*)((char*)out + outstride * i) = v;
     }
     return out;
 }
@@ -1876,14 +1908,19 @@ D3DXVECTOR4* WINAPI D3DXVec3Transform(D3DXVECTOR4 *pout, const D3DXVECTOR3 *pv,
 D3DXVECTOR4* WINAPI D3DXVec3TransformArray(D3DXVECTOR4* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
     UINT i;
+    D3DXMATRIX m = *matrix;
+    D3DXVECTOR4 *o;
+    D3DXVECTOR3 v;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
     for (i = 0; i < elements; ++i) {
-        D3DXVec3Transform(
-            (D3DXVECTOR4*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            matrix);
+        v = *(const D3DXVECTOR3*)((const char*)in + instride * i);
+        o = (D3DXVECTOR4*)((char*)out + outstride * i);
+        o->x = m.u.m[0][0] * v.x + m.u.m[1][0] * v.y + m.u.m[2][0] * v.z + m.u.m[3][0];
+        o->y = m.u.m[0][1] * v.x + m.u.m[1][1] * v.y + m.u.m[2][1] * v.z + m.u.m[3][1];
+        o->z = m.u.m[0][2] * v.x + m.u.m[1][2] * v.y + m.u.m[2][2] * v.z + m.u.m[3][2];
+        o->w = m.u.m[0][3] * v.x + m.u.m[1][3] * v.y + m.u.m[2][3] * v.z + m.u.m[3][3];
     }
     return out;
 }
@@ -1909,14 +1946,15 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformCoord(D3DXVECTOR3 *pout, const D3DXVECTOR3
 D3DXVECTOR3* WINAPI D3DXVec3TransformCoordArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
     UINT i;
+    D3DXMATRIX m = *matrix;
+    D3DXVECTOR3 v;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
     for (i = 0; i < elements; ++i) {
-        D3DXVec3TransformCoord(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            matrix);
+        v = *(const D3DXVECTOR3*)((const char*)in + instride * i);
+        transform_coord(&v, &m);
+        *(D3DXVECTOR3*)((char*)out + outstride * i) = v;
     }
     return out;
 }
@@ -1937,14 +1975,17 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformNormal(D3DXVECTOR3 *pout, const D3DXVECTOR3
 D3DXVECTOR3* WINAPI D3DXVec3TransformNormalArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
     UINT i;
+    D3DXMATRIX m = *matrix;
+    D3DXVECTOR3 *o, v;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
     for (i = 0; i < elements; ++i) {
-        D3DXVec3TransformNormal(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            matrix);
+        v = *(const D3DXVECTOR3*)((const char*)in + instride * i);
+        o = (D3DXVECTOR3*)((char*)out + outstride * i);
+        o->x = m.u.m[0][0] * v.x + m.u.m[1][0] * v.y + m.u.m[2][0] * v.z;
+        o->y = m.u.m[0][1] * v.x + m.u.m[1][1] * v.y + m.u.m[2][1] * v.z;
+        o->z = m.u.m[0][2] * v.x + m.u.m[1][2] * v.y + m.u.m[2][2] * v.z;
     }
     return out;
 }
@@ -1981,15 +2022,32 @@ D3DXVECTOR3 * WINAPI D3DXVec3Unproject(D3DXVECTOR3 *out, const D3DXVECTOR3 *v,
 D3DXVECTOR3* WINAPI D3DXVec3UnprojectArray(D3DXVECTOR3* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DVIEWPORT9* viewport, const D3DXMATRIX* projection, const D3DXMATRIX* view, const D3DXMATRIX* world, UINT elements)
 {
     UINT i;
+    D3DXMATRIX m;
+    D3DXVECTOR3 v;
 
     TRACE("out %p, outstride %u, in %p, instride %u, viewport %p, projection %p, view %p, world %p, elements %u\n",
         out, outstride, in, instride, viewport, projection, view, world, elements);
 
+    /* the combined and inverted matrix is the same for every element */
+    D3DXMatrixIdentity(&m);
+    if (world)
+        D3DXMatrixMultiply(&m, &m, world);
+    if (view)
+        D3DXMatrixMultiply(&m, &m, view);
+    if (projection)
+        D3DXMatrixMultiply(&m, &m, projection);
+    D3DXMatrixInverse(&m, NULL, &m);
+
     for (i = 0; i < elements; ++i) {
-        D3DXVec3Unproject(
-            (D3DXVECTOR3*)((char*)out + outstride * i),
-            (const D3DXVECTOR3*)((const char*)in + instride * i),
-            viewport, projection, view, world);
+        v = *(const D3DXVECTOR3*)((const char*)in + instride * i);
+        if (viewport)
+        {
+            v.x = 2.0f * (v.x - viewport->X) / viewport->Width - 1.0f;
+            v.y = 1.0f - 2.0f * (v.y - viewport->Y) / viewport->Height;
+            v.z = (v.z - viewport->MinZ) / (viewport->MaxZ - viewport->MinZ);
+        }
+        transform_coord(&v, &m);
+        *(D3DXVECTOR3*)((char*)out + outstride * i) = v;
     }
     return out;
 }
@@ -2083,14 +2141,18 @@ D3DXVECTOR4* WINAPI D3DXVec4Transform(D3DXVECTOR4 *pout, const D3DXVECTOR4 *pv,
 D3DXVECTOR4* WINAPI D3DXVec4TransformArray(D3DXVECTOR4* out, UINT outstride, const D3DXVECTOR4* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
     UINT i;
+    D3DXMATRIX m = *matrix;
+    D3DXVECTOR4 *o, v;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
     for (i = 0; i < elements; ++i) {
-        D3DXVec4Transform(
-            (D3DXVECTOR4*)((char*)out + outstride * i),
-            (const D3DXVECTOR4*)((const char*)in + instride * i),
-            matrix);
+        v = *(const D3DXVECTOR4*)((const char*)in + instride * i);
+        o = (D3DXVECTOR4*)((char*)out + outstride * i);
+        o->x = m.u.m[0][0] * v.x + m.u.m[1][0] * v.y + m.u.m[2][0] * v.z + m.u.m[3][0] * v.w;
+        o->y = m.u.m[0][1] * v.x + m.u.m[1][1] * v.y + m.u.m[2][1] * v.z + m.u.m[3][1] * v.w;
+        o->z = m.u.m[0][2] * v.x + m.u.m[1][2] * v.y + m.u.m[2][2] * v.z + m.u.m[3][2] * v.w;
+        o->w = m.u.m[0][3] * v.x + m.u.m[1][3] * v.y + m.u.m[2][3] * v.z + m.u.m[3][3] * v.w;
     }
     return out;
 }
@@ -1874,6 +1874,79 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
     }
 }
 
+#define MAX_DXTN_THREADS 16
+
+struct dxtn_band
+{
+    GLenum format;
+    GLint width;
+    GLint height;
+    GLint dst_row_stride;
+    const GLubyte *src;
+    GLubyte *dst;
+};
+
+static DWORD WINAPI compress_dxtn_band_proc(void *arg)
+{
+    struct dxtn_band *band = arg;
+
+    tx_compress_dxtn(4, band->width, band->height, band->src, band->format, band->dst, band->dst_row_stride);
+    return 0;
+}
+
+/* Blocks are compressed independently, so split large surfaces into bands of
+ * block rows and compress them on one thread per CPU. */
+static void compress_dxtn(GLenum format, GLint width, GLint height, const GLubyte *src,
+        GLubyte *dst, GLint dst_row_stride)
+{
+    struct dxtn_band bands[MAX_DXTN_THREADS];
+    HANDLE threads[MAX_DXTN_THREADS];
+    unsigned int i, band_count, thread_count = 0;
+    GLint block_rows, band_rows, block_size, row_size, y;
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    block_rows = (height + 3) / 4;
+    band_count = min(min(info.dwNumberOfProcessors, MAX_DXTN_THREADS), block_rows);
+
+    if (band_count <= 1 || width * height < 256 * 256)
+    {
+        tx_compress_dxtn(4, width, height, src, format, dst, dst_row_stride);
+        return;
+    }
+
+    /* Same destination block row size as used by tx_compress_dxtn(). */
+    block_size = (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 2 : 4;
+    row_size = ((width + 3) & ~3) * block_size;
+    if (dst_row_stride >= width * block_size)
+        row_size = dst_row_stride;
+
+    band_rows = (block_rows + band_count - 1) / band_count;
+    for (i = 0, y = 0; y < block_rows; ++i, y += band_rows)
+    {
+        bands[i].format = format;
+        bands[i].width = width;
+        bands[i].height = min(band_rows * 4, height - y * 4);
+        bands[i].dst_row_stride = dst_row_stride;
+        bands[i].src = src + y * 4 * width * 4;
+        bands[i].dst = dst + y * row_size;
+    }
+    band_count = i;
+
+    for (i = 1; i < band_count; ++i)
+    {
+        if ((threads[thread_count] = CreateThread(NULL, 0, compress_dxtn_band_proc, &bands[i], 0, NULL)))
+            ++thread_count;
+        else
+            compress_dxtn_band_proc(&bands[i]);
+    }
+    compress_dxtn_band_proc(&bands[0]);
+
+    WaitForMultipleObjects(thread_count, threads, TRUE, INFINITE);
+    for (i = 0; i < thread_count; ++i)
+        CloseHandle(threads[i]);
+}
+
 /************************************************************
  * D3DXLoadSurfaceFromMemory
  *
@@ -2144,8 +2217,8 @@ HRESULT WINAPI D3DXLoadSurfaceFromMemory(IDirect3DSurface9 *dst_surface,
                 default:
                     ERR("Unexpected destination compressed format %u.\n", surfdesc.Format);
             }
-            tx_compress_dxtn(4, dst_size_aligned.width, dst_size_aligned.height,
-                    dst_uncompressed, gl_format, lockrect.pBits,
+            compress_dxtn(gl_format, dst_size_aligned.width, dst_size_aligned.height,
+                    dst_uncompressed, lockrect.pBits,
                     lockrect.Pitch * destformatdesc->block_width / destformatdesc->block_byte_count);
             heap_free(dst_uncompressed);
         }
@@ -465,6 +465,53 @@ static BOOL default_unwind(struct cpu_stack_walk* csw, CONTEXT* context)
     return TRUE;
 }
 
+#define UNWIND_CACHE_SIZE   512
+#define UNWIND_CACHE_CODES  30
+
+struct unwind_cache_entry
+{
+    DWORD64     addr;   /* address of the cached unwind info, 0 if unused */
+    BYTE        data[FIELD_OFFSET(UNWIND_INFO, UnwindCode) + UNWIND_CACHE_CODES * sizeof(UNWIND_CODE)];
+};
+
+/* read the unwind info and codes at addr, going through the per process cache
+ * as walking many stacks reads the same entries over and over */
+static BOOL read_unwind_info(struct cpu_stack_walk* csw, DWORD64 addr, UNWIND_INFO* info)
+{
+    struct unwind_cache_entry*  entry = NULL;
+    struct process*             pcs;
+
+    if ((pcs = process_find_by_handle(csw->hProcess)))
+    {
+        if (!pcs->unwind_cache)
+            pcs->unwind_cache = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                          UNWIND_CACHE_SIZE * sizeof(struct unwind_cache_entry));
+        if (pcs->unwind_cache)
+        {
+            entry = (struct unwind_cache_entry*)pcs->unwind_cache + (addr >> 2) % UNWIND_CACHE_SIZE;
+            if (entry->addr == addr)
+            {
+                memcpy(info, entry->data, FIELD_OFFSET(UNWIND_INFO, UnwindCode) +
+                       ((UNWIND_INFO*)entry->data)->CountOfCodes * sizeof(UNWIND_CODE));
+                return TRUE;
+            }
+        }
+    }
+
+    if (!sw_read_mem(csw, addr, info, sizeof(*info)) ||
+        !sw_read_mem(csw, addr + FIELD_OFFSET(UNWIND_INFO, UnwindCode),
+                     info->UnwindCode, info->CountOfCodes * sizeof(UNWIND_CODE)))
+        return FALSE;
+
+    if (entry && info->CountOfCodes <= UNWIND_CACHE_CODES)
+    {
+        entry->addr = addr;
+        memcpy(entry->data, info, FIELD_OFFSET(UNWIND_INFO, UnwindCode) +
+               info->CountOfCodes * sizeof(UNWIND_CODE));
+    }
+    return TRUE;
+}
+
 static BOOL interpret_function_table_entry(struct cpu_stack_walk* csw,
                                            CONTEXT* context, RUNTIME_FUNCTION* function, DWORD64 base)
 {
@@ -478,13 +525,11 @@ static BOOL interpret_function_table_entry(struct cpu_stack_walk* csw,
 
     /* FIXME: we have some assumptions here */
     assert(context);
-    dump_unwind_info(csw, sw_module_base(csw, context->Rip), function);
+    if (TRACE_ON(dbghelp)) dump_unwind_info(csw, sw_module_base(csw, context->Rip), function);
     newframe = context->Rsp;
     for (;;)
     {
-        if (!sw_read_mem(csw, base + function->UnwindData, info, sizeof(*info)) ||
-            !sw_read_mem(csw, base + function->UnwindData + FIELD_OFFSET(UNWIND_INFO, UnwindCode),
-                         info->UnwindCode, info->CountOfCodes * sizeof(UNWIND_CODE)))
+        if (!read_unwind_info(csw, base + function->UnwindData, info))
         {
             WARN("Couldn't read unwind_code at %lx\n", base + function->UnwindData);
             return FALSE;
@@ -368,11 +368,14 @@ struct module
 
     /* symbols & symbol tables */
     struct vector               vsymt;
+    DWORD*                      vsymt_hash;     /* vsymt indexes, hashed on symt pointer */
+    unsigned                    vsymt_hash_size;
     int                         sortlist_valid;
     unsigned                    num_sorttab;    /* number of symbols with addresses */
     unsigned                    num_symbols;
     unsigned                    sorttab_size;
     struct symt_ht**            addr_sorttab;
+    ULONG64*                    addr_sortval;   /* addresses of the num_sorttab first symbols */
     struct hash_table           ht_symbols;
 
     /* types */
@@ -418,6 +421,8 @@ struct process
     unsigned                    buffer_size;
     void*                       buffer;
 
+    void*                       unwind_cache;   /* cpu specific cache of unwind information */
+
     BOOL                        is_64bit;
 };
 
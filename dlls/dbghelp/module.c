@@ -215,10 +215,13 @@ struct module* module_new(struct process* pcs, const WCHAR* name,
     module->sortlist_valid    = FALSE;
     module->sorttab_size      = 0;
     module->addr_sorttab      = NULL;
+    module->addr_sortval      = NULL;
     module->num_sorttab       = 0;
     module->num_symbols       = 0;
 
     vector_init(&module->vsymt, sizeof(struct symt*), 128);
+    module->vsymt_hash        = NULL;
+    module->vsymt_hash_size   = 0;
     /* FIXME: this seems a bit too high (on a per module basis)
      * need some statistics about this
      */
@@ -851,8 +854,13 @@ BOOL module_remove(struct process* pcs, struct module* module)
     hash_table_destroy(&module->ht_types);
     HeapFree(GetProcessHeap(), 0, module->sources);
     HeapFree(GetProcessHeap(), 0, module->addr_sorttab);
+    HeapFree(GetProcessHeap(), 0, module->addr_sortval);
+    HeapFree(GetProcessHeap(), 0, module->vsymt_hash);
     HeapFree(GetProcessHeap(), 0, module->real_path);
     pool_destroy(&module->pool);
+    /* the cached unwind information may belong to the removed module */
+    HeapFree(GetProcessHeap(), 0, pcs->unwind_cache);
+    pcs->unwind_cache = NULL;
     /* native dbghelp doesn't invoke registered callback(,CBA_SYMBOLS_UNLOADED,) here
      * so do we
      */
@@ -1275,6 +1283,8 @@ void module_reset_debug_info(struct module* module)
     module->sortlist_valid = TRUE;
     module->sorttab_size = 0;
     module->addr_sorttab = NULL;
+    HeapFree(GetProcessHeap(), 0, module->addr_sortval);
+    module->addr_sortval = NULL;
     module->num_sorttab = module->num_symbols = 0;
     hash_table_destroy(&module->ht_symbols);
     module->ht_symbols.num_buckets = 0;
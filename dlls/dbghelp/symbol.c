@@ -51,6 +51,13 @@ static inline int cmp_sorttab_addr(struct module* module, int idx, ULONG64 addr)
     return cmp_addr(ref, addr);
 }
 
+/* same as cmp_sorttab_addr, but only valid once the sorted table has been built */
+static inline int cmp_sortval_addr(struct module* module, int idx, ULONG64 addr)
+{
+    if (!module->addr_sortval) return cmp_sorttab_addr(module, idx, addr);
+    return cmp_addr(module->addr_sortval[idx], addr);
+}
+
 int __cdecl symt_cmp_addr(const void* p1, const void* p2)
 {
     const struct symt*  sym1 = *(const struct symt* const *)p1;
@@ -62,19 +69,64 @@ int __cdecl symt_cmp_addr(const void* p1, const void* p2)
     return cmp_addr(a1, a2);
 }
 
+#ifdef _WIN64
+static inline unsigned symt_ptr_hash(const struct symt* sym, unsigned size)
+{
+    return (unsigned)((((ULONG_PTR)sym >> 3) * 0x9e3779b97f4a7c15ull) >> 32) & (size - 1);
+}
+
+/* make room in the vsymt hash table for len entries */
+static BOOL symt_grow_index_hash(struct module* module, unsigned len)
+{
+    DWORD*              new;
+    unsigned            size, i, h;
+
+    if (len * 2 < module->vsymt_hash_size) return TRUE;
+    for (size = max(module->vsymt_hash_size, 256); len * 2 >= size; size *= 2);
+    if (!(new = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*new)))) return FALSE;
+    for (i = 0; i < vector_length(&module->vsymt); i++)
+    {
+        h = symt_ptr_hash(*(struct symt**)vector_at(&module->vsymt, i), size);
+        while (new[h]) h = (h + 1) & (size - 1);
+        new[h] = i + 1;
+    }
+    HeapFree(GetProcessHeap(), 0, module->vsymt_hash);
+    module->vsymt_hash = new;
+    module->vsymt_hash_size = size;
+    return TRUE;
+}
+#endif
+
 DWORD             symt_ptr2index(struct module* module, const struct symt* sym)
 {
 #ifdef _WIN64
     const struct symt** c;
     int                 len = vector_length(&module->vsymt), i;
+    unsigned            h;
+
+    if (symt_grow_index_hash(module, len + 1))
+    {
+        for (h = symt_ptr_hash(sym, module->vsymt_hash_size); module->vsymt_hash[h];
+             h = (h + 1) & (module->vsymt_hash_size - 1))
+        {
+            if (*(struct symt**)vector_at(&module->vsymt, module->vsymt_hash[h] - 1) == sym)
+                return module->vsymt_hash[h];
+        }
+        /* not found */
+        if ((c = vector_add(&module->vsymt, &module->pool)))
+        {
+            *c = sym;
+            module->vsymt_hash[h] = len + 1;
+        }
+        return len + 1;
+    }
 
-    /* FIXME: this is inefficient */
+    /* no memory for the hash table, fall back to a linear search */
     for (i = 0; i < len; i++)
     {
         if (*(struct symt**)vector_at(&module->vsymt, i) == sym)
             return i + 1;
     }
-    /* not found */
     c = vector_add(&module->vsymt, &module->pool);
     if (c) *c = sym;
     return len + 1;
@@ -833,6 +885,15 @@ static BOOL resort_symbols(struct module* module)
         }
     }
     module->num_sorttab = module->num_symbols;
+
+    /* cache the addresses so that lookups don't have to dereference every symbol */
+    HeapFree(GetProcessHeap(), 0, module->addr_sortval);
+    if ((module->addr_sortval = HeapAlloc(GetProcessHeap(), 0, module->num_sorttab * sizeof(ULONG64))))
+    {
+        unsigned i;
+        for (i = 0; i < module->num_sorttab; i++)
+            symt_get_address(&module->addr_sorttab[i]->symt, &module->addr_sortval[i]);
+    }
     return module->sortlist_valid = TRUE;
 }
 
@@ -858,14 +919,14 @@ static int symt_get_best_at(struct module* module, int idx_sorttab)
         symt_get_address(&module->addr_sorttab[idx_sorttab]->symt, &ref_addr);
         while (idx_sorttab > 0 &&
                module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol &&
-               !cmp_sorttab_addr(module, idx_sorttab - 1, ref_addr))
+               !cmp_sortval_addr(module, idx_sorttab - 1, ref_addr))
             idx_sorttab--;
         if (module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol)
         {
             idx_sorttab = idx_sorttab_orig;
             while (idx_sorttab < module->num_sorttab - 1 &&
                    module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol &&
-                   !cmp_sorttab_addr(module, idx_sorttab + 1, ref_addr))
+                   !cmp_sortval_addr(module, idx_sorttab + 1, ref_addr))
                 idx_sorttab++;
         }
         /* if no better symbol was found restore the original */
@@ -909,13 +970,13 @@ struct symt_ht* symt_find_nearest(struct module* module, DWORD_PTR addr)
     while (high > low + 1)
     {
         mid = (high + low) / 2;
-        if (cmp_sorttab_addr(module, mid, addr) < 0)
+        if (cmp_sortval_addr(module, mid, addr) < 0)
             low = mid;
         else
             high = mid;
     }
     if (low != high && high != module->num_sorttab &&
-        cmp_sorttab_addr(module, high, addr) <= 0)
+        cmp_sortval_addr(module, high, addr) <= 0)
         low = high;
 
     /* If found symbol is a public symbol, check if there are any other entries that
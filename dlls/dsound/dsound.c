@@ -136,6 +136,7 @@ static HRESULT DirectSoundDevice_Create(DirectSoundDevice ** ppDevice)
     device->ref            = 1;
     device->priolevel      = DSSCL_NORMAL;
     device->stopped        = 1;
+    list_init(&device->fir_banks);
 
     device->speaker_config = 0;
     device->num_speakers = 0;
@@ -235,6 +236,7 @@ static ULONG DirectSoundDevice_Release(DirectSoundDevice * device)
         CloseHandle(device->sleepev);
         HeapFree(GetProcessHeap(), 0, device->tmp_buffer);
         HeapFree(GetProcessHeap(), 0, device->cp_buffer);
+        DSOUND_FreeFirBanks(device);
         HeapFree(GetProcessHeap(), 0, device->buffer);
         device->mixlock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&device->mixlock);
@@ -308,6 +308,73 @@ static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
     return count;
 }
 
+/**
+ * The FIR taps used for one output sample are every firstep'th point of
+ * the FIR, starting at a phase between 0 and firstep - 1, linearly
+ * interpolated with the following point. Precompute both the taps and
+ * the interpolation deltas for each phase, laid out contiguously, so that
+ * the resampler doesn't have to gather them with a stride per sample.
+ * Taps past the end of the FIR are zero.
+ */
+struct fir_bank
+{
+    struct list entry;
+    UINT firstep, taps;
+    float coeffs[1]; /* firstep * taps base values, then firstep * taps deltas */
+};
+
+static const struct fir_bank *get_fir_bank(DirectSoundDevice *device, UINT firstep, UINT taps)
+{
+    struct fir_bank *bank;
+    UINT phase, j, k;
+    float *base, *delta;
+
+    LIST_FOR_EACH_ENTRY(bank, &device->fir_banks, struct fir_bank, entry)
+    {
+        if (bank->firstep == firstep)
+            return bank;
+    }
+
+    if (!(bank = HeapAlloc(GetProcessHeap(), 0, FIELD_OFFSET(struct fir_bank, coeffs[2 * firstep * taps]))))
+        return NULL;
+    bank->firstep = firstep;
+    bank->taps = taps;
+
+    base = bank->coeffs;
+    delta = bank->coeffs + firstep * taps;
+    for (phase = 0; phase < firstep; ++phase)
+    {
+        for (j = 0; j < taps; ++j)
+        {
+            k = phase + j * firstep;
+            if (k < fir_len - 1)
+            {
+                *base++ = fir[k];
+                *delta++ = fir[k + 1] - fir[k];
+            }
+            else
+            {
+                *base++ = 0.0f;
+                *delta++ = 0.0f;
+            }
+        }
+    }
+
+    list_add_head(&device->fir_banks, &bank->entry);
+    return bank;
+}
+
+void DSOUND_FreeFirBanks(DirectSoundDevice *device)
+{
+    struct fir_bank *bank, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(bank, next, &device->fir_banks, struct fir_bank, entry)
+    {
+        list_remove(&bank->entry);
+        HeapFree(GetProcessHeap(), 0, bank);
+    }
+}
+
 static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
 {
     UINT i, channel;
@@ -324,6 +391,7 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
     UINT required_input = max_ipos + fir_cachesize;
     float *intermediate, *fir_copy, *itmp;
+    const struct fir_bank *bank;
 
     DWORD len = required_input * channels;
     len += fir_cachesize;
@@ -340,6 +408,8 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     fir_copy = dsb->device->cp_buffer;
     intermediate = fir_copy + fir_cachesize;
 
+    bank = get_fir_bank(dsb->device, dsbfirstep, fir_cachesize);
+
     if(dsb->use_committed) {
         committed_samples = (dsb->writelead - dsb->committed_mixpos) / istride;
         committed_samples = committed_samples <= required_input ? committed_samples : required_input;
@@ -368,9 +438,19 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
         float rem = int_fir_steps + 1.0 - total_fir_steps;
 
         int fir_used = 0;
-        while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
-            idx += dsb->firstep;
+        if (bank) {
+            const float *base = bank->coeffs + idx * fir_cachesize;
+            const float *delta = base + dsbfirstep * fir_cachesize;
+            float frem = rem;
+
+            /* Zero taps past the end of the FIR don't change the sum. */
+            for (fir_used = 0; fir_used < fir_cachesize; fir_used++)
+                fir_copy[fir_used] = base[fir_used] + delta[fir_used] * frem;
+        } else {
+            while (idx < fir_len - 1) {
+                fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
+                idx += dsb->firstep;
+            }
         }
 
         assert(fir_used <= fir_cachesize);
@@ -378,11 +458,19 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
 
         for (channel = 0; channel < dsb->mix_channels; channel++) {
             int j;
-            float sum = 0.0;
+            float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
             float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
-            dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
+
+            /* Independent accumulators let the dot product pipeline. */
+            for (j = 0; j + 4 <= fir_used; j += 4) {
+                sum0 += fir_copy[j] * cache[j];
+                sum1 += fir_copy[j + 1] * cache[j + 1];
+                sum2 += fir_copy[j + 2] * cache[j + 2];
+                sum3 += fir_copy[j + 3] * cache[j + 3];
+            }
+            for (; j < fir_used; j++)
+                sum0 += fir_copy[j] * cache[j];
+            dsb->put(dsb, i * ostride, channel, ((sum0 + sum1) + (sum2 + sum3)) * dsb->firgain);
         }
     }
 
@@ -490,12 +490,23 @@ enum SCRIPT_JUSTIFY
     SCRIPT_JUSTIFY_ARABIC_SEEN_M
 };
 
+#define SHAPING_RESULTS_HASH_SIZE 64
+
 struct scriptshaping_cache
 {
     const struct shaping_font_ops *font;
     void *context;
     UINT16 upem;
 
+    /* Recently shaped runs, most recently used first. */
+    struct
+    {
+        CRITICAL_SECTION cs;
+        struct list buckets[SHAPING_RESULTS_HASH_SIZE];
+        struct list mru;
+        unsigned int count;
+    } results;
+
     struct ot_gsubgpos_table gsub;
     struct ot_gsubgpos_table gpos;
 
@@ -400,10 +400,12 @@ static HRESULT set_cached_glyph_metrics(struct dwrite_fontface *fontface, UINT16
     DWRITE_GLYPH_METRICS **block = &fontface->glyphs[glyph >> GLYPH_BLOCK_SHIFT];
 
     if (!*block) {
-        /* start new block */
-        *block = heap_alloc_zero(sizeof(*metrics) * GLYPH_BLOCK_SIZE);
-        if (!*block)
+        /* start new block, fontfaces may be shared between threads */
+        DWRITE_GLYPH_METRICS *new_block = heap_alloc_zero(sizeof(*metrics) * GLYPH_BLOCK_SIZE);
+        if (!new_block)
             return E_OUTOFMEMORY;
+        if (InterlockedCompareExchangePointer((void **)block, new_block, NULL))
+            heap_free(new_block);
     }
 
     memcpy(&(*block)[glyph & GLYPH_BLOCK_MASK], metrics, sizeof(*metrics));
@@ -238,6 +238,34 @@ struct layout_line
     DWRITE_LINE_METRICS1 metrics;
 };
 
+/* Script and bidi analysis results, kept per text range to be reused on relayout. */
+struct layout_itemized_run
+{
+    UINT32 position;
+    UINT32 length;
+    DWRITE_SCRIPT_ANALYSIS sa;
+    UINT8 bidi_level;
+};
+
+struct layout_itemized_range
+{
+    UINT32 position;
+    UINT32 length;
+    size_t first_run;
+    size_t run_count;
+};
+
+struct layout_itemization
+{
+    DWRITE_READING_DIRECTION readingdir;
+    struct layout_itemized_range *ranges;
+    size_t ranges_count;
+    size_t ranges_size;
+    struct layout_itemized_run *runs;
+    size_t runs_count;
+    size_t runs_size;
+};
+
 enum layout_recompute_mask {
     RECOMPUTE_CLUSTERS            = 1 << 0,
     RECOMPUTE_MINIMAL_WIDTH       = 1 << 1,
@@ -276,6 +304,7 @@ struct dwrite_textlayout
 
     DWRITE_LINE_BREAKPOINT *nominal_breakpoints;
     DWRITE_LINE_BREAKPOINT *actual_breakpoints;
+    struct layout_itemization itemization;
 
     struct layout_cluster *clusters;
     DWRITE_CLUSTER_METRICS *clustermetrics;
@@ -788,16 +817,97 @@ static void layout_get_font_height(FLOAT emsize, DWRITE_FONT_METRICS *fontmetric
     *height = SCALE_FONT_METRIC(fontmetrics->ascent + fontmetrics->descent + fontmetrics->lineGap, emsize, fontmetrics);
 }
 
+static void free_layout_itemization(struct layout_itemization *itemization)
+{
+    heap_free(itemization->ranges);
+    heap_free(itemization->runs);
+    memset(itemization, 0, sizeof(*itemization));
+}
+
+static HRESULT layout_itemize_range_cached(struct dwrite_textlayout *layout, const struct layout_itemization *itemization,
+        const struct layout_itemized_range *range)
+{
+    const struct layout_itemized_run *cached;
+    struct layout_run *r;
+    size_t i;
+    HRESULT hr;
+
+    for (i = 0; i < range->run_count; ++i)
+    {
+        cached = &itemization->runs[range->first_run + i];
+
+        if (FAILED(hr = alloc_layout_run(LAYOUT_RUN_REGULAR, cached->position, &r)))
+            return hr;
+
+        r->u.regular.descr.string = &layout->str[cached->position];
+        r->u.regular.descr.stringLength = cached->length;
+        r->u.regular.descr.textPosition = cached->position;
+        r->u.regular.sa = cached->sa;
+        r->u.regular.run.bidiLevel = cached->bidi_level;
+        list_add_tail(&layout->runs, &r->entry);
+    }
+
+    return S_OK;
+}
+
+static HRESULT layout_save_itemized_range(struct dwrite_textlayout *layout, struct list *first, UINT32 position,
+        UINT32 length)
+{
+    struct layout_itemization *itemization = &layout->itemization;
+    struct layout_itemized_range *range;
+    struct layout_itemized_run *cached;
+    struct layout_run *r;
+
+    if (!dwrite_array_reserve((void **)&itemization->ranges, &itemization->ranges_size, itemization->ranges_count + 1,
+            sizeof(*itemization->ranges)))
+        return E_OUTOFMEMORY;
+
+    range = &itemization->ranges[itemization->ranges_count++];
+    range->position = position;
+    range->length = length;
+    range->first_run = itemization->runs_count;
+    range->run_count = 0;
+
+    for (; first; first = list_next(&layout->runs, first))
+    {
+        r = LIST_ENTRY(first, struct layout_run, entry);
+
+        if (!dwrite_array_reserve((void **)&itemization->runs, &itemization->runs_size, itemization->runs_count + 1,
+                sizeof(*itemization->runs)))
+            return E_OUTOFMEMORY;
+
+        cached = &itemization->runs[itemization->runs_count++];
+        cached->position = r->u.regular.descr.textPosition;
+        cached->length = r->u.regular.descr.stringLength;
+        cached->sa = r->u.regular.sa;
+        cached->bidi_level = r->u.regular.run.bidiLevel;
+        range->run_count++;
+    }
+
+    return S_OK;
+}
+
 static HRESULT layout_itemize(struct dwrite_textlayout *layout)
 {
+    struct layout_itemization prev = layout->itemization;
     IDWriteTextAnalyzer2 *analyzer;
     struct layout_range *range;
     struct layout_run *r;
+    size_t prev_index = 0;
     HRESULT hr = S_OK;
 
     analyzer = get_text_analyzer();
 
+    /* Analysis results only depend on the text, range boundaries and paragraph direction. */
+    memset(&layout->itemization, 0, sizeof(layout->itemization));
+    layout->itemization.readingdir = layout->format.readingdir;
+    if (prev.readingdir != layout->format.readingdir)
+        prev.ranges_count = 0;
+
     LIST_FOR_EACH_ENTRY(range, &layout->ranges, struct layout_range, h.entry) {
+        UINT32 position = range->h.range.startPosition, length;
+        struct list *last;
+
         /* We don't care about ranges that don't contain any text. */
         if (range->h.range.startPosition >= layout->len)
             break;
@@ -817,21 +927,42 @@ static HRESULT layout_itemize(struct dwrite_textlayout *layout)
             continue;
         }
 
-        /* Initial splitting by script. */
-        hr = IDWriteTextAnalyzer2_AnalyzeScript(analyzer, (IDWriteTextAnalysisSource *)&layout->IDWriteTextAnalysisSource1_iface,
-                range->h.range.startPosition, get_clipped_range_length(layout, range),
-                (IDWriteTextAnalysisSink *)&layout->IDWriteTextAnalysisSink1_iface);
-        if (FAILED(hr))
-            break;
+        length = get_clipped_range_length(layout, range);
+        last = list_tail(&layout->runs);
 
-        /* Splitting further by bidi levels. */
-        hr = IDWriteTextAnalyzer2_AnalyzeBidi(analyzer, (IDWriteTextAnalysisSource *)&layout->IDWriteTextAnalysisSource1_iface,
-                range->h.range.startPosition, get_clipped_range_length(layout, range),
-                (IDWriteTextAnalysisSink *)&layout->IDWriteTextAnalysisSink1_iface);
-        if (FAILED(hr))
+        while (prev_index < prev.ranges_count && prev.ranges[prev_index].position < position)
+            prev_index++;
+
+        if (prev_index < prev.ranges_count && prev.ranges[prev_index].position == position &&
+                prev.ranges[prev_index].length == length)
+        {
+            if (FAILED(hr = layout_itemize_range_cached(layout, &prev, &prev.ranges[prev_index])))
+                break;
+        }
+        else
+        {
+            /* Initial splitting by script. */
+            hr = IDWriteTextAnalyzer2_AnalyzeScript(analyzer, (IDWriteTextAnalysisSource *)&layout->IDWriteTextAnalysisSource1_iface,
+                    position, length, (IDWriteTextAnalysisSink *)&layout->IDWriteTextAnalysisSink1_iface);
+            if (FAILED(hr))
+                break;
+
+            /* Splitting further by bidi levels. */
+            hr = IDWriteTextAnalyzer2_AnalyzeBidi(analyzer, (IDWriteTextAnalysisSource *)&layout->IDWriteTextAnalysisSource1_iface,
+                    position, length, (IDWriteTextAnalysisSink *)&layout->IDWriteTextAnalysisSink1_iface);
+            if (FAILED(hr))
+                break;
+        }
+
+        if (FAILED(hr = layout_save_itemized_range(layout, last ? list_next(&layout->runs, last) : list_head(&layout->runs),
+                position, length)))
             break;
     }
 
+    if (FAILED(hr))
+        free_layout_itemization(&layout->itemization);
+    free_layout_itemization(&prev);
+
     return hr;
 }
 
@@ -2797,6 +2928,20 @@ static inline HRESULT return_range(const struct layout_range_header *h, DWRITE_T
 }
 
 /* Sets attribute value for given range, does all needed splitting/merging of existing ranges. */
+static USHORT get_layout_range_attr_recompute(enum layout_range_attr_kind attr)
+{
+    switch (attr)
+    {
+    /* These only split final runs, clusters are not affected. */
+    case LAYOUT_RANGE_ATTR_UNDERLINE:
+    case LAYOUT_RANGE_ATTR_STRIKETHROUGH:
+    case LAYOUT_RANGE_ATTR_EFFECT:
+        return RECOMPUTE_LINES_AND_OVERHANGS;
+    default:
+        return RECOMPUTE_EVERYTHING;
+    }
+}
+
 static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layout_range_attr_kind attr, struct layout_range_attr_value *value)
 {
     struct layout_range_header *cur, *right, *left, *outer;
@@ -2903,7 +3048,7 @@ static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layo
         list_add_after(&outer->entry, &cur->entry);
         list_add_after(&cur->entry, &right->entry);
 
-        layout->recompute = RECOMPUTE_EVERYTHING;
+        layout->recompute |= get_layout_range_attr_recompute(attr);
         return S_OK;
     }
 
@@ -2943,7 +3088,7 @@ done:
     if (changed) {
         struct list *next, *i;
 
-        layout->recompute = RECOMPUTE_EVERYTHING;
+        layout->recompute |= get_layout_range_attr_recompute(attr);
         i = list_head(ranges);
         while ((next = list_next(ranges, i))) {
             struct layout_range_header *next_range = LIST_ENTRY(next, struct layout_range_header, entry);
@@ -3081,6 +3226,7 @@ static ULONG WINAPI dwritetextlayout_Release(IDWriteTextLayout4 *iface)
         release_format_data(&layout->format);
         heap_free(layout->nominal_breakpoints);
         heap_free(layout->actual_breakpoints);
+        free_layout_itemization(&layout->itemization);
         heap_free(layout->clustermetrics);
         heap_free(layout->clusters);
         heap_free(layout->lines);
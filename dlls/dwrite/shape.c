@@ -40,9 +40,29 @@ WINE_DEFAULT_DEBUG_CHANNEL(dwrite);
 #define GET_BE_DWORD(x) RtlUlongByteSwap(x)
 #endif
 
+/* Shaping results are cached per font, for runs up to this length. */
+#define SHAPING_RESULTS_MAX_LENGTH 256
+#define SHAPING_RESULTS_MAX_COUNT 512
+
+struct shaping_result
+{
+    struct list entry;
+    struct list mru;
+    unsigned int hash;
+    unsigned int key_size;
+    unsigned int length;
+    unsigned int glyph_count;
+    DWRITE_SHAPING_TEXT_PROPERTIES *text_props;
+    DWRITE_SHAPING_GLYPH_PROPERTIES *glyph_props;
+    UINT16 *clustermap;
+    UINT16 *glyphs;
+    DWORD key[1];
+};
+
 struct scriptshaping_cache *create_scriptshaping_cache(void *context, const struct shaping_font_ops *font_ops)
 {
     struct scriptshaping_cache *cache;
+    unsigned int i;
 
     cache = heap_alloc_zero(sizeof(*cache));
     if (!cache)
@@ -51,6 +71,11 @@ struct scriptshaping_cache *create_scriptshaping_cache(void *context, const stru
     cache->font = font_ops;
     cache->context = context;
 
+    InitializeCriticalSection(&cache->results.cs);
+    for (i = 0; i < ARRAY_SIZE(cache->results.buckets); ++i)
+        list_init(&cache->results.buckets[i]);
+    list_init(&cache->results.mru);
+
     opentype_layout_scriptshaping_cache_init(cache);
     cache->upem = cache->font->get_font_upem(cache->context);
 
@@ -59,9 +84,15 @@ struct scriptshaping_cache *create_scriptshaping_cache(void *context, const stru
 
 void release_scriptshaping_cache(struct scriptshaping_cache *cache)
 {
+    struct shaping_result *result, *next;
+
     if (!cache)
         return;
 
+    LIST_FOR_EACH_ENTRY_SAFE(result, next, &cache->results.mru, struct shaping_result, mru)
+        heap_free(result);
+    DeleteCriticalSection(&cache->results.cs);
+
     cache->font->release_font_table(cache->context, cache->gdef.table.context);
     cache->font->release_font_table(cache->context, cache->gsub.table.context);
     cache->font->release_font_table(cache->context, cache->gpos.table.context);
@@ -291,7 +322,7 @@ static unsigned int shape_get_script_lang_index(struct scriptshaping_context *co
     return 0;
 }
 
-HRESULT shape_get_glyphs(struct scriptshaping_context *context, const unsigned int *scripts)
+static HRESULT shape_get_glyphs_uncached(struct scriptshaping_context *context, const unsigned int *scripts)
 {
     static const unsigned int common_features[] =
     {
@@ -352,6 +383,167 @@ HRESULT shape_get_glyphs(struct scriptshaping_context *context, const unsigned i
     return (context->glyph_count <= context->u.subst.max_glyph_count) ? S_OK : E_NOT_SUFFICIENT_BUFFER;
 }
 
+/* Key covers everything shaping output depends on, except the font itself. */
+static DWORD *shape_get_results_key(const struct scriptshaping_context *context, unsigned int *size,
+        unsigned int *hash)
+{
+    unsigned int i, j, count, pos = 0;
+    WCHAR *digits;
+    DWORD *key;
+
+    if (context->length > SHAPING_RESULTS_MAX_LENGTH)
+        return NULL;
+
+    count = 10 + (context->length + 1) / 2;
+    for (i = 0; i < context->user_features.range_count; ++i)
+        count += 2 + 2 * context->user_features.features[i]->featureCount;
+
+    if (!(key = heap_calloc(count, sizeof(*key))))
+        return NULL;
+
+    key[pos++] = context->length;
+    key[pos++] = context->script;
+    key[pos++] = context->language_tag;
+    key[pos++] = context->is_rtl | (context->is_sideways << 1);
+    key[pos++] = context->user_features.range_count;
+    digits = (WCHAR *)&key[pos];
+    for (i = 0; i < 10 && context->u.subst.digits && context->u.subst.digits[i]; ++i)
+        digits[i] = context->u.subst.digits[i];
+    pos += 5;
+    for (i = 0; i < context->user_features.range_count; ++i)
+    {
+        const DWRITE_TYPOGRAPHIC_FEATURES *features = context->user_features.features[i];
+
+        key[pos++] = context->user_features.range_lengths[i];
+        key[pos++] = features->featureCount;
+        for (j = 0; j < features->featureCount; ++j)
+        {
+            key[pos++] = features->features[j].nameTag;
+            key[pos++] = features->features[j].parameter;
+        }
+    }
+    memcpy(&key[pos], context->text, context->length * sizeof(WCHAR));
+
+    /* FNV-1a */
+    *hash = 2166136261u;
+    for (i = 0; i < count; ++i)
+        *hash = (*hash ^ key[i]) * 16777619u;
+    *size = count;
+
+    return key;
+}
+
+static struct shaping_result *shape_find_result(struct scriptshaping_cache *cache, const DWORD *key,
+        unsigned int size, unsigned int hash)
+{
+    struct shaping_result *result;
+
+    LIST_FOR_EACH_ENTRY(result, &cache->results.buckets[hash % SHAPING_RESULTS_HASH_SIZE], struct shaping_result, entry)
+    {
+        if (result->hash == hash && result->key_size == size && !memcmp(result->key, key, size * sizeof(*key)))
+            return result;
+    }
+
+    return NULL;
+}
+
+static void shape_add_result(struct scriptshaping_context *context, const DWORD *key, unsigned int size,
+        unsigned int hash)
+{
+    struct scriptshaping_cache *cache = context->cache;
+    struct shaping_result *result;
+    SIZE_T alloc_size;
+    char *ptr;
+
+    alloc_size = FIELD_OFFSET(struct shaping_result, key[size]) +
+            context->length * (sizeof(*result->text_props) + sizeof(*result->clustermap)) +
+            context->glyph_count * (sizeof(*result->glyph_props) + sizeof(*result->glyphs));
+    if (!(result = heap_alloc(alloc_size)))
+        return;
+
+    result->hash = hash;
+    result->key_size = size;
+    result->length = context->length;
+    result->glyph_count = context->glyph_count;
+    memcpy(result->key, key, size * sizeof(*key));
+
+    ptr = (char *)&result->key[size];
+    result->text_props = (DWRITE_SHAPING_TEXT_PROPERTIES *)ptr;
+    ptr += context->length * sizeof(*result->text_props);
+    result->glyph_props = (DWRITE_SHAPING_GLYPH_PROPERTIES *)ptr;
+    ptr += context->glyph_count * sizeof(*result->glyph_props);
+    result->clustermap = (UINT16 *)ptr;
+    ptr += context->length * sizeof(*result->clustermap);
+    result->glyphs = (UINT16 *)ptr;
+
+    memcpy(result->text_props, context->u.subst.text_props, context->length * sizeof(*result->text_props));
+    memcpy(result->glyph_props, context->u.subst.glyph_props, context->glyph_count * sizeof(*result->glyph_props));
+    memcpy(result->clustermap, context->u.subst.clustermap, context->length * sizeof(*result->clustermap));
+    memcpy(result->glyphs, context->u.subst.glyphs, context->glyph_count * sizeof(*result->glyphs));
+
+    EnterCriticalSection(&cache->results.cs);
+    if (shape_find_result(cache, key, size, hash))
+    {
+        LeaveCriticalSection(&cache->results.cs);
+        heap_free(result);
+        return;
+    }
+    if (cache->results.count == SHAPING_RESULTS_MAX_COUNT)
+    {
+        struct shaping_result *oldest = LIST_ENTRY(list_tail(&cache->results.mru), struct shaping_result, mru);
+
+        list_remove(&oldest->entry);
+        list_remove(&oldest->mru);
+        heap_free(oldest);
+        cache->results.count--;
+    }
+    list_add_head(&cache->results.buckets[hash % SHAPING_RESULTS_HASH_SIZE], &result->entry);
+    list_add_head(&cache->results.mru, &result->mru);
+    cache->results.count++;
+    LeaveCriticalSection(&cache->results.cs);
+}
+
+HRESULT shape_get_glyphs(struct scriptshaping_context *context, const unsigned int *scripts)
+{
+    struct scriptshaping_cache *cache = context->cache;
+    struct shaping_result *result;
+    unsigned int size, hash;
+    HRESULT hr;
+    DWORD *key;
+
+    if (!(key = shape_get_results_key(context, &size, &hash)))
+        return shape_get_glyphs_uncached(context, scripts);
+
+    EnterCriticalSection(&cache->results.cs);
+    if ((result = shape_find_result(cache, key, size, hash)))
+    {
+        list_remove(&result->mru);
+        list_add_head(&cache->results.mru, &result->mru);
+
+        context->glyph_count = result->glyph_count;
+        if (result->glyph_count <= context->u.subst.max_glyph_count)
+        {
+            memcpy(context->u.subst.text_props, result->text_props, result->length * sizeof(*result->text_props));
+            memcpy(context->u.subst.glyph_props, result->glyph_props, result->glyph_count * sizeof(*result->glyph_props));
+            memcpy(context->u.subst.clustermap, result->clustermap, result->length * sizeof(*result->clustermap));
+            memcpy(context->u.subst.glyphs, result->glyphs, result->glyph_count * sizeof(*result->glyphs));
+            hr = S_OK;
+        }
+        else
+            hr = E_NOT_SUFFICIENT_BUFFER;
+        LeaveCriticalSection(&cache->results.cs);
+        heap_free(key);
+        return hr;
+    }
+    LeaveCriticalSection(&cache->results.cs);
+
+    if ((hr = shape_get_glyphs_uncached(context, scripts)) == S_OK)
+        shape_add_result(context, key, size, hash);
+
+    heap_free(key);
+    return hr;
+}
+
 static int tag_array_sorting_compare(const void *a, const void *b)
 {
     unsigned int left = GET_BE_DWORD(*(unsigned int *)a), right = GET_BE_DWORD(*(unsigned int *)b);
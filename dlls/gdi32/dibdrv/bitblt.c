@@ -581,19 +581,137 @@ static void mask_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
+/* rectangles with at least that many pixels are processed in row bands by several threads */
+#define BAND_MIN_PIXELS  (1024 * 1024)
+#define BAND_MIN_ROWS    64
+#define BAND_MAX_COUNT   16
+
+struct band_work
+{
+    LONG        refcount;
+    LONG        next;       /* index of the next band to process */
+    LONG        remaining;  /* number of bands not processed yet */
+    LONG        failed;
+    int         count;
+    int         height;
+    RECT        rect;
+    BOOL      (*func)( const RECT *band, void *arg );
+    void       *arg;
+};
+
+static void release_band_work( struct band_work *work )
+{
+    if (!InterlockedDecrement( &work->refcount )) HeapFree( GetProcessHeap(), 0, work );
+}
+
+static void process_bands( struct band_work *work )
+{
+    RECT band;
+    LONG i;
+
+    while ((i = InterlockedIncrement( &work->next ) - 1) < work->count)
+    {
+        band = work->rect;
+        band.top = work->rect.top + i * work->height;
+        band.bottom = min( band.top + work->height, work->rect.bottom );
+        if (!work->func( &band, work->arg )) InterlockedExchange( &work->failed, TRUE );
+        if (!InterlockedDecrement( &work->remaining )) RtlWakeAddressAll( &work->remaining );
+    }
+}
+
+static void CALLBACK band_work_callback( TP_CALLBACK_INSTANCE *instance, void *arg )
+{
+    struct band_work *work = arg;
+
+    process_bands( work );
+    release_band_work( work );
+}
+
+/***********************************************************************
+ *           process_rect_in_bands
+ *
+ * Call func for row bands covering rect, spreading large rectangles over the
+ * thread pool. The bands don't overlap, so the result doesn't depend on the
+ * order in which they are processed.
+ */
+static BOOL process_rect_in_bands( const RECT *rect, BOOL (*func)( const RECT *band, void *arg ), void *arg )
+{
+    int width = rect->right - rect->left, height = rect->bottom - rect->top;
+    int i, count = min( NtCurrentTeb()->Peb->NumberOfProcessors, BAND_MAX_COUNT );
+    struct band_work *work;
+    LONG remaining;
+    BOOL ret;
+
+    count = min( count, height / BAND_MIN_ROWS );
+    if (count <= 1 || (LONGLONG)width * height < BAND_MIN_PIXELS ||
+        !(work = HeapAlloc( GetProcessHeap(), 0, sizeof(*work) )))
+        return func( rect, arg );
+
+    work->height    = (height + count - 1) / count;
+    work->count     = (height + work->height - 1) / work->height;
+    work->refcount  = 1;
+    work->next      = 0;
+    work->remaining = work->count;
+    work->failed    = FALSE;
+    work->rect      = *rect;
+    work->func      = func;
+    work->arg       = arg;
+
+    /* the calling thread processes bands too, helpers that show up late will find nothing left to do */
+    for (i = 1; i < work->count; i++)
+    {
+        InterlockedIncrement( &work->refcount );
+        if (TpSimpleTryPost( band_work_callback, work, NULL ))
+        {
+            InterlockedDecrement( &work->refcount );
+            break;
+        }
+    }
+
+    process_bands( work );
+    while ((remaining = work->remaining)) RtlWaitOnAddress( &work->remaining, &remaining, sizeof(remaining), NULL );
+    ret = !work->failed;
+    release_band_work( work );
+    return ret;
+}
+
+struct blend_band_params
+{
+    dib_info     *dst;
+    const dib_info *src;
+    POINT         origin;
+    const RECT   *rect;
+    BLENDFUNCTION blend;
+};
+
+static BOOL blend_band( const RECT *band, void *arg )
+{
+    const struct blend_band_params *params = arg;
+    POINT origin;
+
+    origin.x = params->origin.x;
+    origin.y = params->origin.y + band->top - params->rect->top;
+    params->dst->funcs->blend_rect( params->dst, band, params->src, &origin, params->blend );
+    return TRUE;
+}
+
 static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                          HRGN clip, BLENDFUNCTION blend )
 {
-    POINT origin;
+    struct blend_band_params params;
     struct clipped_rects clipped_rects;
     int i;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
+    params.dst = dst;
+    params.src = src;
+    params.blend = blend;
     for (i = 0; i < clipped_rects.count; i++)
     {
-        origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
-        origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
-        dst->funcs->blend_rect( dst, &clipped_rects.rects[i], src, &origin, blend );
+        params.origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
+        params.origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
+        params.rect = &clipped_rects.rects[i];
+        process_rect_in_bands( &clipped_rects.rects[i], blend_band, &params );
     }
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -678,16 +796,34 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
+struct gradient_band_params
+{
+    dib_info       *dib;
+    const TRIVERTEX *v;
+    int             mode;
+};
+
+static BOOL gradient_band( const RECT *band, void *arg )
+{
+    const struct gradient_band_params *params = arg;
+
+    return params->dib->funcs->gradient_rect( params->dib, band, params->v, params->mode );
+}
+
 static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
 {
     int i;
     struct clipped_rects clipped_rects;
+    struct gradient_band_params params;
     BOOL ret = TRUE;
 
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
+    params.dib  = dib;
+    params.v    = v;
+    params.mode = mode;
     for (i = 0; i < clipped_rects.count; i++)
     {
-        if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
+        if (!(ret = process_rect_in_bands( &clipped_rects.rects[i], gradient_band, &params ))) break;
     }
     free_clipped_rects( &clipped_rects );
     return ret;
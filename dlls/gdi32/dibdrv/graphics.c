@@ -42,10 +42,16 @@ enum glyph_type
 #define GLYPH_CACHE_PAGE_SIZE  0x100
 #define GLYPH_CACHE_PAGES      (0x10000 / GLYPH_CACHE_PAGE_SIZE)
 
+/* unused fonts are kept until there are too many, or their glyphs use too much memory */
+#define FONT_CACHE_MIN_UNUSED  5
+#define FONT_CACHE_MAX_UNUSED  64
+#define FONT_CACHE_MAX_SIZE    (16 * 1024 * 1024)
+
 struct cached_font
 {
     struct list           entry;
     LONG                  ref;
+    LONG                  size;     /* memory used by the cached glyphs */
     DWORD                 hash;
     LOGFONTW              lf;
     XFORM                 xform;
@@ -54,6 +60,7 @@ struct cached_font
 };
 
 static struct list font_cache = LIST_INIT( font_cache );
+static LONG font_cache_size;  /* memory used by the glyphs of all cached fonts */
 
 static CRITICAL_SECTION font_cache_cs;
 static CRITICAL_SECTION_DEBUG critsect_debug =
@@ -587,7 +594,8 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
         }
     }
 
-    if (i > 5)  /* keep at least 5 of the most-recently used fonts around */
+    /* keep at least a few of the most-recently used fonts around */
+    if (i > FONT_CACHE_MAX_UNUSED || (i > FONT_CACHE_MIN_UNUSED && font_cache_size > FONT_CACHE_MAX_SIZE))
     {
         ptr = last_unused;
         for (i = 0; i < GLYPH_NBTYPES; i++)
@@ -600,6 +608,7 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
                 HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j] );
             }
         }
+        InterlockedExchangeAdd( &font_cache_size, -ptr->size );
         list_remove( &ptr->entry );
     }
     else if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
@@ -610,6 +619,7 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 
     *ptr = font;
     ptr->ref = 1;
+    ptr->size = 0;
     memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
 done:
     list_add_head( &font_cache, &ptr->entry );
@@ -624,7 +634,7 @@ void release_cached_font( struct cached_font *font )
 }
 
 static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT index, UINT flags,
-                                              struct cached_glyph *glyph )
+                                              struct cached_glyph *glyph, UINT size )
 {
     struct cached_glyph *ret;
     enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
@@ -643,9 +653,19 @@ static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT ind
         }
         if (InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page], ptr, NULL ))
             HeapFree( GetProcessHeap(), 0, ptr );
+        else
+        {
+            InterlockedExchangeAdd( &font->size, GLYPH_CACHE_PAGE_SIZE * sizeof(*ptr) );
+            InterlockedExchangeAdd( &font_cache_size, GLYPH_CACHE_PAGE_SIZE * sizeof(*ptr) );
+        }
     }
     ret = InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page][entry], glyph, NULL );
-    if (!ret) ret = glyph;
+    if (!ret)
+    {
+        InterlockedExchangeAdd( &font->size, size );
+        InterlockedExchangeAdd( &font_cache_size, size );
+        ret = glyph;
+    }
     else HeapFree( GetProcessHeap(), 0, glyph );
     return ret;
 }
@@ -804,7 +824,7 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
 
 done:
     glyph->metrics = metrics;
-    return add_cached_glyph( font, index, flags, glyph );
+    return add_cached_glyph( font, index, flags, glyph, FIELD_OFFSET( struct cached_glyph, bits[size] ));
 }
 
 static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT x, INT y,
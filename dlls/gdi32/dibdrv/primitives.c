@@ -4593,44 +4593,52 @@ static inline BYTE blend_color(BYTE dst, BYTE src, DWORD alpha)
     return (src * alpha + dst * (255 - alpha) + 127) / 255;
 }
 
+/* The 32-bpp blending functions below process two channels at a time, held in the
+ * 0x00ff00ff lanes of a DWORD. Each lane stays below 0x10000 so nothing carries into
+ * the other one, and the results are identical to blending each channel separately. */
+
+/* (x + 127) / 255 in both lanes, for lane values up to 255 * 255 */
+static inline DWORD div255_round_pairs( DWORD x )
+{
+    x += 0x007f007f;
+    return ((x + 0x00010001 + ((x >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+static inline DWORD blend_color_pairs( DWORD dst, DWORD src, DWORD alpha )
+{
+    return div255_round_pairs( src * alpha + dst * (255 - alpha) );
+}
+
 static inline DWORD blend_argb_constant_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, src >> 24, alpha ) << 24);
+    return (blend_color_pairs( dst & 0x00ff00ff, src & 0x00ff00ff, alpha ) |
+            blend_color_pairs( (dst >> 8) & 0x00ff00ff, (src >> 8) & 0x00ff00ff, alpha ) << 8);
 }
 
 static inline DWORD blend_argb_no_src_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, 255, alpha ) << 24);
+    return blend_argb_constant_alpha( dst, src | 0xff000000, alpha );
+}
+
+/* add premultiplied src channel pairs to dst scaled by 255 - alpha; an overflowing
+ * channel sets the low bit of the next one, same as when or-ing per channel results */
+static inline DWORD blend_premultiplied_pairs( DWORD dst, DWORD src_rb, DWORD src_ag, DWORD alpha )
+{
+    DWORD rb = src_rb + div255_round_pairs( (dst & 0x00ff00ff) * (255 - alpha) );
+    DWORD ag = src_ag + div255_round_pairs( ((dst >> 8) & 0x00ff00ff) * (255 - alpha) );
+    return rb | ag << 8;
 }
 
 static inline DWORD blend_argb( DWORD dst, DWORD src )
 {
-    BYTE b = (BYTE)src;
-    BYTE g = (BYTE)(src >> 8);
-    BYTE r = (BYTE)(src >> 16);
-    DWORD alpha  = (BYTE)(src >> 24);
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    return blend_premultiplied_pairs( dst, src & 0x00ff00ff, (src >> 8) & 0x00ff00ff, src >> 24 );
 }
 
 static inline DWORD blend_argb_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    BYTE b = ((BYTE)src         * alpha + 127) / 255;
-    BYTE g = ((BYTE)(src >> 8)  * alpha + 127) / 255;
-    BYTE r = ((BYTE)(src >> 16) * alpha + 127) / 255;
-    alpha  = ((BYTE)(src >> 24) * alpha + 127) / 255;
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    DWORD rb = div255_round_pairs( (src & 0x00ff00ff) * alpha );
+    DWORD ag = div255_round_pairs( ((src >> 8) & 0x00ff00ff) * alpha );
+    return blend_premultiplied_pairs( dst, rb, ag, ag >> 16 );
 }
 
 static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BLENDFUNCTION blend )
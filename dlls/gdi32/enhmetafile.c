@@ -2287,14 +2287,107 @@ BOOL WINAPI PlayEnhMetaFileRecord(
       FIXME("type %d is unimplemented\n", type);
       break;
     }
-  tmprc.left = tmprc.top = 0;
-  tmprc.right = tmprc.bottom = 1000;
-  LPtoDP(hdc, (POINT*)&tmprc, 2);
-  TRACE("L:0,0 - 1000,1000 -> D:%s\n", wine_dbgstr_rect(&tmprc));
+  if (TRACE_ON(enhmetafile))
+  {
+    tmprc.left = tmprc.top = 0;
+    tmprc.right = tmprc.bottom = 1000;
+    LPtoDP(hdc, (POINT*)&tmprc, 2);
+    TRACE("L:0,0 - 1000,1000 -> D:%s\n", wine_dbgstr_rect(&tmprc));
+  }
 
   return TRUE;
 }
 
+/* returns the number of points of a polyline record, or 0 if it can't be batched */
+static DWORD get_polyline_record_points( const ENHMETARECORD *emr, DWORD size )
+{
+    DWORD count;
+
+    switch (emr->iType)
+    {
+    case EMR_POLYLINE:
+        if (size < FIELD_OFFSET(EMRPOLYLINE, aptl)) return 0;
+        count = ((const EMRPOLYLINE *)emr)->cptl;
+        if (count > (size - FIELD_OFFSET(EMRPOLYLINE, aptl)) / sizeof(POINTL)) return 0;
+        break;
+    case EMR_POLYLINE16:
+        if (size < FIELD_OFFSET(EMRPOLYLINE16, apts)) return 0;
+        count = ((const EMRPOLYLINE16 *)emr)->cpts;
+        if (count > (size - FIELD_OFFSET(EMRPOLYLINE16, apts)) / sizeof(POINTS)) return 0;
+        break;
+    default:
+        return 0;
+    }
+    return count >= 2 ? count : 0;
+}
+
+/******************************************************************
+ *         EMF_PlayPolylines
+ *
+ * Play a run of consecutive polyline records with a single PolyPolyline
+ * call, which saves the per call DC and driver overhead when replaying
+ * large metafiles. Returns the offset of the first record that was not
+ * played, or 0 if there is nothing worth batching.
+ */
+static DWORD EMF_PlayPolylines( HDC hdc, const ENHMETAHEADER *emh, DWORD offset )
+{
+    const ENHMETARECORD *emr;
+    DWORD end, total = 0, polylines = 0, count, pos, i, j;
+    DWORD *counts;
+    POINT *pts;
+
+    /* recording DCs must see the original records */
+    if (GetObjectType( hdc ) != OBJ_DC && GetObjectType( hdc ) != OBJ_MEMDC) return 0;
+    /* overlapping wide lines would only be drawn once with PolyPolyline */
+    if (GetROP2( hdc ) != R2_COPYPEN) return 0;
+
+    for (end = offset; end + 8 <= emh->nBytes; end += emr->nSize)
+    {
+        emr = (const ENHMETARECORD *)((const char *)emh + end);
+        if (end + emr->nSize < end || end + emr->nSize > emh->nBytes) break;
+        if (!(count = get_polyline_record_points( emr, emr->nSize ))) break;
+        if (total + count < total) break;
+        total += count;
+        polylines++;
+    }
+    if (polylines < 2) return 0;
+
+    if (!(counts = HeapAlloc( GetProcessHeap(), 0, polylines * sizeof(*counts) + total * sizeof(*pts) )))
+        return 0;
+    pts = (POINT *)(counts + polylines);
+
+    for (i = pos = 0; i < polylines; i++, offset += emr->nSize)
+    {
+        emr = (const ENHMETARECORD *)((const char *)emh + offset);
+        if (emr->iType == EMR_POLYLINE)
+        {
+            const EMRPOLYLINE *poly = (const EMRPOLYLINE *)emr;
+            counts[i] = poly->cptl;
+            memcpy( pts + pos, poly->aptl, poly->cptl * sizeof(*pts) );
+        }
+        else
+        {
+            const EMRPOLYLINE16 *poly = (const EMRPOLYLINE16 *)emr;
+            counts[i] = poly->cpts;
+            for (j = 0; j < poly->cpts; j++)
+            {
+                pts[pos + j].x = poly->apts[j].x;
+                pts[pos + j].y = poly->apts[j].y;
+            }
+        }
+        pos += counts[i];
+    }
+
+    TRACE("playing %u polylines with %u points\n", polylines, total);
+    PolyPolyline( hdc, pts, counts, polylines );
+    HeapFree( GetProcessHeap(), 0, counts );
+    return end;
+}
+
+static INT CALLBACK EMF_PlayEnhMetaFileCallback(HDC hdc, HANDLETABLE *ht,
+						const ENHMETARECORD *emr,
+						INT handles, LPARAM data);
+
 
 /*****************************************************************************
  *
@@ -2508,6 +2601,18 @@ BOOL WINAPI EnumEnhMetaFile(
         if (hdc && IS_WIN9X() && emr_produces_output(emr->iType))
             EMF_Update_MF_Xform(hdc, info);
 
+        /* PlayEnhMetaFile doesn't need to see individual records */
+        if (hdc && callback == EMF_PlayEnhMetaFileCallback &&
+            (emr->iType == EMR_POLYLINE || emr->iType == EMR_POLYLINE16))
+        {
+            DWORD next = EMF_PlayPolylines(hdc, emh, offset);
+            if (next)
+            {
+                offset = next;
+                continue;
+            }
+        }
+
 	TRACE("Calling EnumFunc with record %s, size %d\n", get_emr_name(emr->iType), emr->nSize);
 	ret = (*callback)(hdc, ht, emr, emh->nHandles, (LPARAM)data);
 	offset += emr->nSize;
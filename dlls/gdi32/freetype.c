@@ -108,6 +108,7 @@
 #include "gdi_private.h"
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/rbtree.h"
 
 #include "resource.h"
 
@@ -1317,16 +1318,328 @@ static void unix_face_destroy( struct unix_face *This )
     RtlFreeHeap( GetProcessHeap(), 0, This );
 }
 
+/* persistent cache of the names and properties of the system font files, so that
+ * processes don't have to open and parse every font file again on startup */
+
+#define FONT_META_CACHE_MAGIC   0x434e4657  /* WFNC */
+#define FONT_META_CACHE_VERSION 1
+
+struct font_meta_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD lcid;
+    DWORD count;
+};
+
+struct font_meta_entry
+{
+    DWORD         size;         /* total size of the entry, names included */
+    DWORD         face_index;
+    ULONGLONG     file_size;
+    LONGLONG      file_mtime;
+    DWORD         num_faces;
+    DWORD         ntm_flags;
+    DWORD         font_version;
+    FONTSIGNATURE fs;
+    WORD          name_len[4];  /* family, second, style and full name lengths, 0 if missing */
+    /* followed by the null-terminated names and unix file name */
+};
+
+struct font_meta
+{
+    struct wine_rb_entry           entry;
+    const char                    *unix_name;
+    const struct font_meta_entry  *data;
+    BOOL                           used;
+};
+
+struct font_meta_key
+{
+    const char *unix_name;
+    DWORD       face_index;
+};
+
+static int font_meta_compare( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct font_meta *meta = WINE_RB_ENTRY_VALUE( entry, const struct font_meta, entry );
+    const struct font_meta_key *k = key;
+    int ret;
+
+    if ((ret = strcmp( k->unix_name, meta->unix_name ))) return ret;
+    if (k->face_index != meta->data->face_index) return k->face_index < meta->data->face_index ? -1 : 1;
+    return 0;
+}
+
+static struct wine_rb_tree font_meta_tree = { font_meta_compare };
+static struct font_meta *font_meta_array;
+static char *font_meta_input;
+static char *font_meta_output;
+static SIZE_T font_meta_output_size, font_meta_output_alloc;
+static DWORD font_meta_loaded, font_meta_used, font_meta_count;
+static BOOL font_meta_enabled;
+
+static char *get_font_meta_cache_name(void)
+{
+    static const char suffix[] = "/wine/font-metadata.cache";
+    const char *dir, *sub = "";
+    char *name;
+
+    if (!(dir = getenv( "XDG_CACHE_HOME" )) || dir[0] != '/')
+    {
+        if (!(dir = getenv( "HOME" ))) return NULL;
+        sub = "/.cache";
+    }
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, strlen( dir ) + strlen( sub ) + sizeof(suffix) )))
+        return NULL;
+    strcpy( name, dir );
+    strcat( name, sub );
+    strcat( name, suffix );
+    return name;
+}
+
+static void font_meta_cache_load(void)
+{
+    const struct font_meta_header *header;
+    const struct font_meta_entry *data;
+    struct font_meta_key key;
+    struct stat st;
+    char *name, *ptr, *end;
+    DWORD i, j;
+    int fd;
+
+    font_meta_enabled = TRUE;
+    if (!(name = get_font_meta_cache_name())) return;
+    fd = open( name, O_RDONLY );
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+    if (fd == -1) return;
+
+    if (fstat( fd, &st ) == -1 || st.st_size < sizeof(*header) || st.st_size > 64 * 1024 * 1024) goto done;
+    if (!(font_meta_input = RtlAllocateHeap( GetProcessHeap(), 0, st.st_size ))) goto done;
+    if (read( fd, font_meta_input, st.st_size ) != st.st_size) goto done;
+
+    header = (const struct font_meta_header *)font_meta_input;
+    if (header->magic != FONT_META_CACHE_MAGIC || header->version != FONT_META_CACHE_VERSION ||
+        header->lcid != system_lcid || header->count > st.st_size / sizeof(*data))
+        goto done;
+    if (!(font_meta_array = RtlAllocateHeap( GetProcessHeap(), 0, header->count * sizeof(*font_meta_array) )))
+        goto done;
+
+    ptr = font_meta_input + sizeof(*header);
+    end = font_meta_input + st.st_size;
+    for (i = 0; i < header->count; i++)
+    {
+        struct font_meta *meta = &font_meta_array[font_meta_loaded];
+        SIZE_T names_size = 0;
+
+        data = (const struct font_meta_entry *)ptr;
+        if (end - ptr < sizeof(*data) || data->size < sizeof(*data) || data->size > end - ptr ||
+            data->size % sizeof(ULONGLONG))
+            break;
+        for (j = 0; j < ARRAY_SIZE(data->name_len); j++) names_size += data->name_len[j] * sizeof(WCHAR);
+        meta->data = data;
+        meta->used = FALSE;
+        meta->unix_name = (const char *)(data + 1) + names_size;
+        if (names_size >= data->size - sizeof(*data) || !memchr( meta->unix_name, 0, ptr + data->size - meta->unix_name ))
+            break;
+        ptr += data->size;
+
+        key.unix_name = meta->unix_name;
+        key.face_index = data->face_index;
+        if (!wine_rb_put( &font_meta_tree, &key, &meta->entry )) font_meta_loaded++;
+    }
+    TRACE( "loaded %u cached font entries\n", font_meta_loaded );
+
+done:
+    close( fd );
+}
+
+static void font_meta_append( const struct font_meta_entry *data )
+{
+    if (font_meta_output_size + data->size > font_meta_output_alloc)
+    {
+        SIZE_T new_alloc = max( max( font_meta_output_alloc * 2, 64 * 1024 ), font_meta_output_size + data->size );
+        char *new_output;
+
+        if (!font_meta_output) new_output = RtlAllocateHeap( GetProcessHeap(), 0, new_alloc );
+        else new_output = RtlReAllocateHeap( GetProcessHeap(), 0, font_meta_output, new_alloc );
+        if (!new_output) return;
+        font_meta_output = new_output;
+        font_meta_output_alloc = new_alloc;
+    }
+    memcpy( font_meta_output + font_meta_output_size, data, data->size );
+    font_meta_output_size += data->size;
+    font_meta_count++;
+}
+
+static WCHAR *font_meta_get_name( const WCHAR **ptr, WORD len )
+{
+    WCHAR *name = NULL;
+
+    if (len && (name = RtlAllocateHeap( GetProcessHeap(), 0, len * sizeof(WCHAR) )))
+    {
+        memcpy( name, *ptr, (len - 1) * sizeof(WCHAR) );
+        name[len - 1] = 0;
+    }
+    *ptr += len;
+    return name;
+}
+
+static struct unix_face *font_meta_get_face( const char *unix_name, UINT face_index, const struct stat *st )
+{
+    const struct font_meta_entry *data;
+    struct font_meta_key key;
+    struct wine_rb_entry *entry;
+    struct font_meta *meta;
+    struct unix_face *This;
+    const WCHAR *names;
+
+    key.unix_name = unix_name;
+    key.face_index = face_index;
+    if (!(entry = wine_rb_get( &font_meta_tree, &key ))) return NULL;
+    meta = WINE_RB_ENTRY_VALUE( entry, struct font_meta, entry );
+    data = meta->data;
+    if (data->file_size != st->st_size || data->file_mtime != st->st_mtime) return NULL;
+
+    if (!(This = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*This) ))) return NULL;
+    This->scalable = TRUE;
+    This->num_faces = data->num_faces;
+    This->ntm_flags = data->ntm_flags;
+    This->font_version = data->font_version;
+    This->fs = data->fs;
+
+    names = (const WCHAR *)(data + 1);
+    This->family_name = font_meta_get_name( &names, data->name_len[0] );
+    This->second_name = font_meta_get_name( &names, data->name_len[1] );
+    This->style_name = font_meta_get_name( &names, data->name_len[2] );
+    This->full_name = font_meta_get_name( &names, data->name_len[3] );
+    if (!This->family_name)
+    {
+        unix_face_destroy( This );
+        return NULL;
+    }
+
+    if (!meta->used)
+    {
+        font_meta_append( data );
+        meta->used = TRUE;
+        font_meta_used++;
+    }
+    return This;
+}
+
+static void font_meta_put_face( const char *unix_name, UINT face_index, const struct stat *st,
+                                const struct unix_face *face )
+{
+    const WCHAR *names[4] = { face->family_name, face->second_name, face->style_name, face->full_name };
+    struct font_meta_entry *data;
+    SIZE_T size = sizeof(*data), len[4];
+    WCHAR *ptr;
+    UINT i;
+
+    /* only faces parsed without FreeType are cached, others need their FT_Face anyway */
+    if (face->ft_face || !face->scalable || !face->family_name) return;
+
+    for (i = 0; i < ARRAY_SIZE(names); i++)
+    {
+        len[i] = names[i] ? lstrlenW( names[i] ) + 1 : 0;
+        if (len[i] > 0xffff) return;
+        size += len[i] * sizeof(WCHAR);
+    }
+    size = (size + strlen( unix_name ) + 1 + sizeof(ULONGLONG) - 1) & ~(sizeof(ULONGLONG) - 1);
+
+    if (!(data = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) return;
+    data->size = size;
+    data->face_index = face_index;
+    data->file_size = st->st_size;
+    data->file_mtime = st->st_mtime;
+    data->num_faces = face->num_faces;
+    data->ntm_flags = face->ntm_flags;
+    data->font_version = face->font_version;
+    data->fs = face->fs;
+
+    ptr = (WCHAR *)(data + 1);
+    for (i = 0; i < ARRAY_SIZE(names); i++)
+    {
+        data->name_len[i] = len[i];
+        memcpy( ptr, names[i], len[i] * sizeof(WCHAR) );
+        ptr += len[i];
+    }
+    strcpy( (char *)ptr, unix_name );
+
+    font_meta_append( data );
+    RtlFreeHeap( GetProcessHeap(), 0, data );
+}
+
+static void font_meta_cache_save(void)
+{
+    struct font_meta_header header;
+    char *name = NULL, *tmp_name = NULL, *p;
+    BOOL ret;
+    int fd;
+
+    font_meta_enabled = FALSE;
+
+    /* only rewrite the cache when some entries were added or went stale */
+    if (font_meta_count == font_meta_used && font_meta_used == font_meta_loaded) goto done;
+    if (!(name = get_font_meta_cache_name())) goto done;
+    if (!(tmp_name = RtlAllocateHeap( GetProcessHeap(), 0, strlen( name ) + 16 ))) goto done;
+
+    for (p = name + 1; (p = strchr( p, '/' )); *p++ = '/')
+    {
+        *p = 0;
+        mkdir( name, 0777 );
+    }
+
+    sprintf( tmp_name, "%s.%x", name, getpid() );
+    if ((fd = open( tmp_name, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) != -1)
+    {
+        header.magic = FONT_META_CACHE_MAGIC;
+        header.version = FONT_META_CACHE_VERSION;
+        header.lcid = system_lcid;
+        header.count = font_meta_count;
+        ret = write( fd, &header, sizeof(header) ) == sizeof(header) &&
+              write( fd, font_meta_output, font_meta_output_size ) == font_meta_output_size;
+        if (close( fd )) ret = FALSE;
+        if (ret && !rename( tmp_name, name ))
+            TRACE( "saved %u font entries to %s\n", font_meta_count, debugstr_a(name) );
+        else
+        {
+            WARN( "failed to write %s\n", debugstr_a(name) );
+            unlink( tmp_name );
+        }
+    }
+
+done:
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+    RtlFreeHeap( GetProcessHeap(), 0, tmp_name );
+    RtlFreeHeap( GetProcessHeap(), 0, font_meta_output );
+    RtlFreeHeap( GetProcessHeap(), 0, font_meta_array );
+    RtlFreeHeap( GetProcessHeap(), 0, font_meta_input );
+    wine_rb_init( &font_meta_tree, font_meta_compare );
+    font_meta_output = font_meta_input = NULL;
+    font_meta_array = NULL;
+    font_meta_output_size = font_meta_output_alloc = 0;
+    font_meta_loaded = font_meta_used = font_meta_count = 0;
+}
+
 static int add_unix_face( const char *unix_name, const WCHAR *file, void *data_ptr, SIZE_T data_size,
                           DWORD face_index, DWORD flags, DWORD *num_faces )
 {
     struct unix_face *unix_face;
+    struct stat st;
+    BOOL cacheable;
     int ret;
 
     if (num_faces) *num_faces = 0;
 
-    if (!(unix_face = unix_face_create( unix_name, data_ptr, data_size, face_index, flags )))
-        return 0;
+    cacheable = font_meta_enabled && unix_name && !stat( unix_name, &st );
+    if (!cacheable || !(unix_face = font_meta_get_face( unix_name, face_index, &st )))
+    {
+        if (!(unix_face = unix_face_create( unix_name, data_ptr, data_size, face_index, flags )))
+            return 0;
+        if (cacheable) font_meta_put_face( unix_name, face_index, &st, unix_face );
+    }
 
     if (unix_face->family_name[0] == '.') /* Ignore fonts with names beginning with a dot */
     {
@@ -1940,6 +2253,7 @@ sym_not_found:
  */
 static void CDECL freetype_load_fonts(void)
 {
+    font_meta_cache_load();
 #ifdef SONAME_LIBFONTCONFIG
     load_fontconfig_fonts();
 #elif defined(HAVE_CARBON_CARBON_H)
@@ -1947,6 +2261,7 @@ static void CDECL freetype_load_fonts(void)
 #elif defined(__ANDROID__)
     ReadFontDir("/system/fonts", TRUE);
 #endif
+    font_meta_cache_save();
 }
 
 /* Some fonts have large usWinDescent values, as a result of storing signed short
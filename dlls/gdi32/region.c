@@ -370,6 +370,7 @@ static BOOL REGION_UnionRegion(WINEREGION *d, WINEREGION *s1, WINEREGION *s2);
 static BOOL REGION_SubtractRegion(WINEREGION *d, WINEREGION *s1, WINEREGION *s2);
 static BOOL REGION_XorRegion(WINEREGION *d, WINEREGION *s1, WINEREGION *s2);
 static BOOL REGION_UnionRectWithRegion(const RECT *rect, WINEREGION *rgn);
+static INT REGION_Coalesce(WINEREGION *pReg, INT prevStart, INT curStart);
 
 /***********************************************************************
  *            get_region_type
@@ -1152,6 +1153,39 @@ BOOL WINAPI EqualRgn( HRGN hrgn1, HRGN hrgn2 )
 static BOOL REGION_UnionRectWithRegion(const RECT *rect, WINEREGION *rgn)
 {
     WINEREGION region;
+    RECT *last;
+    INT cur, prev;
+
+    /* Fast path for a rectangle that comes after all the existing ones in
+     * band order, which is what building a region from sorted rectangles
+     * does: append it in place instead of going through REGION_RegionOp. */
+    if (rgn->numRects && rect->left < rect->right && rect->top < rect->bottom)
+    {
+        last = &rgn->rects[rgn->numRects - 1];
+        if (rect->top >= last->bottom ||
+            (rect->top == last->top && rect->bottom == last->bottom && rect->left >= last->right))
+        {
+            if (rect->top == last->top && rect->left == last->right)
+                last->right = rect->right;
+            else if (!add_rect( rgn, rect->left, rect->top, rect->right, rect->bottom ))
+                return FALSE;
+
+            /* merge the last band with the previous one if they line up */
+            for (cur = rgn->numRects - 1; cur > 0; cur--)
+                if (rgn->rects[cur - 1].top != rgn->rects[cur].top) break;
+            if (cur > 0)
+            {
+                for (prev = cur - 1; prev > 0; prev--)
+                    if (rgn->rects[prev - 1].top != rgn->rects[prev].top) break;
+                REGION_Coalesce( rgn, prev, cur );
+            }
+
+            rgn->extents.left = min( rgn->extents.left, rect->left );
+            rgn->extents.right = max( rgn->extents.right, rect->right );
+            rgn->extents.bottom = max( rgn->extents.bottom, rect->bottom );
+            return TRUE;
+        }
+    }
 
     init_region( &region, 1 );
     region.numRects = 1;
@@ -778,6 +778,96 @@ static inline BOOL set_cache_glyph_widths(SCRIPT_CACHE *psc, WORD glyph, ABC *ab
     return TRUE;
 }
 
+static DWORD shape_cache_hash(const WCHAR *chars, int count, const SCRIPT_ANALYSIS *sa)
+{
+    DWORD hash = 2166136261u ^ sa->eScript;
+    int i;
+
+    for (i = 0; i < count; i++)
+        hash = (hash ^ chars[i]) * 16777619u;
+    return hash;
+}
+
+static BOOL shape_cache_match(const CacheShapeEntry *entry, DWORD hash, const WCHAR *chars, int count,
+        const SCRIPT_ANALYSIS *sa, OPENTYPE_TAG script, OPENTYPE_TAG lang, int max_glyphs)
+{
+    return entry->hash == hash && entry->char_count == count && entry->max_glyphs == max_glyphs
+            && entry->script == script && entry->lang == lang
+            && !memcmp(&entry->sa, sa, sizeof(*sa))
+            && !memcmp(entry->chars, chars, count * sizeof(*chars));
+}
+
+static BOOL shape_cache_lookup(ScriptCache *sc, const WCHAR *chars, int count, const SCRIPT_ANALYSIS *sa,
+        OPENTYPE_TAG script, OPENTYPE_TAG lang, int max_glyphs, WORD *log_clust, SCRIPT_CHARPROP *char_props,
+        WORD *glyphs, SCRIPT_GLYPHPROP *glyph_props, int *glyph_count)
+{
+    DWORD hash = shape_cache_hash(chars, count, sa);
+    CacheShapeEntry *entry;
+    BOOL found = FALSE;
+
+    EnterCriticalSection(&cs_script_cache);
+    entry = sc->shape_cache[hash % SHAPE_CACHE_SIZE];
+    if (entry && shape_cache_match(entry, hash, chars, count, sa, script, lang, max_glyphs))
+    {
+        memcpy(log_clust, entry->log_clust, count * sizeof(*log_clust));
+        memcpy(char_props, entry->char_props, count * sizeof(*char_props));
+        memcpy(glyphs, entry->glyphs, entry->glyph_count * sizeof(*glyphs));
+        memcpy(glyph_props, entry->glyph_props, entry->glyph_count * sizeof(*glyph_props));
+        *glyph_count = entry->glyph_count;
+        found = TRUE;
+    }
+    LeaveCriticalSection(&cs_script_cache);
+    return found;
+}
+
+static void shape_cache_store(ScriptCache *sc, const WCHAR *chars, int count, const SCRIPT_ANALYSIS *sa,
+        OPENTYPE_TAG script, OPENTYPE_TAG lang, int max_glyphs, const WORD *log_clust,
+        const SCRIPT_CHARPROP *char_props, const WORD *glyphs, const SCRIPT_GLYPHPROP *glyph_props,
+        int glyph_count)
+{
+    CacheShapeEntry *entry, *old;
+    DWORD hash;
+    char *ptr;
+
+    if (!(entry = heap_alloc(sizeof(*entry) + count * (sizeof(*chars) + sizeof(*log_clust)
+            + sizeof(*char_props)) + glyph_count * (sizeof(*glyphs) + sizeof(*glyph_props)))))
+        return;
+
+    hash = shape_cache_hash(chars, count, sa);
+    entry->hash = hash;
+    entry->sa = *sa;
+    entry->script = script;
+    entry->lang = lang;
+    entry->char_count = count;
+    entry->max_glyphs = max_glyphs;
+    entry->glyph_count = glyph_count;
+
+    /* Keep the larger-aligned arrays first. */
+    ptr = (char *)(entry + 1);
+    entry->glyph_props = (SCRIPT_GLYPHPROP *)ptr;
+    ptr += glyph_count * sizeof(*glyph_props);
+    entry->char_props = (SCRIPT_CHARPROP *)ptr;
+    ptr += count * sizeof(*char_props);
+    entry->glyphs = (WORD *)ptr;
+    ptr += glyph_count * sizeof(*glyphs);
+    entry->log_clust = (WORD *)ptr;
+    ptr += count * sizeof(*log_clust);
+    entry->chars = (WCHAR *)ptr;
+
+    memcpy(entry->glyph_props, glyph_props, glyph_count * sizeof(*glyph_props));
+    memcpy(entry->char_props, char_props, count * sizeof(*char_props));
+    memcpy(entry->glyphs, glyphs, glyph_count * sizeof(*glyphs));
+    memcpy(entry->log_clust, log_clust, count * sizeof(*log_clust));
+    memcpy(entry->chars, chars, count * sizeof(*chars));
+
+    EnterCriticalSection(&cs_script_cache);
+    old = sc->shape_cache[hash % SHAPE_CACHE_SIZE];
+    sc->shape_cache[hash % SHAPE_CACHE_SIZE] = entry;
+    LeaveCriticalSection(&cs_script_cache);
+
+    heap_free(old);
+}
+
 static HRESULT init_script_cache(const HDC hdc, SCRIPT_CACHE *psc)
 {
     ScriptCache *sc;
@@ -1043,6 +1133,8 @@ HRESULT WINAPI ScriptFreeCache(SCRIPT_CACHE *psc)
             heap_free(((ScriptCache *)*psc)->scripts[n].languages);
         }
         heap_free(((ScriptCache *)*psc)->scripts);
+        for (i = 0; i < SHAPE_CACHE_SIZE; i++)
+            heap_free(((ScriptCache *)*psc)->shape_cache[i]);
         heap_free(((ScriptCache *)*psc)->otm);
         heap_free(*psc);
         *psc = NULL;
@@ -3057,7 +3149,7 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
     HRESULT hr;
     int i;
     unsigned int g;
-    BOOL rtl;
+    BOOL rtl, use_shape_cache;
     int cluster;
     static int once = 0;
 
@@ -3085,6 +3177,14 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
     ((ScriptCache *)*psc)->userScript = tagScript;
     ((ScriptCache *)*psc)->userLang = tagLangSys;
 
+    /* Runs of text are frequently reshaped unchanged, e.g. on every repaint.
+     * Only the glyph translation path is cached, the other one is trivial. */
+    use_shape_cache = psa && !psa->fNoGlyphIndex && ((ScriptCache *)*psc)->sfnt
+            && !cRanges && cChars > 0 && cChars <= SHAPE_CACHE_MAX_CHARS;
+    if (use_shape_cache && shape_cache_lookup((ScriptCache *)*psc, pwcChars, cChars, psa, tagScript,
+            tagLangSys, cMaxGlyphs, pwLogClust, pCharProps, pwOutGlyphs, pOutGlyphProps, pcGlyphs))
+        return S_OK;
+
     /* Initialize a SCRIPT_VISATTR and LogClust for each char in this run */
     for (i = 0; i < cChars; i++)
     {
@@ -3181,6 +3281,10 @@ HRESULT WINAPI ScriptShapeOpenType( HDC hdc, SCRIPT_CACHE *psc,
             }
         }
         heap_free(rChars);
+
+        if (use_shape_cache)
+            shape_cache_store((ScriptCache *)*psc, pwcChars, cChars, psa, tagScript, tagLangSys, cMaxGlyphs,
+                    pwLogClust, pCharProps, pwOutGlyphs, pOutGlyphProps, *pcGlyphs);
     }
     else
     {
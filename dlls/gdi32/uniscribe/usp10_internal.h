@@ -133,6 +133,9 @@ enum usp10_script
 
 #define NUM_PAGES         17
 
+#define SHAPE_CACHE_SIZE      64
+#define SHAPE_CACHE_MAX_CHARS 64
+
 #define GSUB_E_NOFEATURE -20
 #define GSUB_E_NOGLYPH -10
 
@@ -185,6 +188,21 @@ typedef struct {
     WORD *glyphs[GLYPH_MAX / GLYPH_BLOCK_SIZE];
 } CacheGlyphPage;
 
+typedef struct {
+    DWORD hash;
+    SCRIPT_ANALYSIS sa;
+    OPENTYPE_TAG script;
+    OPENTYPE_TAG lang;
+    int char_count;
+    int max_glyphs;
+    int glyph_count;
+    WCHAR *chars;
+    WORD *log_clust;
+    SCRIPT_CHARPROP *char_props;
+    WORD *glyphs;
+    SCRIPT_GLYPHPROP *glyph_props;
+} CacheShapeEntry;
+
 typedef struct {
     struct list entry;
     DWORD refcount;
@@ -207,6 +225,8 @@ typedef struct {
 
     OPENTYPE_TAG userScript;
     OPENTYPE_TAG userLang;
+
+    CacheShapeEntry *shape_cache[SHAPE_CACHE_SIZE];
 } ScriptCache;
 
 typedef struct _scriptData
@@ -1883,8 +1883,75 @@ struct pid_map
 {
     unsigned int pid;
     unsigned int unix_pid;
+#ifdef __linux__
+    UINT_PTR     inode;     /* socket inode owned by the process */
+#endif
 };
 
+#ifdef __linux__
+static int compare_pid_map_inodes( const void *a, const void *b )
+{
+    const struct pid_map *entryA = a, *entryB = b;
+
+    if (entryA->inode < entryB->inode) return -1;
+    return entryA->inode > entryB->inode;
+}
+
+/* Replace the process map by a map of all the sockets owned by these
+ * processes, sorted by inode, so that each table row only needs a lookup
+ * instead of a scan of every process' file descriptors. */
+static struct pid_map *map_socket_inodes( struct pid_map *map, unsigned int *num_entries )
+{
+    struct pid_map *sockets, *new_sockets;
+    unsigned int i, count = 0, size = 64;
+
+    if (!(sockets = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*sockets) )))
+    {
+        HeapFree( GetProcessHeap(), 0, map );
+        return NULL;
+    }
+
+    for (i = 0; i < *num_entries; i++)
+    {
+        char dir[32];
+        struct dirent *dirent;
+        DIR *dirfd;
+
+        sprintf( dir, "/proc/%u/fd", map[i].unix_pid );
+        if (!(dirfd = opendir( dir ))) continue;
+        while ((dirent = readdir( dirfd )))
+        {
+            char link[sizeof(dirent->d_name) + 32], name[32];
+            unsigned long inode;
+            int len;
+
+            sprintf( link, "/proc/%u/fd/%s", map[i].unix_pid, dirent->d_name );
+            if ((len = readlink( link, name, sizeof(name) - 1 )) <= 0) continue;
+            name[len] = 0;
+            if (sscanf( name, "socket:[%lu]", &inode ) != 1) continue;
+
+            if (count == size)
+            {
+                size *= 2;
+                if (!(new_sockets = HeapReAlloc( GetProcessHeap(), 0, sockets, size * sizeof(*sockets) )))
+                    break;
+                sockets = new_sockets;
+            }
+            sockets[count].pid = map[i].pid;
+            sockets[count].unix_pid = map[i].unix_pid;
+            sockets[count].inode = inode;
+            count++;
+        }
+        closedir( dirfd );
+    }
+
+    HeapFree( GetProcessHeap(), 0, map );
+    qsort( sockets, count, sizeof(*sockets), compare_pid_map_inodes );
+    *num_entries = count;
+    return sockets;
+}
+#endif
+
 static struct pid_map *get_pid_map( unsigned int *num_entries )
 {
     struct pid_map *map;
@@ -1951,42 +2018,21 @@ static struct pid_map *get_pid_map( unsigned int *num_entries )
 
     HeapFree( GetProcessHeap(), 0, buffer );
     *num_entries = process_count;
+#ifdef __linux__
+    map = map_socket_inodes( map, num_entries );
+#endif
     return map;
 }
 
 static unsigned int find_owning_pid( struct pid_map *map, unsigned int num_entries, UINT_PTR inode )
 {
 #ifdef __linux__
-    unsigned int i, len_socket;
-    char socket[32];
-
-    sprintf( socket, "socket:[%lu]", inode );
-    len_socket = strlen( socket );
-    for (i = 0; i < num_entries; i++)
-    {
-        char dir[32];
-        struct dirent *dirent;
-        DIR *dirfd;
-
-        sprintf( dir, "/proc/%u/fd", map[i].unix_pid );
-        if ((dirfd = opendir( dir )))
-        {
-            while ((dirent = readdir( dirfd )))
-            {
-                char link[sizeof(dirent->d_name) + 32], name[32];
-                int len;
+    struct pid_map key, *entry;
 
-                sprintf( link, "/proc/%u/fd/%s", map[i].unix_pid, dirent->d_name );
-                if ((len = readlink( link, name, sizeof(name) - 1 )) > 0) name[len] = 0;
-                if (len == len_socket && !strcmp( socket, name ))
-                {
-                    closedir( dirfd );
-                    return map[i].pid;
-                }
-            }
-            closedir( dirfd );
-        }
-    }
+    if (!map) return 0;
+    key.inode = inode;
+    if ((entry = bsearch( &key, map, num_entries, sizeof(*map), compare_pid_map_inodes )))
+        return entry->pid;
     return 0;
 #elif defined(HAVE_LIBPROCSTAT)
     struct procstat *pstat;
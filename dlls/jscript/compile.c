@@ -414,6 +414,24 @@ static HRESULT push_instr_uint(compiler_ctx_t *ctx, jsop_t op, unsigned arg)
     return S_OK;
 }
 
+static inline unsigned alloc_prop_cache(compiler_ctx_t *ctx)
+{
+    return ctx->code->prop_cache_cnt++;
+}
+
+static HRESULT push_instr_memberid(compiler_ctx_t *ctx, unsigned flags)
+{
+    unsigned instr;
+
+    instr = push_instr(ctx, OP_memberid);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].uint = flags;
+    instr_ptr(ctx, instr)->u.arg[1].uint = alloc_prop_cache(ctx);
+    return S_OK;
+}
+
 static HRESULT compile_binary_expression(compiler_ctx_t *ctx, binary_expression_t *expr, jsop_t op)
 {
     HRESULT hres;
@@ -449,7 +467,7 @@ static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_
     if(FAILED(hres))
         return hres;
 
-    return push_instr_bstr(ctx, OP_member, expr->identifier);
+    return push_instr_bstr_uint(ctx, OP_member, expr->identifier, alloc_prop_cache(ctx));
 }
 
 #define LABEL_FLAG 0x80000000
@@ -526,7 +544,7 @@ static HRESULT emit_identifier(compiler_ctx_t *ctx, const WCHAR *identifier)
     int local_ref;
     if(bind_local(ctx, identifier, &local_ref))
         return push_instr_int(ctx, OP_local, local_ref);
-    return push_instr_bstr(ctx, OP_ident, identifier);
+    return push_instr_bstr_uint(ctx, OP_ident, identifier, alloc_prop_cache(ctx));
 }
 
 static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *expr, unsigned flags)
@@ -551,7 +569,7 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
         if(FAILED(hres))
             return hres;
 
-        hres = push_instr_uint(ctx, OP_memberid, flags);
+        hres = push_instr_memberid(ctx, flags);
         break;
     }
     case EXPR_MEMBER: {
@@ -571,7 +589,7 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
         if(FAILED(hres))
             return hres;
 
-        hres = push_instr_uint(ctx, OP_memberid, flags);
+        hres = push_instr_memberid(ctx, flags);
         break;
     }
     DEFAULT_UNREACHABLE;
@@ -2432,6 +2450,45 @@ static void resolve_labels(compiler_ctx_t *ctx, unsigned off)
     ctx->labels_cnt = 0;
 }
 
+/*
+ * Fuses common instruction sequences into a single instruction. The fused
+ * instruction replaces the first one of the sequence and skips over the rest,
+ * which are left in place so that jumps into the middle of the sequence still
+ * behave the same.
+ */
+static void fuse_instrs(compiler_ctx_t *ctx, unsigned off)
+{
+    instr_t *instr, *end = ctx->code->instrs + ctx->code_off;
+
+    for(instr = ctx->code->instrs+off; instr + 1 < end; instr++) {
+        switch(instr->op) {
+        case OP_lt:
+        case OP_lteq:
+        case OP_gt:
+        case OP_gteq:
+            /* relational operator followed by a conditional jump */
+            if(instr[1].op != OP_jmp_z)
+                break;
+            switch(instr->op) {
+            case OP_lt:   instr->op = OP_lt_jmp_z; break;
+            case OP_lteq: instr->op = OP_lteq_jmp_z; break;
+            case OP_gt:   instr->op = OP_gt_jmp_z; break;
+            default:      instr->op = OP_gteq_jmp_z; break;
+            }
+            instr->u.arg->uint = instr[1].u.arg->uint;
+            break;
+        case OP_local_ref:
+            /* local variable incremented or decremented as a statement */
+            if(instr + 2 < end && (instr[1].op == OP_postinc || instr[1].op == OP_preinc)
+               && instr[2].op == OP_pop && instr[2].u.arg->uint == 1)
+                instr->op = OP_local_incr;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 void release_bytecode(bytecode_t *code)
 {
     unsigned i;
@@ -2450,6 +2507,7 @@ void release_bytecode(bytecode_t *code)
     heap_pool_free(&code->heap);
     heap_free(code->bstr_pool);
     heap_free(code->str_pool);
+    heap_free(code->prop_caches);
     heap_free(code->instrs);
     heap_free(code);
 }
@@ -2593,6 +2651,7 @@ static HRESULT compile_function(compiler_ctx_t *ctx, statement_t *source, functi
         return hres;
 
     resolve_labels(ctx, off);
+    fuse_instrs(ctx, off);
 
     hres = push_instr_uint(ctx, OP_ret, !from_eval);
     if(FAILED(hres))
@@ -2740,6 +2799,14 @@ HRESULT compile_script(script_ctx_t *ctx, const WCHAR *code, UINT64 source_conte
         return DISP_E_EXCEPTION;
     }
 
+    if(compiler.code->prop_cache_cnt) {
+        compiler.code->prop_caches = heap_alloc_zero(compiler.code->prop_cache_cnt * sizeof(*compiler.code->prop_caches));
+        if(!compiler.code->prop_caches) {
+            release_bytecode(compiler.code);
+            return E_OUTOFMEMORY;
+        }
+    }
+
     if(named_item) {
         compiler.code->named_item = named_item;
         named_item->ref++;
@@ -1895,6 +1895,32 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/* Property ids are never reused for another name and deleted properties keep their
+ * slot, so a cached id is still valid as long as the slot holds the same live name. */
+HRESULT jsdisp_get_id_cached(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, prop_cache_t *cache, DISPID *id)
+{
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if(!cache)
+        return jsdisp_get_id(jsdisp, name, flags, id);
+
+    if(cache->obj == jsdisp && (DWORD)cache->id < jsdisp->prop_cnt) {
+        prop = jsdisp->props + cache->id;
+        if(prop->type != PROP_DELETED && !wcscmp(prop->name, name)) {
+            *id = cache->id;
+            return S_OK;
+        }
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres)) {
+        cache->obj = jsdisp;
+        cache->id = *id;
+    }
+    return hres;
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
@@ -427,7 +427,8 @@ void scope_release(scope_chain_t *scope)
     heap_free(scope);
 }
 
-static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags, DISPID *id)
+static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags,
+                           prop_cache_t *cache, DISPID *id)
 {
     IDispatchEx *dispex;
     jsdisp_t *jsdisp;
@@ -436,7 +437,7 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
 
     jsdisp = iface_to_jsdisp(disp);
     if(jsdisp) {
-        hres = jsdisp_get_id(jsdisp, name, flags, id);
+        hres = jsdisp_get_id_cached(jsdisp, name, flags, cache, id);
         jsdisp_release(jsdisp);
         return hres;
     }
@@ -626,7 +627,7 @@ static BOOL lookup_global_members(script_ctx_t *ctx, BSTR identifier, exprval_t
 
     LIST_FOR_EACH_ENTRY(item, &ctx->named_items, named_item_t, entry) {
         if(item->flags & SCRIPTITEM_GLOBALMEMBERS) {
-            hres = disp_get_id(ctx, item->disp, identifier, identifier, 0, &id);
+            hres = disp_get_id(ctx, item->disp, identifier, identifier, 0, NULL, &id);
             if(SUCCEEDED(hres)) {
                 if(ret)
                     exprval_set_disp_ref(ret, item->disp, id);
@@ -665,7 +666,7 @@ local_ref_t *lookup_local(const function_code_t *function, const WCHAR *identifi
 }
 
 /* ECMA-262 3rd Edition    10.1.4 */
-static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, exprval_t *ret)
+static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, prop_cache_t *cache, exprval_t *ret)
 {
     scope_chain_t *scope;
     named_item_t *item;
@@ -698,9 +699,9 @@ static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, exprval_t *re
                 continue;
 
             if(scope->jsobj)
-                hres = jsdisp_get_id(scope->jsobj, identifier, fdexNameImplicit, &id);
+                hres = jsdisp_get_id_cached(scope->jsobj, identifier, fdexNameImplicit, cache, &id);
             else
-                hres = disp_get_id(ctx, scope->obj, identifier, identifier, fdexNameImplicit, &id);
+                hres = disp_get_id(ctx, scope->obj, identifier, identifier, fdexNameImplicit, NULL, &id);
             if(SUCCEEDED(hres)) {
                 exprval_set_disp_ref(ret, scope->obj, id);
                 return S_OK;
@@ -709,13 +710,13 @@ static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, exprval_t *re
 
         item = ctx->call_ctx->bytecode->named_item;
         if(item) {
-            hres = jsdisp_get_id(item->script_obj, identifier, 0, &id);
+            hres = jsdisp_get_id_cached(item->script_obj, identifier, 0, cache, &id);
             if(SUCCEEDED(hres)) {
                 exprval_set_disp_ref(ret, to_disp(item->script_obj), id);
                 return S_OK;
             }
             if(!(item->flags & SCRIPTITEM_CODEONLY)) {
-                hres = disp_get_id(ctx, item->disp, identifier, identifier, 0, &id);
+                hres = disp_get_id(ctx, item->disp, identifier, identifier, 0, NULL, &id);
                 if(SUCCEEDED(hres)) {
                     exprval_set_disp_ref(ret, item->disp, id);
                     return S_OK;
@@ -724,7 +725,7 @@ static HRESULT identifier_eval(script_ctx_t *ctx, BSTR identifier, exprval_t *re
         }
     }
 
-    hres = jsdisp_get_id(ctx->global, identifier, 0, &id);
+    hres = jsdisp_get_id_cached(ctx->global, identifier, 0, cache, &id);
     if(SUCCEEDED(hres)) {
         exprval_set_disp_ref(ret, to_disp(ctx->global), id);
         return S_OK;
@@ -757,6 +758,12 @@ static inline unsigned get_op_uint(script_ctx_t *ctx, int i)
     return frame->bytecode->instrs[frame->ip].u.arg[i].uint;
 }
 
+static inline prop_cache_t *get_op_prop_cache(script_ctx_t *ctx, int i)
+{
+    call_frame_t *frame = ctx->call_ctx;
+    return frame->bytecode->prop_caches + frame->bytecode->instrs[frame->ip].u.arg[i].uint;
+}
+
 static inline unsigned get_op_int(script_ctx_t *ctx, int i)
 {
     call_frame_t *frame = ctx->call_ctx;
@@ -1201,7 +1208,7 @@ static HRESULT interp_array(script_ctx_t *ctx)
         return hres;
     }
 
-    hres = disp_get_id(ctx, obj, name, NULL, 0, &id);
+    hres = disp_get_id(ctx, obj, name, NULL, 0, NULL, &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
@@ -1220,6 +1227,7 @@ static HRESULT interp_array(script_ctx_t *ctx)
 static HRESULT interp_member(script_ctx_t *ctx)
 {
     const BSTR arg = get_op_bstr(ctx, 0);
+    prop_cache_t *cache = get_op_prop_cache(ctx, 1);
     IDispatch *obj;
     jsval_t v;
     DISPID id;
@@ -1231,7 +1239,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, arg, arg, 0, &id);
+    hres = disp_get_id(ctx, obj, arg, arg, 0, cache, &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -1249,6 +1257,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
 static HRESULT interp_memberid(script_ctx_t *ctx)
 {
     const unsigned arg = get_op_uint(ctx, 0);
+    prop_cache_t *cache = get_op_prop_cache(ctx, 1);
     jsval_t objv, namev;
     const WCHAR *name;
     jsstr_t *name_str;
@@ -1273,7 +1282,7 @@ static HRESULT interp_memberid(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, name, NULL, arg, &id);
+    hres = disp_get_id(ctx, obj, name, NULL, arg, cache, &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         ref.type = EXPRVAL_IDREF;
@@ -1396,7 +1405,7 @@ static HRESULT interp_identifier_ref(script_ctx_t *ctx, BSTR identifier, unsigne
     exprval_t exprval;
     HRESULT hres;
 
-    hres = identifier_eval(ctx, identifier, &exprval);
+    hres = identifier_eval(ctx, identifier, NULL, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -1423,13 +1432,13 @@ static HRESULT interp_identifier_ref(script_ctx_t *ctx, BSTR identifier, unsigne
     return stack_push_exprval(ctx, &exprval);
 }
 
-static HRESULT identifier_value(script_ctx_t *ctx, BSTR identifier)
+static HRESULT identifier_value(script_ctx_t *ctx, BSTR identifier, prop_cache_t *cache)
 {
     exprval_t exprval;
     jsval_t v;
     HRESULT hres;
 
-    hres = identifier_eval(ctx, identifier, &exprval);
+    hres = identifier_eval(ctx, identifier, cache, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -1460,6 +1469,33 @@ static HRESULT interp_local_ref(script_ctx_t *ctx)
     return stack_push_exprval(ctx, &ref);
 }
 
+/* local_ref, postinc or preinc and pop fused by the compiler */
+static HRESULT interp_local_incr(script_ctx_t *ctx)
+{
+    const int arg = get_op_int(ctx, 0);
+    call_frame_t *frame = ctx->call_ctx;
+    const int incr = frame->bytecode->instrs[frame->ip + 1].u.arg->lng;
+    jsval_t *v;
+    HRESULT hres;
+
+    TRACE("%d %d\n", arg, incr);
+
+    if(frame->base_scope && frame->base_scope->frame) {
+        v = ctx->stack + local_off(frame, arg);
+        if(is_number(*v)) {
+            *v = jsval_number(get_number(*v) + (double)incr);
+            frame->ip += 3;
+            return S_OK;
+        }
+    }
+
+    /* fall back to the unfused sequence */
+    hres = interp_local_ref(ctx);
+    if(SUCCEEDED(hres))
+        jmp_next(ctx);
+    return hres;
+}
+
 static HRESULT interp_local(script_ctx_t *ctx)
 {
     const int arg = get_op_int(ctx, 0);
@@ -1470,7 +1506,7 @@ static HRESULT interp_local(script_ctx_t *ctx)
     TRACE("%d: %s\n", arg, debugstr_w(local_name(frame, arg)));
 
     if(!frame->base_scope || !frame->base_scope->frame)
-        return identifier_value(ctx, local_name(frame, arg));
+        return identifier_value(ctx, local_name(frame, arg), NULL);
 
     hres = jsval_copy(ctx->stack[local_off(frame, arg)], &copy);
     if(FAILED(hres))
@@ -1486,7 +1522,7 @@ static HRESULT interp_ident(script_ctx_t *ctx)
 
     TRACE("%s\n", debugstr_w(arg));
 
-    return identifier_value(ctx, arg);
+    return identifier_value(ctx, arg, get_op_prop_cache(ctx, 1));
 }
 
 /* ECMA-262 3rd Edition    10.1.4 */
@@ -1843,7 +1879,7 @@ static HRESULT interp_in(script_ctx_t *ctx)
         return hres;
     }
 
-    hres = disp_get_id(ctx, get_object(obj), str, NULL, 0, &id);
+    hres = disp_get_id(ctx, get_object(obj), str, NULL, 0, NULL, &id);
     IDispatch_Release(get_object(obj));
     jsstr_release(jsstr);
     if(SUCCEEDED(hres))
@@ -1867,6 +1903,9 @@ static HRESULT interp_add(script_ctx_t *ctx)
 
     TRACE("%s + %s\n", debugstr_jsval(lval), debugstr_jsval(rval));
 
+    if(is_number(lval) && is_number(rval))
+        return stack_push(ctx, jsval_number(get_number(lval) + get_number(rval)));
+
     hres = to_primitive(ctx, lval, &l, NO_HINT);
     if(SUCCEEDED(hres)) {
         hres = to_primitive(ctx, rval, &r, NO_HINT);
@@ -2040,7 +2079,7 @@ static HRESULT interp_delete_ident(script_ctx_t *ctx)
 
     TRACE("%s\n", debugstr_w(arg));
 
-    hres = identifier_eval(ctx, arg, &exprval);
+    hres = identifier_eval(ctx, arg, NULL, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -2151,7 +2190,7 @@ static HRESULT interp_typeofident(script_ctx_t *ctx)
 
     TRACE("%s\n", debugstr_w(arg));
 
-    hres = identifier_eval(ctx, arg, &exprval);
+    hres = identifier_eval(ctx, arg, NULL, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -2454,6 +2493,13 @@ static HRESULT less_eval(script_ctx_t *ctx, jsval_t lval, jsval_t rval, BOOL gre
     jsval_t l, r;
     HRESULT hres;
 
+    if(is_number(lval) && is_number(rval)) {
+        ln = get_number(lval);
+        rn = get_number(rval);
+        *ret = !isnan(ln) && !isnan(rn) && ((ln < rn) ^ greater);
+        return S_OK;
+    }
+
     hres = to_primitive(ctx, lval, &l, NO_HINT);
     if(FAILED(hres))
         return hres;
@@ -2567,6 +2613,53 @@ static HRESULT interp_gteq(script_ctx_t *ctx)
     return stack_push(ctx, jsval_bool(b));
 }
 
+/* relational operator and jmp_z fused by the compiler */
+static HRESULT less_jmp_z(script_ctx_t *ctx, BOOL swap, BOOL greater)
+{
+    const unsigned arg = get_op_uint(ctx, 0);
+    jsval_t l, r;
+    BOOL b;
+    HRESULT hres;
+
+    r = stack_pop(ctx);
+    l = stack_pop(ctx);
+
+    TRACE("%s %s, %u\n", debugstr_jsval(l), debugstr_jsval(r), arg);
+
+    hres = swap ? less_eval(ctx, r, l, greater, &b) : less_eval(ctx, l, r, greater, &b);
+    jsval_release(l);
+    jsval_release(r);
+    if(FAILED(hres))
+        return hres;
+
+    /* skip the original jmp_z following us */
+    if(b)
+        ctx->call_ctx->ip += 2;
+    else
+        jmp_abs(ctx, arg);
+    return S_OK;
+}
+
+static HRESULT interp_lt_jmp_z(script_ctx_t *ctx)
+{
+    return less_jmp_z(ctx, FALSE, FALSE);
+}
+
+static HRESULT interp_lteq_jmp_z(script_ctx_t *ctx)
+{
+    return less_jmp_z(ctx, TRUE, TRUE);
+}
+
+static HRESULT interp_gt_jmp_z(script_ctx_t *ctx)
+{
+    return less_jmp_z(ctx, TRUE, FALSE);
+}
+
+static HRESULT interp_gteq_jmp_z(script_ctx_t *ctx)
+{
+    return less_jmp_z(ctx, FALSE, TRUE);
+}
+
 /* ECMA-262 3rd Edition    11.4.8 */
 static HRESULT interp_bneg(script_ctx_t *ctx)
 {
@@ -3014,7 +3107,7 @@ static HRESULT bind_event_target(script_ctx_t *ctx, function_code_t *func, jsdis
     jsval_t v;
     HRESULT hres;
 
-    hres = identifier_eval(ctx, func->event_target, &exprval);
+    hres = identifier_eval(ctx, func->event_target, NULL, &exprval);
     if(FAILED(hres))
         return hres;
 
@@ -3205,7 +3298,7 @@ HRESULT exec_source(script_ctx_t *ctx, DWORD flags, bytecode_t *bytecode, functi
             }
 
             if(item && !(item->flags & SCRIPTITEM_CODEONLY)
-                && SUCCEEDED(disp_get_id(ctx, item->disp, function->variables[i].name, function->variables[i].name, 0, &id)))
+                && SUCCEEDED(disp_get_id(ctx, item->disp, function->variables[i].name, function->variables[i].name, 0, NULL, &id)))
                     continue;
 
             if(!item && (flags & EXEC_GLOBAL) && lookup_global_members(ctx, function->variables[i].name, NULL))
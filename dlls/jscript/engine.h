@@ -42,8 +42,10 @@
     X(forin,      0, ARG_ADDR,   0)        \
     X(func,       1, ARG_UINT,   0)        \
     X(gt,         1, 0,0)                  \
+    X(gt_jmp_z,   0, ARG_ADDR,   0)        \
     X(gteq,       1, 0,0)                  \
-    X(ident,      1, ARG_BSTR,   0)        \
+    X(gteq_jmp_z, 0, ARG_ADDR,   0)        \
+    X(ident,      1, ARG_BSTR,   ARG_UINT) \
     X(identid,    1, ARG_BSTR,   ARG_INT)  \
     X(in,         1, 0,0)                  \
     X(instanceof, 1, 0,0)                  \
@@ -51,12 +53,15 @@
     X(jmp,        0, ARG_ADDR,   0)        \
     X(jmp_z,      0, ARG_ADDR,   0)        \
     X(local,      1, ARG_INT,    0)        \
+    X(local_incr, 0, ARG_INT,    ARG_UINT) \
     X(local_ref,  1, ARG_INT,    ARG_UINT) \
     X(lshift,     1, 0,0)                  \
     X(lt,         1, 0,0)                  \
+    X(lt_jmp_z,   0, ARG_ADDR,   0)        \
     X(lteq,       1, 0,0)                  \
-    X(member,     1, ARG_BSTR,   0)        \
-    X(memberid,   1, ARG_UINT,   0)        \
+    X(lteq_jmp_z, 0, ARG_ADDR,   0)        \
+    X(member,     1, ARG_BSTR,   ARG_UINT) \
+    X(memberid,   1, ARG_UINT,   ARG_UINT) \
     X(minus,      1, 0,0)                  \
     X(mod,        1, 0,0)                  \
     X(mul,        1, 0,0)                  \
@@ -203,6 +208,9 @@ struct _bytecode_t {
     unsigned str_pool_size;
     unsigned str_cnt;
 
+    prop_cache_t *prop_caches;  /* indexed by the instruction's cache argument */
+    unsigned prop_cache_cnt;
+
     struct list entry;
 };
 
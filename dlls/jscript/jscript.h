@@ -87,6 +87,13 @@ static inline LPWSTR heap_strdupW(LPCWSTR str)
 
 typedef struct jsdisp_t jsdisp_t;
 
+/* Remembers the last object a name was resolved on. The object is not referenced,
+ * entries are validated against its property table on every use. */
+typedef struct {
+    jsdisp_t *obj;
+    DISPID id;
+} prop_cache_t;
+
 extern HINSTANCE jscript_hinstance DECLSPEC_HIDDEN;
 HRESULT get_dispatch_typeinfo(ITypeInfo**) DECLSPEC_HIDDEN;
 
@@ -307,6 +314,7 @@ HRESULT jsdisp_propput_idx(jsdisp_t*,DWORD,jsval_t) DECLSPEC_HIDDEN;
 HRESULT jsdisp_propget_name(jsdisp_t*,LPCWSTR,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_idx(jsdisp_t*,DWORD,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_id(jsdisp_t*,const WCHAR*,DWORD,DISPID*) DECLSPEC_HIDDEN;
+HRESULT jsdisp_get_id_cached(jsdisp_t*,const WCHAR*,DWORD,prop_cache_t*,DISPID*) DECLSPEC_HIDDEN;
 HRESULT disp_delete(IDispatch*,DISPID,BOOL*) DECLSPEC_HIDDEN;
 HRESULT disp_delete_name(script_ctx_t*,IDispatch*,jsstr_t*,BOOL*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_delete_idx(jsdisp_t*,DWORD) DECLSPEC_HIDDEN;
@@ -406,6 +414,13 @@ typedef struct {
     unsigned length;
 } match_result_t;
 
+#define REGEXP_CACHE_SIZE 16
+
+typedef struct {
+    jsstr_t *src;
+    struct regexp_t *regexp;
+} regexp_cache_entry_t;
+
 struct _script_ctx_t {
     LONG ref;
 
@@ -435,6 +450,8 @@ struct _script_ctx_t {
     DWORD last_match_index;
     DWORD last_match_length;
 
+    regexp_cache_entry_t regexp_cache[REGEXP_CACHE_SIZE];
+
     jsdisp_t *global;
     jsdisp_t *function_constr;
     jsdisp_t *array_constr;
@@ -491,6 +508,7 @@ struct match_state_t;
 HRESULT regexp_match_next(script_ctx_t*,jsdisp_t*,DWORD,jsstr_t*,struct match_state_t**) DECLSPEC_HIDDEN;
 HRESULT parse_regexp_flags(const WCHAR*,DWORD,DWORD*) DECLSPEC_HIDDEN;
 HRESULT regexp_string_match(script_ctx_t*,jsdisp_t*,jsstr_t*,jsval_t*) DECLSPEC_HIDDEN;
+void release_regexp_cache(script_ctx_t*) DECLSPEC_HIDDEN;
 
 BOOL bool_obj_value(jsdisp_t*) DECLSPEC_HIDDEN;
 unsigned array_get_length(jsdisp_t*) DECLSPEC_HIDDEN;
@@ -544,7 +544,7 @@ static void RegExp_destructor(jsdisp_t *dispex)
     RegExpInstance *This = regexp_from_jsdisp(dispex);
 
     if(This->jsregexp)
-        regexp_destroy(This->jsregexp);
+        regexp_release(This->jsregexp);
     jsval_release(This->last_index_val);
     jsstr_release(This->str);
     heap_free(This);
@@ -610,8 +610,32 @@ static HRESULT alloc_regexp(script_ctx_t *ctx, jsdisp_t *object_prototype, RegEx
     return S_OK;
 }
 
+static regexp_cache_entry_t *get_regexp_cache_entry(script_ctx_t *ctx, const WCHAR *str, unsigned len, DWORD flags)
+{
+    unsigned hash = flags, i;
+
+    for(i = 0; i < len; i++)
+        hash = hash * 31 + str[i];
+    return &ctx->regexp_cache[hash % REGEXP_CACHE_SIZE];
+}
+
+void release_regexp_cache(script_ctx_t *ctx)
+{
+    unsigned i;
+
+    for(i = 0; i < REGEXP_CACHE_SIZE; i++) {
+        if(!ctx->regexp_cache[i].regexp)
+            continue;
+        regexp_release(ctx->regexp_cache[i].regexp);
+        jsstr_release(ctx->regexp_cache[i].src);
+        ctx->regexp_cache[i].regexp = NULL;
+        ctx->regexp_cache[i].src = NULL;
+    }
+}
+
 HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **ret)
 {
+    regexp_cache_entry_t *cache;
     RegExpInstance *regexp;
     const WCHAR *str;
     HRESULT hres;
@@ -626,14 +650,32 @@ HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **r
     if(FAILED(hres))
         return hres;
 
-    regexp->str = jsstr_addref(src);
     regexp->last_index_val = jsval_number(0);
 
-    regexp->jsregexp = regexp_new(ctx, &ctx->tmp_heap, str, jsstr_length(regexp->str), flags, FALSE);
-    if(!regexp->jsregexp) {
-        WARN("regexp_new failed\n");
-        jsdisp_release(&regexp->dispex);
-        return E_FAIL;
+    /*
+     * Compiled regexps are immutable and shared by all objects created from the
+     * same source and flags. The program refers to the source string, so objects
+     * sharing it keep the string it was compiled from.
+     */
+    cache = get_regexp_cache_entry(ctx, str, jsstr_length(src), flags);
+    if(cache->regexp && cache->regexp->flags == flags && jsstr_eq(cache->src, src)) {
+        regexp->str = jsstr_addref(cache->src);
+        regexp->jsregexp = regexp_addref(cache->regexp);
+    }else {
+        regexp->str = jsstr_addref(src);
+        regexp->jsregexp = regexp_new(ctx, &ctx->tmp_heap, str, jsstr_length(regexp->str), flags, FALSE);
+        if(!regexp->jsregexp) {
+            WARN("regexp_new failed\n");
+            jsdisp_release(&regexp->dispex);
+            return E_FAIL;
+        }
+
+        if(cache->regexp) {
+            regexp_release(cache->regexp);
+            jsstr_release(cache->src);
+        }
+        cache->src = jsstr_addref(src);
+        cache->regexp = regexp_addref(regexp->jsregexp);
     }
 
     *ret = &regexp->dispex;
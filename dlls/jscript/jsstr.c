@@ -207,6 +207,56 @@ int jsstr_cmp(jsstr_t *str1, jsstr_t *str2)
     return ropes_cmp(jsstr_as_rope(str1), jsstr_as_rope(str2));
 }
 
+C_ASSERT(sizeof(jsstr_heap_t) <= sizeof(jsstr_rope_t));
+
+static const WCHAR *jsstr_rope_flatten_ext(jsstr_rope_t *str, unsigned extra)
+{
+    unsigned len = jsstr_length(&str->str), capacity;
+    jsstr_t *left = str->left, *right = str->right, *leaf = left;
+    jsstr_rope_t *rope;
+    WCHAR *buf;
+
+    /*
+     * If the leftmost leaf is a heap string with enough room that is referenced only
+     * through this rope, take over its buffer and copy only what follows it.
+     */
+    while(jsstr_is_rope(leaf) && leaf->ref == 1)
+        leaf = jsstr_as_rope(leaf)->left;
+
+    if(jsstr_is_heap(leaf) && leaf->ref == 1 && jsstr_as_heap(leaf)->capacity > len) {
+        buf = jsstr_as_heap(leaf)->buf;
+        capacity = jsstr_as_heap(leaf)->capacity;
+        jsstr_as_heap(leaf)->buf = NULL;
+
+        for(rope = str;; rope = jsstr_as_rope(rope->left)) {
+            jsstr_flush(rope->right, buf+jsstr_length(rope->left));
+            if(rope->left == leaf)
+                break;
+        }
+    }else {
+        capacity = len + 1 + extra;
+        buf = heap_alloc(capacity * sizeof(WCHAR));
+        if(!buf)
+            return NULL;
+
+        jsstr_flush(left, buf);
+        jsstr_flush(right, buf+jsstr_length(left));
+    }
+    buf[len] = 0;
+
+    /* Trasform to heap string */
+    jsstr_release(left);
+    jsstr_release(right);
+    str->str.length_flags |= JSSTR_FLAG_FLAT;
+    jsstr_as_heap(&str->str)->capacity = capacity;
+    return jsstr_as_heap(&str->str)->buf = buf;
+}
+
+const WCHAR *jsstr_rope_flatten(jsstr_rope_t *str)
+{
+    return jsstr_rope_flatten_ext(str, 0);
+}
+
 jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
 {
     unsigned len1, len2;
@@ -225,25 +275,42 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
         unsigned depth, depth2;
         jsstr_rope_t *rope;
 
+        if(len1+len2 > JSSTR_MAX_LENGTH)
+            return NULL;
+
+        /*
+         * Flatten too deep ropes in place instead of copying them into the result. When
+         * the left side is flattened, it's most likely a string being appended to in a loop,
+         * so leave room in the buffer for further appends. Subsequent flattening of the
+         * rope built on top of it will reuse the buffer, which makes repeated appends
+         * linear instead of quadratic.
+         */
         depth = jsstr_is_rope(str1) ? jsstr_as_rope(str1)->depth : 0;
+        if(depth >= JSSTR_MAX_ROPE_DEPTH) {
+            if(!jsstr_rope_flatten_ext(jsstr_as_rope(str1), len1))
+                return NULL;
+            depth = 0;
+        }
+
         depth2 = jsstr_is_rope(str2) ? jsstr_as_rope(str2)->depth : 0;
+        if(depth2 >= JSSTR_MAX_ROPE_DEPTH) {
+            if(!jsstr_rope_flatten(jsstr_as_rope(str2)))
+                return NULL;
+            depth2 = 0;
+        }
+
         if(depth2 > depth)
             depth = depth2;
 
-        if(depth++ < JSSTR_MAX_ROPE_DEPTH) {
-            if(len1+len2 > JSSTR_MAX_LENGTH)
-                return NULL;
+        rope = heap_alloc(sizeof(*rope));
+        if(!rope)
+            return NULL;
 
-            rope = heap_alloc(sizeof(*rope));
-            if(!rope)
-                return NULL;
-
-            jsstr_init(&rope->str, len1+len2, JSSTR_ROPE);
-            rope->left = jsstr_addref(str1);
-            rope->right = jsstr_addref(str2);
-            rope->depth = depth;
-            return &rope->str;
-        }
+        jsstr_init(&rope->str, len1+len2, JSSTR_ROPE);
+        rope->left = jsstr_addref(str1);
+        rope->right = jsstr_addref(str2);
+        rope->depth = depth+1;
+        return &rope->str;
     }
 
     ret = jsstr_alloc_buf(len1+len2, &ptr);
@@ -256,27 +323,6 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
 
 }
 
-C_ASSERT(sizeof(jsstr_heap_t) <= sizeof(jsstr_rope_t));
-
-const WCHAR *jsstr_rope_flatten(jsstr_rope_t *str)
-{
-    WCHAR *buf;
-
-    buf = heap_alloc((jsstr_length(&str->str)+1) * sizeof(WCHAR));
-    if(!buf)
-        return NULL;
-
-    jsstr_flush(str->left, buf);
-    jsstr_flush(str->right, buf+jsstr_length(str->left));
-    buf[jsstr_length(&str->str)] = 0;
-
-    /* Trasform to heap string */
-    jsstr_release(str->left);
-    jsstr_release(str->right);
-    str->str.length_flags |= JSSTR_FLAG_FLAT;
-    return jsstr_as_heap(&str->str)->buf = buf;
-}
-
 static jsstr_t *empty_str, *nan_str, *undefined_str, *null_bstr_str;
 
 jsstr_t *jsstr_nan(void)
@@ -29,7 +29,9 @@
  * is when a rope string becomes a heap stream. That happens when we need a real, linear
  * zero-terminated buffer (a flat buffer). At this point the type of the string is changed
  * and the new buffer is stored in the string, so that subsequent operations requiring
- * a flat string won't need to flatten it again.
+ * a flat string won't need to flatten it again. The buffer of a heap string may be larger
+ * than the string itself, in which case a later flattening of a rope having it as its
+ * leftmost leaf may reuse the buffer instead of copying it.
  *
  * In the future more layouts and transformations may be added.
  */
@@ -85,6 +87,7 @@ typedef struct {
 typedef struct {
     jsstr_t str;
     WCHAR *buf;
+    unsigned capacity;
 } jsstr_heap_t;
 
 typedef struct {
@@ -1912,6 +1912,320 @@ out:
     return result;
 }
 
+/*
+ * Regular expressions without backreferences and lookahead assertions are
+ * also compiled into a Thompson NFA, which is simulated in lock step over
+ * the input (a Pike VM) once the backtracking matcher gets too expensive. The
+ * simulation keeps threads in backtracking priority order and never enters
+ * an NFA state twice at the same input position, so it finds the match and
+ * captures the backtracking matcher would, in time linear in the input
+ * length. For that to hold, no loop may be able to iterate without consuming
+ * input, and parentheses inside loops must be set on every iteration of a
+ * greedy loop, since the backtracking matcher only resets them on some of
+ * the paths. It may still leave captures from failed paths behind where the
+ * simulation correctly reports them as unmatched.
+ */
+enum {
+    NFA_CHAR,       /* consume a character matching match_op */
+    NFA_ASSERT,     /* zero width match_op test */
+    NFA_SPLIT,      /* continue at x, then at y */
+    NFA_JUMP,       /* continue at x */
+    NFA_LPAREN,     /* start of capture arg */
+    NFA_RPAREN,     /* end of capture arg */
+    NFA_MATCH
+};
+
+typedef struct RENfaInst {
+    BYTE op;
+    BYTE match_op;                  /* REOp for NFA_CHAR and NFA_ASSERT */
+    UINT arg;                       /* character, class or paren index */
+    UINT x, y;                      /* branch targets */
+} RENfaInst;
+
+struct RENfaProgram {
+    UINT count;
+    RENfaInst insts[1];
+};
+
+#define NFA_MAX_INSTS   4096
+#define NFA_MAX_DEPTH   256
+
+typedef struct NfaCompiler {
+    CompilerState *state;
+    RENfaInst *insts;
+    UINT count;
+    UINT size;
+} NfaCompiler;
+
+static BOOL NfaEmitList(NfaCompiler *nc, RENode *t);
+
+/* Can the node list at t match without consuming any input? */
+static BOOL
+NfaIsNullable(RENode *t)
+{
+    for (; t; t = t->next) {
+        switch (t->op) {
+          case REOP_EMPTY:
+          case REOP_BOL:
+          case REOP_EOL:
+          case REOP_WBDRY:
+          case REOP_WNONBDRY:
+          case REOP_BACKREF:
+          case REOP_ASSERT:
+          case REOP_ASSERT_NOT:
+            break;
+          case REOP_LPAREN:
+            if (!NfaIsNullable(t->kid))
+                return FALSE;
+            break;
+          case REOP_ALT:
+          case REOP_ALTPREREQ:
+          case REOP_ALTPREREQ2:
+            if (!NfaIsNullable(t->kid) && !NfaIsNullable(t->u.kid2))
+                return FALSE;
+            break;
+          case REOP_QUANT:
+            if (t->u.range.min && !NfaIsNullable(t->kid))
+                return FALSE;
+            break;
+          default:
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Check whether the node list at t can be simulated by the NFA. in_loop is
+ * set inside quantifiers that may iterate more than once, cond once a path
+ * from such a quantifier goes through an alternative or an optional term,
+ * or the quantifier is non-greedy.
+ */
+static BOOL
+NfaIsSupported(RENode *t, BOOL in_loop, BOOL cond, UINT depth)
+{
+    if (depth > NFA_MAX_DEPTH)
+        return FALSE;
+
+    for (; t; t = t->next) {
+        switch (t->op) {
+          case REOP_EMPTY:
+          case REOP_BOL:
+          case REOP_EOL:
+          case REOP_WBDRY:
+          case REOP_WNONBDRY:
+          case REOP_DOT:
+          case REOP_DIGIT:
+          case REOP_NONDIGIT:
+          case REOP_ALNUM:
+          case REOP_NONALNUM:
+          case REOP_SPACE:
+          case REOP_NONSPACE:
+          case REOP_FLAT:
+          case REOP_CLASS:
+            break;
+          case REOP_LPAREN:
+            if (in_loop && cond)
+                return FALSE;
+            if (!NfaIsSupported(t->kid, in_loop, cond, depth + 1))
+                return FALSE;
+            break;
+          case REOP_ALT:
+          case REOP_ALTPREREQ:
+          case REOP_ALTPREREQ2:
+            if (!NfaIsSupported(t->kid, in_loop, cond || in_loop, depth + 1) ||
+                !NfaIsSupported(t->u.kid2, in_loop, cond || in_loop, depth + 1))
+                return FALSE;
+            break;
+          case REOP_QUANT:
+            if (!t->u.range.max)
+                break;
+            if (!NfaIsSupported(t->kid, in_loop || t->u.range.max > 1,
+                                cond || (in_loop && !t->u.range.min) ||
+                                (t->u.range.max > 1 && !t->u.range.greedy), depth + 1))
+                return FALSE;
+            /* Checked after the kid, which limits the recursion depth. */
+            if (NfaIsNullable(t->kid))
+                return FALSE;
+            break;
+          default:
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static BOOL
+NfaEmit(NfaCompiler *nc, BYTE op, BYTE match_op, UINT arg)
+{
+    RENfaInst *inst;
+
+    if (nc->count == nc->size) {
+        RENfaInst *tmp;
+        UINT size;
+
+        if (nc->size == NFA_MAX_INSTS)
+            return FALSE;
+        size = min(nc->size * 2, NFA_MAX_INSTS);
+        tmp = heap_realloc(nc->insts, size * sizeof(RENfaInst));
+        if (!tmp)
+            return FALSE;
+        nc->insts = tmp;
+        nc->size = size;
+    }
+
+    inst = &nc->insts[nc->count++];
+    inst->op = op;
+    inst->match_op = match_op;
+    inst->arg = arg;
+    inst->x = inst->y = 0;
+    return TRUE;
+}
+
+static BOOL
+NfaEmitQuant(NfaCompiler *nc, RENode *t)
+{
+    UINT i, split, chain = (UINT)-1;
+    BOOL greedy = t->u.range.greedy;
+
+    for (i = 0; i < t->u.range.min; i++) {
+        if (!NfaEmitList(nc, t->kid))
+            return FALSE;
+    }
+
+    if (t->u.range.max == (UINT)-1) {
+        split = nc->count;
+        if (!NfaEmit(nc, NFA_SPLIT, 0, 0) || !NfaEmitList(nc, t->kid) ||
+            !NfaEmit(nc, NFA_JUMP, 0, 0))
+            return FALSE;
+        nc->insts[nc->count - 1].x = split;
+        nc->insts[split].x = greedy ? split + 1 : nc->count;
+        nc->insts[split].y = greedy ? nc->count : split + 1;
+        return TRUE;
+    }
+
+    /* Optional iterations are nested, all of them exit to the same place. */
+    for (; i < t->u.range.max; i++) {
+        split = nc->count;
+        if (!NfaEmit(nc, NFA_SPLIT, 0, 0))
+            return FALSE;
+        nc->insts[split].arg = chain;
+        chain = split;
+        if (!NfaEmitList(nc, t->kid))
+            return FALSE;
+    }
+    while (chain != (UINT)-1) {
+        split = chain;
+        chain = nc->insts[split].arg;
+        nc->insts[split].x = greedy ? split + 1 : nc->count;
+        nc->insts[split].y = greedy ? nc->count : split + 1;
+    }
+    return TRUE;
+}
+
+static BOOL
+NfaEmitList(NfaCompiler *nc, RENode *t)
+{
+    BYTE match_op;
+    UINT i, split, jump;
+
+    for (; t; t = t->next) {
+        switch (t->op) {
+          case REOP_EMPTY:
+            break;
+          case REOP_BOL:
+          case REOP_EOL:
+          case REOP_WBDRY:
+          case REOP_WNONBDRY:
+            if (!NfaEmit(nc, NFA_ASSERT, t->op, 0))
+                return FALSE;
+            break;
+          case REOP_DOT:
+          case REOP_DIGIT:
+          case REOP_NONDIGIT:
+          case REOP_ALNUM:
+          case REOP_NONALNUM:
+          case REOP_SPACE:
+          case REOP_NONSPACE:
+            if (!NfaEmit(nc, NFA_CHAR, t->op, 0))
+                return FALSE;
+            break;
+          case REOP_FLAT:
+            match_op = (nc->state->flags & REG_FOLD) ? REOP_FLAT1i : REOP_FLAT1;
+            if (t->kid && t->u.flat.length > 1) {
+                for (i = 0; i < t->u.flat.length; i++) {
+                    if (!NfaEmit(nc, NFA_CHAR, match_op, ((WCHAR*)t->kid)[i]))
+                        return FALSE;
+                }
+            } else if (!NfaEmit(nc, NFA_CHAR, match_op, t->u.flat.chr)) {
+                return FALSE;
+            }
+            break;
+          case REOP_CLASS:
+            if (!NfaEmit(nc, NFA_CHAR, t->u.ucclass.sense ? REOP_CLASS : REOP_NCLASS,
+                         t->u.ucclass.index))
+                return FALSE;
+            break;
+          case REOP_LPAREN:
+            if (!NfaEmit(nc, NFA_LPAREN, 0, t->u.parenIndex) ||
+                !NfaEmitList(nc, t->kid) ||
+                !NfaEmit(nc, NFA_RPAREN, 0, t->u.parenIndex))
+                return FALSE;
+            break;
+          case REOP_ALT:
+          case REOP_ALTPREREQ:
+          case REOP_ALTPREREQ2:
+            split = nc->count;
+            if (!NfaEmit(nc, NFA_SPLIT, 0, 0) || !NfaEmitList(nc, t->kid))
+                return FALSE;
+            jump = nc->count;
+            if (!NfaEmit(nc, NFA_JUMP, 0, 0) || !NfaEmitList(nc, t->u.kid2))
+                return FALSE;
+            nc->insts[split].x = split + 1;
+            nc->insts[split].y = jump + 1;
+            nc->insts[jump].x = nc->count;
+            break;
+          case REOP_QUANT:
+            if (!NfaEmitQuant(nc, t))
+                return FALSE;
+            break;
+          default:
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static RENfaProgram *
+CompileNfa(CompilerState *state)
+{
+    RENfaProgram *prog = NULL;
+    NfaCompiler nc;
+
+    if (!NfaIsSupported(state->result, FALSE, FALSE, 0))
+        return NULL;
+
+    nc.state = state;
+    nc.count = 0;
+    nc.size = 64;
+    nc.insts = heap_alloc(nc.size * sizeof(RENfaInst));
+    if (!nc.insts)
+        return NULL;
+
+    if (NfaEmitList(&nc, state->result) && NfaEmit(&nc, NFA_MATCH, 0, 0)) {
+        prog = heap_alloc(offsetof(RENfaProgram, insts) + nc.count * sizeof(RENfaInst));
+        if (prog) {
+            prog->count = nc.count;
+            memcpy(prog->insts, nc.insts, nc.count * sizeof(RENfaInst));
+        }
+    } else {
+        TRACE("regexp not compiled to NFA\n");
+    }
+
+    heap_free(nc.insts);
+    return prog;
+}
+
 /*
  * Save the current state of the match - the position in the input
  * text as well as the position in the bytecode. The state of any
@@ -3070,6 +3384,242 @@ good:
     return x;
 }
 
+static BOOL
+NfaCharMatch(REGlobalData *gData, const RENfaInst *inst, WCHAR ch)
+{
+    RECharSet *charSet;
+
+    switch (inst->match_op) {
+      case REOP_DOT:
+        return !RE_IS_LINE_TERM(ch);
+      case REOP_DIGIT:
+        return JS7_ISDEC(ch);
+      case REOP_NONDIGIT:
+        return !JS7_ISDEC(ch);
+      case REOP_ALNUM:
+        return JS_ISWORD(ch);
+      case REOP_NONALNUM:
+        return !JS_ISWORD(ch);
+      case REOP_SPACE:
+        return iswspace(ch);
+      case REOP_NONSPACE:
+        return !iswspace(ch);
+      case REOP_FLAT1:
+        return ch == inst->arg;
+      case REOP_FLAT1i:
+        return towupper(ch) == towupper(inst->arg);
+      case REOP_CLASS:
+      case REOP_NCLASS:
+        charSet = &gData->regexp->classList[inst->arg];
+        assert(charSet->converted);
+        return (charSet->length != 0 && ch <= charSet->length &&
+                (charSet->u.bits[ch >> 3] & (1 << (ch & 0x7)))) ^
+               (inst->match_op == REOP_NCLASS);
+      default:
+        assert(FALSE);
+        return FALSE;
+    }
+}
+
+static BOOL
+NfaAssertMatch(REGlobalData *gData, const RENfaInst *inst, const WCHAR *cp)
+{
+    BOOL before, after;
+
+    switch (inst->match_op) {
+      case REOP_BOL:
+        return cp == gData->cpbegin ||
+               ((gData->regexp->flags & REG_MULTILINE) && RE_IS_LINE_TERM(cp[-1]));
+      case REOP_EOL:
+        return cp == gData->cpend ||
+               ((gData->regexp->flags & REG_MULTILINE) && RE_IS_LINE_TERM(*cp));
+      case REOP_WBDRY:
+      case REOP_WNONBDRY:
+        before = cp != gData->cpbegin && JS_ISWORD(cp[-1]);
+        after = cp != gData->cpend && JS_ISWORD(*cp);
+        return (before != after) == (inst->match_op == REOP_WBDRY);
+      default:
+        assert(FALSE);
+        return FALSE;
+    }
+}
+
+typedef struct NfaThreadList {
+    UINT gen;                       /* visited mark of this position */
+    UINT count;
+    UINT *pcs;
+    RECapture *caps;                /* parenCount + 1 captures per thread */
+} NfaThreadList;
+
+typedef struct NfaStackEntry {
+    UINT pc;
+    UINT parenIndex;                /* capture to restore, or (UINT)-1 */
+    RECapture cap;
+} NfaStackEntry;
+
+typedef struct NfaState {
+    RENfaProgram *prog;
+    size_t capCount;
+    UINT *visited;
+    NfaStackEntry *stack;
+    RECapture *caps;                /* captures of the thread being added */
+} NfaState;
+
+/*
+ * Add a thread at pc to list, following jumps, splits, captures and
+ * assertions in priority order. States already visited at this position
+ * belong to higher priority threads and are skipped.
+ */
+static void
+NfaAddThread(REGlobalData *gData, NfaState *ns, NfaThreadList *list,
+             UINT pc, const WCHAR *cp)
+{
+    NfaStackEntry *sp = ns->stack;
+    RENfaInst *inst;
+    RECapture *cap;
+
+    sp->pc = pc;
+    sp->parenIndex = (UINT)-1;
+    sp++;
+
+    while (sp != ns->stack) {
+        sp--;
+        if (sp->parenIndex != (UINT)-1) {
+            ns->caps[sp->parenIndex] = sp->cap;
+            continue;
+        }
+
+        pc = sp->pc;
+        while (ns->visited[pc] != list->gen) {
+            ns->visited[pc] = list->gen;
+            inst = &ns->prog->insts[pc];
+            switch (inst->op) {
+              case NFA_JUMP:
+                pc = inst->x;
+                continue;
+              case NFA_SPLIT:
+                sp->pc = inst->y;
+                sp->parenIndex = (UINT)-1;
+                sp++;
+                pc = inst->x;
+                continue;
+              case NFA_LPAREN:
+              case NFA_RPAREN:
+                cap = &ns->caps[inst->arg];
+                sp->parenIndex = inst->arg;
+                sp->cap = *cap;
+                sp++;
+                if (inst->op == NFA_LPAREN) {
+                    cap->index = cp - gData->cpbegin;
+                    cap->length = 0;
+                } else {
+                    ptrdiff_t delta = cp - (gData->cpbegin + cap->index);
+                    cap->length = (delta < 0) ? 0 : (size_t) delta;
+                }
+                pc++;
+                continue;
+              case NFA_ASSERT:
+                if (!NfaAssertMatch(gData, inst, cp))
+                    break;
+                pc++;
+                continue;
+              default:
+                list->pcs[list->count] = pc;
+                memcpy(&list->caps[list->count * ns->capCount], ns->caps,
+                       ns->capCount * sizeof(RECapture));
+                list->count++;
+                break;
+            }
+            break;
+        }
+    }
+}
+
+/*
+ * Find the leftmost match starting at or after x->cp by simulating the NFA.
+ * Threads started at later positions are added with the lowest priority,
+ * and once a thread matches all lower priority threads are dropped.
+ */
+static match_state_t *
+NfaMatchRegExp(REGlobalData *gData, match_state_t *x)
+{
+    RENfaProgram *prog = gData->regexp->nfa;
+    size_t parenCount = gData->regexp->parenCount;
+    NfaThreadList lists[2], *clist = &lists[0], *nlist = &lists[1], *tmp;
+    const WCHAR *cp, *start = x->cp, *matchEnd = NULL;
+    RECapture *matchCaps, *caps;
+    NfaState ns;
+    RENfaInst *inst;
+    UINT gen = 0, i;
+    size_t j;
+
+    ns.prog = prog;
+    ns.capCount = parenCount + 1;
+    ns.visited = heap_pool_alloc(gData->pool, prog->count * sizeof(UINT));
+    ns.stack = heap_pool_alloc(gData->pool, (prog->count + 1) * sizeof(NfaStackEntry));
+    ns.caps = heap_pool_alloc(gData->pool, ns.capCount * sizeof(RECapture));
+    matchCaps = heap_pool_alloc(gData->pool, ns.capCount * sizeof(RECapture));
+    for (i = 0; i < 2; i++) {
+        lists[i].pcs = heap_pool_alloc(gData->pool, prog->count * sizeof(UINT));
+        lists[i].caps = heap_pool_alloc(gData->pool,
+                                        prog->count * ns.capCount * sizeof(RECapture));
+        if (!lists[i].pcs || !lists[i].caps)
+            goto oom;
+    }
+    if (!ns.visited || !ns.stack || !ns.caps || !matchCaps)
+        goto oom;
+    memset(ns.visited, 0, prog->count * sizeof(UINT));
+
+    clist->gen = ++gen;
+    clist->count = 0;
+    for (cp = start; ; cp++) {
+        if (!matchEnd && (cp == start || !(gData->regexp->flags & REG_STICKY))) {
+            for (j = 0; j < parenCount; j++) {
+                ns.caps[j].index = -1;
+                ns.caps[j].length = 0;
+            }
+            ns.caps[parenCount].index = cp - gData->cpbegin;
+            NfaAddThread(gData, &ns, clist, 0, cp);
+        }
+
+        nlist->gen = ++gen;
+        nlist->count = 0;
+        for (i = 0; i < clist->count; i++) {
+            inst = &prog->insts[clist->pcs[i]];
+            caps = &clist->caps[i * ns.capCount];
+            if (inst->op == NFA_MATCH) {
+                memcpy(matchCaps, caps, ns.capCount * sizeof(RECapture));
+                matchEnd = cp;
+                break;
+            }
+            if (cp != gData->cpend && NfaCharMatch(gData, inst, *cp)) {
+                memcpy(ns.caps, caps, ns.capCount * sizeof(RECapture));
+                NfaAddThread(gData, &ns, nlist, clist->pcs[i] + 1, cp + 1);
+            }
+        }
+
+        if (cp == gData->cpend ||
+            (!nlist->count && (matchEnd || (gData->regexp->flags & REG_STICKY))))
+            break;
+        tmp = clist;
+        clist = nlist;
+        nlist = tmp;
+    }
+
+    if (!matchEnd)
+        return NULL;
+
+    memcpy(x->parens, matchCaps, parenCount * sizeof(RECapture));
+    gData->skipped = matchCaps[parenCount].index - (start - gData->cpbegin);
+    x->cp = matchEnd;
+    return x;
+
+oom:
+    js_ReportOutOfScriptQuota(gData->cx);
+    gData->ok = FALSE;
+    return NULL;
+}
+
 static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
 {
     match_state_t *result;
@@ -3077,6 +3627,13 @@ static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
     const WCHAR *cp2;
     UINT j;
 
+    /*
+     * Let the backtracking matcher spend about as much as the NFA simulation
+     * would need in the worst case, then switch to the simulation.
+     */
+    if (gData->regexp->nfa)
+        gData->backTrackLimit = (gData->cpend - cp + 1) * gData->regexp->nfa->count;
+
     /*
      * Have to include the position beyond the last character
      * in order to detect end-of-input/line condition.
@@ -3087,6 +3644,13 @@ static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
         for (j = 0; j < gData->regexp->parenCount; j++)
             x->parens[j].index = -1;
         result = ExecuteREBytecode(gData, x);
+        if (!gData->ok && gData->regexp->nfa &&
+            gData->backTrackCount >= gData->backTrackLimit) {
+            TRACE("switching to NFA simulation\n");
+            gData->ok = TRUE;
+            x->cp = cp;
+            return NfaMatchRegExp(gData, x);
+        }
         if (!gData->ok || result || (gData->regexp->flags & REG_STICKY))
             return result;
         gData->backTrackSP = gData->backTrackStack;
@@ -3178,8 +3742,11 @@ HRESULT regexp_execute(regexp_t *regexp, void *cx, heap_pool_t *pool,
     return S_OK;
 }
 
-void regexp_destroy(regexp_t *re)
+void regexp_release(regexp_t *re)
 {
+    if (--re->ref)
+        return;
+
     if (re->classList) {
         UINT i;
         for (i = 0; i < re->classCount; i++) {
@@ -3189,6 +3756,7 @@ void regexp_destroy(regexp_t *re)
         }
         heap_free(re->classList);
     }
+    heap_free(re->nfa);
     heap_free(re);
 }
 
@@ -3241,13 +3809,15 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     re = heap_alloc(resize);
     if (!re)
         goto out;
+    re->ref = 1;
+    re->nfa = NULL;
 
     assert(state.classBitmapsMem <= CLASS_BITMAPS_MEM_LIMIT);
     re->classCount = state.classCount;
     if (re->classCount) {
         re->classList = heap_alloc(re->classCount * sizeof(RECharSet));
         if (!re->classList) {
-            regexp_destroy(re);
+            regexp_release(re);
             re = NULL;
             goto out;
         }
@@ -3258,7 +3828,7 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     }
     endPC = EmitREBytecode(&state, re, state.treeDepth, re->program, state.result);
     if (!endPC) {
-        regexp_destroy(re);
+        regexp_release(re);
         re = NULL;
         goto out;
     }
@@ -3281,6 +3851,8 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     re->parenCount = state.parenCount;
     re->source = str;
     re->source_len = str_len;
+    if (!flat)
+        re->nfa = CompileNfa(&state);
 
 out:
     heap_pool_clear(mark);
@@ -1973,6 +1973,55 @@ ok(ActiveXObject === 1, "ActiveXObject = " + ActiveXObject);
 Boolean = 1;
 ok(Boolean === 1, "Boolean = " + Boolean);
 
+function test_member_cache() {
+    var objs = [{x: 1}, {y: 2, x: 3}, {}], i, r = "";
+
+    for(i = 0; i < 6; i++) {
+        r += objs[i % 3].x + ",";
+        if(i == 2)
+            delete objs[0].x;
+        if(i == 3)
+            objs[2].x = 4;
+    }
+    ok(r === "1,3,undefined,undefined,3,4,", "r = " + r);
+}
+test_member_cache();
+
+function test_fused_loops() {
+    var i, n = 0, s = "";
+
+    for(i = 0; i < 5; i++) n++;
+    ok(i === 5 && n === 5, "i = " + i + ", n = " + n);
+    for(i = 5; i >= 0; i--) n--;
+    ok(i === -1 && n === -1, "i = " + i + ", n = " + n);
+    for(i = "a"; i <= "c"; i = String.fromCharCode(i.charCodeAt(0) + 1)) s += i;
+    ok(s === "abc", "s = " + s);
+    i = "3";
+    i++;
+    ok(i === 4, "i = " + i);
+    i = NaN;
+    ok(!(i < 1) && !(i >= 1), "NaN comparison succeeded");
+    while(i > 0 || i <= 0) n++;
+    ok(n === -1, "n = " + n);
+}
+test_fused_loops();
+
+function test_string_append() {
+    var s = "", snap, i;
+
+    for(i = 0; i < 1000; i++) {
+        s += "ab";
+        if(i == 500)
+            snap = s;
+    }
+    ok(s.length === 2000, "s.length = " + s.length);
+    ok(s.substr(1996) === "abab", "s.substr(1996) = " + s.substr(1996));
+    ok(snap.length === 1002, "snap.length = " + snap.length);
+    ok(snap.substr(998) === "abab", "snap.substr(998) = " + snap.substr(998));
+    ok(s.indexOf("ba", 1990) === 1991, "s.indexOf(\"ba\", 1990) = " + s.indexOf("ba", 1990));
+}
+test_string_append();
+
 Object = 1;
 ok(Object === 1, "Object = " + Object);
 
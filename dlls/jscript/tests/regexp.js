@@ -713,4 +713,24 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+tmp = new Array(41).join("a");
+m = /(a+)+b/.exec(tmp);
+ok(m === null, "m = " + m);
+m = /(a|aa)+(b?)$/.exec(tmp + "b");
+ok(m.index === 0, "m.index = " + m.index);
+ok(m.length === 3, "m.length = " + m.length);
+ok(m[1] === "a", "m[1] = " + m[1]);
+ok(m[2] === "b", "m[2] = " + m[2]);
+m = /(\w+\s?)+!$/.exec("x" + tmp + " " + tmp + "!");
+ok(m.index === 0, "m.index = " + m.index);
+ok(m[1] === tmp, "m[1] = " + m[1]);
+
+for(i = 0; i < 2; i++) {
+    re = /a+/g;
+    ok(re.lastIndex === 0, "re.lastIndex = " + re.lastIndex);
+    m = re.exec(" aabaaa");
+    ok(m[0] === "aa", "m[0] = " + m[0]);
+    ok(re.lastIndex === 3, "re.lastIndex = " + re.lastIndex);
+}
+
 reportSuccess();
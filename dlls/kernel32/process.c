@@ -679,9 +679,13 @@ BOOL WINAPI SetFirmwareEnvironmentVariableW(const WCHAR *name, const WCHAR *guid
  */
 BOOL WINAPI GetNumaNodeProcessorMask(UCHAR node, PULONGLONG mask)
 {
-    FIXME("(%c %p): stub\n", node, mask);
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    GROUP_AFFINITY affinity;
+
+    TRACE("(%u %p)\n", node, mask);
+
+    if (!GetNumaNodeProcessorMaskEx(node, &affinity)) return FALSE;
+    *mask = affinity.Group ? 0 : affinity.Mask;
+    return TRUE;
 }
 
 /**********************************************************************
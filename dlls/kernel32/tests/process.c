@@ -78,6 +78,8 @@ static BOOL   (WINAPI *pQueryInformationJobObject)(HANDLE job, JOBOBJECTINFOCLAS
 static BOOL   (WINAPI *pSetInformationJobObject)(HANDLE job, JOBOBJECTINFOCLASS class, LPVOID info, DWORD len);
 static HANDLE (WINAPI *pCreateIoCompletionPort)(HANDLE file, HANDLE existing_port, ULONG_PTR key, DWORD threads);
 static BOOL   (WINAPI *pGetNumaProcessorNode)(UCHAR, PUCHAR);
+static BOOL   (WINAPI *pGetNumaHighestNodeNumber)(ULONG *);
+static BOOL   (WINAPI *pGetNumaNodeProcessorMaskEx)(USHORT, GROUP_AFFINITY *);
 static NTSTATUS (WINAPI *pNtQueryInformationProcess)(HANDLE, PROCESSINFOCLASS, PVOID, ULONG, PULONG);
 static NTSTATUS (WINAPI *pNtQuerySystemInformationEx)(SYSTEM_INFORMATION_CLASS, void*, ULONG, void*, ULONG, ULONG*);
 static DWORD  (WINAPI *pWTSGetActiveConsoleSessionId)(void);
@@ -264,6 +266,8 @@ static BOOL init(void)
     pSetInformationJobObject = (void *)GetProcAddress(hkernel32, "SetInformationJobObject");
     pCreateIoCompletionPort = (void *)GetProcAddress(hkernel32, "CreateIoCompletionPort");
     pGetNumaProcessorNode = (void *)GetProcAddress(hkernel32, "GetNumaProcessorNode");
+    pGetNumaHighestNodeNumber = (void *)GetProcAddress(hkernel32, "GetNumaHighestNodeNumber");
+    pGetNumaNodeProcessorMaskEx = (void *)GetProcAddress(hkernel32, "GetNumaNodeProcessorMaskEx");
     pWTSGetActiveConsoleSessionId = (void *)GetProcAddress(hkernel32, "WTSGetActiveConsoleSessionId");
     pCreateToolhelp32Snapshot = (void *)GetProcAddress(hkernel32, "CreateToolhelp32Snapshot");
     pProcess32First = (void *)GetProcAddress(hkernel32, "Process32First");
@@ -3633,6 +3637,40 @@ static void test_GetNumaProcessorNode(void)
     }
 }
 
+static void test_GetNumaNodeProcessorMask(void)
+{
+    GROUP_AFFINITY affinity;
+    ULONGLONG mask;
+    ULONG highest;
+    BOOL ret;
+
+    if (!pGetNumaHighestNodeNumber || !pGetNumaNodeProcessorMaskEx)
+    {
+        win_skip("GetNumaHighestNodeNumber or GetNumaNodeProcessorMaskEx is missing\n");
+        return;
+    }
+
+    highest = 0xdeadbeef;
+    ret = pGetNumaHighestNodeNumber(&highest);
+    ok(ret, "GetNumaHighestNodeNumber failed, error %u\n", GetLastError());
+    ok(highest < 0x10000, "got highest node %u\n", highest);
+
+    memset(&affinity, 0xcc, sizeof(affinity));
+    ret = pGetNumaNodeProcessorMaskEx(0, &affinity);
+    ok(ret, "GetNumaNodeProcessorMaskEx failed, error %u\n", GetLastError());
+    ok(affinity.Mask != 0, "got empty mask\n");
+
+    mask = 0;
+    ret = GetNumaNodeProcessorMask(0, &mask);
+    ok(ret, "GetNumaNodeProcessorMask failed, error %u\n", GetLastError());
+    ok(mask == (affinity.Group ? 0 : affinity.Mask), "got mask %s\n", wine_dbgstr_longlong(mask));
+
+    SetLastError(0xdeadbeef);
+    ret = pGetNumaNodeProcessorMaskEx(highest + 1, &affinity);
+    ok(!ret, "GetNumaNodeProcessorMaskEx succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError());
+}
+
 static void test_session_info(void)
 {
     DWORD session_id, active_session;
@@ -4400,6 +4438,7 @@ START_TEST(process)
     test_DetachConsoleHandles();
     test_DetachStdHandles();
     test_GetNumaProcessorNode();
+    test_GetNumaNodeProcessorMask();
     test_session_info();
     test_GetLogicalProcessorInformationEx();
     test_GetSystemCpuSetInformation();
@@ -491,29 +491,53 @@ BOOL WINAPI DECLSPEC_HOTPATCH AreFileApisANSI(void)
 }
 
 
+/* report copy progress, returns FALSE if the copy has to be aborted */
+static BOOL copy_file_progress( LPPROGRESS_ROUTINE *progress, void *param, LARGE_INTEGER size,
+                                LARGE_INTEGER transferred, DWORD reason, HANDLE h1, HANDLE h2,
+                                BOOL can_delete )
+{
+    FILE_DISPOSITION_INFORMATION info = { TRUE };
+    IO_STATUS_BLOCK io;
+
+    if (!*progress) return TRUE;
+
+    switch ((*progress)( size, transferred, size, transferred, 1, reason, h1, h2, param ))
+    {
+    case PROGRESS_CONTINUE:
+        return TRUE;
+    case PROGRESS_QUIET:
+        *progress = NULL;
+        return TRUE;
+    case PROGRESS_CANCEL:
+        if (can_delete) NtSetInformationFile( h2, &io, &info, sizeof(info), FileDispositionInformation );
+        /* fall through */
+    default:
+        SetLastError( ERROR_REQUEST_ABORTED );
+        return FALSE;
+    }
+}
+
+
 /***********************************************************************
  *	CopyFileExW   (kernelbase.@)
  */
 BOOL WINAPI CopyFileExW( const WCHAR *source, const WCHAR *dest, LPPROGRESS_ROUTINE progress,
                          void *param, BOOL *cancel_ptr, DWORD flags )
 {
-    static const int buffer_size = 65536;
+    static const DWORD buffer_size = 0x100000;
+    static const LONGLONG chunk_size = 0x4000000;
     HANDLE h1, h2;
     BY_HANDLE_FILE_INFORMATION info;
-    DWORD count;
-    BOOL ret = FALSE;
-    char *buffer;
+    LARGE_INTEGER size, transferred;
+    DWORD count, access = GENERIC_WRITE | DELETE;
+    BOOL ret = FALSE, use_fsctl = TRUE;
+    char *buffer = NULL;
 
     if (!source || !dest)
     {
         SetLastError( ERROR_INVALID_PARAMETER );
         return FALSE;
     }
-    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size )))
-    {
-        SetLastError( ERROR_NOT_ENOUGH_MEMORY );
-        return FALSE;
-    }
 
     TRACE("%s -> %s, %x\n", debugstr_w(source), debugstr_w(dest), flags);
 
@@ -521,14 +545,12 @@ BOOL WINAPI CopyFileExW( const WCHAR *source, const WCHAR *dest, LPPROGRESS_ROUT
                            NULL, OPEN_EXISTING, 0, 0 )) == INVALID_HANDLE_VALUE)
     {
         WARN("Unable to open source %s\n", debugstr_w(source));
-        HeapFree( GetProcessHeap(), 0, buffer );
         return FALSE;
     }
 
     if (!GetFileInformationByHandle( h1, &info ))
     {
         WARN("GetFileInformationByHandle returned error for %s\n", debugstr_w(source));
-        HeapFree( GetProcessHeap(), 0, buffer );
         CloseHandle( h1 );
         return FALSE;
     }
@@ -544,33 +566,98 @@ BOOL WINAPI CopyFileExW( const WCHAR *source, const WCHAR *dest, LPPROGRESS_ROUT
         }
         if (same_file)
         {
-            HeapFree( GetProcessHeap(), 0, buffer );
             CloseHandle( h1 );
             SetLastError( ERROR_SHARING_VIOLATION );
             return FALSE;
         }
     }
 
-    if ((h2 = CreateFileW( dest, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
-                           (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
-                           info.dwFileAttributes, h1 )) == INVALID_HANDLE_VALUE)
+    /* delete access is only needed to remove the destination on cancel,
+     * so don't fail if somebody else has it open without sharing delete */
+    h2 = CreateFileW( dest, access, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                      (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
+                      info.dwFileAttributes, h1 );
+    if (h2 == INVALID_HANDLE_VALUE && GetLastError() == ERROR_SHARING_VIOLATION)
+    {
+        access = GENERIC_WRITE;
+        h2 = CreateFileW( dest, access, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                          (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
+                          info.dwFileAttributes, h1 );
+    }
+    if (h2 == INVALID_HANDLE_VALUE)
     {
         WARN("Unable to open dest %s\n", debugstr_w(dest));
-        HeapFree( GetProcessHeap(), 0, buffer );
         CloseHandle( h1 );
         return FALSE;
     }
 
-    while (ReadFile( h1, buffer, buffer_size, &count, NULL ) && count)
+    size.u.LowPart = info.nFileSizeLow;
+    size.u.HighPart = info.nFileSizeHigh;
+    transferred.QuadPart = 0;
+
+    if (!copy_file_progress( &progress, param, size, transferred, CALLBACK_STREAM_SWITCH,
+                             h1, h2, access & DELETE ))
+        goto done;
+
+    for (;;)
     {
-        char *p = buffer;
-        while (count != 0)
+        if (cancel_ptr && *cancel_ptr)
         {
-            DWORD res;
-            if (!WriteFile( h2, p, count, &res, NULL ) || !res) goto done;
-            p += res;
-            count -= res;
+            SetLastError( ERROR_REQUEST_ABORTED );
+            goto done;
+        }
+
+        if (use_fsctl)
+        {
+            /* let the file system copy the data, sharing extents if possible */
+            DUPLICATE_EXTENTS_DATA data;
+            IO_STATUS_BLOCK io;
+
+            if (transferred.QuadPart >= size.QuadPart) break;
+
+            data.FileHandle = h1;
+            data.SourceFileOffset = transferred;
+            data.TargetFileOffset = transferred;
+            data.ByteCount.QuadPart = min( size.QuadPart - transferred.QuadPart, chunk_size );
+            if (NtFsControlFile( h2, NULL, NULL, NULL, &io, FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+                                 &data, sizeof(data), NULL, 0 ))
+            {
+                TRACE( "falling back to read/write at offset %s\n",
+                       wine_dbgstr_longlong( transferred.QuadPart ));
+                use_fsctl = FALSE;
+                if (!SetFilePointerEx( h1, transferred, NULL, FILE_BEGIN ) ||
+                    !SetFilePointerEx( h2, transferred, NULL, FILE_BEGIN ))
+                    goto done;
+                continue;
+            }
+            transferred.QuadPart += data.ByteCount.QuadPart;
         }
+        else
+        {
+            char *p;
+
+            if (!buffer && !(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size )))
+            {
+                SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+                goto done;
+            }
+            if (!ReadFile( h1, buffer, buffer_size, &count, NULL )) goto done;
+            if (!count) break;
+
+            transferred.QuadPart += count;
+            p = buffer;
+            while (count != 0)
+            {
+                DWORD res;
+                if (!WriteFile( h2, p, count, &res, NULL ) || !res) goto done;
+                p += res;
+                count -= res;
+            }
+        }
+
+        if (!copy_file_progress( &progress, param, size, transferred, CALLBACK_CHUNK_FINISHED,
+                                 h1, h2, access & DELETE ))
+            goto done;
     }
     ret =  TRUE;
 done:
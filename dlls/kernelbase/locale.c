@@ -2481,6 +2481,21 @@ static unsigned int get_weight( WCHAR ch, enum weight type )
 }
 
 
+static inline const WCHAR *get_compare_decomposition( const WCHAR *str, unsigned int *len )
+{
+    const WCHAR *ret;
+
+    /* ASCII characters don't have a decomposition, skip the hash lookup */
+    if (*str < 0x80)
+    {
+        *len = 1;
+        return str;
+    }
+    if (!(ret = get_decomposition( *str, len ))) ret = str;
+    return ret;
+}
+
+
 static void inc_str_pos( const WCHAR **str, int *len, unsigned int *dpos, unsigned int *dlen )
 {
     (*dpos)++;
@@ -2501,8 +2516,8 @@ static int compare_weights(int flags, const WCHAR *str1, int len1,
 
     while (len1 > 0 && len2 > 0)
     {
-        if (!dlen1 && !(dstr1 = get_decomposition( *str1, &dlen1 ))) dstr1 = str1;
-        if (!dlen2 && !(dstr2 = get_decomposition( *str2, &dlen2 ))) dstr2 = str2;
+        if (!dlen1) dstr1 = get_compare_decomposition( str1, &dlen1 );
+        if (!dlen2) dstr2 = get_compare_decomposition( str2, &dlen2 );
 
         if (flags & NORM_IGNORESYMBOLS)
         {
@@ -2561,14 +2576,14 @@ static int compare_weights(int flags, const WCHAR *str1, int len1,
     }
     while (len1)
     {
-        if (!dlen1 && !(dstr1 = get_decomposition( *str1, &dlen1 ))) dstr1 = str1;
+        if (!dlen1) dstr1 = get_compare_decomposition( str1, &dlen1 );
         ce1 = get_weight( dstr1[dpos1], type );
         if (ce1) break;
         inc_str_pos( &str1, &len1, &dpos1, &dlen1 );
     }
     while (len2)
     {
-        if (!dlen2 && !(dstr2 = get_decomposition( *str2, &dlen2 ))) dstr2 = str2;
+        if (!dlen2) dstr2 = get_compare_decomposition( str2, &dlen2 );
         ce2 = get_weight( dstr2[dpos2], type );
         if (ce2) break;
         inc_str_pos( &str2, &len2, &dpos2, &dlen2 );
@@ -3050,6 +3065,16 @@ INT WINAPI CompareStringEx( const WCHAR *locale, DWORD flags, const WCHAR *str1,
     if (len1 < 0) len1 = lstrlenW(str1);
     if (len2 < 0) len2 = lstrlenW(str2);
 
+    /* Identical printable ASCII characters have non-zero weights on all levels
+     * and are compared pairwise, so a common prefix can't affect the result. */
+    while (len1 && len2 && *str1 == *str2 && *str1 >= 0x20 && *str1 <= 0x7e)
+    {
+        str1++;
+        str2++;
+        len1--;
+        len2--;
+    }
+
     ret = compare_weights( flags, str1, len1, str2, len2, UNICODE_WEIGHT );
     if (!ret)
     {
@@ -42,6 +42,8 @@
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
 WINE_DECLARE_DEBUG_CHANNEL(virtual);
 
+static const struct _KUSER_SHARED_DATA *user_shared_data = (struct _KUSER_SHARED_DATA *)0x7ffe0000;
+
 
 /***********************************************************************
  * Virtual memory functions
@@ -65,7 +67,7 @@ BOOL WINAPI DECLSPEC_HOTPATCH FlushViewOfFile( const void *base, SIZE_T size )
  */
 SIZE_T WINAPI GetLargePageMinimum(void)
 {
-    return 2 * 1024 * 1024;
+    return user_shared_data->LargePageMinimum;
 }
 
 
@@ -1095,6 +1097,40 @@ BOOL WINAPI DECLSPEC_HOTPATCH MapUserPhysicalPages( void *addr, ULONG_PTR page_c
  ***********************************************************************/
 
 
+/***********************************************************************
+ *             get_numa_nodes
+ *
+ * Retrieve the NUMA node relationships of the system; must be freed by the caller.
+ */
+static SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *get_numa_nodes( DWORD *len )
+{
+    LOGICAL_PROCESSOR_RELATIONSHIP relation = RelationNumaNode;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info = NULL, *new_info;
+    NTSTATUS status;
+
+    *len = 0x400;
+    for (;;)
+    {
+        if (!(new_info = HeapReAlloc( GetProcessHeap(), 0, info, *len )))
+        {
+            HeapFree( GetProcessHeap(), 0, info );
+            SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+            return NULL;
+        }
+        info = new_info;
+        status = NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relation,
+                                             sizeof(relation), info, *len, len );
+        if (status != STATUS_INFO_LENGTH_MISMATCH) break;
+    }
+    if (!set_ntstatus( status ))
+    {
+        HeapFree( GetProcessHeap(), 0, info );
+        return NULL;
+    }
+    return info;
+}
+
+
 /***********************************************************************
  *             AllocateUserPhysicalPagesNuma   (kernelbase.@)
  */
@@ -1189,8 +1225,19 @@ BOOL WINAPI SetThreadSelectedCpuSets(HANDLE thread, const ULONG *cpu_set_ids, UL
  */
 BOOL WINAPI DECLSPEC_HOTPATCH GetNumaHighestNodeNumber( ULONG *node )
 {
-    FIXME( "semi-stub: %p\n", node );
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info;
+    DWORD pos, len;
+
+    TRACE( "%p\n", node );
+
+    if (!(info = get_numa_nodes( &len ))) return FALSE;
     *node = 0;
+    for (pos = 0; pos < len; pos += ((SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + pos))->Size)
+    {
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *entry = (void *)((char *)info + pos);
+        *node = max( *node, entry->u.NumaNode.NodeNumber );
+    }
+    HeapFree( GetProcessHeap(), 0, info );
     return TRUE;
 }
 
@@ -1200,8 +1247,22 @@ BOOL WINAPI DECLSPEC_HOTPATCH GetNumaHighestNodeNumber( ULONG *node )
  */
 BOOL WINAPI DECLSPEC_HOTPATCH GetNumaNodeProcessorMaskEx( USHORT node, GROUP_AFFINITY *mask )
 {
-    FIXME( "stub: %hu %p\n", node, mask );
-    SetLastError( ERROR_CALL_NOT_IMPLEMENTED );
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info;
+    DWORD pos, len;
+
+    TRACE( "%hu %p\n", node, mask );
+
+    if (!(info = get_numa_nodes( &len ))) return FALSE;
+    for (pos = 0; pos < len; pos += ((SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + pos))->Size)
+    {
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *entry = (void *)((char *)info + pos);
+        if (entry->u.NumaNode.NodeNumber != node) continue;
+        *mask = entry->u.NumaNode.GroupMask;
+        HeapFree( GetProcessHeap(), 0, info );
+        return TRUE;
+    }
+    HeapFree( GetProcessHeap(), 0, info );
+    SetLastError( ERROR_INVALID_PARAMETER );
     return FALSE;
 }
 
@@ -1234,8 +1295,14 @@ LPVOID WINAPI DECLSPEC_HOTPATCH MapViewOfFileExNuma( HANDLE handle, DWORD access
 LPVOID WINAPI DECLSPEC_HOTPATCH VirtualAllocExNuma( HANDLE process, void *addr, SIZE_T size,
                                                     DWORD type, DWORD protect, DWORD node )
 {
-    if (node) FIXME( "Ignoring preferred node %u\n", node );
-    return VirtualAllocEx( process, addr, size, type, protect );
+    MEM_EXTENDED_PARAMETER param;
+
+    if (node == NUMA_NO_PREFERRED_NODE) return VirtualAllocEx( process, addr, size, type, protect );
+
+    memset( &param, 0, sizeof(param) );
+    param.s.Type = MemExtendedParameterNumaNode;
+    param.u.ULong = node;
+    return VirtualAlloc2( process, addr, size, type, protect, &param, 1 );
 }
 
 
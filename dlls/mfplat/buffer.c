@@ -43,6 +43,7 @@ struct buffer
     LONG refcount;
 
     BYTE *data;
+    DWORD data_size;
     DWORD max_length;
     DWORD current_length;
 
@@ -75,6 +76,74 @@ struct buffer
     CRITICAL_SECTION cs;
 };
 
+/* Frame-sized allocations are recycled, so that pipelines creating a new buffer
+   for every sample don't map and fault in fresh pages each time. */
+#define BUFFER_CACHE_MIN_SIZE 0x10000
+#define BUFFER_CACHE_MAX_ENTRIES 8
+
+static struct
+{
+    BYTE *data;
+    DWORD size;
+} buffer_cache[BUFFER_CACHE_MAX_ENTRIES];
+static unsigned int buffer_cache_count;
+
+static CRITICAL_SECTION buffer_cache_cs;
+static CRITICAL_SECTION_DEBUG buffer_cache_cs_debug =
+{
+    0, 0, &buffer_cache_cs,
+    { &buffer_cache_cs_debug.ProcessLocksList, &buffer_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": buffer_cache_cs") }
+};
+static CRITICAL_SECTION buffer_cache_cs = { &buffer_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static BYTE *alloc_buffer_data(DWORD size)
+{
+    BYTE *data = NULL;
+    unsigned int i;
+
+    if (size >= BUFFER_CACHE_MIN_SIZE)
+    {
+        EnterCriticalSection(&buffer_cache_cs);
+        for (i = 0; i < buffer_cache_count; ++i)
+        {
+            if (buffer_cache[i].size == size)
+            {
+                data = buffer_cache[i].data;
+                buffer_cache[i] = buffer_cache[--buffer_cache_count];
+                break;
+            }
+        }
+        LeaveCriticalSection(&buffer_cache_cs);
+
+        if (data)
+        {
+            memset(data, 0, size);
+            return data;
+        }
+    }
+
+    return calloc(1, size);
+}
+
+static void free_buffer_data(BYTE *data, DWORD size)
+{
+    if (data && size >= BUFFER_CACHE_MIN_SIZE)
+    {
+        EnterCriticalSection(&buffer_cache_cs);
+        if (buffer_cache_count < BUFFER_CACHE_MAX_ENTRIES)
+        {
+            buffer_cache[buffer_cache_count].data = data;
+            buffer_cache[buffer_cache_count].size = size;
+            buffer_cache_count++;
+            data = NULL;
+        }
+        LeaveCriticalSection(&buffer_cache_cs);
+    }
+
+    free(data);
+}
+
 static void copy_image(const struct buffer *buffer, BYTE *dest, LONG dest_stride, const BYTE *src,
         LONG src_stride, DWORD width, DWORD lines)
 {
@@ -173,7 +242,7 @@ static ULONG WINAPI memory_buffer_Release(IMFMediaBuffer *iface)
         }
         DeleteCriticalSection(&buffer->cs);
         free(buffer->_2d.linear_buffer);
-        free(buffer->data);
+        free_buffer_data(buffer->data, buffer->data_size);
         free(buffer);
     }
 
@@ -1256,7 +1325,8 @@ static const IMFDXGIBufferVtbl dxgi_buffer_vtbl =
 static HRESULT memory_buffer_init(struct buffer *buffer, DWORD max_length, DWORD alignment,
         const IMFMediaBufferVtbl *vtbl)
 {
-    if (!(buffer->data = calloc(1, ALIGN_SIZE(max_length, alignment))))
+    buffer->data_size = ALIGN_SIZE(max_length, alignment);
+    if (!(buffer->data = alloc_buffer_data(buffer->data_size)))
         return E_OUTOFMEMORY;
 
     buffer->IMFMediaBuffer_iface.lpVtbl = vtbl;
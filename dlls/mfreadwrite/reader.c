@@ -489,6 +489,24 @@ static HRESULT source_reader_request_sample(struct source_reader *reader, struct
     return hr;
 }
 
+/* Streams going through a decoder keep a few samples queued ahead of the
+   application, so decoding overlaps with processing of returned samples. */
+#define STREAM_READ_AHEAD_SAMPLES 2
+
+static BOOL source_reader_stream_needs_sample(const struct source_reader *reader, const struct media_stream *stream)
+{
+    if (stream->requests)
+        return TRUE;
+
+    if (!stream->decoder.transform || stream->state == STREAM_STATE_EOS || !(stream->flags & STREAM_FLAG_SELECTED)
+            || reader->flags & SOURCE_READER_SEEKING)
+    {
+        return FALSE;
+    }
+
+    return stream->responses < STREAM_READ_AHEAD_SAMPLES;
+}
+
 static HRESULT source_reader_new_stream_handler(struct source_reader *reader, IMFMediaEvent *event)
 {
     IMFMediaStream *stream;
@@ -776,7 +794,7 @@ static HRESULT source_reader_media_sample_handler(struct source_reader *reader,
 
             reader->streams[i].flags &= ~STREAM_FLAG_SAMPLE_REQUESTED;
             hr = source_reader_process_sample(reader, &reader->streams[i], sample);
-            if (reader->streams[i].requests)
+            if (source_reader_stream_needs_sample(reader, &reader->streams[i]))
                 source_reader_request_sample(reader, &reader->streams[i]);
 
             break;
@@ -1065,6 +1083,9 @@ static BOOL source_reader_get_read_result(struct source_reader *reader, struct m
             IMFSample_AddRef(*sample);
 
         source_reader_release_response(response);
+
+        if (source_reader_stream_needs_sample(reader, stream))
+            source_reader_request_sample(reader, stream);
     }
     else
     {
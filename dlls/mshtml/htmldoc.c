@@ -250,7 +250,7 @@ static HRESULT WINAPI HTMLDocument_get_all(IHTMLDocument2 *iface, IHTMLElementCo
     if(FAILED(hres))
         return hres;
 
-    *p = create_all_collection(node, TRUE);
+    *p = create_document_all_collection(This->doc_node, node);
     node_release(node);
     return hres;
 }
@@ -5452,15 +5452,20 @@ static HRESULT HTMLDocumentNode_clone(HTMLDOMNode *iface, nsIDOMNode *nsnode, HT
 static void HTMLDocumentNode_traverse(HTMLDOMNode *iface, nsCycleCollectionTraversalCallback *cb)
 {
     HTMLDocumentNode *This = impl_from_HTMLDOMNode(iface);
+    DWORD i;
 
     if(This->nsdoc)
         note_cc_edge((nsISupports*)This->nsdoc, "This->nsdoc", cb);
+    for(i = 0; i < This->all_elems_cnt; i++)
+        note_cc_edge((nsISupports*)&This->all_elems[i]->node.IHTMLDOMNode_iface, "all_elems", cb);
 }
 
 static void HTMLDocumentNode_unlink(HTMLDOMNode *iface)
 {
     HTMLDocumentNode *This = impl_from_HTMLDOMNode(iface);
 
+    release_document_all_elems(This);
+
     if(This->nsdoc) {
         nsIDOMHTMLDocument *nsdoc = This->nsdoc;
 
@@ -681,6 +681,53 @@ IHTMLElementCollection *create_all_collection(HTMLDOMNode *node, BOOL include_ro
                                         dispex_compat_mode(&node->event_target.dispex));
 }
 
+void release_document_all_elems(HTMLDocumentNode *doc)
+{
+    DWORD i;
+
+    for(i = 0; i < doc->all_elems_cnt; i++)
+        node_release(&doc->all_elems[i]->node);
+    heap_free(doc->all_elems);
+    doc->all_elems = NULL;
+    doc->all_elems_cnt = 0;
+}
+
+/* document.all is commonly accessed in loops, so the element list is cached in
+ * the document and rebuilt only after the document tree was modified. */
+IHTMLElementCollection *create_document_all_collection(HTMLDocumentNode *doc, HTMLDOMNode *root)
+{
+    HTMLElement **elems;
+    DWORD i;
+
+    if(!doc->all_elems || doc->all_elems_version != doc->dom_version) {
+        elem_vector_t buf = {NULL, 0, 8};
+
+        release_document_all_elems(doc);
+
+        buf.buf = heap_alloc(buf.size*sizeof(HTMLElement*));
+
+        node_addref(root);
+        elem_vector_add(&buf, elem_from_HTMLDOMNode(root));
+        create_all_list(root, &buf);
+        elem_vector_normalize(&buf);
+
+        doc->all_elems = buf.buf;
+        doc->all_elems_cnt = buf.len;
+        doc->all_elems_version = doc->dom_version;
+    }else {
+        TRACE("using cached list (%u elements)\n", doc->all_elems_cnt);
+    }
+
+    elems = heap_alloc(doc->all_elems_cnt*sizeof(HTMLElement*));
+    for(i = 0; i < doc->all_elems_cnt; i++) {
+        elems[i] = doc->all_elems[i];
+        node_addref(&elems[i]->node);
+    }
+
+    return HTMLElementCollection_Create(elems, doc->all_elems_cnt,
+                                        dispex_compat_mode(&root->event_target.dispex));
+}
+
 IHTMLElementCollection *create_collection_from_nodelist(nsIDOMNodeList *nslist, compat_mode_t compat_mode)
 {
     UINT32 length = 0, i;
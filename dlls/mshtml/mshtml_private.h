@@ -887,6 +887,11 @@ struct HTMLDocumentNode {
 
     BOOL skip_mutation_notif;
 
+    LONG dom_version;
+    LONG all_elems_version;
+    HTMLElement **all_elems;
+    DWORD all_elems_cnt;
+
     UINT charset;
 
     unsigned unique_id;
@@ -1140,6 +1145,8 @@ HRESULT handle_link_click_event(HTMLElement*,nsAString*,nsAString*,nsIDOMEvent*,
 HRESULT wrap_iface(IUnknown*,IUnknown*,IUnknown**) DECLSPEC_HIDDEN;
 
 IHTMLElementCollection *create_all_collection(HTMLDOMNode*,BOOL) DECLSPEC_HIDDEN;
+IHTMLElementCollection *create_document_all_collection(HTMLDocumentNode*,HTMLDOMNode*) DECLSPEC_HIDDEN;
+void release_document_all_elems(HTMLDocumentNode*) DECLSPEC_HIDDEN;
 IHTMLElementCollection *create_collection_from_nodelist(nsIDOMNodeList*,compat_mode_t) DECLSPEC_HIDDEN;
 IHTMLElementCollection *create_collection_from_htmlcol(nsIDOMHTMLCollection*,compat_mode_t) DECLSPEC_HIDDEN;
 IHTMLDOMChildrenCollection *create_child_collection(nsIDOMNodeList*) DECLSPEC_HIDDEN;
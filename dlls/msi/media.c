@@ -162,11 +162,274 @@ static UINT CDECL cabinet_read(INT_PTR hf, void *pv, UINT cb)
     return 0;
 }
 
+/* Extracted files are written by a small pool of threads so that FDI can
+ * decompress the next block while the previous ones are still being
+ * written. All writes to a file go to the same thread, in order. */
+
+#define CABINET_MAX_WRITERS 4
+#define CABINET_MAX_PENDING (16 * 1024 * 1024)
+
+enum cabinet_op_type
+{
+    CABINET_OP_ALLOCATE,
+    CABINET_OP_WRITE,
+    CABINET_OP_CLOSE,
+};
+
+struct cabinet_op
+{
+    struct list entry;
+    enum cabinet_op_type type;
+    HANDLE handle;
+    BOOL set_time;
+    FILETIME time;
+    ULONG size;
+    BYTE data[1];
+};
+
+struct cabinet_writer;
+
+struct cabinet_worker
+{
+    struct cabinet_writer *writer;
+    HANDLE thread;
+    struct list ops;
+};
+
+struct cabinet_writer
+{
+    CRITICAL_SECTION cs;
+    CONDITION_VARIABLE work_cv;
+    CONDITION_VARIABLE done_cv;
+    HANDLE current;                    /* file currently being extracted */
+    struct cabinet_worker *current_worker;
+    struct cabinet_op *current_close;  /* preallocated so closing can't fail */
+    UINT pending_bytes;
+    UINT pending_ops;
+    UINT next_worker;
+    UINT worker_count;
+    BOOL failed;
+    BOOL shutdown;
+    struct cabinet_worker workers[CABINET_MAX_WRITERS];
+};
+
+/* FDI callbacks have no context pointer, only the extracting thread may use the writer */
+static struct cabinet_writer *cabinet_writer;
+static DWORD cabinet_writer_thread;
+
+static BOOL cabinet_do_op( struct cabinet_op *op )
+{
+    LARGE_INTEGER size, zero;
+    DWORD written;
+    BOOL ret = TRUE;
+
+    switch (op->type)
+    {
+    case CABINET_OP_ALLOCATE:
+        /* reserve the final size up front, failure only costs performance */
+        size.QuadPart = op->size;
+        zero.QuadPart = 0;
+        if (!SetFilePointerEx( op->handle, size, NULL, FILE_BEGIN ) || !SetEndOfFile( op->handle ))
+            WARN("failed to preallocate %u bytes (error %u)\n", op->size, GetLastError());
+        SetFilePointerEx( op->handle, zero, NULL, FILE_BEGIN );
+        break;
+
+    case CABINET_OP_WRITE:
+        ret = WriteFile( op->handle, op->data, op->size, &written, NULL ) && written == op->size;
+        if (!ret) ERR("failed to write %u bytes (error %u)\n", op->size, GetLastError());
+        break;
+
+    case CABINET_OP_CLOSE:
+        if (op->set_time) ret = SetFileTime( op->handle, &op->time, 0, &op->time );
+        CloseHandle( op->handle );
+        break;
+    }
+    return ret;
+}
+
+static DWORD WINAPI cabinet_worker_proc( void *arg )
+{
+    struct cabinet_worker *worker = arg;
+    struct cabinet_writer *writer = worker->writer;
+    struct cabinet_op *op;
+    struct list *entry;
+    BOOL ret;
+
+    EnterCriticalSection( &writer->cs );
+    for (;;)
+    {
+        while (!(entry = list_head( &worker->ops )) && !writer->shutdown)
+            SleepConditionVariableCS( &writer->work_cv, &writer->cs, INFINITE );
+        if (!entry) break;
+
+        list_remove( entry );
+        LeaveCriticalSection( &writer->cs );
+
+        op = LIST_ENTRY( entry, struct cabinet_op, entry );
+        ret = cabinet_do_op( op );
+
+        EnterCriticalSection( &writer->cs );
+        if (!ret) writer->failed = TRUE;
+        if (op->type == CABINET_OP_WRITE) writer->pending_bytes -= op->size;
+        writer->pending_ops--;
+        WakeAllConditionVariable( &writer->done_cv );
+        msi_free( op );
+    }
+    LeaveCriticalSection( &writer->cs );
+    return 0;
+}
+
+static BOOL cabinet_queue_op( struct cabinet_writer *writer, struct cabinet_op *op )
+{
+    BOOL ret;
+
+    EnterCriticalSection( &writer->cs );
+    if (op->type == CABINET_OP_WRITE)
+    {
+        while (writer->pending_bytes && writer->pending_bytes + op->size > CABINET_MAX_PENDING)
+            SleepConditionVariableCS( &writer->done_cv, &writer->cs, INFINITE );
+        writer->pending_bytes += op->size;
+    }
+    writer->pending_ops++;
+    list_add_tail( &writer->current_worker->ops, &op->entry );
+    ret = !writer->failed;
+    LeaveCriticalSection( &writer->cs );
+
+    WakeAllConditionVariable( &writer->work_cv );
+    return ret;
+}
+
+static struct cabinet_writer *get_cabinet_writer( INT_PTR hf )
+{
+    if (cabinet_writer_thread != GetCurrentThreadId()) return NULL;
+    if (!cabinet_writer->current || (INT_PTR)cabinet_writer->current != hf) return NULL;
+    return cabinet_writer;
+}
+
+static struct cabinet_writer *create_cabinet_writer(void)
+{
+    struct cabinet_writer *writer;
+    SYSTEM_INFO info;
+    UINT i, count;
+
+    if (!(writer = msi_alloc_zero( sizeof(*writer) ))) return NULL;
+    if (InterlockedCompareExchangePointer( (void **)&cabinet_writer, writer, NULL ))
+    {
+        TRACE("another extraction is in progress, writing synchronously\n");
+        msi_free( writer );
+        return NULL;
+    }
+
+    InitializeCriticalSection( &writer->cs );
+    InitializeConditionVariable( &writer->work_cv );
+    InitializeConditionVariable( &writer->done_cv );
+
+    GetSystemInfo( &info );
+    count = min( max( info.dwNumberOfProcessors, 2 ) - 1, CABINET_MAX_WRITERS );
+    for (i = 0; i < count; i++)
+    {
+        struct cabinet_worker *worker = &writer->workers[writer->worker_count];
+
+        worker->writer = writer;
+        list_init( &worker->ops );
+        if (!(worker->thread = CreateThread( NULL, 0, cabinet_worker_proc, worker, 0, NULL ))) break;
+        writer->worker_count++;
+    }
+    TRACE("using %u writer threads\n", writer->worker_count);
+
+    cabinet_writer_thread = GetCurrentThreadId();
+    return writer;
+}
+
+/* waits for all queued writes, returns FALSE if any of them failed */
+static BOOL destroy_cabinet_writer( struct cabinet_writer *writer )
+{
+    BOOL ret;
+    UINT i;
+
+    if (!writer) return TRUE;
+
+    EnterCriticalSection( &writer->cs );
+    while (writer->pending_ops)
+        SleepConditionVariableCS( &writer->done_cv, &writer->cs, INFINITE );
+    writer->shutdown = TRUE;
+    ret = !writer->failed;
+    LeaveCriticalSection( &writer->cs );
+    WakeAllConditionVariable( &writer->work_cv );
+
+    for (i = 0; i < writer->worker_count; i++)
+    {
+        WaitForSingleObject( writer->workers[i].thread, INFINITE );
+        CloseHandle( writer->workers[i].thread );
+    }
+    msi_free( writer->current_close );
+
+    cabinet_writer_thread = 0;
+    cabinet_writer = NULL;
+
+    DeleteCriticalSection( &writer->cs );
+    msi_free( writer );
+    return ret;
+}
+
+static void cabinet_writer_end_file( struct cabinet_writer *writer, const FILETIME *time )
+{
+    struct cabinet_op *op = writer->current_close;
+
+    if (time)
+    {
+        op->set_time = TRUE;
+        op->time = *time;
+    }
+    writer->current_close = NULL;
+    writer->current = NULL;
+    cabinet_queue_op( writer, op );
+}
+
+/* hands a newly created file over to a writer thread */
+static void cabinet_writer_begin_file( HANDLE handle, ULONG size )
+{
+    struct cabinet_writer *writer;
+    struct cabinet_op *op;
+
+    if (cabinet_writer_thread != GetCurrentThreadId()) return;
+    writer = cabinet_writer;
+    if (!writer->worker_count) return;
+    if (writer->current_close) cabinet_writer_end_file( writer, NULL );
+
+    if (!(writer->current_close = msi_alloc_zero( sizeof(*writer->current_close) ))) return;
+    writer->current_close->type = CABINET_OP_CLOSE;
+    writer->current_close->handle = handle;
+
+    writer->current = handle;
+    writer->current_worker = &writer->workers[writer->next_worker++ % writer->worker_count];
+
+    if (size && (op = msi_alloc_zero( sizeof(*op) )))
+    {
+        op->type = CABINET_OP_ALLOCATE;
+        op->handle = handle;
+        op->size = size;
+        cabinet_queue_op( writer, op );
+    }
+}
+
 static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 {
+    struct cabinet_writer *writer;
     HANDLE handle = (HANDLE)hf;
+    struct cabinet_op *op;
     DWORD written;
 
+    if ((writer = get_cabinet_writer( hf )))
+    {
+        if (!(op = msi_alloc( FIELD_OFFSET( struct cabinet_op, data[cb] ) ))) return 0;
+        op->type = CABINET_OP_WRITE;
+        op->handle = handle;
+        op->size = cb;
+        memcpy( op->data, pv, cb );
+        return cabinet_queue_op( writer, op ) ? cb : 0;
+    }
+
     if (WriteFile(handle, pv, cb, &written, NULL))
         return written;
 
@@ -175,7 +438,14 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 
 static int CDECL cabinet_close(INT_PTR hf)
 {
+    struct cabinet_writer *writer;
     HANDLE handle = (HANDLE)hf;
+
+    if ((writer = get_cabinet_writer( hf )))
+    {
+        cabinet_writer_end_file( writer, NULL );
+        return 0;
+    }
     return CloseHandle(handle) ? 0 : -1;
 }
 
@@ -250,6 +520,10 @@ static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
 static int CDECL cabinet_close_stream( INT_PTR hf )
 {
     IStream *stm = (IStream *)hf;
+
+    /* FDI closes the output file with the same callback on failure */
+    if (get_cabinet_writer( hf )) return cabinet_close( hf );
+
     IStream_Release( stm );
     return 0;
 }
@@ -432,6 +706,7 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 
     attrs = attrs & (FILE_ATTRIBUTE_READONLY|FILE_ATTRIBUTE_HIDDEN|FILE_ATTRIBUTE_SYSTEM);
     if (!attrs) attrs = FILE_ATTRIBUTE_NORMAL;
+    attrs |= FILE_FLAG_SEQUENTIAL_SCAN;
 
     handle = msi_create_file( data->package, path, GENERIC_READ | GENERIC_WRITE, 0, CREATE_ALWAYS, attrs );
     if (handle == INVALID_HANDLE_VALUE)
@@ -493,6 +768,9 @@ static INT_PTR cabinet_copy_file(FDINOTIFICATIONTYPE fdint,
 done:
     msi_free(path);
 
+    if (handle && handle != INVALID_HANDLE_VALUE)
+        cabinet_writer_begin_file( handle, pfdin->cb );
+
     return (INT_PTR)handle;
 }
 
@@ -500,6 +778,7 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
                                        PFDINOTIFICATION pfdin)
 {
     MSICABDATA *data = pfdin->pv;
+    struct cabinet_writer *writer;
     FILETIME ft;
     FILETIME ftLocal;
     HANDLE handle = (HANDLE)pfdin->hf;
@@ -510,10 +789,15 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
         return -1;
     if (!LocalFileTimeToFileTime(&ft, &ftLocal))
         return -1;
-    if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
-        return -1;
+    if ((writer = get_cabinet_writer( pfdin->hf )))
+        cabinet_writer_end_file( writer, &ftLocal );
+    else
+    {
+        if (!SetFileTime(handle, &ftLocal, 0, &ftLocal))
+            return -1;
 
-    CloseHandle(handle);
+        CloseHandle(handle);
+    }
 
     data->cb(data->package, data->curfile, MSICABEXTRACT_FILEEXTRACTED, NULL, NULL,
              data->user);
@@ -572,6 +856,7 @@ static INT_PTR CDECL cabinet_notify_stream( FDINOTIFICATIONTYPE fdint, PFDINOTIF
 
 static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data )
 {
+    struct cabinet_writer *writer;
     LPSTR cabinet, cab_path = NULL;
     HFDI hfdi;
     ERF erf;
@@ -595,7 +880,10 @@ static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data
     if (!cab_path)
         goto done;
 
+    writer = create_cabinet_writer();
     ret = FDICopy( hfdi, cabinet, cab_path, 0, cabinet_notify, NULL, data );
+    if (!destroy_cabinet_writer( writer ))
+        ret = FALSE;
     if (!ret)
         ERR("FDICopy failed\n");
 
@@ -613,6 +901,7 @@ done:
 static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOID data )
 {
     static char filename[] = {'<','S','T','R','E','A','M','>',0};
+    struct cabinet_writer *writer;
     HFDI hfdi;
     ERF erf;
     BOOL ret = FALSE;
@@ -630,7 +919,9 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
     package_disk.package = package;
     package_disk.id      = mi->disk_id;
 
+    writer = create_cabinet_writer();
     ret = FDICopy( hfdi, filename, NULL, 0, cabinet_notify_stream, NULL, data );
+    if (!destroy_cabinet_writer( writer )) ret = FALSE;
     if (!ret) ERR("FDICopy failed\n");
 
     FDIDestroy( hfdi );
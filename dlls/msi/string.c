@@ -53,9 +53,10 @@ struct string_table
     UINT maxcount;         /* the number of strings */
     UINT freeslot;
     UINT codepage;
-    UINT sortcount;
+    UINT hashcount;            /* the number of strings in the index */
+    UINT hashsize;             /* the number of index slots, a power of two */
     struct msistring *strings; /* an array of strings */
-    UINT *sorted;              /* index */
+    UINT *hash;                /* index, string ids hashed by value */
 };
 
 static BOOL validate_codepage( UINT codepage )
@@ -88,8 +89,13 @@ static string_table *init_stringtable( int entries, UINT codepage )
         return NULL;
     }
 
-    st->sorted = msi_alloc( sizeof (UINT) * entries );
-    if( !st->sorted )
+    /* keep the index at most half full */
+    st->hashsize = 16;
+    while (st->hashsize < entries * 2)
+        st->hashsize <<= 1;
+
+    st->hash = msi_alloc_zero( sizeof (UINT) * st->hashsize );
+    if( !st->hash )
     {
         msi_free( st->strings );
         msi_free( st );
@@ -99,7 +105,7 @@ static string_table *init_stringtable( int entries, UINT codepage )
     st->maxcount = entries;
     st->freeslot = 1;
     st->codepage = codepage;
-    st->sortcount = 0;
+    st->hashcount = 0;
 
     return st;
 }
@@ -115,13 +121,13 @@ VOID msi_destroy_stringtable( string_table *st )
             msi_free( st->strings[i].data );
     }
     msi_free( st->strings );
-    msi_free( st->sorted );
+    msi_free( st->hash );
     msi_free( st );
 }
 
 static int st_find_free_entry( string_table *st )
 {
-    UINT i, sz, *s;
+    UINT i, sz;
     struct msistring *p;
 
     TRACE("%p\n", st);
@@ -144,15 +150,7 @@ static int st_find_free_entry( string_table *st )
     if( !p )
         return -1;
 
-    s = msi_realloc( st->sorted, sz*sizeof(UINT) );
-    if( !s )
-    {
-        msi_free( p );
-        return -1;
-    }
-
     st->strings = p;
-    st->sorted = s;
 
     st->freeslot = st->maxcount;
     st->maxcount = sz;
@@ -162,49 +160,66 @@ static int st_find_free_entry( string_table *st )
     return st->freeslot;
 }
 
-static inline int cmp_string( const WCHAR *str1, int len1, const WCHAR *str2, int len2 )
+static inline UINT hash_string( const WCHAR *str, int len )
+{
+    UINT hash = 0x811c9dc5;
+
+    while (len--)
+        hash = (hash ^ *str++) * 0x01000193;
+    return hash;
+}
+
+/* returns the index slot holding the string, or the empty slot where it belongs */
+static UINT find_hash_slot( const string_table *st, const WCHAR *str, int len )
 {
-    if (len1 < len2) return -1;
-    else if (len1 > len2) return 1;
-    while (len1)
+    UINT mask = st->hashsize - 1, i = hash_string( str, len ) & mask, id;
+
+    while ((id = st->hash[i]))
     {
-        if (*str1 == *str2) { str1++; str2++; }
-        else return *str1 - *str2;
-        len1--;
+        if (st->strings[id].len == len && !memcmp( st->strings[id].data, str, len * sizeof(WCHAR) ))
+            break;
+        i = (i + 1) & mask;
     }
-    return 0;
+    return i;
 }
 
-static int find_insert_index( const string_table *st, UINT string_id )
+static BOOL grow_hash( string_table *st )
 {
-    int i, c, low = 0, high = st->sortcount - 1;
+    UINT *old = st->hash, old_size = st->hashsize, i;
 
-    while (low <= high)
+    if (!(st->hash = msi_alloc_zero( old_size * 2 * sizeof(UINT) )))
     {
-        i = (low + high) / 2;
-        c = cmp_string( st->strings[string_id].data, st->strings[string_id].len,
-                        st->strings[st->sorted[i]].data, st->strings[st->sorted[i]].len );
-        if (c < 0)
-            high = i - 1;
-        else if (c > 0)
-            low = i + 1;
-        else
-            return -1; /* already exists */
+        st->hash = old;
+        return FALSE;
+    }
+    st->hashsize = old_size * 2;
+
+    for (i = 0; i < old_size; i++)
+    {
+        if (!old[i]) continue;
+        st->hash[find_hash_slot( st, st->strings[old[i]].data, st->strings[old[i]].len )] = old[i];
     }
-    return high + 1;
+    msi_free( old );
+    return TRUE;
 }
 
-static void insert_string_sorted( string_table *st, UINT string_id )
+static void insert_string_hash( string_table *st, UINT string_id )
 {
-    int i;
+    UINT i;
 
-    i = find_insert_index( st, string_id );
-    if (i == -1)
+    /* if the index can't grow, probing still terminates as long as a slot is empty */
+    if ((st->hashcount + 1) * 2 > st->hashsize && !grow_hash( st ) && st->hashcount + 1 >= st->hashsize)
+    {
+        ERR("failed to index string %u\n", string_id);
         return;
+    }
+
+    i = find_hash_slot( st, st->strings[string_id].data, st->strings[string_id].len );
+    if (st->hash[i])
+        return; /* already exists */
 
-    memmove( &st->sorted[i] + 1, &st->sorted[i], (st->sortcount - i) * sizeof(UINT) );
-    st->sorted[i] = string_id;
-    st->sortcount++;
+    st->hash[i] = string_id;
+    st->hashcount++;
 }
 
 static void set_st_entry( string_table *st, UINT n, WCHAR *str, int len, USHORT refcount,
@@ -224,7 +239,7 @@ static void set_st_entry( string_table *st, UINT n, WCHAR *str, int len, USHORT
     st->strings[n].data = str;
     st->strings[n].len  = len;
 
-    insert_string_sorted( st, n );
+    insert_string_hash( st, n );
 
     if( n < st->maxcount )
         st->freeslot = n + 1;
@@ -401,26 +416,16 @@ static UINT id2string( const string_table *st, UINT id, char *buffer, UINT *sz )
  */
 UINT msi_string2id( const string_table *st, const WCHAR *str, int len, UINT *id )
 {
-    int i, c, low = 0, high = st->sortcount - 1;
+    UINT i;
 
     if (len < 0) len = lstrlenW( str );
 
-    while (low <= high)
-    {
-        i = (low + high) / 2;
-        c = cmp_string( str, len, st->strings[st->sorted[i]].data, st->strings[st->sorted[i]].len );
+    i = find_hash_slot( st, str, len );
+    if (!st->hash[i])
+        return ERROR_INVALID_PARAMETER;
 
-        if (c < 0)
-            high = i - 1;
-        else if (c > 0)
-            low = i + 1;
-        else
-        {
-            *id = st->sorted[i];
-            return ERROR_SUCCESS;
-        }
-    }
-    return ERROR_INVALID_PARAMETER;
+    *id = st->hash[i];
+    return ERROR_SUCCESS;
 }
 
 static void string_totalsize( const string_table *st, UINT *datasize, UINT *poolsize )
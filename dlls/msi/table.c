@@ -40,6 +40,9 @@ WINE_DEFAULT_DEBUG_CHANNEL(msidb);
 
 #define MSITABLE_HASH_TABLE_SIZE 37
 
+/* tables smaller than this are searched linearly */
+#define MSITABLE_KEY_INDEX_MIN_ROWS 16
+
 typedef struct tagMSICOLUMNHASHENTRY
 {
     struct tagMSICOLUMNHASHENTRY *next;
@@ -67,6 +70,9 @@ struct tagMSITABLE
     UINT col_count;
     MSICONDITION persistent;
     INT ref_count;
+    UINT *key_index;      /* primary key hash: bucket heads, then chain links */
+    UINT key_index_size;  /* number of buckets, a power of two */
+    BOOL key_lookup;      /* searched by key since the last modification */
     WCHAR name[1];
 };
 
@@ -360,12 +366,20 @@ static void msi_free_colinfo( MSICOLUMNINFO *colinfo, UINT count )
     for (i = 0; i < count; i++) msi_free( colinfo[i].hash_table );
 }
 
+static void table_invalidate_key_index( MSITABLE *table )
+{
+    msi_free( table->key_index );
+    table->key_index = NULL;
+    table->key_lookup = FALSE;
+}
+
 static void free_table( MSITABLE *table )
 {
     UINT i;
     for( i=0; i<table->row_count; i++ )
         msi_free( table->data[i] );
     msi_free( table->data );
+    msi_free( table->key_index );
     msi_free( table->data_persistent );
     msi_free_colinfo( table->colinfo, table->col_count );
     msi_free( table->colinfo );
@@ -595,6 +609,8 @@ static UINT get_table( MSIDATABASE *db, LPCWSTR name, MSITABLE **table_ret )
     table->colinfo = NULL;
     table->col_count = 0;
     table->persistent = MSICONDITION_TRUE;
+    table->key_index = NULL;
+    table->key_lookup = FALSE;
     lstrcpyW( table->name, name );
 
     if (!wcscmp( name, L"_Tables" ) || !wcscmp( name, L"_Columns" ))
@@ -731,6 +747,8 @@ UINT msi_create_table( MSIDATABASE *db, LPCWSTR name, column_info *col_info,
     table->colinfo = NULL;
     table->col_count = 0;
     table->persistent = persistent;
+    table->key_index = NULL;
+    table->key_lookup = FALSE;
     lstrcpyW( table->name, name );
 
     if( hold )
@@ -939,6 +957,7 @@ static void msi_update_table_columns( MSIDATABASE *db, LPCWSTR name )
 
     if (!(table = find_cached_table( db, name ))) return;
     old_count = table->col_count;
+    table_invalidate_key_index( table );
     msi_free_colinfo( table->colinfo, table->col_count );
     msi_free( table->colinfo );
     table->colinfo = NULL;
@@ -1177,6 +1196,8 @@ static UINT table_set_bytes( MSITABLEVIEW *tv, UINT row, UINT col, UINT val )
 
     msi_free( tv->columns[col-1].hash_table );
     tv->columns[col-1].hash_table = NULL;
+    if (tv->columns[col-1].type & MSITYPE_KEY)
+        table_invalidate_key_index( tv->table );
 
     n = bytes_per_column( tv->db, &tv->columns[col - 1], LONG_STR_BYTES );
     if ( n != 2 && n != 3 && n != 4 )
@@ -1490,6 +1511,8 @@ static UINT table_create_new_row( struct tagMSIVIEW *view, UINT *num, BOOL tempo
     if( !row )
         return ERROR_NOT_ENOUGH_MEMORY;
 
+    table_invalidate_key_index( tv->table );
+
     row_count = &tv->table->row_count;
     data_ptr = &tv->table->data;
     data_persist_ptr = &tv->table->data_persistent;
@@ -1756,6 +1779,7 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
 
     num_rows = tv->table->row_count;
     tv->table->row_count--;
+    table_invalidate_key_index( tv->table );
 
     /* reset the hash tables */
     for (i = 0; i < tv->num_cols; i++)
@@ -1943,6 +1967,8 @@ static UINT TABLE_remove_column(struct tagMSIVIEW *view, UINT number)
     if (tv->table->col_count != number)
         return ERROR_BAD_QUERY_SYNTAX;
 
+    table_invalidate_key_index( tv->table );
+
     if (tv->table->colinfo[number-1].type & MSITYPE_TEMPORARY)
     {
         UINT size = tv->table->colinfo[number-1].offset;
@@ -2059,6 +2085,7 @@ static UINT TABLE_add_column(struct tagMSIVIEW *view, LPCWSTR column,
     colinfo[tv->table->col_count].offset = 0;
     colinfo[tv->table->col_count].hash_table = NULL;
     tv->table->col_count++;
+    table_invalidate_key_index( tv->table );
 
     table_calc_column_offsets( tv->db, tv->table->colinfo, tv->table->col_count);
 
@@ -3144,6 +3171,94 @@ static UINT msi_row_matches( MSITABLEVIEW *tv, UINT row, const UINT *data, UINT
     return ret;
 }
 
+static inline UINT key_hash_add( UINT hash, UINT value )
+{
+    return (hash ^ value) * 0x01000193;
+}
+
+static UINT table_key_hash( MSITABLEVIEW *tv, const UINT *data )
+{
+    UINT i, hash = 0x811c9dc5;
+
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        if (tv->columns[i].type & MSITYPE_KEY)
+            hash = key_hash_add( hash, data[i] );
+    }
+    return hash;
+}
+
+static UINT table_row_key_hash( MSITABLEVIEW *tv, UINT row, UINT *hash )
+{
+    UINT i, r, value;
+
+    *hash = 0x811c9dc5;
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        if (~tv->columns[i].type & MSITYPE_KEY)
+            continue;
+
+        r = TABLE_fetch_int( &tv->view, row, i + 1, &value );
+        if (r != ERROR_SUCCESS)
+            return r;
+        *hash = key_hash_add( *hash, value );
+    }
+    return ERROR_SUCCESS;
+}
+
+/* Hash the key columns of every row, chaining rows in ascending order so the
+ * first match agrees with a linear scan. Entries store row + 1, 0 ends a chain. */
+static UINT table_build_key_index( MSITABLEVIEW *tv )
+{
+    MSITABLE *table = tv->table;
+    UINT size = 1, i, r, hash, *index;
+
+    while (size < table->row_count)
+        size <<= 1;
+
+    if (!(index = msi_alloc_zero( (size + table->row_count) * sizeof(*index) )))
+        return ERROR_OUTOFMEMORY;
+
+    for (i = table->row_count; i > 0; i--)
+    {
+        r = table_row_key_hash( tv, i - 1, &hash );
+        if (r != ERROR_SUCCESS)
+        {
+            msi_free( index );
+            return r;
+        }
+        index[size + i - 1] = index[hash & (size - 1)];
+        index[hash & (size - 1)] = i;
+    }
+
+    TRACE("indexed %u rows of %s\n", table->row_count, debugstr_w(table->name));
+    table->key_index = index;
+    table->key_index_size = size;
+    return ERROR_SUCCESS;
+}
+
+static BOOL table_use_key_index( MSITABLEVIEW *tv )
+{
+    MSITABLE *table = tv->table;
+
+    /* views extended by transforms carry their own column info */
+    if (tv->columns != table->colinfo || table->row_count < MSITABLE_KEY_INDEX_MIN_ROWS)
+        return FALSE;
+
+    if (table->key_index)
+        return TRUE;
+
+    /* Only build the index once the table is searched again without being
+     * modified in between; inserts check for duplicates first, so indexing
+     * on every lookup would rebuild it for each inserted row. */
+    if (!table->key_lookup)
+    {
+        table->key_lookup = TRUE;
+        return FALSE;
+    }
+    return table_build_key_index( tv ) == ERROR_SUCCESS;
+}
+
 static UINT msi_table_find_row( MSITABLEVIEW *tv, MSIRECORD *rec, UINT *row, UINT *column )
 {
     UINT i, r = ERROR_FUNCTION_FAILED, *data;
@@ -3151,6 +3266,24 @@ static UINT msi_table_find_row( MSITABLEVIEW *tv, MSIRECORD *rec, UINT *row, UIN
     data = msi_record_to_row( tv, rec );
     if( !data )
         return r;
+
+    if (table_use_key_index( tv ))
+    {
+        const UINT *index = tv->table->key_index, *chain = index + tv->table->key_index_size;
+
+        for (i = index[table_key_hash( tv, data ) & (tv->table->key_index_size - 1)]; i; i = chain[i - 1])
+        {
+            r = msi_row_matches( tv, i - 1, data, column );
+            if (r == ERROR_SUCCESS)
+            {
+                *row = i - 1;
+                break;
+            }
+        }
+        msi_free( data );
+        return r;
+    }
+
     for( i = 0; i < tv->table->row_count; i++ )
     {
         r = msi_row_matches( tv, i, data, column );
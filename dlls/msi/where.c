@@ -51,6 +51,11 @@ typedef struct tagJOINTABLE
     UINT col_count;
     UINT row_count;
     UINT table_index;
+    /* hash join on an equality with a column of an outer table */
+    const union ext_column *join_column;
+    const union ext_column *join_value;
+    UINT *join_index;     /* bucket heads, then chain links, row + 1 */
+    UINT join_index_size; /* number of buckets, a power of two */
 } JOINTABLE;
 
 typedef struct tagMSIORDERINFO
@@ -80,6 +85,9 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
 
 #define INITIAL_REORDER_SIZE 16
 
+/* inner tables smaller than this are joined by scanning */
+#define JOIN_INDEX_MIN_ROWS 16
+
 #define INVALID_ROW_INDEX (-1)
 
 static void free_reorder(MSIWHEREVIEW *wv)
@@ -646,15 +654,29 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static inline UINT join_hash( UINT value, UINT size )
+{
+    return (value * 0x9e3779b1) & (size - 1);
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    UINT r = ERROR_FUNCTION_FAILED, value, *row = &table_rows[(*tables)->table_index];
+    const UINT *chain = NULL;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    *row = 0;
+    if ((*tables)->join_index &&
+        expr_fetch_value( (*tables)->join_value, table_rows, &value ) == ERROR_SUCCESS && value)
+    {
+        /* only rows in the matching bucket can satisfy the join */
+        chain = (*tables)->join_index + (*tables)->join_index_size;
+        *row = (*tables)->join_index[join_hash( value, (*tables)->join_index_size )] - 1;
+        r = ERROR_SUCCESS;
+    }
+
+    for (; *row < (*tables)->row_count; *row = chain ? chain[*row] - 1 : *row + 1)
     {
         val = 0;
         wv->rec_index = 0;
@@ -785,6 +807,114 @@ static UINT reorder_check( const struct expr *expr, JOINTABLE **ordered_tables,
     }
 }
 
+static BOOL is_column_expr( const struct expr *expr )
+{
+    return expr->type == EXPR_COL_NUMBER || expr->type == EXPR_COL_NUMBER32 ||
+           expr->type == EXPR_COL_NUMBER_STRING;
+}
+
+/* checks whether other is evaluated before table in the join order */
+static BOOL table_precedes( JOINTABLE **ordered_tables, JOINTABLE *table, JOINTABLE *other )
+{
+    for (; *ordered_tables != table; ordered_tables++)
+        if (*ordered_tables == other) return TRUE;
+    return FALSE;
+}
+
+/* finds a column equality that must hold for the whole condition to be
+ * true, between a column of table and a column of an outer table */
+static BOOL find_join_column( const struct expr *expr, JOINTABLE **ordered_tables, JOINTABLE *table )
+{
+    const struct expr *left, *right;
+
+    if (expr->type != EXPR_COMPLEX && expr->type != EXPR_STRCMP)
+        return FALSE;
+
+    if (expr->type == EXPR_COMPLEX && expr->u.expr.op == OP_AND)
+        return find_join_column( expr->u.expr.left, ordered_tables, table ) ||
+               find_join_column( expr->u.expr.right, ordered_tables, table );
+
+    if (expr->u.expr.op != OP_EQ)
+        return FALSE;
+
+    left = expr->u.expr.left;
+    right = expr->u.expr.right;
+    if (!is_column_expr( left ) || left->type != right->type)
+        return FALSE;
+
+    if (right->u.column.parsed.table == table)
+    {
+        left = right;
+        right = expr->u.expr.left;
+    }
+    if (left->u.column.parsed.table != table ||
+        !table_precedes( ordered_tables, table, right->u.column.parsed.table ))
+        return FALSE;
+
+    table->join_column = &left->u.column;
+    table->join_value = &right->u.column;
+    return TRUE;
+}
+
+/* Hash the join column of every row, chaining rows in ascending order so
+ * matches are visited in the same order as a scan. */
+static UINT build_join_index( JOINTABLE *table )
+{
+    UINT size = 1, i, r, value, *index;
+
+    while (size < table->row_count)
+        size <<= 1;
+
+    if (!(index = msi_alloc_zero( (size + table->row_count) * sizeof(*index) )))
+        return ERROR_OUTOFMEMORY;
+
+    for (i = table->row_count; i > 0; i--)
+    {
+        r = table->view->ops->fetch_int( table->view, i - 1, table->join_column->parsed.column, &value );
+        if (r != ERROR_SUCCESS)
+        {
+            msi_free( index );
+            return r;
+        }
+        index[size + i - 1] = index[join_hash( value, size )];
+        index[join_hash( value, size )] = i;
+    }
+
+    table->join_index = index;
+    table->join_index_size = size;
+    return ERROR_SUCCESS;
+}
+
+static void create_join_indexes( MSIWHEREVIEW *wv, JOINTABLE **ordered_tables )
+{
+    JOINTABLE **table;
+
+    if (!wv->cond || !*ordered_tables)
+        return;
+
+    for (table = ordered_tables + 1; *table; table++)
+    {
+        if ((*table)->row_count < JOIN_INDEX_MIN_ROWS ||
+            !find_join_column( wv->cond, ordered_tables, *table ))
+            continue;
+
+        if (build_join_index( *table ) == ERROR_SUCCESS)
+            TRACE("hash joining %u rows on column %u\n", (*table)->row_count,
+                  (*table)->join_column->parsed.column);
+    }
+}
+
+static void free_join_indexes( MSIWHEREVIEW *wv )
+{
+    JOINTABLE *table;
+
+    for (table = wv->tables; table; table = table->next)
+    {
+        msi_free( table->join_index );
+        table->join_index = NULL;
+    }
+}
+
 /* reorders the tablelist in a way to evaluate the condition as fast as possible */
 static JOINTABLE **ordertables( MSIWHEREVIEW *wv )
 {
@@ -851,8 +981,12 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     for (i = 0; i < wv->table_count; i++)
         rows[i] = INVALID_ROW_INDEX;
 
+    create_join_indexes( wv, ordered_tables );
+
     r =  check_condition(wv, record, ordered_tables, rows);
 
+    free_join_indexes( wv );
+
     if (wv->order_info)
         wv->order_info->error = ERROR_SUCCESS;
 
@@ -1249,7 +1383,7 @@ UINT WHERE_CreateView( MSIDATABASE *db, MSIVIEW **view, LPWSTR tables,
         if ((ptr = wcschr(tables, ' ')))
             *ptr = '\0';
 
-        table = msi_alloc(sizeof(JOINTABLE));
+        table = msi_alloc_zero(sizeof(JOINTABLE));
         if (!table)
         {
             r = ERROR_OUTOFMEMORY;
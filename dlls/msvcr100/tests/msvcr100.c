@@ -170,8 +170,8 @@ struct SchedulerVtbl {
     unsigned int (__thiscall *Release)(Scheduler*);
     void (__thiscall *RegisterShutdownEvent)(Scheduler*,HANDLE);
     void (__thiscall *Attach)(Scheduler*);
-    /* CreateScheduleGroup */
-    /* ScheduleTask */
+    void* (__thiscall *CreateScheduleGroup)(Scheduler*);
+    void (__thiscall *ScheduleTask)(Scheduler*,void (__cdecl*)(void*),void*);
 };
 
 static int* (__cdecl *p_errno)(void);
@@ -956,11 +956,26 @@ static void test_ExternalContextBase(void)
     CloseHandle(thread);
 }
 
+static Scheduler *task_scheduler;
+static HANDLE task_event;
+static LONG task_count;
+
+static void __cdecl scheduled_task(void *data)
+{
+    Scheduler *current_scheduler = p_CurrentScheduler_Get();
+
+    ok(current_scheduler == task_scheduler, "CurrentScheduler::Get() = %p, expected %p\n",
+            current_scheduler, task_scheduler);
+    if(InterlockedIncrement(&task_count) == (LONG_PTR)data)
+        SetEvent(task_event);
+}
+
 static void test_Scheduler(void)
 {
     Scheduler *scheduler, *current_scheduler;
     SchedulerPolicy policy;
     unsigned int i;
+    DWORD ret;
 
     call_func1(p_SchedulerPolicy_ctor, &policy);
     scheduler = p_Scheduler_Create(&policy);
@@ -985,6 +1000,16 @@ static void test_Scheduler(void)
 
     i = call_func1(scheduler->vtable->GetNumberOfVirtualProcessors, scheduler);
     ok(i == 1, "Scheduler::GetNumberOfVirtualProcessors() = %u\n", i);
+
+    task_scheduler = scheduler;
+    task_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    for(i=0; i<16; i++)
+        call_func3(scheduler->vtable->ScheduleTask, scheduler, scheduled_task, (void*)16);
+    ret = WaitForSingleObject(task_event, 5000);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", ret);
+    ok(task_count == 16, "task_count = %d\n", task_count);
+    CloseHandle(task_event);
+
     call_func1(scheduler->vtable->Release, scheduler);
     call_func1(p_SchedulerPolicy_dtor, &policy);
 }
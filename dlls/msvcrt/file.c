@@ -101,6 +101,9 @@ static char utf16_bom[2] = { 0xff, 0xfe };
 #define MSVCRT_FD_BLOCK_SIZE 32
 
 #define MSVCRT_INTERNAL_BUFSIZ 4096
+/* buffers of streams that keep moving whole buffers to or from a disk file grow up to this size */
+#define MSVCRT_MAX_ADAPTIVE_BUFSIZ 0x10000
+#define MSVCRT_ADAPTIVE_BUF_TRANSFERS 16
 
 /* ioinfo structure size is different in msvcrXX.dll's */
 typedef struct {
@@ -136,9 +139,11 @@ ioinfo MSVCRT___badioinfo = { INVALID_HANDLE_VALUE, WX_TEXT };
 typedef struct {
     FILE file;
     CRITICAL_SECTION crit;
+    unsigned int transfers;
 } file_crit;
 
 FILE MSVCRT__iob[_IOB_ENTRIES] = { { 0 } };
+static unsigned int MSVCRT_iob_transfers[_IOB_ENTRIES];
 static file_crit* MSVCRT_fstream[MSVCRT_MAX_FILES/MSVCRT_FD_BLOCK_SIZE];
 static int MSVCRT_max_streams = 512, MSVCRT_stream_idx;
 
@@ -672,10 +677,21 @@ void msvcrt_init_io(void)
 }
 
 /* INTERNAL: Flush stdio file buffer */
+/* INTERNAL: Get the number of consecutive full buffer transfers of a stream */
+static unsigned int *msvcrt_get_transfers(FILE *file)
+{
+    if(file>=MSVCRT__iob && file<MSVCRT__iob+_IOB_ENTRIES)
+        return &MSVCRT_iob_transfers[file-MSVCRT__iob];
+    return &((file_crit*)file)->transfers;
+}
+
 static int msvcrt_flush_buffer(FILE* file)
 {
     int ret = 0;
 
+    /* anything but a sequential stream of full buffers ends the streak */
+    *msvcrt_get_transfers(file) = 0;
+
     if((file->_flag & (_IOREAD|_IOWRT)) == _IOWRT &&
             file->_flag & (_IOMYBUF|MSVCRT__USERBUF)) {
         int cnt=file->_ptr-file->_base;
@@ -709,6 +725,7 @@ static BOOL msvcrt_alloc_buffer(FILE* file)
             && _isatty(file->_file))
         return FALSE;
 
+    *msvcrt_get_transfers(file) = 0;
     file->_base = calloc(1, MSVCRT_INTERNAL_BUFSIZ);
     if(file->_base) {
         file->_bufsiz = MSVCRT_INTERNAL_BUFSIZ;
@@ -723,6 +740,32 @@ static BOOL msvcrt_alloc_buffer(FILE* file)
     return TRUE;
 }
 
+/* INTERNAL: Record the number of consecutive full buffer transfers and grow
+ * the buffer of sequentially accessed disk files, which cuts down on
+ * ReadFile/WriteFile calls. The buffer must be empty. */
+static void msvcrt_buffer_transferred(FILE *file, unsigned int transfers)
+{
+    char *base;
+    int bufsiz;
+
+    *msvcrt_get_transfers(file) = transfers;
+    if(transfers < MSVCRT_ADAPTIVE_BUF_TRANSFERS || !(file->_flag & _IOMYBUF)
+            || file->_bufsiz >= MSVCRT_MAX_ADAPTIVE_BUFSIZ)
+        return;
+
+    *msvcrt_get_transfers(file) = 0;
+    if(GetFileType(get_ioinfo_nolock(file->_file)->handle) != FILE_TYPE_DISK)
+        return;
+
+    bufsiz = min(file->_bufsiz * 4, MSVCRT_MAX_ADAPTIVE_BUFSIZ);
+    if(!(base = realloc(file->_base, bufsiz)))
+        return;
+
+    TRACE("growing buffer of %p to %d bytes\n", file, bufsiz);
+    file->_base = file->_ptr = base;
+    file->_bufsiz = bufsiz;
+}
+
 /* INTERNAL: Allocate temporary buffer for stdout and stderr */
 static BOOL add_std_buffer(FILE *file)
 {
@@ -3685,12 +3728,18 @@ int CDECL _filbuf(FILE* file)
 
         return c;
     } else {
+        unsigned int transfers;
+
+        msvcrt_buffer_transferred(file, *msvcrt_get_transfers(file));
+        transfers = *msvcrt_get_transfers(file);
+
         file->_cnt = _read(file->_file, file->_base, file->_bufsiz);
         if(file->_cnt<=0) {
             file->_flag |= (file->_cnt == 0) ? _IOEOF : _IOERR;
             file->_cnt = 0;
             return EOF;
         }
+        *msvcrt_get_transfers(file) = file->_cnt == file->_bufsiz ? transfers + 1 : 0;
 
         file->_cnt--;
         file->_ptr = file->_base+1;
@@ -3943,9 +3992,14 @@ int CDECL _flsbuf(int c, FILE* file)
         int res = 0;
 
         if(file->_cnt <= 0) {
+            unsigned int transfers = *msvcrt_get_transfers(file);
+            BOOL full = file->_ptr - file->_base >= file->_bufsiz;
+
             res = msvcrt_flush_buffer(file);
             if(res)
                 return res;
+            if(full)
+                msvcrt_buffer_transferred(file, transfers + 1);
             file->_flag |= _IOWRT;
             file->_cnt=file->_bufsiz;
         }
@@ -4298,8 +4352,13 @@ size_t CDECL _fread_nolock(void *ptr, size_t size, size_t nmemb, FILE* file)
   {
     int i;
     if (!file->_cnt && rcnt<file->_bufsiz && (file->_flag & (_IOMYBUF | MSVCRT__USERBUF))) {
+      unsigned int transfers;
+
+      msvcrt_buffer_transferred(file, *msvcrt_get_transfers(file));
+      transfers = *msvcrt_get_transfers(file);
       i = _read(file->_file, file->_base, file->_bufsiz);
       file->_ptr = file->_base;
+      *msvcrt_get_transfers(file) = i == file->_bufsiz ? transfers + 1 : 0;
       if (i != -1) {
           file->_cnt = i;
           if (i > rcnt) i = rcnt;
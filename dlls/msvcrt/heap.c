@@ -40,8 +40,14 @@ WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
       ~(alignment - 1)) - offset))
 
 #define SB_HEAP_ALIGN 16
+/* small blocks store a cookie and the heap block pointer before the data */
+#define SB_ALIGN_PTR(ptr) ((void *)(((DWORD_PTR)(ptr) + 2 * sizeof(void *) + \
+                SB_HEAP_ALIGN - 1) & ~(DWORD_PTR)(SB_HEAP_ALIGN - 1)))
+#define SB_COOKIE(ptr) (((DWORD_PTR *)SAVED_PTR(ptr))[-1])
+#define SB_OVERHEAD (2 * sizeof(void *) + SB_HEAP_ALIGN)
 
 static HANDLE heap, sb_heap;
+static DWORD_PTR sb_heap_cookie;
 
 typedef int (CDECL *MSVCRT_new_handler_func)(size_t size);
 
@@ -53,18 +59,30 @@ static unsigned int MSVCRT_amblksiz = 16;
 /* FIXME - According to documentation it should be 480 bytes, at runtime default is 0 */
 static size_t MSVCRT_sbh_threshold = 0;
 
+/* Checking the cookie first avoids validating the whole heap block
+ * on every free() once the small blocks heap was enabled. */
+static inline BOOL msvcrt_is_sb_block(void *ptr)
+{
+    if(!sb_heap || !ptr || ((DWORD_PTR)ptr & (SB_HEAP_ALIGN - 1)))
+        return FALSE;
+    if(SB_COOKIE(ptr) != ((DWORD_PTR)ptr ^ sb_heap_cookie))
+        return FALSE;
+    return HeapValidate(sb_heap, 0, *(void **)SAVED_PTR(ptr));
+}
+
 static void* msvcrt_heap_alloc(DWORD flags, size_t size)
 {
     if(size < MSVCRT_sbh_threshold)
     {
         void *memblock, *temp, **saved;
 
-        temp = HeapAlloc(sb_heap, flags, size+sizeof(void*)+SB_HEAP_ALIGN);
+        temp = HeapAlloc(sb_heap, flags, size+SB_OVERHEAD);
         if(!temp) return NULL;
 
-        memblock = ALIGN_PTR(temp, SB_HEAP_ALIGN, 0);
+        memblock = SB_ALIGN_PTR(temp);
         saved = SAVED_PTR(memblock);
         *saved = temp;
+        SB_COOKIE(memblock) = (DWORD_PTR)memblock ^ sb_heap_cookie;
         return memblock;
     }
 
@@ -73,7 +91,7 @@ static void* msvcrt_heap_alloc(DWORD flags, size_t size)
 
 static void* msvcrt_heap_realloc(DWORD flags, void *ptr, size_t size)
 {
-    if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
+    if(msvcrt_is_sb_block(ptr))
     {
         /* TODO: move data to normal heap if it exceeds sbh_threshold limit */
         void *memblock, *temp, **saved;
@@ -86,10 +104,10 @@ static void* msvcrt_heap_realloc(DWORD flags, void *ptr, size_t size)
             return NULL;
         old_size -= old_padding;
 
-        temp = HeapReAlloc(sb_heap, flags, *saved, size+sizeof(void*)+SB_HEAP_ALIGN);
+        temp = HeapReAlloc(sb_heap, flags, *saved, size+SB_OVERHEAD);
         if(!temp) return NULL;
 
-        memblock = ALIGN_PTR(temp, SB_HEAP_ALIGN, 0);
+        memblock = SB_ALIGN_PTR(temp);
         saved = SAVED_PTR(memblock);
         new_padding = (char*)memblock - (char*)temp;
 
@@ -97,6 +115,7 @@ static void* msvcrt_heap_realloc(DWORD flags, void *ptr, size_t size)
             memmove(memblock, (char*)temp+old_padding, old_size>size ? size : old_size);
 
         *saved = temp;
+        SB_COOKIE(memblock) = (DWORD_PTR)memblock ^ sb_heap_cookie;
         return memblock;
     }
 
@@ -105,9 +124,10 @@ static void* msvcrt_heap_realloc(DWORD flags, void *ptr, size_t size)
 
 static BOOL msvcrt_heap_free(void *ptr)
 {
-    if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
+    if(msvcrt_is_sb_block(ptr))
     {
         void **saved = SAVED_PTR(ptr);
+        SB_COOKIE(ptr) = 0;
         return HeapFree(sb_heap, 0, *saved);
     }
 
@@ -116,7 +136,7 @@ static BOOL msvcrt_heap_free(void *ptr)
 
 static size_t msvcrt_heap_size(void *ptr)
 {
-    if(sb_heap && ptr && !HeapValidate(heap, 0, ptr))
+    if(msvcrt_is_sb_block(ptr))
     {
         void **saved = SAVED_PTR(ptr);
         return HeapSize(sb_heap, 0, *saved);
@@ -531,10 +551,12 @@ int CDECL _set_sbh_threshold(size_t threshold)
   if(!sb_heap)
   {
       ULONG hci = 2;
-      sb_heap = HeapCreate(0, 0, 0);
-      HeapSetInformation(sb_heap, HeapCompatibilityInformation, &hci, sizeof(hci));
-      if(!sb_heap)
+      HANDLE new_heap = HeapCreate(0, 0, 0);
+      if(!new_heap)
           return 0;
+      HeapSetInformation(new_heap, HeapCompatibilityInformation, &hci, sizeof(hci));
+      sb_heap_cookie = (DWORD_PTR)new_heap ^ GetTickCount() ^ ((DWORD_PTR)GetCurrentProcessId() << 16);
+      sb_heap = new_heap;
   }
 
   MSVCRT_sbh_threshold = (threshold+0xf) & ~0xf;
@@ -39,9 +39,13 @@
 #include <stdio.h>
 #include <fenv.h>
 #include <fpieee.h>
+#include <float.h>
 #include <limits.h>
 #include <locale.h>
 #include <math.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
 
 #include "msvcrt.h"
 #include "winternl.h"
@@ -65,6 +69,7 @@ typedef int (CDECL *MSVCRT_matherr_func)(struct _exception *);
 static MSVCRT_matherr_func MSVCRT_default_matherr_func = NULL;
 
 BOOL sse2_supported;
+BOOL erms_supported;
 static BOOL sse2_enabled;
 
 static const struct unix_funcs *unix_funcs;
@@ -72,6 +77,19 @@ static const struct unix_funcs *unix_funcs;
 void msvcrt_init_math( void *module )
 {
     sse2_supported = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE );
+#if defined(__i386__) || defined(__x86_64__)
+    {
+        int regs[4];
+
+        /* enhanced rep movsb/stosb, there is no processor feature flag for it */
+        __cpuid( regs, 0 );
+        if (regs[0] >= 7)
+        {
+            __cpuidex( regs, 7, 0 );
+            erms_supported = (regs[1] >> 9) & 1;
+        }
+    }
+#endif
 #if _MSVCR_VER <=71
     sse2_enabled = FALSE;
 #else
@@ -174,6 +192,350 @@ int CDECL _set_SSE2_enable(int flag)
     return sse2_enabled;
 }
 
+/* Fast paths for exp, log and sin on the arguments that can't raise any
+ * error, evaluated without going through the host libm. They are faithfully
+ * rounded (below 1 ulp of error) and almost always agree with glibc. */
+
+/* 2^(i/128) split into a double and the rounding error of that double */
+static const double exp_table[128][2] =
+{
+    { 0x1.0000000000000p+0, 0x0.0p+0 },
+    { 0x1.0163da9fb3335p+0, 0x1.b61299ab8cdb7p-54 },
+    { 0x1.02c9a3e778061p+0, -0x1.19083535b085dp-56 },
+    { 0x1.04315e86e7f85p+0, -0x1.0a31c1977c96ep-54 },
+    { 0x1.059b0d3158574p+0, 0x1.d73e2a475b465p-55 },
+    { 0x1.0706b29ddf6dep+0, -0x1.c91dfe2b13c27p-55 },
+    { 0x1.0874518759bc8p+0, 0x1.186be4bb284ffp-57 },
+    { 0x1.09e3ecac6f383p+0, 0x1.1487818316136p-54 },
+    { 0x1.0b5586cf9890fp+0, 0x1.8a62e4adc610bp-54 },
+    { 0x1.0cc922b7247f7p+0, 0x1.01edc16e24f71p-54 },
+    { 0x1.0e3ec32d3d1a2p+0, 0x1.03a1727c57b53p-59 },
+    { 0x1.0fb66affed31bp+0, -0x1.b9bedc44ebd7bp-57 },
+    { 0x1.11301d0125b51p+0, -0x1.6c51039449b3ap-54 },
+    { 0x1.12abdc06c31ccp+0, -0x1.1b514b36ca5c7p-58 },
+    { 0x1.1429aaea92de0p+0, -0x1.32fbf9af1369ep-54 },
+    { 0x1.15a98c8a58e51p+0, 0x1.2406ab9eeab0ap-55 },
+    { 0x1.172b83c7d517bp+0, -0x1.19041b9d78a76p-55 },
+    { 0x1.18af9388c8deap+0, -0x1.11023d1970f6cp-54 },
+    { 0x1.1a35beb6fcb75p+0, 0x1.e5b4c7b4968e4p-55 },
+    { 0x1.1bbe084045cd4p+0, -0x1.95386352ef607p-54 },
+    { 0x1.1d4873168b9aap+0, 0x1.e016e00a2643cp-54 },
+    { 0x1.1ed5022fcd91dp+0, -0x1.1df98027bb78cp-54 },
+    { 0x1.2063b88628cd6p+0, 0x1.dc775814a8495p-55 },
+    { 0x1.21f49917ddc96p+0, 0x1.2a97e9494a5eep-55 },
+    { 0x1.2387a6e756238p+0, 0x1.9b07eb6c70573p-54 },
+    { 0x1.251ce4fb2a63fp+0, 0x1.ac155bef4f4a4p-55 },
+    { 0x1.26b4565e27cddp+0, 0x1.2bd339940e9d9p-55 },
+    { 0x1.284dfe1f56381p+0, -0x1.a4c3a8c3f0d7ep-54 },
+    { 0x1.29e9df51fdee1p+0, 0x1.612e8afad1255p-55 },
+    { 0x1.2b87fd0dad990p+0, -0x1.10adcd6381aa4p-59 },
+    { 0x1.2d285a6e4030bp+0, 0x1.0024754db41d5p-54 },
+    { 0x1.2ecafa93e2f56p+0, 0x1.1ca0f45d52383p-56 },
+    { 0x1.306fe0a31b715p+0, 0x1.6f46ad23182e4p-55 },
+    { 0x1.32170fc4cd831p+0, 0x1.a9ce78e18047cp-55 },
+    { 0x1.33c08b26416ffp+0, 0x1.32721843659a6p-54 },
+    { 0x1.356c55f929ff1p+0, -0x1.b5cee5c4e4628p-55 },
+    { 0x1.371a7373aa9cbp+0, -0x1.63aeabf42eae2p-54 },
+    { 0x1.38cae6d05d866p+0, -0x1.e958d3c9904bdp-54 },
+    { 0x1.3a7db34e59ff7p+0, -0x1.5e436d661f5e3p-56 },
+    { 0x1.3c32dc313a8e5p+0, -0x1.efff8375d29c3p-54 },
+    { 0x1.3dea64c123422p+0, 0x1.ada0911f09ebcp-55 },
+    { 0x1.3fa4504ac801cp+0, -0x1.7d023f956f9f3p-54 },
+    { 0x1.4160a21f72e2ap+0, -0x1.ef3691c309278p-58 },
+    { 0x1.431f5d950a897p+0, -0x1.1c7dde35f7999p-55 },
+    { 0x1.44e086061892dp+0, 0x1.89b7a04ef80d0p-59 },
+    { 0x1.46a41ed1d0057p+0, 0x1.c944bd1648a76p-54 },
+    { 0x1.486a2b5c13cd0p+0, 0x1.3c1a3b69062f0p-56 },
+    { 0x1.4a32af0d7d3dep+0, 0x1.9cb62f3d1be56p-54 },
+    { 0x1.4bfdad5362a27p+0, 0x1.d4397afec42e2p-56 },
+    { 0x1.4dcb299fddd0dp+0, 0x1.8ecdbbc6a7833p-54 },
+    { 0x1.4f9b2769d2ca7p+0, -0x1.4b309d25957e3p-54 },
+    { 0x1.516daa2cf6642p+0, -0x1.f768569bd93efp-55 },
+    { 0x1.5342b569d4f82p+0, -0x1.07abe1db13cadp-55 },
+    { 0x1.551a4ca5d920fp+0, -0x1.d689cefede59bp-55 },
+    { 0x1.56f4736b527dap+0, 0x1.9bb2c011d93adp-54 },
+    { 0x1.58d12d497c7fdp+0, 0x1.295e15b9a1de8p-55 },
+    { 0x1.5ab07dd485429p+0, 0x1.6324c054647adp-54 },
+    { 0x1.5c9268a5946b7p+0, 0x1.c4b1b816986a2p-60 },
+    { 0x1.5e76f15ad2148p+0, 0x1.ba6f93080e65ep-54 },
+    { 0x1.605e1b976dc09p+0, -0x1.3e2429b56de47p-54 },
+    { 0x1.6247eb03a5585p+0, -0x1.383c17e40b497p-54 },
+    { 0x1.6434634ccc320p+0, -0x1.c483c759d8933p-55 },
+    { 0x1.6623882552225p+0, -0x1.bb60987591c34p-54 },
+    { 0x1.68155d44ca973p+0, 0x1.038ae44f73e65p-57 },
+    { 0x1.6a09e667f3bcdp+0, -0x1.bdd3413b26456p-54 },
+    { 0x1.6c012750bdabfp+0, -0x1.2895667ff0b0dp-56 },
+    { 0x1.6dfb23c651a2fp+0, -0x1.bbe3a683c88abp-57 },
+    { 0x1.6ff7df9519484p+0, -0x1.83c0f25860ef6p-55 },
+    { 0x1.71f75e8ec5f74p+0, -0x1.16e4786887a99p-55 },
+    { 0x1.73f9a48a58174p+0, -0x1.0a8d96c65d53cp-54 },
+    { 0x1.75feb564267c9p+0, -0x1.0245957316dd3p-54 },
+    { 0x1.780694fde5d3fp+0, 0x1.866b80a02162dp-54 },
+    { 0x1.7a11473eb0187p+0, -0x1.41577ee04992fp-55 },
+    { 0x1.7c1ed0130c132p+0, 0x1.f124cd1164dd6p-54 },
+    { 0x1.7e2f336cf4e62p+0, 0x1.05d02ba15797ep-56 },
+    { 0x1.80427543e1a12p+0, -0x1.27c86626d972bp-54 },
+    { 0x1.82589994cce13p+0, -0x1.d4c1dd41532d8p-54 },
+    { 0x1.8471a4623c7adp+0, -0x1.8d684a341cdfbp-55 },
+    { 0x1.868d99b4492edp+0, -0x1.fc6f89bd4f6bap-54 },
+    { 0x1.88ac7d98a6699p+0, 0x1.994c2f37cb53ap-54 },
+    { 0x1.8ace5422aa0dbp+0, 0x1.6e9f156864b27p-54 },
+    { 0x1.8cf3216b5448cp+0, -0x1.0d55e32e9e3aap-56 },
+    { 0x1.8f1ae99157736p+0, 0x1.5cc13a2e3976cp-55 },
+    { 0x1.9145b0b91ffc6p+0, -0x1.dd6792e582524p-54 },
+    { 0x1.93737b0cdc5e5p+0, -0x1.75fc781b57ebcp-57 },
+    { 0x1.95a44cbc8520fp+0, -0x1.64b7c96a5f039p-56 },
+    { 0x1.97d829fde4e50p+0, -0x1.d185b7c1b85d1p-54 },
+    { 0x1.9a0f170ca07bap+0, -0x1.173bd91cee632p-54 },
+    { 0x1.9c49182a3f090p+0, 0x1.c7c46b071f2bep-56 },
+    { 0x1.9e86319e32323p+0, 0x1.824ca78e64c6ep-56 },
+    { 0x1.a0c667b5de565p+0, -0x1.359495d1cd533p-54 },
+    { 0x1.a309bec4a2d33p+0, 0x1.6305c7ddc36abp-54 },
+    { 0x1.a5503b23e255dp+0, -0x1.d2f6edb8d41e1p-54 },
+    { 0x1.a799e1330b358p+0, 0x1.bcb7ecac563c7p-54 },
+    { 0x1.a9e6b5579fdbfp+0, 0x1.0fac90ef7fd31p-54 },
+    { 0x1.ac36bbfd3f37ap+0, -0x1.f9234cae76cd0p-55 },
+    { 0x1.ae89f995ad3adp+0, 0x1.7a1cd345dcc81p-54 },
+    { 0x1.b0e07298db666p+0, -0x1.bdef54c80e425p-54 },
+    { 0x1.b33a2b84f15fbp+0, -0x1.2805e3084d708p-57 },
+    { 0x1.b59728de5593ap+0, -0x1.c71dfbbba6de3p-54 },
+    { 0x1.b7f76f2fb5e47p+0, -0x1.5584f7e54ac3bp-56 },
+    { 0x1.ba5b030a1064ap+0, -0x1.efcd30e54292ep-54 },
+    { 0x1.bcc1e904bc1d2p+0, 0x1.23dd07a2d9e84p-55 },
+    { 0x1.bf2c25bd71e09p+0, -0x1.efdca3f6b9c73p-54 },
+    { 0x1.c199bdd85529cp+0, 0x1.11065895048ddp-55 },
+    { 0x1.c40ab5fffd07ap+0, 0x1.b4537e083c60ap-54 },
+    { 0x1.c67f12e57d14bp+0, 0x1.2884dff483cadp-54 },
+    { 0x1.c8f6d9406e7b5p+0, 0x1.1acbc48805c44p-56 },
+    { 0x1.cb720dcef9069p+0, 0x1.503cbd1e949dbp-56 },
+    { 0x1.cdf0b555dc3fap+0, -0x1.dd83b53829d72p-55 },
+    { 0x1.d072d4a07897cp+0, -0x1.cbc3743797a9cp-54 },
+    { 0x1.d2f87080d89f2p+0, -0x1.d487b719d8578p-54 },
+    { 0x1.d5818dcfba487p+0, 0x1.2ed02d75b3707p-55 },
+    { 0x1.d80e316c98398p+0, -0x1.11ec18beddfe8p-54 },
+    { 0x1.da9e603db3285p+0, 0x1.c2300696db532p-54 },
+    { 0x1.dd321f301b460p+0, 0x1.2da5778f018c3p-54 },
+    { 0x1.dfc97337b9b5fp+0, -0x1.1a5cd4f184b5cp-54 },
+    { 0x1.e264614f5a129p+0, -0x1.7b627817a1496p-54 },
+    { 0x1.e502ee78b3ff6p+0, 0x1.39e8980a9cc8fp-55 },
+    { 0x1.e7a51fbc74c83p+0, 0x1.2d522ca0c8de2p-54 },
+    { 0x1.ea4afa2a490dap+0, -0x1.e9c23179c2893p-54 },
+    { 0x1.ecf482d8e67f1p+0, -0x1.c93f3b411ad8cp-54 },
+    { 0x1.efa1bee615a27p+0, 0x1.dc7f486a4b6b0p-54 },
+    { 0x1.f252b376bba97p+0, 0x1.3a1a5bf0d8e43p-54 },
+    { 0x1.f50765b6e4540p+0, 0x1.9d3e12dd8a18bp-54 },
+    { 0x1.f7bfdad9cbe14p+0, -0x1.dbb12d006350ap-54 },
+    { 0x1.fa7c1819e90d8p+0, 0x1.74853f3a5931ep-55 },
+    { 0x1.fd3c22b8f71f1p+0, 0x1.2eb74966579e7p-57 },
+};
+/* 1/c, log(c) and the rounding error of log(c) for the centre c of each interval */
+static const double log_table[128][3] =
+{
+    { 0x1.734f0c541fe8dp+0, -0x1.7cc7f7db46a0ep-2, 0x1.8438023cdc3d3p-56 },
+    { 0x1.713786d9c7c09p+0, -0x1.76feecb947175p-2, 0x1.118d9eb4ea362p-56 },
+    { 0x1.6f26016f26017p+0, -0x1.713e33a46a17cp-2, 0x1.9367a05ae38d3p-56 },
+    { 0x1.6d1a62681c861p+0, -0x1.6b85b4cffa3fdp-2, 0x1.8af2c8dafcb08p-57 },
+    { 0x1.6b1490aa31a3dp+0, -0x1.65d558d4ce00bp-2, 0x1.7605a4748480ap-56 },
+    { 0x1.691473a88d0c0p+0, -0x1.602d08af091ecp-2, 0x1.6e8920c09b73fp-58 },
+    { 0x1.6719f3601671ap+0, -0x1.5a8cadbbedfa1p-2, 0x1.e6c2bdfb3e037p-58 },
+    { 0x1.6524f853b4aa3p+0, -0x1.54f431b7be1a9p-2, 0x1.aacfdbbdab914p-56 },
+    { 0x1.63356b88ac0dep+0, -0x1.4f637ebba9810p-2, 0x1.58cb3124b9245p-56 },
+    { 0x1.614b36831ae94p+0, -0x1.49da7f3bcc41fp-2, 0x1.9964a168ccacap-57 },
+    { 0x1.5f66434292dfcp+0, -0x1.44591e0539f49p-2, 0x1.2b125247b0fa5p-56 },
+    { 0x1.5d867c3ece2a5p+0, -0x1.3edf463c1683ep-2, -0x1.83d680d3c1084p-56 },
+    { 0x1.5babcc647fa91p+0, -0x1.396ce359bbf54p-2, 0x1.ce2b31b31e8b0p-58 },
+    { 0x1.59d61f123ccaap+0, -0x1.3401e12aecba1p-2, 0x1.cd55b8a4746c0p-58 },
+    { 0x1.5805601580560p+0, -0x1.2e9e2bce12286p-2, -0x1.8251a3b83d97ap-62 },
+    { 0x1.56397ba7c52e2p+0, -0x1.2941afb186b7cp-2, 0x1.856e61c515740p-57 },
+    { 0x1.54725e6bb82fep+0, -0x1.23ec5991eba49p-2, -0x1.bb75d1addf870p-60 },
+    { 0x1.52aff56a8054bp+0, -0x1.1e9e1678899f4p-2, -0x1.512c3749a1e4ep-56 },
+    { 0x1.50f22e111c4c5p+0, -0x1.1956d3b9bc2fap-2, -0x1.7b9d68d50a15dp-56 },
+    { 0x1.4f38f62dd4c9bp+0, -0x1.14167ef367783p-2, -0x1.e0936abd4fa6ep-62 },
+    { 0x1.4d843bedc2c4cp+0, -0x1.0edd060b78081p-2, 0x1.92b49ef282b09p-57 },
+    { 0x1.4bd3edda68fe1p+0, -0x1.09aa572e6c6d4p-2, -0x1.43c2e68684d53p-57 },
+    { 0x1.4a27fad76014ap+0, -0x1.047e60cde83b8p-2, 0x1.0779634061cbcp-56 },
+    { 0x1.4880522014880p+0, -0x1.feb2233ea07cdp-3, -0x1.8de00938b4c40p-61 },
+    { 0x1.46dce34596066p+0, -0x1.f474b134df229p-3, 0x1.27c77ded76aadp-58 },
+    { 0x1.453d9e2c776cap+0, -0x1.ea4449f04aaf5p-3, 0x1.d33919ab94074p-57 },
+    { 0x1.43a2730abee4dp+0, -0x1.e020cc6235ab5p-3, -0x1.fea48dd7b81d1p-58 },
+    { 0x1.420b5265e5951p+0, -0x1.d60a17f903515p-3, 0x1.c0df841a71b7ap-57 },
+    { 0x1.40782d10e6566p+0, -0x1.cc000c9db3c52p-3, -0x1.53d154280394fp-57 },
+    { 0x1.3ee8f42a5af07p+0, -0x1.c2028ab17f9b4p-3, -0x1.f11aa3853a5f1p-57 },
+    { 0x1.3d5d991aa75c6p+0, -0x1.b811730b823d2p-3, -0x1.a0ee735d9f0ecp-60 },
+    { 0x1.3bd60d9232955p+0, -0x1.ae2ca6f672bd4p-3, -0x1.ab5ca9eaa088ap-57 },
+    { 0x1.3a524387ac822p+0, -0x1.a454082e6ab05p-3, -0x1.df207dc5c34c6p-58 },
+    { 0x1.38d22d366088ep+0, -0x1.9a8778debaa38p-3, -0x1.f47dfd871f87fp-57 },
+    { 0x1.3755bd1c945eep+0, -0x1.90c6db9fcbcd9p-3, -0x1.054473941ad99p-57 },
+    { 0x1.35dce5f9f2af8p+0, -0x1.871213750e994p-3, -0x1.d685f35eea2a0p-57 },
+    { 0x1.34679ace01346p+0, -0x1.7d6903caf5ad0p-3, 0x1.ac5f0c075b847p-59 },
+    { 0x1.32f5ced6a1dfap+0, -0x1.73cb9074fd14dp-3, 0x1.521a000b4cf01p-57 },
+    { 0x1.3187758e9ebb6p+0, -0x1.6a399dabbd383p-3, -0x1.96332bd4b341fp-57 },
+    { 0x1.301c82ac40260p+0, -0x1.60b3100b09476p-3, 0x1.5b2623e05016bp-58 },
+    { 0x1.2eb4ea1fed14bp+0, -0x1.5737cc9018cddp-3, -0x1.4f4d710fec38ep-57 },
+    { 0x1.2d50a012d50a0p+0, -0x1.4dc7b897bc1c8p-3, 0x1.927d47803c5f4p-57 },
+    { 0x1.2bef98e5a3711p+0, -0x1.4462b9dc9b3dcp-3, 0x1.629c46c186385p-58 },
+    { 0x1.2a91c92f3c105p+0, -0x1.3b08b6757f2a9p-3, -0x1.70d6cdf05266cp-60 },
+    { 0x1.293725bb804a5p+0, -0x1.31b994d3a4f85p-3, 0x1.c4716bdfc0cc9p-58 },
+    { 0x1.27dfa38a1ce4dp+0, -0x1.28753bc11aba5p-3, 0x1.6394d9fa33311p-57 },
+    { 0x1.268b37cd60127p+0, -0x1.1f3b925f25d41p-3, -0x1.62c9ef939ac5dp-59 },
+    { 0x1.2539d7e9177b2p+0, -0x1.160c8024b27b1p-3, 0x1.2d56ff61c2bfbp-57 },
+    { 0x1.23eb79717605bp+0, -0x1.0ce7ecdccc28dp-3, 0x1.692a0055dc959p-57 },
+    { 0x1.22a0122a0122ap+0, -0x1.03cdc0a51ec0dp-3, -0x1.39e2d3f8b7d10p-57 },
+    { 0x1.21579804855e6p+0, -0x1.f57bc7d9005dbp-4, 0x1.9361574fb24e2p-58 },
+    { 0x1.2012012012012p+0, -0x1.e3707ee30487bp-4, -0x1.09ccecd579d99p-58 },
+    { 0x1.1ecf43c7fb84cp+0, -0x1.d179788219364p-4, -0x1.9daf7df76ad2ap-59 },
+    { 0x1.1d8f5672e4abdp+0, -0x1.bf968769fca11p-4, 0x1.cdc9f6f5f38c7p-59 },
+    { 0x1.1c522fc1ce059p+0, -0x1.adc77ee5aea8cp-4, -0x1.37d8f39bee659p-58 },
+    { 0x1.1b17c67f2bae3p+0, -0x1.9c0c32d4d2548p-4, -0x1.fb0be3ccc1532p-59 },
+    { 0x1.19e0119e0119ep+0, -0x1.8a6477a91dc29p-4, 0x1.fa83214904842p-59 },
+    { 0x1.18ab083902bdbp+0, -0x1.78d02263d82d3p-4, -0x1.abca5b4fdb880p-58 },
+    { 0x1.1778a191bd684p+0, -0x1.674f089365a7ap-4, 0x1.9acd8b33f8fdcp-58 },
+    { 0x1.1648d50fc3201p+0, -0x1.55e10050e0384p-4, 0x1.45f9d61c68c1bp-58 },
+    { 0x1.151b9a3fdd5c9p+0, -0x1.4485e03dbdfadp-4, -0x1.1ba349aadbc6ep-58 },
+    { 0x1.13f0e8d344724p+0, -0x1.333d7f8183f4bp-4, -0x1.a92afc8ef70b1p-58 },
+    { 0x1.12c8b89edc0acp+0, -0x1.2207b5c78549ep-4, 0x1.cc0fbce104eaap-58 },
+    { 0x1.11a3019a74826p+0, -0x1.10e45b3cae831p-4, 0x1.a4a128d192686p-58 },
+    { 0x1.107fbbe011080p+0, -0x1.ffa6911ab9301p-5, 0x1.cd9f1f95c2eedp-59 },
+    { 0x1.0f5edfab325a2p+0, -0x1.dda8adc67ee4ep-5, -0x1.4e6c986f44c55p-59 },
+    { 0x1.0e40655826011p+0, -0x1.bbcebfc68f420p-5, -0x1.e5cf3a0f56f72p-60 },
+    { 0x1.0d24456359e3ap+0, -0x1.9a187b573de7cp-5, 0x1.727626c86b3abp-59 },
+    { 0x1.0c0a7868b4171p+0, -0x1.788595a3577bap-5, -0x1.e5ef898b67923p-59 },
+    { 0x1.0af2f722eecb5p+0, -0x1.5715c4c03ceefp-5, 0x1.bbf88ec501b56p-61 },
+    { 0x1.09ddba6af8360p+0, -0x1.35c8bfaa1306bp-5, 0x1.50830a65543a4p-63 },
+    { 0x1.08cabb37565e2p+0, -0x1.149e3e4005a8dp-5, 0x1.53482d1f9d7d7p-61 },
+    { 0x1.07b9f29b8eae2p+0, -0x1.e72bf2813ce51p-6, -0x1.75b44595cab18p-60 },
+    { 0x1.06ab59c7912fbp+0, -0x1.a55f548c5c43fp-6, -0x1.ec1a5f86d41f9p-62 },
+    { 0x1.059eea0727586p+0, -0x1.63d6178690bd6p-6, 0x1.8ed4d357c9c97p-64 },
+    { 0x1.04949cc1664c5p+0, -0x1.228fb1fea2e28p-6, 0x1.cd7b66e01c26dp-61 },
+    { 0x1.038c6b78247fcp+0, -0x1.c317384c75f06p-7, -0x1.806208c04c220p-61 },
+    { 0x1.02864fc7729e9p+0, -0x1.41929f96832f0p-7, 0x1.c5517f64bc223p-61 },
+    { 0x1.0182436517a37p+0, -0x1.8121214586b54p-8, -0x1.c14b9f9377a1dp-65 },
+    { 0x1.0080402010080p+0, -0x1.0040155d5889ep-9, 0x1.8f98e1113f403p-65 },
+    { 0x1.fe01fe01fe020p-1, 0x1.ff00aa2b10bc0p-9, 0x1.2821ad5a6d353p-63 },
+    { 0x1.fa11caa01fa12p-1, 0x1.7dc475f810a77p-7, -0x1.16d7687d3df21p-62 },
+    { 0x1.f6310aca0dbb5p-1, 0x1.3cea44346a575p-6, -0x1.0cb5a902b3a1cp-62 },
+    { 0x1.f25f644230ab5p-1, 0x1.b9fc027af9198p-6, -0x1.0ae69229dc868p-64 },
+    { 0x1.ee9c7f8458e02p-1, 0x1.1b0d98923d980p-5, -0x1.e9ae889bac481p-60 },
+    { 0x1.eae807aba01ebp-1, 0x1.58a5bafc8e4d5p-5, -0x1.ce55c2b4e2b72p-59 },
+    { 0x1.e741aa59750e4p-1, 0x1.95c830ec8e3ebp-5, 0x1.f5a0e80520bf2p-59 },
+    { 0x1.e3a9179dc1a73p-1, 0x1.d276b8adb0b52p-5, 0x1.1e3c53257fd47p-61 },
+    { 0x1.e01e01e01e01ep-1, 0x1.075983598e471p-4, 0x1.80da5333c45b8p-59 },
+    { 0x1.dca01dca01dcap-1, 0x1.253f62f0a1417p-4, -0x1.c125963fc4cfdp-62 },
+    { 0x1.d92f2231e7f8ap-1, 0x1.42edcbea646f0p-4, 0x1.ddd4f935996c9p-59 },
+    { 0x1.d5cac807572b2p-1, 0x1.60658a93750c4p-4, -0x1.388458ec21b6ap-58 },
+    { 0x1.d272ca3fc5b1ap-1, 0x1.7da766d7b12cdp-4, -0x1.eeedfcdd94131p-58 },
+    { 0x1.cf26e5c44bfc6p-1, 0x1.9ab42462033adp-4, -0x1.2099e1c184e8ep-59 },
+    { 0x1.cbe6d9601cbe7p-1, 0x1.b78c82bb0eda1p-4, 0x1.0878cf0327e21p-61 },
+    { 0x1.c8b265afb8a42p-1, 0x1.d4313d66cb35dp-4, 0x1.790dd951d90fap-58 },
+    { 0x1.c5894d10d4986p-1, 0x1.f0a30c01162a6p-4, 0x1.85f325c5bbacdp-58 },
+    { 0x1.c26b5392ea01cp-1, 0x1.0671512ca596ep-3, 0x1.50c647eb86499p-58 },
+    { 0x1.bf583ee868d8bp-1, 0x1.14785846742acp-3, 0x1.a28813e3a7f07p-57 },
+    { 0x1.bc4fd65883e7bp-1, 0x1.2266f190a5acbp-3, 0x1.f547bf1809e88p-57 },
+    { 0x1.b951e2b18ff23p-1, 0x1.303d718e47fd3p-3, -0x1.6b9c7d96091fap-63 },
+    { 0x1.b65e2e3beee05p-1, 0x1.3dfc2b0ecc62ap-3, -0x1.ab3a8e7d81017p-58 },
+    { 0x1.b37484ad806cep-1, 0x1.4ba36f39a55e5p-3, 0x1.68981bcc36756p-57 },
+    { 0x1.b094b31d922a4p-1, 0x1.59338d9982086p-3, -0x1.65d22aa8ad7cfp-58 },
+    { 0x1.adbe87f94905ep-1, 0x1.66acd4272ad51p-3, -0x1.0900e4e1ea8b2p-58 },
+    { 0x1.aaf1d2f87ebfdp-1, 0x1.740f8f54037a5p-3, -0x1.b264062a84cdbp-58 },
+    { 0x1.a82e65130e159p-1, 0x1.815c0a14357ebp-3, -0x1.4be48073a0564p-58 },
+    { 0x1.a574107688a4ap-1, 0x1.8e928de886d41p-3, -0x1.569d851a56770p-57 },
+    { 0x1.a2c2a87c51ca0p-1, 0x1.9bb362e7dfb83p-3, 0x1.575e31f003e0cp-57 },
+    { 0x1.a01a01a01a01ap-1, 0x1.a8becfc882f19p-3, -0x1.e8c37918c39ebp-58 },
+    { 0x1.9d79f176b682dp-1, 0x1.b5b519e8fb5a4p-3, 0x1.ba27fdc19e1a0p-57 },
+    { 0x1.9ae24ea5510dap-1, 0x1.c2968558c18c1p-3, -0x1.73dee38a3fb6bp-57 },
+    { 0x1.9852f0d8ec0ffp-1, 0x1.cf6354e09c5dcp-3, 0x1.239a07d55b695p-57 },
+    { 0x1.95cbb0be377aep-1, 0x1.dc1bca0abec7dp-3, 0x1.834c51998b6fcp-57 },
+    { 0x1.934c67f9b2ce6p-1, 0x1.e8c0252aa5a60p-3, -0x1.6e03a39bfc89bp-59 },
+    { 0x1.90d4f120190d5p-1, 0x1.f550a564b7b37p-3, 0x1.c5f6dfd018c37p-61 },
+    { 0x1.8e6527af1373fp-1, 0x1.00e6c45ad501dp-2, -0x1.cb9568ff6feadp-57 },
+    { 0x1.8bfce8062ff3ap-1, 0x1.071b85fcd590dp-2, 0x1.d1707f97bde80p-58 },
+    { 0x1.899c0f601899cp-1, 0x1.0d46b579ab74bp-2, 0x1.03ec81c3cbd92p-57 },
+    { 0x1.87427bcc092b9p-1, 0x1.136870293a8b0p-2, 0x1.7b66298edd24ap-56 },
+    { 0x1.84f00c2780614p-1, 0x1.1980d2dd4236fp-2, 0x1.9d3d1b0e4d147p-56 },
+    { 0x1.82a4a0182a4a0p-1, 0x1.1f8ff9e48a2f3p-2, -0x1.c9fdf9a0c4b07p-56 },
+    { 0x1.8060180601806p-1, 0x1.2596010df763ap-2, -0x1.0f76c57075e9ep-58 },
+    { 0x1.7e225515a4f1dp-1, 0x1.2b9303ab89d25p-2, -0x1.896b5fd852ad4p-56 },
+    { 0x1.7beb3922e017cp-1, 0x1.31871c9544185p-2, -0x1.51acc4c09b379p-60 },
+    { 0x1.79baa6bb6398bp-1, 0x1.3772662bfd85bp-2, -0x1.b5629d8117de7p-59 },
+    { 0x1.77908119ac60dp-1, 0x1.3d54fa5c1f710p-2, -0x1.e3265c6a1c98dp-56 },
+    { 0x1.756cac201756dp-1, 0x1.432ef2a04e814p-2, -0x1.29931715ac903p-56 },
+};
+
+static inline double fast_exp( double x )
+{
+    /* only valid for -708 <= x <= 709, where the result is a normal number */
+    static const double inv_ln2_n = 0x1.71547652b82fep+7, ln2_hi_n = 0x1.62e42fee00000p-8,
+                        ln2_lo_n = 0x1.a39ef35793c76p-40;
+    union { double f; UINT64 i; } scale;
+    double z = x * inv_ln2_n, kd, r, p, t_hi, t_lo;
+    int k, i;
+
+    /* x = (k + r / ln2 * 128) * ln2 / 128, |r| <= ln2 / 256 */
+    k = (int)(z < 0 ? z - 0.5 : z + 0.5);
+    kd = k;
+    r = x - kd * ln2_hi_n - kd * ln2_lo_n;
+    i = k & 127;
+    k = (k - i) / 128;
+    scale.i = (UINT64)(k + 1023) << 52;
+
+    p = r + r * r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 + r * (1.0 / 720)))));
+    t_hi = exp_table[i][0];
+    t_lo = exp_table[i][1];
+    return (t_hi + (t_hi * p + t_lo)) * scale.f;
+}
+
+static inline double fast_log( double x )
+{
+    /* only valid for positive normal numbers */
+    static const double ln2_hi = 0x1.62e42fefa3800p-1, ln2_lo = 0x1.ef35793c76730p-45;
+    static const UINT64 off = 0x3fe6000000000000ull;
+    union { double f; UINT64 i; } u = { x }, c;
+    double f = x - 1.0, r, r2, p, kd, t1, lo1, hi, lo2;
+    UINT64 tmp;
+    int i, k;
+
+    if (f > -0x1p-7 && f < 0x1p-7)
+    {
+        /* close to 1 the table lookup would cancel, use the series directly */
+        r2 = f * f;
+        p = r2 * (-1.0 / 2 + f * (1.0 / 3 + f * (-1.0 / 4 + f * (1.0 / 5 + f * (-1.0 / 6
+                + f * (1.0 / 7 + f * (-1.0 / 8 + f * (1.0 / 9))))))));
+        return f + p;
+    }
+
+    /* x = 2^k * z with off <= z < 2 * off, z is in the i-th interval of width 2^-7 around c */
+    tmp = u.i - off;
+    i = (tmp >> 45) & 127;
+    k = (INT64)tmp >> 52;
+    u.i -= tmp & (0xfffull << 52);
+    c.i = off + ((UINT64)(2 * i + 1) << 44);
+
+    r = (u.f - c.f) * log_table[i][0];
+    kd = k;
+    t1 = kd * ln2_hi + log_table[i][1];
+    lo1 = k ? (kd * ln2_hi - t1) + log_table[i][1] : 0.0;
+    hi = t1 + r;
+    lo2 = (t1 - hi) + r;
+    r2 = r * r;
+    p = r2 * (-1.0 / 2 + r * (1.0 / 3 + r * (-1.0 / 4 + r * (1.0 / 5 + r * (-1.0 / 6 + r * (1.0 / 7))))));
+    return hi + (lo1 + lo2 + kd * ln2_lo + log_table[i][2] + p);
+}
+
+static inline double fast_sin( double x )
+{
+    /* only valid for |x| <= pi/4 */
+    double x2 = x * x;
+
+    return x + x * x2 * (-1.0 / 6 + x2 * (1.0 / 120 + x2 * (-1.0 / 5040 + x2 * (1.0 / 362880
+            + x2 * (-1.0 / 39916800 + x2 * (1.0 / 6227020800.0 + x2 * (-1.0 / 1307674368000.0
+            + x2 * (1.0 / 355687428096000.0))))))));
+}
+
+static inline BOOL is_positive_normal( double x )
+{
+    return x >= DBL_MIN && x <= DBL_MAX;
+}
+
 #if defined(_WIN64)
 # if _MSVCR_VER>=140
 /*********************************************************************
@@ -568,7 +930,11 @@ float CDECL coshf( float x )
  */
 float CDECL expf( float x )
 {
-  float ret = unix_funcs->expf( x );
+  float ret;
+
+  if (x >= -87.0f && x <= 88.0f) return fast_exp( x );
+
+  ret = unix_funcs->expf( x );
   if (isnan(x)) return math_error(_DOMAIN, "expf", x, 0, ret);
   if (isfinite(x) && !ret) return math_error(_UNDERFLOW, "expf", x, 0, ret);
   if (isfinite(x) && !isfinite(ret)) return math_error(_OVERFLOW, "expf", x, 0, ret);
@@ -590,7 +956,11 @@ float CDECL fmodf( float x, float y )
  */
 float CDECL logf( float x )
 {
-  float ret = unix_funcs->logf( x );
+  float ret;
+
+  if (is_positive_normal( x )) return fast_log( x );
+
+  ret = unix_funcs->logf( x );
   if (x < 0.0) return math_error(_DOMAIN, "logf", x, 0, ret);
   if (x == 0.0) return math_error(_SING, "logf", x, 0, ret);
   return ret;
@@ -612,7 +982,16 @@ float CDECL log10f( float x )
  */
 float CDECL powf( float x, float y )
 {
-  float z = unix_funcs->powf(x,y);
+  float z;
+
+  if (x >= FLT_MIN && x <= FLT_MAX && y >= -FLT_MAX && y <= FLT_MAX)
+  {
+    /* the double precision log keeps the error far below float precision */
+    double t = y * fast_log( x );
+    if (t >= -87.0 && t <= 88.0) return fast_exp( t );
+  }
+
+  z = unix_funcs->powf(x,y);
   if (x < 0 && y != floorf(y)) return math_error(_DOMAIN, "powf", x, y, z);
   if (!x && isfinite(y) && y < 0) return math_error(_SING, "powf", x, y, z);
   if (isfinite(x) && isfinite(y) && !isfinite(z)) return math_error(_OVERFLOW, "powf", x, y, z);
@@ -625,7 +1004,11 @@ float CDECL powf( float x, float y )
  */
 float CDECL sinf( float x )
 {
-  float ret = unix_funcs->sinf( x );
+  float ret;
+
+  if (x >= -M_PI_4 && x <= M_PI_4) return fast_sin( x );
+
+  ret = unix_funcs->sinf( x );
   if (!isfinite(x)) return math_error(_DOMAIN, "sinf", x, 0, ret);
   return ret;
 }
@@ -1172,7 +1555,11 @@ double CDECL cosh( double x )
  */
 double CDECL exp( double x )
 {
-  double ret = unix_funcs->exp( x );
+  double ret;
+
+  if (x >= -708.0 && x <= 709.0) return fast_exp( x );
+
+  ret = unix_funcs->exp( x );
   if (isnan(x)) return math_error(_DOMAIN, "exp", x, 0, ret);
   if (isfinite(x) && !ret) return math_error(_UNDERFLOW, "exp", x, 0, ret);
   if (isfinite(x) && !isfinite(ret)) return math_error(_OVERFLOW, "exp", x, 0, ret);
@@ -1194,7 +1581,11 @@ double CDECL fmod( double x, double y )
  */
 double CDECL log( double x )
 {
-  double ret = unix_funcs->log( x );
+  double ret;
+
+  if (is_positive_normal( x )) return fast_log( x );
+
+  ret = unix_funcs->log( x );
   if (x < 0.0) return math_error(_DOMAIN, "log", x, 0, ret);
   if (x == 0.0) return math_error(_SING, "log", x, 0, ret);
   return ret;
@@ -1217,6 +1608,8 @@ double CDECL log10( double x )
 double CDECL pow( double x, double y )
 {
   double z = unix_funcs->pow(x,y);
+  /* none of the errors apply to a positive base with a normal result */
+  if (x > 0 && z >= DBL_MIN && z <= DBL_MAX) return z;
   if (x < 0 && y != floor(y))
     return math_error(_DOMAIN, "pow", x, y, z);
   if (!x && isfinite(y) && y < 0)
@@ -1233,7 +1626,11 @@ double CDECL pow( double x, double y )
  */
 double CDECL sin( double x )
 {
-  double ret = unix_funcs->sin( x );
+  double ret;
+
+  if (x >= -M_PI_4 && x <= M_PI_4) return fast_sin( x );
+
+  ret = unix_funcs->sin( x );
   if (!isfinite(x)) return math_error(_DOMAIN, "sin", x, 0, ret);
   return ret;
 }
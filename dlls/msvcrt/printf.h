@@ -135,6 +135,73 @@ static inline int mbstowcs_len(wchar_t *wcstr, const char *mbstr,
     }
     return wlen;
 }
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static inline ULONGLONG pf_umul128(ULONGLONG a, ULONGLONG b, ULONGLONG *hi)
+{
+    ULONGLONG a_lo = (DWORD)a, a_hi = a >> 32, b_lo = (DWORD)b, b_hi = b >> 32;
+    ULONGLONG p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo;
+    ULONGLONG mid = (p0 >> 32) + (DWORD)p1 + (DWORD)p2;
+
+    *hi = a_hi * b_hi + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+    return (mid << 32) | (DWORD)p0;
+}
+
+/* pf_fixed_conv: computes round(v * 10^prec) exactly using 128-bit integer
+   arithmetic, returns FALSE if the result doesn't fit in 63 bits */
+static inline BOOL pf_fixed_conv(double v, int prec, BOOL standard_rounding, ULONGLONG *ret)
+{
+    ULONGLONG bits = *(ULONGLONG*)&v, m, p10 = 1, hi, lo, t;
+    BOOL round_bit, sticky;
+    int e2, k;
+
+    if(prec > 17) return FALSE;
+
+    m = bits & (((ULONGLONG)1 << (MANT_BITS - 1)) - 1);
+    e2 = (bits >> (MANT_BITS - 1)) & ((1 << EXP_BITS) - 1);
+    if(e2) m |= (ULONGLONG)1 << (MANT_BITS - 1);
+    else e2 = 1;
+    e2 -= (1 << (EXP_BITS - 1)) - 1 + MANT_BITS - 1;
+
+    while(prec--) p10 *= 10;
+    lo = pf_umul128(m, p10, &hi);
+
+    if(e2 >= 0) {
+        if(hi || e2 >= 63 || lo >> (63 - e2)) return FALSE;
+        *ret = lo << e2;
+        return TRUE;
+    }
+
+    /* shift out all but the rounding bit */
+    k = -e2 - 1;
+    if(k >= 128) {
+        t = 0;
+        sticky = (hi || lo);
+    } else if(k >= 64) {
+        t = k == 64 ? hi : hi >> (k - 64);
+        sticky = lo || (k > 64 && (hi & (((ULONGLONG)1 << (k - 64)) - 1)));
+    } else if(k) {
+        if(hi >> k) return FALSE;
+        t = (lo >> k) | (hi << (64 - k));
+        sticky = (lo & (((ULONGLONG)1 << k) - 1)) != 0;
+    } else {
+        if(hi) return FALSE;
+        t = lo;
+        sticky = FALSE;
+    }
+
+    round_bit = t & 1;
+    t >>= 1;
+    if(round_bit && (!standard_rounding || sticky || (t & 1)))
+        t++;
+    if(t >> 63) return FALSE;
+    *ret = t;
+    return TRUE;
+}
 #endif
 
 static inline int FUNC_NAME(pf_output_wstr)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx,
@@ -556,6 +623,13 @@ static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, pf_flags *flags, LON
         if(flags->Precision)
             buf[i++] = '0';
     } else {
+        /* emit base 10 digits in pairs to halve the number of divisions */
+        while(base == 10 && (ULONGLONG)x >= 100) {
+            j = (ULONGLONG)x%100;
+            x = (ULONGLONG)x/100;
+            buf[i++] = digit_pairs[2*j+1];
+            buf[i++] = digit_pairs[2*j];
+        }
         while(x != 0) {
             j = (ULONGLONG)x%base;
             x = (ULONGLONG)x/base;
@@ -586,6 +660,54 @@ static inline void FUNC_NAME(pf_integer_conv)(APICHAR *buf, pf_flags *flags, LON
     }
 }
 
+/* pf_output_fixed_fp: outputs %f formatted q / 10^Precision in a single pf_puts call */
+static inline int FUNC_NAME(pf_output_fixed_fp)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx,
+        ULONGLONG q, pf_flags *flags, _locale_t locale)
+{
+    APICHAR buf[48], *p = buf + ARRAY_SIZE(buf);
+    int i, j, len, r, ret;
+
+    for(i = flags->Precision; i >= 2; i -= 2) {
+        j = q % 100;
+        q /= 100;
+        *--p = digit_pairs[2*j+1];
+        *--p = digit_pairs[2*j];
+    }
+    if(i) {
+        *--p = '0' + q % 10;
+        q /= 10;
+    }
+    if(flags->Precision || flags->Alternate)
+        *--p = *(locale ? locale->locinfo : get_locinfo())->lconv->decimal_point;
+
+    while(q >= 100) {
+        j = q % 100;
+        q /= 100;
+        *--p = digit_pairs[2*j+1];
+        *--p = digit_pairs[2*j];
+    }
+    if(q >= 10) {
+        *--p = digit_pairs[2*q+1];
+        *--p = digit_pairs[2*q];
+    } else {
+        *--p = '0' + q;
+    }
+    len = buf + ARRAY_SIZE(buf) - p;
+
+    r = FUNC_NAME(pf_fill)(pf_puts, puts_ctx, len, flags, TRUE);
+    if(r < 0) return r;
+    ret = r;
+
+    r = pf_puts(puts_ctx, len, p);
+    if(r < 0) return r;
+    ret += r;
+
+    r = FUNC_NAME(pf_fill)(pf_puts, puts_ctx, len, flags, FALSE);
+    if(r < 0) return r;
+    ret += r;
+    return ret;
+}
+
 static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *puts_ctx,
         double v, pf_flags *flags, _locale_t locale, BOOL three_digit_exp,
         BOOL standard_rounding)
@@ -603,6 +725,11 @@ static inline int FUNC_NAME(pf_output_fp)(FUNC_NAME(puts_clbk) pf_puts, void *pu
     if(flags->Precision == -1)
         flags->Precision = 6;
 
+    /* most %f conversions fit in 64 bits, avoid the bignum path for them */
+    if((flags->Format=='f' || flags->Format=='F') &&
+            pf_fixed_conv(v, flags->Precision, standard_rounding, &m))
+        return FUNC_NAME(pf_output_fixed_fp)(pf_puts, puts_ctx, m, flags, locale);
+
     v = frexp(v, &e2);
     if(v) {
         m = (ULONGLONG)1 << (MANT_BITS - 1);
@@ -87,11 +87,18 @@ struct scheduler_list {
     struct scheduler_list *next;
 };
 
+struct scheduler_pool;
+struct scheduler_vp;
+
 typedef struct {
     Context context;
     struct scheduler_list scheduler;
     unsigned int id;
     union allocator_cache_entry *allocator_cache[8];
+    struct scheduler_pool *pool;
+    struct scheduler_vp *vp;
+    LONG blocked;
+    HANDLE block_event;
 } ExternalContextBase;
 extern const vtable_ptr ExternalContextBase_vtable;
 static void ExternalContextBase_ctor(ExternalContextBase*);
@@ -133,6 +140,7 @@ typedef struct {
     int shutdown_size;
     HANDLE *shutdown_events;
     CRITICAL_SECTION cs;
+    struct scheduler_pool *pool;
 } ThreadScheduler;
 extern const vtable_ptr ThreadScheduler_vtable;
 
@@ -140,6 +148,40 @@ typedef struct {
     Scheduler *scheduler;
 } _Scheduler;
 
+struct scheduled_task {
+    void (__cdecl *proc)(void*);
+    void *data;
+    Scheduler *scheduler;
+};
+
+/* Each virtual processor owns a task queue. Its worker pushes and pops
+ * tasks at the tail, idle workers steal the oldest tasks from the head. */
+struct scheduler_vp {
+    struct scheduler_pool *pool;
+    unsigned int id;
+    SRWLOCK lock;
+    struct scheduled_task *tasks;
+    unsigned int head;
+    unsigned int count;
+    unsigned int size;
+};
+
+#define SCHEDULER_MAX_HELPERS 64
+
+struct scheduler_pool {
+    LONG ref;
+    SRWLOCK lock;
+    CONDITION_VARIABLE cv;
+    BOOL shutdown;
+    LONG pending;
+    LONG next_vp;
+    unsigned int idle;
+    unsigned int started;
+    unsigned int helpers;
+    unsigned int vp_count;
+    struct scheduler_vp vps[1];
+};
+
 typedef struct {
     char empty;
 } _CurrentScheduler;
@@ -217,6 +259,251 @@ static Scheduler* get_current_scheduler(void)
     return context->scheduler.scheduler;
 }
 
+static struct scheduler_pool* scheduler_pool_create(unsigned int vp_count)
+{
+    struct scheduler_pool *pool;
+    unsigned int i;
+
+    if(!vp_count) vp_count = 1;
+    pool = operator_new(FIELD_OFFSET(struct scheduler_pool, vps[vp_count]));
+    memset(pool, 0, FIELD_OFFSET(struct scheduler_pool, vps[vp_count]));
+    pool->ref = 1;
+    InitializeSRWLock(&pool->lock);
+    InitializeConditionVariable(&pool->cv);
+    pool->vp_count = vp_count;
+    for(i=0; i<vp_count; i++) {
+        pool->vps[i].pool = pool;
+        pool->vps[i].id = i;
+        InitializeSRWLock(&pool->vps[i].lock);
+    }
+    return pool;
+}
+
+static void scheduler_pool_release(struct scheduler_pool *pool)
+{
+    unsigned int i;
+
+    if(InterlockedDecrement(&pool->ref))
+        return;
+
+    for(i=0; i<pool->vp_count; i++)
+        free(pool->vps[i].tasks);
+    operator_delete(pool);
+}
+
+static void scheduler_vp_push(struct scheduler_vp *vp, const struct scheduled_task *task)
+{
+    AcquireSRWLockExclusive(&vp->lock);
+    if(vp->count == vp->size) {
+        unsigned int i, size = vp->size ? vp->size * 2 : 16;
+        struct scheduled_task *tasks;
+
+        tasks = malloc(size * sizeof(*tasks));
+        if(!tasks) {
+            ReleaseSRWLockExclusive(&vp->lock);
+            throw_exception(EXCEPTION_BAD_ALLOC, 0, "bad allocation");
+            return;
+        }
+        for(i=0; i<vp->count; i++)
+            tasks[i] = vp->tasks[(vp->head + i) % vp->size];
+        free(vp->tasks);
+        vp->tasks = tasks;
+        vp->head = 0;
+        vp->size = size;
+    }
+    vp->tasks[(vp->head + vp->count) % vp->size] = *task;
+    vp->count++;
+    ReleaseSRWLockExclusive(&vp->lock);
+}
+
+static BOOL scheduler_vp_pop(struct scheduler_vp *vp, struct scheduled_task *task)
+{
+    BOOL ret = FALSE;
+
+    AcquireSRWLockExclusive(&vp->lock);
+    if(vp->count) {
+        vp->count--;
+        *task = vp->tasks[(vp->head + vp->count) % vp->size];
+        ret = TRUE;
+    }
+    ReleaseSRWLockExclusive(&vp->lock);
+    return ret;
+}
+
+static BOOL scheduler_vp_steal(struct scheduler_vp *vp, struct scheduled_task *task)
+{
+    BOOL ret = FALSE;
+
+    if(!TryAcquireSRWLockExclusive(&vp->lock))
+        return FALSE;
+    if(vp->count) {
+        *task = vp->tasks[vp->head];
+        vp->head = (vp->head + 1) % vp->size;
+        vp->count--;
+        ret = TRUE;
+    }
+    ReleaseSRWLockExclusive(&vp->lock);
+    return ret;
+}
+
+static BOOL scheduler_pool_get_task(struct scheduler_pool *pool,
+        struct scheduler_vp *vp, struct scheduled_task *task)
+{
+    unsigned int i, start;
+
+    if(vp && scheduler_vp_pop(vp, task))
+        return TRUE;
+
+    while(pool->pending) {
+        start = vp ? vp->id + 1 : GetCurrentThreadId();
+        for(i=0; i<pool->vp_count; i++) {
+            struct scheduler_vp *victim = &pool->vps[(start + i) % pool->vp_count];
+
+            if(victim != vp && scheduler_vp_steal(victim, task))
+                return TRUE;
+        }
+        if(vp && scheduler_vp_pop(vp, task))
+            return TRUE;
+        SwitchToThread();
+    }
+    return FALSE;
+}
+
+static void scheduler_worker_loop(struct scheduler_pool*, struct scheduler_vp*);
+
+static DWORD WINAPI scheduler_vp_proc(void *arg)
+{
+    struct scheduler_vp *vp = arg;
+
+    scheduler_worker_loop(vp->pool, vp);
+    return 0;
+}
+
+static DWORD WINAPI scheduler_helper_proc(void *arg)
+{
+    scheduler_worker_loop(arg, NULL);
+    return 0;
+}
+
+/* called with pool->lock held */
+static BOOL scheduler_pool_start_thread(struct scheduler_pool *pool, struct scheduler_vp *vp)
+{
+    HANDLE thread;
+
+    InterlockedIncrement(&pool->ref);
+    thread = CreateThread(NULL, 0, vp ? scheduler_vp_proc : scheduler_helper_proc,
+            vp ? (void*)vp : (void*)pool, 0, NULL);
+    if(!thread) {
+        WARN("failed to create worker thread: %u\n", GetLastError());
+        InterlockedDecrement(&pool->ref);
+        return FALSE;
+    }
+    CloseHandle(thread);
+    return TRUE;
+}
+
+static void scheduler_worker_loop(struct scheduler_pool *pool, struct scheduler_vp *vp)
+{
+    ExternalContextBase *context = (ExternalContextBase*)get_current_context();
+    struct scheduled_task task;
+    Scheduler *prev;
+    BOOL done;
+
+    TRACE("(%p %p) worker started\n", pool, vp);
+
+    context->pool = pool;
+    context->vp = vp;
+    for(;;) {
+        if(scheduler_pool_get_task(pool, vp, &task)) {
+            InterlockedDecrement(&pool->pending);
+
+            prev = context->scheduler.scheduler;
+            context->scheduler.scheduler = task.scheduler;
+            task.proc(task.data);
+            context->scheduler.scheduler = prev;
+            call_Scheduler_Release(task.scheduler);
+            continue;
+        }
+
+        AcquireSRWLockExclusive(&pool->lock);
+        if(!vp) {
+            /* helpers only run while other workers are blocked */
+            pool->helpers--;
+            ReleaseSRWLockExclusive(&pool->lock);
+            break;
+        }
+        pool->idle++;
+        while(!pool->pending && !pool->shutdown)
+            SleepConditionVariableSRW(&pool->cv, &pool->lock, INFINITE, 0);
+        pool->idle--;
+        done = !pool->pending && pool->shutdown;
+        ReleaseSRWLockExclusive(&pool->lock);
+        if(done) break;
+    }
+    context->pool = NULL;
+    context->vp = NULL;
+
+    TRACE("(%p %p) worker exiting\n", pool, vp);
+    scheduler_pool_release(pool);
+}
+
+static void scheduler_pool_push(struct scheduler_pool *pool, const struct scheduled_task *task)
+{
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+    struct scheduler_vp *vp;
+
+    if(context && context->context.vtable == &ExternalContextBase_vtable
+            && context->pool == pool && context->vp)
+        vp = context->vp;
+    else
+        vp = &pool->vps[(unsigned int)InterlockedIncrement(&pool->next_vp) % pool->vp_count];
+    scheduler_vp_push(vp, task);
+    InterlockedIncrement(&pool->pending);
+
+    AcquireSRWLockExclusive(&pool->lock);
+    if(pool->idle)
+        WakeConditionVariable(&pool->cv);
+    else if(pool->started < pool->vp_count
+            && scheduler_pool_start_thread(pool, &pool->vps[pool->started]))
+        pool->started++;
+    ReleaseSRWLockExclusive(&pool->lock);
+}
+
+/* Starts a helper thread when a worker stops executing tasks while work is queued. */
+static void scheduler_pool_oversubscribe(struct scheduler_pool *pool)
+{
+    AcquireSRWLockExclusive(&pool->lock);
+    if(pool->pending && !pool->idle && pool->helpers < SCHEDULER_MAX_HELPERS
+            && scheduler_pool_start_thread(pool, NULL))
+        pool->helpers++;
+    ReleaseSRWLockExclusive(&pool->lock);
+}
+
+static void scheduler_pool_shutdown(struct scheduler_pool *pool)
+{
+    AcquireSRWLockExclusive(&pool->lock);
+    pool->shutdown = TRUE;
+    WakeAllConditionVariable(&pool->cv);
+    ReleaseSRWLockExclusive(&pool->lock);
+    scheduler_pool_release(pool);
+}
+
+static HANDLE get_block_event(ExternalContextBase *context)
+{
+    HANDLE event;
+
+    if(context->block_event)
+        return context->block_event;
+
+    event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if(!event)
+        throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
+                HRESULT_FROM_WIN32(GetLastError()), NULL);
+    if(InterlockedCompareExchangePointer(&context->block_event, event, NULL))
+        CloseHandle(event);
+    return context->block_event;
+}
+
 /* ?CurrentContext@Context@Concurrency@@SAPAV12@XZ */
 /* ?CurrentContext@Context@Concurrency@@SAPEAV12@XZ */
 Context* __cdecl Context_CurrentContext(void)
@@ -236,20 +523,39 @@ unsigned int __cdecl Context_Id(void)
 /* ?Block@Context@Concurrency@@SAXXZ */
 void __cdecl Context_Block(void)
 {
-    FIXME("()\n");
+    ExternalContextBase *context = (ExternalContextBase*)get_current_context();
+    HANDLE event;
+
+    TRACE("()\n");
+
+    if(context->context.vtable != &ExternalContextBase_vtable) {
+        ERR("unknown context set\n");
+        return;
+    }
+
+    /* Unblock may be called before Block, in that case don't wait */
+    event = get_block_event(context);
+    if(InterlockedDecrement(&context->blocked) >= 0)
+        return;
+
+    if(context->pool)
+        scheduler_pool_oversubscribe(context->pool);
+    WaitForSingleObject(event, INFINITE);
 }
 
 /* ?Yield@Context@Concurrency@@SAXXZ */
 /* ?_Yield@_Context@details@Concurrency@@SAXXZ */
 void __cdecl Context_Yield(void)
 {
-    FIXME("()\n");
+    TRACE("()\n");
+    SwitchToThread();
 }
 
 /* ?_SpinYield@Context@Concurrency@@SAXXZ */
 void __cdecl Context__SpinYield(void)
 {
-    FIXME("()\n");
+    TRACE("()\n");
+    SwitchToThread();
 }
 
 /* ?IsCurrentTaskCollectionCanceling@Context@Concurrency@@SA_NXZ */
@@ -262,7 +568,13 @@ bool __cdecl Context_IsCurrentTaskCollectionCanceling(void)
 /* ?Oversubscribe@Context@Concurrency@@SAX_N@Z */
 void __cdecl Context_Oversubscribe(bool begin)
 {
-    FIXME("(%x)\n", begin);
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+
+    TRACE("(%x)\n", begin);
+
+    if(begin && context && context->context.vtable == &ExternalContextBase_vtable
+            && context->pool)
+        scheduler_pool_oversubscribe(context->pool);
 }
 
 /* ?ScheduleGroupId@Context@Concurrency@@SAIXZ */
@@ -301,8 +613,8 @@ unsigned int __thiscall ExternalContextBase_GetId(const ExternalContextBase *thi
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetVirtualProcessorId, 4)
 unsigned int __thiscall ExternalContextBase_GetVirtualProcessorId(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return -1;
+    TRACE("(%p)->()\n", this);
+    return this->vp ? this->vp->id : -1;
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_GetScheduleGroupId, 4)
@@ -315,14 +627,19 @@ unsigned int __thiscall ExternalContextBase_GetScheduleGroupId(const ExternalCon
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_Unblock, 4)
 void __thiscall ExternalContextBase_Unblock(ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
+    HANDLE event = get_block_event(this);
+
+    TRACE("(%p)->()\n", this);
+
+    if(InterlockedIncrement(&this->blocked) <= 0)
+        SetEvent(event);
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_IsSynchronouslyBlocked, 4)
 bool __thiscall ExternalContextBase_IsSynchronouslyBlocked(const ExternalContextBase *this)
 {
-    FIXME("(%p)->() stub\n", this);
-    return FALSE;
+    TRACE("(%p)->()\n", this);
+    return this->blocked < 0;
 }
 
 static void ExternalContextBase_dtor(ExternalContextBase *this)
@@ -348,6 +665,9 @@ static void ExternalContextBase_dtor(ExternalContextBase *this)
             operator_delete(scheduler_cur);
         }
     }
+
+    if (this->block_event)
+        CloseHandle(this->block_event);
 }
 
 DEFINE_THISCALL_WRAPPER(ExternalContextBase_vector_dtor, 8)
@@ -618,6 +938,8 @@ static void ThreadScheduler_dtor(ThreadScheduler *this)
     if(this->ref != 0) WARN("ref = %d\n", this->ref);
     SchedulerPolicy_dtor(&this->policy);
 
+    scheduler_pool_shutdown(this->pool);
+
     for(i=0; i<this->shutdown_count; i++)
         SetEvent(this->shutdown_events[i]);
     operator_delete(this->shutdown_events);
@@ -734,14 +1056,27 @@ DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
 void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
 {
-    FIXME("(%p %p %p %p) stub\n", this, proc, data, placement);
+    struct scheduled_task task;
+
+    TRACE("(%p %p %p %p)\n", this, proc, data, placement);
+
+    if(placement)
+        FIXME("ignoring placement %p\n", placement);
+
+    /* queued tasks keep the scheduler alive until they are executed */
+    task.proc = proc;
+    task.data = data;
+    task.scheduler = &this->scheduler;
+    ThreadScheduler_Reference(this);
+    scheduler_pool_push(this->pool, &task);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
 void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data)
 {
-    FIXME("(%p %p %p) stub\n", this, proc, data);
+    TRACE("(%p %p %p)\n", this, proc, data);
+    ThreadScheduler_ScheduleTask_loc(this, proc, data, NULL);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_IsAvailableLocation, 8)
@@ -791,6 +1126,7 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
 
     this->shutdown_count = this->shutdown_size = 0;
     this->shutdown_events = NULL;
+    this->pool = scheduler_pool_create(this->virt_proc_no);
 
     InitializeCriticalSection(&this->cs);
     this->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ThreadScheduler");
@@ -1502,8 +1502,17 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
  */
 size_t __cdecl strlen(const char *str)
 {
-    const char *s = str;
-    while (*s) s++;
+    static const size_t low_bits = ~(size_t)0 / 0xff, high_bits = low_bits << 7;
+    const size_t *w;
+    const char *s;
+
+    for (s = str; (size_t)s % sizeof(size_t); s++)
+        if (!*s) return s - str;
+
+    /* aligned loads never cross into the next page */
+    for (w = (const size_t *)s; !((*w - low_bits) & ~*w & high_bits); w++) ;
+
+    for (s = (const char *)w; *s; s++) ;
     return s - str;
 }
 
@@ -2722,6 +2731,63 @@ __ASM_GLOBAL_FUNC( sse2_memmove,
         MEMMOVE_CLEANUP
         "ret" )
 
+/* copies at least this large are done with rep movsb on CPUs with ERMS */
+#define ERMS_THRESHOLD 2048
+#ifdef __x86_64__
+/* copies at least this large would mostly evict the cache, so bypass it */
+#define NONTEMPORAL_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+static void *erms_memcpy(void *dst, const void *src, size_t n)
+{
+    void *d = dst;
+
+    __asm__ __volatile__( "rep movsb" : "+D"(d), "+S"(src), "+c"(n) : : "memory" );
+    return dst;
+}
+
+#ifdef NONTEMPORAL_THRESHOLD
+static void *nontemporal_memcpy(void *dst, const void *src, size_t n)
+{
+    unsigned char *d = dst;
+    const unsigned char *s = src;
+    size_t head = -(size_t)d & 15;
+
+    sse2_memmove(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+
+    for (; n >= 64; n -= 64, d += 64, s += 64)
+        __asm__ __volatile__( "movdqu 0x00(%1), %%xmm0\n\t"
+                              "movdqu 0x10(%1), %%xmm1\n\t"
+                              "movdqu 0x20(%1), %%xmm2\n\t"
+                              "movdqu 0x30(%1), %%xmm3\n\t"
+                              "movntdq %%xmm0, 0x00(%0)\n\t"
+                              "movntdq %%xmm1, 0x10(%0)\n\t"
+                              "movntdq %%xmm2, 0x20(%0)\n\t"
+                              "movntdq %%xmm3, 0x30(%0)\n\t"
+                              : : "r"(d), "r"(s) : "xmm0", "xmm1", "xmm2", "xmm3", "memory" );
+    __asm__ __volatile__( "sfence" : : : "memory" );
+
+    sse2_memmove(d, s, n);
+    return dst;
+}
+#endif
+
+/* pick the fastest way to copy n bytes, SSE2 must be available */
+static inline void *x86_memmove(void *dst, const void *src, size_t n)
+{
+    if (n >= ERMS_THRESHOLD && (size_t)dst - (size_t)src >= n && (size_t)src - (size_t)dst >= n)
+    {
+#ifdef NONTEMPORAL_THRESHOLD
+        if (n >= NONTEMPORAL_THRESHOLD) return nontemporal_memcpy(dst, src, n);
+#endif
+        if (erms_supported) return erms_memcpy(dst, src, n);
+    }
+    return sse2_memmove(dst, src, n);
+}
+
 #endif
 
 /*********************************************************************
@@ -2735,7 +2801,7 @@ __ASM_GLOBAL_FUNC( sse2_memmove,
 void * __cdecl memmove(void *dst, const void *src, size_t n)
 {
 #ifdef __x86_64__
-    return sse2_memmove(dst, src, n);
+    return x86_memmove(dst, src, n);
 #else
     unsigned char *d = dst;
     const unsigned char *s = src;
@@ -2743,7 +2809,7 @@ void * __cdecl memmove(void *dst, const void *src, size_t n)
 
 #ifdef __i386__
     if (sse2_supported)
-        return sse2_memmove(dst, src, n);
+        return x86_memmove(dst, src, n);
 #endif
 
     if (!n) return dst;
@@ -2851,6 +2917,20 @@ void * __cdecl memcpy(void *dst, const void *src, size_t n)
 void* __cdecl memset(void *dst, int c, size_t n)
 {
     volatile unsigned char *d = dst;  /* avoid gcc optimizations */
+    size_t v = (unsigned char)c * (~(size_t)0 / 0xff);
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (n >= ERMS_THRESHOLD && erms_supported)
+    {
+        void *p = dst;
+        __asm__ __volatile__( "rep stosb" : "+D"(p), "+c"(n) : "a"(c) : "memory" );
+        return dst;
+    }
+#endif
+
+    for (; (size_t)d % sizeof(size_t) && n; n--) *d++ = c;
+    for (; n >= sizeof(size_t); n -= sizeof(size_t), d += sizeof(size_t))
+        *(volatile size_t *)d = v;
     while (n--) *d++ = c;
     return dst;
 }
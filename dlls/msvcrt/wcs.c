@@ -2835,8 +2835,17 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
  */
 size_t CDECL wcslen(const wchar_t *str)
 {
-    const wchar_t *s = str;
-    while (*s) s++;
+    static const size_t low_bits = ~(size_t)0 / 0xffff, high_bits = low_bits << 15;
+    const size_t *w;
+    const wchar_t *s;
+
+    /* misaligned strings never reach alignment and are scanned here entirely */
+    for (s = str; (size_t)s % sizeof(size_t); s++)
+        if (!*s) return s - str;
+
+    for (w = (const size_t *)s; !((*w - low_bits) & ~*w & high_bits); w++) ;
+
+    for (s = (const wchar_t *)w; *s; s++) ;
     return s - str;
 }
 
@@ -322,6 +322,10 @@ typedef struct
         BSTR szValue;
         BSTR szQName;
     } *attributes;
+
+    /* reusable buffer for ISAXContentHandler::characters() text */
+    WCHAR *chars;
+    int chars_size;
 } saxlocator;
 
 static inline saxreader *impl_from_IVBSAXXMLReader( IVBSAXXMLReader *iface )
@@ -657,17 +661,44 @@ static BSTR pooled_bstr_from_xmlChar(struct bstrpool *pool, const xmlChar *buf)
     return pool_entry;
 }
 
-static BSTR pooled_bstr_from_xmlCharN(struct bstrpool *pool, const xmlChar *buf, int len)
+/* Reports UTF-8 text without allocating a BSTR for every chunk. Text passed to
+   ISAXContentHandler::characters() is only valid during the call, so a buffer
+   owned by the locator is reused. */
+static HRESULT saxreader_saxcharacters_xmlChar(saxlocator *locator, const xmlChar *ch, int len)
 {
-    BSTR pool_entry = bstr_from_xmlCharN(buf, len);
+    struct saxcontenthandler_iface *content = saxreader_get_contenthandler(locator->saxreader);
+    int chars_len = 0;
+    HRESULT hr;
 
-    if (pool_entry && !bstr_pool_insert(pool, pool_entry))
+    if (!saxreader_has_handler(locator, SAXContentHandler)) return S_OK;
+
+    if (locator->vbInterface)
     {
-        SysFreeString(pool_entry);
-        return NULL;
+        BSTR chars = bstr_from_xmlCharN(ch, len);
+
+        hr = IVBSAXContentHandler_characters(content->vbhandler, &chars);
+        SysFreeString(chars);
+        return hr;
     }
 
-    return pool_entry;
+    if (len)
+        chars_len = MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)ch, len, NULL, 0);
+
+    if (chars_len >= locator->chars_size)
+    {
+        int size = max(max(locator->chars_size * 2, 256), chars_len + 1);
+        WCHAR *chars = heap_realloc(locator->chars, size * sizeof(WCHAR));
+
+        if (!chars) return E_OUTOFMEMORY;
+        locator->chars = chars;
+        locator->chars_size = size;
+    }
+
+    if (chars_len)
+        MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)ch, len, locator->chars, chars_len);
+    locator->chars[chars_len] = 0;
+
+    return ISAXContentHandler_characters(content->handler, locator->chars, chars_len);
 }
 
 static void format_error_message_from_id(saxlocator *This, HRESULT hr)
@@ -1783,7 +1814,6 @@ static void libxmlCharacters(
         int len)
 {
     saxlocator *This = ctx;
-    BSTR Chars;
     HRESULT hr;
     xmlChar *cur, *end;
     BOOL lastEvent = FALSE;
@@ -1840,8 +1870,7 @@ static void libxmlCharacters(
                 This->column = 0;
         }
 
-        Chars = pooled_bstr_from_xmlCharN(&This->saxreader->pool, cur, end-cur);
-        hr = saxreader_saxcharacters(This, Chars);
+        hr = saxreader_saxcharacters_xmlChar(This, cur, end-cur);
 
         if (sax_callback_failed(This, hr))
         {
@@ -2352,6 +2381,7 @@ static ULONG WINAPI isaxlocator_Release(
             SysFreeString(This->attributes[index].szQName);
         }
         heap_free(This->attributes);
+        heap_free(This->chars);
 
         /* element stack */
         LIST_FOR_EACH_ENTRY_SAFE(element, element2, &This->elements, element_entry, entry)
@@ -2492,6 +2522,9 @@ static HRESULT SAXLocator_create(saxreader *reader, saxlocator **ppsaxlocator, B
         return E_OUTOFMEMORY;
     }
 
+    locator->chars = NULL;
+    locator->chars_size = 0;
+
     list_init(&locator->elements);
 
     *ppsaxlocator = locator;
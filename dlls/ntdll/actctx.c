@@ -3324,6 +3324,40 @@ static NTSTATUS find_query_actctx( HANDLE *handle, DWORD flags, ULONG class )
     return status;
 }
 
+/* Section indexes are sorted by key, like on Windows, so that lookups can
+ * use a binary search. Entries with the same key keep their original order
+ * so that the first assembly that provides a key still wins. */
+static int string_index_compare(const void *a, const void *b)
+{
+    const struct string_index *index1 = a, *index2 = b;
+
+    if (index1->hash != index2->hash) return index1->hash < index2->hash ? -1 : 1;
+    if (index1->data_offset != index2->data_offset) return index1->data_offset < index2->data_offset ? -1 : 1;
+    return 0;
+}
+
+static int guid_index_compare(const void *a, const void *b)
+{
+    const struct guid_index *index1 = a, *index2 = b;
+    int ret;
+
+    if ((ret = memcmp(&index1->guid, &index2->guid, sizeof(index1->guid)))) return ret;
+    if (index1->data_offset != index2->data_offset) return index1->data_offset < index2->data_offset ? -1 : 1;
+    return 0;
+}
+
+static void sort_string_index(struct strsection_header *section)
+{
+    qsort((BYTE *)section + section->index_offset, section->count, sizeof(struct string_index),
+          string_index_compare);
+}
+
+static void sort_guid_index(struct guidsection_header *section)
+{
+    qsort((BYTE *)section + section->index_offset, section->count, sizeof(struct guid_index),
+          guid_index_compare);
+}
+
 static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct strsection_header **section)
 {
     unsigned int i, j, total_len = 0, dll_count = 0;
@@ -3401,6 +3435,8 @@ static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct str
         }
     }
 
+    sort_string_index(header);
+
     *section = header;
 
     return STATUS_SUCCESS;
@@ -3408,51 +3444,49 @@ static NTSTATUS build_dllredirect_section(ACTIVATION_CONTEXT* actctx, struct str
 
 static struct string_index *find_string_index(const struct strsection_header *section, const UNICODE_STRING *name)
 {
-    struct string_index *iter, *index = NULL;
+    struct string_index *iter, *end;
     UNICODE_STRING str;
-    ULONG hash = 0, i;
+    ULONG hash = 0, min = 0, max = section->count, pos;
 
     RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
     iter = (struct string_index*)((BYTE*)section + section->index_offset);
+    end = iter + section->count;
 
-    for (i = 0; i < section->count; i++)
+    /* find the first entry with a matching hash */
+    while (min < max)
     {
-        if (iter->hash == hash)
-        {
-            str.Buffer = (WCHAR *)((BYTE *)section + iter->name_offset);
-            str.Length = iter->name_len;
-            if (RtlEqualUnicodeString( &str, name, TRUE ))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_us(&str));
-        }
-        iter++;
+        pos = (min + max) / 2;
+        if (iter[pos].hash < hash) min = pos + 1;
+        else max = pos;
+    }
+
+    for (iter += min; iter < end && iter->hash == hash; iter++)
+    {
+        str.Buffer = (WCHAR *)((BYTE *)section + iter->name_offset);
+        str.Length = iter->name_len;
+        if (RtlEqualUnicodeString( &str, name, TRUE )) return iter;
+        WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_us(&str));
     }
 
-    return index;
+    return NULL;
 }
 
 static struct guid_index *find_guid_index(const struct guidsection_header *section, const GUID *guid)
 {
-    struct guid_index *iter, *index = NULL;
-    ULONG i;
+    struct guid_index *iter;
+    ULONG min = 0, max = section->count, pos;
 
     iter = (struct guid_index*)((BYTE*)section + section->index_offset);
 
-    for (i = 0; i < section->count; i++)
+    while (min < max)
     {
-        if (!memcmp(guid, &iter->guid, sizeof(*guid)))
-        {
-            index = iter;
-            break;
-        }
-        iter++;
+        pos = (min + max) / 2;
+        if (memcmp(&iter[pos].guid, guid, sizeof(*guid)) < 0) min = pos + 1;
+        else max = pos;
     }
 
-    return index;
+    if (min < section->count && !memcmp(&iter[min].guid, guid, sizeof(*guid))) return &iter[min];
+    return NULL;
 }
 
 static inline struct dllredirect_data *get_dllredirect_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
@@ -3502,11 +3536,6 @@ static NTSTATUS find_dll_redirection(ACTIVATION_CONTEXT* actctx, const UNICODE_S
     return STATUS_SUCCESS;
 }
 
-static inline struct string_index *get_wndclass_first_index(ACTIVATION_CONTEXT *actctx)
-{
-    return (struct string_index*)((BYTE*)actctx->wndclass_section + actctx->wndclass_section->index_offset);
-}
-
 static inline struct wndclass_redirect_data *get_wndclass_data(ACTIVATION_CONTEXT *ctxt, struct string_index *index)
 {
     return (struct wndclass_redirect_data*)((BYTE*)ctxt->wndclass_section + index->data_offset);
@@ -3644,6 +3673,8 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
         }
     }
 
+    sort_string_index(header);
+
     *section = header;
 
     return STATUS_SUCCESS;
@@ -3652,11 +3683,8 @@ static NTSTATUS build_wndclass_section(ACTIVATION_CONTEXT* actctx, struct strsec
 static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRING *name,
                                   PACTCTX_SECTION_KEYED_DATA data)
 {
-    struct string_index *iter, *index = NULL;
     struct wndclass_redirect_data *class;
-    UNICODE_STRING str;
-    ULONG hash;
-    int i;
+    struct string_index *index;
 
     if (!(actctx->sections & WINDOWCLASS_SECTION)) return STATUS_SXS_KEY_NOT_FOUND;
 
@@ -3671,27 +3699,7 @@ static NTSTATUS find_window_class(ACTIVATION_CONTEXT* actctx, const UNICODE_STRI
             RtlFreeHeap(GetProcessHeap(), 0, section);
     }
 
-    hash = 0;
-    RtlHashUnicodeString(name, TRUE, HASH_STRING_ALGORITHM_X65599, &hash);
-    iter = get_wndclass_first_index(actctx);
-
-    for (i = 0; i < actctx->wndclass_section->count; i++)
-    {
-        if (iter->hash == hash)
-        {
-            str.Buffer = (WCHAR *)((BYTE *)actctx->wndclass_section + iter->name_offset);
-            str.Length = iter->name_len;
-            if (RtlEqualUnicodeString( &str, name, TRUE ))
-            {
-                index = iter;
-                break;
-            }
-            else
-                WARN("hash collision 0x%08x, %s, %s\n", hash, debugstr_us(name), debugstr_us(&str));
-        }
-        iter++;
-    }
-
+    index = find_string_index(actctx->wndclass_section, name);
     if (!index) return STATUS_SXS_KEY_NOT_FOUND;
 
     if (data)
@@ -3834,6 +3842,8 @@ static NTSTATUS build_tlib_section(ACTIVATION_CONTEXT* actctx, struct guidsectio
         }
     }
 
+    sort_guid_index(header);
+
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4167,6 +4177,8 @@ static NTSTATUS build_comserver_section(ACTIVATION_CONTEXT* actctx, struct guids
         }
     }
 
+    sort_guid_index(header);
+
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4357,6 +4369,8 @@ static NTSTATUS build_ifaceps_section(ACTIVATION_CONTEXT* actctx, struct guidsec
         }
     }
 
+    sort_guid_index(header);
+
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4505,6 +4519,8 @@ static NTSTATUS build_clr_surrogate_section(ACTIVATION_CONTEXT* actctx, struct g
         }
     }
 
+    sort_guid_index(header);
+
     *section = header;
 
     return STATUS_SUCCESS;
@@ -4707,6 +4723,8 @@ static NTSTATUS build_progid_section(ACTIVATION_CONTEXT* actctx, struct strsecti
         }
     }
 
+    sort_string_index(header);
+
     *section = header;
 
     return STATUS_SUCCESS;
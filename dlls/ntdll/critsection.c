@@ -50,6 +50,13 @@ static BOOL crit_section_has_debuginfo(const RTL_CRITICAL_SECTION *crit)
     return crit->DebugInfo != NULL && crit->DebugInfo != no_debug_info_marker;
 }
 
+/* debug info is cleared by MakeCriticalSectionGlobal, any other section is
+ * private to the process and can wait on the LockSemaphore field directly */
+static BOOL crit_section_is_private(const RTL_CRITICAL_SECTION *crit)
+{
+    return crit->DebugInfo != NULL;
+}
+
 /***********************************************************************
  *           get_semaphore
  */
@@ -75,8 +82,7 @@ static inline NTSTATUS wait_semaphore( RTL_CRITICAL_SECTION *crit, int timeout )
 {
     NTSTATUS ret;
 
-    /* debug info is cleared by MakeCriticalSectionGlobal */
-    if (!crit_section_has_debuginfo( crit ) ||
+    if (!crit_section_is_private( crit ) ||
         ((ret = unix_funcs->fast_RtlpWaitForCriticalSection( crit, timeout )) == STATUS_NOT_IMPLEMENTED))
     {
         HANDLE sem = get_semaphore( crit );
@@ -256,7 +262,9 @@ NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
         if (unix_funcs->fast_RtlDeleteCriticalSection( crit ) == STATUS_NOT_IMPLEMENTED)
             NtClose( crit->LockSemaphore );
     }
-    else NtClose( crit->LockSemaphore );
+    else if (!crit_section_is_private( crit ) ||
+             unix_funcs->fast_RtlDeleteCriticalSection( crit ) == STATUS_NOT_IMPLEMENTED)
+        NtClose( crit->LockSemaphore );
     crit->LockSemaphore = 0;
     return STATUS_SUCCESS;
 }
@@ -367,8 +375,7 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
     NTSTATUS ret;
 
-    /* debug info is cleared by MakeCriticalSectionGlobal */
-    if (!crit_section_has_debuginfo( crit ) ||
+    if (!crit_section_is_private( crit ) ||
         ((ret = unix_funcs->fast_RtlpUnWaitCriticalSection( crit )) == STATUS_NOT_IMPLEMENTED))
     {
         HANDLE sem = get_semaphore( crit );
@@ -1076,3 +1076,14 @@ void __cdecl __wine_set_unix_env( const char *var, const char *val)
 {
     unix_funcs->set_unix_env( var, val );
 }
+
+/***********************************************************************
+ *              __wine_fsync_get_shm   (NTDLL.@)
+ *
+ * Returns the address of a server-published fsync shm slot, or NULL
+ * when fsync is not in use.
+ */
+void * __cdecl __wine_fsync_get_shm( unsigned int idx )
+{
+    return unix_funcs->fsync_get_shm_ptr( idx );
+}
@@ -598,6 +598,63 @@ RUNTIME_FUNCTION *lookup_function_info( ULONG_PTR pc, ULONG_PTR *base, LDR_DATA_
     return func;
 }
 
+#ifdef __x86_64__
+/* look for a function entry remembered in an unwind history table */
+static RUNTIME_FUNCTION *search_unwind_history( UNWIND_HISTORY_TABLE *table, ULONG_PTR pc, ULONG_PTR *base )
+{
+    ULONG i;
+
+    if (!table || !table->Count || table->Count > UNWIND_HISTORY_TABLE_SIZE) return NULL;
+    if (pc < table->LowAddress || pc >= table->HighAddress) return NULL;
+
+    for (i = 0; i < table->Count; i++)
+    {
+        UNWIND_HISTORY_TABLE_ENTRY *entry = &table->Entry[i];
+
+        if (pc >= entry->ImageBase + entry->FunctionEntry->BeginAddress &&
+            pc < entry->ImageBase + entry->FunctionEntry->EndAddress)
+        {
+            *base = entry->ImageBase;
+            return entry->FunctionEntry;
+        }
+    }
+    return NULL;
+}
+
+/* remember a function entry in an unwind history table */
+static void add_unwind_history( UNWIND_HISTORY_TABLE *table, ULONG_PTR base, RUNTIME_FUNCTION *func )
+{
+    ULONG_PTR begin = base + func->BeginAddress, end = base + func->EndAddress;
+
+    if (!table || table->Count >= UNWIND_HISTORY_TABLE_SIZE) return;
+
+    if (!table->Count || begin < table->LowAddress) table->LowAddress = begin;
+    if (!table->Count || end > table->HighAddress) table->HighAddress = end;
+    table->Entry[table->Count].ImageBase = base;
+    table->Entry[table->Count].FunctionEntry = func;
+    table->Count++;
+}
+
+/**********************************************************************
+ *           lookup_cached_function_info
+ *
+ * Same as lookup_function_info(), but first looks into the history table, where
+ * the functions found in PE modules are added. module is only set on a cache miss.
+ */
+RUNTIME_FUNCTION *lookup_cached_function_info( ULONG_PTR pc, ULONG_PTR *base, LDR_DATA_TABLE_ENTRY **module,
+                                               UNWIND_HISTORY_TABLE *table )
+{
+    RUNTIME_FUNCTION *func;
+
+    *module = NULL;
+    if ((func = search_unwind_history( table, pc, base ))) return func;
+    /* dynamic function tables may go away at any time, don't remember them */
+    if ((func = lookup_function_info( pc, base, module )) && *module)
+        add_unwind_history( table, *base, func );
+    return func;
+}
+#endif
+
 /**********************************************************************
  *              RtlLookupFunctionEntry   (NTDLL.@)
  */
@@ -607,9 +664,11 @@ PRUNTIME_FUNCTION WINAPI RtlLookupFunctionEntry( ULONG_PTR pc, ULONG_PTR *base,
     LDR_DATA_TABLE_ENTRY *module;
     RUNTIME_FUNCTION *func;
 
-    /* FIXME: should use the history table to make things faster */
-
+#ifdef __x86_64__
+    if (!(func = lookup_cached_function_info( pc, base, &module, table )))
+#else
     if (!(func = lookup_function_info( pc, base, &module )))
+#endif
     {
         *base = 0;
         WARN( "no exception table found for %lx\n", pc );
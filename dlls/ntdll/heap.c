@@ -155,6 +155,8 @@ typedef struct tagHEAP
     struct list      entry;         /* Entry in process heap list */
     struct list      subheap_list;  /* Sub-heap list */
     struct list      large_list;    /* Large blocks list */
+    struct list      large_cache;   /* Recently freed large blocks, most recent first */
+    SIZE_T           large_cache_size; /* Total size of the cached large blocks */
     SIZE_T           grow_size;     /* Size of next subheap for growing heap */
     DWORD            magic;         /* Magic number */
     DWORD            pending_pos;   /* Position in pending free requests ring */
@@ -177,11 +179,31 @@ C_ASSERT( HEAP_NB_FREE_LISTS % HEAP_FREEMASK_BLOCK == 0 );
 #define HEAP_DEF_SIZE        0x110000   /* Default heap size = 1Mb + 64Kb */
 #define COMMIT_MASK          0xffff  /* bitmask for commit/decommit granularity */
 #define MAX_FREE_PENDING     1024    /* max number of free requests to delay */
+#define LARGE_CACHE_MAX_BLOCK 0x2000000 /* largest freed block kept for reuse = 32Mb */
+#define LARGE_CACHE_MAX_SIZE 0x4000000  /* max total size of the freed blocks cache = 64Mb */
 
 BOOL delay_heap_free = FALSE;
 
 static HEAP *processHeap;  /* main process heap */
 
+/* sampled allocation profile, keyed by allocation stack */
+#define HEAP_PROFILE_SIZE    4096    /* number of stacks that can be recorded, a power of two */
+#define HEAP_PROFILE_DUMP    32      /* number of stacks printed on exit */
+
+static SIZE_T heap_profile_rate;     /* bytes between samples, 0 if profiling is disabled */
+static LONG heap_profile_countdown;
+static HEAP_PROFILE_ENTRY *heap_profile;
+static ULONG heap_profile_count;
+
+static RTL_CRITICAL_SECTION heap_profile_section;
+static RTL_CRITICAL_SECTION_DEBUG heap_profile_section_debug =
+{
+    0, 0, &heap_profile_section,
+    { &heap_profile_section_debug.ProcessLocksList, &heap_profile_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": heap_profile_section") }
+};
+static RTL_CRITICAL_SECTION heap_profile_section = { &heap_profile_section_debug, -1, 0, 0, 0, 0 };
+
 static BOOL HEAP_IsRealArena( HEAP *heapPtr, DWORD flags, LPCVOID block, BOOL quiet );
 
 /* get arena size for an rb tree entry */
@@ -777,6 +799,61 @@ static void HEAP_ShrinkBlock(SUBHEAP *subheap, ARENA_INUSE *pArena, SIZE_T size)
 }
 
 
+/***********************************************************************
+ *           get_cached_large_block
+ *
+ * Find a recently freed large block that fits 'block_size' without wasting more than a quarter of it.
+ */
+static ARENA_LARGE *get_cached_large_block( HEAP *heap, SIZE_T block_size )
+{
+    ARENA_LARGE *arena;
+
+    LIST_FOR_EACH_ENTRY( arena, &heap->large_cache, ARENA_LARGE, entry )
+    {
+        if (arena->block_size < block_size || arena->block_size - block_size > block_size / 4) continue;
+        list_remove( &arena->entry );
+        heap->large_cache_size -= arena->block_size;
+        return arena;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           cache_large_block
+ *
+ * Keep a freed large block around for reuse, letting the system reclaim its pages lazily.
+ */
+static BOOL cache_large_block( HEAP *heap, ARENA_LARGE *arena )
+{
+    ARENA_LARGE *old;
+    char *addr = (char *)arena + COMMIT_MASK + 1;
+    SIZE_T size = arena->block_size - COMMIT_MASK - 1;
+    void *address;
+
+    if (arena->block_size > LARGE_CACHE_MAX_BLOCK || (heap->flags & HEAP_SHARED)) return FALSE;
+
+    /* the header stays in the first block, the rest no longer needs to be backed by memory */
+    address = addr;
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 0, &size, MEM_RESET, PAGE_NOACCESS ))
+        return FALSE;
+
+    list_add_head( &heap->large_cache, &arena->entry );
+    heap->large_cache_size += arena->block_size;
+
+    while (heap->large_cache_size > LARGE_CACHE_MAX_SIZE)
+    {
+        old = LIST_ENTRY( list_tail( &heap->large_cache ), ARENA_LARGE, entry );
+        list_remove( &old->entry );
+        heap->large_cache_size -= old->block_size;
+        address = old;
+        size = 0;
+        NtFreeVirtualMemory( NtCurrentProcess(), &address, &size, MEM_RELEASE );
+    }
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           allocate_large_block
  */
@@ -787,13 +864,19 @@ static void *allocate_large_block( HEAP *heap, DWORD flags, SIZE_T size )
     LPVOID address = NULL;
 
     if (block_size < size) return NULL;  /* overflow */
-    if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 0, &block_size,
-                                 MEM_COMMIT, get_protection_type( flags )))
+    if ((arena = get_cached_large_block( heap, block_size )))
+    {
+        /* fresh large blocks are always zeroed, applications depend on it */
+        block_size = arena->block_size;
+        memset( arena + 1, 0, size );
+    }
+    else if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 0, &block_size,
+                                      MEM_COMMIT, get_protection_type( flags )))
     {
         WARN("Could not allocate block for %08lx bytes\n", size );
         return NULL;
     }
-    arena = address;
+    else arena = address;
     arena->data_size = size;
     arena->block_size = block_size;
     arena->size = ARENA_LARGE_SIZE;
@@ -815,6 +898,7 @@ static void free_large_block( HEAP *heap, DWORD flags, void *ptr )
     SIZE_T size = 0;
 
     list_remove( &arena->entry );
+    if (cache_large_block( heap, arena )) return;
     NtFreeVirtualMemory( NtCurrentProcess(), &address, &size, MEM_RELEASE );
 }
 
@@ -996,6 +1080,7 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         heap->grow_size     = max( HEAP_DEF_SIZE, totalSize );
         list_init( &heap->subheap_list );
         list_init( &heap->large_list );
+        list_init( &heap->large_cache );
 
         subheap = &heap->subheap;
         subheap->base       = address;
@@ -1732,6 +1817,13 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
         addr = arena;
         NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
     }
+    LIST_FOR_EACH_ENTRY_SAFE( arena, arena_next, &heapPtr->large_cache, ARENA_LARGE, entry )
+    {
+        list_remove( &arena->entry );
+        size = 0;
+        addr = arena;
+        NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    }
     LIST_FOR_EACH_ENTRY_SAFE( subheap, next, &heapPtr->subheap_list, SUBHEAP, entry )
     {
         if (subheap == &heapPtr->subheap) continue;  /* do this one last */
@@ -1750,6 +1842,113 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
 }
 
 
+/***********************************************************************
+ *           heap_profile_init
+ */
+void heap_profile_init( SIZE_T rate )
+{
+    SIZE_T size = HEAP_PROFILE_SIZE * sizeof(*heap_profile);
+    void *addr = NULL;
+
+    if (!rate || heap_profile) return;
+    if (rate > MAXLONG / 2) rate = MAXLONG / 2;
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &addr, 0, &size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE ))
+        return;
+
+    ERR( "Sampling heap allocations every %lu bytes.\n", rate );
+    heap_profile = addr;
+    heap_profile_countdown = rate;
+    heap_profile_rate = rate;
+}
+
+/* record the stack of the allocation if it crosses the next sampling point */
+static void heap_profile_sample( SIZE_T size )
+{
+    void *frames[HEAP_PROFILE_MAX_FRAMES];
+    LONG left = InterlockedExchangeAdd( &heap_profile_countdown, -(LONG)size ) - (LONG)size;
+    HEAP_PROFILE_ENTRY *entry;
+    USHORT count;
+    ULONG hash, i;
+
+    if (left > 0) return;
+    InterlockedExchangeAdd( &heap_profile_countdown, heap_profile_rate * (-left / heap_profile_rate + 1) );
+
+    /* skip ourselves and RtlAllocateHeap */
+    if (!(count = RtlCaptureStackBackTrace( 2, HEAP_PROFILE_MAX_FRAMES, frames, &hash )))
+    {
+        frames[0] = NULL;
+        count = 1;
+    }
+
+    RtlEnterCriticalSection( &heap_profile_section );
+    for (i = 0; i < HEAP_PROFILE_SIZE; i++)
+    {
+        entry = &heap_profile[(hash + i) & (HEAP_PROFILE_SIZE - 1)];
+        if (!entry->FrameCount)
+        {
+            entry->FrameCount = count;
+            memcpy( entry->Frames, frames, count * sizeof(*frames) );
+            heap_profile_count++;
+        }
+        else if (entry->FrameCount != count || memcmp( entry->Frames, frames, count * sizeof(*frames) ))
+            continue;
+        entry->Samples++;
+        entry->Bytes += size;
+        break;
+    }
+    RtlLeaveCriticalSection( &heap_profile_section );
+}
+
+static int __cdecl heap_profile_compare( const void *a, const void *b )
+{
+    const HEAP_PROFILE_ENTRY *entry_a = a, *entry_b = b;
+
+    if (entry_a->Bytes != entry_b->Bytes) return entry_a->Bytes < entry_b->Bytes ? 1 : -1;
+    return 0;
+}
+
+/* copy the recorded stacks, sorted by decreasing size; return the number of entries */
+static ULONG heap_profile_get_entries( HEAP_PROFILE_ENTRY *entries, ULONG max_count )
+{
+    ULONG i, count = 0;
+
+    for (i = 0; i < HEAP_PROFILE_SIZE && count < max_count; i++)
+        if (heap_profile[i].FrameCount) entries[count++] = heap_profile[i];
+    qsort( entries, count, sizeof(*entries), heap_profile_compare );
+    return count;
+}
+
+/* print the biggest allocation stacks */
+static void heap_profile_dump(void)
+{
+    HEAP_PROFILE_ENTRY *entries;
+    LDR_DATA_TABLE_ENTRY *mod;
+    ULONG i, j, count;
+
+    if (!heap_profile_rate) return;
+
+    RtlEnterCriticalSection( &heap_profile_section );
+    if ((entries = RtlAllocateHeap( GetProcessHeap(), 0, heap_profile_count * sizeof(*entries) )))
+    {
+        count = heap_profile_get_entries( entries, heap_profile_count );
+        MESSAGE( "wine: heap profile, one sample every %lu bytes, %u stacks\n", heap_profile_rate, count );
+        for (i = 0; i < min( count, HEAP_PROFILE_DUMP ); i++)
+        {
+            MESSAGE( "wine: %lu samples, %lu bytes\n", entries[i].Samples, entries[i].Bytes );
+            for (j = 0; j < entries[i].FrameCount; j++)
+            {
+                if (!LdrFindEntryForAddress( entries[i].Frames[j], &mod ))
+                    MESSAGE( "wine:   %p %s+%#lx\n", entries[i].Frames[j], debugstr_w(mod->BaseDllName.Buffer),
+                             (ULONG_PTR)entries[i].Frames[j] - (ULONG_PTR)mod->DllBase );
+                else
+                    MESSAGE( "wine:   %p\n", entries[i].Frames[j] );
+            }
+        }
+        RtlFreeHeap( GetProcessHeap(), 0, entries );
+    }
+    RtlLeaveCriticalSection( &heap_profile_section );
+}
+
 /***********************************************************************
  *           RtlAllocateHeap   (NTDLL.@)
  *
@@ -1792,7 +1991,11 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
     }
 
     TRACE("(%p,%08x,%08lx), status %#x, ptr %p\n", heapPtr, flags, size, status, ptr );
-    if (!status) return ptr;
+    if (!status)
+    {
+        if (heap_profile_rate) heap_profile_sample( size );
+        return ptr;
+    }
     if ((flags & HEAP_GENERATE_EXCEPTIONS) && status == STATUS_NO_MEMORY) RtlRaiseStatus( status );
     RtlSetLastWin32ErrorAndNtStatusFromNtStatus( status );
     return NULL;
@@ -2414,7 +2617,7 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
     if (!(heapPtr = HEAP_GetPtr( heap )))
         return STATUS_INVALID_PARAMETER;
 
-    switch (info_class)
+    switch ((ULONG)info_class)
     {
     case HeapCompatibilityInformation:
         if (size_out) *size_out = sizeof(ULONG);
@@ -2425,6 +2628,25 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         *(ULONG *)info = heapPtr->extended_type;
         return STATUS_SUCCESS;
 
+    case HeapWineProfileInformation:
+    {
+        HEAP_PROFILE_INFORMATION *profile = info;
+        SIZE_T needed;
+
+        RtlEnterCriticalSection( &heap_profile_section );
+        needed = offsetof( HEAP_PROFILE_INFORMATION, Entries[heap_profile_count] );
+        if (size_out) *size_out = needed;
+        if (size_in < needed)
+        {
+            RtlLeaveCriticalSection( &heap_profile_section );
+            return STATUS_BUFFER_TOO_SMALL;
+        }
+        profile->SampleRate = heap_profile_rate;
+        profile->EntryCount = heap_profile_rate ? heap_profile_get_entries( profile->Entries, heap_profile_count ) : 0;
+        RtlLeaveCriticalSection( &heap_profile_section );
+        return STATUS_SUCCESS;
+    }
+
     default:
         FIXME("Unknown heap information class %u\n", info_class);
         return STATUS_INVALID_INFO_CLASS;
@@ -2474,5 +2696,6 @@ NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_
 
 void HEAP_notify_thread_destroy( BOOLEAN last )
 {
+    if (last) heap_profile_dump();
     HEAP_lfh_notify_thread_destroy( last );
 }
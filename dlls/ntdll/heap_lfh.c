@@ -84,6 +84,12 @@ static inline void LFH_slist_push(LFH_slist **list, LFH_slist *entry)
     while (!__atomic_compare_exchange_n(list, &entry->next, entry, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
 }
 
+static inline void LFH_slist_push_list(LFH_slist **list, LFH_slist *head, LFH_slist *tail)
+{
+    tail->next = __atomic_load_n(list, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(list, &tail->next, head, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
 static inline LFH_slist *LFH_slist_flush(LFH_slist **list)
 {
     if (!__atomic_load_n(list, __ATOMIC_RELAXED)) return NULL;
@@ -151,10 +157,17 @@ struct LFH_heap
     LFH_class large_class[TOTAL_LARGE_CLASS_COUNT];
 
     SLIST_ENTRY entry_orphan;
+
+    /* blocks freed by this thread that belong to another thread heap,
+     * batched to push them to its deferred list all at once */
+    LFH_heap *remote_heap;
+    LFH_slist *remote_head;
+    LFH_slist *remote_tail;
+    size_t remote_count;
 #ifdef _WIN64
-    void *pad[0xc2];
+    void *pad[0xbe];
 #else
-    void *pad[0xc3];
+    void *pad[0xbf];
 #endif
 };
 
@@ -417,6 +430,30 @@ static inline BOOLEAN LFH_deallocate_deferred_blocks(LFH_heap *heap)
     return TRUE;
 }
 
+/* maximum number of blocks freed for another thread heap before handing them over */
+#define REMOTE_BATCH_COUNT 32
+
+static inline void LFH_flush_remote_blocks(LFH_heap *heap)
+{
+    if (!heap->remote_head) return;
+    LFH_slist_push_list(&heap->remote_heap->list_defer, heap->remote_head, heap->remote_tail);
+    heap->remote_heap = NULL;
+    heap->remote_head = heap->remote_tail = NULL;
+    heap->remote_count = 0;
+}
+
+static inline void LFH_defer_remote_block(LFH_heap *heap, LFH_heap *remote, LFH_block *block)
+{
+    if (heap->remote_heap != remote) LFH_flush_remote_blocks(heap);
+
+    block->entry_defer.next = heap->remote_head;
+    if (!heap->remote_head) heap->remote_tail = &block->entry_defer;
+    heap->remote_head = &block->entry_defer;
+    heap->remote_heap = remote;
+
+    if (++heap->remote_count >= REMOTE_BATCH_COUNT) LFH_flush_remote_blocks(heap);
+}
+
 static inline void LFH_deallocated_cached_arenas(LFH_heap *heap)
 {
     if (!heap->cached_large_arena) return;
@@ -535,6 +572,9 @@ static void LFH_heap_initialize(LFH_heap *heap)
 
     heap->list_defer = NULL;
     heap->cached_large_arena = NULL;
+    heap->remote_heap = NULL;
+    heap->remote_head = heap->remote_tail = NULL;
+    heap->remote_count = 0;
 }
 
 static SLIST_HEADER *LFH_orphan_list(void)
@@ -569,6 +609,7 @@ static void LFH_heap_finalize(LFH_heap *heap)
 {
     LFH_arena *arena;
 
+    LFH_flush_remote_blocks(heap);
     LFH_deallocate_deferred_blocks(heap);
 
     for (size_t i = 0; i < TOTAL_BLOCK_CLASS_COUNT; ++i)
@@ -904,6 +945,7 @@ static FORCEINLINE LFH_ptr *LFH_allocate(ULONG flags, size_t size)
     if (class_size == ~(size_t)0)
         return NULL;
 
+    LFH_flush_remote_blocks(heap);
     if (!LFH_deallocate_deferred_blocks(heap))
         return NULL;
 
@@ -930,7 +972,7 @@ static FORCEINLINE BOOLEAN LFH_free(ULONG flags, LFH_ptr *ptr)
 {
     LFH_block *block = LFH_block_from_ptr(ptr);
     LFH_arena *arena = LFH_arena_from_block(block);
-    LFH_heap *heap = LFH_heap_from_arena(arena);
+    LFH_heap *heap = LFH_heap_from_arena(arena), *thread_heap;
 
     if (!LFH_class_from_arena(arena))
         return LFH_memory_deallocate(arena, LFH_block_get_class_size(block));
@@ -945,8 +987,11 @@ static FORCEINLINE BOOLEAN LFH_free(ULONG flags, LFH_ptr *ptr)
 
     block->type = LFH_block_type_free;
 
-    if (heap == LFH_thread_heap(FALSE) && !(flags & HEAP_FREE_CHECKING_ENABLED))
+    thread_heap = LFH_thread_heap(FALSE);
+    if (heap == thread_heap && !(flags & HEAP_FREE_CHECKING_ENABLED))
         LFH_deallocate_block(heap, LFH_arena_from_block(block), block);
+    else if (thread_heap && heap != thread_heap)
+        LFH_defer_remote_block(thread_heap, heap, block);
     else
         LFH_slist_push(&heap->list_defer, &block->entry_defer);
 
@@ -1118,8 +1163,12 @@ void HEAP_lfh_notify_thread_destroy(BOOLEAN last)
         }
         LFH_memory_deallocate(list_orphan, BLOCK_ARENA_SIZE);
     }
-    else if ((heap = LFH_thread_heap(FALSE)) && LFH_validate_heap(0, heap))
-        RtlInterlockedPushEntrySList(list_orphan, &heap->entry_orphan);
+    else if ((heap = LFH_thread_heap(FALSE)))
+    {
+        LFH_flush_remote_blocks(heap);
+        if (LFH_validate_heap(0, heap))
+            RtlInterlockedPushEntrySList(list_orphan, &heap->entry_orphan);
+    }
 }
 
 void HEAP_lfh_set_debug_flags(ULONG flags)
@@ -1127,6 +1176,7 @@ void HEAP_lfh_set_debug_flags(ULONG flags)
     LFH_heap *heap = LFH_thread_heap(FALSE);
     if (!heap) return;
 
+    LFH_flush_remote_blocks(heap);
     LFH_deallocate_deferred_blocks(heap);
     LFH_deallocated_cached_arenas(heap);
 }
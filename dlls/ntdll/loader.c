@@ -41,6 +41,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(module);
 WINE_DECLARE_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(relaystats);
 WINE_DECLARE_DEBUG_CHANNEL(snoop);
 WINE_DECLARE_DEBUG_CHANNEL(loaddll);
 WINE_DECLARE_DEBUG_CHANNEL(imports);
@@ -118,13 +119,30 @@ struct file_id
 typedef struct _wine_modref
 {
     LDR_DATA_TABLE_ENTRY  ldr;
+    struct list           hash_entry;  /* entry in the base name hash table */
     struct file_id        id;
     void                 *unix_entry;
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    struct export_hash   *export_hash;  /* hashed index of the exported names */
 } WINE_MODREF;
 
+/* open addressing hash table of the exported names, built on first use */
+struct export_hash
+{
+    const IMAGE_EXPORT_DIRECTORY *exports;  /* export directory the index was built for */
+    DWORD names;       /* names table rva */
+    DWORD count;       /* number of names */
+    DWORD mask;        /* number of buckets minus one, the number of buckets is a power of two */
+    DWORD buckets[1];  /* index in the names table plus one, 0 for an empty bucket */
+};
+
+#define MIN_EXPORT_HASH_NAMES 32  /* binary search is good enough for small export tables */
+
+#define HASH_MAP_SIZE 32
+static struct list hash_table[HASH_MAP_SIZE];  /* loaded modules hashed by base name */
+
 static UINT tls_module_count;      /* number of modules with TLS directory */
 static IMAGE_TLS_DIRECTORY *tls_dirs;  /* array of TLS directories */
 LIST_ENTRY tls_links = { &tls_links, &tls_links };
@@ -514,21 +532,22 @@ static WINE_MODREF *get_modref( HMODULE hmod )
  */
 static WINE_MODREF *find_basename_module( LPCWSTR name )
 {
-    PLIST_ENTRY mark, entry;
     UNICODE_STRING name_str;
+    WINE_MODREF *wm;
+    ULONG hash;
 
     RtlInitUnicodeString( &name_str, name );
 
     if (cached_modref && RtlEqualUnicodeString( &name_str, &cached_modref->ldr.BaseDllName, TRUE ))
         return cached_modref;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    RtlHashUnicodeString( &name_str, TRUE, HASH_STRING_ALGORITHM_X65599, &hash );
+    LIST_FOR_EACH_ENTRY( wm, &hash_table[hash % HASH_MAP_SIZE], WINE_MODREF, hash_entry )
     {
-        LDR_DATA_TABLE_ENTRY *mod = CONTAINING_RECORD(entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
-        if (RtlEqualUnicodeString( &name_str, &mod->BaseDllName, TRUE ))
+        if (wm->ldr.BaseNameHashValue == hash &&
+            RtlEqualUnicodeString( &name_str, &wm->ldr.BaseDllName, TRUE ))
         {
-            cached_modref = CONTAINING_RECORD(mod, WINE_MODREF, ldr);
+            cached_modref = wm;
             return cached_modref;
         }
     }
@@ -724,7 +743,7 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
         const WCHAR *user = current_modref ? current_modref->ldr.BaseDllName.Buffer : NULL;
         proc = SNOOP_GetProcAddress( module, exports, exp_size, proc, ordinal, user );
     }
-    if (TRACE_ON(relay))
+    if (TRACE_ON(relay) || TRACE_ON(relaystats))
     {
         const WCHAR *user = current_modref ? current_modref->ldr.BaseDllName.Buffer : NULL;
         proc = RELAY_GetProcAddress( module, exports, exp_size, proc, ordinal, user );
@@ -733,6 +752,58 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 2166136261u;
+
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_hash
+ *
+ * Get the hashed index of the exported names of a module, building it if needed.
+ * The loader_section must be locked while calling this function.
+ */
+static const struct export_hash *get_export_hash( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    const DWORD *names = get_rva( module, exports->AddressOfNames );
+    struct export_hash *hash;
+    WINE_MODREF *wm;
+    DWORD i, pos, size = 1;
+
+    if (exports->NumberOfNames < MIN_EXPORT_HASH_NAMES) return NULL;
+    if (!(wm = get_modref( module ))) return NULL;
+    if ((hash = wm->export_hash))
+    {
+        /* rebuild it if the export directory was patched */
+        if (hash->exports == exports && hash->names == exports->AddressOfNames &&
+            hash->count == exports->NumberOfNames)
+            return hash;
+        RtlFreeHeap( GetProcessHeap(), 0, hash );
+        wm->export_hash = NULL;
+    }
+
+    while (size < exports->NumberOfNames * 2) size <<= 1;
+    if (!(hash = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                  offsetof( struct export_hash, buckets[size] ))))
+        return NULL;
+    hash->exports = exports;
+    hash->names = exports->AddressOfNames;
+    hash->count = exports->NumberOfNames;
+    hash->mask = size - 1;
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        pos = hash_export_name( get_rva( module, names[i] )) & hash->mask;
+        while (hash->buckets[pos]) pos = (pos + 1) & hash->mask;
+        hash->buckets[pos] = i + 1;
+    }
+    return wm->export_hash = hash;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
@@ -744,6 +815,7 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
 {
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
+    const struct export_hash *hash;
     int min = 0, max = exports->NumberOfNames - 1;
 
     /* first check the hint */
@@ -754,6 +826,20 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
+    /* then look it up in the hash table */
+    if ((hash = get_export_hash( module, exports )))
+    {
+        DWORD index, pos = hash_export_name( name ) & hash->mask;
+
+        while ((index = hash->buckets[pos]))
+        {
+            if (!strcmp( get_rva( module, names[index - 1] ), name ))
+                return find_ordinal_export( module, exports, exp_size, ordinals[index - 1], load_path );
+            pos = (pos + 1) & hash->mask;
+        }
+        return NULL;
+    }
+
     /* then do a binary search */
     while (min <= max)
     {
@@ -1232,6 +1318,8 @@ static WINE_MODREF *alloc_module( HMODULE hModule, const UNICODE_STRING *nt_name
                    &wm->ldr.InLoadOrderLinks);
     InsertTailList(&NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList,
                    &wm->ldr.InMemoryOrderLinks);
+    RtlHashUnicodeString( &wm->ldr.BaseDllName, TRUE, HASH_STRING_ALGORITHM_X65599, &wm->ldr.BaseNameHashValue );
+    list_add_tail( &hash_table[wm->ldr.BaseNameHashValue % HASH_MAP_SIZE], &wm->hash_entry );
     /* wait until init is called for inserting into InInitializationOrderModuleList */
 
     if (!(nt->OptionalHeader.DllCharacteristics & IMAGE_DLLCHARACTERISTICS_NX_COMPAT))
@@ -1932,6 +2020,7 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderLinks);
             RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+            list_remove( &wm->hash_entry );
 
             /* FIXME: there are several more dangling references
              * left. Including dlls loaded by this dll before the
@@ -1949,7 +2038,7 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
 
     if (image_info->u.s.WineBuiltin)
     {
-        if (TRACE_ON(relay)) RELAY_SetupDLL( *module );
+        if (TRACE_ON(relay) || TRACE_ON(relaystats)) RELAY_SetupDLL( *module );
     }
     else
     {
@@ -1983,7 +2072,7 @@ static void build_ntdll_module(void)
     wm = alloc_module( meminfo.AllocationBase, &nt_name, TRUE );
     assert( wm );
     wm->ldr.Flags &= ~LDR_DONT_RESOLVE_REFS;
-    if (TRACE_ON(relay)) RELAY_SetupDLL( meminfo.AllocationBase );
+    if (TRACE_ON(relay) || TRACE_ON(relaystats)) RELAY_SetupDLL( meminfo.AllocationBase );
 }
 
 
@@ -3280,6 +3369,7 @@ void WINAPI LdrShutdownProcess(void)
         RtlProcessFlsData( NtCurrentTeb()->FlsSlots, 1 );
 
     process_detach();
+    RELAY_DumpStats();
 }
 
 
@@ -3362,6 +3452,7 @@ static void free_modref( WINE_MODREF *wm )
 {
     RemoveEntryList(&wm->ldr.InLoadOrderLinks);
     RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+    list_remove( &wm->hash_entry );
     if (wm->ldr.InInitializationOrderLinks.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderLinks);
 
@@ -3378,6 +3469,7 @@ static void free_modref( WINE_MODREF *wm )
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -3700,6 +3792,11 @@ static void load_global_options(void)
         }
         RtlFreeHeap( GetProcessHeap(), 0, env_str );
     }
+    if ((env_str = get_env(L"WINE_HEAP_PROFILE")))
+    {
+        heap_profile_init( wcstoul( env_str, NULL, 10 ) );
+        RtlFreeHeap( GetProcessHeap(), 0, env_str );
+    }
     heap_set_debug_flags( GetProcessHeap() );
 }
 
@@ -4072,6 +4169,7 @@ static NTSTATUS process_init(void)
     TEB *teb = NtCurrentTeb();
     PEB *peb = teb->Peb;
     DWORD hci = 2;
+    ULONG i;
 
     peb->LdrData            = &ldr;
     peb->FastPebLock        = &peb_lock;
@@ -4094,6 +4192,7 @@ static NTSTATUS process_init(void)
     InitializeListHead( &ldr.InLoadOrderModuleList );
     InitializeListHead( &ldr.InMemoryOrderModuleList );
     InitializeListHead( &ldr.InInitializationOrderModuleList );
+    for (i = 0; i < HASH_MAP_SIZE; i++) list_init( &hash_table[i] );
 
 #ifndef _WIN64
     is_wow64 = !!NtCurrentTeb64();
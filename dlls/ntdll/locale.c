@@ -1377,6 +1377,37 @@ found:
 
 
 /* helper for the various utf8 mbstowcs functions */
+/* return the number of leading 7-bit ASCII chars, checking a word at a time */
+static inline unsigned int count_ascii_chars( const char *str, unsigned int len )
+{
+    unsigned int i;
+    UINT64 val;
+
+    for (i = 0; i + sizeof(val) <= len; i += sizeof(val))
+    {
+        memcpy( &val, str + i, sizeof(val) );
+        if (val & 0x8080808080808080ull) break;
+    }
+    while (i < len && !(str[i] & 0x80)) i++;
+    return i;
+}
+
+
+static inline unsigned int count_ascii_wchars( const WCHAR *str, unsigned int len )
+{
+    unsigned int i;
+    UINT64 val;
+
+    for (i = 0; i + 4 <= len; i += 4)
+    {
+        memcpy( &val, str + i, sizeof(val) );
+        if (val & 0xff80ff80ff80ff80ull) break;
+    }
+    while (i < len && str[i] < 0x80) i++;
+    return i;
+}
+
+
 static unsigned int decode_utf8_char( unsigned char ch, const char **str, const char *strend )
 {
     /* number of following bytes in sequence based on first byte value (for bytes above 0x7f) */
@@ -1449,7 +1480,13 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
         for (len = 0; src < srcend; len++)
         {
             unsigned char ch = *src++;
-            if (ch < 0x80) continue;
+            if (ch < 0x80)
+            {
+                unsigned int count = count_ascii_chars( src, srcend - src );
+                src += count;
+                len += count;
+                continue;
+            }
             if ((res = decode_utf8_char( ch, &src, srcend )) > 0x10ffff)
                 status = STATUS_SOME_NOT_MAPPED;
             else
@@ -1464,7 +1501,12 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
         unsigned char ch = *src++;
         if (ch < 0x80)  /* special fast case for 7-bit ASCII */
         {
+            unsigned int i, count = count_ascii_chars( src, min( srcend - src, dstend - dst - 1 ));
+
             *dst++ = ch;
+            for (i = 0; i < count; i++) dst[i] = (unsigned char)src[i];
+            src += count;
+            dst += count;
             continue;
         }
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0xffff)
@@ -1509,7 +1551,13 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
     {
         for (len = 0; srclen; srclen--, src++)
         {
-            if (*src < 0x80) len++;  /* 0x00-0x7f: 1 byte */
+            if (*src < 0x80)  /* 0x00-0x7f: 1 byte */
+            {
+                unsigned int count = count_ascii_wchars( src, srclen );
+                len += count;
+                src += count - 1;
+                srclen -= count - 1;
+            }
             else if (*src < 0x800) len += 2;  /* 0x80-0x7ff: 2 bytes */
             else
             {
@@ -1537,8 +1585,14 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
 
         if (ch < 0x80)  /* 0x00-0x7f: 1 byte */
         {
+            unsigned int i, count;
+
             if (dst > end - 1) break;
-            *dst++ = ch;
+            count = count_ascii_wchars( src, min( srclen, end - dst ));
+            for (i = 0; i < count; i++) dst[i] = src[i];
+            dst += count;
+            src += count - 1;
+            srclen -= count - 1;
             continue;
         }
         if (ch < 0x800)  /* 0x80-0x7ff: 2 bytes */
@@ -31,6 +31,7 @@
 #include "evntprov.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
+WINE_DECLARE_DEBUG_CHANNEL(etw);
 
 LPCSTR debugstr_us( const UNICODE_STRING *us )
 {
@@ -325,13 +326,52 @@ ULONG WINAPI EtwEventActivityIdControl(ULONG code, GUID *guid)
     return ERROR_SUCCESS;
 }
 
+/* In-process event provider registration. A REGHANDLE is a pointer to one
+ * of these; the enable state is checked inline so that writing events to a
+ * provider that no session listens to costs a couple of compares. */
+struct etw_provider
+{
+    GUID            guid;
+    PENABLECALLBACK callback;
+    void           *context;
+    BOOL            enabled;
+    UCHAR           level;
+    ULONGLONG       match_any;
+    ULONGLONG       match_all;
+};
+
+static inline struct etw_provider *etw_provider_from_handle( REGHANDLE handle )
+{
+    return (struct etw_provider *)(ULONG_PTR)handle;
+}
+
+static inline BOOL etw_provider_is_enabled( const struct etw_provider *provider, UCHAR level,
+                                            ULONGLONG keyword )
+{
+    if (!provider || !provider->enabled) return FALSE;
+    if (level && provider->level && level > provider->level) return FALSE;
+    if (!keyword || !provider->match_any) return TRUE;
+    return (keyword & provider->match_any) && (keyword & provider->match_all) == provider->match_all;
+}
+
+static void etw_trace_event( const struct etw_provider *provider, const EVENT_DESCRIPTOR *descriptor,
+                             ULONG count, const EVENT_DATA_DESCRIPTOR *data )
+{
+    ULONG i, size = 0;
+
+    for (i = 0; i < count; i++) size += data[i].Size;
+    TRACE_(etw)( "%s id %u version %u level %u opcode %u task %u keyword %s, %u fields, %u bytes\n",
+                 debugstr_guid(&provider->guid), descriptor->Id, descriptor->Version, descriptor->Level,
+                 descriptor->Opcode, descriptor->Task, wine_dbgstr_longlong(descriptor->Keyword),
+                 count, size );
+}
+
 /******************************************************************************
  *                  EtwEventProviderEnabled (NTDLL.@)
  */
 BOOLEAN WINAPI EtwEventProviderEnabled( REGHANDLE handle, UCHAR level, ULONGLONG keyword )
 {
-    FIXME("%s, %u, %s: stub\n", wine_dbgstr_longlong(handle), level, wine_dbgstr_longlong(keyword));
-    return FALSE;
+    return etw_provider_is_enabled( etw_provider_from_handle( handle ), level, keyword );
 }
 
 /******************************************************************************
@@ -340,11 +380,30 @@ BOOLEAN WINAPI EtwEventProviderEnabled( REGHANDLE handle, UCHAR level, ULONGLONG
 ULONG WINAPI EtwEventRegister( LPCGUID provider, PENABLECALLBACK callback, PVOID context,
                 PREGHANDLE handle )
 {
-    FIXME("(%s, %p, %p, %p) stub.\n", debugstr_guid(provider), callback, context, handle);
+    struct etw_provider *object;
+
+    TRACE("(%s, %p, %p, %p)\n", debugstr_guid(provider), callback, context, handle);
 
-    if (!handle) return ERROR_INVALID_PARAMETER;
+    if (!provider || !handle) return ERROR_INVALID_PARAMETER;
 
-    *handle = 0xdeadbeef;
+    if (!(object = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*object) )))
+        return ERROR_NOT_ENOUGH_MEMORY;
+    object->guid     = *provider;
+    object->callback = callback;
+    object->context  = context;
+
+    /* The only consumer is the etw debug channel, which listens to everything. */
+    if (TRACE_ON(etw))
+    {
+        object->enabled = TRUE;
+        object->level   = EVENT_LEVEL_MAX;
+    }
+
+    *handle = (REGHANDLE)(ULONG_PTR)object;
+
+    if (object->enabled && callback)
+        callback( provider, EVENT_CONTROL_CODE_ENABLE_PROVIDER, object->level,
+                  object->match_any, object->match_all, NULL, context );
     return ERROR_SUCCESS;
 }
 
@@ -353,7 +412,12 @@ ULONG WINAPI EtwEventRegister( LPCGUID provider, PENABLECALLBACK callback, PVOID
  */
 ULONG WINAPI EtwEventUnregister( REGHANDLE handle )
 {
-    FIXME("(%s) stub.\n", wine_dbgstr_longlong(handle));
+    struct etw_provider *provider = etw_provider_from_handle( handle );
+
+    TRACE("(%s)\n", wine_dbgstr_longlong(handle));
+
+    if (!provider) return ERROR_INVALID_HANDLE;
+    RtlFreeHeap( GetProcessHeap(), 0, provider );
     return ERROR_SUCCESS;
 }
 
@@ -372,8 +436,14 @@ ULONG WINAPI EtwEventSetInformation( REGHANDLE handle, EVENT_INFO_CLASS class, v
  */
 ULONG WINAPI EtwEventWriteString( REGHANDLE handle, UCHAR level, ULONGLONG keyword, PCWSTR string )
 {
-    FIXME("%s, %u, %s, %s: stub\n", wine_dbgstr_longlong(handle), level,
-          wine_dbgstr_longlong(keyword), debugstr_w(string));
+    struct etw_provider *provider = etw_provider_from_handle( handle );
+
+    if (!provider) return ERROR_INVALID_HANDLE;
+    if (!string) return ERROR_INVALID_PARAMETER;
+    if (!etw_provider_is_enabled( provider, level, keyword )) return ERROR_SUCCESS;
+
+    TRACE_(etw)( "%s level %u keyword %s: %s\n", debugstr_guid(&provider->guid), level,
+                 wine_dbgstr_longlong(keyword), debugstr_w(string) );
     return ERROR_SUCCESS;
 }
 
@@ -383,8 +453,14 @@ ULONG WINAPI EtwEventWriteString( REGHANDLE handle, UCHAR level, ULONGLONG keywo
 ULONG WINAPI EtwEventWriteTransfer( REGHANDLE handle, PCEVENT_DESCRIPTOR descriptor, LPCGUID activity,
                                     LPCGUID related, ULONG count, PEVENT_DATA_DESCRIPTOR data )
 {
-    FIXME("%s, %p, %s, %s, %u, %p: stub\n", wine_dbgstr_longlong(handle), descriptor,
-          debugstr_guid(activity), debugstr_guid(related), count, data);
+    struct etw_provider *provider = etw_provider_from_handle( handle );
+
+    if (!descriptor) return ERROR_INVALID_PARAMETER;
+    if (!etw_provider_is_enabled( provider, descriptor->Level, descriptor->Keyword )) return ERROR_SUCCESS;
+    if (count && !data) return ERROR_INVALID_PARAMETER;
+
+    TRACE_(etw)( "activity %s, related %s\n", debugstr_guid(activity), debugstr_guid(related) );
+    etw_trace_event( provider, descriptor, count, data );
     return ERROR_SUCCESS;
 }
 
@@ -461,8 +537,8 @@ ULONG WINAPI EtwUnregisterTraceGuids( TRACEHANDLE RegistrationHandle )
  */
 BOOLEAN WINAPI EtwEventEnabled( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor )
 {
-    FIXME("(%s, %p): stub\n", wine_dbgstr_longlong(handle), descriptor);
-    return FALSE;
+    if (!descriptor) return FALSE;
+    return etw_provider_is_enabled( etw_provider_from_handle( handle ), descriptor->Level, descriptor->Keyword );
 }
 
 /******************************************************************************
@@ -471,7 +547,13 @@ BOOLEAN WINAPI EtwEventEnabled( REGHANDLE handle, const EVENT_DESCRIPTOR *descri
 ULONG WINAPI EtwEventWrite( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor, ULONG count,
     EVENT_DATA_DESCRIPTOR *data )
 {
-    FIXME("(%s, %p, %u, %p): stub\n", wine_dbgstr_longlong(handle), descriptor, count, data);
+    struct etw_provider *provider = etw_provider_from_handle( handle );
+
+    if (!descriptor) return ERROR_INVALID_PARAMETER;
+    if (!etw_provider_is_enabled( provider, descriptor->Level, descriptor->Keyword )) return ERROR_SUCCESS;
+    if (count && !data) return ERROR_INVALID_PARAMETER;
+
+    etw_trace_event( provider, descriptor, count, data );
     return ERROR_SUCCESS;
 }
 
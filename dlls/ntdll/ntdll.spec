@@ -1612,6 +1612,7 @@
 @ extern __wine_syscall_dispatcher
 @ extern -arch=i386 __wine_ldt_copy
 @ cdecl __wine_set_unix_env(ptr ptr)
+@ cdecl __wine_fsync_get_shm(long)
 
 # Debugging
 @ cdecl -norelay __wine_dbg_get_channel_flags(ptr)
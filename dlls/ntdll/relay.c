@@ -29,10 +29,12 @@
 #include "windef.h"
 #include "winternl.h"
 #include "wine/exception.h"
+#include "wine/list.h"
 #include "ntdll_misc.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(relaystats);
 
 #if defined(__i386__) || defined(__x86_64__) || defined(__arm__) || defined(__aarch64__)
 
@@ -61,12 +63,16 @@ struct relay_entry_point
 {
     void       *orig_func;    /* original entry point function */
     const char *name;         /* function name (if any) */
+    LONG        calls;        /* number of calls, for +relaystats */
+    LONGLONG    time;         /* time spent in the function, for +relaystats */
 };
 
 struct relay_private_data
 {
+    struct list              entry;             /* entry in the list of relayed dlls */
     HMODULE                  module;            /* module handle of this dll */
     unsigned int             base;              /* ordinal base */
+    unsigned int             nb_entry_points;   /* number of entry points */
     char                     dllname[40];       /* dll name (without .dll extension) */
     struct relay_entry_point entry_points[1];   /* list of dll entry points */
 };
@@ -82,6 +88,27 @@ static const WCHAR **debug_from_snoop_includelist;
 
 static RTL_RUN_ONCE init_once = RTL_RUN_ONCE_INIT;
 
+static struct list relay_dlls = LIST_INIT( relay_dlls );
+
+/* with +relaystats, calls are counted and timed instead of traced */
+
+struct relay_stats_frame
+{
+    struct relay_entry_point *entry_point;
+    ULONG_PTR                 retaddr;
+    LONGLONG                  start;
+};
+
+struct relay_stats_thread
+{
+    unsigned int             depth;        /* number of frames in use */
+    unsigned int             overflow;     /* number of calls that didn't fit in frames */
+    struct relay_stats_frame frames[64];
+};
+
+static BOOL relay_stats;
+static ULONG relay_stats_index;
+
 /* compare an ASCII and a Unicode string without depending on the current codepage */
 static inline int strcmpAW( const char *strA, const WCHAR *strW )
 {
@@ -157,6 +184,15 @@ static const WCHAR **load_list( HKEY hkey, const WCHAR *value )
     return list;
 }
 
+/***********************************************************************
+ *           relay_stats_free_thread
+ */
+static void WINAPI relay_stats_free_thread( void *data )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, data );
+}
+
+
 /***********************************************************************
  *           init_debug_lists
  *
@@ -168,6 +204,9 @@ static DWORD WINAPI init_debug_lists( RTL_RUN_ONCE *once, void *param, void **co
     UNICODE_STRING name;
     HANDLE root, hkey;
 
+    if (TRACE_ON(relaystats) && !RtlFlsAlloc( relay_stats_free_thread, &relay_stats_index ))
+        relay_stats = TRUE;
+
     RtlOpenCurrentUser( KEY_ALL_ACCESS, &root );
     attr.Length = sizeof(attr);
     attr.RootDirectory = root;
@@ -276,6 +315,69 @@ static BOOL check_from_module( const WCHAR **includelist, const WCHAR **excludel
 }
 
 
+/***********************************************************************
+ *           relay_stats_enter
+ *
+ * Count a call and record its start time for +relaystats.
+ */
+static void relay_stats_enter( struct relay_entry_point *entry_point, ULONG_PTR retaddr )
+{
+    struct relay_stats_thread *thread;
+    struct relay_stats_frame *frame;
+    LARGE_INTEGER now;
+
+    InterlockedIncrement( &entry_point->calls );
+
+    if (RtlFlsGetValue( relay_stats_index, (void **)&thread )) return;
+    if (!thread)
+    {
+        if (!(thread = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*thread) ))) return;
+        RtlFlsSetValue( relay_stats_index, thread );
+    }
+    if (thread->depth == ARRAY_SIZE(thread->frames))
+    {
+        thread->overflow++;
+        return;
+    }
+
+    RtlQueryPerformanceCounter( &now );
+    frame = &thread->frames[thread->depth++];
+    frame->entry_point = entry_point;
+    frame->retaddr = retaddr;
+    frame->start = now.QuadPart;
+}
+
+
+/***********************************************************************
+ *           relay_stats_exit
+ *
+ * Add the time spent in a call for +relaystats.
+ */
+static void relay_stats_exit( struct relay_entry_point *entry_point, ULONG_PTR retaddr )
+{
+    struct relay_stats_thread *thread;
+    struct relay_stats_frame *frame;
+    LARGE_INTEGER now;
+
+    if (RtlFlsGetValue( relay_stats_index, (void **)&thread ) || !thread) return;
+    if (thread->overflow)
+    {
+        thread->overflow--;
+        return;
+    }
+
+    RtlQueryPerformanceCounter( &now );
+    /* skip the frames of calls that were unwound by an exception */
+    while (thread->depth)
+    {
+        frame = &thread->frames[--thread->depth];
+        if (frame->entry_point != entry_point || frame->retaddr != retaddr) continue;
+        InterlockedExchangeAdd64( &entry_point->time, now.QuadPart - frame->start );
+        break;
+    }
+}
+
+
 static BOOL is_ret_val( char type )
 {
     return type >= 'A' && type <= 'Z';
@@ -291,6 +393,34 @@ static const char *func_name( struct relay_private_data *data, unsigned int ordi
         return wine_dbg_sprintf( "%s.%u", data->dllname, data->base + ordinal );
 }
 
+/***********************************************************************
+ *           RELAY_DumpStats
+ *
+ * Print the +relaystats counters when the process exits.
+ */
+void RELAY_DumpStats(void)
+{
+    struct relay_private_data *data;
+    LARGE_INTEGER frequency;
+    unsigned int i;
+
+    if (!relay_stats) return;
+
+    RtlQueryPerformanceFrequency( &frequency );
+    LIST_FOR_EACH_ENTRY( data, &relay_dlls, struct relay_private_data, entry )
+    {
+        for (i = 0; i < data->nb_entry_points; i++)
+        {
+            struct relay_entry_point *entry_point = data->entry_points + i;
+
+            if (!entry_point->calls) continue;
+            TRACE_(relaystats)( "%s: %u calls, %I64u us\n", func_name( data, i ), entry_point->calls,
+                                entry_point->time * 1000000 / frequency.QuadPart );
+        }
+    }
+}
+
+
 static void trace_string_a( INT_PTR ptr )
 {
     if (!IS_INTARG( ptr )) TRACE( "%08Ix %s", ptr, debugstr_a( (char *)ptr ));
@@ -358,6 +488,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
         if (arg_types[1] == 't') *nb_args |= 0x40000000;  /* fastcall */
     }
     TRACE( ") ret=%08x\n", stack[-1] );
+    if (relay_stats) relay_stats_enter( entry_point, (ULONG_PTR)stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -369,6 +500,12 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (relay_stats)
+    {
+        struct relay_private_data *data = descr->private;
+        relay_stats_exit( data->entry_points + LOWORD(idx), (ULONG_PTR)retaddr );
+    }
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -522,6 +659,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 #endif
     *nb_args = pos;
     TRACE( ") ret=%08x\n", stack[-1] );
+    if (relay_stats) relay_stats_enter( entry_point, (ULONG_PTR)stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -533,6 +671,12 @@ DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigne
 {
     const char *arg_types = descr->args_string + HIWORD(idx);
 
+    if (relay_stats)
+    {
+        struct relay_private_data *data = descr->private;
+        relay_stats_exit( data->entry_points + LOWORD(idx), (ULONG_PTR)retaddr );
+    }
+
     TRACE( "\1Ret  %s()", func_name( descr->private, LOWORD(idx) ));
 
     while (!is_ret_val( *arg_types )) arg_types++;
@@ -631,6 +775,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     }
     *nb_args = i;
     TRACE( ") ret=%08zx\n", stack[-1] );
+    if (relay_stats) relay_stats_enter( entry_point, (ULONG_PTR)stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -640,6 +785,12 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (relay_stats)
+    {
+        struct relay_private_data *data = descr->private;
+        relay_stats_exit( data->entry_points + LOWORD(idx), (ULONG_PTR)retaddr );
+    }
+
     TRACE( "\1Ret  %s() retval=%08zx ret=%08zx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -737,6 +888,7 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
     }
     *nb_args = i;
     TRACE( ") ret=%08zx\n", stack[-1] );
+    if (relay_stats) relay_stats_enter( entry_point, (ULONG_PTR)stack[-1] );
     return entry_point->orig_func;
 }
 
@@ -746,6 +898,12 @@ DECLSPEC_HIDDEN void * WINAPI relay_trace_entry( struct relay_descr *descr, unsi
 DECLSPEC_HIDDEN void WINAPI relay_trace_exit( struct relay_descr *descr, unsigned int idx,
                                               INT_PTR retaddr, INT_PTR retval )
 {
+    if (relay_stats)
+    {
+        struct relay_private_data *data = descr->private;
+        relay_stats_exit( data->entry_points + LOWORD(idx), (ULONG_PTR)retaddr );
+    }
+
     TRACE( "\1Ret  %s() retval=%08zx ret=%08zx\n",
            func_name( descr->private, LOWORD(idx) ), retval, retaddr );
 }
@@ -895,6 +1053,8 @@ void RELAY_SetupDLL( HMODULE module )
 
     data->module = module;
     data->base   = exports->Base;
+    data->nb_entry_points = exports->NumberOfFunctions;
+    list_add_tail( &relay_dlls, &data->entry );
     len = strlen( (char *)module + exports->Name );
     if (len > 4 && !_stricmp( (char *)module + exports->Name + len - 4, ".dll" )) len -= 4;
     len = min( len, sizeof(data->dllname) - 1 );
@@ -944,6 +1104,10 @@ void RELAY_SetupDLL( HMODULE module )
 {
 }
 
+void RELAY_DumpStats(void)
+{
+}
+
 #endif  /* __i386__ || __x86_64__ || __arm__ || __aarch64__ */
 
 
@@ -2640,6 +2640,84 @@ static void test_get_next_thread(void)
     pNtClose(prev);
 }
 
+static void test_handle_info(void)
+{
+    OBJECT_DATA_INFORMATION info;
+    HANDLE handle, dup, handles[200];
+    NTSTATUS status;
+    unsigned int i;
+    ULONG len;
+    BOOL ret;
+
+    handle = CreateEventA( NULL, FALSE, FALSE, NULL );
+    ok( handle != NULL, "CreateEvent failed %u\n", GetLastError() );
+
+    memset( &info, 0xcc, sizeof(info) );
+    len = 0xdeadbeef;
+    status = pNtQueryObject( handle, ObjectDataInformation, &info, sizeof(info), &len );
+    ok( !status, "NtQueryObject failed %x\n", status );
+    ok( len == sizeof(info), "got len %u\n", len );
+    ok( !info.InheritHandle, "got inherit %u\n", info.InheritHandle );
+    ok( !info.ProtectFromClose, "got protect %u\n", info.ProtectFromClose );
+
+    ret = SetHandleInformation( handle, HANDLE_FLAG_INHERIT | HANDLE_FLAG_PROTECT_FROM_CLOSE,
+                                HANDLE_FLAG_INHERIT | HANDLE_FLAG_PROTECT_FROM_CLOSE );
+    ok( ret, "SetHandleInformation failed %u\n", GetLastError() );
+    status = pNtQueryObject( handle, ObjectDataInformation, &info, sizeof(info), NULL );
+    ok( !status, "NtQueryObject failed %x\n", status );
+    ok( info.InheritHandle, "got inherit %u\n", info.InheritHandle );
+    ok( info.ProtectFromClose, "got protect %u\n", info.ProtectFromClose );
+
+    ret = SetHandleInformation( handle, HANDLE_FLAG_PROTECT_FROM_CLOSE, 0 );
+    ok( ret, "SetHandleInformation failed %u\n", GetLastError() );
+    status = pNtQueryObject( handle, ObjectDataInformation, &info, sizeof(info), NULL );
+    ok( !status, "NtQueryObject failed %x\n", status );
+    ok( info.InheritHandle, "got inherit %u\n", info.InheritHandle );
+    ok( !info.ProtectFromClose, "got protect %u\n", info.ProtectFromClose );
+
+    ret = DuplicateHandle( GetCurrentProcess(), handle, GetCurrentProcess(), &dup, 0, FALSE,
+                           DUPLICATE_SAME_ACCESS | DUPLICATE_CLOSE_SOURCE );
+    ok( ret, "DuplicateHandle failed %u\n", GetLastError() );
+    if (dup != handle)
+    {
+        status = pNtQueryObject( handle, ObjectDataInformation, &info, sizeof(info), NULL );
+        ok( status == STATUS_INVALID_HANDLE, "NtQueryObject returned %x\n", status );
+    }
+    status = pNtQueryObject( dup, ObjectDataInformation, &info, sizeof(info), NULL );
+    ok( !status, "NtQueryObject failed %x\n", status );
+    ok( !info.InheritHandle, "got inherit %u\n", info.InheritHandle );
+    ok( !info.ProtectFromClose, "got protect %u\n", info.ProtectFromClose );
+
+    pNtClose( dup );
+    status = pNtQueryObject( dup, ObjectDataInformation, &info, sizeof(info), NULL );
+    ok( status == STATUS_INVALID_HANDLE, "NtQueryObject returned %x\n", status );
+    ret = DuplicateHandle( GetCurrentProcess(), dup, GetCurrentProcess(), &handle, 0, FALSE,
+                           DUPLICATE_SAME_ACCESS );
+    ok( !ret, "DuplicateHandle succeeded\n" );
+    ok( GetLastError() == ERROR_INVALID_HANDLE, "got error %u\n", GetLastError() );
+
+    /* make sure the handle table grows */
+    for (i = 0; i < ARRAY_SIZE(handles); i++)
+    {
+        handles[i] = CreateEventA( NULL, FALSE, FALSE, NULL );
+        ok( handles[i] != NULL, "CreateEvent failed %u\n", GetLastError() );
+    }
+    ret = SetHandleInformation( handles[i - 1], HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT );
+    ok( ret, "SetHandleInformation failed %u\n", GetLastError() );
+    for (i = 0; i < ARRAY_SIZE(handles); i++)
+    {
+        status = pNtQueryObject( handles[i], ObjectDataInformation, &info, sizeof(info), NULL );
+        ok( !status, "%u: NtQueryObject failed %x\n", i, status );
+        ok( info.InheritHandle == (i == ARRAY_SIZE(handles) - 1), "%u: got inherit %u\n", i, info.InheritHandle );
+    }
+    for (i = 0; i < ARRAY_SIZE(handles); i++) pNtClose( handles[i] );
+    for (i = 0; i < ARRAY_SIZE(handles); i++)
+    {
+        status = pNtQueryObject( handles[i], ObjectDataInformation, &info, sizeof(info), NULL );
+        ok( status == STATUS_INVALID_HANDLE, "%u: NtQueryObject returned %x\n", i, status );
+    }
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
@@ -2710,4 +2788,5 @@ START_TEST(om)
     test_process();
     test_object_types();
     test_get_next_thread();
+    test_handle_info();
 }
@@ -30,6 +30,7 @@
 
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/rbtree.h"
 
 #include "ntdll_misc.h"
 
@@ -73,6 +74,8 @@ struct queue_timer
 {
     struct timer_queue *q;
     struct list entry;
+    struct wine_rb_entry expire_entry;
+    ULONG serial;               /* insertion order for timers with equal expiration time */
     ULONG runcount;             /* number of callbacks pending execution */
     RTL_WAITORTIMERCALLBACKFUNC callback;
     PVOID param;
@@ -87,7 +90,9 @@ struct timer_queue
 {
     DWORD magic;
     RTL_CRITICAL_SECTION cs;
-    struct list timers;         /* sorted by expiration time */
+    struct list timers;         /* all timers of the queue */
+    struct wine_rb_tree expiry; /* timers sorted by expiration time */
+    ULONG serial;
     BOOL quit;                  /* queue should be deleted; once set, never unset */
     HANDLE event;
     HANDLE thread;
@@ -178,7 +183,8 @@ struct threadpool_object
             /* information about the timer, locked via timerqueue.cs */
             BOOL            timer_initialized;
             BOOL            timer_pending;
-            struct list     timer_entry;
+            struct wine_rb_entry timer_entry;
+            ULONG           timer_serial;
             BOOL            timer_set;
             ULONGLONG       timeout;
             LONG            period;
@@ -238,13 +244,15 @@ struct threadpool_group
 
 /* global timerqueue object */
 static RTL_CRITICAL_SECTION_DEBUG timerqueue_debug;
+static int compare_pending_timer( const void *key, const struct wine_rb_entry *entry );
 
 static struct
 {
     CRITICAL_SECTION        cs;
     LONG                    objcount;
     BOOL                    thread_running;
-    struct list             pending_timers;
+    struct wine_rb_tree     pending_timers;
+    ULONG                   serial;
     RTL_CONDITION_VARIABLE  update_event;
 }
 timerqueue =
@@ -252,7 +260,8 @@ timerqueue =
     { &timerqueue_debug, -1, 0, 0, 0, 0 },      /* cs */
     0,                                          /* objcount */
     FALSE,                                      /* thread_running */
-    LIST_INIT( timerqueue.pending_timers ),     /* pending_timers */
+    { compare_pending_timer },                  /* pending_timers */
+    0,                                          /* serial */
     RTL_CONDITION_VARIABLE_INIT                 /* update_event */
 };
 
@@ -294,8 +303,17 @@ struct waitqueue_bucket
     struct list             waiting;
     HANDLE                  update_event;
     BOOL                    alertable;
+    BOOL                    changed;
 };
 
+/* Wakes up the wait queue thread of the bucket and makes it rebuild its
+ * wait array, waitqueue.cs has to be held. */
+static inline void waitqueue_bucket_update( struct waitqueue_bucket *bucket )
+{
+    bucket->changed = TRUE;
+    NtSetEvent( bucket->update_event, NULL );
+}
+
 /* global I/O completion queue object */
 static RTL_CRITICAL_SECTION_DEBUG ioqueue_debug;
 
@@ -367,6 +385,7 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled );
 static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread );
 static void tp_object_prepare_shutdown( struct threadpool_object *object );
 static BOOL tp_object_release( struct threadpool_object *object );
+static BOOL tp_threadpool_release( struct threadpool *pool );
 static struct threadpool *default_threadpool = NULL;
 
 static BOOL array_reserve(void **elements, unsigned int *capacity, unsigned int count, unsigned int size)
@@ -560,6 +579,7 @@ static void queue_remove_timer(struct queue_timer *t)
     assert(t->destroy);
 
     list_remove(&t->entry);
+    wine_rb_remove(&q->expiry, &t->expire_entry);
     if (t->event)
         NtSetEvent(t->event, NULL);
     RtlFreeHeap(GetProcessHeap(), 0, t);
@@ -597,38 +617,56 @@ static inline ULONGLONG queue_current_time(void)
     return now.QuadPart * 1000 / freq.QuadPart;
 }
 
-static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
-                            BOOL set_event)
+static int compare_queue_timer(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct queue_timer *t = key;
+    const struct queue_timer *cur = WINE_RB_ENTRY_VALUE(entry, const struct queue_timer, expire_entry);
+
+    if (t->expire != cur->expire)
+        return t->expire < cur->expire ? -1 : 1;
+    if (t->serial != cur->serial)
+        return (int)(t->serial - cur->serial);
+    return 0;
+}
+
+static inline struct queue_timer *queue_first_timer(struct timer_queue *q)
+{
+    struct wine_rb_entry *entry = wine_rb_head(q->expiry.root);
+    return entry ? WINE_RB_ENTRY_VALUE(entry, struct queue_timer, expire_entry) : NULL;
+}
+
+static void queue_insert_timer(struct queue_timer *t, ULONGLONG time,
+                               BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
-    if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
-        {
-            struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
-                break;
-        }
-    list_add_before(ptr, &t->entry);
-
     t->expire = time;
+    t->serial = q->serial++;
+    wine_rb_put(&q->expiry, t, &t->expire_entry);
 
-    /* If we insert at the head of the list, we need to expire sooner
+    /* If we insert at the head of the queue, we need to expire sooner
        than expected.  */
-    if (set_event && &t->entry == list_head(&q->timers))
+    if (set_event && queue_first_timer(q) == t)
         NtSetEvent(q->event, NULL);
 }
 
+static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
+                            BOOL set_event)
+{
+    /* We MUST hold the queue cs while calling this function.  */
+    list_add_tail(&t->q->timers, &t->entry);
+    queue_insert_timer(t, time, set_event);
+}
+
 static inline void queue_move_timer(struct queue_timer *t, ULONGLONG time,
                                     BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
-    list_remove(&t->entry);
-    queue_add_timer(t, time, set_event);
+    wine_rb_remove(&t->q->expiry, &t->expire_entry);
+    queue_insert_timer(t, time, set_event);
 }
 
 static void queue_timer_expire(struct timer_queue *q)
@@ -636,10 +674,9 @@ static void queue_timer_expire(struct timer_queue *q)
     struct queue_timer *t = NULL;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((t = queue_first_timer(q)))
     {
         ULONGLONG now, next;
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
         if (!t->destroy && t->expire <= ((now = queue_current_time())))
         {
             ++t->runcount;
@@ -682,9 +719,8 @@ static ULONG queue_get_timeout(struct timer_queue *q)
     ULONG timeout = INFINITE;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((t = queue_first_timer(q)))
     {
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
         assert(!t->destroy || t->expire == EXPIRE_NEVER);
 
         if (t->expire != EXPIRE_NEVER)
@@ -751,7 +787,7 @@ static void queue_destroy_timer(struct queue_timer *t)
         queue_remove_timer(t);
     else
         /* Make sure no destroyed timer masks an active timer at the head
-           of the sorted list.  */
+           of the sorted queue.  */
         queue_move_timer(t, EXPIRE_NEVER, FALSE);
 }
 
@@ -776,6 +812,8 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
 
     RtlInitializeCriticalSection(&q->cs);
     list_init(&q->timers);
+    wine_rb_init(&q->expiry, compare_queue_timer);
+    q->serial = 0;
     q->quit = FALSE;
     q->magic = TIMER_QUEUE_MAGIC;
     status = NtCreateEvent(&q->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
@@ -1041,6 +1079,55 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+/***********************************************************************
+ *           compare_pending_timer    (internal)
+ *
+ * Orders pending timers by their timeout, timers with the same timeout
+ * in the order they were queued.
+ */
+static int compare_pending_timer( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct threadpool_object *timer = key;
+    const struct threadpool_object *other_timer = WINE_RB_ENTRY_VALUE( entry, const struct threadpool_object,
+                                                                       u.timer.timer_entry );
+
+    if (timer->u.timer.timeout != other_timer->u.timer.timeout)
+        return timer->u.timer.timeout < other_timer->u.timer.timeout ? -1 : 1;
+    if (timer->u.timer.timer_serial != other_timer->u.timer.timer_serial)
+        return (int)(timer->u.timer.timer_serial - other_timer->u.timer.timer_serial);
+    return 0;
+}
+
+/***********************************************************************
+ *           tp_timerqueue_insert    (internal)
+ *
+ * Inserts a timer into the pending timers, returns TRUE if it became the
+ * first one to expire. timerqueue.cs has to be held.
+ */
+static BOOL tp_timerqueue_insert( struct threadpool_object *timer )
+{
+    assert( timer->type == TP_OBJECT_TYPE_TIMER );
+    assert( !timer->u.timer.timer_pending );
+
+    timer->u.timer.timer_serial = timerqueue.serial++;
+    wine_rb_put( &timerqueue.pending_timers, timer, &timer->u.timer.timer_entry );
+    timer->u.timer.timer_pending = TRUE;
+    return wine_rb_head( timerqueue.pending_timers.root ) == &timer->u.timer.timer_entry;
+}
+
+/***********************************************************************
+ *           tp_timerqueue_remove    (internal)
+ *
+ * Removes a timer from the pending timers, timerqueue.cs has to be held.
+ */
+static void tp_timerqueue_remove( struct threadpool_object *timer )
+{
+    assert( timer->u.timer.timer_pending );
+
+    wine_rb_remove( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
+    timer->u.timer.timer_pending = FALSE;
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
@@ -1049,7 +1136,7 @@ static void CALLBACK timerqueue_thread_proc( void *param )
     ULONGLONG timeout_lower, timeout_upper, new_timeout;
     struct threadpool_object *other_timer;
     LARGE_INTEGER now, timeout;
-    struct list *ptr;
+    struct wine_rb_entry *ptr;
 
     TRACE( "starting timer queue thread\n" );
 
@@ -1059,17 +1146,15 @@ static void CALLBACK timerqueue_thread_proc( void *param )
         NtQuerySystemTime( &now );
 
         /* Check for expired timers. */
-        while ((ptr = list_head( &timerqueue.pending_timers )))
+        while ((ptr = wine_rb_head( timerqueue.pending_timers.root )))
         {
-            struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
+            struct threadpool_object *timer = WINE_RB_ENTRY_VALUE( ptr, struct threadpool_object, u.timer.timer_entry );
             assert( timer->type == TP_OBJECT_TYPE_TIMER );
-            assert( timer->u.timer.timer_pending );
             if (timer->u.timer.timeout > now.QuadPart)
                 break;
 
             /* Queue a new callback in one of the worker threads. */
-            list_remove( &timer->u.timer.timer_entry );
-            timer->u.timer.timer_pending = FALSE;
+            tp_timerqueue_remove( timer );
             tp_object_submit( timer, FALSE );
 
             /* Insert the timer back into the queue, except it's marked for shutdown. */
@@ -1079,23 +1164,15 @@ static void CALLBACK timerqueue_thread_proc( void *param )
                 if (timer->u.timer.timeout <= now.QuadPart)
                     timer->u.timer.timeout = now.QuadPart + 1;
 
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
-                timer->u.timer.timer_pending = TRUE;
+                tp_timerqueue_insert( timer );
             }
         }
 
         timeout_lower = timeout_upper = MAXLONGLONG;
 
         /* Determine next timeout and use the window length to optimize wakeup times. */
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
+        WINE_RB_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
+                                struct threadpool_object, u.timer.timer_entry )
         {
             assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
             if (other_timer->u.timer.timeout >= timeout_upper)
@@ -1153,6 +1230,34 @@ static NTSTATUS tp_new_worker_thread( struct threadpool *pool )
     return status;
 }
 
+/***********************************************************************
+ *           tp_start_reserved_worker_thread    (internal)
+ *
+ * Starts a worker thread for which pool->num_workers has already been
+ * incremented. Must be called without holding pool->cs, thread creation
+ * is slow and would otherwise serialize all submitters.
+ */
+static NTSTATUS tp_start_reserved_worker_thread( struct threadpool *pool )
+{
+    HANDLE thread;
+    NTSTATUS status;
+
+    InterlockedIncrement( &pool->refcount );
+    status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                                  threadpool_worker_proc, pool, &thread, NULL );
+    if (status == STATUS_SUCCESS)
+    {
+        NtClose( thread );
+        return status;
+    }
+
+    RtlEnterCriticalSection( &pool->cs );
+    pool->num_workers--;
+    RtlLeaveCriticalSection( &pool->cs );
+    tp_threadpool_release( pool );
+    return status;
+}
+
 /***********************************************************************
  *           tp_timerqueue_lock    (internal)
  *
@@ -1210,15 +1315,12 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
     {
         /* If timer was pending, remove it. */
         if (timer->u.timer.timer_pending)
-        {
-            list_remove( &timer->u.timer.timer_entry );
-            timer->u.timer.timer_pending = FALSE;
-        }
+            tp_timerqueue_remove( timer );
 
         /* If the last timer object was destroyed, then wake up the thread. */
         if (!--timerqueue.objcount)
         {
-            assert( list_empty( &timerqueue.pending_timers ) );
+            assert( !timerqueue.pending_timers.root );
             RtlWakeAllConditionVariable( &timerqueue.update_event );
         }
 
@@ -1237,7 +1339,8 @@ static void CALLBACK waitqueue_thread_proc( void *param )
     struct waitqueue_bucket *bucket = param;
     struct threadpool_object *wait, *next;
     LARGE_INTEGER now, timeout;
-    DWORD num_handles;
+    DWORD num_handles = 0;
+    BOOL rebuild = TRUE;
     NTSTATUS status;
 
     TRACE( "starting wait queue thread\n" );
@@ -1246,9 +1349,23 @@ static void CALLBACK waitqueue_thread_proc( void *param )
 
     for (;;)
     {
+        /* The wait array only has to be rebuilt when the set of waiting objects
+         * changed, or when a timeout expired; an object which was signaled and
+         * is still waiting keeps its handle and absolute timeout. */
+        if (!rebuild && !bucket->changed && bucket->objcount)
+            goto do_wait;
+
+        /* Release temporary references to wait objects. */
+        while (num_handles)
+        {
+            wait = objects[--num_handles];
+            assert( wait->type == TP_OBJECT_TYPE_WAIT );
+            tp_object_release( wait );
+        }
+
+        bucket->changed = FALSE;
         NtQuerySystemTime( &now );
         timeout.QuadPart = MAXLONGLONG;
-        num_handles = 0;
 
         LIST_FOR_EACH_ENTRY_SAFE( wait, next, &bucket->waiting, struct threadpool_object,
                                   u.wait.wait_entry )
@@ -1286,6 +1403,8 @@ static void CALLBACK waitqueue_thread_proc( void *param )
             }
         }
 
+    do_wait:
+        rebuild = TRUE;
         if (!bucket->objcount)
         {
             /* All wait objects have been destroyed, if no new wait objects are created
@@ -1319,6 +1438,7 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                         list_remove( &wait->u.wait.wait_entry );
                         list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
                     }
+                    else rebuild = FALSE;
                     if ((wait->u.wait.flags & (WT_EXECUTEINWAITTHREAD | WT_EXECUTEINIOTHREAD)))
                     {
                         wait->u.wait.signaled++;
@@ -1332,14 +1452,6 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                 else
                     WARN("wait object %p triggered while object was destroyed\n", wait);
             }
-
-            /* Release temporary references to wait objects. */
-            while (num_handles)
-            {
-                wait = objects[--num_handles];
-                assert( wait->type == TP_OBJECT_TYPE_WAIT );
-                tp_object_release( wait );
-            }
         }
 
         /* Try to merge bucket with other threads. */
@@ -1376,7 +1488,7 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                     list_remove( &bucket->bucket_entry );
                     list_add_tail( &waitqueue.buckets, &bucket->bucket_entry );
 
-                    NtSetEvent( other_bucket->update_event, NULL );
+                    waitqueue_bucket_update( other_bucket );
                     break;
                 }
             }
@@ -1444,6 +1556,7 @@ static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
 
     bucket->objcount = 0;
     bucket->alertable = alertable;
+    bucket->changed = FALSE;
     list_init( &bucket->reserved );
     list_init( &bucket->waiting );
 
@@ -1496,7 +1609,7 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
         wait->u.wait.bucket = NULL;
         bucket->objcount--;
 
-        NtSetEvent( bucket->update_event, NULL );
+        waitqueue_bucket_update( bucket );
     }
     RtlLeaveCriticalSection( &waitqueue.cs );
 }
@@ -1970,17 +2083,21 @@ static void tp_object_prio_queue( struct threadpool_object *object )
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
-    NTSTATUS status = STATUS_UNSUCCESSFUL;
+    BOOL new_worker = FALSE;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
     RtlEnterCriticalSection( &pool->cs );
 
-    /* Start new worker threads if required. */
+    /* Reserve a new worker thread if required, it is started after leaving
+     * the critical section. */
     if (pool->num_busy_workers >= pool->num_workers &&
         pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    {
+        pool->num_workers++;
+        new_worker = TRUE;
+    }
 
     /* Queue work item and increment refcount. */
     InterlockedIncrement( &object->refcount );
@@ -1991,14 +2108,12 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
-    {
-        assert( pool->num_workers > 0 );
-        RtlWakeConditionVariable( &pool->update_event );
-    }
-
     RtlLeaveCriticalSection( &pool->cs );
+
+    /* No new thread started - wake up one existing thread. Waking outside of
+     * the critical section avoids the woken thread immediately blocking on it. */
+    if (!new_worker || tp_start_reserved_worker_thread( pool ) != STATUS_SUCCESS)
+        RtlWakeConditionVariable( &pool->update_event );
 }
 
 /***********************************************************************
@@ -2343,7 +2458,16 @@ static void CALLBACK threadpool_worker_proc( void *param )
             assert(pool->num_busy_workers);
             pool->num_busy_workers--;
 
-            tp_object_release( object );
+            /* Destroying the object takes the group lock and frees memory, don't
+             * block other workers and submitters while doing that. Nobody else can
+             * acquire a new reference when we hold the last one. */
+            if (object->refcount == 1)
+            {
+                RtlLeaveCriticalSection( &pool->cs );
+                tp_object_release( object );
+                RtlEnterCriticalSection( &pool->cs );
+            }
+            else tp_object_release( object );
         }
 
         /* Shutdown worker thread if requested. */
@@ -2956,7 +3080,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2994,10 +3117,7 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
 
     /* First remove existing timeout. */
     if (this->u.timer.timer_pending)
-    {
-        list_remove( &this->u.timer.timer_entry );
-        this->u.timer.timer_pending = FALSE;
-    }
+        tp_timerqueue_remove( this );
 
     /* If the timer was enabled, then add it back to the queue. */
     if (timeout)
@@ -3006,20 +3126,9 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
 
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
-
         /* Wake up the timer thread when the timeout has to be updated. */
-        if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
+        if (tp_timerqueue_insert( this ))
             RtlWakeAllConditionVariable( &timerqueue.update_event );
-
-        this->u.timer.timer_pending = TRUE;
     }
 
     RtlLeaveCriticalSection( &timerqueue.cs );
@@ -3074,7 +3183,7 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
         }
 
         /* Wake up the wait queue thread. */
-        NtSetEvent( bucket->update_event, NULL );
+        waitqueue_bucket_update( bucket );
     }
 
     RtlLeaveCriticalSection( &waitqueue.cs );
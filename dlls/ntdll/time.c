@@ -375,11 +375,148 @@ LONGLONG WINAPI RtlGetSystemTimePrecise( void )
     return unix_funcs->RtlGetSystemTimePrecise();
 }
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+/* With an invariant TSC, the performance counter is extrapolated from the TSC
+ * and only calibrated against NtQueryPerformanceCounter about once a second. */
+static struct
+{
+    volatile LONG seq;          /* sequence number, odd while being updated */
+    ULONGLONG     base_tsc;     /* TSC of the reference calibration point */
+    LONGLONG      base_counter; /* counter of the reference calibration point */
+    ULONGLONG     tsc;          /* TSC of the last calibration point */
+    LONGLONG      counter;      /* counter of the last calibration point */
+    ULONGLONG     mult;         /* counter ticks per TSC cycle, 32.32 fixed point */
+    ULONGLONG     max_delta;    /* TSC cycles after which to calibrate again */
+} qpc_tsc;
+
+static LONG qpc_tsc_state;  /* 1 if the TSC can be used, -1 if not, 0 if not checked yet */
+static LONG qpc_tsc_lock;
+
+static inline ULONGLONG read_tsc(void)
+{
+    unsigned int low, high;
+
+    __asm__ __volatile__( "lfence; rdtsc" : "=a" (low), "=d" (high) :: "memory" );
+    return ((ULONGLONG)high << 32) | low;
+}
+
+static BOOL qpc_tsc_supported(void)
+{
+    unsigned int regs[4];
+
+    /* lfence requires SSE2 */
+    if (!user_shared_data->ProcessorFeatures[PF_RDTSC_INSTRUCTION_AVAILABLE] ||
+        !user_shared_data->ProcessorFeatures[PF_XMMI64_INSTRUCTIONS_AVAILABLE])
+        return FALSE;
+
+    __asm__( "cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+             : "a" (0x80000000), "c" (0) );
+    if (regs[0] < 0x80000007) return FALSE;
+    __asm__( "cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+             : "a" (0x80000007), "c" (0) );
+    return (regs[3] >> 8) & 1;
+}
+
+/* record a new calibration point and return the counter value it is anchored to */
+static LONGLONG qpc_tsc_calibrate( ULONGLONG tsc, LONGLONG counter )
+{
+    ULONGLONG delta, mult;
+    LONGLONG predicted = counter;
+
+    if (InterlockedCompareExchange( &qpc_tsc_lock, 1, 0 )) return counter;
+
+    if (qpc_tsc.mult)
+    {
+        /* never go back behind values that were already extrapolated */
+        delta = min( tsc - qpc_tsc.tsc, qpc_tsc.max_delta );
+        predicted = max( counter, qpc_tsc.counter + (LONGLONG)(delta * qpc_tsc.mult >> 32) );
+    }
+
+    qpc_tsc.seq++;
+    __asm__ __volatile__( "" ::: "memory" );
+
+    /* the scale is computed from the actual counter values only */
+    if (!qpc_tsc.base_tsc || tsc <= qpc_tsc.base_tsc)
+    {
+        qpc_tsc.base_tsc = tsc;
+        qpc_tsc.base_counter = counter;
+    }
+    else if (counter - qpc_tsc.base_counter >= TICKSPERSEC / 10)
+    {
+        mult = ((ULONGLONG)(counter - qpc_tsc.base_counter) << 32) / (tsc - qpc_tsc.base_tsc);
+        if (mult)
+        {
+            qpc_tsc.mult = mult;
+            qpc_tsc.max_delta = ((ULONGLONG)TICKSPERSEC << 32) / mult;
+        }
+        /* keep the reference point recent enough for the computation not to overflow */
+        if (counter - qpc_tsc.base_counter >= 60 * (LONGLONG)TICKSPERSEC)
+        {
+            qpc_tsc.base_tsc = tsc;
+            qpc_tsc.base_counter = counter;
+        }
+    }
+    qpc_tsc.tsc = tsc;
+    qpc_tsc.counter = predicted;
+
+    __asm__ __volatile__( "" ::: "memory" );
+    qpc_tsc.seq++;
+
+    InterlockedExchange( &qpc_tsc_lock, 0 );
+    return predicted;
+}
+
+static BOOL qpc_tsc_query( LARGE_INTEGER *counter )
+{
+    ULONGLONG tsc, end, delta;
+    LARGE_INTEGER now;
+    LONG seq;
+    BOOL valid;
+
+    if (qpc_tsc_state <= 0)
+    {
+        if (qpc_tsc_state < 0) return FALSE;
+        qpc_tsc_state = qpc_tsc_supported() ? 1 : -1;
+        if (qpc_tsc_state < 0) return FALSE;
+    }
+
+    do
+    {
+        seq = qpc_tsc.seq;
+        __asm__ __volatile__( "" ::: "memory" );
+        tsc = read_tsc();
+        delta = tsc - qpc_tsc.tsc;
+        valid = qpc_tsc.mult && delta <= qpc_tsc.max_delta;
+        if (valid) counter->QuadPart = qpc_tsc.counter + (delta * qpc_tsc.mult >> 32);
+        __asm__ __volatile__( "" ::: "memory" );
+    } while ((seq & 1) || seq != qpc_tsc.seq);
+
+    if (valid) return TRUE;
+
+    tsc = read_tsc();
+    NtQueryPerformanceCounter( &now, NULL );
+    end = read_tsc();
+    /* don't calibrate from a sample where the thread got preempted */
+    if (qpc_tsc.mult && end - tsc > qpc_tsc.max_delta / 10000)
+    {
+        *counter = now;
+        return TRUE;
+    }
+    counter->QuadPart = qpc_tsc_calibrate( tsc + (end - tsc) / 2, now.QuadPart );
+    return TRUE;
+}
+
+#endif
+
 /******************************************************************************
  *  RtlQueryPerformanceCounter   [NTDLL.@]
  */
 BOOL WINAPI DECLSPEC_HOTPATCH RtlQueryPerformanceCounter( LARGE_INTEGER *counter )
 {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    if (qpc_tsc_query( counter )) return TRUE;
+#endif
     NtQueryPerformanceCounter( counter, NULL );
     return TRUE;
 }
@@ -26,6 +26,7 @@
 #include "wine/port.h"
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,11 +39,24 @@
 #include "winnt.h"
 #include "winternl.h"
 #include "unix_private.h"
+#include "wine/list.h"
 #include "wine/debug.h"
 
 WINE_DECLARE_DEBUG_CHANNEL(pid);
 WINE_DECLARE_DEBUG_CHANNEL(timestamp);
 WINE_DECLARE_DEBUG_CHANNEL(microsecs);
+WINE_DECLARE_DEBUG_CHANNEL(buffered);
+
+/* with +buffered, complete lines are collected per thread and written in large chunks */
+struct debug_buffer
+{
+    struct list  entry;       /* entry in the list of buffers */
+    unsigned int pos;         /* current position in data */
+    char         data[65536];
+};
+
+static struct list debug_buffers = LIST_INIT( debug_buffers );
+static pthread_mutex_t debug_buffers_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static BOOL init_done;
 static struct debug_info initial_info;  /* debug info for initial thread */
@@ -74,6 +88,37 @@ static int append_output( struct debug_info *info, const char *str, size_t len )
     return len;
 }
 
+/* write out the lines collected in a debug buffer */
+static void flush_buffer( struct debug_buffer *buffer )
+{
+    if (buffer->pos) write( 2, buffer->data, buffer->pos );
+    buffer->pos = 0;
+}
+
+/* write a complete output line, or collect it in the thread buffer */
+static void write_output( struct debug_info *info )
+{
+    struct debug_buffer *buffer = info->buffer;
+
+    if (!buffer && init_done && TRACE_ON(buffered) && (buffer = malloc( sizeof(*buffer) )))
+    {
+        buffer->pos = 0;
+        mutex_lock( &debug_buffers_mutex );
+        list_add_tail( &debug_buffers, &buffer->entry );
+        mutex_unlock( &debug_buffers_mutex );
+        info->buffer = buffer;
+    }
+
+    if (!buffer)
+    {
+        write( 2, info->output, info->out_pos );
+        return;
+    }
+    if (info->out_pos > sizeof(buffer->data) - buffer->pos) flush_buffer( buffer );
+    memcpy( buffer->data + buffer->pos, info->output, info->out_pos );
+    buffer->pos += info->out_pos;
+}
+
 /* add a new debug option at the end of the option list */
 static void add_option( const char *name, unsigned char set, unsigned char clear )
 {
@@ -248,7 +293,7 @@ int __cdecl __wine_dbg_output( const char *str )
     if (end)
     {
         ret += append_output( info, str, end + 1 - str );
-        write( 2, info->output, info->out_pos );
+        write_output( info );
         info->out_pos = 0;
         str = end + 1;
     }
@@ -306,6 +351,40 @@ void dbg_init(void)
     init_done = TRUE;
 }
 
+/***********************************************************************
+ *		dbg_flush_thread
+ *
+ * Write out the buffered output of the current thread when it exits.
+ */
+void dbg_flush_thread(void)
+{
+    struct debug_info *info = get_info();
+    struct debug_buffer *buffer = info->buffer;
+
+    if (!buffer) return;
+    info->buffer = NULL;
+    flush_buffer( buffer );
+    mutex_lock( &debug_buffers_mutex );
+    list_remove( &buffer->entry );
+    mutex_unlock( &debug_buffers_mutex );
+    free( buffer );
+}
+
+/***********************************************************************
+ *		dbg_flush_process
+ *
+ * Write out the buffered output of all threads when the process exits.
+ */
+void dbg_flush_process(void)
+{
+    struct debug_buffer *buffer;
+
+    mutex_lock( &debug_buffers_mutex );
+    LIST_FOR_EACH_ENTRY( buffer, &debug_buffers, struct debug_buffer, entry )
+        flush_buffer( buffer );
+    mutex_unlock( &debug_buffers_mutex );
+}
+
 void CDECL write_crash_log(const char *log_type, const char *log_msg)
 {
     const char *dir = getenv("WINE_CRASH_REPORT_DIR");
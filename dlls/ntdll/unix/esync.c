@@ -1264,13 +1264,18 @@ static void server_set_msgwait( int in_msgwait )
 NTSTATUS esync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
                              BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
+    static BOOL msgwait_reported;
     BOOL msgwait = FALSE;
     struct esync *obj;
     NTSTATUS ret;
 
-    if (count && !get_object( handles[count - 1], &obj ) && obj->type == ESYNC_QUEUE)
+    /* A wait which can't block only needs to be reported to the server once,
+     * so that the process idle event gets set. */
+    if (count && (!timeout || timeout->QuadPart || !msgwait_reported) &&
+        !get_object( handles[count - 1], &obj ) && obj->type == ESYNC_QUEUE)
     {
         msgwait = TRUE;
+        msgwait_reported = TRUE;
         server_set_msgwait( 1 );
     }
 
@@ -109,6 +109,9 @@
 #ifdef HAVE_SYS_STATFS_H
 #include <sys/statfs.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 #include <time.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
@@ -177,6 +180,16 @@ typedef struct
 #define AT_NO_AUTOMOUNT 0x800
 #endif
 
+/* Define the btrfs/xfs ioctl for sharing extents between files */
+struct file_clone_range_args
+{
+    LONGLONG  src_fd;
+    ULONGLONG src_offset;
+    ULONGLONG src_length;
+    ULONGLONG dest_offset;
+};
+#define WINE_FICLONERANGE _IOW(0x94, 13, struct file_clone_range_args)
+
 #endif  /* linux */
 
 #define IS_SEPARATOR(ch)   ((ch) == '\\' || (ch) == '/')
@@ -229,9 +242,20 @@ struct dir_data
     unsigned int            size;    /* size of the names array */
     unsigned int            count;   /* count of used entries in the names array */
     unsigned int            pos;     /* current reading position in the names array */
+    unsigned int            refcount; /* references to a shared listing, 0 if not shared */
     struct file_identity    id;      /* directory file identity */
     struct dir_data_names  *names;   /* directory file names */
     struct dir_data_buffer *buffer;  /* head of data buffers list */
+    struct dir_data        *shared;  /* shared listing the names belong to */
+};
+
+/* process-wide cache of full directory listings, validated against the directory times */
+struct dir_listing
+{
+    struct list             entry;   /* entry in the listing cache */
+    LARGE_INTEGER           mtime;   /* directory modification time */
+    LARGE_INTEGER           ctime;   /* directory change time */
+    struct dir_data        *data;    /* shared listing */
 };
 
 static const unsigned int dir_data_buffer_initial_size = 4096;
@@ -241,6 +265,11 @@ static const unsigned int dir_data_names_initial_size  = 64;
 static struct dir_data **dir_data_cache;
 static unsigned int dir_data_cache_size;
 
+static const unsigned int dir_listing_cache_max_size = 64;
+
+static struct list dir_listing_cache = LIST_INIT( dir_listing_cache );
+static unsigned int dir_listing_cache_size;
+
 static BOOL show_dot_files;
 static mode_t start_umask;
 
@@ -336,6 +365,12 @@ static inline BOOL has_wildcard( const UNICODE_STRING *mask )
     return FALSE;
 }
 
+/* check whether the mask selects every entry, so that the listing can be shared */
+static inline BOOL is_full_listing_mask( const UNICODE_STRING *mask )
+{
+    return !mask || (mask->Length == sizeof(WCHAR) && mask->Buffer[0] == '*');
+}
+
 NTSTATUS errno_to_status( int err )
 {
     TRACE( "errno = %d\n", err );
@@ -458,7 +493,8 @@ static BOOL add_dir_data_names( struct dir_data *data, const WCHAR *long_name,
         data->names = names;
     }
 
-    if (short_name[0])
+    if (!short_name) names[data->count].short_name = NULL;  /* generated on demand */
+    else if (short_name[0])
     {
         if (!(names[data->count].short_name = add_dir_data_nameW( data, short_name ))) return FALSE;
     }
@@ -477,6 +513,14 @@ static void free_dir_data( struct dir_data *data )
 
     if (!data) return;
 
+    if (data->shared)
+    {
+        free_dir_data( data->shared );
+        free( data );
+        return;
+    }
+    if (data->refcount && --data->refcount) return;
+
     for (buffer = data->buffer; buffer; buffer = next)
     {
         next = buffer->next;
@@ -1462,6 +1506,13 @@ static BOOL append_entry( struct dir_data *data, const char *long_name,
     if (long_len == ARRAY_SIZE(long_nameW)) return TRUE;
     long_nameW[long_len] = 0;
 
+    if (!short_name && is_full_listing_mask( mask ))
+    {
+        /* the short name isn't needed for matching, only hash it if a query returns it */
+        TRACE( "long %s mask %s\n", debugstr_w( long_nameW ), debugstr_us( mask ));
+        return add_dir_data_names( data, long_nameW, NULL, long_name );
+    }
+
     if (short_name)
     {
         short_len = ntdll_umbstowcs( short_name, strlen(short_name),
@@ -1531,21 +1582,72 @@ static int fd_get_file_info( int fd, unsigned int options, struct stat *st, ULON
 }
 
 
-/* get the stat info and file attributes for a file (by name) */
-static int get_file_info( const char *path, struct stat *st, ULONG *attr )
+#ifdef HAVE_STATX
+/* statx fields needed to fill the directory information classes */
+static const unsigned int dir_entry_statx_mask = STATX_TYPE | STATX_MODE | STATX_INO | STATX_SIZE |
+                                                 STATX_BLOCKS | STATX_ATIME | STATX_MTIME | STATX_CTIME;
+static BOOL statx_supported = TRUE;
+#endif
+
+/* stat a file, only fetching the requested statx fields if possible; a zero mask means all fields */
+static int stat_file( const char *path, struct stat *st, BOOL follow, unsigned int mask )
+{
+#ifdef HAVE_STATX
+    if (mask && statx_supported)
+    {
+        struct statx stx;
+
+        /* cached attributes are good enough, don't force a round trip on network filesystems */
+        if (!statx( AT_FDCWD, path, (follow ? 0 : AT_SYMLINK_NOFOLLOW) | AT_STATX_DONT_SYNC, mask, &stx ))
+        {
+            memset( st, 0, sizeof(*st) );
+            st->st_dev     = makedev( stx.stx_dev_major, stx.stx_dev_minor );
+            st->st_ino     = stx.stx_ino;
+            st->st_mode    = stx.stx_mode;
+            st->st_nlink   = stx.stx_nlink;
+            st->st_uid     = stx.stx_uid;
+            st->st_gid     = stx.stx_gid;
+            st->st_rdev    = makedev( stx.stx_rdev_major, stx.stx_rdev_minor );
+            st->st_size    = stx.stx_size;
+            st->st_blksize = stx.stx_blksize;
+            st->st_blocks  = stx.stx_blocks;
+            st->st_atime   = stx.stx_atime.tv_sec;
+            st->st_mtime   = stx.stx_mtime.tv_sec;
+            st->st_ctime   = stx.stx_ctime.tv_sec;
+#ifdef HAVE_STRUCT_STAT_ST_ATIM
+            st->st_atim.tv_nsec = stx.stx_atime.tv_nsec;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+            st->st_mtim.tv_nsec = stx.stx_mtime.tv_nsec;
+#endif
+#ifdef HAVE_STRUCT_STAT_ST_CTIM
+            st->st_ctim.tv_nsec = stx.stx_ctime.tv_nsec;
+#endif
+            return 0;
+        }
+        if (errno != ENOSYS) return -1;
+        statx_supported = FALSE;
+    }
+#endif
+    return follow ? stat( path, st ) : lstat( path, st );
+}
+
+
+/* get the stat info and file attributes for a file (by name), fetching only the given statx fields */
+static int get_file_info_mask( const char *path, struct stat *st, ULONG *attr, unsigned int mask )
 {
     char *parent_path;
     int ret;
 
     *attr = 0;
-    ret = lstat( path, st );
+    ret = stat_file( path, st, FALSE, mask );
     if (ret == -1) return ret;
     if (S_ISLNK( st->st_mode ))
     {
         BOOL is_dir;
 
         /* return information about the destination (unless this is a dangling symlink) */
-        stat( path, st );
+        stat_file( path, st, TRUE, mask );
         /* symbolic links always report size 0 */
         st->st_size = 0;
         /* symbolic links (either junction points or NT symlinks) are "reparse points" */
@@ -1561,7 +1663,7 @@ static int get_file_info( const char *path, struct stat *st, ULONG *attr )
         /* consider mount points to be reparse points (IO_REPARSE_TAG_MOUNT_POINT) */
         strcpy( parent_path, path );
         strcat( parent_path, "/.." );
-        if (!stat( parent_path, &parent_st )
+        if (!stat_file( parent_path, &parent_st, TRUE, mask ? STATX_INO : 0 )
                 && (st->st_dev != parent_st.st_dev || st->st_ino == parent_st.st_ino))
             *attr |= FILE_ATTRIBUTE_REPARSE_POINT;
 
@@ -1572,6 +1674,13 @@ static int get_file_info( const char *path, struct stat *st, ULONG *attr )
 }
 
 
+/* get the stat info and file attributes for a file (by name) */
+static int get_file_info( const char *path, struct stat *st, ULONG *attr )
+{
+    return get_file_info_mask( path, st, attr, 0 );
+}
+
+
 #if defined(__ANDROID__) && !defined(HAVE_UTIMENSAT)
 static int utimensat( int fd, const char *name, const struct timespec spec[2], int flags )
 {
@@ -2046,6 +2155,36 @@ static NTSTATUS get_mountmgr_fs_info( HANDLE handle, int fd, struct mountmgr_uni
 }
 
 
+/* get the statx fields needed for a directory information class */
+static unsigned int get_dir_entry_statx_mask( FILE_INFORMATION_CLASS class )
+{
+#ifdef HAVE_STATX
+    if (class == FileNamesInformation) return STATX_TYPE | STATX_MODE | STATX_INO;
+    return dir_entry_statx_mask;
+#else
+    return 0;
+#endif
+}
+
+
+/* get the short name of a directory entry, generating and remembering it if necessary */
+static const WCHAR *get_dir_data_short_name( struct dir_data *data, struct dir_data_names *names )
+{
+    static const WCHAR empty[1];
+    int len = wcslen( names->long_name );
+    WCHAR short_nameW[13];
+
+    if (names->short_name) return names->short_name;
+    if (is_legal_8dot3_name( names->long_name, len )) return names->short_name = empty;
+
+    len = hash_short_file_name( names->long_name, len, short_nameW );
+    short_nameW[len] = 0;
+    wcsupr( short_nameW );
+    /* the names of a shared listing live in its own buffers */
+    return names->short_name = add_dir_data_nameW( data->shared ? data->shared : data, short_nameW );
+}
+
+
 /***********************************************************************
  *           get_dir_data_entry
  *
@@ -2055,12 +2194,13 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
                                     ULONG max_length, FILE_INFORMATION_CLASS class,
                                     union file_directory_info **last_info )
 {
-    const struct dir_data_names *names = &dir_data->names[dir_data->pos];
+    struct dir_data_names *names = &dir_data->names[dir_data->pos];
+    const WCHAR *short_name = NULL;
     union file_directory_info *info;
     struct stat st;
     ULONG name_len, start, dir_size, attributes;
 
-    if (get_file_info( names->unix_name, &st, &attributes ) == -1)
+    if (get_file_info_mask( names->unix_name, &st, &attributes, get_dir_entry_statx_mask( class ) ) == -1)
     {
         TRACE( "file no longer exists %s\n", names->unix_name );
         return STATUS_SUCCESS;
@@ -2079,6 +2219,10 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
     /* if this is not the first entry, fail; the first entry is always returned (but truncated) */
     if (*last_info && name_len > max_length) return STATUS_MORE_ENTRIES;
 
+    if ((class == FileBothDirectoryInformation || class == FileIdBothDirectoryInformation) &&
+        !(short_name = get_dir_data_short_name( dir_data, names )))
+        return STATUS_NO_MEMORY;
+
     info = (union file_directory_info *)((char *)info_ptr + start);
     info->dir.NextEntryOffset = 0;
     info->dir.FileIndex = 0;  /* NTFS always has 0 here, so let's not bother with it */
@@ -2113,15 +2257,15 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
 
     case FileBothDirectoryInformation:
         info->both.EaSize = 0; /* FIXME */
-        info->both.ShortNameLength = wcslen( names->short_name ) * sizeof(WCHAR);
-        memcpy( info->both.ShortName, names->short_name, info->both.ShortNameLength );
+        info->both.ShortNameLength = wcslen( short_name ) * sizeof(WCHAR);
+        memcpy( info->both.ShortName, short_name, info->both.ShortNameLength );
         info->both.FileNameLength = name_len;
         break;
 
     case FileIdBothDirectoryInformation:
         info->id_both.EaSize = 0; /* FIXME */
-        info->id_both.ShortNameLength = wcslen( names->short_name ) * sizeof(WCHAR);
-        memcpy( info->id_both.ShortName, names->short_name, info->id_both.ShortNameLength );
+        info->id_both.ShortNameLength = wcslen( short_name ) * sizeof(WCHAR);
+        memcpy( info->id_both.ShortName, short_name, info->id_both.ShortNameLength );
         info->id_both.FileNameLength = name_len;
         break;
 
@@ -2339,6 +2483,84 @@ static int name_compare( const void *a, const void *b )
 }
 
 
+/***********************************************************************
+ *           get_dir_listing
+ *
+ * Find a cached listing for the directory and return a new handle-private reference to it.
+ * Must be called with dir_mutex held.
+ */
+static struct dir_data *get_dir_listing( const struct stat *st )
+{
+    struct dir_listing *listing;
+    struct dir_data *data;
+    LARGE_INTEGER mtime, ctime, atime, creation;
+
+    get_file_times( st, &mtime, &ctime, &atime, &creation );
+
+    LIST_FOR_EACH_ENTRY( listing, &dir_listing_cache, struct dir_listing, entry )
+    {
+        if (listing->data->id.dev != st->st_dev || listing->data->id.ino != st->st_ino) continue;
+
+        if (listing->mtime.QuadPart != mtime.QuadPart || listing->ctime.QuadPart != ctime.QuadPart)
+        {
+            /* the directory changed, drop the stale listing */
+            list_remove( &listing->entry );
+            dir_listing_cache_size--;
+            free_dir_data( listing->data );
+            free( listing );
+            return NULL;
+        }
+
+        if (!(data = calloc( 1, sizeof(*data) ))) return NULL;
+        data->count  = listing->data->count;
+        data->id     = listing->data->id;
+        data->names  = listing->data->names;
+        data->shared = listing->data;
+        listing->data->refcount++;
+
+        list_remove( &listing->entry );
+        list_add_head( &dir_listing_cache, &listing->entry );
+        return data;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           add_dir_listing
+ *
+ * Add a freshly read full listing to the process-wide cache.
+ * Must be called with dir_mutex held.
+ */
+static void add_dir_listing( struct dir_data *data, const struct stat *st )
+{
+    struct dir_listing *listing;
+    LARGE_INTEGER atime, creation;
+    time_t now = time( NULL );
+
+    /* a change within the timestamp granularity could go unnoticed, so only
+     * cache directories that have been left alone for a little while */
+    if (st->st_mtime >= now - 1 || st->st_ctime >= now - 1) return;
+
+    if (!(listing = malloc( sizeof(*listing) ))) return;
+    get_file_times( st, &listing->mtime, &listing->ctime, &atime, &creation );
+    listing->data = data;
+    data->refcount = 2;  /* one for the cache, one for the caller */
+    list_add_head( &dir_listing_cache, &listing->entry );
+
+    if (++dir_listing_cache_size > dir_listing_cache_max_size)
+    {
+        struct list *ptr = list_tail( &dir_listing_cache );
+
+        listing = LIST_ENTRY( ptr, struct dir_listing, entry );
+        list_remove( &listing->entry );
+        dir_listing_cache_size--;
+        free_dir_data( listing->data );
+        free( listing );
+    }
+}
+
+
 /***********************************************************************
  *           init_cached_dir_data
  *
@@ -2350,6 +2572,14 @@ static NTSTATUS init_cached_dir_data( struct dir_data **data_ret, int fd, const
     struct stat st;
     NTSTATUS status;
     unsigned int i;
+    BOOL shareable = is_full_listing_mask( mask ) && !fstat( fd, &st );
+
+    if (shareable && (data = get_dir_listing( &st )))
+    {
+        TRACE( "mask %s reusing %u cached files\n", debugstr_us( mask ), data->count );
+        *data_ret = data;
+        return STATUS_SUCCESS;
+    }
 
     if (!(data = calloc( 1, sizeof(*data) ))) return STATUS_NO_MEMORY;
 
@@ -2367,7 +2597,7 @@ static NTSTATUS init_cached_dir_data( struct dir_data **data_ret, int fd, const
 
     if (data->count)
     {
-        fstat( fd, &st );
+        if (!shareable) fstat( fd, &st );
         data->id.dev = st.st_dev;
         data->id.ino = st.st_ino;
     }
@@ -2376,6 +2606,8 @@ static NTSTATUS init_cached_dir_data( struct dir_data **data_ret, int fd, const
     for (i = 0; i < data->count; i++)
         TRACE( "%s %s\n", debugstr_w(data->names[i].long_name), debugstr_w(data->names[i].short_name) );
 
+    if (data->count && shareable) add_dir_listing( data, &st );
+
     *data_ret = data;
     return data->count ? STATUS_SUCCESS : STATUS_NO_SUCH_FILE;
 }
@@ -2530,6 +2762,250 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event, PIO_APC_ROUTI
 }
 
 
+/* case-insensitive name index of a directory, used when a lookup misses on exact case */
+struct dir_index_entry
+{
+    unsigned int hash;               /* hash of the upper-cased name */
+    unsigned int next;               /* next entry in the hash chain */
+    unsigned int name;               /* offset of the Unix file name in the names buffer */
+    BOOL         is_short;           /* entry is a generated short name */
+};
+
+struct dir_index
+{
+    struct list             entry;   /* entry in the index cache */
+    struct file_identity    id;      /* directory file identity */
+    LARGE_INTEGER           mtime;   /* directory modification time */
+    LARGE_INTEGER           ctime;   /* directory change time */
+    unsigned int            count;   /* count of used entries */
+    unsigned int            size;    /* size of the entries array */
+    unsigned int            hash_size; /* number of hash buckets, a power of two */
+    unsigned int           *buckets; /* first entry of each hash chain */
+    struct dir_index_entry *entries; /* index entries, in readdir order */
+    char                   *names;   /* Unix file names */
+    unsigned int            names_len; /* used size of the names buffer */
+    unsigned int            names_size; /* allocated size of the names buffer */
+};
+
+static const unsigned int dir_index_cache_max_size = 64;
+static const unsigned int dir_index_end = ~0u;
+
+static pthread_mutex_t dir_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct list dir_index_cache = LIST_INIT( dir_index_cache );
+static unsigned int dir_index_cache_size;
+
+static unsigned int hash_dir_index_name( const WCHAR *name, int length )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < length; i++) hash = hash * 31 + towupper( name[i] );
+    return hash;
+}
+
+static void free_dir_index( struct dir_index *index )
+{
+    free( index->buckets );
+    free( index->entries );
+    free( index->names );
+    free( index );
+}
+
+static BOOL add_dir_index_entry( struct dir_index *index, unsigned int hash, unsigned int name, BOOL is_short )
+{
+    if (index->count == index->size)
+    {
+        unsigned int size = max( 64, index->size * 2 );
+        struct dir_index_entry *new_entries = realloc( index->entries, size * sizeof(*new_entries) );
+
+        if (!new_entries) return FALSE;
+        index->entries = new_entries;
+        index->size = size;
+    }
+    index->entries[index->count].hash = hash;
+    index->entries[index->count].name = name;
+    index->entries[index->count].is_short = is_short;
+    index->count++;
+    return TRUE;
+}
+
+static BOOL add_dir_index_name( struct dir_index *index, const char *name, unsigned int *offset )
+{
+    unsigned int len = strlen( name ) + 1;
+
+    if (index->names_len + len > index->names_size)
+    {
+        unsigned int size = max( 4096, max( index->names_size * 2, index->names_len + len ) );
+        char *new_names = realloc( index->names, size );
+
+        if (!new_names) return FALSE;
+        index->names = new_names;
+        index->names_size = size;
+    }
+    memcpy( index->names + index->names_len, name, len );
+    *offset = index->names_len;
+    index->names_len += len;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           build_dir_index
+ *
+ * Read a directory and index its long and generated short names case-insensitively.
+ */
+static NTSTATUS build_dir_index( const char *dir_name, const struct stat *st, struct dir_index **ret )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN], short_nameW[12];
+    LARGE_INTEGER atime, creation;
+    struct dir_index *index;
+    struct dirent *de;
+    unsigned int i, name, bucket;
+    int len;
+    DIR *dir;
+
+    if (!(dir = opendir( dir_name ))) return errno_to_status( errno );
+    if (!(index = calloc( 1, sizeof(*index) ))) goto failed;
+
+    while ((de = readdir( dir )))
+    {
+        if (!add_dir_index_name( index, de->d_name, &name )) goto failed;
+        len = ntdll_umbstowcs( de->d_name, strlen(de->d_name), buffer, MAX_DIR_ENTRY_LEN );
+        if (!add_dir_index_entry( index, hash_dir_index_name( buffer, len ), name, FALSE )) goto failed;
+        if (is_legal_8dot3_name( buffer, len )) continue;
+        len = hash_short_file_name( buffer, len, short_nameW );
+        if (!add_dir_index_entry( index, hash_dir_index_name( short_nameW, len ), name, TRUE )) goto failed;
+    }
+    closedir( dir );
+
+    index->hash_size = 16;
+    while (index->hash_size < index->count) index->hash_size *= 2;
+    if (!(index->buckets = malloc( index->hash_size * sizeof(*index->buckets) )))
+    {
+        free_dir_index( index );
+        return STATUS_NO_MEMORY;
+    }
+    for (i = 0; i < index->hash_size; i++) index->buckets[i] = dir_index_end;
+    /* insert backwards so that the chains are walked in readdir order */
+    for (i = index->count; i > 0; i--)
+    {
+        bucket = index->entries[i - 1].hash & (index->hash_size - 1);
+        index->entries[i - 1].next = index->buckets[bucket];
+        index->buckets[bucket] = i - 1;
+    }
+
+    index->id.dev = st->st_dev;
+    index->id.ino = st->st_ino;
+    get_file_times( st, &index->mtime, &index->ctime, &atime, &creation );
+    *ret = index;
+    return STATUS_SUCCESS;
+
+failed:
+    closedir( dir );
+    if (index) free_dir_index( index );
+    return STATUS_NO_MEMORY;
+}
+
+
+/***********************************************************************
+ *           lookup_dir_index
+ *
+ * Find a name in the index; short names are only considered if requested.
+ */
+static const char *lookup_dir_index( const struct dir_index *index, const WCHAR *name, int length,
+                                     BOOLEAN check_short )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN], short_nameW[12];
+    unsigned int hash = hash_dir_index_name( name, length );
+    unsigned int i;
+    int len;
+
+    for (i = index->buckets[hash & (index->hash_size - 1)]; i != dir_index_end; i = index->entries[i].next)
+    {
+        const struct dir_index_entry *entry = &index->entries[i];
+        const char *unix_name = index->names + entry->name;
+
+        if (entry->hash != hash) continue;
+        if (entry->is_short && !check_short) continue;
+        len = ntdll_umbstowcs( unix_name, strlen(unix_name), buffer, MAX_DIR_ENTRY_LEN );
+        if (entry->is_short)
+        {
+            len = hash_short_file_name( buffer, len, short_nameW );
+            if (len == length && !wcsnicmp( short_nameW, name, len )) return unix_name;
+        }
+        else if (len == length && !wcsnicmp( buffer, name, len )) return unix_name;
+    }
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           find_file_in_dir_index
+ *
+ * Case-insensitive search of a directory through the cached name index.
+ * unix_name contains the directory name; the file found is appended at pos.
+ */
+static NTSTATUS find_file_in_dir_index( char *unix_name, int pos, const WCHAR *name, int length,
+                                        BOOLEAN check_short )
+{
+    struct dir_index *index, *found = NULL;
+    LARGE_INTEGER mtime, ctime, atime, creation;
+    const char *file;
+    struct stat st;
+    time_t now;
+    NTSTATUS status;
+
+    if (stat( unix_name, &st ) == -1) return errno_to_status( errno );
+    get_file_times( &st, &mtime, &ctime, &atime, &creation );
+
+    mutex_lock( &dir_index_mutex );
+
+    LIST_FOR_EACH_ENTRY( index, &dir_index_cache, struct dir_index, entry )
+    {
+        if (index->id.dev != st.st_dev || index->id.ino != st.st_ino) continue;
+        list_remove( &index->entry );
+        dir_index_cache_size--;
+        if (index->mtime.QuadPart == mtime.QuadPart && index->ctime.QuadPart == ctime.QuadPart)
+            found = index;
+        else
+            free_dir_index( index );  /* the directory changed */
+        break;
+    }
+
+    if (!found && (status = build_dir_index( unix_name, &st, &found )))
+    {
+        mutex_unlock( &dir_index_mutex );
+        return status;
+    }
+
+    if ((file = lookup_dir_index( found, name, length, check_short )))
+    {
+        unix_name[pos - 1] = '/';
+        strcpy( unix_name + pos, file );
+        status = STATUS_SUCCESS;
+    }
+    else status = STATUS_OBJECT_PATH_NOT_FOUND;
+
+    /* a change within the timestamp granularity could go unnoticed, so only
+     * keep indexes of directories that have been left alone for a little while */
+    now = time( NULL );
+    if (st.st_mtime >= now - 1 || st.st_ctime >= now - 1) free_dir_index( found );
+    else
+    {
+        list_add_head( &dir_index_cache, &found->entry );
+        if (++dir_index_cache_size > dir_index_cache_max_size)
+        {
+            index = LIST_ENTRY( list_tail( &dir_index_cache ), struct dir_index, entry );
+            list_remove( &index->entry );
+            dir_index_cache_size--;
+            free_dir_index( index );
+        }
+    }
+
+    mutex_unlock( &dir_index_mutex );
+    return status;
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2545,6 +3021,7 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     DIR *dir;
     struct dirent *de;
     struct stat st;
+    NTSTATUS status;
     int ret;
 
     /* try a shortcut for this directory */
@@ -2624,6 +3101,14 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    if ((status = find_file_in_dir_index( unix_name, pos, name, length, is_name_8_dot_3 )) != STATUS_NO_MEMORY)
+    {
+        if (status == STATUS_OBJECT_PATH_NOT_FOUND) goto not_found;
+        if (status) return status;
+        goto success;
+    }
+
+    /* fall back to a plain scan if the index could not be built */
     if (!(dir = opendir( unix_name ))) return errno_to_status( errno );
 
     unix_name[pos - 1] = '/';
@@ -5686,6 +6171,24 @@ err:
 }
 
 
+#if defined(HAVE_PREADV) || defined(HAVE_PWRITEV)
+/* fill an iovec array from page sized segments, starting at offset pos in the first one */
+static int get_segments_iovec( struct iovec *iov, int max, const FILE_SEGMENT_ELEMENT *segments,
+                               ULONG pos, ULONG length )
+{
+    int count;
+
+    for (count = 0; count < max && length; count++, pos = 0)
+    {
+        iov[count].iov_base = (char *)segments[count].Buffer + pos;
+        iov[count].iov_len = min( length, page_size - pos );
+        length -= iov[count].iov_len;
+    }
+    return count;
+}
+#endif
+
+
 /******************************************************************************
  *              NtReadFileScatter   (NTDLL.@)
  */
@@ -5700,6 +6203,9 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE;
+#ifdef HAVE_PREADV
+    struct iovec iov[256];
+#endif
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p),partial stub!\n",
            file, event, apc, apc_user, io, segments, length, offset, key );
@@ -5719,11 +6225,20 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
 
     while (length)
     {
+#ifdef HAVE_PREADV
+        int count = get_segments_iovec( iov, ARRAY_SIZE(iov), segments, pos, length );
+
+        if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
+            result = preadv( unix_handle, iov, count, offset->QuadPart + total );
+        else
+            result = readv( unix_handle, iov, count );
+#else
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
             result = pread( unix_handle, (char *)segments->Buffer + pos,
-                            min( length - pos, page_size - pos ), offset->QuadPart + total );
+                            min( length, page_size - pos ), offset->QuadPart + total );
         else
-            result = read( unix_handle, (char *)segments->Buffer + pos, min( length - pos, page_size - pos ) );
+            result = read( unix_handle, (char *)segments->Buffer + pos, min( length, page_size - pos ) );
+#endif
 
         if (result == -1)
         {
@@ -5734,11 +6249,8 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         if (!result) break;
         total += result;
         length -= result;
-        if ((pos += result) == page_size)
-        {
-            pos = 0;
-            segments++;
-        }
+        segments += (pos + result) / page_size;
+        pos = (pos + result) % page_size;
     }
 
     if (total == 0) status = STATUS_END_OF_FILE;
@@ -6002,6 +6514,9 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
     enum server_fd_type type;
     ULONG_PTR cvalue = apc ? 0 : (ULONG_PTR)apc_user;
     BOOL send_completion = FALSE;
+#ifdef HAVE_PWRITEV
+    struct iovec iov[256];
+#endif
 
     TRACE( "(%p,%p,%p,%p,%p,%p,0x%08x,%p,%p),partial stub!\n",
            file, event, apc, apc_user, io, segments, length, offset, key );
@@ -6022,11 +6537,20 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
 
     while (length)
     {
+#ifdef HAVE_PWRITEV
+        int count = get_segments_iovec( iov, ARRAY_SIZE(iov), segments, pos, length );
+
+        if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
+            result = pwritev( unix_handle, iov, count, offset->QuadPart + total );
+        else
+            result = writev( unix_handle, iov, count );
+#else
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
             result = pwrite( unix_handle, (char *)segments->Buffer + pos,
                              page_size - pos, offset->QuadPart + total );
         else
             result = write( unix_handle, (char *)segments->Buffer + pos, page_size - pos );
+#endif
 
         if (result == -1)
         {
@@ -6046,11 +6570,8 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         }
         total += result;
         length -= result;
-        if ((pos += result) == page_size)
-        {
-            pos = 0;
-            segments++;
-        }
+        segments += (pos + result) / page_size;
+        pos = (pos + result) % page_size;
     }
 
     send_completion = cvalue != 0;
@@ -6651,6 +7172,78 @@ cleanup:
 }
 
 
+/* copy a range of bytes between two files without going through user space,
+ * sharing the extents when the file system supports it */
+static NTSTATUS duplicate_extents( HANDLE handle, const DUPLICATE_EXTENTS_DATA *data )
+{
+    NTSTATUS status;
+    int src_fd, dst_fd, src_close, dst_close;
+
+    TRACE( "%p <- %p, src %s dst %s count %s\n", handle, data->FileHandle,
+           wine_dbgstr_longlong( data->SourceFileOffset.QuadPart ),
+           wine_dbgstr_longlong( data->TargetFileOffset.QuadPart ),
+           wine_dbgstr_longlong( data->ByteCount.QuadPart ) );
+
+    if (data->SourceFileOffset.QuadPart < 0 || data->TargetFileOffset.QuadPart < 0 ||
+        data->ByteCount.QuadPart < 0)
+        return STATUS_INVALID_PARAMETER;
+
+    if ((status = server_get_unix_fd( handle, FILE_WRITE_DATA, &dst_fd, &dst_close, NULL, NULL )))
+        return status;
+    if ((status = server_get_unix_fd( data->FileHandle, FILE_READ_DATA, &src_fd, &src_close, NULL, NULL )))
+    {
+        if (dst_close) close( dst_fd );
+        return status;
+    }
+
+#ifdef linux
+    {
+        struct file_clone_range_args args;
+        ULONGLONG count = data->ByteCount.QuadPart;
+        off_t src_pos = data->SourceFileOffset.QuadPart;
+        off_t dst_pos = data->TargetFileOffset.QuadPart;
+
+        args.src_fd      = src_fd;
+        args.src_offset  = src_pos;
+        args.src_length  = count;
+        args.dest_offset = dst_pos;
+
+        if (count && !ioctl( dst_fd, WINE_FICLONERANGE, &args )) count = 0;
+#ifdef __NR_copy_file_range
+        while (count)
+        {
+            ssize_t ret = syscall( __NR_copy_file_range, src_fd, &src_pos, dst_fd, &dst_pos,
+                                   (size_t)min( count, 0x40000000 ), 0 );
+            if (ret < 0)
+            {
+                if (errno == EINTR) continue;
+                if (errno == ENOSYS || errno == EXDEV || errno == EOPNOTSUPP || errno == EINVAL)
+                    status = STATUS_INVALID_DEVICE_REQUEST;
+                else
+                    status = errno_to_status( errno );
+                break;
+            }
+            if (!ret)
+            {
+                status = STATUS_END_OF_FILE;
+                break;
+            }
+            count -= ret;
+        }
+#else
+        if (count) status = STATUS_INVALID_DEVICE_REQUEST;
+#endif
+    }
+#else
+    status = STATUS_INVALID_DEVICE_REQUEST;
+#endif
+
+    if (src_close) close( src_fd );
+    if (dst_close) close( dst_fd );
+    return status;
+}
+
+
 /******************************************************************************
  *              NtFsControlFile   (NTDLL.@)
  */
@@ -6801,6 +7394,21 @@ NTSTATUS WINAPI NtFsControlFile( HANDLE handle, HANDLE event, PIO_APC_ROUTINE ap
         io->Information = 0;
         status = STATUS_SUCCESS;
         break;
+
+    case FSCTL_DUPLICATE_EXTENTS_TO_FILE:
+    {
+        const DUPLICATE_EXTENTS_DATA *data = in_buffer;
+
+        if (in_size < sizeof(*data))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+        status = duplicate_extents( handle, data );
+        io->Information = 0;
+        break;
+    }
+
     default:
         return server_ioctl_file( handle, event, apc, apc_context, io, code,
                                   in_buffer, in_size, out_buffer, out_size );
@@ -7668,6 +8276,9 @@ NTSTATUS WINAPI NtQueryObject( HANDLE handle, OBJECT_INFORMATION_CLASS info_clas
 
         if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
+        if (server_get_shared_handle_info( handle, NULL, NULL, NULL ) == STATUS_INVALID_HANDLE)
+            return STATUS_INVALID_HANDLE;
+
         SERVER_START_REQ( get_object_info )
         {
             req->handle = wine_server_obj_handle( handle );
@@ -7818,9 +8429,20 @@ NTSTATUS WINAPI NtQueryObject( HANDLE handle, OBJECT_INFORMATION_CLASS info_clas
     case ObjectDataInformation:
     {
         OBJECT_DATA_INFORMATION* p = ptr;
+        unsigned int flags;
 
         if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
+        status = server_get_shared_handle_info( handle, NULL, NULL, &flags );
+        if (status != STATUS_NOT_SUPPORTED)
+        {
+            if (status) break;
+            p->InheritHandle = (flags & HANDLE_FLAG_INHERIT) != 0;
+            p->ProtectFromClose = (flags & HANDLE_FLAG_PROTECT_FROM_CLOSE) != 0;
+            if (used_len) *used_len = sizeof(*p);
+            break;
+        }
+
         SERVER_START_REQ( set_handle_info )
         {
             req->handle = wine_server_obj_handle( handle );
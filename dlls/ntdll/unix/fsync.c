@@ -156,6 +156,7 @@ static inline int futex_wait( int *addr, int val, const ULONGLONG *end )
 }
 
 static unsigned int spincount = 100;
+static int do_fsync_stats;
 
 int do_fsync(void)
 {
@@ -176,6 +177,7 @@ int do_fsync(void)
         do_fsync_cached = getenv("WINEFSYNC") && atoi(getenv("WINEFSYNC")) && errno != ENOSYS;
         if (getenv("WINEFSYNC_SPINCOUNT"))
             spincount = atoi(getenv("WINEFSYNC_SPINCOUNT"));
+        do_fsync_stats = getenv("WINEFSYNC_STATS") && atoi(getenv("WINEFSYNC_STATS"));
     }
 
     return do_fsync_cached;
@@ -191,8 +193,43 @@ struct fsync
 {
     enum fsync_type type;
     void *shm;              /* pointer to shm section */
+    unsigned int spin;      /* adaptive estimate of the spins needed to grab the object */
+    unsigned int waits;     /* statistics, only collected with WINEFSYNC_STATS */
+    unsigned int spins;
+    unsigned int sleeps;
 };
 
+/* The spin loop is adapted to each object, like glibc's adaptive mutexes:
+ * we spin up to twice the number of spins that were recently needed to grab
+ * it, and sleep on the futex if that wasn't enough. */
+static inline unsigned int get_spin_limit( const struct fsync *obj )
+{
+    return min( obj->spin * 2 + 10, spincount );
+}
+
+static inline void update_spin( struct fsync *obj, unsigned int spins )
+{
+    obj->spin += ((int)spins - (int)obj->spin) / 8;
+    if (do_fsync_stats)
+    {
+        __atomic_fetch_add( &obj->waits, 1, __ATOMIC_RELAXED );
+        __atomic_fetch_add( &obj->spins, spins, __ATOMIC_RELAXED );
+    }
+}
+
+static inline void add_sleep_stats( struct fsync *obj )
+{
+    if (do_fsync_stats) __atomic_fetch_add( &obj->sleeps, 1, __ATOMIC_RELAXED );
+}
+
+static void dump_stats( HANDLE handle, const struct fsync *obj )
+{
+    if (!obj->waits) return;
+    MESSAGE( "fsync: %04x:%04x handle %p type %u: %u waits, %u spins, %u sleeps, spin estimate %u\n",
+             GetCurrentProcessId(), GetCurrentThreadId(), handle, obj->type,
+             obj->waits, obj->spins, obj->sleeps, obj->spin );
+}
+
 struct semaphore
 {
     int count;
@@ -216,47 +253,74 @@ C_ASSERT(sizeof(struct mutex) == 8);
 
 static char shm_name[29];
 static int shm_fd;
-static void **shm_addrs;
-static int shm_addrs_size;  /* length of the allocated shm_addrs array */
+/* Table of mapped shm pages. Readers don't take any lock; when the table needs
+ * to grow, a bigger copy is published and the old one is leaked, since other
+ * threads may still be reading it. Since the size doubles every time, this
+ * wastes at most as much memory as the current table. */
+struct shm_addrs
+{
+    int size;
+    void *addrs[1];
+};
+
+static struct shm_addrs *shm_addrs;
 static long pagesize;
 
 static pthread_mutex_t shm_addrs_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+static struct shm_addrs *alloc_shm_addrs( int size )
+{
+    struct shm_addrs *table;
+
+    if (!(table = calloc( 1, sizeof(*table) + (size - 1) * sizeof(table->addrs[0]) ))) return NULL;
+    table->size = size;
+    return table;
+}
+
 static void *get_shm( unsigned int idx )
 {
     int entry  = (idx * 8) / pagesize;
     int offset = (idx * 8) % pagesize;
-    void *ret;
+    struct shm_addrs *table = __atomic_load_n( &shm_addrs, __ATOMIC_ACQUIRE );
+    void *addr;
+
+    if (entry < table->size && (addr = __atomic_load_n( &table->addrs[entry], __ATOMIC_ACQUIRE )))
+        return (void *)((unsigned long)addr + offset);
 
     pthread_mutex_lock( &shm_addrs_mutex );
 
-    if (entry >= shm_addrs_size)
+    /* only the mutex holder modifies the table, so it's safe to use it directly */
+    table = shm_addrs;
+    if (entry >= table->size)
     {
-        int new_size = max(shm_addrs_size * 2, entry + 1);
+        int new_size = max(table->size * 2, entry + 1);
+        struct shm_addrs *new_table;
 
-        if (!(shm_addrs = realloc( shm_addrs, new_size * sizeof(shm_addrs[0]) )))
-            ERR("Failed to grow shm_addrs array to size %d.\n", shm_addrs_size);
-        memset( shm_addrs + shm_addrs_size, 0, (new_size - shm_addrs_size) * sizeof(shm_addrs[0]) );
-        shm_addrs_size = new_size;
+        if (!(new_table = alloc_shm_addrs( new_size )))
+        {
+            ERR("Failed to grow shm_addrs array to size %d.\n", new_size);
+            pthread_mutex_unlock( &shm_addrs_mutex );
+            return NULL;
+        }
+        memcpy( new_table->addrs, table->addrs, table->size * sizeof(table->addrs[0]) );
+        __atomic_store_n( &shm_addrs, new_table, __ATOMIC_RELEASE );
+        table = new_table;
     }
 
-    if (!shm_addrs[entry])
+    if (!(addr = table->addrs[entry]))
     {
-        void *addr = mmap( NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, entry * pagesize );
+        addr = mmap( NULL, pagesize, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, entry * pagesize );
         if (addr == (void *)-1)
             ERR("Failed to map page %d (offset %#lx).\n", entry, entry * pagesize);
 
         TRACE("Mapping page %d at %p.\n", entry, addr);
 
-        if (__sync_val_compare_and_swap( &shm_addrs[entry], 0, addr ))
-            munmap( addr, pagesize ); /* someone beat us to it */
+        __atomic_store_n( &table->addrs[entry], addr, __ATOMIC_RELEASE );
     }
 
-    ret = (void *)((unsigned long)shm_addrs[entry] + offset);
-
     pthread_mutex_unlock( &shm_addrs_mutex );
 
-    return ret;
+    return (void *)((unsigned long)addr + offset);
 }
 
 /* We'd like lookup to be fast. To that end, we use a static list indexed by handle.
@@ -298,7 +362,13 @@ static struct fsync *add_to_list( HANDLE handle, enum fsync_type type, void *shm
     }
 
     if (!__sync_val_compare_and_swap((int *)&fsync_list[entry][idx].type, 0, type ))
+    {
         fsync_list[entry][idx].shm = shm;
+        fsync_list[entry][idx].spin = 0;
+        fsync_list[entry][idx].waits = 0;
+        fsync_list[entry][idx].spins = 0;
+        fsync_list[entry][idx].sleeps = 0;
+    }
 
     return &fsync_list[entry][idx];
 }
@@ -356,6 +426,14 @@ static NTSTATUS get_object( HANDLE handle, struct fsync **obj )
     return ret;
 }
 
+/* Returns the address of a shm slot the server publishes data in, so that
+ * PE code can read it without any call. */
+void * CDECL fsync_get_shm_ptr( unsigned int shm_idx )
+{
+    if (!do_fsync() || !shm_idx) return NULL;
+    return get_shm( shm_idx );
+}
+
 NTSTATUS fsync_close( HANDLE handle )
 {
     UINT_PTR entry, idx = handle_to_index( handle, &entry );
@@ -364,6 +442,7 @@ NTSTATUS fsync_close( HANDLE handle )
 
     if (entry < FSYNC_LIST_ENTRIES && fsync_list[entry])
     {
+        if (do_fsync_stats) dump_stats( handle, &fsync_list[entry][idx] );
         if (__atomic_exchange_n( &fsync_list[entry][idx].type, 0, __ATOMIC_SEQ_CST ))
             return STATUS_SUCCESS;
     }
@@ -440,6 +519,22 @@ static NTSTATUS open_fsync( enum fsync_type type, HANDLE *handle,
     return ret;
 }
 
+/* dump the statistics of the objects that are still open at exit */
+static void dump_all_stats(void)
+{
+    UINT_PTR entry, idx;
+
+    for (entry = 0; entry < FSYNC_LIST_ENTRIES; entry++)
+    {
+        if (!fsync_list[entry]) continue;
+        for (idx = 0; idx < FSYNC_LIST_BLOCK_SIZE; idx++)
+        {
+            if (!fsync_list[entry][idx].type) continue;
+            dump_stats( (HANDLE)(((entry * FSYNC_LIST_BLOCK_SIZE + idx) + 1) << 2), &fsync_list[entry][idx] );
+        }
+    }
+}
+
 void fsync_init(void)
 {
     struct stat st;
@@ -480,8 +575,9 @@ void fsync_init(void)
 
     pagesize = sysconf( _SC_PAGESIZE );
 
-    shm_addrs = calloc( 128, sizeof(shm_addrs[0]) );
-    shm_addrs_size = 128;
+    shm_addrs = alloc_shm_addrs( 128 );
+
+    if (do_fsync_stats) atexit( dump_all_stats );
 }
 
 NTSTATUS fsync_create_semaphore( HANDLE *handle, ACCESS_MASK access,
@@ -758,7 +854,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
     int has_fsync = 0, has_server = 0;
     BOOL msgwait = FALSE;
     int dummy_futex = 0;
-    unsigned int spin;
+    unsigned int spin, limit;
     LONGLONG timeleft;
     LARGE_INTEGER now;
     DWORD waitcount;
@@ -872,16 +968,18 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                          * to use a dedicated interlocked_dec_if_nonzero()
                          * helper, but nesting loops like that is probably not
                          * great for performance... */
-                        for (spin = 0; spin <= spincount || current; ++spin)
+                        for (spin = 0, limit = get_spin_limit( obj ); spin <= limit || current; ++spin)
                         {
                             if ((current = __atomic_load_n( &semaphore->count, __ATOMIC_SEQ_CST ))
                                     && __sync_val_compare_and_swap( &semaphore->count, current, current - 1 ) == current)
                             {
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
+                                update_spin( obj, spin );
                                 return i;
                             }
                             small_pause();
                         }
+                        update_spin( obj, spin );
 
                         futex_vector_set( &futexes[i], &semaphore->count, 0 );
                         break;
@@ -898,22 +996,25 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                             return i;
                         }
 
-                        for (spin = 0; spin <= spincount; ++spin)
+                        for (spin = 0, limit = get_spin_limit( obj ); spin <= limit; ++spin)
                         {
                             if (!(tid = __sync_val_compare_and_swap( &mutex->tid, 0, GetCurrentThreadId() )))
                             {
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
                                 mutex->count = 1;
+                                update_spin( obj, spin );
                                 return i;
                             }
                             else if (tid == ~0 && (tid = __sync_val_compare_and_swap( &mutex->tid, ~0, GetCurrentThreadId() )) == ~0)
                             {
                                 TRACE("Woken up by abandoned mutex %p [%d].\n", handles[i], i);
                                 mutex->count = 1;
+                                update_spin( obj, spin );
                                 return STATUS_ABANDONED_WAIT_0 + i;
                             }
                             small_pause();
                         }
+                        update_spin( obj, spin );
 
                         futex_vector_set( &futexes[i], &mutex->tid, tid );
                         break;
@@ -923,7 +1024,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                     {
                         struct event *event = obj->shm;
 
-                        for (spin = 0; spin <= spincount; ++spin)
+                        for (spin = 0, limit = get_spin_limit( obj ); spin <= limit; ++spin)
                         {
                             if (__sync_val_compare_and_swap( &event->signaled, 1, 0 ))
                             {
@@ -931,10 +1032,12 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                                     usleep( 0 );
 
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
+                                update_spin( obj, spin );
                                 return i;
                             }
                             small_pause();
                         }
+                        update_spin( obj, spin );
 
                         futex_vector_set( &futexes[i], &event->signaled, 0 );
                         break;
@@ -945,7 +1048,7 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                     {
                         struct event *event = obj->shm;
 
-                        for (spin = 0; spin <= spincount; ++spin)
+                        for (spin = 0, limit = get_spin_limit( obj ); spin <= limit; ++spin)
                         {
                             if (__atomic_load_n( &event->signaled, __ATOMIC_SEQ_CST ))
                             {
@@ -953,10 +1056,12 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                                     usleep( 0 );
 
                                 TRACE("Woken up by handle %p [%d].\n", handles[i], i);
+                                update_spin( obj, spin );
                                 return i;
                             }
                             small_pause();
                         }
+                        update_spin( obj, spin );
 
                         futex_vector_set( &futexes[i], &event->signaled, 0 );
                         break;
@@ -993,6 +1098,11 @@ static NTSTATUS __fsync_wait_objects( DWORD count, const HANDLE *handles,
                 return STATUS_TIMEOUT;
             }
 
+            if (do_fsync_stats)
+            {
+                for (i = 0; i < count; i++) if (objs[i]) add_sleep_stats( objs[i] );
+            }
+
             if (waitcount == 1)
                 ret = futex_wait( u64_to_ptr(futexes[0].uaddr), futexes[0].val, timeout ? &end : NULL );
             else
@@ -1057,6 +1167,7 @@ tryagain:
 
                     while ((current = __atomic_load_n( &mutex->tid, __ATOMIC_SEQ_CST )))
                     {
+                        add_sleep_stats( obj );
                         status = do_single_wait( &mutex->tid, current, timeout ? &end : NULL, alertable );
                         if (status != STATUS_PENDING)
                             break;
@@ -1069,6 +1180,7 @@ tryagain:
 
                     while (!__atomic_load_n( &event->signaled, __ATOMIC_SEQ_CST ))
                     {
+                        add_sleep_stats( obj );
                         status = do_single_wait( &event->signaled, 0, timeout ? &end : NULL, alertable );
                         if (status != STATUS_PENDING)
                             break;
@@ -1244,13 +1356,18 @@ static void server_set_msgwait( int in_msgwait )
 NTSTATUS fsync_wait_objects( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
                              BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
+    static BOOL msgwait_reported;
     BOOL msgwait = FALSE;
     struct fsync *obj;
     NTSTATUS ret;
 
-    if (count && !get_object( handles[count - 1], &obj ) && obj->type == FSYNC_QUEUE)
+    /* A wait which can't block only needs to be reported to the server once,
+     * so that the process idle event gets set. */
+    if (count && (!timeout || timeout->QuadPart || !msgwait_reported) &&
+        !get_object( handles[count - 1], &obj ) && obj->type == FSYNC_QUEUE)
     {
         msgwait = TRUE;
+        msgwait_reported = TRUE;
         server_set_msgwait( 1 );
     }
 
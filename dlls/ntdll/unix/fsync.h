@@ -21,6 +21,7 @@
 extern int do_fsync(void) DECLSPEC_HIDDEN;
 extern void fsync_init(void) DECLSPEC_HIDDEN;
 extern NTSTATUS fsync_close( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void * CDECL fsync_get_shm_ptr( unsigned int shm_idx ) DECLSPEC_HIDDEN;
 
 extern NTSTATUS fsync_create_semaphore(HANDLE *handle, ACCESS_MASK access,
     const OBJECT_ATTRIBUTES *attr, LONG initial, LONG max) DECLSPEC_HIDDEN;
@@ -1843,6 +1843,7 @@ static struct unix_funcs unix_funcs =
     steamclient_setup_trampolines,
     set_unix_env,
     write_crash_log,
+    fsync_get_shm_ptr,
 };
 
 BOOL ac_odyssey;
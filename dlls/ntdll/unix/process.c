@@ -870,6 +870,8 @@ NTSTATUS WINAPI NtCreateUserProcess( HANDLE *process_handle_ptr, HANDLE *thread_
     const PS_ATTRIBUTE *handles_attr = NULL;
     data_size_t handles_size;
     obj_handle_t *handles;
+    HANDLE close_handles[4];
+    unsigned int close_count = 0;
 
     for (i = 0; i < attr_count; i++)
     {
@@ -1071,10 +1073,11 @@ NTSTATUS WINAPI NtCreateUserProcess( HANDLE *process_handle_ptr, HANDLE *thread_
     status = STATUS_SUCCESS;
 
 done:
-    if (file_handle) NtClose( file_handle );
-    if (process_info) NtClose( process_info );
-    if (process_handle) NtClose( process_handle );
-    if (thread_handle) NtClose( thread_handle );
+    if (file_handle) close_handles[close_count++] = file_handle;
+    if (process_info) close_handles[close_count++] = process_info;
+    if (process_handle) close_handles[close_count++] = process_handle;
+    if (thread_handle) close_handles[close_count++] = thread_handle;
+    server_close_handles( close_handles, close_count );
     if (socketfd[0] != -1) close( socketfd[0] );
     if (unixdir != -1) close( unixdir );
     free( startup_info );
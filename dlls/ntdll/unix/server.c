@@ -117,6 +117,17 @@ timeout_t server_start_time = 0;  /* time of server startup */
 sigset_t server_block_set;  /* signals to block during server calls */
 static int fd_socket = -1;  /* socket to exchange file descriptors with the server */
 static pid_t server_pid;
+
+/* server request statistics, collected per thread when WINESERVERSTATS is set */
+struct request_stats
+{
+    unsigned int count;  /* number of calls */
+    ULONGLONG    time;   /* total time spent in the calls */
+};
+
+static BOOL request_stats_enabled;
+static struct request_stats process_request_stats[REQ_NB_REQUESTS];
+static pthread_mutex_t request_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t fd_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /* atomically exchange a 64-bit value */
@@ -267,16 +278,143 @@ static inline unsigned int wait_reply( struct __server_request_info *req )
 }
 
 
+/***********************************************************************
+ *           add_request_stats
+ */
+static void add_request_stats( enum request req, ULONGLONG start )
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    LARGE_INTEGER now;
+
+    if (req >= REQ_NB_REQUESTS) return;
+    if (!thread_data->request_stats &&
+        !(thread_data->request_stats = calloc( REQ_NB_REQUESTS, sizeof(struct request_stats) )))
+        return;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    thread_data->request_stats[req].count++;
+    thread_data->request_stats[req].time += now.QuadPart - start;
+}
+
+
+/***********************************************************************
+ *           flush_request_stats
+ *
+ * Add the request statistics of the current thread to the process totals.
+ */
+void flush_request_stats(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct request_stats *stats = thread_data->request_stats;
+    unsigned int i;
+
+    if (!stats) return;
+    thread_data->request_stats = NULL;
+
+    mutex_lock( &request_stats_mutex );
+    for (i = 0; i < REQ_NB_REQUESTS; i++)
+    {
+        process_request_stats[i].count += stats[i].count;
+        process_request_stats[i].time += stats[i].time;
+    }
+    mutex_unlock( &request_stats_mutex );
+    free( stats );
+}
+
+
+/***********************************************************************
+ *           dump_request_stats
+ *
+ * Print the request statistics of the process when it exits.
+ */
+static void dump_request_stats(void)
+{
+    unsigned int i;
+
+    if (!request_stats_enabled) return;
+    flush_request_stats();
+
+    fprintf( stderr, "%04x: server request statistics\n", GetCurrentProcessId() );
+    for (i = 0; i < REQ_NB_REQUESTS; i++)
+    {
+        if (!process_request_stats[i].count) continue;
+        fprintf( stderr, "%04x:   request %3u: %8u calls, %12.3f ms total, %8.3f us average\n",
+                 GetCurrentProcessId(), i, process_request_stats[i].count,
+                 process_request_stats[i].time / 10000.0,
+                 process_request_stats[i].time / 10.0 / process_request_stats[i].count );
+    }
+}
+
+
 /***********************************************************************
  *           server_call_unlocked
  */
 unsigned int server_call_unlocked( void *req_ptr )
 {
     struct __server_request_info * const req = req_ptr;
+    enum request type = req->u.req.request_header.req;
+    LARGE_INTEGER start;
     unsigned int ret;
 
+    if (request_stats_enabled) NtQueryPerformanceCounter( &start, NULL );
     if ((ret = send_request( req ))) return ret;
-    return wait_reply( req );
+    ret = wait_reply( req );
+    if (request_stats_enabled) add_request_stats( type, start.QuadPart );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           server_call_batch
+ *
+ * Send several requests to the server with a single write, and wait for
+ * all the replies. The requests must not depend on each other's results
+ * and must not pass file descriptors. Returns the status of the first
+ * failed request; the individual status codes are in the reply headers.
+ */
+unsigned int server_call_batch( struct __server_request_info **reqs, unsigned int count )
+{
+    struct iovec vec[SERVER_MAX_BATCH * (__SERVER_MAX_DATA + 1)];
+    enum request types[SERVER_MAX_BATCH];
+    unsigned int i, j, err, total = 0, status = STATUS_SUCCESS;
+    LARGE_INTEGER start;
+    sigset_t old_set;
+    int ret, nvec = 0;
+
+    assert( count <= SERVER_MAX_BATCH );
+
+    if (request_stats_enabled) NtQueryPerformanceCounter( &start, NULL );
+    for (i = 0; i < count; i++)
+    {
+        types[i] = reqs[i]->u.req.request_header.req;
+        vec[nvec].iov_base = (void *)&reqs[i]->u.req;
+        vec[nvec++].iov_len = sizeof(reqs[i]->u.req);
+        for (j = 0; j < reqs[i]->data_count; j++)
+        {
+            vec[nvec].iov_base = (void *)reqs[i]->data[j].ptr;
+            vec[nvec++].iov_len = reqs[i]->data[j].size;
+        }
+        total += sizeof(reqs[i]->u.req) + reqs[i]->u.req.request_header.request_size;
+    }
+
+    pthread_sigmask( SIG_BLOCK, &server_block_set, &old_set );
+    if ((ret = writev( ntdll_get_thread_data()->request_fd, vec, nvec )) != total)
+    {
+        if (ret >= 0) server_protocol_error( "partial write %d\n", ret );
+        if (errno == EPIPE) abort_thread(0);
+        if (errno != EFAULT) server_protocol_perror( "write" );
+        pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+        return STATUS_ACCESS_VIOLATION;
+    }
+    for (i = 0; i < count; i++)
+    {
+        err = wait_reply( reqs[i] );
+        if (err && !status) status = err;
+    }
+    /* the whole batch is accounted to each request */
+    if (request_stats_enabled) for (i = 0; i < count; i++) add_request_stats( types[i], start.QuadPart );
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+    return status;
 }
 
 
@@ -1010,6 +1148,104 @@ static int remove_fd_from_cache( HANDLE handle )
 }
 
 
+/***********************************************************************/
+/* shared handle table support */
+
+struct shared_handle_view
+{
+    const struct shared_handle_entry *entries;  /* read-only mapping of the server table */
+    unsigned int                      count;    /* number of mapped entries */
+};
+
+static struct shared_handle_view *shared_handle_view;
+static int shared_handle_fd = -1;
+static BOOL shared_handle_disabled;
+
+
+/***********************************************************************
+ *           map_shared_handle_table
+ *
+ * Map the current size of the shared handle table, which may have grown.
+ * Caller must hold fd_cache_mutex.
+ */
+static BOOL map_shared_handle_table(void)
+{
+    struct shared_handle_view *view;
+    obj_handle_t fd_handle;
+    struct stat st;
+    void *ptr;
+
+    if (shared_handle_fd == -1)
+    {
+        SERVER_START_REQ( get_shared_handle_table )
+        {
+            if (!wine_server_call( req )) shared_handle_fd = receive_fd( &fd_handle );
+        }
+        SERVER_END_REQ;
+        if (shared_handle_fd == -1)
+        {
+            shared_handle_disabled = TRUE;
+            return FALSE;
+        }
+    }
+
+    if (fstat( shared_handle_fd, &st ) == -1) return FALSE;
+    if (shared_handle_view && st.st_size / sizeof(*view->entries) <= shared_handle_view->count) return TRUE;
+    if (!(view = malloc( sizeof(*view) ))) return FALSE;
+    ptr = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, shared_handle_fd, 0 );
+    if (ptr == MAP_FAILED)
+    {
+        free( view );
+        return FALSE;
+    }
+    view->entries = ptr;
+    view->count   = st.st_size / sizeof(*view->entries);
+    /* other threads may still be reading the previous view, so it is never freed */
+    __atomic_store_n( &shared_handle_view, view, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           server_get_shared_handle_info
+ *
+ * Retrieve the type index, access rights and flags of a handle of the current
+ * process from the table shared by the server, without a server round-trip.
+ * Returns STATUS_NOT_SUPPORTED if the caller needs to ask the server instead.
+ */
+NTSTATUS server_get_shared_handle_info( HANDLE handle, unsigned int *type, unsigned int *access,
+                                        unsigned int *flags )
+{
+    unsigned int index = (wine_server_obj_handle( handle ) >> 2) - 1;
+    struct shared_handle_view *view;
+    struct shared_handle_entry entry;
+    sigset_t sigset;
+    BOOL ret;
+
+    /* pseudo-handles and global handles are only known to the server */
+    if (!handle || (INT_PTR)handle < 0 || index >= 0x00ffffff) return STATUS_NOT_SUPPORTED;
+
+    view = __atomic_load_n( &shared_handle_view, __ATOMIC_ACQUIRE );
+    if (!view || index >= view->count)
+    {
+        if (shared_handle_disabled) return STATUS_NOT_SUPPORTED;
+        server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+        ret = map_shared_handle_table();
+        server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+        if (!ret) return STATUS_NOT_SUPPORTED;
+        view = __atomic_load_n( &shared_handle_view, __ATOMIC_ACQUIRE );
+        if (index >= view->count) return STATUS_INVALID_HANDLE;  /* beyond the end of the table */
+    }
+
+    entry = *(volatile struct shared_handle_entry *)&view->entries[index];
+    if (!entry.type) return STATUS_INVALID_HANDLE;
+    if (type) *type = entry.type - 1;
+    if (access) *access = entry.access;
+    if (flags) *flags = entry.flags;
+    return STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *           server_get_unix_fd
  *
@@ -1469,6 +1705,8 @@ static void init_teb64( TEB *teb )
  */
 void process_exit_wrapper( int status )
 {
+    dump_request_stats();
+    dbg_flush_process();
     close( fd_socket );
     exit( status );
 }
@@ -1492,6 +1730,7 @@ size_t server_init_process(void)
     int nice_limit = 0;
 
     server_pid = -1;
+    request_stats_enabled = getenv( "WINESERVERSTATS" ) != NULL;
     if (env_socket)
     {
         fd_socket = atoi( env_socket );
@@ -1715,6 +1954,10 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
 {
     NTSTATUS ret;
 
+    if (source_process == NtCurrentProcess() &&
+        server_get_shared_handle_info( source, NULL, NULL, NULL ) == STATUS_INVALID_HANDLE)
+        return STATUS_INVALID_HANDLE;
+
     SERVER_START_REQ( dup_handle )
     {
         req->src_process = wine_server_obj_handle( source_process );
@@ -1738,6 +1981,41 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
 }
 
 
+/***********************************************************************
+ *           server_close_handles
+ *
+ * Close several handles with a single server round-trip.
+ */
+void server_close_handles( const HANDLE *handles, unsigned int count )
+{
+    struct __server_request_info info[SERVER_MAX_BATCH], *reqs[SERVER_MAX_BATCH];
+    int fds[SERVER_MAX_BATCH];
+    unsigned int i, pos, n;
+
+    for (pos = 0; pos < count; pos += n)
+    {
+        n = min( count - pos, SERVER_MAX_BATCH );
+        for (i = 0; i < n; i++)
+        {
+            HANDLE handle = handles[pos + i];
+
+            fds[i] = remove_fd_from_cache( handle );
+            if (do_fsync()) fsync_close( handle );
+            if (do_esync()) esync_close( handle );
+
+            memset( &info[i].u.req, 0, sizeof(info[i].u.req) );
+            info[i].u.req.request_header.req = REQ_close_handle;
+            info[i].u.req.close_handle_request.handle = wine_server_obj_handle( handle );
+            info[i].data_count = 0;
+            info[i].reply_data = NULL;
+            reqs[i] = &info[i];
+        }
+        server_call_batch( reqs, n );
+        for (i = 0; i < n; i++) if (fds[i] != -1) close( fds[i] );
+    }
+}
+
+
 /**************************************************************************
  *           NtClose
  */
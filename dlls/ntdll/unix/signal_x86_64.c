@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <time.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
@@ -325,6 +326,7 @@ struct amd64_thread_data
     DWORD_PTR             dr7;           /* 0318 */
     void                 *exit_frame;    /* 0320 exit frame pointer */
     struct syscall_frame *syscall_frame; /* 0328 syscall frame pointer */
+    ULONG_PTR             prof_timer;    /* 0330 profiling timer id + 1 */
 };
 
 C_ASSERT( sizeof(struct amd64_thread_data) <= sizeof(((struct ntdll_thread_data *)0)->cpu_data) );
@@ -2921,6 +2923,192 @@ static void usr1_handler( int signal, siginfo_t *siginfo, void *ucontext )
 }
 
 
+/***********************************************************************
+ * Sampling profiler
+ *
+ * With WINEPROFILE=<file>, every thread gets a SIGPROF timer on its own CPU
+ * time. Samples are aggregated by program counter, plus the Windows caller
+ * when the thread was inside a syscall, and written in the "collapsed
+ * stack" format understood by flamegraph tools when the process exits.
+ */
+#if defined(__linux__) && defined(SIGEV_THREAD_ID)
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+#define PROFILE_TABLE_SIZE 65536   /* must be a power of 2 */
+#define PROFILE_MAX_PROBES 32
+#define PROFILE_INTERVAL   1000000 /* 1ms of thread CPU time */
+
+struct profile_sample
+{
+    ULONG64 pc;
+    ULONG64 caller;     /* Windows return address if the sample was taken in a syscall */
+    LONG    count;
+    LONG    state;      /* 0: free, 1: being filled, 2: valid */
+};
+
+static struct profile_sample *profile_table;
+static char *profile_file;
+static LONG profile_lost;
+
+static void prof_handler( int signal, siginfo_t *siginfo, void *sigcontext )
+{
+    struct syscall_frame *frame = amd64_thread_data()->syscall_frame;
+    ucontext_t *ucontext = sigcontext;
+    ULONG64 pc = RIP_sig(ucontext), caller = frame ? frame->rip : 0;
+    ULONG64 hash = (pc ^ (caller * 0x9e3779b97f4a7c15ull)) >> 4;
+    struct profile_sample *sample;
+    unsigned int i;
+
+    for (i = 0; i < PROFILE_MAX_PROBES; i++)
+    {
+        sample = &profile_table[(hash + i) & (PROFILE_TABLE_SIZE - 1)];
+        switch (__atomic_load_n( &sample->state, __ATOMIC_ACQUIRE ))
+        {
+        case 0:
+            if (InterlockedCompareExchange( &sample->state, 1, 0 )) break;
+            sample->pc = pc;
+            sample->caller = caller;
+            sample->count = 1;
+            __atomic_store_n( &sample->state, 2, __ATOMIC_RELEASE );
+            return;
+        case 2:
+            if (sample->pc != pc || sample->caller != caller) break;
+            InterlockedIncrement( &sample->count );
+            return;
+        }
+    }
+    InterlockedIncrement( &profile_lost );
+}
+
+static void profile_format_address( char *buffer, size_t size, ULONG64 addr )
+{
+    PEB_LDR_DATA *ldr = NtCurrentTeb()->Peb->LdrData;
+    LIST_ENTRY *entry;
+    Dl_info info;
+
+    if (ldr)
+    {
+        for (entry = ldr->InLoadOrderModuleList.Flink; entry != &ldr->InLoadOrderModuleList; entry = entry->Flink)
+        {
+            LDR_DATA_TABLE_ENTRY *mod = CONTAINING_RECORD( entry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks );
+            char name[MAX_PATH];
+            int len;
+
+            if (addr < (ULONG_PTR)mod->DllBase || addr - (ULONG_PTR)mod->DllBase >= mod->SizeOfImage) continue;
+            len = ntdll_wcstoumbs( mod->BaseDllName.Buffer, mod->BaseDllName.Length / sizeof(WCHAR),
+                                   name, sizeof(name) - 1, FALSE );
+            name[max( len, 0 )] = 0;
+            snprintf( buffer, size, "%s+0x%lx", name, (unsigned long)(addr - (ULONG_PTR)mod->DllBase) );
+            return;
+        }
+    }
+    if (dladdr( (void *)addr, &info ) && info.dli_fname)
+    {
+        const char *name = strrchr( info.dli_fname, '/' );
+        snprintf( buffer, size, "%s+0x%lx", name ? name + 1 : info.dli_fname,
+                  (unsigned long)(addr - (ULONG_PTR)info.dli_fbase) );
+        return;
+    }
+    snprintf( buffer, size, "0x%lx", (unsigned long)addr );
+}
+
+static void profile_dump(void)
+{
+    char pc_name[MAX_PATH + 32], caller_name[MAX_PATH + 32];
+    unsigned int i;
+    FILE *file;
+
+    if (!(file = fopen( profile_file, "w" )))
+    {
+        ERR( "failed to create %s, errno %d\n", profile_file, errno );
+        return;
+    }
+    for (i = 0; i < PROFILE_TABLE_SIZE; i++)
+    {
+        const struct profile_sample *sample = &profile_table[i];
+
+        if (__atomic_load_n( &sample->state, __ATOMIC_ACQUIRE ) != 2) continue;
+        profile_format_address( pc_name, sizeof(pc_name), sample->pc );
+        if (sample->caller)
+        {
+            profile_format_address( caller_name, sizeof(caller_name), sample->caller );
+            fprintf( file, "%s;%s %d\n", caller_name, pc_name, sample->count );
+        }
+        else fprintf( file, "%s %d\n", pc_name, sample->count );
+    }
+    if (profile_lost) fprintf( file, "[lost] %d\n", profile_lost );
+    fclose( file );
+}
+
+static void profile_init_thread(void)
+{
+    struct sigevent event;
+    struct itimerspec spec;
+    timer_t timer;
+
+    if (!profile_table) return;
+
+    memset( &event, 0, sizeof(event) );
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = syscall( SYS_gettid );
+    if (timer_create( CLOCK_THREAD_CPUTIME_ID, &event, &timer ) == -1)
+    {
+        WARN( "failed to create profiling timer, errno %d\n", errno );
+        return;
+    }
+    spec.it_interval.tv_sec = spec.it_value.tv_sec = 0;
+    spec.it_interval.tv_nsec = spec.it_value.tv_nsec = PROFILE_INTERVAL;
+    timer_settime( timer, 0, &spec, NULL );
+    amd64_thread_data()->prof_timer = (ULONG_PTR)timer + 1;
+}
+
+static void profile_free_thread( TEB *teb )
+{
+    struct amd64_thread_data *data = (struct amd64_thread_data *)((struct ntdll_thread_data *)&teb->GdiTebBatch)->cpu_data;
+
+    if (!data->prof_timer) return;
+    timer_delete( (timer_t)(data->prof_timer - 1) );
+    data->prof_timer = 0;
+}
+
+static void profile_init_process( struct sigaction *sig_act )
+{
+    const char *env = getenv( "WINEPROFILE" );
+
+    if (!env || !*env) return;
+    profile_table = anon_mmap_alloc( PROFILE_TABLE_SIZE * sizeof(*profile_table), PROT_READ | PROT_WRITE );
+    if (profile_table == MAP_FAILED || !(profile_file = strdup( env )))
+    {
+        profile_table = NULL;
+        return;
+    }
+
+    sig_act->sa_sigaction = prof_handler;
+    if (sigaction( SIGPROF, sig_act, NULL ) == -1)
+    {
+        profile_table = NULL;
+        return;
+    }
+    atexit( profile_dump );
+    profile_init_thread();
+}
+
+#else  /* defined(__linux__) && defined(SIGEV_THREAD_ID) */
+
+static void profile_init_thread(void) { }
+static void profile_free_thread( TEB *teb ) { }
+static void profile_init_process( struct sigaction *sig_act )
+{
+    if (getenv( "WINEPROFILE" )) FIXME( "sampling profiler not supported on this platform\n" );
+}
+
+#endif  /* defined(__linux__) && defined(SIGEV_THREAD_ID) */
+
+
 /**********************************************************************
  *           get_thread_ldt_entry
  */
@@ -2962,6 +3150,7 @@ NTSTATUS signal_alloc_thread( TEB *teb )
  */
 void signal_free_thread( TEB *teb )
 {
+    profile_free_thread( teb );
 }
 
 #ifdef __APPLE__
@@ -3052,6 +3241,8 @@ void signal_init_thread( TEB *teb )
 #else
     FIXME("FPU setup not implemented for this platform.\n");
 #endif
+
+    profile_init_thread();
 }
 
 
@@ -3082,6 +3273,7 @@ void signal_init_process(void)
     if (sigaction( SIGILL, &sig_act, NULL ) == -1) goto error;
     if (sigaction( SIGBUS, &sig_act, NULL ) == -1) goto error;
     install_bpf(&sig_act);
+    profile_init_process( &sig_act );
     return;
 
  error:
@@ -83,6 +83,15 @@ static const LARGE_INTEGER zero_timeout;
 
 static pthread_mutex_t addr_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* timer resolutions, in 100ns units */
+#define TIMER_RESOLUTION_MIN      156250  /* coarsest resolution reported */
+#define TIMER_RESOLUTION_MAX      5000    /* finest resolution that can be requested */
+#define TIMER_RESOLUTION_DEFAULT  10000
+/* time spent yielding instead of sleeping at the end of a delay with a fine resolution */
+#define DELAY_SPIN_TIME           1000
+
+static ULONG timer_resolution;  /* resolution requested by the process, 0 if none */
+
 /* return a monotonic time counter, in Win32 ticks */
 static inline ULONGLONG monotonic_counter(void)
 {
@@ -1614,6 +1623,27 @@ NTSTATUS WINAPI NtDelayExecution( BOOLEAN alertable, const LARGE_INTEGER *timeou
     {
         for (;;) select( 0, NULL, NULL, NULL, NULL );
     }
+#if defined(HAVE_CLOCK_GETTIME) && defined(TIMER_ABSTIME)
+    else if (timeout->QuadPart < 0)
+    {
+        ULONGLONG when, end = monotonic_counter() - timeout->QuadPart;
+        struct timespec ts;
+
+        NtYieldExecution();
+
+        /* sleep until an absolute deadline so that interruptions don't add up,
+         * and yield through the last part if the process asked for a fine resolution */
+        when = end;
+        if (timer_resolution && timer_resolution <= TIMER_RESOLUTION_DEFAULT) when -= DELAY_SPIN_TIME;
+        if (when > monotonic_counter())
+        {
+            ts.tv_sec  = when / TICKSPERSEC;
+            ts.tv_nsec = (when % TICKSPERSEC) * 100;
+            while (clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL ) == EINTR);
+        }
+        while (monotonic_counter() < end) NtYieldExecution();
+    }
+#endif
     else
     {
         LARGE_INTEGER now;
@@ -1715,8 +1745,14 @@ NTSTATUS WINAPI NtSetSystemTime( const LARGE_INTEGER *new, LARGE_INTEGER *old )
  */
 NTSTATUS WINAPI NtQueryTimerResolution( ULONG *min_res, ULONG *max_res, ULONG *current_res )
 {
-    FIXME( "(%p,%p,%p), stub!\n", min_res, max_res, current_res );
-    return STATUS_NOT_IMPLEMENTED;
+    ULONG res = timer_resolution;
+
+    TRACE( "(%p,%p,%p)\n", min_res, max_res, current_res );
+
+    *min_res = TIMER_RESOLUTION_MIN;
+    *max_res = TIMER_RESOLUTION_MAX;
+    *current_res = res ? res : TIMER_RESOLUTION_DEFAULT;
+    return STATUS_SUCCESS;
 }
 
 
@@ -1725,8 +1761,14 @@ NTSTATUS WINAPI NtQueryTimerResolution( ULONG *min_res, ULONG *max_res, ULONG *c
  */
 NTSTATUS WINAPI NtSetTimerResolution( ULONG res, BOOLEAN set, ULONG *current_res )
 {
-    FIXME( "(%u,%u,%p), stub!\n", res, set, current_res );
-    return STATUS_NOT_IMPLEMENTED;
+    TRACE( "(%u,%u,%p)\n", res, set, current_res );
+
+    /* the resolution only affects how precisely this process sleeps */
+    if (set) timer_resolution = min( max( res, TIMER_RESOLUTION_MAX ), TIMER_RESOLUTION_MIN );
+    else timer_resolution = 0;
+
+    *current_res = timer_resolution ? timer_resolution : TIMER_RESOLUTION_DEFAULT;
+    return STATUS_SUCCESS;
 }
 
 
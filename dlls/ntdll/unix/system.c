@@ -2354,7 +2354,7 @@ NTSTATUS WINAPI NtQuerySystemInformation( SYSTEM_INFORMATION_CLASS class,
     {
         unsigned int process_count, i, j;
         char *buffer = NULL;
-        unsigned int pos = 0;
+        unsigned int pos = 0, buffer_size = size;
 
         if (size && !(buffer = malloc( size )))
         {
@@ -2362,14 +2362,28 @@ NTSTATUS WINAPI NtQuerySystemInformation( SYSTEM_INFORMATION_CLASS class,
             break;
         }
 
-        SERVER_START_REQ( list_processes )
+        /* always fetch the whole list, so that the exact size needed can be returned
+         * and callers don't have to guess it in several round trips */
+        for (;;)
         {
-            wine_server_set_reply( req, buffer, size );
-            ret = wine_server_call( req );
-            len = reply->info_size;
-            process_count = reply->process_count;
+            SERVER_START_REQ( list_processes )
+            {
+                wine_server_set_reply( req, buffer, buffer_size );
+                ret = wine_server_call( req );
+                len = reply->info_size;
+                process_count = reply->process_count;
+            }
+            SERVER_END_REQ;
+
+            if (ret != STATUS_INFO_LENGTH_MISMATCH) break;
+            free( buffer );
+            if (!(buffer = malloc( len )))
+            {
+                ret = STATUS_NO_MEMORY;
+                break;
+            }
+            buffer_size = len;
         }
-        SERVER_END_REQ;
 
         if (ret)
         {
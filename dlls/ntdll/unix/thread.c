@@ -93,6 +93,8 @@ static inline int get_unix_exit_code( NTSTATUS status )
  */
 static void pthread_exit_wrapper( int status )
 {
+    flush_request_stats();
+    dbg_flush_thread();
     close( ntdll_get_thread_data()->wait_fd[0] );
     close( ntdll_get_thread_data()->wait_fd[1] );
     close( ntdll_get_thread_data()->reply_fd );
@@ -113,6 +115,7 @@ static void start_thread( TEB *teb )
     BOOL suspend;
 
     debug_info.str_pos = debug_info.out_pos = 0;
+    debug_info.buffer = NULL;
     thread_data->debug_info = &debug_info;
     thread_data->pthread_id = pthread_self();
     signal_init_thread( teb );
@@ -645,7 +648,13 @@ NTSTATUS get_thread_context( HANDLE handle, context_t *context, unsigned int fla
 
     if (ret == STATUS_PENDING)
     {
-        NtWaitForSingleObject( handle, FALSE, NULL );
+        select_op_t select_op;
+
+        /* the context object is a plain server object, so wait on it directly instead of
+         * having esync/fsync ask the server for an fd that doesn't exist first */
+        select_op.wait.op = SELECT_WAIT;
+        select_op.wait.handles[0] = wine_server_obj_handle( handle );
+        server_wait( &select_op, offsetof( select_op_t, wait.handles[1] ), SELECT_INTERRUPTIBLE, NULL );
 
         SERVER_START_REQ( get_thread_context )
         {
@@ -43,6 +43,7 @@ struct debug_info
     unsigned int out_pos;       /* current position in output buffer */
     char         strings[1024]; /* buffer for temporary strings */
     char         output[1024];  /* current output line */
+    struct debug_buffer *buffer; /* buffered output lines, if enabled */
 };
 
 /* thread private data, stored in NtCurrentTeb()->GdiTebBatch */
@@ -61,6 +62,7 @@ struct ntdll_thread_data
     PRTL_THREAD_START_ROUTINE start;  /* thread entry point */
     void              *param;         /* thread entry point parameter */
     void              *heap;          /* thread local heap data */
+    struct request_stats *request_stats; /* server request statistics */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -149,6 +151,9 @@ extern void start_server( BOOL debug ) DECLSPEC_HIDDEN;
 extern ULONG_PTR get_image_address(void) DECLSPEC_HIDDEN;
 
 extern unsigned int server_call_unlocked( void *req_ptr ) DECLSPEC_HIDDEN;
+#define SERVER_MAX_BATCH 16  /* max number of requests in a server_call_batch() */
+extern unsigned int server_call_batch( struct __server_request_info **reqs, unsigned int count ) DECLSPEC_HIDDEN;
+extern void server_close_handles( const HANDLE *handles, unsigned int count ) DECLSPEC_HIDDEN;
 extern void server_enter_uninterrupted_section( pthread_mutex_t *mutex, sigset_t *sigset ) DECLSPEC_HIDDEN;
 extern void server_leave_uninterrupted_section( pthread_mutex_t *mutex, sigset_t *sigset ) DECLSPEC_HIDDEN;
 extern unsigned int server_select( const select_op_t *select_op, data_size_t size, UINT flags,
@@ -160,7 +165,10 @@ extern unsigned int server_queue_process_apc( HANDLE process, const apc_call_t *
                                               apc_result_t *result ) DECLSPEC_HIDDEN;
 extern int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
+extern NTSTATUS server_get_shared_handle_info( HANDLE handle, unsigned int *type, unsigned int *access,
+                                               unsigned int *flags ) DECLSPEC_HIDDEN;
 extern void process_exit_wrapper( int status )  DECLSPEC_HIDDEN;
+extern void flush_request_stats(void) DECLSPEC_HIDDEN;
 extern size_t server_init_process(void) DECLSPEC_HIDDEN;
 extern void server_init_process_done(void) DECLSPEC_HIDDEN;
 extern void server_init_thread( void *entry_point, BOOL *suspend ) DECLSPEC_HIDDEN;
@@ -250,6 +258,8 @@ extern void init_cpu_info(void) DECLSPEC_HIDDEN;
 extern struct cpu_topology_override *get_cpu_topology_override(void) DECLSPEC_HIDDEN;
 
 extern void dbg_init(void) DECLSPEC_HIDDEN;
+extern void dbg_flush_thread(void) DECLSPEC_HIDDEN;
+extern void dbg_flush_process(void) DECLSPEC_HIDDEN;
 
 extern void WINAPI DECLSPEC_NORETURN call_user_apc_dispatcher( CONTEXT *context_ptr, ULONG_PTR ctx,
                                                                ULONG_PTR arg1, ULONG_PTR arg2,
@@ -27,6 +27,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <signal.h>
@@ -40,6 +41,12 @@
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_SYS_IOCTL_H
+# include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
 #ifdef HAVE_SYS_SYSINFO_H
 # include <sys/sysinfo.h>
 #endif
@@ -53,6 +60,9 @@
 # include <mach/mach_init.h>
 # include <mach/mach_vm.h>
 #endif
+#ifdef HAVE_LINUX_USERFAULTFD_H
+# include <linux/userfaultfd.h>
+#endif
 
 #include <sys/uio.h>
 
@@ -131,7 +141,10 @@ static const BYTE VIRTUAL_Win32Flags[16] =
 };
 
 static struct wine_rb_tree views_tree;
+static BOOL use_kernel_write_watch;  /* the kernel tracks the write watches, pages are kept writable */
 static pthread_mutex_t virtual_mutex;
+static pthread_rwlock_t virtual_rwlock;  /* held exclusively along with virtual_mutex, shared by queries */
+static unsigned int virtual_lock_count;  /* recursion count of virtual_mutex, protected by it */
 
 static const BOOL is_win64 = (sizeof(void *) > sizeof(int));
 static const UINT page_shift = 12;
@@ -183,6 +196,11 @@ static const size_t pages_vprot_shift = 20;
 static const size_t pages_vprot_mask = (1 << 20) - 1;
 static size_t pages_vprot_size;
 static BYTE **pages_vprot;
+/* directory entries whose pages all have the same protection point to a shared read-only copy */
+static BYTE *pages_vprot_uniform[256];
+#define PAGES_VPROT_SPARE 16
+static BYTE *pages_vprot_spare[PAGES_VPROT_SPARE];  /* private entries kept for reuse */
+static unsigned int pages_vprot_spare_count;
 #else  /* on 32-bit we use a simple array with one byte per page */
 static BYTE *pages_vprot;
 #endif
@@ -722,6 +740,81 @@ static inline int is_view_valloc( const struct file_view *view )
     return !(view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT));
 }
 
+#ifdef _WIN64
+
+static inline BOOL is_uniform_vprot_dir( const BYTE *dir )
+{
+    return dir && pages_vprot_uniform[*dir] == dir;
+}
+
+
+/***********************************************************************
+ *           get_uniform_vprot_dir
+ *
+ * Return the shared directory entry for pages all having the same protection.
+ */
+static BYTE *get_uniform_vprot_dir( BYTE vprot )
+{
+    BYTE *ptr;
+
+    if (pages_vprot_uniform[vprot]) return pages_vprot_uniform[vprot];
+    if ((ptr = anon_mmap_alloc( pages_vprot_mask + 1, PROT_READ | PROT_WRITE )) == MAP_FAILED) return NULL;
+    if (vprot) memset( ptr, vprot, pages_vprot_mask + 1 );
+    mprotect( ptr, pages_vprot_mask + 1, PROT_READ );
+    return pages_vprot_uniform[vprot] = ptr;
+}
+
+
+/***********************************************************************
+ *           set_uniform_vprot_dir
+ *
+ * Set all the pages of a directory entry to the same protection. Return FALSE on failure.
+ */
+static BOOL set_uniform_vprot_dir( size_t i, BYTE vprot )
+{
+    BYTE *dir = pages_vprot[i], *uniform;
+
+    if (dir && dir == pages_vprot_uniform[vprot]) return TRUE;
+    if (!(uniform = get_uniform_vprot_dir( vprot ))) return FALSE;
+    if (dir && !is_uniform_vprot_dir( dir ))
+    {
+        if (pages_vprot_spare_count < PAGES_VPROT_SPARE) pages_vprot_spare[pages_vprot_spare_count++] = dir;
+        else munmap( dir, pages_vprot_mask + 1 );
+    }
+    pages_vprot[i] = uniform;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           get_private_vprot_dir
+ *
+ * Return a directory entry that can be modified, copying it if it's shared.
+ */
+static BYTE *get_private_vprot_dir( size_t i )
+{
+    BYTE *dir = pages_vprot[i], *ptr;
+
+    if (dir && !is_uniform_vprot_dir( dir )) return dir;
+    if (pages_vprot_spare_count)
+    {
+        ptr = pages_vprot_spare[--pages_vprot_spare_count];
+        memset( ptr, dir ? *dir : 0, pages_vprot_mask + 1 );
+    }
+    else if ((ptr = anon_mmap_alloc( pages_vprot_mask + 1, PROT_READ | PROT_WRITE )) != MAP_FAILED)
+    {
+        if (dir && *dir) memset( ptr, *dir, pages_vprot_mask + 1 );
+    }
+    else
+    {
+        ERR( "out of memory for page protections\n" );
+        abort_process( 1 );
+    }
+    return pages_vprot[i] = ptr;
+}
+
+#endif  /* _WIN64 */
+
 /***********************************************************************
  *           get_page_vprot
  *
@@ -767,10 +860,18 @@ static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vp
 
 #ifdef _WIN64
     vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift] + (curr_idx & pages_vprot_mask);
+    *vprot = *vprot_ptr;
+    if (is_uniform_vprot_dir( pages_vprot[curr_idx >> pages_vprot_shift] ))
+    {
+        /* skip to the next directory entry */
+        curr_idx = (curr_idx | pages_vprot_mask) + 1;
+        if (curr_idx >= end_idx) return size;
+        aligned_start_idx = curr_idx;
+    }
 #else
     vprot_ptr = pages_vprot + curr_idx;
-#endif
     *vprot = *vprot_ptr;
+#endif
 
     /* Page count page table is at least the multiples of sizeof(UINT_PTR)
      * so we don't have to worry about crossing the boundary on unaligned idx values. */
@@ -783,7 +884,16 @@ static SIZE_T get_vprot_range_size( char *base, SIZE_T size, BYTE mask, BYTE *vp
     for (; curr_idx < end_idx; curr_idx += sizeof(UINT_PTR), vprot_ptr += sizeof(UINT_PTR))
     {
 #ifdef _WIN64
-        if (!(curr_idx & pages_vprot_mask)) vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift];
+        if (!(curr_idx & pages_vprot_mask))
+        {
+            vprot_ptr = pages_vprot[curr_idx >> pages_vprot_shift];
+            if (is_uniform_vprot_dir( vprot_ptr ))
+            {
+                if ((*vprot ^ *vprot_ptr) & mask) return (curr_idx - start_idx) << page_shift;
+                curr_idx += pages_vprot_mask + 1 - sizeof(UINT_PTR);  /* the loop adds the rest */
+                continue;
+            }
+        }
 #endif
         if ((vprot_word ^ *(UINT_PTR *)vprot_ptr) & mask_word)
         {
@@ -806,13 +916,17 @@ static void set_page_vprot( const void *addr, size_t size, BYTE vprot )
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
 
 #ifdef _WIN64
-    while (idx >> pages_vprot_shift != end >> pages_vprot_shift)
+    while (idx < end)
     {
-        size_t dir_size = pages_vprot_mask + 1 - (idx & pages_vprot_mask);
-        memset( pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask), vprot, dir_size );
+        size_t i = idx >> pages_vprot_shift;
+        size_t dir_size = min( pages_vprot_mask + 1 - (idx & pages_vprot_mask), end - idx );
+        BYTE *dir = pages_vprot[i];
+
+        if (dir_size == pages_vprot_mask + 1 && set_uniform_vprot_dir( i, vprot )) ;
+        else if (!is_uniform_vprot_dir( dir ) || *dir != vprot)
+            memset( get_private_vprot_dir( i ) + (idx & pages_vprot_mask), vprot, dir_size );
         idx += dir_size;
     }
-    memset( pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask), vprot, end - idx );
 #else
     memset( pages_vprot + idx, vprot, end - idx );
 #endif
@@ -830,10 +944,27 @@ static void set_page_vprot_bits( const void *addr, size_t size, BYTE set, BYTE c
     size_t end = ((size_t)addr + size + page_mask) >> page_shift;
 
 #ifdef _WIN64
-    for ( ; idx < end; idx++)
+    while (idx < end)
     {
-        BYTE *ptr = pages_vprot[idx >> pages_vprot_shift] + (idx & pages_vprot_mask);
-        *ptr = (*ptr & ~clear) | set;
+        size_t i = idx >> pages_vprot_shift;
+        size_t dir_size = min( pages_vprot_mask + 1 - (idx & pages_vprot_mask), end - idx );
+        BYTE *ptr, *dir = pages_vprot[i];
+        size_t j;
+
+        if (is_uniform_vprot_dir( dir ))
+        {
+            BYTE vprot = (*dir & ~clear) | set;
+
+            if (vprot == *dir) ;
+            else if (dir_size == pages_vprot_mask + 1 && set_uniform_vprot_dir( i, vprot )) ;
+            else memset( get_private_vprot_dir( i ) + (idx & pages_vprot_mask), vprot, dir_size );
+        }
+        else
+        {
+            ptr = get_private_vprot_dir( i ) + (idx & pages_vprot_mask);
+            for (j = 0; j < dir_size; j++) ptr[j] = (ptr[j] & ~clear) | set;
+        }
+        idx += dir_size;
     }
 #else
     for ( ; idx < end; idx++) pages_vprot[idx] = (pages_vprot[idx] & ~clear) | set;
@@ -858,7 +989,18 @@ static BOOL alloc_pages_vprot( const void *addr, size_t size )
     for (i = idx >> pages_vprot_shift; i < (end + pages_vprot_mask) >> pages_vprot_shift; i++)
     {
         if (pages_vprot[i]) continue;
-        if ((ptr = anon_mmap_alloc( pages_vprot_mask + 1, PROT_READ | PROT_WRITE )) == MAP_FAILED)
+        /* entries entirely covered by the range start out shared, they get set as a whole */
+        if (i << pages_vprot_shift >= idx && (i + 1) << pages_vprot_shift <= end)
+        {
+            if (!(pages_vprot[i] = get_uniform_vprot_dir( 0 ))) return FALSE;
+            continue;
+        }
+        if (pages_vprot_spare_count)
+        {
+            ptr = pages_vprot_spare[--pages_vprot_spare_count];
+            memset( ptr, 0, pages_vprot_mask + 1 );
+        }
+        else if ((ptr = anon_mmap_alloc( pages_vprot_mask + 1, PROT_READ | PROT_WRITE )) == MAP_FAILED)
             return FALSE;
         pages_vprot[i] = ptr;
     }
@@ -913,7 +1055,7 @@ static int get_unix_prot( BYTE vprot )
         if (vprot & VPROT_WRITE) prot |= PROT_WRITE | PROT_READ;
         if (vprot & VPROT_WRITECOPY) prot |= PROT_WRITE | PROT_READ;
         if (vprot & VPROT_EXEC) prot |= PROT_EXEC | PROT_READ;
-        if (vprot & VPROT_WRITEWATCH) prot &= ~PROT_WRITE;
+        if ((vprot & VPROT_WRITEWATCH) && !use_kernel_write_watch) prot &= ~PROT_WRITE;
     }
     if (!prot) prot = PROT_NONE;
     return prot;
@@ -959,6 +1101,55 @@ static void dump_view( struct file_view *view )
 }
 
 
+/***********************************************************************
+ *           virtual_lock
+ *
+ * Get exclusive access to the views and page protections. Recursive.
+ * sigset is NULL when called from a signal handler.
+ */
+static void virtual_lock( sigset_t *sigset )
+{
+    if (sigset) pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+    mutex_lock( &virtual_mutex );
+    if (!virtual_lock_count++ && !process_exiting) pthread_rwlock_wrlock( &virtual_rwlock );
+}
+
+
+/***********************************************************************
+ *           virtual_unlock
+ */
+static void virtual_unlock( sigset_t *sigset )
+{
+    if (!--virtual_lock_count && !process_exiting) pthread_rwlock_unlock( &virtual_rwlock );
+    mutex_unlock( &virtual_mutex );
+    if (sigset) pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
+/***********************************************************************
+ *           virtual_lock_shared
+ *
+ * Get read-only access to the views and page protections, concurrently with other readers.
+ * This is not recursive, and the caller must neither modify anything nor touch client memory
+ * while holding it, since a fault would deadlock in virtual_handle_fault.
+ */
+static void virtual_lock_shared( sigset_t *sigset )
+{
+    pthread_sigmask( SIG_BLOCK, &server_block_set, sigset );
+    if (!process_exiting) pthread_rwlock_rdlock( &virtual_rwlock );
+}
+
+
+/***********************************************************************
+ *           virtual_unlock_shared
+ */
+static void virtual_unlock_shared( sigset_t *sigset )
+{
+    if (!process_exiting) pthread_rwlock_unlock( &virtual_rwlock );
+    pthread_sigmask( SIG_SETMASK, sigset, NULL );
+}
+
+
 /***********************************************************************
  *           VIRTUAL_Dump
  */
@@ -969,12 +1160,12 @@ static void VIRTUAL_Dump(void)
     struct file_view *view;
 
     TRACE( "Dump of all virtual memory views:\n" );
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     WINE_RB_FOR_EACH_ENTRY( view, &views_tree, struct file_view, entry )
     {
         dump_view( view );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 }
 #endif
 
@@ -1513,6 +1704,183 @@ static NTSTATUS set_protection( struct file_view *view, void *base, SIZE_T size,
 }
 
 
+#if defined(__linux__) && defined(HAVE_LINUX_USERFAULTFD_H) && defined(UFFDIO_WRITEPROTECT_MODE_WP) && defined(__NR_userfaultfd)
+
+/* kernel interfaces that may be missing from older headers */
+#ifndef UFFD_FEATURE_WP_UNPOPULATED
+#define UFFD_FEATURE_WP_UNPOPULATED (1 << 13)
+#endif
+#ifndef UFFD_FEATURE_WP_ASYNC
+#define UFFD_FEATURE_WP_ASYNC (1 << 15)
+#endif
+#ifndef PAGEMAP_SCAN
+#define PAGE_IS_WRITTEN       (1 << 1)
+#define PM_SCAN_WP_MATCHING   (1 << 0)
+#define PM_SCAN_CHECK_WPASYNC (1 << 1)
+struct page_region
+{
+    __u64 start;
+    __u64 end;
+    __u64 categories;
+};
+struct pm_scan_arg
+{
+    __u64 size;
+    __u64 flags;
+    __u64 start;
+    __u64 end;
+    __u64 walk_end;
+    __u64 vec;
+    __u64 vec_len;
+    __u64 max_pages;
+    __u64 category_inverted;
+    __u64 category_mask;
+    __u64 category_anyof_mask;
+    __u64 return_mask;
+};
+#define PAGEMAP_SCAN _IOWR('f', 16, struct pm_scan_arg)
+#endif
+
+static int uffd = -1;        /* userfaultfd in asynchronous write-protect mode */
+static int pagemap_fd = -1;  /* /proc/self/pagemap, to scan for written pages */
+
+/***********************************************************************
+ *           init_kernel_write_watch
+ *
+ * Check whether the kernel can track written pages without faulting, using userfaultfd
+ * asynchronous write-protection and PAGEMAP_SCAN. Called before the first write watch is created.
+ */
+static void init_kernel_write_watch(void)
+{
+    static BOOL init_done;
+    struct uffdio_api api = { .api = UFFD_API, .features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED };
+    struct pm_scan_arg scan = { .size = sizeof(scan), .flags = PM_SCAN_CHECK_WPASYNC };
+    const char *env;
+
+    if (init_done) return;
+    init_done = TRUE;
+
+    if ((env = getenv( "WINE_DISABLE_KERNEL_WRITEWATCH" )) && atoi( env )) return;
+    if ((uffd = syscall( __NR_userfaultfd, O_CLOEXEC | O_NONBLOCK )) == -1)
+    {
+#ifdef UFFD_USER_MODE_ONLY
+        /* unprivileged processes may only handle user mode faults, which is enough for asynchronous mode */
+        if (errno == EPERM) uffd = syscall( __NR_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY );
+#endif
+        if (uffd == -1) return;
+    }
+    if (ioctl( uffd, UFFDIO_API, &api ) == -1 ||
+        (api.features & (UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED)) !=
+        (UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED))
+        goto failed;
+    if ((pagemap_fd = open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC )) == -1) goto failed;
+    /* an empty scan fails if PAGEMAP_SCAN isn't supported */
+    if (ioctl( pagemap_fd, PAGEMAP_SCAN, &scan ) == -1) goto failed;
+
+    TRACE( "using kernel write watches\n" );
+    use_kernel_write_watch = TRUE;
+    return;
+
+failed:
+    WARN( "kernel write watches not supported\n" );
+    if (pagemap_fd != -1) close( pagemap_fd );
+    close( uffd );
+    pagemap_fd = uffd = -1;
+}
+
+
+/***********************************************************************
+ *           register_kernel_write_watch
+ *
+ * Start tracking the writes to a newly mapped range.
+ */
+static BOOL register_kernel_write_watch( void *base, size_t size )
+{
+    struct uffdio_register reg = { .range = { (UINT_PTR)base, size }, .mode = UFFDIO_REGISTER_MODE_WP };
+    struct uffdio_writeprotect wp = { .range = { (UINT_PTR)base, size }, .mode = UFFDIO_WRITEPROTECT_MODE_WP };
+
+    if (ioctl( uffd, UFFDIO_REGISTER, &reg ) == -1 || ioctl( uffd, UFFDIO_WRITEPROTECT, &wp ) == -1)
+    {
+        ERR( "failed to register write watch for %p-%p: %s\n", base, (char *)base + size, strerror( errno ));
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           reset_kernel_write_watches
+ */
+static void reset_kernel_write_watches( void *base, size_t size )
+{
+    struct uffdio_writeprotect wp = { .range = { (UINT_PTR)base, size }, .mode = UFFDIO_WRITEPROTECT_MODE_WP };
+
+    if (ioctl( uffd, UFFDIO_WRITEPROTECT, &wp ) == -1)
+        ERR( "failed to reset write watch for %p-%p: %s\n", base, (char *)base + size, strerror( errno ));
+}
+
+
+/***********************************************************************
+ *           get_kernel_write_watches
+ *
+ * Retrieve the written pages of a range, optionally write-protecting them again atomically.
+ */
+static void get_kernel_write_watches( char *base, size_t size, void **addresses, ULONG_PTR *count, BOOL reset )
+{
+    struct page_region regions[64];
+    struct pm_scan_arg scan = { .size = sizeof(scan) };
+    char *addr = base, *end = base + size;
+    ULONG_PTR pos = 0;
+    int i, ret;
+
+    while (pos < *count && addr < end)
+    {
+        scan.flags = reset ? PM_SCAN_WP_MATCHING | PM_SCAN_CHECK_WPASYNC : 0;
+        scan.start = (UINT_PTR)addr;
+        scan.end = (UINT_PTR)end;
+        scan.vec = (UINT_PTR)regions;
+        scan.vec_len = ARRAY_SIZE(regions);
+        scan.max_pages = *count - pos;
+        scan.category_mask = scan.return_mask = PAGE_IS_WRITTEN;
+        if ((ret = ioctl( pagemap_fd, PAGEMAP_SCAN, &scan )) == -1)
+        {
+            ERR( "failed to scan %p-%p: %s\n", addr, end, strerror( errno ));
+            break;
+        }
+        for (i = 0; i < ret; i++)
+        {
+            UINT_PTR page;
+            for (page = regions[i].start; page < regions[i].end && pos < *count; page += page_size)
+                addresses[pos++] = (void *)page;
+        }
+        addr = (char *)(UINT_PTR)scan.walk_end;
+    }
+    *count = pos;
+}
+
+#else  /* __linux__ */
+
+static void init_kernel_write_watch(void)
+{
+}
+
+static BOOL register_kernel_write_watch( void *base, size_t size )
+{
+    return FALSE;
+}
+
+static void reset_kernel_write_watches( void *base, size_t size )
+{
+}
+
+static void get_kernel_write_watches( char *base, size_t size, void **addresses, ULONG_PTR *count, BOOL reset )
+{
+    *count = 0;
+}
+
+#endif  /* __linux__ */
+
+
 /***********************************************************************
  *           update_write_watches
  */
@@ -1533,6 +1901,11 @@ static void update_write_watches( void *base, size_t size, size_t accessed_size
  */
 static void reset_write_watches( void *base, SIZE_T size )
 {
+    if (use_kernel_write_watch)
+    {
+        reset_kernel_write_watches( base, size );
+        return;
+    }
     set_page_vprot_bits( base, size, VPROT_WRITEWATCH, 0 );
     mprotect_range( base, size, 0, 0 );
 }
@@ -1910,6 +2283,46 @@ static NTSTATUS map_view( struct file_view **view_ret, void *base, size_t size,
 }
 
 
+/***********************************************************************
+ *           advise_large_pages
+ *
+ * Ask the kernel to back a range with transparent huge pages.
+ */
+static void advise_large_pages( void *base, size_t size )
+{
+#ifdef MADV_HUGEPAGE
+    if (madvise( base, size, MADV_HUGEPAGE ) == -1)
+        WARN( "failed to use huge pages for %p-%p: %s\n", base, (char *)base + size, strerror(errno) );
+#endif
+}
+
+
+/***********************************************************************
+ *           map_large_page_view
+ *
+ * Create a view aligned to the large page size, backed by huge pages when possible.
+ * virtual_mutex must be held by caller.
+ */
+static NTSTATUS map_large_page_view( struct file_view **view_ret, void *base, size_t size,
+                                     int top_down, unsigned int vprot, unsigned short zero_bits_64 )
+{
+    size_t mask = user_shared_data->LargePageMinimum - 1;
+    struct file_view *view;
+    NTSTATUS status;
+
+    if (!base)
+    {
+        /* find room for an aligned range, then map the view at its aligned start */
+        if ((status = map_view( &view, NULL, size + mask, top_down, vprot, zero_bits_64 ))) return status;
+        base = ROUND_ADDR( (char *)view->base + mask, mask );
+        delete_view( view );
+    }
+    if ((status = map_view( view_ret, base, size, top_down, vprot, zero_bits_64 ))) return status;
+    advise_large_pages( base, size );
+    return STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *           map_file_into_view
  *
@@ -2031,6 +2444,9 @@ static NTSTATUS decommit_pages( struct file_view *view, size_t start, size_t siz
 {
     if (anon_mmap_fixed( (char *)view->base + start, size, PROT_NONE, 0 ) != MAP_FAILED)
     {
+        /* the new mapping isn't registered for write watches */
+        if (use_kernel_write_watch && (view->protect & VPROT_WRITEWATCH))
+            register_kernel_write_watch( (char *)view->base + start, size );
         set_page_vprot_bits( (char *)view->base + start, size, 0, VPROT_COMMITTED );
         return STATUS_SUCCESS;
     }
@@ -2126,6 +2542,131 @@ static NTSTATUS map_pe_header( void *ptr, size_t size, int fd, BOOL *removable )
 }
 
 
+struct perf_map_symbol
+{
+    DWORD       rva;
+    const char *name;
+};
+
+static int perf_map_symbol_compare( const void *p1, const void *p2 )
+{
+    const struct perf_map_symbol *sym1 = p1, *sym2 = p2;
+
+    if (sym1->rva < sym2->rva) return -1;
+    return sym1->rva > sym2->rva;
+}
+
+/***********************************************************************
+ *           perf_map_add_image
+ *
+ * Append the exports of a newly mapped PE image to /tmp/perf-<pid>.map,
+ * so that host profilers can symbolize code running inside it.
+ * Enabled by setting WINEPERFMAP=1.
+ * virtual_mutex must be held by caller.
+ */
+static void perf_map_add_image( const struct file_view *view )
+{
+    static int perf_map_fd = -2;
+    const char *base = view->base;
+    const IMAGE_DOS_HEADER *dos = (const IMAGE_DOS_HEADER *)base;
+    const IMAGE_NT_HEADERS *nt;
+    const IMAGE_DATA_DIRECTORY *dir;
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    const IMAGE_SECTION_HEADER *sec;
+    const DWORD *functions, *names;
+    const WORD *ordinals;
+    struct perf_map_symbol *symbols;
+    const char *module;
+    DWORD i, j, count = 0, end;
+    char buffer[1024];
+    int len;
+
+    if (perf_map_fd == -2)
+    {
+        const char *env = getenv( "WINEPERFMAP" );
+
+        perf_map_fd = -1;
+        if (env && atoi( env ))
+        {
+            snprintf( buffer, sizeof(buffer), "/tmp/perf-%d.map", (int)getpid() );
+            perf_map_fd = open( buffer, O_WRONLY | O_CREAT | O_APPEND, 0644 );
+            if (perf_map_fd == -1) WARN( "failed to create %s, errno %d\n", buffer, errno );
+            else fcntl( perf_map_fd, F_SETFD, FD_CLOEXEC );
+        }
+    }
+    if (perf_map_fd == -1) return;
+
+    nt = (const IMAGE_NT_HEADERS *)(base + dos->e_lfanew);
+    if (nt->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC)
+    {
+        const IMAGE_NT_HEADERS64 *nt64 = (const IMAGE_NT_HEADERS64 *)nt;
+        if (nt64->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT) return;
+        dir = &nt64->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+    }
+    else
+    {
+        const IMAGE_NT_HEADERS32 *nt32 = (const IMAGE_NT_HEADERS32 *)nt;
+        if (nt32->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT) return;
+        dir = &nt32->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+    }
+    if (!dir->VirtualAddress || dir->Size < sizeof(*exports)) return;
+    if (dir->VirtualAddress >= view->size || dir->Size > view->size - dir->VirtualAddress) return;
+    if (!(get_page_vprot( base + dir->VirtualAddress ) & VPROT_READ)) return;
+
+    exports   = (const IMAGE_EXPORT_DIRECTORY *)(base + dir->VirtualAddress);
+    if (exports->AddressOfFunctions >= view->size || exports->AddressOfNames >= view->size ||
+        exports->AddressOfNameOrdinals >= view->size || exports->Name >= view->size)
+        return;
+    if (exports->NumberOfFunctions > (view->size - exports->AddressOfFunctions) / sizeof(DWORD) ||
+        exports->NumberOfNames > (view->size - exports->AddressOfNames) / sizeof(DWORD) ||
+        exports->NumberOfNames > (view->size - exports->AddressOfNameOrdinals) / sizeof(WORD))
+        return;
+    functions = (const DWORD *)(base + exports->AddressOfFunctions);
+    names     = (const DWORD *)(base + exports->AddressOfNames);
+    ordinals  = (const WORD *)(base + exports->AddressOfNameOrdinals);
+    module    = base + exports->Name;
+
+    if (!exports->NumberOfNames) return;
+    if (!(symbols = malloc( exports->NumberOfNames * sizeof(*symbols) ))) return;
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        DWORD rva;
+
+        if (ordinals[i] >= exports->NumberOfFunctions || names[i] >= view->size) continue;
+        rva = functions[ordinals[i]];
+        if (!rva || rva >= view->size) continue;
+        /* skip forwarded exports, they point to a string in the export directory */
+        if (rva >= dir->VirtualAddress && rva < dir->VirtualAddress + dir->Size) continue;
+        symbols[count].rva  = rva;
+        symbols[count].name = base + names[i];
+        count++;
+    }
+    qsort( symbols, count, sizeof(*symbols), perf_map_symbol_compare );
+
+    sec = IMAGE_FIRST_SECTION( nt );
+    for (i = 0; i < count; i++)
+    {
+        /* a symbol extends to the next export, or to the end of its section */
+        end = view->size;
+        for (j = 0; j < nt->FileHeader.NumberOfSections; j++)
+        {
+            if (symbols[i].rva < sec[j].VirtualAddress) continue;
+            if (symbols[i].rva - sec[j].VirtualAddress >= sec[j].Misc.VirtualSize) continue;
+            end = sec[j].VirtualAddress + sec[j].Misc.VirtualSize;
+            break;
+        }
+        if (i + 1 < count && symbols[i + 1].rva < end) end = symbols[i + 1].rva;
+        if (end == symbols[i].rva) continue;  /* aliases of the next symbol */
+
+        len = snprintf( buffer, sizeof(buffer), "%lx %x %.256s!%.512s\n",
+                        (unsigned long)(base + symbols[i].rva), end - symbols[i].rva, module, symbols[i].name );
+        if (len > 0) write( perf_map_fd, buffer, len );
+    }
+    free( symbols );
+}
+
+
 /***********************************************************************
  *           map_image_into_view
  *
@@ -2399,7 +2940,7 @@ static NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, unsigned sh
     }
 
     res = STATUS_INVALID_PARAMETER;
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     if (sec_flags & SEC_IMAGE)
     {
@@ -2452,6 +2993,7 @@ static NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, unsigned sh
         res = map_file_into_view( view, unix_handle, 0, size, offset.QuadPart, vprot, needs_close );
         if (res) ERR( "mapping %p %lx %x%08x failed\n",
                       view->base, size, offset.u.HighPart, offset.u.LowPart );
+        else if (sec_flags & SEC_LARGE_PAGES) advise_large_pages( view->base, size );
     }
 
     if (res == STATUS_SUCCESS)
@@ -2470,6 +3012,7 @@ static NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, unsigned sh
 
     if (res >= 0)
     {
+        if (sec_flags & SEC_IMAGE) perf_map_add_image( view );
         *addr_ptr = view->base;
         *size_ptr = size;
         VIRTUAL_DEBUG_DUMP_VIEW( view );
@@ -2477,7 +3020,7 @@ static NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, unsigned sh
     else delete_view( view );
 
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     if (needs_close) close( unix_handle );
     if (shared_needs_close) close( shared_fd );
     if (shared_file) NtClose( shared_file );
@@ -2514,12 +3057,21 @@ void virtual_init(void)
     size_t size;
     int i;
     pthread_mutexattr_t attr;
+    pthread_rwlockattr_t rwattr;
 
     pthread_mutexattr_init( &attr );
     pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
     pthread_mutex_init( &virtual_mutex, &attr );
     pthread_mutexattr_destroy( &attr );
 
+    pthread_rwlockattr_init( &rwattr );
+#ifdef __GLIBC__
+    /* readers don't recurse, so don't let a stream of queries starve the writers */
+    pthread_rwlockattr_setkind_np( &rwattr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP );
+#endif
+    pthread_rwlock_init( &virtual_rwlock, &rwattr );
+    pthread_rwlockattr_destroy( &rwattr );
+
     if (preload_info && *preload_info)
         for (i = 0; (*preload_info)[i].size; i++)
             mmap_add_reserved_area( (*preload_info)[i].addr, (*preload_info)[i].size );
@@ -2629,7 +3181,7 @@ NTSTATUS virtual_create_builtin_view( void *module, const UNICODE_STRING *nt_nam
     void *base = wine_server_get_ptr( info->base );
     int i;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     status = create_view( &view, base, size, SEC_IMAGE | SEC_FILE | VPROT_SYSTEM |
                           VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY | VPROT_EXEC );
     if (!status)
@@ -2667,7 +3219,7 @@ NTSTATUS virtual_create_builtin_view( void *module, const UNICODE_STRING *nt_nam
         }
         else delete_view( view );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 
     return status;
 }
@@ -2757,7 +3309,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
     NTSTATUS status = STATUS_SUCCESS;
     SIZE_T block_size = signal_stack_mask + 1;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if (next_free_teb)
     {
         ptr = next_free_teb;
@@ -2773,7 +3325,7 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
             if ((status = NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, 0, &total,
                                                    MEM_RESERVE, PAGE_READWRITE )))
             {
-                server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+                virtual_unlock( &sigset );
                 return status;
             }
             teb_block = ptr;
@@ -2785,14 +3337,14 @@ NTSTATUS virtual_alloc_teb( TEB **ret_teb )
     }
     *ret_teb = teb = (TEB *)((char *)ptr + teb_offset);
     init_teb( teb, NtCurrentTeb()->Peb );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 
     if ((status = signal_alloc_thread( teb )))
     {
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_lock( &sigset );
         *(void **)ptr = next_free_teb;
         next_free_teb = ptr;
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_unlock( &sigset );
     }
     return status;
 }
@@ -2820,12 +3372,12 @@ void virtual_free_teb( TEB *teb )
         NtFreeVirtualMemory( GetCurrentProcess(), &thread_data->start_stack, &size, MEM_RELEASE );
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     list_remove( &thread_data->entry );
     ptr = (char *)teb - teb_offset;
     *(void **)ptr = next_free_teb;
     next_free_teb = ptr;
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 }
 
 
@@ -2839,13 +3391,13 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
 
     if (index < TLS_MINIMUM_AVAILABLE)
     {
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_lock( &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
             teb->TlsSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_unlock( &sigset );
     }
     else
     {
@@ -2853,13 +3405,13 @@ NTSTATUS virtual_clear_tls_index( ULONG index )
         if (index >= 8 * sizeof(NtCurrentTeb()->Peb->TlsExpansionBitmapBits))
             return STATUS_INVALID_PARAMETER;
 
-        server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_lock( &sigset );
         LIST_FOR_EACH_ENTRY( thread_data, &teb_list, struct ntdll_thread_data, entry )
         {
             TEB *teb = CONTAINING_RECORD( thread_data, TEB, GdiTebBatch );
             if (teb->TlsExpansionSlots) teb->TlsExpansionSlots[index] = 0;
         }
-        server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+        virtual_unlock( &sigset );
     }
     return STATUS_SUCCESS;
 }
@@ -2888,7 +3440,7 @@ NTSTATUS virtual_alloc_thread_stack( INITIAL_TEB *stack, SIZE_T reserve_size, SI
     size = (size + 0xffff) & ~0xffff;  /* round to 64K boundary */
     if (pthread_size) *pthread_size = extra_size = max( page_size, ROUND_SIZE( 0, *pthread_size ));
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     if ((status = map_view( &view, NULL, size + extra_size, FALSE,
                             VPROT_READ | VPROT_WRITE | VPROT_COMMITTED, 0 )) != STATUS_SUCCESS)
@@ -2929,7 +3481,7 @@ NTSTATUS virtual_alloc_thread_stack( INITIAL_TEB *stack, SIZE_T reserve_size, SI
     stack->StackBase = (char *)view->base + view->size;
     stack->StackLimit = (char *)view->base + 2 * page_size;
 done:
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return status;
 }
 
@@ -3009,7 +3561,7 @@ NTSTATUS virtual_handle_fault( void *addr, DWORD err, void *stack )
     char *page = ROUND_ADDR( addr, page_mask );
     BYTE vprot;
 
-    mutex_lock( &virtual_mutex );  /* no need for signal masking inside signal handler */
+    virtual_lock( NULL );  /* no need for signal masking inside signal handler */
     vprot = get_page_vprot( page );
     if (!is_inside_signal_stack( stack ) && (vprot & VPROT_GUARD))
     {
@@ -3024,7 +3576,7 @@ NTSTATUS virtual_handle_fault( void *addr, DWORD err, void *stack )
     }
     else if (err & EXCEPTION_WRITE_FAULT)
     {
-        if (vprot & VPROT_WRITEWATCH)
+        if ((vprot & VPROT_WRITEWATCH) && !use_kernel_write_watch)
         {
             set_page_vprot_bits( page, page_size, 0, VPROT_WRITEWATCH );
             mprotect_range( page, page_size, 0, 0 );
@@ -3051,7 +3603,7 @@ NTSTATUS virtual_handle_fault( void *addr, DWORD err, void *stack )
         else
             set_page_vprot_bits( page, page_size, 0, VPROT_READ | VPROT_EXEC );
     }
-    mutex_unlock( &virtual_mutex );
+    virtual_unlock( NULL );
     return ret;
 }
 
@@ -3094,13 +3646,13 @@ void *virtual_setup_exception( void *stack_ptr, size_t size, EXCEPTION_RECORD *r
     }
     else if (stack < (char *)NtCurrentTeb()->Tib.StackLimit)
     {
-        mutex_lock( &virtual_mutex );  /* no need for signal masking inside signal handler */
+        virtual_lock( NULL );  /* no need for signal masking inside signal handler */
         if ((get_page_vprot( stack ) & VPROT_GUARD) && grow_thread_stack( ROUND_ADDR( stack, page_mask )))
         {
             rec->ExceptionCode = STATUS_STACK_OVERFLOW;
             rec->NumberParameters = 0;
         }
-        mutex_unlock( &virtual_mutex );
+        virtual_unlock( NULL );
     }
 #if defined(VALGRIND_MAKE_MEM_UNDEFINED)
     VALGRIND_MAKE_MEM_UNDEFINED( stack, size );
@@ -3125,7 +3677,7 @@ static NTSTATUS check_write_access( void *base, size_t size, BOOL *has_write_wat
     for (i = 0; i < size; i += page_size)
     {
         BYTE vprot = get_page_vprot( addr + i );
-        if (vprot & VPROT_WRITEWATCH) *has_write_watch = TRUE;
+        if ((vprot & VPROT_WRITEWATCH) && !use_kernel_write_watch) *has_write_watch = TRUE;
         if (!(get_unix_prot( vprot & ~VPROT_WRITEWATCH ) & PROT_WRITE))
             return STATUS_INVALID_USER_BUFFER;
     }
@@ -3149,14 +3701,14 @@ unsigned int virtual_locked_server_call( void *req_ptr )
 
     if (!size) return wine_server_call( req_ptr );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         ret = server_call_unlocked( req );
         if (has_write_watch) update_write_watches( addr, size, wine_server_reply_size( req ));
     }
     else memset( &req->u.reply, 0, sizeof(req->u.reply) );
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return ret;
 }
 
@@ -3173,14 +3725,14 @@ ssize_t virtual_locked_read( int fd, void *addr, size_t size )
     ssize_t ret = read( fd, addr, size );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = read( fd, addr, size );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     errno = err;
     return ret;
 }
@@ -3198,14 +3750,14 @@ ssize_t virtual_locked_pread( int fd, void *addr, size_t size, off_t offset )
     ssize_t ret = pread( fd, addr, size, offset );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if (!check_write_access( addr, size, &has_write_watch ))
     {
         ret = pread( fd, addr, size, offset );
         err = errno;
         if (has_write_watch) update_write_watches( addr, size, max( 0, ret ));
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     errno = err;
     return ret;
 }
@@ -3224,7 +3776,7 @@ ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     ssize_t ret = recvmsg( fd, hdr, flags );
     if (ret != -1 || errno != EFAULT) return ret;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     for (i = 0; i < hdr->msg_iovlen; i++)
         if (check_write_access( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, &has_write_watch ))
             break;
@@ -3236,7 +3788,7 @@ ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags )
     if (has_write_watch)
         while (i--) update_write_watches( hdr->msg_iov[i].iov_base, hdr->msg_iov[i].iov_len, 0 );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     errno = err;
     return ret;
 }
@@ -3251,10 +3803,10 @@ BOOL virtual_is_valid_code_address( const void *addr, SIZE_T size )
     BOOL ret = FALSE;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if ((view = find_view( addr, size )))
         ret = !(view->protect & VPROT_SYSTEM);  /* system views are not visible to the app */
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return ret;
 }
 
@@ -3341,7 +3893,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
 
     if (!size) return 0;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if ((view = find_view( addr, size )))
     {
         if (!(view->protect & VPROT_SYSTEM))
@@ -3357,7 +3909,7 @@ SIZE_T virtual_uninterrupted_read_memory( const void *addr, void *buffer, SIZE_T
             }
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return bytes_read;
 }
 
@@ -3377,13 +3929,13 @@ NTSTATUS virtual_uninterrupted_write_memory( void *addr, const void *buffer, SIZ
 
     if (!size) return STATUS_SUCCESS;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if (!(ret = check_write_access( addr, size, &has_write_watch )))
     {
         memcpy( addr, buffer, size );
         if (has_write_watch) update_write_watches( addr, size, size );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return ret;
 }
 
@@ -3398,7 +3950,7 @@ void virtual_set_force_exec( BOOL enable )
     struct file_view *view;
     sigset_t sigset;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if (!force_exec_prot != !enable)  /* change all existing views */
     {
         force_exec_prot = enable;
@@ -3416,7 +3968,7 @@ void virtual_set_force_exec( BOOL enable )
             mprotect_range( view->base, view->size, commit, 0 );
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 }
 
 struct free_range
@@ -3454,7 +4006,7 @@ void CDECL virtual_release_address_space(void)
 
     if (is_win64) return;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     range.base  = (char *)0x82000000;
     range.limit = user_space_limit;
@@ -3478,7 +4030,7 @@ void CDECL virtual_release_address_space(void)
         while (mmap_enum_reserved_areas( free_reserved_memory, &range, 0 )) /* nothing */;
     }
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 }
 
 
@@ -3589,35 +4141,66 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR z
     /* Compute the alloc type flags */
 
     if (!(type & (MEM_COMMIT | MEM_RESERVE | MEM_RESET)) ||
-        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET)))
+        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET | MEM_LARGE_PAGES)))
     {
         WARN("called with wrong alloc type flags (%08x) !\n", type);
         return STATUS_INVALID_PARAMETER;
     }
 
+    if (type & MEM_LARGE_PAGES)
+    {
+        SIZE_T large_page_mask = user_shared_data->LargePageMinimum - 1;
+
+        /* large pages have to be reserved and committed at once, in whole large pages */
+        if (!user_shared_data->LargePageMinimum ||
+            (type & (MEM_COMMIT | MEM_RESERVE | MEM_WRITE_WATCH)) != (MEM_COMMIT | MEM_RESERVE) ||
+            ((UINT_PTR)base & large_page_mask) || (size & large_page_mask))
+        {
+            WARN("invalid large page allocation %p %08lx type %08x\n", base, size, type);
+            return STATUS_INVALID_PARAMETER;
+        }
+    }
+
     /* Reserve the memory */
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     if ((type & MEM_RESERVE) || !base)
     {
         if (!(status = get_vprot_flags( protect, &vprot, FALSE )))
         {
             if (type & MEM_COMMIT) vprot |= VPROT_COMMITTED;
-            if (type & MEM_WRITE_WATCH) vprot |= VPROT_WRITEWATCH;
+            if (type & MEM_WRITE_WATCH)
+            {
+                init_kernel_write_watch();
+                vprot |= VPROT_WRITEWATCH;
+            }
             if (protect & PAGE_NOCACHE) vprot |= SEC_NOCACHE;
 
             if (vprot & VPROT_WRITECOPY) status = STATUS_INVALID_PAGE_PROTECTION;
             else if (is_dos_memory) status = allocate_dos_memory( &view, vprot );
+            else if (type & MEM_LARGE_PAGES)
+                status = map_large_page_view( &view, base, size, type & MEM_TOP_DOWN, vprot, zero_bits_64 );
             else status = map_view( &view, base, size, type & MEM_TOP_DOWN, vprot, zero_bits_64 );
 
+            if (status == STATUS_SUCCESS && use_kernel_write_watch && (vprot & VPROT_WRITEWATCH) &&
+                !register_kernel_write_watch( view->base, view->size ))
+            {
+                delete_view( view );
+                status = STATUS_NO_MEMORY;
+            }
             if (status == STATUS_SUCCESS) base = view->base;
         }
     }
     else if (type & MEM_RESET)
     {
         if (!(view = find_view( base, size ))) status = STATUS_NOT_MAPPED_VIEW;
+#ifdef MADV_FREE
+        /* let the kernel reclaim the pages lazily, falling back for kernels that don't support it */
+        else if (madvise( base, size, MADV_FREE ) == -1 && errno == EINVAL) madvise( base, size, MADV_DONTNEED );
+#else
         else madvise( base, size, MADV_DONTNEED );
+#endif
     }
     else  /* commit the pages */
     {
@@ -3638,7 +4221,7 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR z
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -3648,6 +4231,33 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG_PTR z
     return status;
 }
 
+/***********************************************************************
+ *           set_preferred_node
+ *
+ * Make the pages of a range get allocated on a given NUMA node when possible.
+ */
+static void set_preferred_node( void *addr, SIZE_T size, ULONG node )
+{
+#if defined(__linux__) && defined(__NR_mbind)
+    static const int mpol_preferred = 1;  /* MPOL_PREFERRED from linux/mempolicy.h */
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))];
+
+    if (node >= sizeof(mask) * 8)
+    {
+        WARN( "invalid node %u\n", node );
+        return;
+    }
+    memset( mask, 0, sizeof(mask) );
+    mask[node / (8 * sizeof(mask[0]))] = 1ul << (node % (8 * sizeof(mask[0])));
+    /* the kernel ignores the last bit of maxnode */
+    if (syscall( __NR_mbind, addr, size, mpol_preferred, mask, sizeof(mask) * 8 + 1, 0 ))
+        WARN( "failed to bind %p-%p to node %u: %s\n", addr, (char *)addr + size, node, strerror(errno) );
+#else
+    FIXME( "Ignoring preferred node %u\n", node );
+#endif
+}
+
+
 /***********************************************************************
  *             NtAllocateVirtualMemoryEx   (NTDLL.@)
  *             ZwAllocateVirtualMemoryEx   (NTDLL.@)
@@ -3656,11 +4266,31 @@ NTSTATUS WINAPI NtAllocateVirtualMemoryEx( HANDLE process, PVOID *ret, SIZE_T *s
                                            ULONG protect, MEM_EXTENDED_PARAMETER *parameters,
                                            ULONG count )
 {
+    ULONG i, node = ~0u;
+    NTSTATUS status;
+
     if (count && !parameters) return STATUS_INVALID_PARAMETER;
 
-    if (count) FIXME( "Ignoring %d extended parameters %p\n", count, parameters );
+    for (i = 0; i < count; i++)
+    {
+        switch (parameters[i].Type)
+        {
+        case MemExtendedParameterNumaNode:
+            node = parameters[i].ULong;
+            break;
+        default:
+            FIXME( "Ignoring extended parameter type %u\n", (int)parameters[i].Type );
+            break;
+        }
+    }
 
-    return NtAllocateVirtualMemory( process, ret, 0, size_ptr, type, protect );
+    status = NtAllocateVirtualMemory( process, ret, 0, size_ptr, type, protect );
+    if (!status && node != ~0u)
+    {
+        if (process == NtCurrentProcess()) set_preferred_node( *ret, *size_ptr, node );
+        else FIXME( "Ignoring preferred node %u for process %p\n", node, process );
+    }
+    return status;
 }
 
 
@@ -3709,7 +4339,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
     /* avoid freeing the DOS area when a broken app passes a NULL pointer */
     if (!base) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     if (!(view = find_view( base, size )) || !is_view_valloc( view ))
     {
@@ -3742,7 +4372,7 @@ NTSTATUS WINAPI NtFreeVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T *si
         status = STATUS_INVALID_PARAMETER;
     }
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return status;
 }
 
@@ -3796,7 +4426,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
     size = ROUND_SIZE( addr, size );
     base = ROUND_ADDR( addr, page_mask );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     if ((view = find_view( base, size )))
     {
@@ -3830,7 +4460,7 @@ NTSTATUS WINAPI NtProtectVirtualMemory( HANDLE process, PVOID *addr_ptr, SIZE_T
 
     if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 
     if (status == STATUS_SUCCESS)
     {
@@ -3878,55 +4508,14 @@ static int CDECL get_free_mem_state_callback( void *start, SIZE_T size, void *ar
     return 1;
 }
 
-/* get basic information about a memory block */
-static NTSTATUS get_basic_memory_info( HANDLE process, LPCVOID addr,
-                                       MEMORY_BASIC_INFORMATION *info,
-                                       SIZE_T len, SIZE_T *res_len )
+/* fill the information about a block of the current process; the virtual lock must be held by caller,
+ * either shared, in which case this fails when exclusive access is needed, or exclusively */
+static BOOL fill_basic_memory_info( char *base, MEMORY_BASIC_INFORMATION *info, BOOL exclusive )
 {
     struct file_view *view;
-    char *base, *alloc_base = 0, *alloc_end = working_set_limit;
+    char *alloc_base = 0, *alloc_end = working_set_limit;
     struct wine_rb_entry *ptr;
-    sigset_t sigset;
 
-    if (len < sizeof(MEMORY_BASIC_INFORMATION))
-        return STATUS_INFO_LENGTH_MISMATCH;
-
-    if (process != NtCurrentProcess())
-    {
-        NTSTATUS status;
-        apc_call_t call;
-        apc_result_t result;
-
-        memset( &call, 0, sizeof(call) );
-
-        call.virtual_query.type = APC_VIRTUAL_QUERY;
-        call.virtual_query.addr = wine_server_client_ptr( addr );
-        status = server_queue_process_apc( process, &call, &result );
-        if (status != STATUS_SUCCESS) return status;
-
-        if (result.virtual_query.status == STATUS_SUCCESS)
-        {
-            info->BaseAddress       = wine_server_get_ptr( result.virtual_query.base );
-            info->AllocationBase    = wine_server_get_ptr( result.virtual_query.alloc_base );
-            info->RegionSize        = result.virtual_query.size;
-            info->Protect           = result.virtual_query.prot;
-            info->AllocationProtect = result.virtual_query.alloc_prot;
-            info->State             = (DWORD)result.virtual_query.state << 12;
-            info->Type              = (DWORD)result.virtual_query.alloc_type << 16;
-            if (info->RegionSize != result.virtual_query.size)  /* truncated */
-                return STATUS_INVALID_PARAMETER;  /* FIXME */
-            if (res_len) *res_len = sizeof(*info);
-        }
-        return result.virtual_query.status;
-    }
-
-    base = ROUND_ADDR( addr, page_mask );
-
-    if (is_beyond_limit( base, 1, working_set_limit )) return STATUS_INVALID_PARAMETER;
-
-    /* Find the view containing the address */
-
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
     ptr = views_tree.root;
     while (ptr)
     {
@@ -3983,6 +4572,8 @@ static NTSTATUS get_basic_memory_info( HANDLE process, LPCVOID addr,
     {
         BYTE vprot;
 
+        /* committed ranges of SEC_RESERVE views are cached in the page protections */
+        if ((view->protect & SEC_RESERVE) && !exclusive) return FALSE;
         info->RegionSize = get_committed_size( view, base, &vprot, ~VPROT_WRITEWATCH );
         info->State = (vprot & VPROT_COMMITTED) ? MEM_COMMIT : MEM_RESERVE;
         info->Protect = (vprot & VPROT_COMMITTED) ? get_win32_prot( vprot, view->protect ) : 0;
@@ -3991,7 +4582,65 @@ static NTSTATUS get_basic_memory_info( HANDLE process, LPCVOID addr,
         else if (view->protect & (SEC_FILE | SEC_RESERVE | SEC_COMMIT)) info->Type = MEM_MAPPED;
         else info->Type = MEM_PRIVATE;
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    return TRUE;
+}
+
+/* get basic information about a memory block */
+static NTSTATUS get_basic_memory_info( HANDLE process, LPCVOID addr,
+                                       MEMORY_BASIC_INFORMATION *info,
+                                       SIZE_T len, SIZE_T *res_len )
+{
+    MEMORY_BASIC_INFORMATION mbi;
+    char *base;
+    sigset_t sigset;
+
+    if (len < sizeof(MEMORY_BASIC_INFORMATION))
+        return STATUS_INFO_LENGTH_MISMATCH;
+
+    if (process != NtCurrentProcess())
+    {
+        NTSTATUS status;
+        apc_call_t call;
+        apc_result_t result;
+
+        memset( &call, 0, sizeof(call) );
+
+        call.virtual_query.type = APC_VIRTUAL_QUERY;
+        call.virtual_query.addr = wine_server_client_ptr( addr );
+        status = server_queue_process_apc( process, &call, &result );
+        if (status != STATUS_SUCCESS) return status;
+
+        if (result.virtual_query.status == STATUS_SUCCESS)
+        {
+            info->BaseAddress       = wine_server_get_ptr( result.virtual_query.base );
+            info->AllocationBase    = wine_server_get_ptr( result.virtual_query.alloc_base );
+            info->RegionSize        = result.virtual_query.size;
+            info->Protect           = result.virtual_query.prot;
+            info->AllocationProtect = result.virtual_query.alloc_prot;
+            info->State             = (DWORD)result.virtual_query.state << 12;
+            info->Type              = (DWORD)result.virtual_query.alloc_type << 16;
+            if (info->RegionSize != result.virtual_query.size)  /* truncated */
+                return STATUS_INVALID_PARAMETER;  /* FIXME */
+            if (res_len) *res_len = sizeof(*info);
+        }
+        return result.virtual_query.status;
+    }
+
+    base = ROUND_ADDR( addr, page_mask );
+
+    if (is_beyond_limit( base, 1, working_set_limit )) return STATUS_INVALID_PARAMETER;
+
+    /* fill a local copy, faulting on the client buffer must not happen with the lock held */
+    virtual_lock_shared( &sigset );
+    if (!fill_basic_memory_info( base, &mbi, FALSE ))
+    {
+        virtual_unlock_shared( &sigset );
+        virtual_lock( &sigset );
+        fill_basic_memory_info( base, &mbi, TRUE );
+        virtual_unlock( &sigset );
+    }
+    else virtual_unlock_shared( &sigset );
+    *info = mbi;
 
     if (res_len) *res_len = sizeof(*info);
     return STATUS_SUCCESS;
@@ -4018,7 +4667,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
         if (!once++) WARN( "unable to open /proc/self/pagemap\n" );
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     for (p = info; (UINT_PTR)(p + 1) <= (UINT_PTR)info + len; p++)
     {
         BYTE vprot;
@@ -4046,7 +4695,7 @@ static NTSTATUS get_working_set_ex( HANDLE process, LPCVOID addr,
                 p->VirtualAttributes.Win32Protection = get_win32_prot( vprot, view->protect );
         }
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
 
     if (f)
         fclose( f );
@@ -4375,7 +5024,7 @@ NTSTATUS WINAPI NtUnmapViewOfSection( HANDLE process, PVOID addr )
         return status;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if ((view = find_view( addr, 0 )) && !is_view_valloc( view ))
     {
         SERVER_START_REQ( unmap_view )
@@ -4387,7 +5036,7 @@ NTSTATUS WINAPI NtUnmapViewOfSection( HANDLE process, PVOID addr )
         if (!status) delete_view( view );
         else FIXME( "failed to unmap %p %x\n", view->base, status );
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return status;
 }
 
@@ -4513,7 +5162,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         return result.virtual_flush.status;
     }
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
     if (!(view = find_view( addr, *size_ptr ))) status = STATUS_INVALID_PARAMETER;
     else
     {
@@ -4523,7 +5172,7 @@ NTSTATUS WINAPI NtFlushVirtualMemory( HANDLE process, LPCVOID *addr_ptr,
         if (msync( addr, *size_ptr, MS_ASYNC )) status = STATUS_NOT_MAPPED_DATA;
 #endif
     }
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return status;
 }
 
@@ -4550,9 +5199,14 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     TRACE( "%p %x %p-%p %p %lu\n", process, flags, base, (char *)base + size,
            addresses, *count );
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
-    if (is_write_watch_range( base, size ))
+    if (is_write_watch_range( base, size ) && use_kernel_write_watch)
+    {
+        get_kernel_write_watches( base, size, addresses, count, flags & WRITE_WATCH_FLAG_RESET );
+        *granularity = page_size;
+    }
+    else if (is_write_watch_range( base, size ))
     {
         ULONG_PTR pos = 0;
         char *addr = base;
@@ -4569,7 +5223,7 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
     }
     else status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return status;
 }
 
@@ -4590,14 +5244,14 @@ NTSTATUS WINAPI NtResetWriteWatch( HANDLE process, PVOID base, SIZE_T size )
 
     if (!size) return STATUS_INVALID_PARAMETER;
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     if (is_write_watch_range( base, size ))
         reset_write_watches( base, size );
     else
         status = STATUS_INVALID_PARAMETER;
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return status;
 }
 
@@ -4718,7 +5372,7 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
 
     TRACE("%p %p\n", addr1, addr2);
 
-    server_enter_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_lock( &sigset );
 
     view1 = find_view( addr1, 0 );
     view2 = find_view( addr2, 0 );
@@ -4742,7 +5396,7 @@ NTSTATUS WINAPI NtAreMappedFilesTheSame(PVOID addr1, PVOID addr2)
         SERVER_END_REQ;
     }
 
-    server_leave_uninterrupted_section( &virtual_mutex, &sigset );
+    virtual_unlock( &sigset );
     return status;
 }
 
@@ -26,7 +26,7 @@
 struct _DISPATCHER_CONTEXT;
 
 /* increment this when you change the function table */
-#define NTDLL_UNIXLIB_VERSION 113
+#define NTDLL_UNIXLIB_VERSION 114
 
 struct unix_funcs
 {
@@ -96,6 +96,9 @@ struct unix_funcs
     void          (CDECL *steamclient_setup_trampolines)( HMODULE src_mod, HMODULE tgt_mod );
     void          (CDECL *set_unix_env)( const char *var, const char *val );
     void          (CDECL *write_crash_log)( const char *log_type, const char *log_msg );
+
+    /* fsync functions */
+    void *        (CDECL *fsync_get_shm_ptr)( unsigned int shm_idx );
 };
 
 #endif /* __NTDLL_UNIXLIB_H */
@@ -7256,6 +7256,31 @@ static HRESULT BlockChainStream_GetBlockAtOffset(BlockChainStream *This,
   return S_OK;
 }
 
+/* Count the blocks following index that live in the sectors directly after
+ * sector and are not held in the block cache, so they can be read together. */
+static ULONG BlockChainStream_GetContiguousBlocks(BlockChainStream *This,
+    ULONG index, ULONG sector, ULONG max_blocks)
+{
+  ULONG count = 0;
+  int i;
+
+  while (count < max_blocks)
+  {
+    ULONG next = index + count + 1;
+
+    if (BlockChainStream_GetSectorOfOffset(This, next) != sector + count + 1)
+      break;
+
+    for (i=0; i<2; i++)
+      if (This->cachedBlocks[i].index == next)
+        return count;
+
+    count++;
+  }
+
+  return count;
+}
+
 BlockChainStream* BlockChainStream_Construct(
   StorageImpl* parentStorage,
   ULONG*         headOfStreamPlaceHolder,
@@ -7653,7 +7678,16 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
 
     if (!cachedBlock)
     {
-      /* Not in cache, and we're going to read past the end of the block. */
+      ULONG extraBlocks;
+
+      /* Not in cache, and we're going to read past the end of the block.
+       * Read ahead through the following sectors of the run in one go, but
+       * leave the final block of the request to the block cache. */
+      extraBlocks = BlockChainStream_GetContiguousBlocks(This, blockNoInSequence, blockIndex,
+          (size - bytesToReadInBuffer - 1) / This->parentStorage->bigBlockSize);
+      bytesToReadInBuffer += extraBlocks * This->parentStorage->bigBlockSize;
+      blockNoInSequence   += extraBlocks;
+
       ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex) +
                                offsetInBlock;
 
@@ -2705,10 +2705,6 @@ static HRESULT WINAPI VMR9_ImagePresenter_PresentImage(IVMRImagePresenter9 *ifac
     if (!device)
         return S_OK;
 
-    if (FAILED(hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET,
-            D3DCOLOR_XRGB(0, 0, 0), 1.0f, 0)))
-        ERR("Failed to clear, hr %#x.\n", hr);
-
     if (FAILED(hr = IDirect3DDevice9_BeginScene(device)))
         ERR("Failed to begin scene, hr %#x.\n", hr);
 
@@ -2718,8 +2714,14 @@ static HRESULT WINAPI VMR9_ImagePresenter_PresentImage(IVMRImagePresenter9 *ifac
         return hr;
     }
 
+    /* The image covers the whole back buffer, so it only needs to be cleared
+     * if the blit fails. */
     if (FAILED(hr = IDirect3DDevice9_StretchRect(device, info->lpSurf, NULL, backbuffer, NULL, D3DTEXF_POINT)))
+    {
         ERR("Failed to blit image, hr %#x.\n", hr);
+        if (FAILED(hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET, D3DCOLOR_XRGB(0, 0, 0), 1.0f, 0)))
+            ERR("Failed to clear, hr %#x.\n", hr);
+    }
     IDirect3DSurface9_Release(backbuffer);
 
     if (FAILED(hr = IDirect3DDevice9_EndScene(device)))
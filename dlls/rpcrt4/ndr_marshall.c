@@ -6861,6 +6861,37 @@ static void WINAPI NdrBaseTypeBufferSize(
     }
 }
 
+/***********************************************************************
+ *           ndr_copy_buffer_size [internal]
+ *
+ * Buffer sizing for types whose wire format is their memory layout.
+ */
+void ndr_copy_buffer_size(PMIDL_STUB_MESSAGE pStubMsg, ULONG size, unsigned int align)
+{
+    align_length(&pStubMsg->BufferLength, align);
+    safe_buffer_length_increment(pStubMsg, size);
+}
+
+/***********************************************************************
+ *           ndr_copy_marshall [internal]
+ */
+void ndr_copy_marshall(PMIDL_STUB_MESSAGE pStubMsg, const unsigned char *pMemory,
+                       ULONG size, unsigned int align)
+{
+    align_pointer_clear(&pStubMsg->Buffer, align);
+    safe_copy_to_buffer(pStubMsg, pMemory, size);
+}
+
+/***********************************************************************
+ *           ndr_copy_unmarshall [internal]
+ */
+void ndr_copy_unmarshall(PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
+                         ULONG size, unsigned int align)
+{
+    align_pointer(&pStubMsg->Buffer, align);
+    safe_copy_from_buffer(pStubMsg, pMemory, size);
+}
+
 /***********************************************************************
  *           NdrBaseTypeMemorySize [internal]
  */
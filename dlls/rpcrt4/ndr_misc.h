@@ -64,4 +64,10 @@ extern const NDR_FREE       NdrFreer[] DECLSPEC_HIDDEN;
 
 ULONG ComplexStructSize(PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat) DECLSPEC_HIDDEN;
 
+void ndr_copy_buffer_size(PMIDL_STUB_MESSAGE pStubMsg, ULONG size, unsigned int align) DECLSPEC_HIDDEN;
+void ndr_copy_marshall(PMIDL_STUB_MESSAGE pStubMsg, const unsigned char *pMemory,
+                       ULONG size, unsigned int align) DECLSPEC_HIDDEN;
+void ndr_copy_unmarshall(PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
+                         ULONG size, unsigned int align) DECLSPEC_HIDDEN;
+
 #endif  /* __WINE_NDR_MISC_H */
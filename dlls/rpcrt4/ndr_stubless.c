@@ -477,16 +477,183 @@ static size_t basetype_arg_size( unsigned char fc )
     }
 }
 
+/* The parameter descriptions of a procedure never change, so the parameters
+ * whose wire format is their memory layout are found once per procedure and
+ * then sized, marshalled and unmarshalled with a plain copy. Plans are keyed
+ * on the contents of the parameter array, since old-style (-Oi) procedures
+ * convert their parameters into a temporary buffer on every call. */
+
+struct ndr_plan_step
+{
+    unsigned short size;   /* 0 if the type needs the format string interpreter */
+    unsigned char  align;
+    unsigned char  is_struct;
+};
+
+struct ndr_plan
+{
+    struct ndr_plan *next;
+    const unsigned char *format_types;
+    unsigned int hash;
+    unsigned short number_of_params;
+    const NDR_PARAM_OIF *params;
+    struct ndr_plan_step steps[1];
+};
+
+#define NDR_PLAN_HASH_SIZE 64
+
+static struct ndr_plan *ndr_plans[NDR_PLAN_HASH_SIZE];
+
+static void init_plan_step( struct ndr_plan_step *step, const NDR_PARAM_OIF *param,
+                            const unsigned char *format_types )
+{
+    PFORMAT_STRING pTypeFormat;
+
+    step->size = step->align = step->is_struct = 0;
+
+    if (param->attr.IsBasetype)
+    {
+        switch (param->u.type_format_char)
+        {
+        case FC_BYTE:
+        case FC_CHAR:
+        case FC_SMALL:
+        case FC_USMALL:
+            step->size = sizeof(UCHAR);
+            break;
+        case FC_WCHAR:
+        case FC_SHORT:
+        case FC_USHORT:
+            step->size = sizeof(USHORT);
+            break;
+        case FC_LONG:
+        case FC_ULONG:
+        case FC_ENUM32:
+        case FC_ERROR_STATUS_T:
+            step->size = sizeof(ULONG);
+            break;
+        case FC_FLOAT:
+            step->size = sizeof(float);
+            break;
+        case FC_HYPER:
+            step->size = sizeof(ULONGLONG);
+            break;
+        case FC_DOUBLE:
+            step->size = sizeof(double);
+            break;
+        default:
+            /* FC_ENUM16 and FC_[U]INT3264 change size on the wire */
+            return;
+        }
+        step->align = step->size;
+        return;
+    }
+
+    pTypeFormat = &format_types[param->u.type_offset];
+    if (*pTypeFormat == FC_STRUCT)
+    {
+        step->size = *(const WORD *)(pTypeFormat + 2);
+        step->align = pTypeFormat[1] + 1;
+        step->is_struct = TRUE;
+    }
+}
+
+static const struct ndr_plan *get_ndr_plan( const MIDL_STUB_MESSAGE *pStubMsg, const NDR_PARAM_OIF *params,
+                                            unsigned short number_of_params )
+{
+    const unsigned char *format_types = pStubMsg->StubDesc->pFormatTypes;
+    const unsigned char *data = (const unsigned char *)params;
+    size_t i, params_size = number_of_params * sizeof(*params);
+    unsigned int hash = number_of_params + (unsigned int)((ULONG_PTR)format_types >> 4);
+    struct ndr_plan *plan, *head, **bucket;
+
+    for (i = 0; i < params_size; i++) hash = hash * 31 + data[i];
+    bucket = &ndr_plans[hash % NDR_PLAN_HASH_SIZE];
+
+    for (plan = *bucket; plan; plan = plan->next)
+    {
+        if (plan->hash == hash && plan->format_types == format_types &&
+            plan->number_of_params == number_of_params && !memcmp( plan->params, params, params_size ))
+            return plan;
+    }
+
+    if (!(plan = HeapAlloc( GetProcessHeap(), 0,
+                            FIELD_OFFSET(struct ndr_plan, steps[number_of_params]) + params_size )))
+        return NULL;
+
+    plan->format_types = format_types;
+    plan->hash = hash;
+    plan->number_of_params = number_of_params;
+    plan->params = (const NDR_PARAM_OIF *)&plan->steps[number_of_params];
+    memcpy( (void *)plan->params, params, params_size );
+    for (i = 0; i < number_of_params; i++) init_plan_step( &plan->steps[i], &params[i], format_types );
+
+    /* racing threads may add the same plan twice, which is harmless */
+    do
+    {
+        head = *bucket;
+        plan->next = head;
+    } while (InterlockedCompareExchangePointer( (void **)bucket, plan, head ) != head);
+
+    return plan;
+}
+
+static inline void plan_buffer_sizer( PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
+                                      const NDR_PARAM_OIF *param, const struct ndr_plan_step *step )
+{
+    if (step && step->size)
+        ndr_copy_buffer_size( pStubMsg, step->size, step->align );
+    else
+        call_buffer_sizer( pStubMsg, pMemory, param );
+}
+
+static inline void plan_marshaller( PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
+                                    const NDR_PARAM_OIF *param, const struct ndr_plan_step *step )
+{
+    if (step && step->size)
+    {
+        if (param->attr.IsBasetype ? param->attr.IsSimpleRef : !param->attr.IsByValue)
+            pMemory = *(unsigned char **)pMemory;
+        ndr_copy_marshall( pStubMsg, pMemory, step->size, step->align );
+        if (step->is_struct) pStubMsg->BufferMark = pStubMsg->Buffer - step->size;
+    }
+    else
+        call_marshaller( pStubMsg, pMemory, param );
+}
+
+static inline void plan_unmarshaller( PMIDL_STUB_MESSAGE pStubMsg, unsigned char **ppMemory,
+                                      const NDR_PARAM_OIF *param, const struct ndr_plan_step *step )
+{
+    unsigned char *dest;
+
+    /* structures may have to be allocated, leave them to the interpreter */
+    if (step && step->size && !step->is_struct)
+    {
+        dest = param->attr.IsSimpleRef ? **(unsigned char ***)ppMemory : *ppMemory;
+        if (dest)
+        {
+            ndr_copy_unmarshall( pStubMsg, dest, step->size, step->align );
+            return;
+        }
+    }
+    call_unmarshaller( pStubMsg, ppMemory, param, 0 );
+}
+
 void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum stubless_phase phase,
                      void **fpu_args, unsigned short number_of_params, unsigned char *pRetVal )
 {
     const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
+    const struct ndr_plan *plan = NULL;
     unsigned int i;
 
+    if (phase == STUBLESS_CALCSIZE || phase == STUBLESS_MARSHAL || phase == STUBLESS_UNMARSHAL)
+        plan = get_ndr_plan( pStubMsg, params, number_of_params );
+
     for (i = 0; i < number_of_params; i++)
     {
         unsigned char *pArg = pStubMsg->StackTop + params[i].stack_offset;
         PFORMAT_STRING pTypeFormat = (PFORMAT_STRING)&pStubMsg->StubDesc->pFormatTypes[params[i].u.type_offset];
+        const struct ndr_plan_step *step = plan ? &plan->steps[i] : NULL;
 
 #ifdef __x86_64__  /* floats are passed as doubles through varargs functions */
         float f;
@@ -519,16 +686,16 @@ void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum s
         case STUBLESS_CALCSIZE:
             if (params[i].attr.IsSimpleRef && !*(unsigned char **)pArg)
                 RpcRaiseException(RPC_X_NULL_REF_POINTER);
-            if (params[i].attr.IsIn) call_buffer_sizer(pStubMsg, pArg, &params[i]);
+            if (params[i].attr.IsIn) plan_buffer_sizer(pStubMsg, pArg, &params[i], step);
             break;
         case STUBLESS_MARSHAL:
-            if (params[i].attr.IsIn) call_marshaller(pStubMsg, pArg, &params[i]);
+            if (params[i].attr.IsIn) plan_marshaller(pStubMsg, pArg, &params[i], step);
             break;
         case STUBLESS_UNMARSHAL:
             if (params[i].attr.IsOut)
             {
                 if (params[i].attr.IsReturn && pRetVal) pArg = pRetVal;
-                call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
+                plan_unmarshaller(pStubMsg, &pArg, &params[i], step);
             }
             break;
         case STUBLESS_FREE:
@@ -1218,13 +1385,18 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
                               unsigned short number_of_params)
 {
     const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
+    const struct ndr_plan *plan = NULL;
     unsigned int i;
     LONG_PTR *retval_ptr = NULL;
 
+    if (phase == STUBLESS_CALCSIZE || phase == STUBLESS_MARSHAL || phase == STUBLESS_UNMARSHAL)
+        plan = get_ndr_plan( pStubMsg, params, number_of_params );
+
     for (i = 0; i < number_of_params; i++)
     {
         unsigned char *pArg = pStubMsg->StackTop + params[i].stack_offset;
         const unsigned char *pTypeFormat = &pStubMsg->StubDesc->pFormatTypes[params[i].u.type_offset];
+        const struct ndr_plan_step *step = plan ? &plan->steps[i] : NULL;
 
         TRACE("param[%d]: %p -> %p type %02x %s\n", i,
               pArg, *(unsigned char **)pArg,
@@ -1235,7 +1407,7 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
         {
         case STUBLESS_MARSHAL:
             if (params[i].attr.IsOut || params[i].attr.IsReturn)
-                call_marshaller(pStubMsg, pArg, &params[i]);
+                plan_marshaller(pStubMsg, pArg, &params[i], step);
             break;
         case STUBLESS_MUSTFREE:
             if (params[i].attr.MustFree)
@@ -1281,11 +1453,11 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
                                            params[i].attr.ServerAllocSize * 8);
 
             if (params[i].attr.IsIn)
-                call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
+                plan_unmarshaller(pStubMsg, &pArg, &params[i], step);
             break;
         case STUBLESS_CALCSIZE:
             if (params[i].attr.IsOut || params[i].attr.IsReturn)
-                call_buffer_sizer(pStubMsg, pArg, &params[i]);
+                plan_buffer_sizer(pStubMsg, pArg, &params[i], step);
             break;
         default:
             RpcRaiseException(RPC_S_INTERNAL_ERROR);
@@ -68,6 +68,18 @@ typedef struct _RpcConnection_np
     IO_STATUS_BLOCK io_status;
     HANDLE event_cache;
     BOOL read_closed;
+    /* ncalrpc shared memory transport */
+    struct lrpc_shm *shm;
+    HANDLE shm_section;
+    HANDLE shm_events[4];
+    HANDLE shm_watch_event;
+    IO_STATUS_BLOCK shm_watch_io;
+    unsigned char shm_watch_byte;
+    CRITICAL_SECTION shm_write_cs;
+    BOOL shm_checked;
+    unsigned char peek_buffer[24];
+    unsigned int peek_len;
+    unsigned int peek_pos;
 } RpcConnection_np;
 
 static RpcConnection *rpcrt4_conn_np_alloc(void)
@@ -173,6 +185,8 @@ static RPC_STATUS rpcrt4_conn_open_pipe(RpcConnection *Connection, LPCSTR pname,
   return RPC_S_OK;
 }
 
+static RPC_STATUS lrpc_shm_connect(RpcConnection_np *npc);
+
 static char *ncalrpc_pipe_name(const char *endpoint)
 {
   static const char prefix[] = "\\\\.\\pipe\\lrpc\\";
@@ -199,6 +213,9 @@ static RPC_STATUS rpcrt4_ncalrpc_open(RpcConnection* Connection)
   r = rpcrt4_conn_open_pipe(Connection, pname, TRUE);
   I_RpcFree(pname);
 
+  if (r == RPC_S_OK)
+    r = lrpc_shm_connect(npc);
+
   return r;
 }
 
@@ -468,6 +485,407 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *conn)
     return rpcrt4_conn_np_read(conn, NULL, 0);
 }
 
+/**** ncalrpc shared memory transport ****/
+
+/* Once an ncalrpc connection is established, the client sets up a section
+ * holding one ring buffer per direction and hands it to the server over the
+ * pipe. From then on packets are copied through the rings and the pipe is
+ * only kept around for impersonation and to notice the peer going away.
+ * Events are only signalled when the other side actually went to sleep. */
+
+#define LRPC_SHM_MAGIC     0x4d48534c  /* "LSHM", never a valid RPC version */
+#define LRPC_RING_SIZE     0x10000
+#define LRPC_SPIN_COUNT    4000
+
+enum lrpc_shm_event
+{
+    LRPC_EVENT_C2S_DATA,
+    LRPC_EVENT_C2S_SPACE,
+    LRPC_EVENT_S2C_DATA,
+    LRPC_EVENT_S2C_SPACE,
+};
+
+struct lrpc_ring
+{
+    LONG head;            /* total number of bytes written */
+    LONG tail;            /* total number of bytes read */
+    LONG reader_waiting;
+    LONG writer_waiting;
+};
+
+struct lrpc_shm
+{
+    struct lrpc_ring ring[2];  /* client to server, server to client */
+    unsigned char data[2][LRPC_RING_SIZE];
+};
+
+struct lrpc_shm_setup
+{
+    DWORD magic;
+    DWORD section;
+    DWORD events[4];
+};
+
+struct lrpc_shm_reply
+{
+    DWORD magic;
+    DWORD status;
+};
+
+static inline unsigned int lrpc_ring_used(const struct lrpc_ring *ring)
+{
+    return (ULONG)(*(volatile LONG *)&ring->head - *(volatile LONG *)&ring->tail);
+}
+
+static void lrpc_shm_free(RpcConnection_np *npc)
+{
+    unsigned int i;
+
+    if (npc->shm_watch_event)
+    {
+        IO_STATUS_BLOCK io_status;
+
+        if (npc->shm_watch_io.Status == STATUS_PENDING &&
+            NtCancelIoFileEx(npc->pipe, &npc->shm_watch_io, &io_status) == STATUS_SUCCESS)
+            WaitForSingleObject(npc->shm_watch_event, INFINITE);
+        CloseHandle(npc->shm_watch_event);
+        npc->shm_watch_event = 0;
+    }
+    if (npc->shm)
+    {
+        UnmapViewOfFile(npc->shm);
+        npc->shm = NULL;
+        npc->shm_write_cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&npc->shm_write_cs);
+    }
+    if (npc->shm_section)
+    {
+        CloseHandle(npc->shm_section);
+        npc->shm_section = 0;
+    }
+    for (i = 0; i < ARRAY_SIZE(npc->shm_events); i++)
+    {
+        if (npc->shm_events[i]) CloseHandle(npc->shm_events[i]);
+        npc->shm_events[i] = 0;
+    }
+}
+
+/* Keeps a read pending on the otherwise unused pipe, so that a wait on the
+ * rings ends when the pipe is broken or the read is cancelled. */
+static BOOL lrpc_shm_start(RpcConnection_np *npc)
+{
+    NTSTATUS status;
+
+    if (!(npc->shm_watch_event = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        return FALSE;
+
+    npc->shm_watch_io.Status = STATUS_PENDING;
+    status = NtReadFile(npc->pipe, npc->shm_watch_event, NULL, NULL, &npc->shm_watch_io,
+                        &npc->shm_watch_byte, 1, NULL, NULL);
+    if (status != STATUS_PENDING)
+    {
+        WARN("unexpected data on the pipe, status %08x\n", status);
+        npc->shm_watch_io.Status = status;
+        return FALSE;
+    }
+
+    InitializeCriticalSection(&npc->shm_write_cs);
+    npc->shm_write_cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": RpcConnection_np.shm_write_cs");
+    return TRUE;
+}
+
+static void *lrpc_shm_map(HANDLE section)
+{
+    return MapViewOfFile(section, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(struct lrpc_shm));
+}
+
+static RPC_STATUS lrpc_shm_connect(RpcConnection_np *npc)
+{
+    struct lrpc_shm_setup setup;
+    struct lrpc_shm_reply reply;
+    struct lrpc_shm *shm;
+    unsigned int i;
+
+    if (!(npc->shm_section = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                                0, sizeof(struct lrpc_shm), NULL)))
+        goto fail;
+    for (i = 0; i < ARRAY_SIZE(npc->shm_events); i++)
+        if (!(npc->shm_events[i] = CreateEventW(NULL, FALSE, FALSE, NULL)))
+            goto fail;
+    if (!(shm = lrpc_shm_map(npc->shm_section)))
+        goto fail;
+
+    setup.magic = LRPC_SHM_MAGIC;
+    setup.section = HandleToULong(npc->shm_section);
+    for (i = 0; i < ARRAY_SIZE(npc->shm_events); i++)
+        setup.events[i] = HandleToULong(npc->shm_events[i]);
+
+    /* the server always replies, whether it can use the section or not */
+    if (rpcrt4_conn_np_write(&npc->common, &setup, sizeof(setup)) != sizeof(setup) ||
+        rpcrt4_conn_np_read(&npc->common, &reply, sizeof(reply)) != sizeof(reply) ||
+        reply.magic != LRPC_SHM_MAGIC || reply.status != RPC_S_OK)
+    {
+        UnmapViewOfFile(shm);
+        goto fail;
+    }
+
+    if (!lrpc_shm_start(npc))
+    {
+        /* the server already committed to the rings, so there is no way back */
+        ERR("failed to set up shared memory transport\n");
+        UnmapViewOfFile(shm);
+        lrpc_shm_free(npc);
+        CloseHandle(npc->pipe);
+        npc->pipe = 0;
+        return RPC_S_OUT_OF_RESOURCES;
+    }
+    npc->shm = shm;
+    TRACE("using shared memory transport for %p\n", npc);
+    return RPC_S_OK;
+
+fail:
+    WARN("falling back to pipe transport\n");
+    lrpc_shm_free(npc);
+    return RPC_S_OK;
+}
+
+static RPC_STATUS lrpc_shm_accept(RpcConnection_np *npc, const struct lrpc_shm_setup *setup)
+{
+    HANDLE process;
+    ULONG pid;
+    unsigned int i;
+    RPC_STATUS status = RPC_S_OUT_OF_RESOURCES;
+
+    if (!GetNamedPipeClientProcessId(npc->pipe, &pid) ||
+        !(process = OpenProcess(PROCESS_DUP_HANDLE, FALSE, pid)))
+        return RPC_S_ACCESS_DENIED;
+
+    if (!DuplicateHandle(process, ULongToHandle(setup->section), GetCurrentProcess(),
+                         &npc->shm_section, 0, FALSE, DUPLICATE_SAME_ACCESS))
+        goto done;
+    for (i = 0; i < ARRAY_SIZE(npc->shm_events); i++)
+        if (!DuplicateHandle(process, ULongToHandle(setup->events[i]), GetCurrentProcess(),
+                             &npc->shm_events[i], 0, FALSE, DUPLICATE_SAME_ACCESS))
+            goto done;
+    if ((npc->shm = lrpc_shm_map(npc->shm_section)))
+        status = RPC_S_OK;
+
+done:
+    CloseHandle(process);
+    if (status != RPC_S_OK) lrpc_shm_free(npc);
+    return status;
+}
+
+/* The first packet on a server connection tells whether the client wants to
+ * use the rings. Anything else is kept and handed out by later reads. */
+static void lrpc_shm_check_client(RpcConnection_np *npc)
+{
+    struct lrpc_shm_reply reply;
+    struct lrpc_shm *shm;
+    NTSTATUS status;
+    int len;
+
+    npc->shm_checked = TRUE;
+
+    len = rpcrt4_conn_np_read(&npc->common, npc->peek_buffer, sizeof(npc->peek_buffer));
+    if (len <= 0) return;
+    npc->peek_len = len;
+    status = npc->io_status.Status;
+
+    if (len != sizeof(struct lrpc_shm_setup) || status != STATUS_SUCCESS ||
+        ((struct lrpc_shm_setup *)npc->peek_buffer)->magic != LRPC_SHM_MAGIC)
+        return;
+    npc->peek_len = 0;
+
+    reply.magic = LRPC_SHM_MAGIC;
+    reply.status = lrpc_shm_accept(npc, (struct lrpc_shm_setup *)npc->peek_buffer);
+    if (rpcrt4_conn_np_write(&npc->common, &reply, sizeof(reply)) != sizeof(reply) ||
+        reply.status != RPC_S_OK)
+    {
+        lrpc_shm_free(npc);
+        return;
+    }
+
+    shm = npc->shm;
+    npc->shm = NULL;
+    if (lrpc_shm_start(npc))
+    {
+        npc->shm = shm;
+        TRACE("using shared memory transport for %p\n", npc);
+    }
+    else
+    {
+        ERR("failed to set up shared memory transport\n");
+        UnmapViewOfFile(shm);
+        lrpc_shm_free(npc);
+        npc->read_closed = TRUE;
+    }
+}
+
+/* Waits until the ring has data (reader) or space (writer), advertising the
+ * wait in *waiting so that the other side signals the event. Returns FALSE if
+ * the connection is gone. */
+static BOOL lrpc_shm_wait(RpcConnection_np *npc, const struct lrpc_ring *ring, BOOL reader,
+                          LONG *waiting, HANDLE event)
+{
+    HANDLE handles[2];
+    unsigned int spin;
+
+    for (;;)
+    {
+        for (spin = 0; spin < LRPC_SPIN_COUNT; spin++)
+        {
+            if (reader ? lrpc_ring_used(ring) != 0 : lrpc_ring_used(ring) < LRPC_RING_SIZE)
+                return TRUE;
+            YieldProcessor();
+        }
+
+        InterlockedExchange(waiting, 1);
+        if (reader ? lrpc_ring_used(ring) != 0 : lrpc_ring_used(ring) < LRPC_RING_SIZE)
+            return TRUE;
+        if (npc->read_closed || npc->shm_watch_io.Status != STATUS_PENDING)
+            return FALSE;
+
+        handles[0] = event;
+        handles[1] = npc->shm_watch_event;
+        if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0)
+            return FALSE;
+    }
+}
+
+static int lrpc_shm_read(RpcConnection_np *npc, void *buffer, unsigned int count)
+{
+    unsigned int index = npc->common.server ? 0 : 1;
+    struct lrpc_ring *ring = &npc->shm->ring[index];
+    const unsigned char *data = npc->shm->data[index];
+    HANDLE data_event = npc->shm_events[index ? LRPC_EVENT_S2C_DATA : LRPC_EVENT_C2S_DATA];
+    HANDLE space_event = npc->shm_events[index ? LRPC_EVENT_S2C_SPACE : LRPC_EVENT_C2S_SPACE];
+    unsigned int done = 0, len, pos, used;
+
+    if (!count)
+        return lrpc_shm_wait(npc, ring, TRUE, &ring->reader_waiting, data_event) ? 0 : -1;
+
+    while (done < count)
+    {
+        if (!(used = lrpc_ring_used(ring)))
+        {
+            if (!lrpc_shm_wait(npc, ring, TRUE, &ring->reader_waiting, data_event))
+                return -1;
+            continue;
+        }
+        MemoryBarrier();
+
+        pos = (ULONG)ring->tail % LRPC_RING_SIZE;
+        len = min(min(used, count - done), LRPC_RING_SIZE - pos);
+        memcpy((unsigned char *)buffer + done, data + pos, len);
+        done += len;
+
+        InterlockedExchangeAdd(&ring->tail, len);
+        if (ring->writer_waiting && InterlockedExchange(&ring->writer_waiting, 0))
+            SetEvent(space_event);
+    }
+    return count;
+}
+
+static int lrpc_shm_write(RpcConnection_np *npc, const void *buffer, unsigned int count)
+{
+    unsigned int index = npc->common.server ? 1 : 0;
+    struct lrpc_ring *ring = &npc->shm->ring[index];
+    unsigned char *data = npc->shm->data[index];
+    HANDLE data_event = npc->shm_events[index ? LRPC_EVENT_S2C_DATA : LRPC_EVENT_C2S_DATA];
+    HANDLE space_event = npc->shm_events[index ? LRPC_EVENT_S2C_SPACE : LRPC_EVENT_C2S_SPACE];
+    unsigned int done = 0, len, pos, used;
+
+    /* server threads may send replies on the same connection concurrently */
+    EnterCriticalSection(&npc->shm_write_cs);
+    while (done < count)
+    {
+        if ((used = lrpc_ring_used(ring)) == LRPC_RING_SIZE)
+        {
+            if (!lrpc_shm_wait(npc, ring, FALSE, &ring->writer_waiting, space_event))
+            {
+                LeaveCriticalSection(&npc->shm_write_cs);
+                return -1;
+            }
+            continue;
+        }
+        MemoryBarrier();
+
+        pos = (ULONG)ring->head % LRPC_RING_SIZE;
+        len = min(min(LRPC_RING_SIZE - used, count - done), LRPC_RING_SIZE - pos);
+        memcpy(data + pos, (const unsigned char *)buffer + done, len);
+        done += len;
+
+        InterlockedExchangeAdd(&ring->head, len);
+        if (ring->reader_waiting && InterlockedExchange(&ring->reader_waiting, 0))
+            SetEvent(data_event);
+    }
+    LeaveCriticalSection(&npc->shm_write_cs);
+    return count;
+}
+
+static int rpcrt4_conn_lrpc_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+    unsigned int len;
+    int ret;
+
+    if (conn->server && !npc->shm_checked)
+        lrpc_shm_check_client(npc);
+
+    if (npc->shm)
+        return lrpc_shm_read(npc, buffer, count);
+
+    if (npc->peek_pos == npc->peek_len)
+        return rpcrt4_conn_np_read(conn, buffer, count);
+
+    /* hand out what was read while looking for the setup packet */
+    if (!count) return 0;
+    len = min(count, npc->peek_len - npc->peek_pos);
+    memcpy(buffer, npc->peek_buffer + npc->peek_pos, len);
+    npc->peek_pos += len;
+    if (len == count || npc->io_status.Status != STATUS_BUFFER_OVERFLOW)
+        return len;
+
+    /* the rest of the packet is still in the pipe */
+    ret = rpcrt4_conn_np_read(conn, (unsigned char *)buffer + len, count - len);
+    return ret < 0 ? ret : len + ret;
+}
+
+static int rpcrt4_conn_lrpc_write(RpcConnection *conn, const void *buffer, unsigned int count)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm)
+        return lrpc_shm_write(npc, buffer, count);
+    return rpcrt4_conn_np_write(conn, buffer, count);
+}
+
+static int rpcrt4_conn_lrpc_close(RpcConnection *conn)
+{
+    lrpc_shm_free((RpcConnection_np *)conn);
+    return rpcrt4_conn_np_close(conn);
+}
+
+static void rpcrt4_conn_lrpc_close_read(RpcConnection *conn)
+{
+    RpcConnection_np *npc = (RpcConnection_np *)conn;
+
+    if (npc->shm)
+    {
+        IO_STATUS_BLOCK io_status;
+        npc->read_closed = TRUE;
+        NtCancelIoFileEx(npc->pipe, &npc->shm_watch_io, &io_status);
+    }
+    else
+        rpcrt4_conn_np_close_read(conn);
+}
+
+static int rpcrt4_conn_lrpc_wait_for_incoming_data(RpcConnection *conn)
+{
+    return rpcrt4_conn_lrpc_read(conn, NULL, 0);
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -3141,13 +3559,13 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_alloc,
     rpcrt4_ncalrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_close_read,
+    rpcrt4_conn_lrpc_read,
+    rpcrt4_conn_lrpc_write,
+    rpcrt4_conn_lrpc_close,
+    rpcrt4_conn_lrpc_close_read,
     rpcrt4_conn_np_cancel_call,
     rpcrt4_ncalrpc_np_is_server_listening,
-    rpcrt4_conn_np_wait_for_incoming_data,
+    rpcrt4_conn_lrpc_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
     NULL,
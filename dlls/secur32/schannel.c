@@ -33,6 +33,7 @@
 #include "secur32_priv.h"
 
 #include "wine/unicode.h"
+#include "wine/list.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(secur32);
@@ -60,8 +61,35 @@ struct schan_context
     struct schan_transport transport;
     ULONG req_ctx_attr;
     const CERT_CONTEXT *cert;
+    char *target;
+    DWORD enabled_protocols;
+    BOOL cacheable;
+    BOOL established;
 };
 
+/* client sessions that can be resumed, most recently used first */
+struct schan_cached_session
+{
+    struct list entry;
+    char *target;
+    DWORD enabled_protocols;
+    ULONGLONG expiry;
+    SIZE_T size;
+    BYTE data[1];
+};
+
+static struct list schan_session_cache = LIST_INIT(schan_session_cache);
+static unsigned int schan_session_cache_count;
+
+static CRITICAL_SECTION schan_session_cache_cs;
+static CRITICAL_SECTION_DEBUG schan_session_cache_cs_debug =
+{
+    0, 0, &schan_session_cache_cs,
+    { &schan_session_cache_cs_debug.ProcessLocksList, &schan_session_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": schan_session_cache_cs") }
+};
+static CRITICAL_SECTION schan_session_cache_cs = { &schan_session_cache_cs_debug, -1, 0, 0, 0, 0 };
+
 static struct schan_handle *schan_handle_table;
 static struct schan_handle *schan_free_handles;
 static SIZE_T schan_handle_table_size;
@@ -73,6 +101,10 @@ static DWORD config_enabled_protocols;
 /* Protocols disabled by default. They are enabled for using, but disabled when caller asks for default settings. */
 static DWORD config_default_disabled_protocols;
 
+/* ClientCacheTime is in milliseconds, Windows defaults to 10 hours */
+static DWORD config_client_cache_time = 10 * 60 * 60 * 1000;
+static DWORD config_max_cache_size = 256;
+
 static ULONG_PTR schan_alloc_handle(void *object, enum schan_handle_type type)
 {
     struct schan_handle *handle;
@@ -170,6 +202,15 @@ static void read_config(void)
         'S','C','H','A','N','N','E','L','\\',
         'P','r','o','t','o','c','o','l','s',0 };
 
+    static const WCHAR schannel_config_key_name[] = {
+        'S','Y','S','T','E','M','\\',
+        'C','u','r','r','e','n','t','C','o','n','t','r','o','l','S','e','t','\\',
+        'C','o','n','t','r','o','l','\\',
+        'S','e','c','u','r','i','t','y','P','r','o','v','i','d','e','r','s','\\',
+        'S','C','H','A','N','N','E','L',0 };
+
+    static const WCHAR clientcachetimeW[] = {'C','l','i','e','n','t','C','a','c','h','e','T','i','m','e',0};
+    static const WCHAR maximumcachesizeW[] = {'M','a','x','i','m','u','m','C','a','c','h','e','S','i','z','e',0};
     static const WCHAR clientW[] = {'\\','C','l','i','e','n','t',0};
     static const WCHAR enabledW[] = {'e','n','a','b','l','e','d',0};
     static const WCHAR disabledbydefaultW[] = {'D','i','s','a','b','l','e','d','B','y','D','e','f','a','u','l','t',0};
@@ -239,6 +280,19 @@ static void read_config(void)
 
     RegCloseKey(protocols_key);
 
+    if (!RegOpenKeyExW(HKEY_LOCAL_MACHINE, schannel_config_key_name, 0, KEY_READ, &key))
+    {
+        DWORD type, size, value;
+
+        size = sizeof(value);
+        if (!RegQueryValueExW(key, clientcachetimeW, NULL, &type, (BYTE *)&value, &size) && type == REG_DWORD)
+            config_client_cache_time = value;
+        size = sizeof(value);
+        if (!RegQueryValueExW(key, maximumcachesizeW, NULL, &type, (BYTE *)&value, &size) && type == REG_DWORD)
+            config_max_cache_size = value;
+        RegCloseKey(key);
+    }
+
     config_enabled_protocols = enabled & schan_imp_enabled_protocols();
     config_default_disabled_protocols = default_disabled;
     config_read = TRUE;
@@ -246,6 +300,89 @@ static void read_config(void)
     TRACE("enabled %x, disabled by default %x\n", config_enabled_protocols, config_default_disabled_protocols);
 }
 
+static void schan_free_cached_session(struct schan_cached_session *cached)
+{
+    list_remove(&cached->entry);
+    schan_session_cache_count--;
+    heap_free(cached->target);
+    heap_free(cached);
+}
+
+static struct schan_cached_session *schan_find_cached_session(const char *target, DWORD enabled_protocols)
+{
+    struct schan_cached_session *cached, *next;
+    ULONGLONG now = GetTickCount64();
+
+    LIST_FOR_EACH_ENTRY_SAFE(cached, next, &schan_session_cache, struct schan_cached_session, entry)
+    {
+        if (cached->expiry <= now)
+        {
+            schan_free_cached_session(cached);
+            continue;
+        }
+        if (cached->enabled_protocols == enabled_protocols && !strcmp(cached->target, target))
+            return cached;
+    }
+    return NULL;
+}
+
+/* Let a new client session resume an earlier one to the same target, saving a full handshake. */
+static void schan_resume_session(struct schan_context *ctx)
+{
+    struct schan_cached_session *cached;
+
+    EnterCriticalSection(&schan_session_cache_cs);
+    if ((cached = schan_find_cached_session(ctx->target, ctx->enabled_protocols)))
+    {
+        TRACE("resuming session for %s\n", debugstr_a(ctx->target));
+        schan_imp_set_session_data(ctx->session, cached->data, cached->size);
+        list_remove(&cached->entry);
+        list_add_head(&schan_session_cache, &cached->entry);
+    }
+    LeaveCriticalSection(&schan_session_cache_cs);
+}
+
+/* Called when the context goes away, TLS 1.3 tickets only arrive after the handshake. */
+static void schan_cache_session(struct schan_context *ctx)
+{
+    struct schan_cached_session *cached, *old;
+    SIZE_T size = 0;
+
+    if (!ctx->cacheable || !ctx->established || !config_client_cache_time || !config_max_cache_size) return;
+    if (!schan_imp_get_session_data(ctx->session, NULL, &size) || !size) return;
+
+    if (!(cached = heap_alloc(FIELD_OFFSET(struct schan_cached_session, data[size])))) return;
+    if (!schan_imp_get_session_data(ctx->session, cached->data, &size) ||
+        !(cached->target = heap_alloc(strlen(ctx->target) + 1)))
+    {
+        heap_free(cached);
+        return;
+    }
+    strcpy(cached->target, ctx->target);
+    cached->enabled_protocols = ctx->enabled_protocols;
+    cached->expiry = GetTickCount64() + config_client_cache_time;
+    cached->size = size;
+
+    EnterCriticalSection(&schan_session_cache_cs);
+    if ((old = schan_find_cached_session(ctx->target, ctx->enabled_protocols)))
+        schan_free_cached_session(old);
+    list_add_head(&schan_session_cache, &cached->entry);
+    if (++schan_session_cache_count > config_max_cache_size)
+        schan_free_cached_session(LIST_ENTRY(list_tail(&schan_session_cache), struct schan_cached_session, entry));
+    LeaveCriticalSection(&schan_session_cache_cs);
+    TRACE("cached session for %s, %lu bytes\n", debugstr_a(ctx->target), size);
+}
+
+static void schan_free_context(struct schan_context *ctx)
+{
+    schan_cache_session(ctx);
+    if (ctx->cert)
+        CertFreeCertificateContext(ctx->cert);
+    schan_imp_dispose_session(ctx->session);
+    heap_free(ctx->target);
+    heap_free(ctx);
+}
+
 static SECURITY_STATUS schan_QueryCredentialsAttributes(
  PCredHandle phCredential, ULONG ulAttribute, VOID *pBuffer)
 {
@@ -430,6 +567,7 @@ static SECURITY_STATUS schan_AcquireClientCredentials(const SCHANNEL_CRED *schan
     }
 
     creds->enabled_protocols = enabled_protocols;
+    creds->client_cert = cert != NULL;
     phCredential->dwLower = handle;
     phCredential->dwUpper = 0;
 
@@ -811,10 +949,9 @@ static SECURITY_STATUS SEC_ENTRY schan_InitializeSecurityContextW(
             return SEC_E_INVALID_HANDLE;
         }
 
-        ctx = heap_alloc(sizeof(*ctx));
+        ctx = heap_alloc_zero(sizeof(*ctx));
         if (!ctx) return SEC_E_INSUFFICIENT_MEMORY;
 
-        ctx->cert = NULL;
         handle = schan_alloc_handle(ctx, SCHAN_HANDLE_CTX);
         if (handle == SCHAN_INVALID_HANDLE)
         {
@@ -835,13 +972,15 @@ static SECURITY_STATUS SEC_ENTRY schan_InitializeSecurityContextW(
         if (pszTargetName && *pszTargetName)
         {
             UINT len = WideCharToMultiByte( CP_UNIXCP, 0, pszTargetName, -1, NULL, 0, NULL, NULL );
-            char *target = heap_alloc( len );
 
-            if (target)
+            if ((ctx->target = heap_alloc( len )))
             {
-                WideCharToMultiByte( CP_UNIXCP, 0, pszTargetName, -1, target, len, NULL, NULL );
-                schan_imp_set_session_target( ctx->session, target );
-                heap_free( target );
+                WideCharToMultiByte( CP_UNIXCP, 0, pszTargetName, -1, ctx->target, len, NULL, NULL );
+                schan_imp_set_session_target( ctx->session, ctx->target );
+
+                ctx->enabled_protocols = cred->enabled_protocols;
+                ctx->cacheable = !cred->client_cert;
+                if (ctx->cacheable) schan_resume_session( ctx );
             }
         }
 
@@ -901,6 +1040,7 @@ static SECURITY_STATUS SEC_ENTRY schan_InitializeSecurityContextW(
 
     /* Perform the TLS handshake */
     ret = schan_imp_handshake(ctx->session);
+    if (ret == SEC_E_OK) ctx->established = TRUE;
 
     out_buffers = &ctx->transport.out;
     if (out_buffers->current_buffer_idx != -1)
@@ -1379,8 +1519,10 @@ static SECURITY_STATUS SEC_ENTRY schan_DecryptMessage(PCtxtHandle context_handle
         return SEC_E_INCOMPLETE_MESSAGE;
     }
 
+    /* Records are authenticated as a whole, so the ciphertext has been consumed by the time any
+     * plaintext is written and we can decrypt in place right after the header. */
     data_size = expected_size - 5;
-    data = heap_alloc(data_size);
+    data = (char *)buf_ptr + 5;
 
     init_schan_buffers(&ctx->transport.in, message, schan_decrypt_message_get_next_buffer);
     ctx->transport.in.limit = expected_size;
@@ -1401,7 +1543,6 @@ static SECURITY_STATUS SEC_ENTRY schan_DecryptMessage(PCtxtHandle context_handle
 
         if (status != SEC_E_OK)
         {
-            heap_free(data);
             ERR("Returning %x\n", status);
             return status;
         }
@@ -1414,9 +1555,6 @@ static SECURITY_STATUS SEC_ENTRY schan_DecryptMessage(PCtxtHandle context_handle
 
     TRACE("Received %ld bytes\n", received);
 
-    memcpy(buf_ptr + 5, data, received);
-    heap_free(data);
-
     schan_decrypt_fill_buffer(message, SECBUFFER_DATA,
         buf_ptr + 5, received);
 
@@ -1444,11 +1582,7 @@ static SECURITY_STATUS SEC_ENTRY schan_DeleteSecurityContext(PCtxtHandle context
     ctx = schan_free_handle(context_handle->dwLower, SCHAN_HANDLE_CTX);
     if (!ctx) return SEC_E_INVALID_HANDLE;
 
-    if (ctx->cert)
-        CertFreeCertificateContext(ctx->cert);
-    schan_imp_dispose_session(ctx->session);
-    heap_free(ctx);
-
+    schan_free_context(ctx);
     return SEC_E_OK;
 }
 
@@ -1587,6 +1721,7 @@ void SECUR32_deinitSchannelSP(void)
         {
             struct schan_context *ctx = schan_free_handle(i, SCHAN_HANDLE_CTX);
             schan_imp_dispose_session(ctx->session);
+            heap_free(ctx->target);
             heap_free(ctx);
         }
     }
@@ -1602,6 +1737,10 @@ void SECUR32_deinitSchannelSP(void)
         }
     }
     heap_free(schan_handle_table);
+
+    while (!list_empty(&schan_session_cache))
+        schan_free_cached_session(LIST_ENTRY(list_head(&schan_session_cache), struct schan_cached_session, entry));
+
     schan_imp_deinit();
 }
 
@@ -96,6 +96,9 @@ MAKE_FUNCPTR(gnutls_record_recv);
 MAKE_FUNCPTR(gnutls_record_send);
 MAKE_FUNCPTR(gnutls_server_name_set);
 MAKE_FUNCPTR(gnutls_session_channel_binding);
+MAKE_FUNCPTR(gnutls_session_get_data);
+MAKE_FUNCPTR(gnutls_session_is_resumed);
+MAKE_FUNCPTR(gnutls_session_set_data);
 MAKE_FUNCPTR(gnutls_transport_get_ptr);
 MAKE_FUNCPTR(gnutls_transport_set_errno);
 MAKE_FUNCPTR(gnutls_transport_set_ptr);
@@ -349,7 +352,7 @@ SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
         err = pgnutls_handshake(s);
         switch(err) {
         case GNUTLS_E_SUCCESS:
-            TRACE("Handshake completed\n");
+            TRACE("Handshake completed%s\n", pgnutls_session_is_resumed(s) ? " (resumed)" : "");
             return SEC_E_OK;
 
         case GNUTLS_E_AGAIN:
@@ -388,6 +391,31 @@ SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
     return SEC_E_OK;
 }
 
+BOOL schan_imp_get_session_data(schan_imp_session session, void *data, SIZE_T *size)
+{
+    gnutls_session_t s = (gnutls_session_t)session;
+    size_t len = *size;
+    int err;
+
+    err = pgnutls_session_get_data(s, data, &len);
+    if (err != GNUTLS_E_SUCCESS && (data || err != GNUTLS_E_SHORT_MEMORY_BUFFER))
+    {
+        pgnutls_perror(err);
+        return FALSE;
+    }
+    *size = len;
+    return TRUE;
+}
+
+void schan_imp_set_session_data(schan_imp_session session, const void *data, SIZE_T size)
+{
+    gnutls_session_t s = (gnutls_session_t)session;
+    int err;
+
+    if ((err = pgnutls_session_set_data(s, data, size)) != GNUTLS_E_SUCCESS)
+        pgnutls_perror(err);
+}
+
 static DWORD schannel_get_protocol(gnutls_protocol_t proto)
 {
     /* FIXME: currently schannel only implements client connections, but
@@ -1069,6 +1097,9 @@ BOOL schan_imp_init(void)
     LOAD_FUNCPTR(gnutls_record_send);
     LOAD_FUNCPTR(gnutls_server_name_set)
     LOAD_FUNCPTR(gnutls_session_channel_binding)
+    LOAD_FUNCPTR(gnutls_session_get_data)
+    LOAD_FUNCPTR(gnutls_session_is_resumed)
+    LOAD_FUNCPTR(gnutls_session_set_data)
     LOAD_FUNCPTR(gnutls_transport_get_ptr)
     LOAD_FUNCPTR(gnutls_transport_set_errno)
     LOAD_FUNCPTR(gnutls_transport_set_ptr)
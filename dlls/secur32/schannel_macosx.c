@@ -847,6 +847,18 @@ void schan_imp_set_session_target(schan_imp_session session, const char *target)
     TRACE("(%p/%p, %s)\n", s, s->context, debugstr_a(target));
 
     SSLSetPeerDomainName( s->context, target, strlen(target) );
+    /* lets Secure Transport resume earlier sessions to the same peer */
+    SSLSetPeerID( s->context, target, strlen(target) );
+}
+
+/* Secure Transport keeps its own session cache keyed by the peer ID */
+BOOL schan_imp_get_session_data(schan_imp_session session, void *data, SIZE_T *size)
+{
+    return FALSE;
+}
+
+void schan_imp_set_session_data(schan_imp_session session, const void *data, SIZE_T size)
+{
 }
 
 SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
@@ -198,6 +198,7 @@ typedef struct schan_credentials
     ULONG credential_use;
     void *credentials;
     DWORD enabled_protocols;
+    BOOL client_cert;
 } schan_credentials;
 
 struct schan_transport;
@@ -232,6 +233,8 @@ extern void schan_imp_set_session_transport(schan_imp_session session,
                                             struct schan_transport *t) DECLSPEC_HIDDEN;
 extern void schan_imp_set_session_target(schan_imp_session session, const char *target) DECLSPEC_HIDDEN;
 extern SECURITY_STATUS schan_imp_handshake(schan_imp_session session) DECLSPEC_HIDDEN;
+extern BOOL schan_imp_get_session_data(schan_imp_session session, void *data, SIZE_T *size) DECLSPEC_HIDDEN;
+extern void schan_imp_set_session_data(schan_imp_session session, const void *data, SIZE_T size) DECLSPEC_HIDDEN;
 extern unsigned int schan_imp_get_session_cipher_block_size(schan_imp_session session) DECLSPEC_HIDDEN;
 extern unsigned int schan_imp_get_max_message_size(schan_imp_session session) DECLSPEC_HIDDEN;
 extern ALG_ID schan_imp_get_key_signature_algorithm(schan_imp_session session) DECLSPEC_HIDDEN;
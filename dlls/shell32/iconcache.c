@@ -83,7 +83,9 @@ static const WCHAR ShellIconSize[] = {'S','h','e','l','l',' ','I','c','o','n','
  * SIC_CompareEntries
  *
  * NOTES
- *  Callback for DPA_Search
+ *  Callback for DPA_Search. The cache is kept sorted on the source index,
+ *  the shortcut flag and the file name so that lookups can use a binary
+ *  search; SIC_COMPARE_LISTINDEX only checks for equality.
  */
 static INT CALLBACK SIC_CompareEntries( LPVOID p1, LPVOID p2, LPARAM lparam)
 {
@@ -99,14 +101,13 @@ static INT CALLBACK SIC_CompareEntries( LPVOID p1, LPVOID p2, LPARAM lparam)
         if (lparam & SIC_COMPARE_LISTINDEX)
             return e1->dwListIndex != e2->dwListIndex;
 
-	if (e1->dwSourceIndex != e2->dwSourceIndex || /* first the faster one */
-	    (e1->dwFlags & GIL_FORSHORTCUT) != (e2->dwFlags & GIL_FORSHORTCUT)) 
-	  return 1;
+	if (e1->dwSourceIndex != e2->dwSourceIndex) /* first the faster one */
+	  return e1->dwSourceIndex < e2->dwSourceIndex ? -1 : 1;
 
-	if (strcmpiW(e1->sSourceFile,e2->sSourceFile))
-	  return 1;
+	if ((e1->dwFlags & GIL_FORSHORTCUT) != (e2->dwFlags & GIL_FORSHORTCUT))
+	  return (e1->dwFlags & GIL_FORSHORTCUT) ? 1 : -1;
 
-	return 0;
+	return strcmpiW(e1->sSourceFile,e2->sSourceFile);
 }
 
 /**************************************************************************************
@@ -319,7 +320,8 @@ static INT SIC_IconAppend (const WCHAR *sourcefile, INT src_index, HICON *hicons
 
     EnterCriticalSection(&SHELL32_SicCS);
 
-    index = DPA_InsertPtr(sic_hdpa, 0x7fff, entry);
+    index = DPA_Search(sic_hdpa, entry, 0, SIC_CompareEntries, 0, DPAS_SORTED | DPAS_INSERTAFTER);
+    index = DPA_InsertPtr(sic_hdpa, index, entry);
     if ( INVALID_INDEX == index )
     {
         heap_free(entry->sSourceFile);
@@ -554,8 +556,7 @@ INT SIC_GetIconIndex (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags )
 
 	if (NULL != DPA_GetPtr (sic_hdpa, 0))
 	{
-	  /* search linear from position 0*/
-	  index = DPA_Search (sic_hdpa, &sice, 0, SIC_CompareEntries, 0, 0);
+	  index = DPA_Search (sic_hdpa, &sice, 0, SIC_CompareEntries, 0, DPAS_SORTED);
 	}
 
 	if ( INVALID_INDEX == index )
@@ -607,10 +607,23 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 		if (!(es->style & ES_AUTOHSCROLL)) {
 		   if (current_line->width > fw && fw > es->char_width) {
 
-			INT prev, next;
+			INT prev, next, i;
 			int w;
 			const SIZE *sz;
 			float d;
+			INT *piDx = NULL, *prefix = NULL;
+
+			/* Measure candidate break positions with the logical widths of the
+			 * whole line instead of analysing every candidate prefix again. */
+			if (current_line->ssa && *ScriptString_pcOutChars(current_line->ssa) >= current_line->net_length)
+			{
+				piDx = HeapAlloc(GetProcessHeap(), 0, sizeof(INT) * (*ScriptString_pcOutChars(current_line->ssa)));
+				prefix = HeapAlloc(GetProcessHeap(), 0, sizeof(INT) * (current_line->net_length + 1));
+				ScriptStringGetLogicalWidths(current_line->ssa, piDx);
+				prefix[0] = 0;
+				for (i = 0; i < current_line->net_length; i++)
+					prefix[i + 1] = prefix[i] + piDx[i];
+			}
 
 			prev = current_line->net_length - 1;
 			w = current_line->net_length;
@@ -621,14 +634,8 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 			do {
 				prev = EDIT_CallWordBreakProc(es, current_position - es->text,
 						next, current_line->net_length, WB_LEFT);
-				current_line->net_length = prev;
-				EDIT_InvalidateUniscribeData_linedef(current_line);
-				EDIT_UpdateUniscribeData_linedef(es, NULL, current_line);
-				if (current_line->ssa)
-					sz = ScriptString_pSize(current_line->ssa);
-				else sz = 0;
-				if (sz)
-					current_line->width = sz->cx;
+				if (prev > 0 && prefix)
+					current_line->width = prefix[prev];
 				else
 					prev = 0;
 				next = prev - 1;
@@ -636,18 +643,8 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 			current_line->net_length = w;
 
 			if (prev == 0) { /* Didn't find a line break so force a break */
-				INT *piDx;
-				const INT *count;
-
-				EDIT_InvalidateUniscribeData_linedef(current_line);
-				EDIT_UpdateUniscribeData_linedef(es, NULL, current_line);
-
-				if (current_line->ssa)
+				if (piDx)
 				{
-					count = ScriptString_pcOutChars(current_line->ssa);
-					piDx = HeapAlloc(GetProcessHeap(),0,sizeof(INT) * (*count));
-					ScriptStringGetLogicalWidths(current_line->ssa,piDx);
-
 					prev = current_line->net_length-1;
 					do {
 						current_line->width -= piDx[prev];
@@ -655,11 +652,15 @@ static void EDIT_BuildLineDefs_ML(EDITSTATE *es, INT istart, INT iend, INT delta
 					} while ( prev > 0 && current_line->width > fw);
 					if (prev<=0)
 						prev = 1;
-					HeapFree(GetProcessHeap(),0,piDx);
 				}
 				else
 					prev = (fw / es->char_width);
 			}
+			else
+				EDIT_InvalidateUniscribeData_linedef(current_line);
+
+			HeapFree(GetProcessHeap(), 0, prefix);
+			HeapFree(GetProcessHeap(), 0, piDx);
 
 			/* If the first line we are calculating, wrapped before istart, we must
 			 * adjust istart in order for this to be reflected in the update region. */
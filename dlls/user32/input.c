@@ -51,6 +51,74 @@ WINE_DECLARE_DEBUG_CHANNEL(keyboard);
 
 INT global_key_state_counter = 0;
 
+/***********************************************************************
+ *           get_desktop_shared
+ *
+ * Map the state that the server publishes for the thread desktop.
+ */
+const volatile void *get_desktop_shared(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    HANDLE handle = 0;
+    SIZE_T size = 0;
+    void *ptr = NULL;
+
+    if (thread_info->desktop_shm) return thread_info->desktop_shm;
+
+    SERVER_START_REQ( get_desktop_shared_mapping )
+    {
+        if (!wine_server_call( req )) handle = wine_server_ptr_handle( reply->handle );
+    }
+    SERVER_END_REQ;
+    if (!handle) return NULL;
+
+    if (!NtMapViewOfSection( handle, GetCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                             ViewShare, 0, PAGE_READONLY ))
+        thread_info->desktop_shm = ptr;
+    NtClose( handle );
+    return thread_info->desktop_shm;
+}
+
+/***********************************************************************
+ *           unmap_desktop_shared
+ */
+void unmap_desktop_shared(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+
+    if (!thread_info->desktop_shm) return;
+    NtUnmapViewOfSection( GetCurrentProcess(), (void *)thread_info->desktop_shm );
+    thread_info->desktop_shm = NULL;
+}
+
+/***********************************************************************
+ *           read_desktop_shared
+ *
+ * Take a consistent snapshot of the shared desktop state, retrying while
+ * the server is in the middle of an update.
+ */
+static BOOL read_desktop_shared( POINT *pt, DWORD *last_change, INT key, BYTE *key_state )
+{
+    const volatile desktop_shm_t *shm = get_desktop_shared();
+    unsigned int seq;
+
+    if (!shm) return FALSE;
+    do
+    {
+        while ((seq = shm->seq) & 1) YieldProcessor();
+        MemoryBarrier();
+        if (pt)
+        {
+            pt->x = shm->cursor_x;
+            pt->y = shm->cursor_y;
+        }
+        if (last_change) *last_change = shm->cursor_last_change;
+        if (key_state) *key_state = shm->keystate[key];
+        MemoryBarrier();
+    } while (shm->seq != seq);
+    return TRUE;
+}
+
 /***********************************************************************
  *           get_key_state
  */
@@ -252,16 +320,19 @@ BOOL WINAPI DECLSPEC_HOTPATCH GetCursorPos( POINT *pt )
 
     if (!pt) return FALSE;
 
-    SERVER_START_REQ( set_cursor )
+    if (!(ret = read_desktop_shared( pt, &last_change, 0, NULL )))
     {
-        if ((ret = !wine_server_call( req )))
+        SERVER_START_REQ( set_cursor )
         {
-            pt->x = reply->new_x;
-            pt->y = reply->new_y;
-            last_change = reply->last_change;
+            if ((ret = !wine_server_call( req )))
+            {
+                pt->x = reply->new_x;
+                pt->y = reply->new_y;
+                last_change = reply->last_change;
+            }
         }
+        SERVER_END_REQ;
     }
-    SERVER_END_REQ;
 
     /* query new position from graphics driver if we haven't updated recently */
     if (ret && GetTickCount() - last_change > 100) ret = USER_Driver->pGetCursorPos( pt );
@@ -398,6 +469,10 @@ SHORT WINAPI DECLSPEC_HOTPATCH GetAsyncKeyState( INT key )
 
     check_for_events( QS_INPUT );
 
+    /* the server only needs to be involved to clear the pressed-since-last-call bit */
+    if (read_desktop_shared( NULL, NULL, key, &prev_key_state ) && !(prev_key_state & 0xc0))
+        return 0;
+
     if (key_state_info && !(key_state_info->state[key] & 0xc0) &&
         key_state_info->counter == counter && GetTickCount() - key_state_info->time < 50)
     {
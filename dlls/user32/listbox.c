@@ -144,7 +144,7 @@ static BOOL resize_storage(LB_DESCR *descr, UINT items_size)
     LB_ITEMDATA *items;
 
     if (items_size > descr->items_size ||
-        items_size + LB_ARRAY_GRANULARITY * 2 < descr->items_size)
+        (items_size + LB_ARRAY_GRANULARITY * 2 < descr->items_size && items_size < descr->items_size / 2))
     {
         items_size = (items_size + LB_ARRAY_GRANULARITY - 1) & ~(LB_ARRAY_GRANULARITY - 1);
         if ((descr->style & (LBS_NODATA | LBS_MULTIPLESEL | LBS_EXTENDEDSEL)) != LBS_NODATA)
@@ -1635,7 +1635,10 @@ static LRESULT LISTBOX_InsertItem( LB_DESCR *descr, INT index,
 
     if (index == -1) index = descr->nb_items;
     else if ((index < 0) || (index > descr->nb_items)) return LB_ERR;
-    if (!resize_storage(descr, descr->nb_items + 1)) return LB_ERR;
+    /* Grow geometrically, so that adding many items doesn't reallocate the array every few items. */
+    if (descr->nb_items == descr->items_size &&
+        !resize_storage(descr, max(descr->items_size + descr->items_size / 2, descr->nb_items + 1)))
+        return LB_ERR;
 
     insert_item_data(descr, index);
     descr->nb_items++;
@@ -47,6 +47,8 @@ WINE_DEFAULT_DEBUG_CHANNEL(msg);
 WINE_DECLARE_DEBUG_CHANNEL(relay);
 WINE_DECLARE_DEBUG_CHANNEL(key);
 
+extern void * CDECL __wine_fsync_get_shm( unsigned int idx );
+
 #define WM_NCMOUSEFIRST WM_NCMOUSEMOVE
 #define WM_NCMOUSELAST  (WM_NCMOUSEFIRST+(WM_MOUSELAST-WM_MOUSEFIRST))
 
@@ -2688,6 +2690,35 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+/***********************************************************************
+ *           get_server_queue_handle
+ *
+ * Get a handle to the server message queue for the current thread.
+ */
+static HANDLE get_server_queue_handle(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    HANDLE ret;
+
+    if (!(ret = thread_info->server_queue))
+    {
+        unsigned int status_idx = 0;
+
+        SERVER_START_REQ( get_msg_queue )
+        {
+            wine_server_call( req );
+            ret = wine_server_ptr_handle( reply->handle );
+            status_idx = reply->status_idx;
+        }
+        SERVER_END_REQ;
+        thread_info->server_queue = ret;
+        if (status_idx) thread_info->queue_status = __wine_fsync_get_shm( status_idx );
+        if (!ret) ERR( "Cannot get server thread queue\n" );
+    }
+    return ret;
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2705,6 +2736,16 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
     void *buffer;
     size_t buffer_size = 256;
 
+    /* If the server found no message with the same masks last time and the
+     * queue wake bits it publishes are still clear, there can't be one now.
+     * Still ask the server regularly so that it doesn't consider us hung. */
+    if (!hwnd && thread_info->queue_status && !*thread_info->queue_status &&
+        thread_info->last_getmsg_time &&
+        thread_info->wake_mask == (changed_mask & (QS_SENDMESSAGE | QS_SMRESULT)) &&
+        thread_info->changed_mask == changed_mask &&
+        GetTickCount() - thread_info->last_getmsg_time < 1000)
+        return 0;
+
     if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return -1;
 
     if (!first && !last) last = ~0;
@@ -2753,6 +2794,8 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
             {
                 thread_info->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
                 thread_info->changed_mask = changed_mask;
+                if (!thread_info->server_queue) get_server_queue_handle();
+                thread_info->last_getmsg_time = GetTickCount();
                 return 0;
             }
             if (res != STATUS_BUFFER_OVERFLOW)
@@ -2951,31 +2994,6 @@ static inline void process_sent_messages(void)
 }
 
 
-/***********************************************************************
- *           get_server_queue_handle
- *
- * Get a handle to the server message queue for the current thread.
- */
-static HANDLE get_server_queue_handle(void)
-{
-    struct user_thread_info *thread_info = get_user_thread_info();
-    HANDLE ret;
-
-    if (!(ret = thread_info->server_queue))
-    {
-        SERVER_START_REQ( get_msg_queue )
-        {
-            wine_server_call( req );
-            ret = wine_server_ptr_handle( reply->handle );
-        }
-        SERVER_END_REQ;
-        thread_info->server_queue = ret;
-        if (!ret) ERR( "Cannot get server thread queue\n" );
-    }
-    return ret;
-}
-
-
 /***********************************************************************
  *           wait_message_reply
  *
@@ -3001,6 +3019,7 @@ static void wait_message_reply( UINT flags )
         SERVER_END_REQ;
 
         thread_info->wake_mask = thread_info->changed_mask = 0;
+        thread_info->last_getmsg_time = 0;
 
         if (wake_bits & QS_SMRESULT) return;  /* got a result */
         if (wake_bits & QS_SENDMESSAGE)
@@ -3042,11 +3061,16 @@ static DWORD wait_objects( DWORD count, const HANDLE *handles, DWORD timeout,
         SERVER_END_REQ;
         thread_info->wake_mask = wake_mask;
         thread_info->changed_mask = changed_mask;
+        thread_info->last_getmsg_time = 0;
     }
 
     ret = wow_handlers.wait_message( count, handles, timeout, changed_mask, flags );
 
-    if (ret != WAIT_TIMEOUT) thread_info->wake_mask = thread_info->changed_mask = 0;
+    if (ret != WAIT_TIMEOUT)
+    {
+        thread_info->wake_mask = thread_info->changed_mask = 0;
+        thread_info->last_getmsg_time = 0;
+    }
     return ret;
 }
 
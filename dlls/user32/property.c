@@ -26,10 +26,58 @@
 #include "winnls.h"
 #include "winuser.h"
 #include "wine/server.h"
+#include "user_private.h"
 
 /* size of buffer needed to store an atom string */
 #define ATOM_BUFFER_SIZE 256
 
+/***********************************************************************
+ *              get_property_name_key
+ *
+ * Compute the cache key of a property name, must match the computation in the server.
+ */
+static unsigned int get_property_name_key( const WCHAR *name )
+{
+    unsigned int key = 2166136261u;
+
+    for (; *name; name++)
+    {
+        WCHAR ch = *name;
+        if (ch >= 'A' && ch <= 'Z') ch += 'a' - 'A';
+        key = (key ^ ch) * 16777619u;
+    }
+    return key | SHM_PROPERTY_NAME_KEY;
+}
+
+/***********************************************************************
+ *              get_shared_property
+ *
+ * Look up a property in the cache of recently set properties that the
+ * server publishes in the desktop shared memory.
+ */
+static BOOL get_shared_property( HWND hwnd, LPCWSTR str, ULONG_PTR *data )
+{
+    const volatile desktop_shm_t *shm = get_desktop_shared();
+    user_handle_t handle = wine_server_user_handle( hwnd );
+    const volatile shm_property_t *prop;
+    unsigned int key, seq;
+    BOOL ret;
+
+    if (!shm || !handle) return FALSE;
+
+    key = IS_INTRESOURCE(str) ? LOWORD(str) : get_property_name_key( str );
+    prop = &shm->properties[SHM_PROPERTY_SLOT( handle, key )];
+    do
+    {
+        while ((seq = shm->seq) & 1) YieldProcessor();
+        MemoryBarrier();
+        ret = prop->window == handle && prop->key == key;
+        *data = prop->data;
+        MemoryBarrier();
+    } while (shm->seq != seq);
+    return ret;
+}
+
 
 /***********************************************************************
  *              get_properties
@@ -128,6 +176,8 @@ HANDLE WINAPI GetPropW( HWND hwnd, LPCWSTR str )
 {
     ULONG_PTR ret = 0;
 
+    if (get_shared_property( hwnd, str, &ret )) return (HANDLE)ret;
+
     SERVER_START_REQ( get_window_property )
     {
         req->window = wine_server_user_handle( hwnd );
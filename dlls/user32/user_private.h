@@ -202,11 +202,16 @@ struct user_thread_info
     HWND                          top_window;             /* Desktop window */
     HWND                          msg_window;             /* HWND_MESSAGE parent window */
     struct rawinput_thread_data  *rawinput;               /* RawInput thread local data / buffer */
+    const volatile unsigned int  *queue_status;           /* Queue wake bits published by the server */
+    DWORD                         last_getmsg_time;       /* Time of last get_message call without message */
+    const volatile void          *desktop_shm;            /* Desktop state published by the server */
 };
 
 C_ASSERT( sizeof(struct user_thread_info) <= sizeof(((TEB *)0)->Win32ClientInfo) );
 
 extern INT global_key_state_counter DECLSPEC_HIDDEN;
+extern const volatile void *get_desktop_shared(void) DECLSPEC_HIDDEN;
+extern void unmap_desktop_shared(void) DECLSPEC_HIDDEN;
 extern BOOL (WINAPI *imm_register_window)(HWND) DECLSPEC_HIDDEN;
 extern void (WINAPI *imm_unregister_window)(HWND) DECLSPEC_HIDDEN;
 extern void (WINAPI *imm_activate_window)(HWND) DECLSPEC_HIDDEN;
@@ -460,6 +460,7 @@ BOOL WINAPI SetThreadDesktop( HDESK handle )
         thread_info->top_window = 0;
         thread_info->msg_window = 0;
         if (key_state_info) key_state_info->time = 0;
+        unmap_desktop_shared();
     }
     return ret;
 }
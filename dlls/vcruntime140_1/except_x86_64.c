@@ -656,7 +656,8 @@ static inline void find_catch_block4(EXCEPTION_RECORD *rec, CONTEXT *context,
             if (ci.ret_addr[1])
                 catch_record.ExceptionInformation[9] = (ULONG_PTR)rva_to_ptr(
                     ci.ret_addr[1] + dispatch->FunctionEntry->BeginAddress, dispatch->ImageBase);
-            RtlUnwindEx((void*)frame, (void*)dispatch->ControlPc, &catch_record, NULL, &ctx, NULL);
+            RtlUnwindEx((void*)frame, (void*)dispatch->ControlPc, &catch_record, NULL, &ctx,
+                    dispatch->HistoryTable);
         }
     }
 
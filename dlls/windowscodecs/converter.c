@@ -136,6 +136,62 @@ static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
 }
 
+static inline DWORD swap_rb(DWORD pixel)
+{
+    return (pixel & 0xff00ff00) | ((pixel & 0xff) << 16) | ((pixel >> 16) & 0xff);
+}
+
+/* convert a row of 24bpp pixels to opaque 32bpp, four pixels (three source dwords) at a time */
+static void convert_24bpp_to_32bpp_row(const BYTE *src, DWORD *dst, UINT width, BOOL swap)
+{
+    DWORD w[3], p[4];
+    UINT x, i;
+
+    for (x = 0; x + 4 <= width; x += 4, src += 12, dst += 4)
+    {
+        memcpy(w, src, sizeof(w));
+        p[0] = w[0] & 0xffffff;
+        p[1] = (w[0] >> 24) | ((w[1] & 0xffff) << 8);
+        p[2] = (w[1] >> 16) | ((w[2] & 0xff) << 16);
+        p[3] = w[2] >> 8;
+        for (i = 0; i < 4; i++)
+            dst[i] = 0xff000000 | (swap ? swap_rb(p[i]) : p[i]);
+    }
+    for (; x < width; x++, src += 3, dst++)
+    {
+        p[0] = src[0] | (src[1] << 8) | (src[2] << 16);
+        *dst = 0xff000000 | (swap ? swap_rb(p[0]) : p[0]);
+    }
+}
+
+static HRESULT copypixels_24bpp_to_32bppBGRA(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, BOOL swap)
+{
+    HRESULT res;
+    INT y;
+    BYTE *srcdata;
+    UINT srcstride, srcdatasize;
+
+    srcstride = 3 * prc->Width;
+    srcdatasize = srcstride * prc->Height;
+
+    srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
+    if (!srcdata) return E_OUTOFMEMORY;
+
+    res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
+
+    if (SUCCEEDED(res))
+    {
+        for (y=0; y<prc->Height; y++)
+            convert_24bpp_to_32bpp_row(srcdata + srcstride * y, (DWORD *)(pbBuffer + cbStride * y),
+                                       prc->Width, swap);
+    }
+
+    HeapFree(GetProcessHeap(), 0, srcdata);
+
+    return res;
+}
+
 static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRect *prc,
     UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer, enum pixelformat source_format)
 {
@@ -615,95 +671,10 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         }
         return S_OK;
     case format_24bppBGR:
-        if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-
-            srcstride = 3 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
-
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
-            return res;
-        }
-        return S_OK;
     case format_24bppRGB:
         if (prc)
-        {
-            HRESULT res;
-            INT x, y;
-            BYTE *srcdata;
-            UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
-
-            srcstride = 3 * prc->Width;
-            srcdatasize = srcstride * prc->Height;
-
-            srcdata = HeapAlloc(GetProcessHeap(), 0, srcdatasize);
-            if (!srcdata) return E_OUTOFMEMORY;
-
-            res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
-
-            if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* red */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* blue */
-
-                        *dstpixel++=tmppixel[2]; /* blue */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
-
-            HeapFree(GetProcessHeap(), 0, srcdata);
-
-            return res;
-        }
+            return copypixels_24bpp_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer,
+                                                 source_format == format_24bppRGB);
         return S_OK;
     case format_32bppBGR:
         if (prc)
@@ -716,8 +687,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
+            {
+                DWORD *pixel = (DWORD *)(pbBuffer + cbStride * y);
                 for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+                    pixel[x] |= 0xff000000;
+            }
         }
         return S_OK;
     case format_32bppRGBA:
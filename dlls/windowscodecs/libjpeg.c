@@ -169,8 +169,10 @@ struct jpeg_decoder {
     struct jpeg_error_mgr jerr;
     struct jpeg_source_mgr source_mgr;
     BYTE source_buffer[1024];
+    ULONGLONG stream_pos;
     UINT stride;
     BYTE *image_data;
+    BOOL decode_failed;
 };
 
 static inline struct jpeg_decoder *impl_from_decoder(struct decoder* iface)
@@ -241,7 +243,6 @@ static HRESULT CDECL jpeg_decoder_initialize(struct decoder* iface, IStream *str
     struct jpeg_decoder *This = impl_from_decoder(iface);
     int ret;
     jmp_buf jmpbuf;
-    UINT data_size, i;
 
     if (This->cinfo_initialized)
         return WINCODEC_ERR_WRONGSTATE;
@@ -337,13 +338,55 @@ static HRESULT CDECL jpeg_decoder_initialize(struct decoder* iface, IStream *str
     This->frame.num_colors = 0;
 
     This->stride = (This->frame.bpp * This->cinfo.output_width + 7) / 8;
-    data_size = This->stride * This->cinfo.output_height;
 
-    This->image_data = malloc(data_size);
+    /* scanlines are decoded on demand by copy_pixels, remember where the decompressor left the stream */
+    stream_seek(This->stream, 0, STREAM_SEEK_CUR, &This->stream_pos);
+
+    st->frame_count = 1;
+    st->flags = WICBitmapDecoderCapabilityCanDecodeAllImages |
+                WICBitmapDecoderCapabilityCanDecodeSomeImages |
+                WICBitmapDecoderCapabilityCanEnumerateMetadata |
+                DECODER_FLAGS_UNSUPPORTED_COLOR_CONTEXT;
+    return S_OK;
+}
+
+static HRESULT CDECL jpeg_decoder_get_frame_info(struct decoder* iface, UINT frame, struct decoder_frame *info)
+{
+    struct jpeg_decoder *This = impl_from_decoder(iface);
+    *info = This->frame;
+    return S_OK;
+}
+
+static HRESULT jpeg_decoder_read_scanlines(struct jpeg_decoder *This, UINT last_scanline)
+{
+    jmp_buf jmpbuf;
+    UINT i;
+
+    if (This->cinfo.output_scanline >= last_scanline)
+        return S_OK;
+
+    if (This->decode_failed)
+        return E_FAIL;
+
     if (!This->image_data)
-        return E_OUTOFMEMORY;
+    {
+        This->image_data = malloc(This->stride * This->cinfo.output_height);
+        if (!This->image_data)
+            return E_OUTOFMEMORY;
+    }
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        This->decode_failed = TRUE;
+        return E_FAIL;
+    }
 
-    while (This->cinfo.output_scanline < This->cinfo.output_height)
+    /* the stream may have been used for metadata in the meantime */
+    stream_seek(This->stream, This->stream_pos, STREAM_SEEK_SET, NULL);
+
+    while (This->cinfo.output_scanline < last_scanline)
     {
         UINT first_scanline = This->cinfo.output_scanline;
         UINT max_rows;
@@ -358,37 +401,25 @@ static HRESULT CDECL jpeg_decoder_initialize(struct decoder* iface, IStream *str
         if (ret == 0)
         {
             ERR("read_scanlines failed\n");
+            This->decode_failed = TRUE;
             return E_FAIL;
         }
-    }
 
-    if (This->frame.bpp == 24)
-    {
-        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
-        reverse_bgr8(3, This->image_data,
-            This->cinfo.output_width, This->cinfo.output_height,
-            This->stride);
-    }
+        if (This->frame.bpp == 24)
+        {
+            /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
+            reverse_bgr8(3, out_rows[0], This->cinfo.output_width, ret, This->stride);
+        }
 
-    if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
-    {
-        /* Adobe JPEG's have inverted CMYK data. */
-        for (i=0; i<data_size; i++)
-            This->image_data[i] ^= 0xff;
+        if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
+        {
+            /* Adobe JPEG's have inverted CMYK data. */
+            for (i=0; i<This->stride * ret; i++)
+                out_rows[0][i] ^= 0xff;
+        }
     }
 
-    st->frame_count = 1;
-    st->flags = WICBitmapDecoderCapabilityCanDecodeAllImages |
-                WICBitmapDecoderCapabilityCanDecodeSomeImages |
-                WICBitmapDecoderCapabilityCanEnumerateMetadata |
-                DECODER_FLAGS_UNSUPPORTED_COLOR_CONTEXT;
-    return S_OK;
-}
-
-static HRESULT CDECL jpeg_decoder_get_frame_info(struct decoder* iface, UINT frame, struct decoder_frame *info)
-{
-    struct jpeg_decoder *This = impl_from_decoder(iface);
-    *info = This->frame;
+    stream_seek(This->stream, 0, STREAM_SEEK_CUR, &This->stream_pos);
     return S_OK;
 }
 
@@ -396,6 +427,13 @@ static HRESULT CDECL jpeg_decoder_copy_pixels(struct decoder* iface, UINT frame,
     const WICRect *prc, UINT stride, UINT buffersize, BYTE *buffer)
 {
     struct jpeg_decoder *This = impl_from_decoder(iface);
+    HRESULT hr;
+
+    /* only decode as far down as the requested rectangle reaches */
+    hr = jpeg_decoder_read_scanlines(This, prc ? prc->Y + prc->Height : This->frame.height);
+    if (FAILED(hr))
+        return hr;
+
     return copy_pixels(This->frame.bpp, This->image_data,
         This->frame.width, This->frame.height, This->stride,
         prc, stride, buffersize, buffer);
@@ -444,6 +482,7 @@ HRESULT CDECL jpeg_decoder_create(struct decoder_info *info, struct decoder **re
     This->cinfo_initialized = FALSE;
     This->stream = NULL;
     This->image_data = NULL;
+    This->decode_failed = FALSE;
     *result = &This->decoder;
 
     info->container_format = GUID_ContainerFormatJpeg;
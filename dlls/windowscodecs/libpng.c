@@ -66,6 +66,7 @@ MAKE_FUNCPTR(png_get_PLTE);
 MAKE_FUNCPTR(png_get_tRNS);
 MAKE_FUNCPTR(png_read_image);
 MAKE_FUNCPTR(png_read_info);
+MAKE_FUNCPTR(png_read_row);
 MAKE_FUNCPTR(png_set_bgr);
 MAKE_FUNCPTR(png_set_crc_action);
 MAKE_FUNCPTR(png_set_error_fn);
@@ -128,6 +129,7 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_get_tRNS);
         LOAD_FUNCPTR(png_read_image);
         LOAD_FUNCPTR(png_read_info);
+        LOAD_FUNCPTR(png_read_row);
         LOAD_FUNCPTR(png_set_bgr);
         LOAD_FUNCPTR(png_set_crc_action);
         LOAD_FUNCPTR(png_set_error_fn);
@@ -161,8 +163,13 @@ struct png_decoder
 {
     struct decoder decoder;
     IStream *stream;
+    ULONGLONG stream_pos;
+    png_structp png_ptr;
+    png_infop info_ptr;
+    int passes;
     struct decoder_frame decoder_frame;
     UINT stride;
+    UINT rows_read;
     BYTE *image_bits;
     BYTE *color_profile;
     DWORD color_profile_len;
@@ -220,8 +227,6 @@ HRESULT CDECL png_decoder_initialize(struct decoder *iface, IStream *stream, str
     png_colorp png_palette;
     int num_palette;
     int i;
-    UINT image_size;
-    png_bytep *row_pointers=NULL;
     png_charp cp_name;
     png_bytep cp_profile;
     png_uint_32 cp_len;
@@ -436,31 +441,11 @@ HRESULT CDECL png_decoder_initialize(struct decoder *iface, IStream *stream, str
     }
 
     This->stride = (This->decoder_frame.width * This->decoder_frame.bpp + 7) / 8;
-    image_size = This->stride * This->decoder_frame.height;
-
-    This->image_bits = malloc(image_size);
-    if (!This->image_bits)
-    {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
-
-    row_pointers = malloc(sizeof(png_bytep)*This->decoder_frame.height);
-    if (!row_pointers)
-    {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
 
-    for (i=0; i<This->decoder_frame.height; i++)
-        row_pointers[i] = This->image_bits + i * This->stride;
-
-    ppng_read_image(png_ptr, row_pointers);
-
-    free(row_pointers);
-    row_pointers = NULL;
-
-    /* png_read_end intentionally not called to not seek to the end of the file */
+    /* the image data is decoded on demand by copy_pixels */
+    This->passes = ppng_set_interlace_handling(png_ptr);
+    This->rows_read = 0;
+    stream_seek(stream, 0, STREAM_SEEK_CUR, &This->stream_pos);
 
     st->flags = WICBitmapDecoderCapabilityCanDecodeAllImages |
                 WICBitmapDecoderCapabilityCanDecodeSomeImages |
@@ -472,12 +457,14 @@ HRESULT CDECL png_decoder_initialize(struct decoder *iface, IStream *stream, str
     hr = S_OK;
 
 end:
-    ppng_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-    free(row_pointers);
-    if (FAILED(hr))
+    if (SUCCEEDED(hr))
+    {
+        This->png_ptr = png_ptr;
+        This->info_ptr = info_ptr;
+    }
+    else
     {
-        free(This->image_bits);
-        This->image_bits = NULL;
+        ppng_destroy_read_struct(&png_ptr, &info_ptr, NULL);
         free(This->color_profile);
         This->color_profile = NULL;
     }
@@ -491,10 +478,82 @@ HRESULT CDECL png_decoder_get_frame_info(struct decoder *iface, UINT frame, stru
     return S_OK;
 }
 
+static HRESULT png_decoder_read_rows(struct png_decoder *This, UINT last_row)
+{
+    jmp_buf jmpbuf;
+    png_bytep *row_pointers = NULL;
+    UINT i;
+
+    if (This->rows_read >= last_row)
+        return S_OK;
+
+    /* decoding failed earlier */
+    if (!This->png_ptr)
+        return E_FAIL;
+
+    if (!This->image_bits)
+    {
+        This->image_bits = malloc(This->stride * This->decoder_frame.height);
+        if (!This->image_bits)
+            return E_OUTOFMEMORY;
+    }
+
+    if (This->passes > 1)
+    {
+        /* interlaced images can only be decoded as a whole */
+        row_pointers = malloc(sizeof(png_bytep) * This->decoder_frame.height);
+        if (!row_pointers)
+            return E_OUTOFMEMORY;
+
+        for (i=0; i<This->decoder_frame.height; i++)
+            row_pointers[i] = This->image_bits + i * This->stride;
+    }
+
+    if (setjmp(jmpbuf))
+    {
+        free(row_pointers);
+        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, NULL);
+        return E_FAIL;
+    }
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+
+    /* the stream may have been used for metadata in the meantime */
+    stream_seek(This->stream, This->stream_pos, STREAM_SEEK_SET, NULL);
+
+    if (row_pointers)
+    {
+        ppng_read_image(This->png_ptr, row_pointers);
+        This->rows_read = This->decoder_frame.height;
+        free(row_pointers);
+    }
+    else
+    {
+        while (This->rows_read < last_row)
+        {
+            ppng_read_row(This->png_ptr, This->image_bits + This->rows_read * This->stride, NULL);
+            This->rows_read++;
+        }
+    }
+
+    /* png_read_end intentionally not called to not seek to the end of the file */
+    if (This->rows_read == This->decoder_frame.height)
+        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, NULL);
+    else
+        stream_seek(This->stream, 0, STREAM_SEEK_CUR, &This->stream_pos);
+
+    return S_OK;
+}
+
 HRESULT CDECL png_decoder_copy_pixels(struct decoder *iface, UINT frame,
     const WICRect *prc, UINT stride, UINT buffersize, BYTE *buffer)
 {
     struct png_decoder *This = impl_from_decoder(iface);
+    HRESULT hr;
+
+    /* only decode as far down as the requested rectangle reaches */
+    hr = png_decoder_read_rows(This, prc ? prc->Y + prc->Height : This->decoder_frame.height);
+    if (FAILED(hr))
+        return hr;
 
     return copy_pixels(This->decoder_frame.bpp, This->image_bits,
         This->decoder_frame.width, This->decoder_frame.height, This->stride,
@@ -594,6 +653,8 @@ void CDECL png_decoder_destroy(struct decoder* iface)
 {
     struct png_decoder *This = impl_from_decoder(iface);
 
+    if (This->png_ptr)
+        ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, NULL);
     free(This->image_bits);
     free(This->color_profile);
     RtlFreeHeap(GetProcessHeap(), 0, This);
@@ -626,6 +687,8 @@ HRESULT CDECL png_decoder_create(struct decoder_info *info, struct decoder **res
     }
 
     This->decoder.vtable = &png_decoder_vtable;
+    This->png_ptr = NULL;
+    This->info_ptr = NULL;
     This->image_bits = NULL;
     This->color_profile = NULL;
     *result = &This->decoder;
@@ -192,15 +192,48 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
 {
     UINT i;
     UINT bytesperpixel = This->bpp/8;
-    UINT src_x, src_y;
+    UINT src_x, src_y, rem, step, step_rem;
+    const BYTE *src_row;
 
     src_y = dst_y * This->src_height / This->height - src_data_y;
+    src_row = src_data[src_y];
+
+    /* step through the source with a quotient/remainder pair instead of dividing for every pixel */
+    src_x = dst_x * This->src_width / This->width - src_data_x;
+    rem = dst_x * This->src_width % This->width;
+    step = This->src_width / This->width;
+    step_rem = This->src_width % This->width;
+
+#define COPY_PIXELS(copy) \
+    for (i=0; i<dst_width; i++) \
+    { \
+        copy; \
+        src_x += step; \
+        rem += step_rem; \
+        if (rem >= This->width) \
+        { \
+            rem -= This->width; \
+            src_x++; \
+        } \
+    }
 
-    for (i=0; i<dst_width; i++)
+    switch (bytesperpixel)
     {
-        src_x = (dst_x + i) * This->src_width / This->width - src_data_x;
-        memcpy(pbBuffer + bytesperpixel * i, src_data[src_y] + bytesperpixel * src_x, bytesperpixel);
+    case 1:
+        COPY_PIXELS(pbBuffer[i] = src_row[src_x]);
+        break;
+    case 2:
+        COPY_PIXELS(memcpy(pbBuffer + 2 * i, src_row + 2 * src_x, 2));
+        break;
+    case 4:
+        COPY_PIXELS(memcpy(pbBuffer + 4 * i, src_row + 4 * src_x, 4));
+        break;
+    default:
+        COPY_PIXELS(memcpy(pbBuffer + bytesperpixel * i, src_row + bytesperpixel * src_x, bytesperpixel));
+        break;
     }
+
+#undef COPY_PIXELS
 }
 
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
@@ -309,6 +309,40 @@ static HRESULT wined3d_select_vulkan_queue_family(const struct wined3d_adapter_v
     return E_FAIL;
 }
 
+/* Find a dedicated transfer queue family, typically backed by a DMA engine,
+ * that can copy to images without granularity restrictions. */
+static uint32_t wined3d_select_vulkan_transfer_queue_family(const struct wined3d_adapter_vk *adapter_vk)
+{
+    VkPhysicalDevice physical_device = adapter_vk->physical_device;
+    const struct wined3d_vk_info *vk_info = &adapter_vk->vk_info;
+    VkQueueFamilyProperties *queue_properties;
+    const VkExtent3D *granularity;
+    uint32_t count, i;
+
+    VK_CALL(vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count, NULL));
+
+    if (!(queue_properties = heap_calloc(count, sizeof(*queue_properties))))
+        return ~0u;
+
+    VK_CALL(vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &count, queue_properties));
+
+    for (i = 0; i < count; ++i)
+    {
+        granularity = &queue_properties[i].minImageTransferGranularity;
+        if ((queue_properties[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT))
+                == VK_QUEUE_TRANSFER_BIT && queue_properties[i].queueCount
+                && granularity->width == 1 && granularity->height == 1 && granularity->depth == 1)
+        {
+            heap_free(queue_properties);
+            return i;
+        }
+    }
+    heap_free(queue_properties);
+
+    TRACE("No dedicated transfer queue found.\n");
+    return ~0u;
+}
+
 struct wined3d_physical_device_info
 {
     VkPhysicalDeviceTransformFeedbackFeaturesEXT xfb_features;
@@ -399,6 +433,76 @@ static const struct wined3d_allocator_ops wined3d_allocator_vk_ops =
     .allocator_destroy_chunk = wined3d_allocator_vk_destroy_chunk,
 };
 
+static void wined3d_device_vk_create_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    static const WCHAR extension[] = {'v','k','c','a','c','h','e',0};
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    VkPipelineCacheCreateInfo cache_desc;
+    WCHAR path[MAX_PATH];
+    void *data = NULL;
+    SIZE_T size = 0;
+    VkResult vr;
+
+    /* The driver validates the cache header itself, the UUID in the file
+     * name just avoids thrashing the cache when switching drivers. */
+    if (wined3d_get_cache_file_path(path, ARRAY_SIZE(path), adapter_vk->pipeline_cache_uuid,
+            VK_UUID_SIZE, extension, FALSE))
+        data = wined3d_load_cache_file(path, &size);
+
+    cache_desc.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_desc.pNext = NULL;
+    cache_desc.flags = 0;
+    cache_desc.initialDataSize = size;
+    cache_desc.pInitialData = data;
+    if ((vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_desc,
+            NULL, &device_vk->vk_pipeline_cache))) < 0 && size)
+    {
+        WARN("Failed to create pipeline cache from %s, vr %s.\n",
+                debugstr_w(path), wined3d_debug_vkresult(vr));
+        cache_desc.initialDataSize = size = 0;
+        cache_desc.pInitialData = NULL;
+        vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_desc, NULL, &device_vk->vk_pipeline_cache));
+    }
+    heap_free(data);
+
+    if (vr < 0)
+    {
+        WARN("Failed to create pipeline cache, vr %s.\n", wined3d_debug_vkresult(vr));
+        device_vk->vk_pipeline_cache = VK_NULL_HANDLE;
+        return;
+    }
+
+    TRACE("Loaded %lu bytes of pipeline cache data.\n", (unsigned long)size);
+    device_vk->pipeline_cache_initial_size = size;
+}
+
+static void wined3d_device_vk_destroy_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk, BOOL save)
+{
+    static const WCHAR extension[] = {'v','k','c','a','c','h','e',0};
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    WCHAR path[MAX_PATH];
+    void *data = NULL;
+    size_t size = 0;
+
+    if (!device_vk->vk_pipeline_cache)
+        return;
+
+    /* Only write the cache back if new pipelines were added to it. */
+    if (save && VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache,
+            &size, NULL)) >= 0 && size > device_vk->pipeline_cache_initial_size && size <= 256 * 1024 * 1024
+            && (data = heap_alloc(size))
+            && VK_CALL(vkGetPipelineCacheData(device_vk->vk_device, device_vk->vk_pipeline_cache, &size, data)) >= 0
+            && wined3d_get_cache_file_path(path, ARRAY_SIZE(path), adapter_vk->pipeline_cache_uuid,
+            VK_UUID_SIZE, extension, TRUE))
+        wined3d_save_cache_file(path, data, size);
+    heap_free(data);
+
+    VK_CALL(vkDestroyPipelineCache(device_vk->vk_device, device_vk->vk_pipeline_cache, NULL));
+    device_vk->vk_pipeline_cache = VK_NULL_HANDLE;
+}
+
 static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wined3d_adapter *adapter,
         enum wined3d_device_type device_type, HWND focus_window, unsigned int flags, BYTE surface_alignment,
         const enum wined3d_feature_level *levels, unsigned int level_count,
@@ -413,7 +517,8 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
     VkPhysicalDeviceFeatures2 *features2;
     struct wined3d_device_vk *device_vk;
     VkDevice vk_device = VK_NULL_HANDLE;
-    VkDeviceQueueCreateInfo queue_info;
+    VkDeviceQueueCreateInfo queue_info[2];
+    uint32_t transfer_queue_family_index;
     VkPhysicalDevice physical_device;
     VkDeviceCreateInfo device_info;
     uint32_t queue_family_index;
@@ -426,6 +531,7 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
 
     if (FAILED(hr = wined3d_select_vulkan_queue_family(adapter_vk, &queue_family_index, &timestamp_bits)))
         goto fail;
+    transfer_queue_family_index = wined3d_select_vulkan_transfer_queue_family(adapter_vk);
 
     physical_device = adapter_vk->physical_device;
 
@@ -456,18 +562,21 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
 
     wined3d_disable_vulkan_features(&physical_device_info);
 
-    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queue_info.pNext = NULL;
-    queue_info.flags = 0;
-    queue_info.queueFamilyIndex = queue_family_index;
-    queue_info.queueCount = ARRAY_SIZE(priorities);
-    queue_info.pQueuePriorities = priorities;
+    queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info[0].pNext = NULL;
+    queue_info[0].flags = 0;
+    queue_info[0].queueFamilyIndex = queue_family_index;
+    queue_info[0].queueCount = ARRAY_SIZE(priorities);
+    queue_info[0].pQueuePriorities = priorities;
+
+    queue_info[1] = queue_info[0];
+    queue_info[1].queueFamilyIndex = transfer_queue_family_index;
 
     device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     device_info.pNext = features2->pNext;
     device_info.flags = 0;
-    device_info.queueCreateInfoCount = 1;
-    device_info.pQueueCreateInfos = &queue_info;
+    device_info.queueCreateInfoCount = transfer_queue_family_index != ~0u ? 2 : 1;
+    device_info.pQueueCreateInfos = queue_info;
     device_info.enabledLayerCount = 0;
     device_info.ppEnabledLayerNames = NULL;
     device_info.enabledExtensionCount = adapter_vk->device_extension_count;
@@ -485,6 +594,11 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
     device_vk->vk_device = vk_device;
     VK_CALL(vkGetDeviceQueue(vk_device, queue_family_index, 0, &device_vk->vk_queue));
     device_vk->vk_queue_family_index = queue_family_index;
+    if (transfer_queue_family_index != ~0u)
+    {
+        VK_CALL(vkGetDeviceQueue(vk_device, transfer_queue_family_index, 0, &device_vk->vk_transfer_queue));
+        device_vk->vk_transfer_queue_family_index = transfer_queue_family_index;
+    }
     device_vk->timestamp_bits = timestamp_bits;
 
     device_vk->vk_info = *vk_info;
@@ -509,10 +623,13 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
         goto fail;
     }
 
+    wined3d_device_vk_create_pipeline_cache(device_vk, adapter_vk);
+
     if (FAILED(hr = wined3d_device_init(&device_vk->d, wined3d, adapter->ordinal, device_type, focus_window,
             flags, surface_alignment, levels, level_count, vk_info->supported, device_parent)))
     {
         WARN("Failed to initialize device, hr %#x.\n", hr);
+        wined3d_device_vk_destroy_pipeline_cache(device_vk, adapter_vk, FALSE);
         wined3d_allocator_cleanup(&device_vk->allocator);
         goto fail;
     }
@@ -533,6 +650,7 @@ static void adapter_vk_destroy_device(struct wined3d_device *device)
     const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
 
     wined3d_device_cleanup(&device_vk->d);
+    wined3d_device_vk_destroy_pipeline_cache(device_vk, wined3d_adapter_vk_const(device->adapter), TRUE);
     wined3d_allocator_cleanup(&device_vk->allocator);
     VK_CALL(vkDestroyDevice(device_vk->vk_device, NULL));
     heap_free(device_vk);
@@ -1097,6 +1215,13 @@ static void adapter_vk_copy_bo_address(struct wined3d_context *context,
     if (dst_bo && (dst_bo->command_buffer_id > context_vk->completed_command_buffer_id
             || !(dst_bo->memory_type & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)))
     {
+        if (!src_bo && (dst_ptr = wined3d_context_vk_get_upload_memory(context_vk, size, &staging)))
+        {
+            memcpy(dst_ptr, src->addr, size);
+            adapter_vk_copy_bo_address(context, dst, &staging, size);
+            return;
+        }
+
         if (!(wined3d_context_vk_create_bo(context_vk, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &staging_bo)))
         {
@@ -2190,6 +2315,7 @@ static bool wined3d_adapter_vk_init_device_extensions(struct wined3d_adapter_vk
         {VK_EXT_TRANSFORM_FEEDBACK_EXTENSION_NAME,          ~0u},
         {VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_EXTENSION_NAME,    ~0u,                true},
         {VK_KHR_MAINTENANCE1_EXTENSION_NAME,                VK_API_VERSION_1_1, true},
+        {VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME,             ~0u},
         {VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE_EXTENSION_NAME,VK_API_VERSION_1_2},
         {VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME,      VK_API_VERSION_1_1, true},
         {VK_KHR_SWAPCHAIN_EXTENSION_NAME,                   ~0u,                true},
@@ -2203,6 +2329,7 @@ static bool wined3d_adapter_vk_init_device_extensions(struct wined3d_adapter_vk
     map[] =
     {
         {VK_EXT_TRANSFORM_FEEDBACK_EXTENSION_NAME,           WINED3D_VK_EXT_TRANSFORM_FEEDBACK},
+        {VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME,              WINED3D_VK_KHR_PUSH_DESCRIPTOR},
         {VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE_EXTENSION_NAME, WINED3D_VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE},
     };
 
@@ -2294,6 +2421,7 @@ static BOOL wined3d_adapter_vk_init(struct wined3d_adapter_vk *adapter_vk,
 {
     struct wined3d_vk_info *vk_info = &adapter_vk->vk_info;
     struct wined3d_adapter *adapter = &adapter_vk->a;
+    VkPhysicalDevicePushDescriptorPropertiesKHR push_descriptor_properties;
     VkPhysicalDeviceIDProperties id_properties;
     VkPhysicalDeviceProperties2 properties2;
     LUID primary_luid, *luid = NULL;
@@ -2315,6 +2443,10 @@ static BOOL wined3d_adapter_vk_init(struct wined3d_adapter_vk *adapter_vk,
 
     memset(&id_properties, 0, sizeof(id_properties));
     id_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    memset(&push_descriptor_properties, 0, sizeof(push_descriptor_properties));
+    push_descriptor_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+    if (vk_info->supported[WINED3D_VK_KHR_PUSH_DESCRIPTOR])
+        id_properties.pNext = &push_descriptor_properties;
     properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
     properties2.pNext = &id_properties;
 
@@ -2323,6 +2455,8 @@ static BOOL wined3d_adapter_vk_init(struct wined3d_adapter_vk *adapter_vk,
     else
         VK_CALL(vkGetPhysicalDeviceProperties(adapter_vk->physical_device, &properties2.properties));
     adapter_vk->device_limits = properties2.properties.limits;
+    memcpy(adapter_vk->pipeline_cache_uuid, properties2.properties.pipelineCacheUUID, VK_UUID_SIZE);
+    adapter_vk->max_push_descriptors = push_descriptor_properties.maxPushDescriptors;
 
     VK_CALL(vkGetPhysicalDeviceMemoryProperties(adapter_vk->physical_device, &adapter_vk->memory_properties));
 
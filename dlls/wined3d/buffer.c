@@ -184,6 +184,15 @@ static BOOL wined3d_buffer_gl_create_buffer_object(struct wined3d_buffer_gl *buf
         coherent = false;
     }
     gl_storage_flags = wined3d_resource_gl_storage_flags(&buffer_gl->b.resource);
+    /* Dynamic buffers are mapped once and stay mapped, which avoids a
+     * glMapBufferRange()/glUnmapBuffer() pair for every DISCARD or
+     * NOOVERWRITE map. */
+    if (gl_info->supported[ARB_BUFFER_STORAGE] && (buffer_gl->b.resource.usage & WINED3DUSAGE_DYNAMIC)
+            && (gl_storage_flags & GL_MAP_WRITE_BIT))
+    {
+        gl_storage_flags |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        coherent = true;
+    }
     bo = &buffer_gl->bo;
     if (!wined3d_context_gl_create_bo(context_gl, size, binding, usage, coherent, gl_storage_flags, bo))
     {
@@ -1299,6 +1308,20 @@ static void wined3d_buffer_gl_upload_ranges(struct wined3d_buffer *buffer, struc
     TRACE("buffer %p, context %p, data %p, data_offset %u, range_count %u, ranges %p.\n",
             buffer, context, data, data_offset, range_count, ranges);
 
+    /* Write directly through the persistent mapping when the GPU is done
+     * with the buffer object. */
+    if (buffer_gl->bo.map_ptr && (buffer_gl->bo.command_fence_id
+            <= wined3d_device_gl(context->device)->completed_fence_id))
+    {
+        while (range_count--)
+        {
+            range = &ranges[range_count];
+            memcpy((BYTE *)buffer_gl->bo.map_ptr + range->offset,
+                    (BYTE *)data + range->offset - data_offset, range->size);
+        }
+        return;
+    }
+
     wined3d_buffer_gl_bind(buffer_gl, context_gl);
 
     while (range_count--)
@@ -1345,6 +1345,7 @@ static void wined3d_context_gl_cleanup(struct wined3d_context_gl *context_gl)
     struct wined3d_pipeline_statistics_query *pipeline_statistics_query;
     const struct wined3d_gl_info *gl_info = context_gl->gl_info;
     struct wined3d_so_statistics_query *so_statistics_query;
+    struct wined3d_retired_bo_gl *retired_bo, *next_bo;
     struct wined3d_timestamp_query *timestamp_query;
     struct wined3d_occlusion_query *occlusion_query;
     struct fbo_entry *entry, *entry2;
@@ -1384,6 +1385,11 @@ static void wined3d_context_gl_cleanup(struct wined3d_context_gl *context_gl)
         if (context_gl->blit_vbo)
             GL_EXTCALL(glDeleteBuffers(1, &context_gl->blit_vbo));
 
+        LIST_FOR_EACH_ENTRY(retired_bo, &context_gl->retired_bos, struct wined3d_retired_bo_gl, entry)
+        {
+            wined3d_context_gl_destroy_bo(context_gl, &retired_bo->bo);
+        }
+
         for (i = 0; i < context_gl->free_pipeline_statistics_query_count; ++i)
         {
             union wined3d_gl_pipeline_statistics_query *q = &context_gl->free_pipeline_statistics_queries[i];
@@ -1426,6 +1432,10 @@ static void wined3d_context_gl_cleanup(struct wined3d_context_gl *context_gl)
 
         checkGLcall("context cleanup");
     }
+    LIST_FOR_EACH_ENTRY_SAFE(retired_bo, next_bo, &context_gl->retired_bos, struct wined3d_retired_bo_gl, entry)
+    {
+        heap_free(retired_bo);
+    }
     heap_free(context_gl->submitted.fences);
     heap_free(context_gl->free_pipeline_statistics_queries);
     heap_free(context_gl->free_so_statistics_queries);
@@ -2085,6 +2095,7 @@ HRESULT wined3d_context_gl_init(struct wined3d_context_gl *context_gl, struct wi
     list_init(&context_gl->timestamp_queries);
     list_init(&context_gl->so_statistics_queries);
     list_init(&context_gl->pipeline_statistics_queries);
+    list_init(&context_gl->retired_bos);
 
     for (i = 0; i < ARRAY_SIZE(context_gl->tex_unit_map); ++i)
         context_gl->tex_unit_map[i] = WINED3D_UNMAPPED_STAGE;
@@ -2650,6 +2661,47 @@ void wined3d_context_gl_submit_command_fence(struct wined3d_context_gl *context_
     wined3d_context_gl_poll_fences(context_gl);
 }
 
+static bool wined3d_context_gl_get_retired_bo(struct wined3d_context_gl *context_gl,
+        const struct wined3d_bo_gl *bo, struct wined3d_bo_gl *ret)
+{
+    struct wined3d_device_gl *device_gl = wined3d_device_gl(context_gl->c.device);
+    struct wined3d_retired_bo_gl *retired_bo;
+
+    LIST_FOR_EACH_ENTRY(retired_bo, &context_gl->retired_bos, struct wined3d_retired_bo_gl, entry)
+    {
+        if (retired_bo->bo.size != bo->size || retired_bo->bo.binding != bo->binding
+                || retired_bo->bo.flags != bo->flags)
+            continue;
+        if (retired_bo->bo.command_fence_id > device_gl->completed_fence_id
+                && retired_bo->bo.command_fence_id <= device_gl->current_fence_id)
+            continue;
+
+        *ret = retired_bo->bo;
+        list_init(&ret->users);
+        list_remove(&retired_bo->entry);
+        heap_free(retired_bo);
+        --context_gl->retired_bo_count;
+        return true;
+    }
+
+    return false;
+}
+
+static void wined3d_context_gl_retire_bo(struct wined3d_context_gl *context_gl, struct wined3d_bo_gl *bo)
+{
+    struct wined3d_retired_bo_gl *retired_bo;
+
+    if (!bo->map_ptr || context_gl->retired_bo_count >= 64 || !(retired_bo = heap_alloc(sizeof(*retired_bo))))
+    {
+        wined3d_context_gl_destroy_bo(context_gl, bo);
+        return;
+    }
+
+    retired_bo->bo = *bo;
+    list_add_head(&context_gl->retired_bos, &retired_bo->entry);
+    ++context_gl->retired_bo_count;
+}
+
 static void *wined3d_bo_gl_map(struct wined3d_bo_gl *bo,
         struct wined3d_context_gl *context_gl, size_t offset, size_t size, uint32_t flags)
 {
@@ -2664,11 +2716,11 @@ static void *wined3d_bo_gl_map(struct wined3d_bo_gl *bo,
 
     if ((flags & WINED3D_MAP_DISCARD) && bo->command_fence_id > device_gl->completed_fence_id)
     {
-        if (wined3d_context_gl_create_bo(context_gl, bo->size,
-                bo->binding, bo->usage, bo->coherent, bo->flags, &tmp))
+        if (wined3d_context_gl_get_retired_bo(context_gl, bo, &tmp) || wined3d_context_gl_create_bo(context_gl,
+                bo->size, bo->binding, bo->usage, bo->coherent, bo->flags, &tmp))
         {
             list_move_head(&tmp.users, &bo->users);
-            wined3d_context_gl_destroy_bo(context_gl, bo);
+            wined3d_context_gl_retire_bo(context_gl, bo);
             *bo = tmp;
             list_init(&bo->users);
             list_move_head(&bo->users, &tmp.users);
@@ -2689,6 +2741,21 @@ static void *wined3d_bo_gl_map(struct wined3d_bo_gl *bo,
 
 map:
     gl_info = context_gl->gl_info;
+
+    if (bo->flags & GL_MAP_PERSISTENT_BIT)
+    {
+        if (!bo->map_ptr)
+        {
+            wined3d_context_gl_bind_bo(context_gl, bo->binding, bo->id);
+            bo->map_ptr = GL_EXTCALL(glMapBufferRange(bo->binding, 0, bo->size,
+                    bo->flags & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)));
+            wined3d_context_gl_bind_bo(context_gl, bo->binding, 0);
+            checkGLcall("Map persistent buffer object");
+        }
+
+        return bo->map_ptr ? (uint8_t *)bo->map_ptr + offset : NULL;
+    }
+
     wined3d_context_gl_bind_bo(context_gl, bo->binding, bo->id);
 
     if (gl_info->supported[ARB_MAP_BUFFER_RANGE])
@@ -2732,6 +2799,11 @@ void wined3d_context_gl_unmap_bo_address(struct wined3d_context_gl *context_gl,
     if (!(bo = (struct wined3d_bo_gl *)data->buffer_object))
         return;
 
+    /* Persistent mappings are coherent, and stay mapped until the buffer
+     * object is destroyed. */
+    if (bo->map_ptr)
+        return;
+
     gl_info = context_gl->gl_info;
     wined3d_context_gl_bind_bo(context_gl, bo->binding, bo->id);
 
@@ -2825,9 +2897,11 @@ void wined3d_context_gl_destroy_bo(struct wined3d_context_gl *context_gl, struct
     TRACE("context_gl %p, bo %p.\n", context_gl, bo);
 
     TRACE("Destroying GL buffer %u.\n", bo->id);
+    /* Deleting a buffer object implicitly unmaps it. */
     GL_EXTCALL(glDeleteBuffers(1, &bo->id));
     checkGLcall("buffer object destruction");
     bo->id = 0;
+    bo->map_ptr = NULL;
 }
 
 bool wined3d_context_gl_create_bo(struct wined3d_context_gl *context_gl, GLsizeiptr size,
@@ -2870,6 +2944,7 @@ bool wined3d_context_gl_create_bo(struct wined3d_context_gl *context_gl, GLsizei
     bo->coherent = coherent;
     list_init(&bo->users);
     bo->command_fence_id = 0;
+    bo->map_ptr = NULL;
 
     return true;
 }
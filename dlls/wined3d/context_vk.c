@@ -501,6 +501,71 @@ BOOL wined3d_context_vk_create_bo(struct wined3d_context_vk *context_vk, VkDevic
     return TRUE;
 }
 
+/* Small uploads are staged through a set of persistently mapped buffers
+ * that are suballocated linearly. Once the current buffer is full we move on
+ * to the next one that is no longer in use by the GPU, or create a new one
+ * if there is none. */
+void *wined3d_context_vk_get_upload_memory(struct wined3d_context_vk *context_vk,
+        VkDeviceSize size, struct wined3d_bo_address *address)
+{
+    struct wined3d_bo_address bo_address;
+    unsigned int i, idx, count;
+    VkDeviceSize offset;
+    struct wined3d_bo_vk *bo;
+
+    if (size > WINED3D_VK_UPLOAD_BO_SIZE / 4)
+        return NULL;
+
+    count = context_vk->upload.count;
+    offset = (context_vk->upload.offset + 15) & ~(VkDeviceSize)15;
+    if (!count || offset + size > WINED3D_VK_UPLOAD_BO_SIZE)
+    {
+        wined3d_context_vk_poll_command_buffers(context_vk);
+        for (i = 1, idx = 0; i <= count; ++i)
+        {
+            idx = (context_vk->upload.current + i) % count;
+            if (context_vk->upload.bos[idx].command_buffer_id <= context_vk->completed_command_buffer_id)
+                break;
+        }
+
+        if (i > count)
+        {
+            if (count == WINED3D_VK_UPLOAD_BO_COUNT)
+                return NULL;
+
+            idx = count;
+            bo = &context_vk->upload.bos[idx];
+            if (!wined3d_context_vk_create_bo(context_vk, WINED3D_VK_UPLOAD_BO_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, bo))
+            {
+                WARN("Failed to create upload bo.\n");
+                return NULL;
+            }
+
+            bo_address.buffer_object = (uintptr_t)bo;
+            bo_address.addr = NULL;
+            if (!(context_vk->upload.map_ptrs[idx] = wined3d_context_map_bo_address(&context_vk->c,
+                    &bo_address, WINED3D_VK_UPLOAD_BO_SIZE, WINED3D_MAP_WRITE | WINED3D_MAP_NOOVERWRITE)))
+            {
+                ERR("Failed to map upload bo.\n");
+                wined3d_context_vk_destroy_bo(context_vk, bo);
+                return NULL;
+            }
+            TRACE("Created upload bo %u.\n", idx);
+            ++context_vk->upload.count;
+        }
+
+        context_vk->upload.current = idx;
+        offset = 0;
+    }
+
+    context_vk->upload.offset = offset + size;
+    address->buffer_object = (uintptr_t)&context_vk->upload.bos[context_vk->upload.current];
+    address->addr = (void *)(uintptr_t)offset;
+
+    return context_vk->upload.map_ptrs[context_vk->upload.current] + offset;
+}
+
 static struct wined3d_retired_object_vk *wined3d_context_vk_get_retired_object_vk(struct wined3d_context_vk *context_vk)
 {
     struct wined3d_retired_objects_vk *retired = &context_vk->retired;
@@ -570,6 +635,22 @@ static void wined3d_context_vk_destroy_descriptor_pool(struct wined3d_context_vk
     o->command_buffer_id = command_buffer_id;
 }
 
+static void wined3d_context_vk_destroy_descriptor_set(struct wine_rb_entry *entry, void *ctx)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct wined3d_descriptor_set_vk, entry));
+}
+
+/* Cached descriptor sets refer to buffers, views and samplers by handle.
+ * Since handles can be reused once the object they refer to is destroyed,
+ * the cache is flushed whenever one of those objects is. */
+static void wined3d_context_vk_clear_descriptor_sets(struct wined3d_context_vk *context_vk)
+{
+    if (!context_vk->descriptor_sets.root)
+        return;
+
+    wine_rb_destroy(&context_vk->descriptor_sets, wined3d_context_vk_destroy_descriptor_set, NULL);
+}
+
 void wined3d_context_vk_destroy_memory(struct wined3d_context_vk *context_vk,
         VkDeviceMemory vk_memory, uint64_t command_buffer_id)
 {
@@ -675,6 +756,8 @@ static void wined3d_context_vk_destroy_buffer(struct wined3d_context_vk *context
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_retired_object_vk *o;
 
+    wined3d_context_vk_clear_descriptor_sets(context_vk);
+
     if (context_vk->completed_command_buffer_id > command_buffer_id)
     {
         VK_CALL(vkDestroyBuffer(device_vk->vk_device, vk_buffer, NULL));
@@ -725,6 +808,8 @@ void wined3d_context_vk_destroy_buffer_view(struct wined3d_context_vk *context_v
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_retired_object_vk *o;
 
+    wined3d_context_vk_clear_descriptor_sets(context_vk);
+
     if (context_vk->completed_command_buffer_id > command_buffer_id)
     {
         VK_CALL(vkDestroyBufferView(device_vk->vk_device, vk_view, NULL));
@@ -750,6 +835,8 @@ void wined3d_context_vk_destroy_image_view(struct wined3d_context_vk *context_vk
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_retired_object_vk *o;
 
+    wined3d_context_vk_clear_descriptor_sets(context_vk);
+
     if (context_vk->completed_command_buffer_id > command_buffer_id)
     {
         VK_CALL(vkDestroyImageView(device_vk->vk_device, vk_view, NULL));
@@ -775,6 +862,8 @@ void wined3d_context_vk_destroy_sampler(struct wined3d_context_vk *context_vk,
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_retired_object_vk *o;
 
+    wined3d_context_vk_clear_descriptor_sets(context_vk);
+
     if (context_vk->completed_command_buffer_id > command_buffer_id)
     {
         VK_CALL(vkDestroySampler(device_vk->vk_device, vk_sampler, NULL));
@@ -847,6 +936,14 @@ void wined3d_context_vk_poll_command_buffers(struct wined3d_context_vk *context_
         VK_CALL(vkDestroyFence(device_vk->vk_device, buffer->vk_fence, NULL));
         VK_CALL(vkFreeCommandBuffers(device_vk->vk_device,
                 context_vk->vk_command_pool, 1, &buffer->vk_command_buffer));
+        /* The command buffer waited for the transfer semaphore, so the
+         * transfer command buffer has finished as well. */
+        if (buffer->vk_transfer_command_buffer)
+        {
+            VK_CALL(vkFreeCommandBuffers(device_vk->vk_device,
+                    context_vk->vk_transfer_command_pool, 1, &buffer->vk_transfer_command_buffer));
+            VK_CALL(vkDestroySemaphore(device_vk->vk_device, buffer->vk_transfer_semaphore, NULL));
+        }
 
         if (buffer->id > context_vk->completed_command_buffer_id)
             context_vk->completed_command_buffer_id = buffer->id;
@@ -1213,6 +1310,7 @@ static void wined3d_context_vk_destroy_render_pass(struct wine_rb_entry *entry,
 
 static void wined3d_shader_descriptor_writes_vk_cleanup(struct wined3d_shader_descriptor_writes_vk *writes)
 {
+    heap_free(writes->key_entries);
     heap_free(writes->writes);
 }
 
@@ -1295,6 +1393,7 @@ void wined3d_context_vk_cleanup(struct wined3d_context_vk *context_vk)
     struct wined3d_command_buffer_vk *buffer = &context_vk->current_command_buffer;
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    unsigned int i;
 
     if (buffer->vk_command_buffer)
     {
@@ -1302,19 +1401,35 @@ void wined3d_context_vk_cleanup(struct wined3d_context_vk *context_vk)
                 context_vk->vk_command_pool, 1, &buffer->vk_command_buffer));
         buffer->vk_command_buffer = VK_NULL_HANDLE;
     }
+    if (buffer->vk_transfer_command_buffer)
+    {
+        VK_CALL(vkFreeCommandBuffers(device_vk->vk_device,
+                context_vk->vk_transfer_command_pool, 1, &buffer->vk_transfer_command_buffer));
+        VK_CALL(vkDestroySemaphore(device_vk->vk_device, buffer->vk_transfer_semaphore, NULL));
+        buffer->vk_transfer_command_buffer = VK_NULL_HANDLE;
+        buffer->vk_transfer_semaphore = VK_NULL_HANDLE;
+    }
 
     wined3d_context_vk_wait_command_buffer(context_vk, buffer->id - 1);
     context_vk->completed_command_buffer_id = buffer->id;
 
     heap_free(context_vk->compute.bindings.bindings);
     heap_free(context_vk->graphics.bindings.bindings);
+    wine_rb_destroy(&context_vk->descriptor_sets, wined3d_context_vk_destroy_descriptor_set, NULL);
     if (context_vk->vk_descriptor_pool)
         VK_CALL(vkDestroyDescriptorPool(device_vk->vk_device, context_vk->vk_descriptor_pool, NULL));
     if (context_vk->vk_framebuffer)
         VK_CALL(vkDestroyFramebuffer(device_vk->vk_device, context_vk->vk_framebuffer, NULL));
     VK_CALL(vkDestroyCommandPool(device_vk->vk_device, context_vk->vk_command_pool, NULL));
+    if (context_vk->vk_transfer_command_pool)
+        VK_CALL(vkDestroyCommandPool(device_vk->vk_device, context_vk->vk_transfer_command_pool, NULL));
     if (context_vk->vk_so_counter_bo.vk_buffer)
         wined3d_context_vk_destroy_bo(context_vk, &context_vk->vk_so_counter_bo);
+    for (i = 0; i < context_vk->upload.count; ++i)
+    {
+        wined3d_context_vk_destroy_bo(context_vk, &context_vk->upload.bos[i]);
+    }
+    context_vk->upload.count = 0;
     wined3d_context_vk_cleanup_resources(context_vk);
     wined3d_context_vk_destroy_query_pools(context_vk, &context_vk->free_occlusion_query_pools);
     wined3d_context_vk_destroy_query_pools(context_vk, &context_vk->free_timestamp_query_pools);
@@ -1347,7 +1462,10 @@ void wined3d_context_vk_remove_pending_queries(struct wined3d_context_vk *contex
 
         if (p->query_vk)
         {
-            if (p->query_vk != query_vk && !wined3d_query_vk_accumulate_data(p->query_vk, context_vk, &p->pool_idx))
+            /* Results can't be available before the command buffer that
+             * ended the query has completed; don't bother asking. */
+            if (p->query_vk != query_vk && (p->command_buffer_id > context_vk->completed_command_buffer_id
+                    || !wined3d_query_vk_accumulate_data(p->query_vk, context_vk, &p->pool_idx)))
                 continue;
             wined3d_query_pool_vk_free_query(p->pool_idx.pool_vk, p->pool_idx.idx);
             --p->query_vk->pending_count;
@@ -1394,6 +1512,7 @@ void wined3d_context_vk_add_pending_query(struct wined3d_context_vk *context_vk,
 
     p->query_vk = query_vk;
     p->pool_idx = query_vk->pool_idx;
+    p->command_buffer_id = context_vk->current_command_buffer.id;
     ++query_vk->pending_count;
 }
 
@@ -1453,16 +1572,87 @@ VkCommandBuffer wined3d_context_vk_get_command_buffer(struct wined3d_context_vk
     return buffer->vk_command_buffer;
 }
 
+VkCommandBuffer wined3d_context_vk_get_transfer_command_buffer(struct wined3d_context_vk *context_vk)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    VkCommandBufferAllocateInfo command_buffer_info;
+    VkSemaphoreCreateInfo semaphore_info;
+    struct wined3d_command_buffer_vk *buffer;
+    VkCommandBufferBeginInfo begin_info;
+    VkResult vr;
+
+    TRACE("context_vk %p.\n", context_vk);
+
+    if (!context_vk->vk_transfer_command_pool)
+        return VK_NULL_HANDLE;
+
+    buffer = &context_vk->current_command_buffer;
+    if (buffer->vk_transfer_command_buffer)
+        return buffer->vk_transfer_command_buffer;
+
+    /* The transfer command buffer is submitted together with the current
+     * command buffer, and shares its id. */
+    if (!wined3d_context_vk_get_command_buffer(context_vk))
+        return VK_NULL_HANDLE;
+
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = NULL;
+    semaphore_info.flags = 0;
+    if ((vr = VK_CALL(vkCreateSemaphore(device_vk->vk_device,
+            &semaphore_info, NULL, &buffer->vk_transfer_semaphore))) < 0)
+    {
+        WARN("Failed to create semaphore, vr %s.\n", wined3d_debug_vkresult(vr));
+        return buffer->vk_transfer_semaphore = VK_NULL_HANDLE;
+    }
+
+    command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_buffer_info.pNext = NULL;
+    command_buffer_info.commandPool = context_vk->vk_transfer_command_pool;
+    command_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_buffer_info.commandBufferCount = 1;
+    if ((vr = VK_CALL(vkAllocateCommandBuffers(device_vk->vk_device,
+            &command_buffer_info, &buffer->vk_transfer_command_buffer))) < 0)
+    {
+        WARN("Failed to allocate Vulkan command buffer, vr %s.\n", wined3d_debug_vkresult(vr));
+        VK_CALL(vkDestroySemaphore(device_vk->vk_device, buffer->vk_transfer_semaphore, NULL));
+        buffer->vk_transfer_semaphore = VK_NULL_HANDLE;
+        return buffer->vk_transfer_command_buffer = VK_NULL_HANDLE;
+    }
+
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.pNext = NULL;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    begin_info.pInheritanceInfo = NULL;
+    if ((vr = VK_CALL(vkBeginCommandBuffer(buffer->vk_transfer_command_buffer, &begin_info))) < 0)
+    {
+        WARN("Failed to begin command buffer, vr %s.\n", wined3d_debug_vkresult(vr));
+        VK_CALL(vkFreeCommandBuffers(device_vk->vk_device, context_vk->vk_transfer_command_pool,
+                1, &buffer->vk_transfer_command_buffer));
+        VK_CALL(vkDestroySemaphore(device_vk->vk_device, buffer->vk_transfer_semaphore, NULL));
+        buffer->vk_transfer_semaphore = VK_NULL_HANDLE;
+        return buffer->vk_transfer_command_buffer = VK_NULL_HANDLE;
+    }
+
+    TRACE("Created new transfer command buffer %p for command buffer id 0x%s.\n",
+            buffer->vk_transfer_command_buffer, wine_dbgstr_longlong(buffer->id));
+
+    return buffer->vk_transfer_command_buffer;
+}
+
 void wined3d_context_vk_submit_command_buffer(struct wined3d_context_vk *context_vk,
         unsigned int wait_semaphore_count, const VkSemaphore *wait_semaphores, const VkPipelineStageFlags *wait_stages,
         unsigned int signal_semaphore_count, const VkSemaphore *signal_semaphores)
 {
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    VkPipelineStageFlags stages[WINED3D_MAX_WAIT_SEMAPHORES_VK + 1];
+    VkSemaphore semaphores[WINED3D_MAX_WAIT_SEMAPHORES_VK + 1];
     struct wined3d_command_buffer_vk *buffer;
     struct wined3d_query_vk *query_vk;
     VkFenceCreateInfo fence_desc;
     VkSubmitInfo submit_info;
+    unsigned int i;
     VkResult vr;
 
     TRACE("context_vk %p, wait_semaphore_count %u, wait_semaphores %p, wait_stages %p,"
@@ -1497,6 +1687,44 @@ void wined3d_context_vk_submit_command_buffer(struct wined3d_context_vk *context
 
     VK_CALL(vkEndCommandBuffer(buffer->vk_command_buffer));
 
+    if (buffer->vk_transfer_command_buffer)
+    {
+        VK_CALL(vkEndCommandBuffer(buffer->vk_transfer_command_buffer));
+
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext = NULL;
+        submit_info.waitSemaphoreCount = 0;
+        submit_info.pWaitSemaphores = NULL;
+        submit_info.pWaitDstStageMask = NULL;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &buffer->vk_transfer_command_buffer;
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &buffer->vk_transfer_semaphore;
+
+        if ((vr = VK_CALL(vkQueueSubmit(device_vk->vk_transfer_queue, 1, &submit_info, VK_NULL_HANDLE))) < 0)
+        {
+            ERR("Failed to submit transfer command buffer %p, vr %s.\n",
+                    buffer->vk_transfer_command_buffer, wined3d_debug_vkresult(vr));
+        }
+        else if (wait_semaphore_count < ARRAY_SIZE(semaphores))
+        {
+            for (i = 0; i < wait_semaphore_count; ++i)
+            {
+                semaphores[i] = wait_semaphores[i];
+                stages[i] = wait_stages[i];
+            }
+            semaphores[i] = buffer->vk_transfer_semaphore;
+            stages[i] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            wait_semaphores = semaphores;
+            wait_stages = stages;
+            ++wait_semaphore_count;
+        }
+        else
+        {
+            ERR("Too many wait semaphores (%u).\n", wait_semaphore_count);
+        }
+    }
+
     fence_desc.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fence_desc.pNext = NULL;
     fence_desc.flags = 0;
@@ -1606,6 +1834,19 @@ static int wined3d_pipeline_layout_vk_compare(const void *key, const struct wine
     return memcmp(a->bindings, b->bindings, a->binding_count * sizeof(*a->bindings));
 }
 
+static int wined3d_descriptor_set_vk_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct wined3d_descriptor_set_key_vk *a = key;
+    const struct wined3d_descriptor_set_key_vk *b = &WINE_RB_ENTRY_VALUE(entry,
+            const struct wined3d_descriptor_set_vk, entry)->key;
+
+    if (a->vk_set_layout != b->vk_set_layout)
+        return a->vk_set_layout < b->vk_set_layout ? -1 : 1;
+    if (a->entry_count != b->entry_count)
+        return a->entry_count < b->entry_count ? -1 : 1;
+    return memcmp(a->entries, b->entries, a->entry_count * sizeof(*a->entries));
+}
+
 static int wined3d_graphics_pipeline_vk_compare(const void *key, const struct wine_rb_entry *entry)
 {
     const struct wined3d_graphics_pipeline_key_vk *a = key;
@@ -2128,6 +2369,47 @@ static bool wined3d_context_vk_update_graphics_pipeline_key(struct wined3d_conte
     return update;
 }
 
+/* Framebuffer state changes don't necessarily change the attachments; keep
+ * the current render pass instead of splitting it in that case. */
+static bool wined3d_context_vk_render_pass_matches(struct wined3d_context_vk *context_vk,
+        const struct wined3d_state *state)
+{
+    struct wined3d_rendertarget_view *view;
+    unsigned int attachment_count, i;
+    VkImageView vk_view;
+
+    if (!context_vk->vk_render_pass)
+        return false;
+
+    for (i = 0, attachment_count = 0; i < ARRAY_SIZE(state->fb.render_targets); ++i)
+    {
+        if (!(view = state->fb.render_targets[i]) || view->format->id == WINED3DFMT_NULL)
+            continue;
+
+        vk_view = wined3d_rendertarget_view_vk_get_image_view(wined3d_rendertarget_view_vk(view), context_vk);
+        if (attachment_count == context_vk->render_pass_attachment_count
+                || context_vk->vk_render_pass_views[attachment_count] != vk_view)
+            return false;
+        ++attachment_count;
+    }
+
+    if ((view = state->fb.depth_stencil))
+    {
+        vk_view = wined3d_rendertarget_view_vk_get_image_view(wined3d_rendertarget_view_vk(view), context_vk);
+        if (attachment_count == context_vk->render_pass_attachment_count
+                || context_vk->vk_render_pass_views[attachment_count] != vk_view)
+            return false;
+        ++attachment_count;
+    }
+
+    if (attachment_count != context_vk->render_pass_attachment_count)
+        return false;
+
+    /* The attachment slots determine the render pass as well. */
+    return wined3d_context_vk_get_render_pass(context_vk, &state->fb, ARRAY_SIZE(state->fb.render_targets),
+            !!state->fb.depth_stencil, 0) == context_vk->vk_render_pass;
+}
+
 static bool wined3d_context_vk_begin_render_pass(struct wined3d_context_vk *context_vk,
         VkCommandBuffer vk_command_buffer, const struct wined3d_state *state, const struct wined3d_vk_info *vk_info)
 {
@@ -2210,6 +2492,8 @@ static bool wined3d_context_vk_begin_render_pass(struct wined3d_context_vk *cont
         WARN("Failed to create Vulkan framebuffer, vr %s.\n", wined3d_debug_vkresult(vr));
         return false;
     }
+    memcpy(context_vk->vk_render_pass_views, vk_views, attachment_count * sizeof(*vk_views));
+    context_vk->render_pass_attachment_count = attachment_count;
 
     begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     begin_info.pNext = NULL;
@@ -2363,6 +2647,8 @@ static VkResult wined3d_context_vk_create_descriptor_set(struct wined3d_context_
 
     if (vr == VK_ERROR_FRAGMENTED_POOL || vr == VK_ERROR_OUT_OF_POOL_MEMORY)
     {
+        /* The cached sets are allocated from the retired pool. */
+        wined3d_context_vk_clear_descriptor_sets(context_vk);
         wined3d_context_vk_destroy_descriptor_pool(context_vk,
                 context_vk->vk_descriptor_pool, context_vk->current_command_buffer.id);
         context_vk->vk_descriptor_pool = VK_NULL_HANDLE;
@@ -2460,12 +2746,92 @@ static bool wined3d_shader_resource_bindings_add_null_srv_binding(struct wined3d
     }
 }
 
+static bool wined3d_context_vk_get_descriptor_set(struct wined3d_context_vk *context_vk,
+        VkDescriptorSetLayout vk_set_layout, VkDescriptorSet *vk_descriptor_set)
+{
+    struct wined3d_shader_descriptor_writes_vk *writes = &context_vk->descriptor_writes;
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    struct wined3d_descriptor_key_entry_vk *key_entry;
+    struct wined3d_descriptor_set_key_vk key;
+    struct wined3d_descriptor_set_vk *set;
+    const VkWriteDescriptorSet *write;
+    struct wine_rb_entry *entry;
+    VkResult vr;
+    SIZE_T i;
+
+    if (!wined3d_array_reserve((void **)&writes->key_entries, &writes->key_size,
+            writes->count, sizeof(*writes->key_entries)))
+        return false;
+
+    for (i = 0; i < writes->count; ++i)
+    {
+        write = &writes->writes[i];
+        key_entry = &writes->key_entries[i];
+        memset(key_entry, 0, sizeof(*key_entry));
+        key_entry->binding = write->dstBinding;
+        key_entry->type = write->descriptorType;
+        if (write->pBufferInfo)
+        {
+            key_entry->handles[0] = write->pBufferInfo->buffer;
+            key_entry->handles[1] = write->pBufferInfo->offset;
+            key_entry->handles[2] = write->pBufferInfo->range;
+        }
+        else if (write->pImageInfo)
+        {
+            key_entry->handles[0] = write->pImageInfo->sampler;
+            key_entry->handles[1] = write->pImageInfo->imageView;
+            key_entry->handles[2] = write->pImageInfo->imageLayout;
+        }
+        else if (write->pTexelBufferView)
+        {
+            key_entry->handles[0] = *write->pTexelBufferView;
+        }
+    }
+
+    key.vk_set_layout = vk_set_layout;
+    key.entry_count = writes->count;
+    key.entries = writes->key_entries;
+    if ((entry = wine_rb_get(&context_vk->descriptor_sets, &key)))
+    {
+        *vk_descriptor_set = WINE_RB_ENTRY_VALUE(entry, struct wined3d_descriptor_set_vk, entry)->vk_descriptor_set;
+        return true;
+    }
+
+    if ((vr = wined3d_context_vk_create_descriptor_set(context_vk, vk_set_layout, vk_descriptor_set)))
+    {
+        WARN("Failed to create descriptor set, vr %s.\n", wined3d_debug_vkresult(vr));
+        return false;
+    }
+
+    for (i = 0; i < writes->count; ++i)
+    {
+        writes->writes[i].dstSet = *vk_descriptor_set;
+    }
+    VK_CALL(vkUpdateDescriptorSets(device_vk->vk_device, writes->count, writes->writes, 0, NULL));
+
+    /* Descriptor sets are never written again after this, so they can be
+     * reused for as long as the pool they were allocated from exists. */
+    if (!(set = heap_alloc(sizeof(*set) + key.entry_count * sizeof(*key.entries))))
+        return true;
+    memcpy(set + 1, key.entries, key.entry_count * sizeof(*key.entries));
+    set->key.vk_set_layout = key.vk_set_layout;
+    set->key.entry_count = key.entry_count;
+    set->key.entries = (const struct wined3d_descriptor_key_entry_vk *)(set + 1);
+    set->vk_descriptor_set = *vk_descriptor_set;
+    if (wine_rb_put(&context_vk->descriptor_sets, &set->key, &set->entry) == -1)
+        heap_free(set);
+
+    return true;
+}
+
 static bool wined3d_context_vk_update_descriptors(struct wined3d_context_vk *context_vk,
         VkCommandBuffer vk_command_buffer, const struct wined3d_state *state, enum wined3d_pipeline pipeline)
 {
     struct wined3d_shader_descriptor_writes_vk *writes = &context_vk->descriptor_writes;
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
+    VkDescriptorSet vk_descriptor_set = VK_NULL_HANDLE;
     const struct wined3d_shader_resource_binding *binding;
     struct wined3d_shader_resource_bindings *bindings;
     struct wined3d_unordered_access_view_vk *uav_vk;
@@ -2479,13 +2845,12 @@ static bool wined3d_context_vk_update_descriptors(struct wined3d_context_vk *con
     VkPipelineLayout vk_pipeline_layout;
     struct wined3d_resource *resource;
     VkPipelineBindPoint vk_bind_point;
-    VkDescriptorSet vk_descriptor_set;
     struct wined3d_view_vk *view_vk;
     struct wined3d_sampler *sampler;
     struct wined3d_buffer *buffer;
     VkBufferView *buffer_view;
+    bool push_descriptors;
     VkDescriptorType type;
-    VkResult vr;
     size_t i;
 
     switch (pipeline)
@@ -2495,6 +2860,7 @@ static bool wined3d_context_vk_update_descriptors(struct wined3d_context_vk *con
             vk_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
             vk_set_layout = context_vk->graphics.vk_set_layout;
             vk_pipeline_layout = context_vk->graphics.vk_pipeline_layout;
+            push_descriptors = context_vk->graphics.push_descriptors;
             break;
 
         case WINED3D_PIPELINE_COMPUTE:
@@ -2502,6 +2868,7 @@ static bool wined3d_context_vk_update_descriptors(struct wined3d_context_vk *con
             vk_bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
             vk_set_layout = context_vk->compute.vk_set_layout;
             vk_pipeline_layout = context_vk->compute.vk_pipeline_layout;
+            push_descriptors = context_vk->compute.push_descriptors;
             break;
 
         default:
@@ -2509,12 +2876,6 @@ static bool wined3d_context_vk_update_descriptors(struct wined3d_context_vk *con
             return false;
     }
 
-    if ((vr = wined3d_context_vk_create_descriptor_set(context_vk, vk_set_layout, &vk_descriptor_set)))
-    {
-        WARN("Failed to create descriptor set, vr %s.\n", wined3d_debug_vkresult(vr));
-        return false;
-    }
-
     writes->count = 0;
     for (i = 0; i < bindings->count; ++i)
     {
@@ -2638,7 +2999,15 @@ static bool wined3d_context_vk_update_descriptors(struct wined3d_context_vk *con
         }
     }
 
-    VK_CALL(vkUpdateDescriptorSets(device_vk->vk_device, writes->count, writes->writes, 0, NULL));
+    if (push_descriptors)
+    {
+        VK_CALL(vkCmdPushDescriptorSetKHR(vk_command_buffer, vk_bind_point,
+                vk_pipeline_layout, 0, writes->count, writes->writes));
+        return true;
+    }
+
+    if (!wined3d_context_vk_get_descriptor_set(context_vk, vk_set_layout, &vk_descriptor_set))
+        return false;
     VK_CALL(vkCmdBindDescriptorSets(vk_command_buffer, vk_bind_point,
             vk_pipeline_layout, 0, 1, &vk_descriptor_set, 0, NULL));
 
@@ -2647,14 +3016,14 @@ static bool wined3d_context_vk_update_descriptors(struct wined3d_context_vk *con
 
 static VkResult wined3d_context_vk_create_descriptor_set_layout(struct wined3d_device_vk *device_vk,
         const struct wined3d_vk_info *vk_info, const struct wined3d_pipeline_layout_key_vk *key,
-        VkDescriptorSetLayout *vk_set_layout)
+        bool push_descriptors, VkDescriptorSetLayout *vk_set_layout)
 {
     VkDescriptorSetLayoutCreateInfo layout_desc;
     VkResult vr;
 
     layout_desc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     layout_desc.pNext = NULL;
-    layout_desc.flags = 0;
+    layout_desc.flags = push_descriptors ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
     layout_desc.bindingCount = key->binding_count;
     layout_desc.pBindings = key->bindings;
 
@@ -2668,6 +3037,7 @@ struct wined3d_pipeline_layout_vk *wined3d_context_vk_get_pipeline_layout(
         struct wined3d_context_vk *context_vk, VkDescriptorSetLayoutBinding *bindings, SIZE_T binding_count)
 {
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    const struct wined3d_adapter_vk *adapter_vk = wined3d_adapter_vk(device_vk->d.adapter);
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_pipeline_layout_key_vk key;
     struct wined3d_pipeline_layout_vk *layout;
@@ -2691,7 +3061,12 @@ struct wined3d_pipeline_layout_vk *wined3d_context_vk_get_pipeline_layout(
     memcpy(layout->key.bindings, key.bindings, sizeof(*layout->key.bindings) * key.binding_count);
     layout->key.binding_count = key.binding_count;
 
-    if ((vr = wined3d_context_vk_create_descriptor_set_layout(device_vk, vk_info, &key, &layout->vk_set_layout)))
+    /* Push descriptors avoid allocating and writing descriptor sets
+     * altogether, but are limited to a small number of bindings. */
+    layout->push_descriptors = vk_info->supported[WINED3D_VK_KHR_PUSH_DESCRIPTOR]
+            && key.binding_count && key.binding_count <= adapter_vk->max_push_descriptors;
+    if ((vr = wined3d_context_vk_create_descriptor_set_layout(device_vk, vk_info,
+            &key, layout->push_descriptors, &layout->vk_set_layout)))
     {
         WARN("Failed to create descriptor set layout, vr %s.\n", wined3d_debug_vkresult(vr));
         goto fail;
@@ -2747,7 +3122,7 @@ static VkPipeline wined3d_context_vk_get_graphics_pipeline(struct wined3d_contex
     pipeline_vk->key = *key;
 
     if ((vr = VK_CALL(vkCreateGraphicsPipelines(device_vk->vk_device,
-            VK_NULL_HANDLE, 1, &key->pipeline_desc, NULL, &pipeline_vk->vk_pipeline))) < 0)
+            device_vk->vk_pipeline_cache, 1, &key->pipeline_desc, NULL, &pipeline_vk->vk_pipeline))) < 0)
     {
         WARN("Failed to create graphics pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
         heap_free(pipeline_vk);
@@ -3010,7 +3385,8 @@ VkCommandBuffer wined3d_context_vk_apply_draw_state(struct wined3d_context_vk *c
         return VK_NULL_HANDLE;
     }
 
-    if (wined3d_context_is_graphics_state_dirty(&context_vk->c, STATE_FRAMEBUFFER))
+    if (wined3d_context_is_graphics_state_dirty(&context_vk->c, STATE_FRAMEBUFFER)
+            && !wined3d_context_vk_render_pass_matches(context_vk, state))
         wined3d_context_vk_end_current_render_pass(context_vk);
     if (!wined3d_context_vk_begin_render_pass(context_vk, vk_command_buffer, state, vk_info))
     {
@@ -3202,6 +3578,17 @@ HRESULT wined3d_context_vk_init(struct wined3d_context_vk *context_vk, struct wi
     }
     context_vk->current_command_buffer.id = 1;
 
+    if (device_vk->vk_transfer_queue)
+    {
+        command_pool_info.queueFamilyIndex = device_vk->vk_transfer_queue_family_index;
+        if ((vr = VK_CALL(vkCreateCommandPool(device_vk->vk_device,
+                &command_pool_info, NULL, &context_vk->vk_transfer_command_pool))) < 0)
+        {
+            WARN("Failed to create Vulkan transfer command pool, vr %s.\n", wined3d_debug_vkresult(vr));
+            context_vk->vk_transfer_command_pool = VK_NULL_HANDLE;
+        }
+    }
+
     wined3d_context_vk_init_graphics_pipeline_key(context_vk);
 
     list_init(&context_vk->active_queries);
@@ -3211,6 +3598,7 @@ HRESULT wined3d_context_vk_init(struct wined3d_context_vk *context_vk, struct wi
     list_init(&context_vk->free_stream_output_statistics_query_pools);
 
     wine_rb_init(&context_vk->render_passes, wined3d_render_pass_vk_compare);
+    wine_rb_init(&context_vk->descriptor_sets, wined3d_descriptor_set_vk_compare);
     wine_rb_init(&context_vk->pipeline_layouts, wined3d_pipeline_layout_vk_compare);
     wine_rb_init(&context_vk->graphics_pipelines, wined3d_graphics_pipeline_vk_compare);
     wine_rb_init(&context_vk->bo_slab_available, wined3d_bo_slab_vk_compare);
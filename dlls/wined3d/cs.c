@@ -21,6 +21,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_sync);
 WINE_DECLARE_DEBUG_CHANNEL(fps);
 
@@ -499,6 +500,51 @@ static inline void wined3d_cs_submit(struct wined3d_cs *cs, enum wined3d_cs_queu
     cs->ops->submit(cs, queue_id);
 }
 
+#define WINED3D_CS_TRACE_BUFFER_SIZE 0x10000
+
+/* Command stream statistics, collected when the d3d_perf channel is enabled,
+ * or when a trace file is configured. Producer counters are only written by
+ * the application threads and are cumulative, everything else belongs to the
+ * CS thread. */
+struct wined3d_cs_stats
+{
+    LONG64 submit_count;
+    LONG64 queue_depth;
+    LONG max_queue_depth;
+    LONG64 stall_count;
+    LONG64 stall_time;
+
+    LONG64 frequency;
+    LONG64 period_start;
+    LONG64 idle_time;
+    LONG64 prev_submit_count;
+    LONG64 prev_queue_depth;
+    LONG64 prev_stall_count;
+    LONG64 prev_stall_time;
+    struct
+    {
+        unsigned int count;
+        LONG64 time;
+    } ops[WINED3D_CS_OP_STOP];
+
+    /* Chrome trace event output, see about:tracing. */
+    HANDLE trace_file;
+    LONG64 trace_start;
+    LONG64 frame_start;
+    LONG64 frame_busy_time;
+    unsigned int frame_count;
+    size_t trace_size;
+    char trace_buffer[WINED3D_CS_TRACE_BUFFER_SIZE];
+};
+
+static inline LONG64 wined3d_cs_stats_time(void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
 static const char *debug_cs_op(enum wined3d_cs_op op)
 {
     switch (op)
@@ -650,6 +696,40 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
     }
 
     InterlockedDecrement(&cs->pending_presents);
+    if (InterlockedCompareExchange(&cs->waiting_for_present, FALSE, TRUE))
+        SetEvent(cs->present_event);
+}
+
+/* Wait until fewer than "max_latency" presents are queued. Spin for a short
+ * while, since the worker thread is often about to retire one, then block
+ * instead of burning a core for the whole frame. */
+static void wined3d_cs_wait_present(struct wined3d_cs *cs, LONG pending, unsigned int max_latency)
+{
+    unsigned int spin_count = 0;
+
+    while (pending >= max_latency)
+    {
+        if (!cs->present_event || spin_count < WINED3D_CS_PRESENT_SPIN_COUNT)
+        {
+            YieldProcessor();
+            ++spin_count;
+        }
+        else
+        {
+            InterlockedExchange(&cs->waiting_for_present, TRUE);
+
+            /* The worker thread might have retired a present before
+             * "waiting_for_present" was set. If it reset "waiting_for_present"
+             * in the meantime, it also signalled the event, which we need to
+             * consume. */
+            if (InterlockedCompareExchange(&cs->pending_presents, 0, 0) < max_latency
+                    && InterlockedCompareExchange(&cs->waiting_for_present, FALSE, TRUE))
+                return;
+
+            WaitForSingleObject(cs->present_event, INFINITE);
+        }
+        pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
+    }
 }
 
 void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *swapchain,
@@ -681,11 +761,7 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
 
     /* Limit input latency by limiting the number of presents that we can get
      * ahead of the worker thread. */
-    while (pending >= swapchain->max_frame_latency)
-    {
-        YieldProcessor();
-        pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
-    }
+    wined3d_cs_wait_present(cs, pending, swapchain->max_frame_latency);
 }
 
 static void wined3d_cs_exec_clear(struct wined3d_cs *cs, const void *data)
@@ -2904,6 +2980,7 @@ static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct
 
 static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined3d_cs *cs)
 {
+    struct wined3d_cs_stats *stats = cs->stats;
     struct wined3d_cs_packet *packet;
     size_t packet_size;
 
@@ -2911,6 +2988,16 @@ static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
     InterlockedExchange(&queue->head, (queue->head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1));
 
+    if (stats)
+    {
+        LONG depth = (queue->head - *(volatile LONG *)&queue->tail) & (WINED3D_CS_QUEUE_SIZE - 1);
+
+        ++stats->submit_count;
+        stats->queue_depth += depth;
+        if (depth > stats->max_queue_depth)
+            stats->max_queue_depth = depth;
+    }
+
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         SetEvent(cs->event);
 }
@@ -2928,6 +3015,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    LONG64 stall_start = 0;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
@@ -2978,6 +3066,15 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
 
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
                 head, tail, (unsigned long)packet_size);
+        if (cs->stats && !stall_start)
+            stall_start = wined3d_cs_stats_time();
+        YieldProcessor();
+    }
+
+    if (stall_start)
+    {
+        ++cs->stats->stall_count;
+        cs->stats->stall_time += wined3d_cs_stats_time() - stall_start;
     }
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
@@ -2995,11 +3092,22 @@ static void *wined3d_cs_mt_require_space(struct wined3d_cs *cs, size_t size, enu
 
 static void wined3d_cs_mt_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    LONG64 stall_start = 0;
+
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(cs, queue_id);
 
+    if (cs->stats && !wined3d_cs_queue_is_empty(cs, &cs->queue[queue_id]))
+        stall_start = wined3d_cs_stats_time();
+
     while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
         YieldProcessor();
+
+    if (stall_start)
+    {
+        ++cs->stats->stall_count;
+        cs->stats->stall_time += wined3d_cs_stats_time() - stall_start;
+    }
 }
 
 static const struct wined3d_cs_ops wined3d_cs_mt_ops =
@@ -3044,6 +3152,146 @@ static void wined3d_cs_wait_event(struct wined3d_cs *cs)
     WaitForSingleObject(cs->event, INFINITE);
 }
 
+static void wined3d_cs_park(struct wined3d_cs *cs)
+{
+    LONG64 start = wined3d_cs_stats_time();
+
+    wined3d_cs_wait_event(cs);
+
+    /* Spin for longer if we got woken up right away, and park sooner if we
+     * were idle for a while. */
+    if (wined3d_cs_stats_time() - start < cs->park_threshold)
+        cs->spin_limit = min(cs->spin_limit * 2, WINED3D_CS_SPIN_COUNT);
+    else
+        cs->spin_limit = max(cs->spin_limit / 2, WINED3D_CS_MIN_SPIN_COUNT);
+}
+
+static void wined3d_cs_report_stats(struct wined3d_cs *cs, LONG64 now)
+{
+    struct wined3d_cs_stats *stats = cs->stats;
+    LONG64 elapsed = now - stats->period_start;
+    LONG64 submit_count, stall_count;
+    unsigned int i;
+
+    if (elapsed < 5 * stats->frequency)
+        return;
+
+    submit_count = stats->submit_count - stats->prev_submit_count;
+    stall_count = stats->stall_count - stats->prev_stall_count;
+    TRACE_(d3d_perf)("%p: %s submissions, average queue depth %s bytes, max %d bytes, %s producer stalls (%.3f ms), "
+            "consumer idle %.1f%%, spin limit %u.\n", cs, wine_dbgstr_longlong(submit_count),
+            wine_dbgstr_longlong(submit_count ? (stats->queue_depth - stats->prev_queue_depth) / submit_count : 0),
+            stats->max_queue_depth, wine_dbgstr_longlong(stall_count),
+            (stats->stall_time - stats->prev_stall_time) * 1000.0 / stats->frequency,
+            stats->idle_time * 100.0 / elapsed, cs->spin_limit);
+    for (i = 0; i < ARRAY_SIZE(stats->ops); ++i)
+    {
+        if (!stats->ops[i].count)
+            continue;
+        TRACE_(d3d_perf)("%p: %s: %u calls, %.3f ms.\n", cs, debug_cs_op(i), stats->ops[i].count,
+                stats->ops[i].time * 1000.0 / stats->frequency);
+    }
+
+    stats->prev_submit_count += submit_count;
+    stats->prev_queue_depth = stats->queue_depth;
+    stats->prev_stall_count += stall_count;
+    stats->prev_stall_time = stats->stall_time;
+    stats->max_queue_depth = 0;
+    stats->idle_time = 0;
+    memset(stats->ops, 0, sizeof(stats->ops));
+    stats->period_start = now;
+}
+
+static void wined3d_cs_trace_flush(struct wined3d_cs_stats *stats)
+{
+    DWORD written;
+
+    if (stats->trace_size && !WriteFile(stats->trace_file, stats->trace_buffer, stats->trace_size, &written, NULL))
+        ERR("Failed to write command stream trace, error %u.\n", GetLastError());
+    stats->trace_size = 0;
+}
+
+static void wined3d_cs_trace_event(struct wined3d_cs_stats *stats, const char *format, ...)
+{
+    va_list args;
+    int len;
+
+    if (stats->trace_size > WINED3D_CS_TRACE_BUFFER_SIZE - 256)
+        wined3d_cs_trace_flush(stats);
+
+    va_start(args, format);
+    len = vsnprintf(&stats->trace_buffer[stats->trace_size],
+            WINED3D_CS_TRACE_BUFFER_SIZE - stats->trace_size, format, args);
+    va_end(args);
+    if (len > 0 && len < WINED3D_CS_TRACE_BUFFER_SIZE - stats->trace_size)
+        stats->trace_size += len;
+}
+
+static double wined3d_cs_trace_us(const struct wined3d_cs_stats *stats, LONG64 time)
+{
+    return time * 1000000.0 / stats->frequency;
+}
+
+static void wined3d_cs_trace_op(struct wined3d_cs *cs, enum wined3d_cs_op opcode, LONG64 start, LONG64 end)
+{
+    struct wined3d_cs_stats *stats = cs->stats;
+    double frame_time;
+
+    if (!stats->trace_file)
+        return;
+
+    wined3d_cs_trace_event(stats, "{\"name\":\"%s\",\"cat\":\"cs\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,"
+            "\"ts\":%.3f,\"dur\":%.3f},\n", debug_cs_op(opcode) + strlen("WINED3D_CS_OP_"),
+            GetCurrentProcessId(), cs->thread_id, wined3d_cs_trace_us(stats, start - stats->trace_start),
+            wined3d_cs_trace_us(stats, end - start));
+
+    stats->frame_busy_time += end - start;
+    if (opcode != WINED3D_CS_OP_PRESENT)
+        return;
+
+    /* Per-frame CS thread totals, as counter tracks. */
+    frame_time = wined3d_cs_trace_us(stats, end - stats->frame_start) / 1000.0;
+    wined3d_cs_trace_event(stats, "{\"name\":\"frame\",\"cat\":\"cs\",\"ph\":\"C\",\"pid\":%u,\"ts\":%.3f,"
+            "\"args\":{\"frame_ms\":%.3f,\"cs_busy_ms\":%.3f}},\n",
+            GetCurrentProcessId(), wined3d_cs_trace_us(stats, end - stats->trace_start), frame_time,
+            wined3d_cs_trace_us(stats, stats->frame_busy_time) / 1000.0);
+    stats->frame_start = end;
+    stats->frame_busy_time = 0;
+
+    /* Don't lose too much if the process gets killed. */
+    if (!(++stats->frame_count % 60))
+        wined3d_cs_trace_flush(stats);
+}
+
+static void wined3d_cs_trace_close(struct wined3d_cs_stats *stats)
+{
+    if (!stats->trace_file)
+        return;
+
+    wined3d_cs_trace_event(stats, "{}]\n");
+    wined3d_cs_trace_flush(stats);
+    CloseHandle(stats->trace_file);
+    stats->trace_file = NULL;
+}
+
+static void wined3d_cs_trace_open(struct wined3d_cs_stats *stats, const char *path)
+{
+    static const char header[] = "[\n";
+    DWORD written;
+    HANDLE file;
+
+    if ((file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, NULL,
+            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        ERR("Failed to create command stream trace file %s, error %u.\n", debugstr_a(path), GetLastError());
+        return;
+    }
+    WriteFile(file, header, sizeof(header) - 1, &written, NULL);
+
+    stats->trace_file = file;
+    stats->trace_start = stats->frame_start = wined3d_cs_stats_time();
+}
+
 static void wined3d_cs_command_lock(const struct wined3d_cs *cs)
 {
     if (cs->serialize_commands)
@@ -3059,9 +3307,11 @@ static void wined3d_cs_command_unlock(const struct wined3d_cs *cs)
 static DWORD WINAPI wined3d_cs_run(void *ctx)
 {
     struct wined3d_cs_packet *packet;
+    struct wined3d_cs_stats *stats;
     struct wined3d_cs_queue *queue;
     unsigned int spin_count = 0;
     struct wined3d_cs *cs = ctx;
+    LONG64 idle_start = 0, start, end;
     enum wined3d_cs_op opcode;
     HMODULE wined3d_module;
     unsigned int poll = 0;
@@ -3075,6 +3325,7 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
 
     list_init(&cs->query_poll_list);
     cs->thread_id = GetCurrentThreadId();
+    stats = cs->stats;
     for (;;)
     {
         if (++poll == WINED3D_CS_QUERY_POLL_INTERVAL)
@@ -3091,12 +3342,22 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
-                if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
-                    wined3d_cs_wait_event(cs);
+                if (stats && !idle_start)
+                    idle_start = wined3d_cs_stats_time();
+                if (++spin_count >= cs->spin_limit && list_empty(&cs->query_poll_list))
+                {
+                    wined3d_cs_park(cs);
+                    spin_count = 0;
+                }
                 continue;
             }
         }
         spin_count = 0;
+        if (idle_start)
+        {
+            stats->idle_time += wined3d_cs_stats_time() - idle_start;
+            idle_start = 0;
+        }
 
         tail = queue->tail;
         packet = (struct wined3d_cs_packet *)&queue->data[tail];
@@ -3113,7 +3374,20 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             }
 
             wined3d_cs_command_lock(cs);
-            wined3d_cs_op_handlers[opcode](cs, packet->data);
+            if (stats)
+            {
+                start = wined3d_cs_stats_time();
+                wined3d_cs_op_handlers[opcode](cs, packet->data);
+                end = wined3d_cs_stats_time();
+                stats->ops[opcode].time += end - start;
+                ++stats->ops[opcode].count;
+                wined3d_cs_trace_op(cs, opcode, start, end);
+                wined3d_cs_report_stats(cs, start);
+            }
+            else
+            {
+                wined3d_cs_op_handlers[opcode](cs, packet->data);
+            }
             wined3d_cs_command_unlock(cs);
             TRACE("%s executed.\n", debug_cs_op(opcode));
         }
@@ -3123,6 +3397,9 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
         InterlockedExchange(&queue->tail, tail);
     }
 
+    if (stats)
+        wined3d_cs_trace_close(stats);
+
     cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
     cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail = cs->queue[WINED3D_CS_QUEUE_DEFAULT].head;
     TRACE("Stopped.\n");
@@ -3150,8 +3427,22 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     if (wined3d_settings.cs_multithreaded & WINED3D_CSMT_ENABLE
             && !RtlIsCriticalSectionLockedByThread(NtCurrentTeb()->Peb->LoaderLock))
     {
+        LARGE_INTEGER frequency;
+
         cs->ops = &wined3d_cs_mt_ops;
 
+        QueryPerformanceFrequency(&frequency);
+        cs->spin_limit = WINED3D_CS_SPIN_COUNT;
+        cs->park_threshold = frequency.QuadPart / 1000;
+        if ((TRACE_ON(d3d_perf) || wined3d_settings.cs_trace_file)
+                && (cs->stats = heap_alloc_zero(sizeof(*cs->stats))))
+        {
+            cs->stats->frequency = frequency.QuadPart;
+            cs->stats->period_start = wined3d_cs_stats_time();
+            if (wined3d_settings.cs_trace_file)
+                wined3d_cs_trace_open(cs->stats, wined3d_settings.cs_trace_file);
+        }
+
         if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
@@ -3159,10 +3450,19 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
             goto fail;
         }
 
+        if (!(cs->present_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        {
+            ERR("Failed to create command stream present event.\n");
+            CloseHandle(cs->event);
+            heap_free(cs->data);
+            goto fail;
+        }
+
         if (!(GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
                 (const WCHAR *)wined3d_cs_run, &cs->wined3d_module)))
         {
             ERR("Failed to get wined3d module handle.\n");
+            CloseHandle(cs->present_event);
             CloseHandle(cs->event);
             heap_free(cs->data);
             goto fail;
@@ -3172,6 +3472,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
         {
             ERR("Failed to create wined3d command stream thread.\n");
             FreeLibrary(cs->wined3d_module);
+            CloseHandle(cs->present_event);
             CloseHandle(cs->event);
             heap_free(cs->data);
             goto fail;
@@ -3182,6 +3483,9 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
 
 fail:
     state_cleanup(&cs->state);
+    if (cs->stats)
+        wined3d_cs_trace_close(cs->stats);
+    heap_free(cs->stats);
     heap_free(cs);
     return NULL;
 }
@@ -3194,9 +3498,11 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
         CloseHandle(cs->thread);
         if (!CloseHandle(cs->event))
             ERR("Closing event failed.\n");
+        CloseHandle(cs->present_event);
     }
 
     state_cleanup(&cs->state);
+    heap_free(cs->stats);
     heap_free(cs->data);
     heap_free(cs);
 }
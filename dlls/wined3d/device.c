@@ -1632,6 +1632,12 @@ static void wined3d_device_set_material(struct wined3d_device *device, const str
 {
     TRACE("device %p, material %p.\n", device, material);
 
+    if (!memcmp(&device->state->material, material, sizeof(*material)))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        return;
+    }
+
     device->state->material = *material;
     wined3d_cs_emit_set_material(device->cs, material);
 }
@@ -1698,6 +1704,13 @@ void CDECL wined3d_device_set_viewports(struct wined3d_device *device, unsigned
                 viewports[i].width, viewports[i].height, viewports[i].min_z, viewports[i].max_z);
     }
 
+    if (state->viewport_count == viewport_count
+            && !memcmp(state->viewports, viewports, viewport_count * sizeof(*viewports)))
+    {
+        TRACE("Application is setting the old viewports over, nothing to do.\n");
+        return;
+    }
+
     if (viewport_count)
         memcpy(state->viewports, viewports, viewport_count * sizeof(*viewports));
     else
@@ -2269,6 +2282,27 @@ struct wined3d_sampler * CDECL wined3d_device_get_vs_sampler(const struct wined3
     return wined3d_device_get_sampler(device, WINED3D_SHADER_TYPE_VERTEX, idx);
 }
 
+/* Shrink a constant update to the range of constants that actually change.
+ * Returns false if none of them do. */
+static bool wined3d_device_trim_constant_range(const void *current, unsigned int element_size,
+        unsigned int *start_idx, unsigned int *count, const void **constants)
+{
+    const uint8_t *src = *constants, *dst = (const uint8_t *)current + *start_idx * element_size;
+    unsigned int first = 0, last = *count;
+
+    while (first < last && !memcmp(&dst[first * element_size], &src[first * element_size], element_size))
+        ++first;
+    if (first == last)
+        return false;
+    while (!memcmp(&dst[(last - 1) * element_size], &src[(last - 1) * element_size], element_size))
+        --last;
+
+    *constants = &src[first * element_size];
+    *start_idx += first;
+    *count = last - first;
+    return true;
+}
+
 static void wined3d_device_set_vs_consts_b(struct wined3d_device *device,
         unsigned int start_idx, unsigned int count, const BOOL *constants)
 {
@@ -2277,6 +2311,13 @@ static void wined3d_device_set_vs_consts_b(struct wined3d_device *device,
     TRACE("device %p, start_idx %u, count %u, constants %p.\n",
             device, start_idx, count, constants);
 
+    if (!wined3d_device_trim_constant_range(device->state->vs_consts_b, sizeof(*constants),
+            &start_idx, &count, (const void **)&constants))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        return;
+    }
+
     memcpy(&device->state->vs_consts_b[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2295,6 +2336,13 @@ static void wined3d_device_set_vs_consts_i(struct wined3d_device *device,
     TRACE("device %p, start_idx %u, count %u, constants %p.\n",
             device, start_idx, count, constants);
 
+    if (!wined3d_device_trim_constant_range(device->state->vs_consts_i, sizeof(*constants),
+            &start_idx, &count, (const void **)&constants))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        return;
+    }
+
     memcpy(&device->state->vs_consts_i[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2313,6 +2361,13 @@ static void wined3d_device_set_vs_consts_f(struct wined3d_device *device,
     TRACE("device %p, start_idx %u, count %u, constants %p.\n",
             device, start_idx, count, constants);
 
+    if (!wined3d_device_trim_constant_range(device->state->vs_consts_f, sizeof(*constants),
+            &start_idx, &count, (const void **)&constants))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        return;
+    }
+
     memcpy(&device->state->vs_consts_f[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2387,6 +2442,13 @@ static void wined3d_device_set_ps_consts_b(struct wined3d_device *device,
     TRACE("device %p, start_idx %u, count %u, constants %p.\n",
             device, start_idx, count, constants);
 
+    if (!wined3d_device_trim_constant_range(device->state->ps_consts_b, sizeof(*constants),
+            &start_idx, &count, (const void **)&constants))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        return;
+    }
+
     memcpy(&device->state->ps_consts_b[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2405,6 +2467,13 @@ static void wined3d_device_set_ps_consts_i(struct wined3d_device *device,
     TRACE("device %p, start_idx %u, count %u, constants %p.\n",
             device, start_idx, count, constants);
 
+    if (!wined3d_device_trim_constant_range(device->state->ps_consts_i, sizeof(*constants),
+            &start_idx, &count, (const void **)&constants))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        return;
+    }
+
     memcpy(&device->state->ps_consts_i[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2423,6 +2492,13 @@ static void wined3d_device_set_ps_consts_f(struct wined3d_device *device,
     TRACE("device %p, start_idx %u, count %u, constants %p.\n",
             device, start_idx, count, constants);
 
+    if (!wined3d_device_trim_constant_range(device->state->ps_consts_f, sizeof(*constants),
+            &start_idx, &count, (const void **)&constants))
+    {
+        TRACE("Application is setting the old values over, nothing to do.\n");
+        return;
+    }
+
     memcpy(&device->state->ps_consts_f[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -3817,15 +3893,16 @@ void CDECL wined3d_device_apply_stateblock(struct wined3d_device *device,
 
     if (changed->lights)
     {
-        for (i = 0; i < ARRAY_SIZE(state->light_state->light_map); ++i)
-        {
-            const struct wined3d_light_info *light;
+        struct wined3d_light_info *light, *cursor;
 
-            LIST_FOR_EACH_ENTRY(light, &state->light_state->light_map[i], struct wined3d_light_info, entry)
-            {
-                wined3d_device_set_light(device, light->OriginalIndex, &light->OriginalParms);
-                wined3d_device_set_light_enable(device, light->OriginalIndex, light->glIndex != -1);
-            }
+        /* Only send the lights that were touched since the last apply,
+         * instead of every light the application ever defined. */
+        LIST_FOR_EACH_ENTRY_SAFE(light, cursor, &stateblock->changed_lights, struct wined3d_light_info, changed_entry)
+        {
+            wined3d_device_set_light(device, light->OriginalIndex, &light->OriginalParms);
+            wined3d_device_set_light_enable(device, light->OriginalIndex, light->glIndex != -1);
+            list_remove(&light->changed_entry);
+            list_init(&light->changed_entry);
         }
     }
 
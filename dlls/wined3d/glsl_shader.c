@@ -141,6 +141,12 @@ struct shader_glsl_priv
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
     BOOL legacy_lighting;
+
+    struct wine_rb_tree program_binaries;
+    SIZE_T program_binaries_size;
+    uint8_t program_binary_cache_id[8];
+    BOOL program_binaries_loaded;
+    BOOL program_binaries_dirty;
 };
 
 struct glsl_vs_program
@@ -10214,6 +10220,295 @@ static void set_glsl_compute_shader_program(const struct wined3d_context_gl *con
 }
 
 /* Context activation is done by the caller. */
+/* Linked program binaries are cached on disk per application and per GL
+ * driver, keyed on the GLSL sources of the attached shaders and the link
+ * time state that isn't part of those sources. */
+#define WINED3D_GLSL_BINARY_CACHE_MAGIC     0x4e494247u /* "GBIN" */
+#define WINED3D_GLSL_BINARY_CACHE_VERSION   1
+#define WINED3D_GLSL_BINARY_CACHE_MAX_SIZE  (64 * 1024 * 1024)
+
+struct glsl_program_binary
+{
+    struct wine_rb_entry entry;
+    uint64_t key[2];
+    GLenum format;
+    GLsizei size;
+    BYTE data[1];
+};
+
+struct glsl_program_binary_file_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t padding;
+};
+
+struct glsl_program_binary_file_entry
+{
+    uint64_t key[2];
+    uint32_t format;
+    uint32_t size;
+};
+
+static int glsl_program_binary_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct glsl_program_binary *binary = WINE_RB_ENTRY_VALUE(entry, const struct glsl_program_binary, entry);
+    const uint64_t *k = key;
+
+    if (k[0] != binary->key[0])
+        return k[0] < binary->key[0] ? -1 : 1;
+    if (k[1] != binary->key[1])
+        return k[1] < binary->key[1] ? -1 : 1;
+    return 0;
+}
+
+static void glsl_program_binary_free(struct wine_rb_entry *entry, void *context)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry));
+}
+
+static void glsl_program_binary_hash(uint64_t *key, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        key[0] = (key[0] ^ p[i]) * 0x100000001b3ull;
+        key[1] = (key[1] ^ p[i]) * 0xc6a4a7935bd1e995ull;
+        key[1] ^= key[1] >> 47;
+    }
+}
+
+static BOOL shader_glsl_get_program_binary_cache_path(const struct shader_glsl_priv *priv,
+        WCHAR *path, unsigned int size, BOOL create_dir)
+{
+    static const WCHAR extension[] = {'g','l','c','a','c','h','e',0};
+
+    return wined3d_get_cache_file_path(path, size, priv->program_binary_cache_id,
+            sizeof(priv->program_binary_cache_id), extension, create_dir);
+}
+
+static void shader_glsl_load_program_binaries(const struct wined3d_gl_info *gl_info, struct shader_glsl_priv *priv)
+{
+    const struct glsl_program_binary_file_header *header;
+    const struct glsl_program_binary_file_entry *e;
+    struct glsl_program_binary *binary;
+    uint64_t id[2] = {0xcbf29ce484222325ull, 0x84222325cbf29ce4ull};
+    const char *renderer, *version;
+    WCHAR path[MAX_PATH];
+    SIZE_T size, offset;
+    unsigned int i;
+    uint64_t hash;
+    BYTE *data;
+
+    priv->program_binaries_loaded = TRUE;
+
+    renderer = (const char *)gl_info->gl_ops.gl.p_glGetString(GL_RENDERER);
+    version = (const char *)gl_info->gl_ops.gl.p_glGetString(GL_VERSION);
+    if (!renderer || !version)
+        return;
+    glsl_program_binary_hash(id, renderer, strlen(renderer) + 1);
+    glsl_program_binary_hash(id, version, strlen(version) + 1);
+    hash = id[0] ^ id[1];
+    for (i = 0; i < sizeof(priv->program_binary_cache_id); ++i)
+        priv->program_binary_cache_id[i] = hash >> (i * 8);
+
+    if (!shader_glsl_get_program_binary_cache_path(priv, path, ARRAY_SIZE(path), FALSE)
+            || !(data = wined3d_load_cache_file(path, &size)))
+        return;
+
+    header = (const struct glsl_program_binary_file_header *)data;
+    if (size < sizeof(*header) || header->magic != WINED3D_GLSL_BINARY_CACHE_MAGIC
+            || header->version != WINED3D_GLSL_BINARY_CACHE_VERSION)
+    {
+        WARN("Ignoring invalid program binary cache %s.\n", debugstr_w(path));
+        heap_free(data);
+        return;
+    }
+
+    for (i = 0, offset = sizeof(*header); i < header->count; ++i)
+    {
+        if (size - offset < sizeof(*e))
+            break;
+        e = (const struct glsl_program_binary_file_entry *)(data + offset);
+        offset += sizeof(*e);
+        if (!e->size || size - offset < e->size)
+            break;
+
+        if (priv->program_binaries_size + e->size > WINED3D_GLSL_BINARY_CACHE_MAX_SIZE
+                || !(binary = heap_alloc(offsetof(struct glsl_program_binary, data[e->size]))))
+            break;
+        binary->key[0] = e->key[0];
+        binary->key[1] = e->key[1];
+        binary->format = e->format;
+        binary->size = e->size;
+        memcpy(binary->data, data + offset, e->size);
+        if (wine_rb_put(&priv->program_binaries, binary->key, &binary->entry) == -1)
+            heap_free(binary);
+        else
+            priv->program_binaries_size += e->size;
+
+        offset += (e->size + 7) & ~7u;
+        if (offset > size)
+            break;
+    }
+
+    TRACE("Loaded %u program binaries from %s.\n", i, debugstr_w(path));
+    heap_free(data);
+}
+
+static void shader_glsl_save_program_binaries(struct shader_glsl_priv *priv)
+{
+    struct glsl_program_binary_file_header *header;
+    struct glsl_program_binary_file_entry *e;
+    struct glsl_program_binary *binary;
+    SIZE_T size, offset;
+    WCHAR path[MAX_PATH];
+    BYTE *data;
+
+    size = sizeof(*header);
+    WINE_RB_FOR_EACH_ENTRY(binary, &priv->program_binaries, struct glsl_program_binary, entry)
+    {
+        size += sizeof(*e) + ((binary->size + 7) & ~7u);
+    }
+
+    if (!(data = heap_alloc_zero(size)))
+        return;
+
+    header = (struct glsl_program_binary_file_header *)data;
+    header->magic = WINED3D_GLSL_BINARY_CACHE_MAGIC;
+    header->version = WINED3D_GLSL_BINARY_CACHE_VERSION;
+    header->count = 0;
+    offset = sizeof(*header);
+    WINE_RB_FOR_EACH_ENTRY(binary, &priv->program_binaries, struct glsl_program_binary, entry)
+    {
+        e = (struct glsl_program_binary_file_entry *)(data + offset);
+        e->key[0] = binary->key[0];
+        e->key[1] = binary->key[1];
+        e->format = binary->format;
+        e->size = binary->size;
+        offset += sizeof(*e);
+        memcpy(data + offset, binary->data, binary->size);
+        offset += (binary->size + 7) & ~7u;
+        ++header->count;
+    }
+
+    if (shader_glsl_get_program_binary_cache_path(priv, path, ARRAY_SIZE(path), TRUE))
+        wined3d_save_cache_file(path, data, size);
+    heap_free(data);
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_get_program_binary_key(const struct wined3d_gl_info *gl_info,
+        const GLuint *shader_ids, unsigned int shader_count, uint32_t link_flags, uint64_t *key)
+{
+    GLint source_size = 0, length;
+    char *source = NULL;
+    unsigned int i;
+
+    key[0] = 0xcbf29ce484222325ull;
+    key[1] = 0x84222325cbf29ce4ull;
+    glsl_program_binary_hash(key, &link_flags, sizeof(link_flags));
+
+    for (i = 0; i < shader_count; ++i)
+    {
+        if (!shader_ids[i])
+            continue;
+
+        GL_EXTCALL(glGetShaderiv(shader_ids[i], GL_SHADER_SOURCE_LENGTH, &length));
+        if (length > source_size)
+        {
+            heap_free(source);
+            if (!(source = heap_alloc(length)))
+            {
+                /* Make sure the key can't match anything. */
+                key[0] = key[1] = 0;
+                return;
+            }
+            source_size = length;
+        }
+        if (length)
+            GL_EXTCALL(glGetShaderSource(shader_ids[i], length, &length, source));
+        glsl_program_binary_hash(key, &i, sizeof(i));
+        glsl_program_binary_hash(key, &length, sizeof(length));
+        glsl_program_binary_hash(key, source, length);
+    }
+    checkGLcall("get program binary key");
+
+    heap_free(source);
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_load_program_binary(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, const uint64_t *key)
+{
+    struct glsl_program_binary *binary;
+    struct wine_rb_entry *entry;
+    GLint status;
+
+    if (!priv->program_binaries_loaded)
+        shader_glsl_load_program_binaries(gl_info, priv);
+
+    if (!key[0] && !key[1])
+        return FALSE;
+    if (!(entry = wine_rb_get(&priv->program_binaries, key)))
+        return FALSE;
+    binary = WINE_RB_ENTRY_VALUE(entry, struct glsl_program_binary, entry);
+
+    GL_EXTCALL(glProgramBinary(program_id, binary->format, binary->data, binary->size));
+    GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+    checkGLcall("glProgramBinary");
+    if (status)
+    {
+        TRACE("Loaded program %u from a %d byte binary.\n", program_id, binary->size);
+        return TRUE;
+    }
+
+    /* The driver rejected the binary, e.g. after a driver update that didn't
+     * change the version string. Drop it and link normally. */
+    WARN("Failed to load program binary for program %u.\n", program_id);
+    wine_rb_remove(&priv->program_binaries, entry);
+    priv->program_binaries_size -= binary->size;
+    priv->program_binaries_dirty = TRUE;
+    heap_free(binary);
+    return FALSE;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_store_program_binary(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, const uint64_t *key)
+{
+    struct glsl_program_binary *binary;
+    GLint status, size;
+
+    if (!key[0] && !key[1])
+        return;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+    if (!status)
+        return;
+    GL_EXTCALL(glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &size));
+    if (size <= 0 || priv->program_binaries_size + size > WINED3D_GLSL_BINARY_CACHE_MAX_SIZE)
+        return;
+
+    if (!(binary = heap_alloc(offsetof(struct glsl_program_binary, data[size]))))
+        return;
+    binary->key[0] = key[0];
+    binary->key[1] = key[1];
+    GL_EXTCALL(glGetProgramBinary(program_id, size, &binary->size, &binary->format, binary->data));
+    checkGLcall("glGetProgramBinary");
+    if (!binary->size || wine_rb_put(&priv->program_binaries, binary->key, &binary->entry) == -1)
+    {
+        heap_free(binary);
+        return;
+    }
+
+    priv->program_binaries_size += binary->size;
+    priv->program_binaries_dirty = TRUE;
+}
+
 static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl, const struct wined3d_state *state,
         struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
 {
@@ -10237,6 +10532,9 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     struct list *ps_list, *vs_list;
     WORD attribs_map;
     struct wined3d_string_buffer *tmp_name;
+    uint32_t link_flags;
+    uint64_t binary_key[2];
+    BOOL use_binary_cache;
 
     if (!(context_gl->c.shader_update_mask & (1u << WINED3D_SHADER_TYPE_VERTEX)) && ctx_data->glsl_program)
     {
@@ -10401,6 +10699,12 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         attribs_map = (1u << WINED3D_FFP_ATTRIBS_COUNT) - 1;
     }
 
+    link_flags = attribs_map;
+    if (vshader && vshader->reg_maps.shader_version.major >= 4)
+        link_flags |= 1u << 16;
+    if (state->blend_state && state->blend_state->dual_source)
+        link_flags |= 1u << 17;
+
     if (!shader_glsl_use_explicit_attrib_location(gl_info))
     {
         /* Bind vertex attributes to a corresponding index number to match
@@ -10484,10 +10788,26 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         list_add_head(ps_list, &entry->ps.shader_entry);
     }
 
-    /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    /* Transform feedback varyings aren't part of the key. */
+    use_binary_cache = gl_info->supported[ARB_GET_PROGRAM_BINARY] && !(gshader && gshader->u.gs.so_desc);
+    if (use_binary_cache)
+    {
+        const GLuint shader_ids[] = {vs_id, reorder_shader_id, hs_id, ds_id, gs_id, ps_id};
+
+        shader_glsl_get_program_binary_key(gl_info, shader_ids, ARRAY_SIZE(shader_ids), link_flags, binary_key);
+    }
+
+    if (!use_binary_cache || !shader_glsl_load_program_binary(gl_info, priv, program_id, binary_key))
+    {
+        /* Link the program */
+        if (use_binary_cache)
+            GL_EXTCALL(glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+        TRACE("Linking GLSL shader program %u.\n", program_id);
+        GL_EXTCALL(glLinkProgram(program_id));
+        shader_glsl_validate_link(gl_info, program_id);
+        if (use_binary_cache)
+            shader_glsl_store_program_binary(gl_info, priv, program_id, binary_key);
+    }
 
     shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
             vshader ? vshader->limits->constant_float : 0);
@@ -11077,6 +11397,7 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     }
 
     wine_rb_init(&priv->program_lookup, glsl_program_key_compare);
+    wine_rb_init(&priv->program_binaries, glsl_program_binary_compare);
 
     priv->next_constant_version = 1;
     priv->vertex_pipe = vertex_pipe;
@@ -11108,6 +11429,9 @@ static void shader_glsl_free(struct wined3d_device *device, struct wined3d_conte
     struct shader_glsl_priv *priv = device->shader_priv;
 
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
+    if (priv->program_binaries_dirty)
+        shader_glsl_save_program_binaries(priv);
+    wine_rb_destroy(&priv->program_binaries, glsl_program_binary_free, NULL);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
     heap_free(priv->stack);
@@ -57,6 +57,10 @@ struct shader_spirv_resource_bindings
     enum wined3d_shader_type so_stage;
 };
 
+#define WINED3D_SPIRV_CACHE_MAGIC       0x56525053u /* "SPRV" */
+#define WINED3D_SPIRV_CACHE_VERSION     1
+#define WINED3D_SPIRV_CACHE_MAX_SIZE    (64 * 1024 * 1024)
+
 struct shader_spirv_priv
 {
     const struct wined3d_vertex_pipe_ops *vertex_pipe;
@@ -64,6 +68,35 @@ struct shader_spirv_priv
     bool ffp_proj_control;
 
     struct shader_spirv_resource_bindings bindings;
+
+    struct wine_rb_tree spirv_cache;
+    SIZE_T spirv_cache_size;
+    uint8_t spirv_cache_id[8];
+    bool spirv_cache_loaded;
+    bool spirv_cache_dirty;
+};
+
+struct shader_spirv_cache_entry
+{
+    struct wine_rb_entry entry;
+    uint64_t key[2];
+    uint32_t size;
+    BYTE data[1];
+};
+
+struct shader_spirv_cache_file_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t padding;
+};
+
+struct shader_spirv_cache_file_entry
+{
+    uint64_t key[2];
+    uint32_t size;
+    uint32_t padding;
 };
 
 struct shader_spirv_compile_arguments
@@ -101,6 +134,7 @@ struct shader_spirv_compute_program_vk
     VkPipeline vk_pipeline;
     VkPipelineLayout vk_pipeline_layout;
     VkDescriptorSetLayout vk_set_layout;
+    bool push_descriptors;
 
     struct vkd3d_shader_scan_descriptor_info descriptor_info;
 };
@@ -304,23 +338,226 @@ static void shader_spirv_init_shader_interface_vk(struct wined3d_shader_spirv_sh
     iface->vkd3d_interface.uav_counter_count = b->uav_counter_count;
 }
 
-static VkShaderModule shader_spirv_compile(struct wined3d_context_vk *context_vk,
+static int shader_spirv_cache_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct shader_spirv_cache_entry *e = WINE_RB_ENTRY_VALUE(entry, const struct shader_spirv_cache_entry, entry);
+    const uint64_t *k = key;
+
+    if (k[0] != e->key[0])
+        return k[0] < e->key[0] ? -1 : 1;
+    if (k[1] != e->key[1])
+        return k[1] < e->key[1] ? -1 : 1;
+    return 0;
+}
+
+static void shader_spirv_cache_entry_free(struct wine_rb_entry *entry, void *context)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct shader_spirv_cache_entry, entry));
+}
+
+static void shader_spirv_cache_hash(uint64_t *key, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        key[0] = (key[0] ^ p[i]) * 0x100000001b3ull;
+        key[1] = (key[1] ^ p[i]) * 0xc6a4a7935bd1e995ull;
+        key[1] ^= key[1] >> 47;
+    }
+}
+
+static BOOL shader_spirv_get_cache_path(const struct shader_spirv_priv *priv,
+        WCHAR *path, unsigned int size, BOOL create_dir)
+{
+    static const WCHAR extension[] = {'s','p','v','c','a','c','h','e',0};
+
+    return wined3d_get_cache_file_path(path, size, priv->spirv_cache_id,
+            sizeof(priv->spirv_cache_id), extension, create_dir);
+}
+
+static void shader_spirv_load_cache(struct shader_spirv_priv *priv)
+{
+    uint64_t id[2] = {0xcbf29ce484222325ull, 0x84222325cbf29ce4ull};
+    const struct shader_spirv_cache_file_header *header;
+    const struct shader_spirv_cache_file_entry *e;
+    struct shader_spirv_cache_entry *entry;
+    const char *version;
+    WCHAR path[MAX_PATH];
+    SIZE_T size, offset;
+    unsigned int i;
+    uint64_t hash;
+    BYTE *data;
+
+    priv->spirv_cache_loaded = true;
+
+    /* SPIR-V is device independent, but depends on the vkd3d-shader
+     * version that produced it. */
+    version = vkd3d_shader_get_version(NULL, NULL);
+    shader_spirv_cache_hash(id, version, strlen(version) + 1);
+    hash = id[0] ^ id[1];
+    for (i = 0; i < sizeof(priv->spirv_cache_id); ++i)
+        priv->spirv_cache_id[i] = hash >> (i * 8);
+
+    if (!shader_spirv_get_cache_path(priv, path, ARRAY_SIZE(path), FALSE)
+            || !(data = wined3d_load_cache_file(path, &size)))
+        return;
+
+    header = (const struct shader_spirv_cache_file_header *)data;
+    if (size < sizeof(*header) || header->magic != WINED3D_SPIRV_CACHE_MAGIC
+            || header->version != WINED3D_SPIRV_CACHE_VERSION)
+    {
+        WARN("Ignoring invalid SPIR-V cache %s.\n", debugstr_w(path));
+        heap_free(data);
+        return;
+    }
+
+    for (i = 0, offset = sizeof(*header); i < header->count; ++i)
+    {
+        if (size - offset < sizeof(*e))
+            break;
+        e = (const struct shader_spirv_cache_file_entry *)(data + offset);
+        offset += sizeof(*e);
+        if (!e->size || (e->size & 3) || size - offset < e->size)
+            break;
+
+        if (priv->spirv_cache_size + e->size > WINED3D_SPIRV_CACHE_MAX_SIZE
+                || !(entry = heap_alloc(offsetof(struct shader_spirv_cache_entry, data[e->size]))))
+            break;
+        entry->key[0] = e->key[0];
+        entry->key[1] = e->key[1];
+        entry->size = e->size;
+        memcpy(entry->data, data + offset, e->size);
+        if (wine_rb_put(&priv->spirv_cache, entry->key, &entry->entry) == -1)
+            heap_free(entry);
+        else
+            priv->spirv_cache_size += e->size;
+
+        offset += (e->size + 7) & ~7u;
+        if (offset > size)
+            break;
+    }
+
+    TRACE("Loaded %u SPIR-V shaders from %s.\n", i, debugstr_w(path));
+    heap_free(data);
+}
+
+static void shader_spirv_save_cache(struct shader_spirv_priv *priv)
+{
+    struct shader_spirv_cache_file_header *header;
+    struct shader_spirv_cache_file_entry *e;
+    struct shader_spirv_cache_entry *entry;
+    SIZE_T size, offset;
+    WCHAR path[MAX_PATH];
+    BYTE *data;
+
+    size = sizeof(*header);
+    WINE_RB_FOR_EACH_ENTRY(entry, &priv->spirv_cache, struct shader_spirv_cache_entry, entry)
+    {
+        size += sizeof(*e) + ((entry->size + 7) & ~7u);
+    }
+
+    if (!(data = heap_alloc_zero(size)))
+        return;
+
+    header = (struct shader_spirv_cache_file_header *)data;
+    header->magic = WINED3D_SPIRV_CACHE_MAGIC;
+    header->version = WINED3D_SPIRV_CACHE_VERSION;
+    header->count = 0;
+    offset = sizeof(*header);
+    WINE_RB_FOR_EACH_ENTRY(entry, &priv->spirv_cache, struct shader_spirv_cache_entry, entry)
+    {
+        e = (struct shader_spirv_cache_file_entry *)(data + offset);
+        e->key[0] = entry->key[0];
+        e->key[1] = entry->key[1];
+        e->size = entry->size;
+        offset += sizeof(*e);
+        memcpy(data + offset, entry->data, entry->size);
+        offset += (entry->size + 7) & ~7u;
+        ++header->count;
+    }
+
+    if (shader_spirv_get_cache_path(priv, path, ARRAY_SIZE(path), TRUE))
+        wined3d_save_cache_file(path, data, size);
+    heap_free(data);
+}
+
+/* Everything that affects the generated SPIR-V goes into the key. */
+static void shader_spirv_get_cache_key(const struct wined3d_shader *shader,
+        const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings,
+        uint64_t *key)
+{
+    enum wined3d_shader_type shader_type = shader->reg_maps.shader_version.type;
+
+    key[0] = 0xcbf29ce484222325ull;
+    key[1] = 0x84222325cbf29ce4ull;
+    shader_spirv_cache_hash(key, &shader_type, sizeof(shader_type));
+    if (args)
+        shader_spirv_cache_hash(key, args, sizeof(*args));
+    shader_spirv_cache_hash(key, &bindings->binding_count, sizeof(bindings->binding_count));
+    shader_spirv_cache_hash(key, bindings->bindings, bindings->binding_count * sizeof(*bindings->bindings));
+    shader_spirv_cache_hash(key, &bindings->uav_counter_count, sizeof(bindings->uav_counter_count));
+    shader_spirv_cache_hash(key, bindings->uav_counters,
+            bindings->uav_counter_count * sizeof(*bindings->uav_counters));
+    shader_spirv_cache_hash(key, &shader->byte_code_size, sizeof(shader->byte_code_size));
+    shader_spirv_cache_hash(key, shader->byte_code, shader->byte_code_size);
+}
+
+static VkShaderModule shader_spirv_create_module(struct wined3d_context_vk *context_vk,
+        const void *code, size_t size)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    VkShaderModuleCreateInfo shader_desc;
+    VkShaderModule module;
+    VkResult vr;
+
+    shader_desc.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_desc.pNext = NULL;
+    shader_desc.flags = 0;
+    shader_desc.codeSize = size;
+    shader_desc.pCode = code;
+    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_desc, NULL, &module))) < 0)
+    {
+        WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
+        return VK_NULL_HANDLE;
+    }
+
+    return module;
+}
+
+static VkShaderModule shader_spirv_compile(struct shader_spirv_priv *priv, struct wined3d_context_vk *context_vk,
         struct wined3d_shader *shader, const struct shader_spirv_compile_arguments *args,
         const struct shader_spirv_resource_bindings *bindings, const struct wined3d_stream_output_desc *so_desc)
 {
     struct wined3d_shader_spirv_compile_args compile_args;
     struct wined3d_shader_spirv_shader_interface iface;
+    struct shader_spirv_cache_entry *cache_entry;
     struct vkd3d_shader_compile_info info;
-    const struct wined3d_vk_info *vk_info;
     enum wined3d_shader_type shader_type;
-    VkShaderModuleCreateInfo shader_desc;
-    struct wined3d_device_vk *device_vk;
     struct vkd3d_shader_code spirv;
+    struct wine_rb_entry *entry;
     VkShaderModule module;
+    uint64_t key[2];
     char *messages;
-    VkResult vr;
     int ret;
 
+    /* Stream output descriptions aren't part of the cache key. */
+    if (!so_desc)
+    {
+        if (!priv->spirv_cache_loaded)
+            shader_spirv_load_cache(priv);
+
+        shader_spirv_get_cache_key(shader, args, bindings, key);
+        if ((entry = wine_rb_get(&priv->spirv_cache, key)))
+        {
+            cache_entry = WINE_RB_ENTRY_VALUE(entry, struct shader_spirv_cache_entry, entry);
+            TRACE("Using cached SPIR-V for shader %p.\n", shader);
+            return shader_spirv_create_module(context_vk, cache_entry->data, cache_entry->size);
+        }
+    }
+
     shader_spirv_init_shader_interface_vk(&iface, shader, bindings, so_desc);
     shader_type = shader->reg_maps.shader_version.type;
     shader_spirv_init_compile_args(&compile_args, &iface.vkd3d_interface,
@@ -358,19 +595,23 @@ static VkShaderModule shader_spirv_compile(struct wined3d_context_vk *context_vk
         return VK_NULL_HANDLE;
     }
 
-    device_vk = wined3d_device_vk(context_vk->c.device);
-    vk_info = &device_vk->vk_info;
-
-    shader_desc.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shader_desc.pNext = NULL;
-    shader_desc.flags = 0;
-    shader_desc.codeSize = spirv.size;
-    shader_desc.pCode = spirv.code;
-    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_desc, NULL, &module))) < 0)
+    if ((module = shader_spirv_create_module(context_vk, spirv.code, spirv.size)) && !so_desc
+            && priv->spirv_cache_size + spirv.size <= WINED3D_SPIRV_CACHE_MAX_SIZE
+            && (cache_entry = heap_alloc(offsetof(struct shader_spirv_cache_entry, data[spirv.size]))))
     {
-        vkd3d_shader_free_shader_code(&spirv);
-        WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
-        return VK_NULL_HANDLE;
+        cache_entry->key[0] = key[0];
+        cache_entry->key[1] = key[1];
+        cache_entry->size = spirv.size;
+        memcpy(cache_entry->data, spirv.code, spirv.size);
+        if (wine_rb_put(&priv->spirv_cache, cache_entry->key, &cache_entry->entry) == -1)
+        {
+            heap_free(cache_entry);
+        }
+        else
+        {
+            priv->spirv_cache_size += spirv.size;
+            priv->spirv_cache_dirty = true;
+        }
     }
 
     vkd3d_shader_free_shader_code(&spirv);
@@ -413,7 +654,7 @@ static struct shader_spirv_graphics_program_variant_vk *shader_spirv_find_graphi
     variant_vk = &program_vk->variants[variant_count];
     variant_vk->compile_args = args;
     variant_vk->binding_base = binding_base;
-    if (!(variant_vk->vk_module = shader_spirv_compile(context_vk, shader, &args, bindings, so_desc)))
+    if (!(variant_vk->vk_module = shader_spirv_compile(priv, context_vk, shader, &args, bindings, so_desc)))
         return NULL;
     ++program_vk->variant_count;
 
@@ -437,7 +678,7 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     if (program->vk_module)
         return program;
 
-    if (!(program->vk_module = shader_spirv_compile(context_vk, shader, NULL, bindings, NULL)))
+    if (!(program->vk_module = shader_spirv_compile(priv, context_vk, shader, NULL, bindings, NULL)))
         return NULL;
 
     if (!(layout = wined3d_context_vk_get_pipeline_layout(context_vk,
@@ -449,6 +690,7 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     }
     program->vk_set_layout = layout->vk_set_layout;
     program->vk_pipeline_layout = layout->vk_pipeline_layout;
+    program->push_descriptors = layout->push_descriptors;
 
     pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
     pipeline_info.pNext = NULL;
@@ -464,7 +706,7 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
     pipeline_info.basePipelineIndex = -1;
     if ((vr = VK_CALL(vkCreateComputePipelines(device_vk->vk_device,
-            VK_NULL_HANDLE, 1, &pipeline_info, NULL, &program->vk_pipeline))) < 0)
+            device_vk->vk_pipeline_cache, 1, &pipeline_info, NULL, &program->vk_pipeline))) < 0)
     {
         ERR("Failed to create Vulkan compute pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
         VK_CALL(vkDestroyShaderModule(device_vk->vk_device, program->vk_module, NULL));
@@ -845,6 +1087,7 @@ static void shader_spirv_select(void *shader_priv, struct wined3d_context *conte
     layout_vk = wined3d_context_vk_get_pipeline_layout(context_vk, bindings->vk_bindings, bindings->vk_binding_count);
     context_vk->graphics.vk_set_layout = layout_vk->vk_set_layout;
     context_vk->graphics.vk_pipeline_layout = layout_vk->vk_pipeline_layout;
+    context_vk->graphics.push_descriptors = layout_vk->push_descriptors;
 
     for (shader_type = 0; shader_type < ARRAY_SIZE(context_vk->graphics.vk_modules); ++shader_type)
     {
@@ -892,12 +1135,14 @@ static void shader_spirv_select_compute(void *shader_priv,
         context_vk->compute.vk_pipeline = program->vk_pipeline;
         context_vk->compute.vk_set_layout = program->vk_set_layout;
         context_vk->compute.vk_pipeline_layout = program->vk_pipeline_layout;
+        context_vk->compute.push_descriptors = program->push_descriptors;
     }
     else
     {
         context_vk->compute.vk_pipeline = VK_NULL_HANDLE;
         context_vk->compute.vk_set_layout = VK_NULL_HANDLE;
         context_vk->compute.vk_pipeline_layout = VK_NULL_HANDLE;
+        context_vk->compute.push_descriptors = false;
     }
 }
 
@@ -1055,6 +1300,10 @@ static HRESULT shader_spirv_alloc(struct wined3d_device *device,
     fragment_pipe->get_caps(device->adapter, &fragment_caps);
     priv->ffp_proj_control = fragment_caps.wined3d_caps & WINED3D_FRAGMENT_CAP_PROJ_CONTROL;
     memset(&priv->bindings, 0, sizeof(priv->bindings));
+    wine_rb_init(&priv->spirv_cache, shader_spirv_cache_compare);
+    priv->spirv_cache_size = 0;
+    priv->spirv_cache_loaded = false;
+    priv->spirv_cache_dirty = false;
 
     device->vertex_priv = vertex_priv;
     device->fragment_priv = fragment_priv;
@@ -1067,6 +1316,9 @@ static void shader_spirv_free(struct wined3d_device *device, struct wined3d_cont
 {
     struct shader_spirv_priv *priv = device->shader_priv;
 
+    if (priv->spirv_cache_dirty)
+        shader_spirv_save_cache(priv);
+    wine_rb_destroy(&priv->spirv_cache, shader_spirv_cache_entry_free, NULL);
     shader_spirv_resource_bindings_cleanup(&priv->bindings);
     priv->fragment_pipe->free_private(device, context);
     priv->vertex_pipe->vp_free(device, context);
@@ -355,6 +355,7 @@ static void stateblock_init_lights(struct list *dst_map, const struct list *src_
 
             *dst_light = *src_light;
             list_add_tail(&dst_map[i], &dst_light->entry);
+            list_init(&dst_light->changed_entry);
         }
     }
 }
@@ -547,6 +548,7 @@ void wined3d_stateblock_state_cleanup(struct wined3d_stateblock_state *state)
         LIST_FOR_EACH_ENTRY_SAFE(light, cursor, &state->light_state->light_map[i], struct wined3d_light_info, entry)
         {
             list_remove(&light->entry);
+            list_remove(&light->changed_entry);
             heap_free(light);
         }
     }
@@ -623,6 +625,7 @@ HRESULT wined3d_light_state_set_light(struct wined3d_light_state *state, DWORD l
 
         hash_idx = LIGHTMAP_HASHFUNC(light_idx);
         list_add_head(&state->light_map[hash_idx], &object->entry);
+        list_init(&object->changed_entry);
         object->glIndex = -1;
         object->OriginalIndex = light_idx;
     }
@@ -1564,10 +1567,20 @@ HRESULT CDECL wined3d_stateblock_set_stream_source_freq(struct wined3d_statebloc
     return WINED3D_OK;
 }
 
+static void wined3d_stateblock_invalidate_light(struct wined3d_stateblock *stateblock,
+        struct wined3d_light_info *light_info)
+{
+    /* An unlinked changed_entry points to itself. */
+    if (list_empty(&light_info->changed_entry))
+        list_add_tail(&stateblock->changed_lights, &light_info->changed_entry);
+    stateblock->changed.lights = 1;
+}
+
 HRESULT CDECL wined3d_stateblock_set_light(struct wined3d_stateblock *stateblock,
         UINT light_idx, const struct wined3d_light *light)
 {
     struct wined3d_light_info *object = NULL;
+    HRESULT hr;
 
     TRACE("stateblock %p, light_idx %u, light %p.\n", stateblock, light_idx, light);
 
@@ -1600,8 +1613,10 @@ HRESULT CDECL wined3d_stateblock_set_light(struct wined3d_stateblock *stateblock
             return WINED3DERR_INVALIDCALL;
     }
 
-    stateblock->changed.lights = 1;
-    return wined3d_light_state_set_light(stateblock->stateblock_state.light_state, light_idx, light, &object);
+    if (FAILED(hr = wined3d_light_state_set_light(stateblock->stateblock_state.light_state, light_idx, light, &object)))
+        return hr;
+    wined3d_stateblock_invalidate_light(stateblock, object);
+    return WINED3D_OK;
 }
 
 HRESULT CDECL wined3d_stateblock_set_light_enable(struct wined3d_stateblock *stateblock, UINT light_idx, BOOL enable)
@@ -1618,7 +1633,7 @@ HRESULT CDECL wined3d_stateblock_set_light_enable(struct wined3d_stateblock *sta
             return hr;
     }
     wined3d_light_state_enable_light(light_state, &stateblock->device->adapter->d3d_info, light_info, enable);
-    stateblock->changed.lights = 1;
+    wined3d_stateblock_invalidate_light(stateblock, light_info);
     return S_OK;
 }
 
@@ -1958,6 +1973,7 @@ static HRESULT stateblock_init(struct wined3d_stateblock *stateblock, const stru
 
     stateblock->ref = 1;
     stateblock->device = device;
+    list_init(&stateblock->changed_lights);
     stateblock->stateblock_state.light_state = &stateblock->light_state;
     wined3d_stateblock_state_init(&stateblock->stateblock_state, device,
             type == WINED3D_SBT_PRIMARY ? WINED3D_STATE_INIT_DEFAULT : 0);
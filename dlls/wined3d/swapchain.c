@@ -991,6 +991,8 @@ static HRESULT wined3d_swapchain_vk_create_vulkan_swapchain(struct wined3d_swapc
         goto fail;
     }
     swapchain_vk->vk_swapchain = vk_swapchain;
+    swapchain_vk->vk_format = vk_format;
+    swapchain_vk->vk_extent = vk_swapchain_desc.imageExtent;
 
     if (!wined3d_swapchain_vk_create_vulkan_swapchain_images(swapchain_vk, vk_swapchain))
     {
@@ -1031,6 +1033,19 @@ static void wined3d_swapchain_vk_set_swap_interval(struct wined3d_swapchain_vk *
     wined3d_swapchain_vk_recreate(swapchain_vk);
 }
 
+static BOOL wined3d_swapchain_vk_can_copy(const struct wined3d_swapchain_vk *swapchain_vk,
+        const struct wined3d_texture_vk *back_buffer_vk, const RECT *src_rect, const RECT *dst_rect)
+{
+    if (wined3d_format_vk(back_buffer_vk->t.resource.format)->vk_format != swapchain_vk->vk_format)
+        return FALSE;
+    if (src_rect->right - src_rect->left != dst_rect->right - dst_rect->left
+            || src_rect->bottom - src_rect->top != dst_rect->bottom - dst_rect->top)
+        return FALSE;
+    return src_rect->left >= 0 && src_rect->top >= 0 && dst_rect->left >= 0 && dst_rect->top >= 0
+            && dst_rect->right <= (LONG)swapchain_vk->vk_extent.width
+            && dst_rect->bottom <= (LONG)swapchain_vk->vk_extent.height;
+}
+
 static void wined3d_swapchain_vk_blit(struct wined3d_swapchain_vk *swapchain_vk,
         struct wined3d_context_vk *context_vk, const RECT *src_rect, const RECT *dst_rect, unsigned int swap_interval)
 {
@@ -1043,6 +1058,7 @@ static void wined3d_swapchain_vk_blit(struct wined3d_swapchain_vk *swapchain_vk,
     unsigned int present_idx;
     VkImageLayout vk_layout;
     uint32_t image_idx;
+    VkImageCopy copy;
     VkImageBlit blit;
     VkResult vr;
     HRESULT hr;
@@ -1088,27 +1104,53 @@ static void wined3d_swapchain_vk_blit(struct wined3d_swapchain_vk *swapchain_vk,
             VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             swapchain_vk->vk_images[image_idx], VK_IMAGE_ASPECT_COLOR_BIT);
 
-    blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    blit.srcSubresource.mipLevel = 0;
-    blit.srcSubresource.baseArrayLayer = 0;
-    blit.srcSubresource.layerCount = 1;
-    blit.srcOffsets[0].x = src_rect->left;
-    blit.srcOffsets[0].y = src_rect->top;
-    blit.srcOffsets[0].z = 0;
-    blit.srcOffsets[1].x = src_rect->right;
-    blit.srcOffsets[1].y = src_rect->bottom;
-    blit.srcOffsets[1].z = 1;
-    blit.dstSubresource = blit.srcSubresource;
-    blit.dstOffsets[0].x = dst_rect->left;
-    blit.dstOffsets[0].y = dst_rect->top;
-    blit.dstOffsets[0].z = 0;
-    blit.dstOffsets[1].x = dst_rect->right;
-    blit.dstOffsets[1].y = dst_rect->bottom;
-    blit.dstOffsets[1].z = 1;
-    VK_CALL(vkCmdBlitImage(vk_command_buffer,
-            back_buffer_vk->vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-            swapchain_vk->vk_images[image_idx], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1, &blit, VK_FILTER_NEAREST));
+    if (wined3d_swapchain_vk_can_copy(swapchain_vk, back_buffer_vk, src_rect, dst_rect))
+    {
+        /* A straight copy avoids the format conversion and scaling paths of
+         * vkCmdBlitImage(), and can be done by the copy engine. */
+        copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.srcSubresource.mipLevel = 0;
+        copy.srcSubresource.baseArrayLayer = 0;
+        copy.srcSubresource.layerCount = 1;
+        copy.srcOffset.x = src_rect->left;
+        copy.srcOffset.y = src_rect->top;
+        copy.srcOffset.z = 0;
+        copy.dstSubresource = copy.srcSubresource;
+        copy.dstOffset.x = dst_rect->left;
+        copy.dstOffset.y = dst_rect->top;
+        copy.dstOffset.z = 0;
+        copy.extent.width = src_rect->right - src_rect->left;
+        copy.extent.height = src_rect->bottom - src_rect->top;
+        copy.extent.depth = 1;
+        VK_CALL(vkCmdCopyImage(vk_command_buffer,
+                back_buffer_vk->vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                swapchain_vk->vk_images[image_idx], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &copy));
+    }
+    else
+    {
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = 0;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.srcOffsets[0].x = src_rect->left;
+        blit.srcOffsets[0].y = src_rect->top;
+        blit.srcOffsets[0].z = 0;
+        blit.srcOffsets[1].x = src_rect->right;
+        blit.srcOffsets[1].y = src_rect->bottom;
+        blit.srcOffsets[1].z = 1;
+        blit.dstSubresource = blit.srcSubresource;
+        blit.dstOffsets[0].x = dst_rect->left;
+        blit.dstOffsets[0].y = dst_rect->top;
+        blit.dstOffsets[0].z = 0;
+        blit.dstOffsets[1].x = dst_rect->right;
+        blit.dstOffsets[1].y = dst_rect->bottom;
+        blit.dstOffsets[1].z = 1;
+        VK_CALL(vkCmdBlitImage(vk_command_buffer,
+                back_buffer_vk->vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                swapchain_vk->vk_images[image_idx], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit, VK_FILTER_NEAREST));
+    }
 
     wined3d_context_vk_reference_texture(context_vk, back_buffer_vk);
     wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
@@ -2287,43 +2287,47 @@ static void wined3d_fixup_alpha(const struct wined3d_format *format, const uint8
         unsigned int src_row_pitch, uint8_t *dst, unsigned int dst_row_pitch,
         unsigned int width, unsigned int height)
 {
-    unsigned int byte_count, alpha_mask;
-    unsigned int x, y;
+    unsigned int byte_count, alpha_mask, row_size;
+    uint8_t mask_bytes[sizeof(uint64_t)];
+    unsigned int i, x, y;
+    uint64_t mask, v;
 
     byte_count = format->byte_count;
     alpha_mask = ((1u << format->alpha_size) - 1) << format->alpha_offset;
 
+    /* Replicate the mask over a 64-bit word, and OR it into the rows a
+     * word at a time. Since every lane holds the same mask this works
+     * regardless of endianness. */
     switch (byte_count)
     {
         case 2:
-            for (y = 0; y < height; ++y)
-            {
-                const uint16_t *src_row = (const uint16_t *)&src[y * src_row_pitch];
-                uint16_t *dst_row = (uint16_t *)&dst[y * dst_row_pitch];
-
-                for (x = 0; x < width; ++x)
-                {
-                    dst_row[x] = src_row[x] | alpha_mask;
-                }
-            }
+            mask = alpha_mask * 0x0001000100010001ull;
             break;
 
         case 4:
-            for (y = 0; y < height; ++y)
-            {
-                const uint32_t *src_row = (const uint32_t *)&src[y * src_row_pitch];
-                uint32_t *dst_row = (uint32_t *)&dst[y * dst_row_pitch];
-
-                for (x = 0; x < width; ++x)
-                {
-                    dst_row[x] = src_row[x] | alpha_mask;
-                }
-            }
+            mask = alpha_mask * 0x0000000100000001ull;
             break;
 
         default:
             ERR("Unsupported byte count %u.\n", byte_count);
-            break;
+            return;
+    }
+    memcpy(mask_bytes, &mask, sizeof(mask));
+
+    row_size = width * byte_count;
+    for (y = 0; y < height; ++y)
+    {
+        const uint8_t *src_row = &src[y * src_row_pitch];
+        uint8_t *dst_row = &dst[y * dst_row_pitch];
+
+        for (x = 0; x + sizeof(v) <= row_size; x += sizeof(v))
+        {
+            memcpy(&v, &src_row[x], sizeof(v));
+            v |= mask;
+            memcpy(&dst_row[x], &v, sizeof(v));
+        }
+        for (i = 0; x < row_size; ++i, ++x)
+            dst_row[x] = src_row[x] | mask_bytes[i];
     }
 }
 
@@ -4579,6 +4583,18 @@ const VkDescriptorImageInfo *wined3d_texture_vk_get_default_image_info(struct wi
     return &texture_vk->default_image_info;
 }
 
+static bool wined3d_texture_vk_use_transfer_queue(const struct wined3d_texture_vk *texture_vk,
+        const struct wined3d_context_vk *context_vk, unsigned int size)
+{
+    if (!texture_vk->transfer_queue || size < WINED3D_VK_TRANSFER_UPLOAD_MIN_SIZE)
+        return false;
+
+    /* Transfer commands execute before the current command buffer, and
+     * concurrently with command buffers that haven't completed yet. */
+    return texture_vk->command_buffer_id <= context_vk->completed_command_buffer_id
+            || texture_vk->transfer_command_buffer_id == context_vk->current_command_buffer.id;
+}
+
 static void wined3d_texture_vk_upload_data(struct wined3d_context *context,
         const struct wined3d_const_bo_address *src_bo_addr, const struct wined3d_format *src_format,
         const struct wined3d_box *src_box, unsigned int src_row_pitch, unsigned int src_slice_pitch,
@@ -4597,6 +4613,7 @@ static void wined3d_texture_vk_upload_data(struct wined3d_context *context,
     struct wined3d_range range;
     VkBufferImageCopy region;
     size_t src_offset;
+    bool transfer;
     void *map_ptr;
 
     TRACE("context %p, src_bo_addr %s, src_format %s, src_box %s, src_row_pitch %u, src_slice_pitch %u, "
@@ -4677,19 +4694,37 @@ static void wined3d_texture_vk_upload_data(struct wined3d_context *context,
     range.size = sub_resource->size;
     wined3d_context_unmap_bo_address(context, &staging_bo_addr, 1, &range);
 
-    if (!(vk_command_buffer = wined3d_context_vk_get_command_buffer(context_vk)))
+    /* Large uploads to textures that the GPU isn't using go through the
+     * transfer queue. These execute before the current command buffer, and
+     * may overlap with previously submitted rendering. */
+    transfer = wined3d_texture_vk_use_transfer_queue(dst_texture_vk, context_vk, sub_resource->size)
+            && !(staging_bo.buffer_offset & 3)
+            && (vk_command_buffer = wined3d_context_vk_get_transfer_command_buffer(context_vk));
+    if (!transfer && !(vk_command_buffer = wined3d_context_vk_get_command_buffer(context_vk)))
     {
         ERR("Failed to get command buffer.\n");
         wined3d_context_vk_destroy_bo(context_vk, &staging_bo);
         return;
     }
 
-    wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-            vk_access_mask_from_bind_flags(dst_texture_vk->t.resource.bind_flags),
-            VK_ACCESS_TRANSFER_WRITE_BIT,
-            dst_texture_vk->layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            dst_texture_vk->vk_image, aspect_mask);
+    if (transfer)
+    {
+        TRACE("Uploading %u bytes through the transfer queue.\n", sub_resource->size);
+        wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                dst_texture_vk->layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                dst_texture_vk->vk_image, aspect_mask);
+    }
+    else
+    {
+        wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                vk_access_mask_from_bind_flags(dst_texture_vk->t.resource.bind_flags),
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                dst_texture_vk->layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                dst_texture_vk->vk_image, aspect_mask);
+    }
 
     region.bufferOffset = staging_bo.buffer_offset;
     region.bufferRowLength = (dst_row_pitch / src_format->block_byte_count) * src_format->block_width;
@@ -4711,13 +4746,28 @@ static void wined3d_texture_vk_upload_data(struct wined3d_context *context,
     VK_CALL(vkCmdCopyBufferToImage(vk_command_buffer, staging_bo.vk_buffer,
             dst_texture_vk->vk_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region));
 
-    wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-            VK_ACCESS_TRANSFER_WRITE_BIT,
-            vk_access_mask_from_bind_flags(dst_texture_vk->t.resource.bind_flags),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dst_texture_vk->layout,
-            dst_texture_vk->vk_image, aspect_mask);
+    if (transfer)
+    {
+        /* The semaphore wait in the current command buffer makes the
+         * transfer write visible to the graphics queue. */
+        wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dst_texture_vk->layout,
+                dst_texture_vk->vk_image, aspect_mask);
+    }
+    else
+    {
+        wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                vk_access_mask_from_bind_flags(dst_texture_vk->t.resource.bind_flags),
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dst_texture_vk->layout,
+                dst_texture_vk->vk_image, aspect_mask);
+    }
     wined3d_context_vk_reference_texture(context_vk, dst_texture_vk);
+    if (transfer)
+        dst_texture_vk->transfer_command_buffer_id = context_vk->current_command_buffer.id;
     wined3d_context_vk_reference_bo(context_vk, &staging_bo);
     wined3d_context_vk_destroy_bo(context_vk, &staging_bo);
 }
@@ -4933,6 +4983,7 @@ BOOL wined3d_texture_vk_prepare_texture(struct wined3d_texture_vk *texture_vk,
     struct wined3d_device_vk *device_vk;
     struct wined3d_resource *resource;
     VkCommandBuffer vk_command_buffer;
+    uint32_t queue_family_indices[2];
     VkImageCreateInfo create_info;
     unsigned int memory_type_idx;
     VkResult vr;
@@ -5021,9 +5072,25 @@ BOOL wined3d_texture_vk_prepare_texture(struct wined3d_texture_vk *texture_vk,
         }
     }
 
-    create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    create_info.queueFamilyIndexCount = 0;
-    create_info.pQueueFamilyIndices = NULL;
+    /* Shader resources without other bindings are typically streamed in;
+     * share them with the transfer queue, so that uploads can happen there. */
+    texture_vk->transfer_queue = context_vk->vk_transfer_command_pool
+            && resource->bind_flags == WINED3D_BIND_SHADER_RESOURCE && create_info.samples == 1
+            && vk_aspect_mask_from_format(&format_vk->f) == VK_IMAGE_ASPECT_COLOR_BIT;
+    if (texture_vk->transfer_queue)
+    {
+        queue_family_indices[0] = device_vk->vk_queue_family_index;
+        queue_family_indices[1] = device_vk->vk_transfer_queue_family_index;
+        create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        create_info.queueFamilyIndexCount = ARRAY_SIZE(queue_family_indices);
+        create_info.pQueueFamilyIndices = queue_family_indices;
+    }
+    else
+    {
+        create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        create_info.queueFamilyIndexCount = 0;
+        create_info.pQueueFamilyIndices = NULL;
+    }
     create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     if ((vr = VK_CALL(vkCreateImage(device_vk->vk_device, &create_info, NULL, &texture_vk->vk_image))) < 0)
     {
@@ -5067,7 +5134,14 @@ BOOL wined3d_texture_vk_prepare_texture(struct wined3d_texture_vk *texture_vk,
         return FALSE;
     }
 
+    /* The image is new, so the initial layout transition can happen on the
+     * transfer queue, ahead of the current command buffer. That allows the
+     * initial upload to happen there as well. */
     wined3d_context_vk_reference_texture(context_vk, texture_vk);
+    if (texture_vk->transfer_queue && (vk_command_buffer = wined3d_context_vk_get_transfer_command_buffer(context_vk)))
+        texture_vk->transfer_command_buffer_id = context_vk->current_command_buffer.id;
+    else
+        vk_command_buffer = wined3d_context_vk_get_command_buffer(context_vk);
     wined3d_context_vk_image_barrier(context_vk, vk_command_buffer,
             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
             0, 0,
@@ -6093,6 +6167,7 @@ static void vk_blitter_clear_rendertargets(struct wined3d_context_vk *context_vk
         const struct wined3d_fb_state *fb, unsigned int rect_count, const RECT *clear_rects, const RECT *draw_rect,
         uint32_t flags, const struct wined3d_color *colour, float depth, unsigned int stencil)
 {
+    VkClearAttachment clear_attachments[WINED3D_MAX_RENDER_TARGETS + 1];
     VkClearValue clear_values[WINED3D_MAX_RENDER_TARGETS + 1];
     VkImageView views[WINED3D_MAX_RENDER_TARGETS + 1];
     struct wined3d_rendertarget_view_vk *rtv_vk;
@@ -6103,9 +6178,11 @@ static void vk_blitter_clear_rendertargets(struct wined3d_context_vk *context_vk
     VkRenderPassBeginInfo begin_desc;
     unsigned int i, attachment_count;
     VkFramebufferCreateInfo fb_desc;
+    unsigned int vk_rect_count = 0;
     VkFramebuffer vk_framebuffer;
     VkRenderPass vk_render_pass;
     bool depth_stencil = false;
+    VkClearRect *vk_rects;
     unsigned int layer_count;
     VkClearColorValue *c;
     VkResult vr;
@@ -6138,6 +6215,8 @@ static void vk_blitter_clear_rendertargets(struct wined3d_context_vk *context_vk
         views[attachment_count] = wined3d_rendertarget_view_vk_get_image_view(rtv_vk, context_vk);
         wined3d_rendertarget_view_vk_barrier(rtv_vk, context_vk, WINED3D_BIND_RENDER_TARGET);
 
+        clear_attachments[attachment_count].aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        clear_attachments[attachment_count].colorAttachment = i;
         c = &clear_values[attachment_count].color;
         if (view->format_flags & WINED3DFMT_FLAG_INTEGER)
         {
@@ -6173,6 +6252,12 @@ static void vk_blitter_clear_rendertargets(struct wined3d_context_vk *context_vk
         views[attachment_count] = wined3d_rendertarget_view_vk_get_image_view(rtv_vk, context_vk);
         wined3d_rendertarget_view_vk_barrier(rtv_vk, context_vk, WINED3D_BIND_DEPTH_STENCIL);
 
+        clear_attachments[attachment_count].aspectMask = 0;
+        if (flags & WINED3DCLEAR_ZBUFFER && view->format->depth_size)
+            clear_attachments[attachment_count].aspectMask |= VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (flags & WINED3DCLEAR_STENCIL && view->format->stencil_size)
+            clear_attachments[attachment_count].aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        clear_attachments[attachment_count].colorAttachment = 0;
         clear_values[attachment_count].depthStencil.depth = depth;
         clear_values[attachment_count].depthStencil.stencil = stencil;
 
@@ -6186,16 +6271,53 @@ static void vk_blitter_clear_rendertargets(struct wined3d_context_vk *context_vk
     if (!attachment_count)
         return;
 
+    /* Clearing several rectangles through load ops would take a render pass
+     * per rectangle. Use a single render pass with vkCmdClearAttachments()
+     * instead. */
+    if (rect_count > 1 && (vk_rects = heap_calloc(rect_count, sizeof(*vk_rects))))
+    {
+        for (i = 0; i < rect_count; ++i)
+        {
+            r.left = max(clear_rects[i].left, draw_rect->left);
+            r.top = max(clear_rects[i].top, draw_rect->top);
+            r.right = min(clear_rects[i].right, draw_rect->right);
+            r.bottom = min(clear_rects[i].bottom, draw_rect->bottom);
+
+            if (r.left >= r.right || r.top >= r.bottom)
+                continue;
+
+            vk_rects[vk_rect_count].rect.offset.x = r.left;
+            vk_rects[vk_rect_count].rect.offset.y = r.top;
+            vk_rects[vk_rect_count].rect.extent.width = r.right - r.left;
+            vk_rects[vk_rect_count].rect.extent.height = r.bottom - r.top;
+            vk_rects[vk_rect_count].baseArrayLayer = 0;
+            vk_rects[vk_rect_count].layerCount = layer_count;
+            ++vk_rect_count;
+        }
+
+        if (!vk_rect_count)
+        {
+            heap_free(vk_rects);
+            return;
+        }
+    }
+    else
+    {
+        vk_rects = NULL;
+    }
+
     if (!(vk_render_pass = wined3d_context_vk_get_render_pass(context_vk, fb,
-            rt_count, flags & (WINED3DCLEAR_ZBUFFER | WINED3DCLEAR_STENCIL), flags)))
+            rt_count, flags & (WINED3DCLEAR_ZBUFFER | WINED3DCLEAR_STENCIL), vk_rects ? 0 : flags)))
     {
         ERR("Failed to get render pass.\n");
+        heap_free(vk_rects);
         return;
     }
 
     if (!(vk_command_buffer = wined3d_context_vk_get_command_buffer(context_vk)))
     {
         ERR("Failed to get command buffer.\n");
+        heap_free(vk_rects);
         return;
     }
 
@@ -6211,6 +6333,7 @@ static void vk_blitter_clear_rendertargets(struct wined3d_context_vk *context_vk
     if ((vr = VK_CALL(vkCreateFramebuffer(device_vk->vk_device, &fb_desc, NULL, &vk_framebuffer))) < 0)
     {
         ERR("Failed to create Vulkan framebuffer, vr %s.\n", wined3d_debug_vkresult(vr));
+        heap_free(vk_rects);
         return;
     }
 
@@ -6223,6 +6346,27 @@ static void vk_blitter_clear_rendertargets(struct wined3d_context_vk *context_vk
 
     wined3d_context_vk_end_current_render_pass(context_vk);
 
+    if (vk_rects)
+    {
+        for (i = 0; i < attachment_count; ++i)
+        {
+            clear_attachments[i].clearValue = clear_values[i];
+        }
+
+        begin_desc.renderArea.offset.x = draw_rect->left;
+        begin_desc.renderArea.offset.y = draw_rect->top;
+        begin_desc.renderArea.extent.width = draw_rect->right - draw_rect->left;
+        begin_desc.renderArea.extent.height = draw_rect->bottom - draw_rect->top;
+        begin_desc.clearValueCount = 0;
+        begin_desc.pClearValues = NULL;
+        VK_CALL(vkCmdBeginRenderPass(vk_command_buffer, &begin_desc, VK_SUBPASS_CONTENTS_INLINE));
+        VK_CALL(vkCmdClearAttachments(vk_command_buffer, attachment_count, clear_attachments,
+                vk_rect_count, vk_rects));
+        VK_CALL(vkCmdEndRenderPass(vk_command_buffer));
+        heap_free(vk_rects);
+        rect_count = 0;
+    }
+
     for (i = 0; i < rect_count; ++i)
     {
         r.left = max(clear_rects[i].left, draw_rect->left);
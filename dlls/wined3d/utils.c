@@ -702,20 +702,19 @@ static void convert_l4a4_unorm(const BYTE *src, BYTE *dst, UINT src_row_pitch, U
      */
     unsigned int x, y, z;
     const unsigned char *Source;
-    unsigned char *Dest;
+    WORD *Dest;
 
     for (z = 0; z < depth; z++)
     {
         for (y = 0; y < height; y++)
         {
             Source = src + z * src_slice_pitch + y * src_row_pitch;
-            Dest = dst + z * dst_slice_pitch + y * dst_row_pitch;
+            Dest = (WORD *)(dst + z * dst_slice_pitch + y * dst_row_pitch);
             for (x = 0; x < width; x++ )
             {
-                unsigned char color = (*Source++);
-                /* A */ Dest[1] = (color & 0xf0u) << 0;
-                /* L */ Dest[0] = (color & 0x0fu) << 4;
-                Dest += 2;
+                WORD color = Source[x];
+                /* A in the high byte, L in the low byte. */
+                Dest[x] = ((color & 0xf0u) << 8) | ((color & 0x0fu) << 4);
             }
         }
     }
@@ -1115,10 +1114,8 @@ static void convert_b5g6r5_unorm_b5g5r5a1_unorm_color_key(const BYTE *src, unsig
         for (x = 0; x < width; ++x)
         {
             WORD src_color = src_row[x];
-            if (!color_in_range(color_key, src_color))
-                dst_row[x] = 0x8000u | ((src_color & 0xffc0u) >> 1) | (src_color & 0x1fu);
-            else
-                dst_row[x] = ((src_color & 0xffc0u) >> 1) | (src_color & 0x1fu);
+            WORD alpha = color_in_range(color_key, src_color) ? 0 : 0x8000u;
+            dst_row[x] = alpha | ((src_color & 0xffc0u) >> 1) | (src_color & 0x1fu);
         }
     }
 }
@@ -1138,10 +1135,8 @@ static void convert_b5g5r5x1_unorm_b5g5r5a1_unorm_color_key(const BYTE *src, uns
         for (x = 0; x < width; ++x)
         {
             WORD src_color = src_row[x];
-            if (color_in_range(color_key, src_color))
-                dst_row[x] = src_color & ~0x8000;
-            else
-                dst_row[x] = src_color | 0x8000;
+            WORD alpha = color_in_range(color_key, src_color) ? 0 : 0x8000u;
+            dst_row[x] = (src_color & 0x7fffu) | alpha;
         }
     }
 }
@@ -1182,10 +1177,8 @@ static void convert_b8g8r8x8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, uns
         for (x = 0; x < width; ++x)
         {
             DWORD src_color = src_row[x];
-            if (color_in_range(color_key, src_color))
-                dst_row[x] = src_color & ~0xff000000;
-            else
-                dst_row[x] = src_color | 0xff000000;
+            DWORD alpha = color_in_range(color_key, src_color) ? 0 : 0xff000000u;
+            dst_row[x] = (src_color & 0x00ffffffu) | alpha;
         }
     }
 }
@@ -1205,9 +1198,7 @@ static void convert_b8g8r8a8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, uns
         for (x = 0; x < width; ++x)
         {
             DWORD src_color = src_row[x];
-            if (color_in_range(color_key, src_color))
-                src_color &= ~0xff000000;
-            dst_row[x] = src_color;
+            dst_row[x] = src_color & (color_in_range(color_key, src_color) ? 0x00ffffffu : ~0u);
         }
     }
 }
@@ -6809,6 +6800,116 @@ BOOL wined3d_array_reserve(void **elements, SIZE_T *capacity, SIZE_T count, SIZE
     return TRUE;
 }
 
+/* On-disk caches are stored per application and per cache id, in
+ * "%LOCALAPPDATA%\wine\wined3d", as "<exe name>.<hex id>.<extension>". */
+BOOL wined3d_get_cache_file_path(WCHAR *path, unsigned int size, const uint8_t *id,
+        unsigned int id_size, const WCHAR *extension, BOOL create_dir)
+{
+    static const WCHAR local_appdata[] = {'L','O','C','A','L','A','P','P','D','A','T','A',0};
+    static const WCHAR wine_dir[] = {'\\','w','i','n','e',0};
+    static const WCHAR wined3d_dir[] = {'\\','w','i','n','e','d','3','d','\\',0};
+    static const WCHAR hex[] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+    WCHAR exe_path[MAX_PATH], *exe_name, *p;
+    unsigned int len, i;
+
+    if (!(len = GetModuleFileNameW(NULL, exe_path, ARRAY_SIZE(exe_path))) || len >= ARRAY_SIZE(exe_path))
+        return FALSE;
+    for (exe_name = p = exe_path; *p; ++p)
+    {
+        if (*p == '\\')
+            exe_name = p + 1;
+    }
+
+    if (!(len = GetEnvironmentVariableW(local_appdata, path, size)) || len >= size)
+        return FALSE;
+    if (len + lstrlenW(wine_dir) + lstrlenW(wined3d_dir) + lstrlenW(exe_name)
+            + 1 + 2 * id_size + 1 + lstrlenW(extension) >= size)
+        return FALSE;
+
+    lstrcatW(path, wine_dir);
+    if (create_dir)
+        CreateDirectoryW(path, NULL);
+    lstrcatW(path, wined3d_dir);
+    if (create_dir)
+        CreateDirectoryW(path, NULL);
+    lstrcatW(path, exe_name);
+
+    p = path + lstrlenW(path);
+    *p++ = '.';
+    for (i = 0; i < id_size; ++i)
+    {
+        *p++ = hex[id[i] >> 4];
+        *p++ = hex[id[i] & 0xf];
+    }
+    *p++ = '.';
+    lstrcpyW(p, extension);
+
+    return TRUE;
+}
+
+void *wined3d_load_cache_file(const WCHAR *path, SIZE_T *size)
+{
+    LARGE_INTEGER file_size;
+    void *data = NULL;
+    DWORD read;
+    HANDLE file;
+
+    *size = 0;
+    if ((file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart && file_size.QuadPart <= 256 * 1024 * 1024
+            && (data = heap_alloc(file_size.QuadPart)))
+    {
+        if (ReadFile(file, data, file_size.QuadPart, &read, NULL) && read == file_size.QuadPart)
+        {
+            *size = read;
+        }
+        else
+        {
+            heap_free(data);
+            data = NULL;
+        }
+    }
+    CloseHandle(file);
+
+    return data;
+}
+
+/* Write to a temporary file first, so that a crash while saving doesn't
+ * leave a truncated cache behind. */
+BOOL wined3d_save_cache_file(const WCHAR *path, const void *data, SIZE_T size)
+{
+    static const WCHAR tmp_suffix[] = {'.','t','m','p',0};
+    WCHAR tmp_path[MAX_PATH + 4];
+    DWORD written;
+    HANDLE file;
+    BOOL ret;
+
+    if (lstrlenW(path) >= MAX_PATH)
+        return FALSE;
+    lstrcpyW(tmp_path, path);
+    lstrcatW(tmp_path, tmp_suffix);
+    if ((file = CreateFileW(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s.\n", debugstr_w(tmp_path));
+        return FALSE;
+    }
+
+    ret = WriteFile(file, data, size, &written, NULL) && written == size;
+    CloseHandle(file);
+    if (!ret || !MoveFileExW(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to save cache file %s.\n", debugstr_w(path));
+        DeleteFileW(tmp_path);
+        return FALSE;
+    }
+
+    TRACE("Saved %lu bytes to %s.\n", (unsigned long)size, debugstr_w(path));
+    return TRUE;
+}
+
 static void swap_rows(float **a, float **b)
 {
     float *tmp = *a;
@@ -355,6 +355,16 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             else
                 memcpy(wined3d_settings.logo, buffer, len);
         }
+        if (!get_config_key(hkey, appkey, "CSTraceFile", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.cs_trace_file = heap_alloc(len)))
+                ERR("Failed to allocate command stream trace path memory.\n");
+            else
+                memcpy(wined3d_settings.cs_trace_file, buffer, len);
+            ERR_(winediag)("Writing command stream trace to %s.\n", debugstr_a(buffer));
+        }
         if (!get_config_key_dword(hkey, appkey, "MultisampleTextures", &wined3d_settings.multisample_textures))
             ERR_(winediag)("Setting multisample textures to %#x.\n", wined3d_settings.multisample_textures);
         if (!get_config_key_dword(hkey, appkey, "SampleCount", &wined3d_settings.sample_count))
@@ -440,6 +450,7 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(swapchain_state_table.hooks);
 
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.cs_trace_file);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_command_cs);
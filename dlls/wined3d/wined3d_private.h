@@ -461,6 +461,7 @@ struct wined3d_settings
     /* Memory tracking and object counting. */
     UINT64 emulated_textureram;
     char *logo;
+    char *cs_trace_file;
     unsigned int multisample_textures;
     unsigned int sample_count;
     BOOL check_float_constants;
@@ -1578,6 +1579,15 @@ struct wined3d_bo_gl
     bool coherent;
     struct list users;
     uint64_t command_fence_id;
+
+    /* Only set for persistently mapped buffer objects. */
+    void *map_ptr;
+};
+
+struct wined3d_retired_bo_gl
+{
+    struct list entry;
+    struct wined3d_bo_gl bo;
 };
 
 static inline GLuint wined3d_bo_gl_id(uintptr_t bo)
@@ -2260,6 +2270,11 @@ struct wined3d_context_gl
 
     GLuint dummy_arbfp_prog;
 
+    /* Persistently mapped buffer objects that were replaced by a discard
+     * map, for reuse once the GPU is done with them. */
+    struct list retired_bos;
+    unsigned int retired_bo_count;
+
     struct
     {
         struct wined3d_command_fence_gl *fences;
@@ -2354,6 +2369,9 @@ struct wined3d_command_buffer_vk
     uint64_t id;
     VkCommandBuffer vk_command_buffer;
     VkFence vk_fence;
+    /* Executed on the transfer queue before vk_command_buffer. */
+    VkCommandBuffer vk_transfer_command_buffer;
+    VkSemaphore vk_transfer_semaphore;
 };
 
 enum wined3d_retired_object_type_vk
@@ -2437,6 +2455,7 @@ struct wined3d_pipeline_layout_vk
     struct wined3d_pipeline_layout_key_vk key;
     VkPipelineLayout vk_pipeline_layout;
     VkDescriptorSetLayout vk_set_layout;
+    bool push_descriptors;
 };
 
 struct wined3d_graphics_pipeline_key_vk
@@ -2496,16 +2515,41 @@ struct wined3d_shader_resource_bindings
     SIZE_T size, count;
 };
 
+struct wined3d_descriptor_key_entry_vk
+{
+    uint32_t binding;
+    uint32_t type;
+    uint64_t handles[3];
+};
+
 struct wined3d_shader_descriptor_writes_vk
 {
     VkWriteDescriptorSet *writes;
     SIZE_T size, count;
+
+    struct wined3d_descriptor_key_entry_vk *key_entries;
+    SIZE_T key_size;
+};
+
+struct wined3d_descriptor_set_key_vk
+{
+    VkDescriptorSetLayout vk_set_layout;
+    SIZE_T entry_count;
+    const struct wined3d_descriptor_key_entry_vk *entries;
+};
+
+struct wined3d_descriptor_set_vk
+{
+    struct wine_rb_entry entry;
+    struct wined3d_descriptor_set_key_vk key;
+    VkDescriptorSet vk_descriptor_set;
 };
 
 struct wined3d_pending_query_vk
 {
     struct wined3d_query_vk *query_vk;
     struct wined3d_query_pool_idx_vk pool_idx;
+    uint64_t command_buffer_id;
 };
 
 struct wined3d_pending_queries_vk
@@ -2516,6 +2560,11 @@ struct wined3d_pending_queries_vk
     SIZE_T count;
 };
 
+#define WINED3D_VK_UPLOAD_BO_SIZE   (4 * 1024 * 1024)
+#define WINED3D_VK_UPLOAD_BO_COUNT  16
+#define WINED3D_VK_TRANSFER_UPLOAD_MIN_SIZE (64 * 1024)
+#define WINED3D_MAX_WAIT_SEMAPHORES_VK 4
+
 struct wined3d_context_vk
 {
     struct wined3d_context c;
@@ -2533,6 +2582,7 @@ struct wined3d_context_vk
         VkPipeline vk_pipeline;
         VkPipelineLayout vk_pipeline_layout;
         VkDescriptorSetLayout vk_set_layout;
+        bool push_descriptors;
         struct wined3d_shader_resource_bindings bindings;
     } graphics;
 
@@ -2541,10 +2591,12 @@ struct wined3d_context_vk
         VkPipeline vk_pipeline;
         VkPipelineLayout vk_pipeline_layout;
         VkDescriptorSetLayout vk_set_layout;
+        bool push_descriptors;
         struct wined3d_shader_resource_bindings bindings;
     } compute;
 
     VkCommandPool vk_command_pool;
+    VkCommandPool vk_transfer_command_pool;
     struct wined3d_command_buffer_vk current_command_buffer;
     uint64_t completed_command_buffer_id;
 
@@ -2559,7 +2611,10 @@ struct wined3d_context_vk
 
     VkFramebuffer vk_framebuffer;
     VkRenderPass vk_render_pass;
+    VkImageView vk_render_pass_views[WINED3D_MAX_RENDER_TARGETS + 1];
+    unsigned int render_pass_attachment_count;
     VkDescriptorPool vk_descriptor_pool;
+    struct wine_rb_tree descriptor_sets;
 
     VkSampleCountFlagBits sample_count;
     unsigned int rt_count;
@@ -2568,6 +2623,14 @@ struct wined3d_context_vk
     VkDeviceSize vk_so_offsets[WINED3D_MAX_STREAM_OUTPUT_BUFFERS];
     struct wined3d_bo_vk vk_so_counter_bo;
 
+    struct
+    {
+        struct wined3d_bo_vk bos[WINED3D_VK_UPLOAD_BO_COUNT];
+        uint8_t *map_ptrs[WINED3D_VK_UPLOAD_BO_COUNT];
+        unsigned int count, current;
+        VkDeviceSize offset;
+    } upload;
+
     struct list active_queries;
     struct wined3d_pending_queries_vk pending_queries;
     struct list free_occlusion_query_pools;
@@ -2621,11 +2684,14 @@ void wined3d_context_vk_destroy_sampler(struct wined3d_context_vk *context_vk,
         VkSampler vk_sampler, uint64_t command_buffer_id) DECLSPEC_HIDDEN;
 void wined3d_context_vk_end_current_render_pass(struct wined3d_context_vk *context_vk) DECLSPEC_HIDDEN;
 VkCommandBuffer wined3d_context_vk_get_command_buffer(struct wined3d_context_vk *context_vk) DECLSPEC_HIDDEN;
+void *wined3d_context_vk_get_upload_memory(struct wined3d_context_vk *context_vk,
+        VkDeviceSize size, struct wined3d_bo_address *address) DECLSPEC_HIDDEN;
 struct wined3d_pipeline_layout_vk *wined3d_context_vk_get_pipeline_layout(struct wined3d_context_vk *context_vk,
         VkDescriptorSetLayoutBinding *bindings, SIZE_T binding_count) DECLSPEC_HIDDEN;
 VkRenderPass wined3d_context_vk_get_render_pass(struct wined3d_context_vk *context_vk,
         const struct wined3d_fb_state *fb, unsigned int rt_count,
         bool depth_stencil, uint32_t clear_flags) DECLSPEC_HIDDEN;
+VkCommandBuffer wined3d_context_vk_get_transfer_command_buffer(struct wined3d_context_vk *context_vk) DECLSPEC_HIDDEN;
 void wined3d_context_vk_image_barrier(struct wined3d_context_vk *context_vk,
         VkCommandBuffer vk_command_buffer, VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask,
         VkAccessFlags src_access_mask, VkAccessFlags dst_access_mask, VkImageLayout old_layout,
@@ -2806,6 +2872,7 @@ struct wined3d_light_info
     float cutoff;
 
     struct list entry;
+    struct list changed_entry;
 };
 
 /* The default light parameters */
@@ -3424,6 +3491,8 @@ struct wined3d_adapter_vk
 
     VkPhysicalDeviceLimits device_limits;
     VkPhysicalDeviceMemoryProperties memory_properties;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+    uint32_t max_push_descriptors;
 };
 
 static inline struct wined3d_adapter_vk *wined3d_adapter_vk(struct wined3d_adapter *adapter)
@@ -3996,10 +4065,15 @@ struct wined3d_device_vk
     VkDevice vk_device;
     VkQueue vk_queue;
     uint32_t vk_queue_family_index;
+    VkQueue vk_transfer_queue;
+    uint32_t vk_transfer_queue_family_index;
     uint32_t timestamp_bits;
 
     struct wined3d_vk_info vk_info;
 
+    VkPipelineCache vk_pipeline_cache;
+    size_t pipeline_cache_initial_size;
+
     struct wined3d_null_resources_vk null_resources_vk;
     struct wined3d_null_views_vk null_views_vk;
 
@@ -4463,6 +4537,10 @@ struct wined3d_texture_vk
     enum VkImageLayout layout;
     uint32_t bind_mask;
     uint64_t command_buffer_id;
+    /* Set while the transfer queue is the only user of the image in the
+     * current command buffer. */
+    uint64_t transfer_command_buffer_id;
+    bool transfer_queue;
 
     VkDescriptorImageInfo default_image_info;
 };
@@ -4631,6 +4709,8 @@ struct wined3d_stateblock
 
     struct wined3d_stateblock_state stateblock_state;
     struct wined3d_light_state light_state;
+    /* Lights set since the stateblock was last applied to the device. */
+    struct list changed_lights;
 
     /* Contained state management */
     DWORD                     contained_render_states[WINEHIGHEST_RENDER_STATE + 1];
@@ -4678,6 +4758,8 @@ enum wined3d_push_constants
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
 #define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_MIN_SPIN_COUNT       10000u
+#define WINED3D_CS_PRESENT_SPIN_COUNT   1000u
 
 struct wined3d_cs_queue
 {
@@ -4713,6 +4795,12 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+    HANDLE present_event;
+    BOOL waiting_for_present;
+
+    unsigned int spin_limit;
+    LONGLONG park_threshold;
+    struct wined3d_cs_stats *stats;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device) DECLSPEC_HIDDEN;
@@ -5296,6 +5384,8 @@ struct wined3d_swapchain_vk
 
     VkSwapchainKHR vk_swapchain;
     VkSurfaceKHR vk_surface;
+    VkFormat vk_format;
+    VkExtent2D vk_extent;
     VkImage *vk_images;
     struct
     {
@@ -5849,6 +5939,10 @@ static inline const struct wined3d_format_vk *wined3d_format_vk(const struct win
 }
 
 BOOL wined3d_array_reserve(void **elements, SIZE_T *capacity, SIZE_T count, SIZE_T size) DECLSPEC_HIDDEN;
+BOOL wined3d_get_cache_file_path(WCHAR *path, unsigned int size, const uint8_t *id,
+        unsigned int id_size, const WCHAR *extension, BOOL create_dir) DECLSPEC_HIDDEN;
+void *wined3d_load_cache_file(const WCHAR *path, SIZE_T *size) DECLSPEC_HIDDEN;
+BOOL wined3d_save_cache_file(const WCHAR *path, const void *data, SIZE_T size) DECLSPEC_HIDDEN;
 
 static inline BOOL wined3d_format_is_typeless(const struct wined3d_format *format)
 {
@@ -6100,6 +6194,7 @@ static inline void wined3d_context_vk_reference_texture(const struct wined3d_con
         struct wined3d_texture_vk *texture_vk)
 {
     texture_vk->command_buffer_id = context_vk->current_command_buffer.id;
+    texture_vk->transfer_command_buffer_id = 0;
 }
 
 static inline void wined3d_context_vk_reference_resource(const struct wined3d_context_vk *context_vk,
@@ -178,6 +178,8 @@
     VK_DEVICE_EXT_PFN(vkCmdBindTransformFeedbackBuffersEXT) \
     VK_DEVICE_EXT_PFN(vkCmdEndQueryIndexedEXT) \
     VK_DEVICE_EXT_PFN(vkCmdEndTransformFeedbackEXT) \
+    /* VK_KHR_push_descriptor */ \
+    VK_DEVICE_EXT_PFN(vkCmdPushDescriptorSetKHR) \
     /* VK_KHR_swapchain */ \
     VK_DEVICE_PFN(vkAcquireNextImageKHR) \
     VK_DEVICE_PFN(vkCreateSwapchainKHR) \
@@ -209,6 +211,7 @@ enum wined3d_vk_extension
     WINED3D_VK_EXT_NONE,
 
     WINED3D_VK_EXT_TRANSFORM_FEEDBACK,
+    WINED3D_VK_KHR_PUSH_DESCRIPTOR,
     WINED3D_VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE,
 
     WINED3D_VK_EXT_COUNT,
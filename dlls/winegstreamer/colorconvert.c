@@ -44,6 +44,26 @@ static const GUID *raw_types[] = {
     &MFVideoFormat_YVYU,
 };
 
+enum color_converter_fast_path
+{
+    FAST_PATH_NONE,
+    FAST_PATH_NV12_TO_RGB32,
+    FAST_PATH_NV12_TO_YUY2,
+};
+
+/* A conversion split into horizontal slices, which are picked up by the
+ * calling thread and by thread pool workers. */
+struct color_converter_job
+{
+    enum color_converter_fast_path fast_path;
+    const BYTE *src;
+    BYTE *dst;
+    UINT32 width, height;
+    const int *matrix;
+    unsigned int slice_count, slice_height;
+    LONG next_slice;
+};
+
 struct color_converter
 {
     IMFTransform IMFTransform_iface;
@@ -55,8 +75,190 @@ struct color_converter
     LONGLONG buffer_pts, buffer_dur;
     struct wg_parser *parser;
     struct wg_parser_stream *stream;
+
+    /* Common conversions are done natively, without going through
+     * GStreamer and copying the frames in and out of the pipeline. */
+    enum color_converter_fast_path fast_path;
+    UINT32 width, height;
+    IMFMediaBuffer *input_buffer;
+    struct color_converter_job job;
+    PTP_WORK work;
 };
 
+/* Fixed point YCbCr to RGB coefficients for limited range input, in the
+ * order luma, Cr to R, Cb to G, Cr to G, Cb to B. */
+static const int bt601_matrix[] = {298, 409, -100, -208, 516};
+static const int bt709_matrix[] = {298, 459, -55, -136, 541};
+static const int bt2020_matrix[] = {298, 430, -48, -166, 548};
+
+/* Matches the colorimetry GStreamer assumes for YUV video without any. */
+static const int *get_default_matrix(UINT32 height)
+{
+    if (height >= 2160)
+        return bt2020_matrix;
+    if (height > 576)
+        return bt709_matrix;
+    return bt601_matrix;
+}
+
+static inline BYTE clamp_byte(int value)
+{
+    return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+/* RGB32 is written bottom-up, like the GStreamer path does. */
+static void convert_nv12_to_rgb32(const struct color_converter_job *job, UINT32 y_start, UINT32 y_end)
+{
+    const BYTE *y_plane = job->src, *uv_plane = job->src + job->width * job->height;
+    const int *m = job->matrix;
+    UINT32 x, y;
+
+    for (y = y_start; y < y_end; ++y)
+    {
+        const BYTE *src_y = y_plane + y * job->width;
+        const BYTE *src_uv = uv_plane + (y / 2) * job->width;
+        BYTE *dst = job->dst + (job->height - 1 - y) * job->width * 4;
+
+        for (x = 0; x < job->width; x += 2)
+        {
+            int u = src_uv[x] - 128, v = src_uv[x + 1] - 128;
+            int r = m[1] * v + 128, g = m[2] * u + m[3] * v + 128, b = m[4] * u + 128;
+            int l0 = m[0] * (src_y[x] - 16), l1 = m[0] * (src_y[x + 1] - 16);
+
+            dst[0] = clamp_byte((l0 + b) >> 8);
+            dst[1] = clamp_byte((l0 + g) >> 8);
+            dst[2] = clamp_byte((l0 + r) >> 8);
+            dst[3] = 0xff;
+            dst[4] = clamp_byte((l1 + b) >> 8);
+            dst[5] = clamp_byte((l1 + g) >> 8);
+            dst[6] = clamp_byte((l1 + r) >> 8);
+            dst[7] = 0xff;
+            dst += 8;
+        }
+    }
+}
+
+static void convert_nv12_to_yuy2(const struct color_converter_job *job, UINT32 y_start, UINT32 y_end)
+{
+    const BYTE *y_plane = job->src, *uv_plane = job->src + job->width * job->height;
+    UINT32 x, y;
+
+    for (y = y_start; y < y_end; ++y)
+    {
+        const BYTE *src_y = y_plane + y * job->width;
+        const BYTE *src_uv = uv_plane + (y / 2) * job->width;
+        BYTE *dst = job->dst + y * job->width * 2;
+
+        for (x = 0; x < job->width; x += 2)
+        {
+            dst[0] = src_y[x];
+            dst[1] = src_uv[x];
+            dst[2] = src_y[x + 1];
+            dst[3] = src_uv[x + 1];
+            dst += 4;
+        }
+    }
+}
+
+static void color_converter_run_slices(struct color_converter_job *job)
+{
+    unsigned int slice;
+    UINT32 y_start;
+
+    while ((slice = InterlockedIncrement(&job->next_slice) - 1) < job->slice_count)
+    {
+        y_start = slice * job->slice_height;
+
+        if (job->fast_path == FAST_PATH_NV12_TO_RGB32)
+            convert_nv12_to_rgb32(job, y_start, min(y_start + job->slice_height, job->height));
+        else
+            convert_nv12_to_yuy2(job, y_start, min(y_start + job->slice_height, job->height));
+    }
+}
+
+static void CALLBACK color_converter_work_callback(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work)
+{
+    color_converter_run_slices(context);
+}
+
+static void color_converter_convert(struct color_converter *converter, const BYTE *src, BYTE *dst)
+{
+    struct color_converter_job *job = &converter->job;
+    unsigned int i, thread_count = 1;
+    SYSTEM_INFO info;
+
+    job->fast_path = converter->fast_path;
+    job->src = src;
+    job->dst = dst;
+    job->width = converter->width;
+    job->height = converter->height;
+    job->matrix = get_default_matrix(converter->height);
+    job->next_slice = 0;
+
+    /* Small frames aren't worth waking up other threads for. */
+    if (converter->width * converter->height >= 640 * 480)
+    {
+        GetSystemInfo(&info);
+        thread_count = min(info.dwNumberOfProcessors, 8);
+        if (thread_count > 1 && !converter->work
+                && !(converter->work = CreateThreadpoolWork(color_converter_work_callback, job, NULL)))
+            thread_count = 1;
+    }
+
+    /* Slices must start on even rows, so that chroma rows aren't split. */
+    job->slice_count = thread_count * 2;
+    job->slice_height = (((converter->height + job->slice_count - 1) / job->slice_count) + 1) & ~1u;
+    job->slice_count = (converter->height + job->slice_height - 1) / job->slice_height;
+
+    for (i = 1; i < thread_count; ++i)
+        SubmitThreadpoolWork(converter->work);
+    color_converter_run_slices(job);
+    if (thread_count > 1)
+        WaitForThreadpoolWorkCallbacks(converter->work, FALSE);
+}
+
+static DWORD color_converter_get_output_size(struct color_converter *converter)
+{
+    if (converter->fast_path == FAST_PATH_NV12_TO_RGB32)
+        return converter->width * converter->height * 4;
+    return converter->width * converter->height * 2;
+}
+
+static enum color_converter_fast_path color_converter_get_fast_path(struct color_converter *converter)
+{
+    GUID input_subtype, output_subtype;
+    UINT64 framesize;
+
+    if (FAILED(IMFMediaType_GetGUID(converter->input_type, &MF_MT_SUBTYPE, &input_subtype))
+            || FAILED(IMFMediaType_GetGUID(converter->output_type, &MF_MT_SUBTYPE, &output_subtype))
+            || FAILED(IMFMediaType_GetUINT64(converter->input_type, &MF_MT_FRAME_SIZE, &framesize)))
+        return FAST_PATH_NONE;
+
+    converter->width = framesize >> 32;
+    converter->height = (UINT32)framesize;
+    if (!converter->width || !converter->height || (converter->width & 1) || (converter->height & 1))
+        return FAST_PATH_NONE;
+
+    if (!IsEqualGUID(&input_subtype, &MFVideoFormat_NV12))
+        return FAST_PATH_NONE;
+    if (IsEqualGUID(&output_subtype, &MFVideoFormat_RGB32))
+        return FAST_PATH_NV12_TO_RGB32;
+    if (IsEqualGUID(&output_subtype, &MFVideoFormat_YUY2))
+        return FAST_PATH_NV12_TO_YUY2;
+    return FAST_PATH_NONE;
+}
+
+static void color_converter_reset_fast_path(struct color_converter *converter)
+{
+    if (converter->input_buffer)
+    {
+        IMFMediaBuffer_Release(converter->input_buffer);
+        converter->input_buffer = NULL;
+        converter->buffer_inflight = FALSE;
+    }
+    converter->fast_path = FAST_PATH_NONE;
+}
+
 static struct color_converter *impl_color_converter_from_IMFTransform(IMFTransform *iface)
 {
     return CONTAINING_RECORD(iface, struct color_converter, IMFTransform_iface);
@@ -100,6 +302,9 @@ static ULONG WINAPI color_converter_Release(IMFTransform *iface)
     {
         transform->cs.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&transform->cs);
+        color_converter_reset_fast_path(transform);
+        if (transform->work)
+            CloseThreadpoolWork(transform->work);
         if (transform->output_type)
             IMFMediaType_Release(transform->output_type);
         if (transform->stream)
@@ -350,6 +555,7 @@ static HRESULT WINAPI color_converter_SetInputType(IMFTransform *iface, DWORD id
                 unix_funcs->wg_parser_disconnect(converter->parser);
                 converter->stream = NULL;
             }
+            color_converter_reset_fast_path(converter);
             IMFMediaType_Release(converter->input_type);
             converter->input_type = NULL;
         }
@@ -418,7 +624,10 @@ static HRESULT WINAPI color_converter_SetInputType(IMFTransform *iface, DWORD id
         converter->stream = NULL;
     }
 
-    if (converter->input_type && converter->output_type)
+    color_converter_reset_fast_path(converter);
+
+    if (converter->input_type && converter->output_type
+            && !(converter->fast_path = color_converter_get_fast_path(converter)))
     {
         struct wg_format output_format;
         mf_media_type_to_wg_format(converter->output_type, &output_format);
@@ -460,6 +669,7 @@ static HRESULT WINAPI color_converter_SetOutputType(IMFTransform *iface, DWORD i
                 unix_funcs->wg_parser_disconnect(converter->parser);
                 converter->stream = NULL;
             }
+            color_converter_reset_fast_path(converter);
             IMFMediaType_Release(converter->output_type);
             converter->output_type = NULL;
         }
@@ -528,7 +738,10 @@ static HRESULT WINAPI color_converter_SetOutputType(IMFTransform *iface, DWORD i
         converter->stream = NULL;
     }
 
-    if (converter->input_type && converter->output_type)
+    color_converter_reset_fast_path(converter);
+
+    if (converter->input_type && converter->output_type
+            && !(converter->fast_path = color_converter_get_fast_path(converter)))
     {
         struct wg_format input_format;
         mf_media_type_to_wg_format(converter->input_type, &input_format);
@@ -626,6 +839,15 @@ static HRESULT WINAPI color_converter_ProcessMessage(IMFTransform *iface, MFT_ME
                 return S_OK;
             }
 
+            if (converter->fast_path)
+            {
+                IMFMediaBuffer_Release(converter->input_buffer);
+                converter->input_buffer = NULL;
+                converter->buffer_inflight = FALSE;
+                LeaveCriticalSection(&converter->cs);
+                return S_OK;
+            }
+
             while (event.type != WG_PARSER_EVENT_BUFFER)
                 unix_funcs->wg_parser_stream_get_event(converter->stream, &event);
 
@@ -664,7 +886,7 @@ static HRESULT WINAPI color_converter_ProcessInput(IMFTransform *iface, DWORD id
 
     EnterCriticalSection(&converter->cs);
 
-    if (!converter->stream)
+    if (!converter->stream && !converter->fast_path)
     {
         hr = MF_E_TRANSFORM_TYPE_NOT_SET;
         goto done;
@@ -679,6 +901,24 @@ static HRESULT WINAPI color_converter_ProcessInput(IMFTransform *iface, DWORD id
     if (FAILED(hr = IMFSample_ConvertToContiguousBuffer(sample, &buffer)))
         goto done;
 
+    if (converter->fast_path)
+    {
+        if (FAILED(hr = IMFMediaBuffer_GetCurrentLength(buffer, &buffer_size)))
+            goto done;
+        if (buffer_size < converter->width * converter->height * 3 / 2)
+        {
+            WARN("Input buffer is too small (%u bytes).\n", buffer_size);
+            hr = E_INVALIDARG;
+            goto done;
+        }
+
+        /* Keep the input around, and convert straight into the output
+         * buffer in ProcessOutput(). */
+        converter->input_buffer = buffer;
+        buffer = NULL;
+        goto inflight;
+    }
+
     if (FAILED(hr = IMFMediaBuffer_Lock(buffer, &buffer_data, NULL, &buffer_size)))
         goto done;
 
@@ -702,6 +942,7 @@ static HRESULT WINAPI color_converter_ProcessInput(IMFTransform *iface, DWORD id
     }
 
     IMFMediaBuffer_Unlock(buffer);
+inflight:
     converter->buffer_inflight = TRUE;
     if (FAILED(IMFSample_GetSampleTime(sample, &converter->buffer_pts)))
         converter->buffer_pts = -1;
@@ -723,7 +964,8 @@ static HRESULT WINAPI color_converter_ProcessOutput(IMFTransform *iface, DWORD f
     IMFMediaBuffer *buffer = NULL;
     struct wg_parser_event event;
     unsigned char *buffer_data;
-    DWORD buffer_len;
+    DWORD buffer_len, size;
+    BYTE *input_data;
     HRESULT hr = S_OK;
 
     TRACE("%p, %#x, %u, %p, %p.\n", iface, flags, count, samples, status);
@@ -742,7 +984,7 @@ static HRESULT WINAPI color_converter_ProcessOutput(IMFTransform *iface, DWORD f
 
     EnterCriticalSection(&converter->cs);
 
-    if (!converter->stream)
+    if (!converter->stream && !converter->fast_path)
     {
         hr = MF_E_TRANSFORM_TYPE_NOT_SET;
         goto done;
@@ -756,6 +998,12 @@ static HRESULT WINAPI color_converter_ProcessOutput(IMFTransform *iface, DWORD f
 
     for (;;)
     {
+        if (converter->fast_path)
+        {
+            size = color_converter_get_output_size(converter);
+            break;
+        }
+
         unix_funcs->wg_parser_stream_get_event(converter->stream, &event);
 
         switch (event.type)
@@ -770,12 +1018,13 @@ static HRESULT WINAPI color_converter_ProcessOutput(IMFTransform *iface, DWORD f
                 WARN("Unexpected event, %u\n", event.type);
                 continue;
         }
+        size = event.u.buffer.size;
         break;
     }
 
     if (!samples[0].pSample)
     {
-        if (FAILED(hr = MFCreateMemoryBuffer(event.u.buffer.size, &buffer)))
+        if (FAILED(hr = MFCreateMemoryBuffer(size, &buffer)))
         {
             ERR("Failed to create buffer, hr %#x.\n", hr);
             goto done;
@@ -811,16 +1060,16 @@ static HRESULT WINAPI color_converter_ProcessOutput(IMFTransform *iface, DWORD f
         goto done;
     }
 
-    if (buffer_len < event.u.buffer.size)
+    if (buffer_len < size)
     {
         WARN("Client's buffer is smaller (%u bytes) than the output sample (%u bytes)\n",
-            buffer_len, event.u.buffer.size);
+            buffer_len, size);
 
         hr = MF_E_BUFFERTOOSMALL;
         goto done;
     }
 
-    if (FAILED(hr = IMFMediaBuffer_SetCurrentLength(buffer, event.u.buffer.size)))
+    if (FAILED(hr = IMFMediaBuffer_SetCurrentLength(buffer, size)))
     {
         ERR("Failed to set size, hr %#x.\n", hr);
         goto done;
@@ -832,17 +1081,35 @@ static HRESULT WINAPI color_converter_ProcessOutput(IMFTransform *iface, DWORD f
         goto done;
     }
 
-    if (!unix_funcs->wg_parser_stream_copy_buffer(converter->stream, buffer_data, 0, event.u.buffer.size))
+    if (converter->fast_path)
     {
-        ERR("Failed to copy buffer.\n");
+        if (FAILED(hr = IMFMediaBuffer_Lock(converter->input_buffer, &input_data, NULL, NULL)))
+        {
+            ERR("Failed to lock input buffer, hr %#x.\n", hr);
+            IMFMediaBuffer_Unlock(buffer);
+            goto done;
+        }
+        color_converter_convert(converter, input_data, buffer_data);
+        IMFMediaBuffer_Unlock(converter->input_buffer);
         IMFMediaBuffer_Unlock(buffer);
-        hr = E_FAIL;
-        goto done;
+
+        IMFMediaBuffer_Release(converter->input_buffer);
+        converter->input_buffer = NULL;
     }
+    else
+    {
+        if (!unix_funcs->wg_parser_stream_copy_buffer(converter->stream, buffer_data, 0, event.u.buffer.size))
+        {
+            ERR("Failed to copy buffer.\n");
+            IMFMediaBuffer_Unlock(buffer);
+            hr = E_FAIL;
+            goto done;
+        }
 
-    IMFMediaBuffer_Unlock(buffer);
+        IMFMediaBuffer_Unlock(buffer);
 
-    unix_funcs->wg_parser_stream_release_buffer(converter->stream);
+        unix_funcs->wg_parser_stream_release_buffer(converter->stream);
+    }
     converter->buffer_inflight = FALSE;
 
     if (converter->buffer_pts != -1)
@@ -235,6 +235,12 @@ struct unix_funcs
     bool (CDECL *wg_parser_stream_copy_buffer)(struct wg_parser_stream *stream,
             void *data, uint32_t offset, uint32_t size);
     void (CDECL *wg_parser_stream_release_buffer)(struct wg_parser_stream *stream);
+    /* Detaches the current buffer from the stream without copying it, as if
+     * wg_parser_stream_release_buffer() had been called. The returned pointer
+     * stays mapped read-write until wg_parser_buffer_release(). Returns NULL
+     * if the buffer can't be handed out, in which case it is left in place. */
+    struct wg_parser_buffer *(CDECL *wg_parser_stream_take_buffer)(struct wg_parser_stream *stream, void **data);
+    void (CDECL *wg_parser_buffer_release)(struct wg_parser_buffer *buffer);
     void (CDECL *wg_parser_stream_notify_qos)(struct wg_parser_stream *stream,
             bool underflow, double proportion, int64_t diff, uint64_t timestamp);
 
@@ -49,6 +49,9 @@ struct media_stream
     } state;
     DWORD stream_id;
     BOOL eos;
+
+    /* Number of outstanding buffers referencing GStreamer memory. */
+    LONG wg_buffer_count;
 };
 
 enum source_async_op
@@ -452,55 +455,251 @@ static void dispatch_end_of_presentation(struct media_source *source)
     IMFMediaEventQueue_QueueEventParamVar(source->event_queue, MEEndOfPresentation, &GUID_NULL, S_OK, &empty);
 }
 
-static void send_buffer(struct media_stream *stream, const struct wg_parser_event *event, IUnknown *token)
+/* An IMFMediaBuffer wrapping GStreamer memory directly, so that decoded
+ * frames don't need to be copied. */
+struct wg_media_buffer
 {
-    IMFMediaBuffer *buffer;
-    IMFSample *sample;
-    HRESULT hr;
+    IMFMediaBuffer IMFMediaBuffer_iface;
+    LONG refcount;
+
+    struct media_stream *stream;
+    struct wg_parser_buffer *wg_buffer;
     BYTE *data;
+    DWORD max_length, current_length;
+};
 
-    if (FAILED(hr = MFCreateSample(&sample)))
+/* Decoders and queues may allocate from bounded pools; don't let an
+ * application which holds on to samples starve them. */
+#define MAX_WG_MEDIA_BUFFERS 4
+
+static inline struct wg_media_buffer *impl_from_IMFMediaBuffer(IMFMediaBuffer *iface)
+{
+    return CONTAINING_RECORD(iface, struct wg_media_buffer, IMFMediaBuffer_iface);
+}
+
+static HRESULT WINAPI wg_media_buffer_QueryInterface(IMFMediaBuffer *iface, REFIID riid, void **obj)
+{
+    TRACE("%p, %s, %p.\n", iface, debugstr_guid(riid), obj);
+
+    if (IsEqualIID(riid, &IID_IMFMediaBuffer) ||
+            IsEqualIID(riid, &IID_IUnknown))
     {
-        ERR("Failed to create sample, hr %#x.\n", hr);
-        return;
+        *obj = iface;
+        IMFMediaBuffer_AddRef(iface);
+        return S_OK;
     }
 
-    if (FAILED(hr = MFCreateMemoryBuffer(event->u.buffer.size, &buffer)))
+    WARN("Unsupported %s.\n", debugstr_guid(riid));
+    *obj = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI wg_media_buffer_AddRef(IMFMediaBuffer *iface)
+{
+    struct wg_media_buffer *buffer = impl_from_IMFMediaBuffer(iface);
+    ULONG refcount = InterlockedIncrement(&buffer->refcount);
+
+    TRACE("%p, refcount %u.\n", iface, refcount);
+
+    return refcount;
+}
+
+static ULONG WINAPI wg_media_buffer_Release(IMFMediaBuffer *iface)
+{
+    struct wg_media_buffer *buffer = impl_from_IMFMediaBuffer(iface);
+    ULONG refcount = InterlockedDecrement(&buffer->refcount);
+
+    TRACE("%p, refcount %u.\n", iface, refcount);
+
+    if (!refcount)
     {
-        ERR("Failed to create buffer, hr %#x.\n", hr);
-        IMFSample_Release(sample);
-        return;
+        unix_funcs->wg_parser_buffer_release(buffer->wg_buffer);
+        InterlockedDecrement(&buffer->stream->wg_buffer_count);
+        IMFMediaStream_Release(&buffer->stream->IMFMediaStream_iface);
+        free(buffer);
     }
 
-    if (FAILED(hr = IMFSample_AddBuffer(sample, buffer)))
+    return refcount;
+}
+
+static HRESULT WINAPI wg_media_buffer_Lock(IMFMediaBuffer *iface, BYTE **data, DWORD *max_length, DWORD *current_length)
+{
+    struct wg_media_buffer *buffer = impl_from_IMFMediaBuffer(iface);
+
+    TRACE("%p, %p, %p, %p.\n", iface, data, max_length, current_length);
+
+    if (!data)
+        return E_INVALIDARG;
+
+    *data = buffer->data;
+    if (max_length)
+        *max_length = buffer->max_length;
+    if (current_length)
+        *current_length = buffer->current_length;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI wg_media_buffer_Unlock(IMFMediaBuffer *iface)
+{
+    TRACE("%p.\n", iface);
+
+    return S_OK;
+}
+
+static HRESULT WINAPI wg_media_buffer_GetCurrentLength(IMFMediaBuffer *iface, DWORD *current_length)
+{
+    struct wg_media_buffer *buffer = impl_from_IMFMediaBuffer(iface);
+
+    TRACE("%p, %p.\n", iface, current_length);
+
+    if (!current_length)
+        return E_INVALIDARG;
+
+    *current_length = buffer->current_length;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI wg_media_buffer_SetCurrentLength(IMFMediaBuffer *iface, DWORD current_length)
+{
+    struct wg_media_buffer *buffer = impl_from_IMFMediaBuffer(iface);
+
+    TRACE("%p, %u.\n", iface, current_length);
+
+    if (current_length > buffer->max_length)
+        return E_INVALIDARG;
+
+    buffer->current_length = current_length;
+
+    return S_OK;
+}
+
+static HRESULT WINAPI wg_media_buffer_GetMaxLength(IMFMediaBuffer *iface, DWORD *max_length)
+{
+    struct wg_media_buffer *buffer = impl_from_IMFMediaBuffer(iface);
+
+    TRACE("%p, %p.\n", iface, max_length);
+
+    if (!max_length)
+        return E_INVALIDARG;
+
+    *max_length = buffer->max_length;
+
+    return S_OK;
+}
+
+static const IMFMediaBufferVtbl wg_media_buffer_vtbl =
+{
+    wg_media_buffer_QueryInterface,
+    wg_media_buffer_AddRef,
+    wg_media_buffer_Release,
+    wg_media_buffer_Lock,
+    wg_media_buffer_Unlock,
+    wg_media_buffer_GetCurrentLength,
+    wg_media_buffer_SetCurrentLength,
+    wg_media_buffer_GetMaxLength,
+};
+
+static IMFMediaBuffer *create_wg_media_buffer(struct media_stream *stream, DWORD size)
+{
+    struct wg_media_buffer *buffer;
+
+    if (InterlockedIncrement(&stream->wg_buffer_count) > MAX_WG_MEDIA_BUFFERS)
+        goto fail;
+
+    if (!(buffer = malloc(sizeof(*buffer))))
+        goto fail;
+
+    if (!(buffer->wg_buffer = unix_funcs->wg_parser_stream_take_buffer(stream->wg_stream, (void **)&buffer->data)))
     {
-        ERR("Failed to add buffer, hr %#x.\n", hr);
-        goto out;
+        free(buffer);
+        goto fail;
     }
 
-    if (FAILED(hr = IMFMediaBuffer_SetCurrentLength(buffer, event->u.buffer.size)))
+    buffer->IMFMediaBuffer_iface.lpVtbl = &wg_media_buffer_vtbl;
+    buffer->refcount = 1;
+    buffer->stream = stream;
+    IMFMediaStream_AddRef(&stream->IMFMediaStream_iface);
+    buffer->max_length = buffer->current_length = size;
+
+    return &buffer->IMFMediaBuffer_iface;
+
+fail:
+    InterlockedDecrement(&stream->wg_buffer_count);
+    return NULL;
+}
+
+static IMFMediaBuffer *create_copied_media_buffer(struct media_stream *stream, DWORD size)
+{
+    IMFMediaBuffer *buffer;
+    HRESULT hr;
+    BYTE *data;
+
+    if (FAILED(hr = MFCreateMemoryBuffer(size, &buffer)))
+    {
+        ERR("Failed to create buffer, hr %#x.\n", hr);
+        unix_funcs->wg_parser_stream_release_buffer(stream->wg_stream);
+        return NULL;
+    }
+
+    if (FAILED(hr = IMFMediaBuffer_SetCurrentLength(buffer, size)))
     {
         ERR("Failed to set size, hr %#x.\n", hr);
-        goto out;
+        goto fail;
     }
 
     if (FAILED(hr = IMFMediaBuffer_Lock(buffer, &data, NULL, NULL)))
     {
         ERR("Failed to lock buffer, hr %#x.\n", hr);
-        goto out;
+        goto fail;
     }
 
-    if (!unix_funcs->wg_parser_stream_copy_buffer(stream->wg_stream, data, 0, event->u.buffer.size))
+    if (!unix_funcs->wg_parser_stream_copy_buffer(stream->wg_stream, data, 0, size))
     {
-        unix_funcs->wg_parser_stream_release_buffer(stream->wg_stream);
         IMFMediaBuffer_Unlock(buffer);
-        goto out;
+        goto fail;
     }
     unix_funcs->wg_parser_stream_release_buffer(stream->wg_stream);
 
     if (FAILED(hr = IMFMediaBuffer_Unlock(buffer)))
     {
         ERR("Failed to unlock buffer, hr %#x.\n", hr);
+        IMFMediaBuffer_Release(buffer);
+        return NULL;
+    }
+
+    return buffer;
+
+fail:
+    unix_funcs->wg_parser_stream_release_buffer(stream->wg_stream);
+    IMFMediaBuffer_Release(buffer);
+    return NULL;
+}
+
+static void send_buffer(struct media_stream *stream, const struct wg_parser_event *event, IUnknown *token)
+{
+    IMFMediaBuffer *buffer;
+    IMFSample *sample;
+    HRESULT hr;
+
+    if (FAILED(hr = MFCreateSample(&sample)))
+    {
+        ERR("Failed to create sample, hr %#x.\n", hr);
+        unix_funcs->wg_parser_stream_release_buffer(stream->wg_stream);
+        return;
+    }
+
+    if (!(buffer = create_wg_media_buffer(stream, event->u.buffer.size))
+            && !(buffer = create_copied_media_buffer(stream, event->u.buffer.size)))
+    {
+        IMFSample_Release(sample);
+        return;
+    }
+
+    if (FAILED(hr = IMFSample_AddBuffer(sample, buffer)))
+    {
+        ERR("Failed to add buffer, hr %#x.\n", hr);
         goto out;
     }
 
@@ -75,9 +75,16 @@ struct wg_parser
 
     bool flushing, sink_connected, draining;
 
+    /* Read-ahead cache for small pull mode reads of seekable streams. */
+    guint8 *read_cache;
+    guint64 read_cache_offset;
+    guint read_cache_size;
+
     struct wg_format input_format;
 };
 
+static guint read_ahead_size = 256 * 1024;
+
 struct wg_parser_stream
 {
     struct wg_parser *parser;
@@ -856,6 +863,57 @@ static void CDECL wg_parser_stream_release_buffer(struct wg_parser_stream *strea
     pthread_cond_signal(&stream->event_empty_cond);
 }
 
+struct wg_parser_buffer
+{
+    GstBuffer *buffer;
+    GstMapInfo map_info;
+};
+
+static struct wg_parser_buffer * CDECL wg_parser_stream_take_buffer(struct wg_parser_stream *stream, void **data)
+{
+    struct wg_parser *parser = stream->parser;
+    struct wg_parser_buffer *buffer;
+
+    pthread_mutex_lock(&parser->mutex);
+
+    assert(stream->event.type == WG_PARSER_EVENT_BUFFER);
+
+    /* The caller may write to the data, so only hand out buffers which
+     * nobody else holds a reference to. */
+    if (!stream->buffer || !gst_buffer_is_writable(stream->buffer)
+            || !(buffer = malloc(sizeof(*buffer))))
+    {
+        pthread_mutex_unlock(&parser->mutex);
+        return NULL;
+    }
+
+    gst_buffer_unmap(stream->buffer, &stream->map_info);
+    if (!gst_buffer_map(stream->buffer, &buffer->map_info, GST_MAP_READWRITE))
+    {
+        if (!gst_buffer_map(stream->buffer, &stream->map_info, GST_MAP_READ))
+            GST_ERROR("Failed to map buffer.\n");
+        pthread_mutex_unlock(&parser->mutex);
+        free(buffer);
+        return NULL;
+    }
+
+    buffer->buffer = stream->buffer;
+    *data = buffer->map_info.data;
+    stream->buffer = NULL;
+    stream->event.type = WG_PARSER_EVENT_NONE;
+
+    pthread_mutex_unlock(&parser->mutex);
+    pthread_cond_signal(&stream->event_empty_cond);
+    return buffer;
+}
+
+static void CDECL wg_parser_buffer_release(struct wg_parser_buffer *buffer)
+{
+    gst_buffer_unmap(buffer->buffer, &buffer->map_info);
+    gst_buffer_unref(buffer->buffer);
+    free(buffer);
+}
+
 static uint64_t CDECL wg_parser_stream_get_duration(struct wg_parser_stream *stream)
 {
     return stream->duration;
@@ -973,6 +1031,48 @@ static GstAutoplugSelectResult autoplug_select_cb(GstElement *bin, GstPad *pad,
     return GST_AUTOPLUG_SELECT_TRY;
 }
 
+static bool prefer_hardware_decoders;
+
+static bool factory_is_hardware_decoder(GstElementFactory *factory)
+{
+    const char *klass = gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+
+    return klass && strstr(klass, "Decoder") && strstr(klass, "Hardware");
+}
+
+/* Move hardware decoders to the front of the candidate list, so that
+ * decodebin tries them before falling back to software ones. Frames are
+ * still downloaded to system memory, since that is the only memory our
+ * sink pads accept. */
+static GValueArray *autoplug_sort_cb(GstElement *bin, GstPad *pad,
+        GstCaps *caps, GValueArray *factories, gpointer user)
+{
+    GValueArray *sorted;
+    GValue *value;
+    unsigned int i;
+
+    if (!prefer_hardware_decoders)
+        return NULL;
+
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+    sorted = g_value_array_new(factories->n_values);
+    for (i = 0; i < factories->n_values; ++i)
+    {
+        value = g_value_array_get_nth(factories, i);
+        if (factory_is_hardware_decoder(g_value_get_object(value)))
+            g_value_array_append(sorted, value);
+    }
+    for (i = 0; i < factories->n_values; ++i)
+    {
+        value = g_value_array_get_nth(factories, i);
+        if (!factory_is_hardware_decoder(g_value_get_object(value)))
+            g_value_array_append(sorted, value);
+    }
+G_GNUC_END_IGNORE_DEPRECATIONS
+
+    return sorted;
+}
+
 static void no_more_pads_cb(GstElement *element, gpointer user)
 {
     struct wg_parser *parser = user;
@@ -1512,31 +1612,12 @@ static void pad_removed_cb(GstElement *element, GstPad *pad, gpointer user)
     g_free(name);
 }
 
-static GstFlowReturn pull_data(struct wg_parser *parser, guint64 offset, guint size, guint *size_read, GstBuffer **buffer)
+/* Hands a read request to the read thread and waits for it to complete. */
+static enum wg_read_result read_data(struct wg_parser *parser, void *data, guint64 offset, guint size, guint *size_read)
 {
-    GstBuffer *new_buffer = NULL;
     enum wg_read_result ret;
-    GstMapInfo map_info;
     unsigned int i;
 
-    GST_LOG("pad %p, offset %" G_GINT64_MODIFIER "u, length %u, buffer %p.", parser->my_src, offset, size, *buffer);
-
-    if (offset == GST_BUFFER_OFFSET_NONE)
-        offset = parser->next_pull_offset;
-    parser->next_pull_offset = offset + size;
-    if (parser->seekable)
-    {
-        if (offset >= parser->file_size)
-            return GST_FLOW_EOS;
-        if (offset + size >= parser->file_size)
-            size = parser->file_size - offset;
-    }
-
-    if (!*buffer)
-        *buffer = new_buffer = gst_buffer_new_and_alloc(size);
-
-    gst_buffer_map(*buffer, &map_info, GST_MAP_WRITE);
-
     pthread_mutex_lock(&parser->mutex);
 
     if (parser->draining)
@@ -1548,7 +1629,7 @@ static GstFlowReturn pull_data(struct wg_parser *parser, guint64 offset, guint s
     }
 
     assert(!parser->read_request.data);
-    parser->read_request.data = map_info.data;
+    parser->read_request.data = data;
     parser->read_request.offset = offset;
     parser->read_request.size = size;
     parser->read_request.done = false;
@@ -1593,6 +1674,65 @@ static GstFlowReturn pull_data(struct wg_parser *parser, guint64 offset, guint s
 
     pthread_mutex_unlock(&parser->mutex);
 
+    return ret;
+}
+
+/* Demuxers in pull mode tend to issue many tiny reads while parsing
+ * headers and indices; each one is a round trip through the read thread.
+ * Serve those from a larger block read instead. */
+static enum wg_read_result read_data_cached(struct wg_parser *parser, void *data, guint64 offset, guint size)
+{
+    enum wg_read_result ret;
+    guint block_size;
+
+    if (!parser->read_cache || offset < parser->read_cache_offset
+            || offset + size > parser->read_cache_offset + parser->read_cache_size)
+    {
+        block_size = min(read_ahead_size, parser->file_size - offset);
+
+        if (!parser->read_cache && !(parser->read_cache = malloc(read_ahead_size)))
+            return read_data(parser, data, offset, size, NULL);
+
+        parser->read_cache_size = 0;
+        if ((ret = read_data(parser, parser->read_cache, offset, block_size, NULL)) != WG_READ_SUCCESS)
+            return ret;
+        parser->read_cache_offset = offset;
+        parser->read_cache_size = block_size;
+    }
+
+    memcpy(data, parser->read_cache + (offset - parser->read_cache_offset), size);
+    return WG_READ_SUCCESS;
+}
+
+static GstFlowReturn pull_data(struct wg_parser *parser, guint64 offset, guint size, guint *size_read, GstBuffer **buffer)
+{
+    GstBuffer *new_buffer = NULL;
+    enum wg_read_result ret;
+    GstMapInfo map_info;
+
+    GST_LOG("pad %p, offset %" G_GINT64_MODIFIER "u, length %u, buffer %p.", parser->my_src, offset, size, *buffer);
+
+    if (offset == GST_BUFFER_OFFSET_NONE)
+        offset = parser->next_pull_offset;
+    parser->next_pull_offset = offset + size;
+    if (parser->seekable)
+    {
+        if (offset >= parser->file_size)
+            return GST_FLOW_EOS;
+        if (offset + size >= parser->file_size)
+            size = parser->file_size - offset;
+    }
+
+    if (!*buffer)
+        *buffer = new_buffer = gst_buffer_new_and_alloc(size);
+
+    gst_buffer_map(*buffer, &map_info, GST_MAP_WRITE);
+
+    if (parser->seekable && !size_read && size < read_ahead_size / 4)
+        ret = read_data_cached(parser, map_info.data, offset, size);
+    else
+        ret = read_data(parser, map_info.data, offset, size, size_read);
+
     gst_buffer_unmap(*buffer, &map_info);
 
     if (size_read)
@@ -1696,7 +1836,7 @@ static void *push_data(void *arg)
 {
     struct wg_parser *parser = arg;
     GstBuffer *last_buffer = NULL;
-    ULONG alloc_size = 16384;
+    ULONG alloc_size = parser->seekable ? max(16384, read_ahead_size) : 16384;
     GstSegment *segment;
     guint max_size;
 
@@ -2260,6 +2400,7 @@ static BOOL decodebin_parser_init_gst(struct wg_parser *parser)
     g_signal_connect(element, "pad-added", G_CALLBACK(pad_added_cb), parser);
     g_signal_connect(element, "pad-removed", G_CALLBACK(pad_removed_cb), parser);
     g_signal_connect(element, "autoplug-select", G_CALLBACK(autoplug_select_cb), parser);
+    g_signal_connect(element, "autoplug-sort", G_CALLBACK(autoplug_sort_cb), parser);
     g_signal_connect(element, "no-more-pads", G_CALLBACK(no_more_pads_cb), parser);
 
     g_object_set(G_OBJECT(element), "max-size-buffers", G_MAXUINT, NULL);
@@ -2593,6 +2734,7 @@ static void CDECL wg_parser_destroy(struct wg_parser *parser)
     pthread_cond_destroy(&parser->read_cond);
     pthread_cond_destroy(&parser->read_done_cond);
 
+    free(parser->read_cache);
     free(parser);
 }
 
@@ -2627,6 +2769,8 @@ static const struct unix_funcs funcs =
     wg_parser_stream_get_event,
     wg_parser_stream_copy_buffer,
     wg_parser_stream_release_buffer,
+    wg_parser_stream_take_buffer,
+    wg_parser_buffer_release,
     wg_parser_stream_notify_qos,
 
     wg_parser_stream_get_duration,
@@ -2671,6 +2815,12 @@ NTSTATUS CDECL __wine_init_unix_lib(HMODULE module, DWORD reason, const void *pt
 
         GST_DEBUG_CATEGORY_INIT(wine, "WINE", GST_DEBUG_FG_RED, "Wine GStreamer support");
 
+        if ((e = getenv("WINE_GST_HW_DECODE")) && *e != '\0' && *e != '0')
+            prefer_hardware_decoders = true;
+
+        if ((e = getenv("WINE_GST_READ_AHEAD")))
+            read_ahead_size = strtoul(e, NULL, 0);
+
         GST_INFO("GStreamer library version %s; wine built with %d.%d.%d.\n",
                 gst_version_string(), GST_VERSION_MAJOR, GST_VERSION_MINOR, GST_VERSION_MICRO);
 
@@ -1124,6 +1124,7 @@ static HRESULT pulse_stream_connect(ACImpl *This, UINT32 period_bytes) {
     char buffer[64];
     static LONG number;
     pa_buffer_attr attr;
+    pa_proplist *props;
     if (This->stream) {
         pa_stream_disconnect(This->stream);
         while (pa_stream_get_state(This->stream) == PA_STREAM_READY)
@@ -1132,7 +1133,19 @@ static HRESULT pulse_stream_connect(ACImpl *This, UINT32 period_bytes) {
     }
     ret = InterlockedIncrement(&number);
     sprintf(buffer, "audio stream #%i", ret);
-    This->stream = pa_stream_new(pulse_ctx, buffer, &This->ss, &This->map);
+
+    /* PipeWire sizes its graph quantum from the node latency of its clients;
+     * pipewire-pulse derives one from the buffer attributes, but only
+     * approximately. Ask for the period directly. PulseAudio ignores it. */
+    if ((props = pa_proplist_new())) {
+        char latency[32];
+
+        sprintf(latency, "%u/%u", period_bytes / pa_frame_size(&This->ss), This->ss.rate);
+        pa_proplist_sets(props, "node.latency", latency);
+    }
+    This->stream = pa_stream_new_with_proplist(pulse_ctx, buffer, &This->ss, &This->map, props);
+    if (props)
+        pa_proplist_free(props);
 
     if (!This->stream) {
         WARN("pa_stream_new returned error %i\n", pa_context_errno(pulse_ctx));
@@ -1601,18 +1614,13 @@ static HRESULT pulse_spec_from_waveformat(ACImpl *This, const WAVEFORMATEX *fmt)
     return S_OK;
 }
 
-static HRESULT WINAPI AudioClient_Initialize(IAudioClient3 *iface,
-        AUDCLNT_SHAREMODE mode, DWORD flags, REFERENCE_TIME duration,
-        REFERENCE_TIME period, const WAVEFORMATEX *fmt,
+static HRESULT initialize_stream(ACImpl *This, AUDCLNT_SHAREMODE mode, DWORD flags,
+        REFERENCE_TIME duration, REFERENCE_TIME period, const WAVEFORMATEX *fmt,
         const GUID *sessionguid)
 {
-    ACImpl *This = impl_from_IAudioClient3(iface);
     HRESULT hr = S_OK;
     UINT32 bufsize_bytes;
 
-    TRACE("(%p)->(%x, %x, %s, %s, %p, %s)\n", This, mode, flags,
-          wine_dbgstr_longlong(duration), wine_dbgstr_longlong(period), fmt, debugstr_guid(sessionguid));
-
     if (!fmt)
         return E_POINTER;
 
@@ -1655,7 +1663,6 @@ static HRESULT WINAPI AudioClient_Initialize(IAudioClient3 *iface,
     if (FAILED(hr))
         goto exit;
 
-    period = pulse_def_period[This->dataflow == eCapture];
     if (duration < 3 * period)
         duration = 3 * period;
 
@@ -1725,6 +1732,21 @@ exit:
     return hr;
 }
 
+static HRESULT WINAPI AudioClient_Initialize(IAudioClient3 *iface,
+        AUDCLNT_SHAREMODE mode, DWORD flags, REFERENCE_TIME duration,
+        REFERENCE_TIME period, const WAVEFORMATEX *fmt,
+        const GUID *sessionguid)
+{
+    ACImpl *This = impl_from_IAudioClient3(iface);
+
+    TRACE("(%p)->(%x, %x, %s, %s, %p, %s)\n", This, mode, flags,
+          wine_dbgstr_longlong(duration), wine_dbgstr_longlong(period), fmt, debugstr_guid(sessionguid));
+
+    /* The period is ignored for shared mode streams. */
+    return initialize_stream(This, mode, flags, duration,
+            pulse_def_period[This->dataflow == eCapture], fmt, sessionguid);
+}
+
 static HRESULT WINAPI AudioClient_GetBufferSize(IAudioClient3 *iface,
         UINT32 *out)
 {
@@ -2303,21 +2325,43 @@ static HRESULT WINAPI AudioClient_GetSharedModeEnginePeriod(IAudioClient3 *iface
         UINT32 *min_period_frames, UINT32 *max_period_frames)
 {
     ACImpl *This = impl_from_IAudioClient3(iface);
+    UINT32 rate;
 
-    FIXME("(%p)->(%p, %p, %p, %p, %p)\n", This, format, default_period_frames, unit_period_frames,
+    TRACE("(%p)->(%p, %p, %p, %p, %p)\n", This, format, default_period_frames, unit_period_frames,
             min_period_frames, max_period_frames);
 
-    return E_NOTIMPL;
+    if (!format || !default_period_frames || !unit_period_frames || !min_period_frames || !max_period_frames)
+        return E_POINTER;
+
+    /* Small periods are passed on to PulseAudio as the stream latency, down to
+     * the minimum period the server reported for the default device. */
+    rate = format->nSamplesPerSec;
+    *default_period_frames = pulse_def_period[This->dataflow == eCapture] * rate / 10000000;
+    *min_period_frames = (pulse_min_period[This->dataflow == eCapture] * rate + 9999999) / 10000000;
+    *max_period_frames = *default_period_frames;
+    *unit_period_frames = 1;
+
+    return S_OK;
 }
 
 static HRESULT WINAPI AudioClient_GetCurrentSharedModeEnginePeriod(IAudioClient3 *iface,
         WAVEFORMATEX **cur_format, UINT32 *cur_period_frames)
 {
     ACImpl *This = impl_from_IAudioClient3(iface);
+    HRESULT hr;
 
-    FIXME("(%p)->(%p, %p)\n", This, cur_format, cur_period_frames);
+    TRACE("(%p)->(%p, %p)\n", This, cur_format, cur_period_frames);
 
-    return E_NOTIMPL;
+    if (!cur_format || !cur_period_frames)
+        return E_POINTER;
+
+    if (FAILED(hr = IAudioClient3_GetMixFormat(iface, cur_format)))
+        return hr;
+
+    *cur_period_frames = MulDiv(pulse_def_period[This->dataflow == eCapture],
+            (*cur_format)->nSamplesPerSec, 10000000);
+
+    return S_OK;
 }
 
 static HRESULT WINAPI AudioClient_InitializeSharedAudioStream(IAudioClient3 *iface,
@@ -2325,10 +2369,23 @@ static HRESULT WINAPI AudioClient_InitializeSharedAudioStream(IAudioClient3 *ifa
         const GUID *session_guid)
 {
     ACImpl *This = impl_from_IAudioClient3(iface);
+    REFERENCE_TIME period;
 
-    FIXME("(%p)->(0x%x, %u, %p, %s)\n", This, flags, period_frames, format, debugstr_guid(session_guid));
+    TRACE("(%p)->(0x%x, %u, %p, %s)\n", This, flags, period_frames, format, debugstr_guid(session_guid));
 
-    return E_NOTIMPL;
+    if (!format)
+        return E_POINTER;
+    if (!format->nSamplesPerSec)
+        return E_INVALIDARG;
+
+    period = (REFERENCE_TIME)period_frames * 10000000 / format->nSamplesPerSec;
+    if (period < pulse_min_period[This->dataflow == eCapture]
+            || period > pulse_def_period[This->dataflow == eCapture])
+        return E_INVALIDARG;
+
+    /* The buffer is sized from the period, as IAudioClient3 callers expect
+     * the smallest buffer that works for it. */
+    return initialize_stream(This, AUDCLNT_SHAREMODE_SHARED, flags, 0, period, format, session_guid);
 }
 
 static const IAudioClient3Vtbl AudioClient3_Vtbl =
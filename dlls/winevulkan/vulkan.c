@@ -85,6 +85,13 @@ void WINAPI wine_vkGetPhysicalDeviceProperties(VkPhysicalDevice physical_device,
     wine_vk_add_handle_mapping((instance), (uint64_t) (uintptr_t) (object), (uint64_t) (uintptr_t) (native_handle), &(object)->mapping)
 #define WINE_VK_ADD_NON_DISPATCHABLE_MAPPING(instance, object, native_handle) \
     wine_vk_add_handle_mapping((instance), (uint64_t) (uintptr_t) (object), (uint64_t) (native_handle), &(object)->mapping)
+static inline struct list *wine_vk_wrapper_bucket(struct VkInstance_T *instance, uint64_t native_handle)
+{
+    uint64_t hash = native_handle * 0x9e3779b97f4a7c15ull;
+
+    return &instance->wrappers[(hash >> 32) % WINE_VK_WRAPPER_BUCKET_COUNT];
+}
+
 static void  wine_vk_add_handle_mapping(struct VkInstance_T *instance, uint64_t wrapped_handle,
         uint64_t native_handle, struct wine_vk_mapping *mapping)
 {
@@ -93,7 +100,7 @@ static void  wine_vk_add_handle_mapping(struct VkInstance_T *instance, uint64_t
         mapping->native_handle = native_handle;
         mapping->wine_wrapped_handle = wrapped_handle;
         AcquireSRWLockExclusive(&instance->wrapper_lock);
-        list_add_tail(&instance->wrappers, &mapping->link);
+        list_add_tail(wine_vk_wrapper_bucket(instance, native_handle), &mapping->link);
         ReleaseSRWLockExclusive(&instance->wrapper_lock);
     }
 }
@@ -115,8 +122,11 @@ static uint64_t wine_vk_get_wrapper(struct VkInstance_T *instance, uint64_t nati
     struct wine_vk_mapping *mapping;
     uint64_t result = 0;
 
+    if (!instance->enable_wrapper_list)
+        return 0;
+
     AcquireSRWLockShared(&instance->wrapper_lock);
-    LIST_FOR_EACH_ENTRY(mapping, &instance->wrappers, struct wine_vk_mapping, link)
+    LIST_FOR_EACH_ENTRY(mapping, wine_vk_wrapper_bucket(instance, native_handle), struct wine_vk_mapping, link)
     {
         if (mapping->native_handle == native_handle)
         {
@@ -846,7 +856,8 @@ VkResult WINAPI wine_vkAllocateCommandBuffers(VkDevice device,
 void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
         const VkCommandBuffer *buffers)
 {
-    VkCommandBuffer *tmp_buffers;
+    VkCommandBuffer stack_buffers[WINE_VK_STACK_COMMAND_BUFFER_COUNT];
+    VkCommandBuffer *tmp_buffers = stack_buffers;
     unsigned int i;
 
     TRACE("%p %u %p\n", buffer, count, buffers);
@@ -855,11 +866,8 @@ void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
         return;
 
     /* Unfortunately we need a temporary buffer as our command buffers are wrapped.
-     * This call is called often and if a performance concern, we may want to use
-     * alloca as we shouldn't need much memory and it needs to be cleaned up after
-     * the call anyway.
-     */
-    if (!(tmp_buffers = heap_alloc(count * sizeof(*tmp_buffers))))
+     * This call is called often, so avoid the heap for the common case. */
+    if (count > ARRAY_SIZE(stack_buffers) && !(tmp_buffers = heap_alloc(count * sizeof(*tmp_buffers))))
     {
         ERR("Failed to allocate memory for temporary command buffers\n");
         return;
@@ -870,7 +878,8 @@ void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
 
     buffer->device->funcs.p_vkCmdExecuteCommands(buffer->command_buffer, count, tmp_buffers);
 
-    heap_free(tmp_buffers);
+    if (tmp_buffers != stack_buffers)
+        heap_free(tmp_buffers);
 }
 
 VkResult WINAPI __wine_create_vk_device_with_callback(VkPhysicalDevice phys_dev,
@@ -997,6 +1006,7 @@ VkResult WINAPI __wine_create_vk_instance_with_callback(const VkInstanceCreateIn
     VkInstanceCreateInfo create_info_host;
     const VkApplicationInfo *app_info;
     struct VkInstance_T *object;
+    unsigned int i;
     VkResult res;
 
     TRACE("create_info %p, allocator %p, instance %p, native_vkCreateInstance %p, context %p.\n",
@@ -1015,7 +1025,8 @@ VkResult WINAPI __wine_create_vk_instance_with_callback(const VkInstanceCreateIn
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
     object->base.loader_magic = VULKAN_ICD_MAGIC_VALUE;
-    list_init(&object->wrappers);
+    for (i = 0; i < ARRAY_SIZE(object->wrappers); ++i)
+        list_init(&object->wrappers[i]);
     InitializeSRWLock(&object->wrapper_lock);
 
     res = wine_vk_instance_convert_create_info(create_info, &create_info_host, object);
@@ -1431,10 +1442,13 @@ VkResult WINAPI wine_vk_icdNegotiateLoaderICDInterfaceVersion(uint32_t *supporte
 VkResult WINAPI wine_vkQueueSubmit(VkQueue queue, uint32_t count,
         const VkSubmitInfo *submits, VkFence fence)
 {
-    VkSubmitInfo *submits_host;
-    VkResult res;
+    VkCommandBuffer stack_command_buffers[WINE_VK_STACK_COMMAND_BUFFER_COUNT];
+    VkSubmitInfo stack_submits[WINE_VK_STACK_SUBMIT_COUNT];
+    VkSubmitInfo *submits_host = stack_submits;
     VkCommandBuffer *command_buffers;
     unsigned int i, j, num_command_buffers;
+    VkResult res;
+    void *buffer;
 
     TRACE("%p %u %p 0x%s\n", queue, count, submits, wine_dbgstr_longlong(fence));
 
@@ -1443,41 +1457,39 @@ VkResult WINAPI wine_vkQueueSubmit(VkQueue queue, uint32_t count,
         return queue->device->funcs.p_vkQueueSubmit(queue->queue, 0, NULL, fence);
     }
 
-    submits_host = heap_calloc(count, sizeof(*submits_host));
-    if (!submits_host)
+    for (i = 0, num_command_buffers = 0; i < count; i++)
+        num_command_buffers += submits[i].commandBufferCount;
+
+    /* Submits are frequent; use the stack unless the submission is unusually
+     * large, and a single heap allocation otherwise. */
+    command_buffers = stack_command_buffers;
+    if (count > ARRAY_SIZE(stack_submits) || num_command_buffers > ARRAY_SIZE(stack_command_buffers))
     {
-        ERR("Unable to allocate memory for submit buffers!\n");
-        return VK_ERROR_OUT_OF_HOST_MEMORY;
+        if (!(buffer = heap_alloc(count * sizeof(*submits_host) + num_command_buffers * sizeof(*command_buffers))))
+        {
+            ERR("Unable to allocate memory for submit buffers!\n");
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        submits_host = buffer;
+        command_buffers = (VkCommandBuffer *)(submits_host + count);
     }
 
     for (i = 0; i < count; i++)
     {
         memcpy(&submits_host[i], &submits[i], sizeof(*submits_host));
 
-        num_command_buffers = submits[i].commandBufferCount;
-        command_buffers = heap_calloc(num_command_buffers, sizeof(*command_buffers));
-        if (!command_buffers)
-        {
-            ERR("Unable to allocate memory for command buffers!\n");
-            res = VK_ERROR_OUT_OF_HOST_MEMORY;
-            goto done;
-        }
-
-        for (j = 0; j < num_command_buffers; j++)
+        for (j = 0; j < submits[i].commandBufferCount; j++)
         {
             command_buffers[j] = submits[i].pCommandBuffers[j]->command_buffer;
         }
         submits_host[i].pCommandBuffers = command_buffers;
+        command_buffers += submits[i].commandBufferCount;
     }
 
     res = queue->device->funcs.p_vkQueueSubmit(queue->queue, count, submits_host, fence);
 
-done:
-    for (i = 0; i < count; i++)
-    {
-        heap_free((void *)submits_host[i].pCommandBuffers);
-    }
-    heap_free(submits_host);
+    if (submits_host != stack_submits)
+        heap_free(submits_host);
 
     TRACE("Returning %d\n", res);
     return res;
@@ -1697,7 +1709,14 @@ static inline uint64_t convert_monotonic_timestamp(uint64_t value)
         InterlockedCompareExchange64(&freq.QuadPart, temp.QuadPart, 0);
     }
 
-    return value * freq.QuadPart / NANOSECONDS_IN_A_SECOND;
+    /* The performance counter is derived from the same host clock, so this
+     * is an exact linear mapping. Split the multiplication; value * freq
+     * overflows after half an hour of uptime with a 10 MHz counter. */
+    if (!(NANOSECONDS_IN_A_SECOND % freq.QuadPart))
+        return value / (NANOSECONDS_IN_A_SECOND / freq.QuadPart);
+
+    return (value / NANOSECONDS_IN_A_SECOND) * freq.QuadPart
+            + (value % NANOSECONDS_IN_A_SECOND) * freq.QuadPart / NANOSECONDS_IN_A_SECOND;
 }
 
 static inline uint64_t convert_timestamp(VkTimeDomainEXT host_domain, VkTimeDomainEXT target_domain, uint64_t value)
@@ -1718,12 +1737,15 @@ VkResult WINAPI wine_vkGetCalibratedTimestampsEXT(VkDevice device,
     uint32_t timestamp_count, const VkCalibratedTimestampInfoEXT *timestamp_infos,
     uint64_t *timestamps, uint64_t *max_deviation)
 {
-    VkCalibratedTimestampInfoEXT* host_timestamp_infos;
+    VkCalibratedTimestampInfoEXT stack_timestamp_infos[4];
+    VkCalibratedTimestampInfoEXT *host_timestamp_infos = stack_timestamp_infos;
     unsigned int i;
     VkResult res;
     TRACE("%p, %u, %p, %p, %p\n", device, timestamp_count, timestamp_infos, timestamps, max_deviation);
 
-    if (!(host_timestamp_infos = heap_alloc(sizeof(VkCalibratedTimestampInfoEXT) * timestamp_count)))
+    /* Frame pacing code calls this every frame, usually with two domains. */
+    if (timestamp_count > ARRAY_SIZE(stack_timestamp_infos)
+            && !(host_timestamp_infos = heap_alloc(sizeof(VkCalibratedTimestampInfoEXT) * timestamp_count)))
         return VK_ERROR_OUT_OF_HOST_MEMORY;
 
     for (i = 0; i < timestamp_count; i++)
@@ -1734,13 +1756,15 @@ VkResult WINAPI wine_vkGetCalibratedTimestampsEXT(VkDevice device,
     }
 
     res = device->funcs.p_vkGetCalibratedTimestampsEXT(device->device, timestamp_count, host_timestamp_infos, timestamps, max_deviation);
-    if (res != VK_SUCCESS)
-        return res;
-
-    for (i = 0; i < timestamp_count; i++)
-        timestamps[i] = convert_timestamp(host_timestamp_infos[i].timeDomain, timestamp_infos[i].timeDomain, timestamps[i]);
+    if (res == VK_SUCCESS)
+    {
+        for (i = 0; i < timestamp_count; i++)
+            timestamps[i] = convert_timestamp(host_timestamp_infos[i].timeDomain,
+                    timestamp_infos[i].timeDomain, timestamps[i]);
+    }
 
-    heap_free(host_timestamp_infos);
+    if (host_timestamp_infos != stack_timestamp_infos)
+        heap_free(host_timestamp_infos);
 
     return res;
 }
@@ -63,6 +63,13 @@ struct wine_vk_base
 /* Some extensions have callbacks for those we need to be able to
  * get the wine wrapper for a native handle
  */
+#define WINE_VK_WRAPPER_BUCKET_COUNT 256
+
+/* Temporary storage for unwrapping command buffers which is kept on the
+ * stack; larger requests fall back to the heap. */
+#define WINE_VK_STACK_COMMAND_BUFFER_COUNT 64
+#define WINE_VK_STACK_SUBMIT_COUNT 16
+
 struct wine_vk_mapping
 {
     struct list link;
@@ -159,8 +166,10 @@ struct VkInstance_T
     struct VkPhysicalDevice_T **phys_devs;
     uint32_t phys_dev_count;
 
+    /* Native to wrapped handle mappings, only maintained when debug
+     * callbacks need them, hashed by native handle. */
     VkBool32 enable_wrapper_list;
-    struct list wrappers;
+    struct list wrappers[WINE_VK_WRAPPER_BUCKET_COUNT];
     SRWLOCK wrapper_lock;
 
     struct wine_debug_utils_messenger *utils_messengers;
@@ -1569,6 +1569,8 @@ struct x11drv_window_surface
     DWORD                 alpha_bits;
     COLORREF              color_key;
     HRGN                  region;
+    HRGN                  shape_region;  /* layered shape last set on the window */
+    BOOL                  shape_valid;   /* whether the window shape still matches shape_region */
     void                 *bits;
 #ifdef HAVE_LIBXXSHM
     XShmSegmentInfo       shminfo;
@@ -1615,15 +1617,18 @@ static inline void add_row( HRGN rgn, RGNDATA *data, int x, int y, int len )
 
 /***********************************************************************
  *           update_surface_region
+ *
+ * Update the window shape of a layered surface. If rows is set, only the pixels
+ * in that band of the surface have changed since the last update.
  */
-static void update_surface_region( struct x11drv_window_surface *surface )
+static void update_surface_region( struct x11drv_window_surface *surface, const RECT *rows )
 {
 #ifdef HAVE_LIBXSHAPE
     char buffer[4096];
     RGNDATA *data = (RGNDATA *)buffer;
     BITMAPINFO *info = &surface->info;
     UINT *masks = (UINT *)info->bmiColors;
-    int x, y, start, width;
+    int x, y, start, width, top, bottom;
     HRGN rgn;
 
     if (!shape_layered_windows) return;
@@ -1631,6 +1636,8 @@ static void update_surface_region( struct x11drv_window_surface *surface )
     if (!surface->is_argb && surface->color_key == CLR_INVALID)
     {
         XShapeCombineMask( gdi_display, surface->window, ShapeBounding, 0, 0, None, ShapeSet );
+        if (surface->shape_region) DeleteObject( surface->shape_region );
+        surface->shape_region = 0;
         return;
     }
 
@@ -1639,8 +1646,24 @@ static void update_surface_region( struct x11drv_window_surface *surface )
     data->rdh.nCount = 0;
     data->rdh.nRgnSize = sizeof(buffer) - sizeof(data->rdh);
 
-    rgn = CreateRectRgn( 0, 0, 0, 0 );
     width = surface->header.rect.right - surface->header.rect.left;
+    top = 0;
+    bottom = surface->header.rect.bottom - surface->header.rect.top;
+
+    if (rows && surface->shape_region)
+    {
+        /* keep the shape of the rows that haven't been drawn to */
+        HRGN band;
+
+        top = max( rows->top, top );
+        bottom = min( rows->bottom, bottom );
+        band = CreateRectRgn( surface->header.rect.left, surface->header.rect.top + top,
+                              surface->header.rect.right, surface->header.rect.top + bottom );
+        rgn = CreateRectRgn( 0, 0, 0, 0 );
+        CombineRgn( rgn, surface->shape_region, band, RGN_DIFF );
+        DeleteObject( band );
+    }
+    else rgn = CreateRectRgn( 0, 0, 0, 0 );
 
     switch (info->bmiHeader.biBitCount)
     {
@@ -1650,7 +1673,7 @@ static void update_surface_region( struct x11drv_window_surface *surface )
         int stride = (width + 1) & ~1;
         UINT mask = masks[0] | masks[1] | masks[2];
 
-        for (y = surface->header.rect.top; y < surface->header.rect.bottom; y++, bits += stride)
+        for (y = top, bits += top * stride; y < bottom; y++, bits += stride)
         {
             x = 0;
             while (x < width)
@@ -1658,7 +1681,7 @@ static void update_surface_region( struct x11drv_window_surface *surface )
                 while (x < width && (bits[x] & mask) == surface->color_key) x++;
                 start = x;
                 while (x < width && (bits[x] & mask) != surface->color_key) x++;
-                add_row( rgn, data, surface->header.rect.left + start, y, x - start );
+                add_row( rgn, data, surface->header.rect.left + start, surface->header.rect.top + y, x - start );
             }
         }
         break;
@@ -1668,7 +1691,7 @@ static void update_surface_region( struct x11drv_window_surface *surface )
         BYTE *bits = surface->bits;
         int stride = (width * 3 + 3) & ~3;
 
-        for (y = surface->header.rect.top; y < surface->header.rect.bottom; y++, bits += stride)
+        for (y = top, bits += top * stride; y < bottom; y++, bits += stride)
         {
             x = 0;
             while (x < width)
@@ -1684,7 +1707,7 @@ static void update_surface_region( struct x11drv_window_surface *surface )
                         (bits[x * 3 + 1] != GetGValue(surface->color_key)) ||
                         (bits[x * 3 + 2] != GetRValue(surface->color_key))))
                     x++;
-                add_row( rgn, data, surface->header.rect.left + start, y, x - start );
+                add_row( rgn, data, surface->header.rect.left + start, surface->header.rect.top + y, x - start );
             }
         }
         break;
@@ -1695,7 +1718,7 @@ static void update_surface_region( struct x11drv_window_surface *surface )
 
         if (info->bmiHeader.biCompression == BI_RGB)
         {
-            for (y = surface->header.rect.top; y < surface->header.rect.bottom; y++, bits += width)
+            for (y = top, bits += top * width; y < bottom; y++, bits += width)
             {
                 x = 0;
                 while (x < width)
@@ -1707,14 +1730,14 @@ static void update_surface_region( struct x11drv_window_surface *surface )
                     while (x < width &&
                            !((bits[x] & 0xffffff) == surface->color_key ||
                              (surface->is_argb && !(bits[x] & 0xff000000)))) x++;
-                    add_row( rgn, data, surface->header.rect.left + start, y, x - start );
+                    add_row( rgn, data, surface->header.rect.left + start, surface->header.rect.top + y, x - start );
                 }
             }
         }
         else
         {
             UINT mask = masks[0] | masks[1] | masks[2];
-            for (y = surface->header.rect.top; y < surface->header.rect.bottom; y++, bits += width)
+            for (y = top, bits += top * width; y < bottom; y++, bits += width)
             {
                 x = 0;
                 while (x < width)
@@ -1722,7 +1745,7 @@ static void update_surface_region( struct x11drv_window_surface *surface )
                     while (x < width && (bits[x] & mask) == surface->color_key) x++;
                     start = x;
                     while (x < width && (bits[x] & mask) != surface->color_key) x++;
-                    add_row( rgn, data, surface->header.rect.left + start, y, x - start );
+                    add_row( rgn, data, surface->header.rect.left + start, surface->header.rect.top + y, x - start );
                 }
             }
         }
@@ -1734,6 +1757,13 @@ static void update_surface_region( struct x11drv_window_surface *surface )
 
     if (data->rdh.nCount) flush_rgn_data( rgn, data );
 
+    /* drawing often leaves the shape unchanged, avoid reshaping the window in that case */
+    if (surface->shape_valid && surface->shape_region && EqualRgn( rgn, surface->shape_region ))
+    {
+        DeleteObject( rgn );
+        return;
+    }
+
     if ((data = X11DRV_GetRegionData( rgn, 0 )))
     {
         if (!data->rdh.nCount && wm_is_mutter(gdi_display))
@@ -1754,7 +1784,9 @@ static void update_surface_region( struct x11drv_window_surface *surface )
         HeapFree( GetProcessHeap(), 0, data );
     }
 
-    DeleteObject( rgn );
+    if (surface->shape_region) DeleteObject( surface->shape_region );
+    surface->shape_region = rgn;
+    surface->shape_valid = TRUE;
 #endif
 }
 
@@ -1921,7 +1953,8 @@ static void CDECL x11drv_surface_flush( struct window_surface *window_surface )
                surface, coords.width, coords.height,
                wine_dbgstr_rect( &surface->bounds ), surface->bits );
 
-        if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
+        if (surface->is_argb || surface->color_key != CLR_INVALID)
+            update_surface_region( surface, &coords.visrect );
 
         if (src != dst)
         {
@@ -1993,6 +2026,7 @@ static void CDECL x11drv_surface_destroy( struct window_surface *window_surface
     surface->crit.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection( &surface->crit );
     if (surface->region) DeleteObject( surface->region );
+    if (surface->shape_region) DeleteObject( surface->shape_region );
     HeapFree( GetProcessHeap(), 0, surface );
 }
 
@@ -2092,7 +2126,23 @@ void set_surface_color_key( struct window_surface *window_surface, COLORREF colo
     window_surface->funcs->lock( window_surface );
     prev = surface->color_key;
     set_color_key( surface, color_key );
-    if (surface->color_key != prev) update_surface_region( surface );
+    if (surface->color_key != prev) update_surface_region( surface, NULL );
+    window_surface->funcs->unlock( window_surface );
+}
+
+/***********************************************************************
+ *           invalidate_surface_shape
+ *
+ * The window shape has been changed behind the surface's back, set it again on next flush.
+ */
+void invalidate_surface_shape( struct window_surface *window_surface )
+{
+    struct x11drv_window_surface *surface = get_x11_surface( window_surface );
+
+    if (window_surface->funcs != &x11drv_surface_funcs) return;  /* we may get the null surface */
+
+    window_surface->funcs->lock( window_surface );
+    surface->shape_valid = FALSE;
     window_surface->funcs->unlock( window_surface );
 }
 
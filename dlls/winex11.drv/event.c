@@ -438,17 +438,21 @@ static BOOL process_events( Display *display, Bool (*filter)(Display*, XEvent*,X
 {
     XEvent event, prev_event;
     int count = 0;
-    BOOL queued = FALSE, overlay_enabled = FALSE;
+    BOOL queued = FALSE, overlay_checked = FALSE, overlay_enabled = FALSE;
     enum event_merge_action action = MERGE_DISCARD;
     ULONG_PTR overlay_filter = QS_KEY | QS_MOUSEBUTTON | QS_MOUSEMOVE;
 
-    if (WaitForSingleObject(steam_overlay_event, 0) == WAIT_OBJECT_0)
-        overlay_enabled = TRUE;
-
     prev_event.type = 0;
     while (XCheckIfEvent( display, &event, filter, (char *)arg ))
     {
         count++;
+        /* only query the overlay state once there is something to process,
+         * this is called on every message wait and usually finds no event */
+        if (!overlay_checked)
+        {
+            overlay_enabled = WaitForSingleObject( steam_overlay_event, 0 ) == WAIT_OBJECT_0;
+            overlay_checked = TRUE;
+        }
         if (overlay_enabled && filter_event( display, &event, (char *)overlay_filter )) continue;
         if (XFilterEvent( &event, None ))
         {
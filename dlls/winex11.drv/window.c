@@ -489,6 +489,7 @@ static void sync_window_region( struct x11drv_win_data *data, HRGN win_region )
     }
 
     data->shaped = FALSE;
+    if (data->surface) invalidate_surface_shape( data->surface );
 
     if (IsRectEmpty( &data->window_rect ))  /* set an empty shape */
     {
@@ -211,6 +211,7 @@ extern DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisu
 extern struct window_surface *create_surface( Window window, const XVisualInfo *vis, const RECT *rect,
                                               COLORREF color_key, BOOL use_alpha ) DECLSPEC_HIDDEN;
 extern void set_surface_color_key( struct window_surface *window_surface, COLORREF color_key ) DECLSPEC_HIDDEN;
+extern void invalidate_surface_shape( struct window_surface *window_surface ) DECLSPEC_HIDDEN;
 extern HRGN expose_surface( struct window_surface *window_surface, const RECT *rect ) DECLSPEC_HIDDEN;
 
 extern RGNDATA *X11DRV_GetRegionData( HRGN hrgn, HDC hdc_lptodp ) DECLSPEC_HIDDEN;
@@ -48,6 +48,7 @@ BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID lpv)
     case DLL_PROCESS_DETACH:
         if (lpv) break;
         netconn_unload();
+        release_cred_cache();
         release_typelib();
         break;
     }
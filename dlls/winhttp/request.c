@@ -42,6 +42,8 @@
 WINE_DEFAULT_DEBUG_CHANNEL(winhttp);
 
 #define DEFAULT_KEEP_ALIVE_TIMEOUT 30000
+#define DEFAULT_MAX_IDLE_CONNECTIONS 16
+#define HOST_ADDRESS_TIMEOUT 60000
 
 static const WCHAR *attribute_table[] =
 {
@@ -1320,6 +1322,35 @@ static CRITICAL_SECTION connection_pool_cs = { &connection_pool_debug, -1, 0, 0,
 
 static struct list connection_pool = LIST_INIT( connection_pool );
 
+/* the pool is shared by all sessions in the process, tunable under HKCU\Software\Wine\WinHttp */
+static DWORD keep_alive_timeout = DEFAULT_KEEP_ALIVE_TIMEOUT;
+static DWORD max_idle_connections = DEFAULT_MAX_IDLE_CONNECTIONS;
+
+static BOOL WINAPI read_pool_config( INIT_ONCE *once, void *param, void **ctx )
+{
+    DWORD type, size, value;
+    HKEY key;
+
+    if (RegOpenKeyExW( HKEY_CURRENT_USER, L"Software\\Wine\\WinHttp", 0, KEY_READ, &key )) return TRUE;
+
+    size = sizeof(value);
+    if (!RegQueryValueExW( key, L"KeepAliveTimeout", NULL, &type, (BYTE *)&value, &size ) && type == REG_DWORD)
+        keep_alive_timeout = value;
+    size = sizeof(value);
+    if (!RegQueryValueExW( key, L"MaxIdleConnectionsPerServer", NULL, &type, (BYTE *)&value, &size ) &&
+        type == REG_DWORD) max_idle_connections = value;
+    RegCloseKey( key );
+
+    TRACE( "keep-alive timeout %u, max idle connections %u\n", keep_alive_timeout, max_idle_connections );
+    return TRUE;
+}
+
+static void init_pool_config( void )
+{
+    static INIT_ONCE once = INIT_ONCE_STATIC_INIT;
+    InitOnceExecuteOnce( &once, read_pool_config, NULL, NULL );
+}
+
 void release_host( struct hostdata *host )
 {
     LONG ref;
@@ -1376,12 +1407,26 @@ static void CALLBACK connection_collector( TP_CALLBACK_INSTANCE *instance, void
 
 static void cache_connection( struct netconn *netconn )
 {
+    struct netconn *oldest = NULL;
+
+    init_pool_config();
+    if (!keep_alive_timeout || !max_idle_connections)
+    {
+        netconn_close( netconn );
+        return;
+    }
+
     TRACE( "caching connection %p\n", netconn );
 
     EnterCriticalSection( &connection_pool_cs );
 
-    netconn->keep_until = GetTickCount64() + DEFAULT_KEEP_ALIVE_TIMEOUT;
+    netconn->keep_until = GetTickCount64() + keep_alive_timeout;
     list_add_head( &netconn->host->connections, &netconn->entry );
+    if (list_count( &netconn->host->connections ) > max_idle_connections)
+    {
+        oldest = LIST_ENTRY( list_tail( &netconn->host->connections ), struct netconn, entry );
+        list_remove( &oldest->entry );
+    }
 
     if (!connection_collector_running)
     {
@@ -1394,6 +1439,12 @@ static void cache_connection( struct netconn *netconn )
     }
 
     LeaveCriticalSection( &connection_pool_cs );
+
+    if (oldest)
+    {
+        TRACE( "too many idle connections, closing %p\n", oldest );
+        netconn_close( oldest );
+    }
 }
 
 static DWORD map_secure_protocols( DWORD mask )
@@ -1407,23 +1458,95 @@ static DWORD map_secure_protocols( DWORD mask )
     return ret;
 }
 
+/* Credentials without a client certificate only depend on the enabled protocols. They are shared
+ * process-wide and kept until unload, since pooled connections outlive the requests that made them. */
+struct cred_cache_entry
+{
+    struct list entry;
+    DWORD protocols;
+    CredHandle handle;
+};
+
+static struct list cred_cache = LIST_INIT( cred_cache );
+
+static CRITICAL_SECTION cred_cache_cs;
+static CRITICAL_SECTION_DEBUG cred_cache_debug =
+{
+    0, 0, &cred_cache_cs,
+    { &cred_cache_debug.ProcessLocksList, &cred_cache_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": cred_cache_cs") }
+};
+static CRITICAL_SECTION cred_cache_cs = { &cred_cache_debug, -1, 0, 0, 0, 0 };
+
+static SECURITY_STATUS get_shared_cred_handle( DWORD protocols, CredHandle *handle )
+{
+    struct cred_cache_entry *cred;
+    SECURITY_STATUS status = SEC_E_OK;
+    SCHANNEL_CRED schannel_cred;
+
+    EnterCriticalSection( &cred_cache_cs );
+
+    LIST_FOR_EACH_ENTRY( cred, &cred_cache, struct cred_cache_entry, entry )
+    {
+        if (cred->protocols != protocols) continue;
+        *handle = cred->handle;
+        LeaveCriticalSection( &cred_cache_cs );
+        return SEC_E_OK;
+    }
+
+    if (!(cred = heap_alloc( sizeof(*cred) ))) status = SEC_E_INSUFFICIENT_MEMORY;
+    else
+    {
+        memset( &schannel_cred, 0, sizeof(schannel_cred) );
+        schannel_cred.dwVersion             = SCHANNEL_CRED_VERSION;
+        schannel_cred.grbitEnabledProtocols = protocols;
+        status = AcquireCredentialsHandleW( NULL, (WCHAR *)UNISP_NAME_W, SECPKG_CRED_OUTBOUND, NULL,
+                                            &schannel_cred, NULL, NULL, &cred->handle, NULL );
+        if (status == SEC_E_OK)
+        {
+            cred->protocols = protocols;
+            list_add_tail( &cred_cache, &cred->entry );
+            *handle = cred->handle;
+        }
+        else heap_free( cred );
+    }
+
+    LeaveCriticalSection( &cred_cache_cs );
+    return status;
+}
+
+void release_cred_cache( void )
+{
+    struct cred_cache_entry *cred, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( cred, next, &cred_cache, struct cred_cache_entry, entry )
+    {
+        list_remove( &cred->entry );
+        FreeCredentialsHandle( &cred->handle );
+        heap_free( cred );
+    }
+}
+
 static DWORD ensure_cred_handle( struct request *request )
 {
     SECURITY_STATUS status = SEC_E_OK;
 
     if (request->cred_handle_initialized) return ERROR_SUCCESS;
 
-    if (!request->cred_handle_initialized)
+    if (!request->client_cert)
+    {
+        /* not owned by the request, so cred_handle_initialized stays FALSE */
+        status = get_shared_cred_handle( map_secure_protocols( request->connect->session->secure_protocols ),
+                                         &request->cred_handle );
+    }
+    else
     {
         SCHANNEL_CRED cred;
         memset( &cred, 0, sizeof(cred) );
         cred.dwVersion             = SCHANNEL_CRED_VERSION;
         cred.grbitEnabledProtocols = map_secure_protocols( request->connect->session->secure_protocols );
-        if (request->client_cert)
-        {
-            cred.paCred = &request->client_cert;
-            cred.cCreds = 1;
-        }
+        cred.paCred                = &request->client_cert;
+        cred.cCreds                = 1;
         status = AcquireCredentialsHandleW( NULL, (WCHAR *)UNISP_NAME_W, SECPKG_CRED_OUTBOUND, NULL,
                                             &cred, NULL, NULL, &request->cred_handle, NULL );
         if (status == SEC_E_OK)
@@ -1472,6 +1595,7 @@ static DWORD open_connection( struct request *request )
             host->ref = 1;
             host->secure = is_secure;
             host->port = port;
+            host->resolved_until = 0;
             list_init( &host->connections );
             if ((host->hostname = strdupW( connect->servername )))
             {
@@ -1512,6 +1636,19 @@ static DWORD open_connection( struct request *request )
         connect->resolved = TRUE;
     }
 
+    if (!connect->resolved)
+    {
+        /* another connect handle may have resolved this host recently */
+        EnterCriticalSection( &connection_pool_cs );
+        if (host->resolved_until > GetTickCount64())
+        {
+            TRACE( "using cached address for %s\n", debugstr_w(host->hostname) );
+            connect->sockaddr = host->sockaddr;
+            connect->resolved = TRUE;
+        }
+        LeaveCriticalSection( &connection_pool_cs );
+    }
+
     if (!connect->resolved)
     {
         len = lstrlenW( host->hostname ) + 1;
@@ -1524,6 +1661,11 @@ static DWORD open_connection( struct request *request )
         }
         connect->resolved = TRUE;
 
+        EnterCriticalSection( &connection_pool_cs );
+        host->sockaddr = connect->sockaddr;
+        host->resolved_until = GetTickCount64() + HOST_ADDRESS_TIMEOUT;
+        LeaveCriticalSection( &connection_pool_cs );
+
         if (!(addressW = addr_to_str( &connect->sockaddr )))
         {
             release_host( host );
@@ -62,6 +62,8 @@ struct hostdata
     INTERNET_PORT port;
     BOOL secure;
     struct list connections;
+    struct sockaddr_storage sockaddr;   /* last resolved address */
+    ULONGLONG resolved_until;
 };
 
 struct session
@@ -343,6 +345,7 @@ BOOL set_server_for_hostname( struct connect *, const WCHAR *, INTERNET_PORT ) D
 void destroy_authinfo( struct authinfo * ) DECLSPEC_HIDDEN;
 
 void release_host( struct hostdata * ) DECLSPEC_HIDDEN;
+void release_cred_cache( void ) DECLSPEC_HIDDEN;
 DWORD process_header( struct request *, const WCHAR *, const WCHAR *, DWORD, BOOL ) DECLSPEC_HIDDEN;
 
 extern HRESULT WinHttpRequest_create( void ** ) DECLSPEC_HIDDEN;
@@ -1766,9 +1766,11 @@ static BOOL HTTP_DealWithProxy(appinfo_t *hIC, http_session_t *session, http_req
 static DWORD HTTP_ResolveName(http_request_t *request)
 {
     server_t *server = request->proxy ? request->proxy : request->server;
-    int addr_len;
+    struct sockaddr_storage addrs[MAX_SERVER_ADDRS];
+    int lens[MAX_SERVER_ADDRS];
+    unsigned int count;
 
-    if(server->addr_len)
+    if(server_addresses_valid(server))
         return ERROR_SUCCESS;
 
     INTERNET_SendCallback(&request->hdr, request->hdr.dwContext,
@@ -1776,11 +1778,11 @@ static DWORD HTTP_ResolveName(http_request_t *request)
                           server->name,
                           (lstrlenW(server->name)+1) * sizeof(WCHAR));
 
-    addr_len = sizeof(server->addr);
-    if (!GetAddress(server->name, server->port, (SOCKADDR*)&server->addr, &addr_len, server->addr_str))
+    count = GetAddressList(server->name, server->port, addrs, lens, ARRAY_SIZE(addrs));
+    if (!count)
         return ERROR_INTERNET_NAME_NOT_RESOLVED;
 
-    server->addr_len = addr_len;
+    set_server_addresses(server, addrs, lens, count);
     INTERNET_SendCallback(&request->hdr, request->hdr.dwContext,
                           INTERNET_STATUS_NAME_RESOLVED,
                           server->addr_str, strlen(server->addr_str)+1);
@@ -32,6 +32,8 @@
 
 extern HMODULE WININET_hModule DECLSPEC_HIDDEN;
 
+#define MAX_SERVER_ADDRS 4
+
 typedef struct {
     WCHAR *name;
     INTERNET_PORT port;
@@ -39,6 +41,11 @@ typedef struct {
     struct sockaddr_storage addr;
     int addr_len;
     char addr_str[INET6_ADDRSTRLEN];
+    /* further resolved addresses, raced against addr when connecting */
+    struct sockaddr_storage alt_addr[MAX_SERVER_ADDRS-1];
+    int alt_addr_len[MAX_SERVER_ADDRS-1];
+    unsigned int alt_addr_count;
+    ULONGLONG addr_expiry;
 
     WCHAR *scheme_host_port;
     const WCHAR *host_port;
@@ -413,6 +420,7 @@ DWORD HTTP_Connect(appinfo_t*,LPCWSTR,
         DWORD dwInternalFlags, HINTERNET*) DECLSPEC_HIDDEN;
 
 BOOL GetAddress(const WCHAR*,INTERNET_PORT,SOCKADDR*,int*,char*) DECLSPEC_HIDDEN;
+unsigned int GetAddressList(const WCHAR*,INTERNET_PORT,struct sockaddr_storage*,int*,unsigned int) DECLSPEC_HIDDEN;
 
 DWORD get_cookie_header(const WCHAR*,const WCHAR*,WCHAR**) DECLSPEC_HIDDEN;
 DWORD set_cookie(substr_t,substr_t,substr_t,substr_t,DWORD) DECLSPEC_HIDDEN;
@@ -428,6 +436,8 @@ VOID INTERNET_SendCallback(object_header_t *hdr, DWORD_PTR dwContext,
 WCHAR *INTERNET_FindProxyForProtocol(LPCWSTR szProxy, LPCWSTR proto) DECLSPEC_HIDDEN;
 
 DWORD create_netconn(server_t*,DWORD,BOOL,DWORD,netconn_t**) DECLSPEC_HIDDEN;
+BOOL server_addresses_valid(server_t*) DECLSPEC_HIDDEN;
+void set_server_addresses(server_t*,const struct sockaddr_storage*,const int*,unsigned int) DECLSPEC_HIDDEN;
 void free_netconn(netconn_t*) DECLSPEC_HIDDEN;
 void NETCON_unload(void) DECLSPEC_HIDDEN;
 DWORD NETCON_secure_connect(netconn_t*,server_t*) DECLSPEC_HIDDEN;
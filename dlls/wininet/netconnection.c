@@ -288,48 +288,226 @@ static void set_socket_blocking(netconn_t *conn, BOOL is_blocking)
     conn->is_blocking = is_blocking;
 }
 
+/* getaddrinfo does not report record TTLs, so resolved addresses are reused for a fixed time */
+#define ADDRESS_CACHE_TIME 300000
+
+/* delay before racing the next address while earlier attempts are still pending (RFC 8305) */
+#define CONNECTION_ATTEMPT_DELAY 250
+
+static CRITICAL_SECTION server_addr_cs;
+static CRITICAL_SECTION_DEBUG server_addr_cs_debug = {
+    0, 0, &server_addr_cs,
+    { &server_addr_cs_debug.ProcessLocksList,
+      &server_addr_cs_debug.ProcessLocksList },
+    0, 0, { (DWORD_PTR)(__FILE__ ": server_addr_cs") }
+};
+static CRITICAL_SECTION server_addr_cs = { &server_addr_cs_debug, -1, 0, 0, 0, 0 };
+
+static void update_addr_str(server_t *server)
+{
+    void *addr = NULL;
+
+    switch(server->addr.ss_family) {
+    case AF_INET:
+        addr = &((struct sockaddr_in *)&server->addr)->sin_addr;
+        break;
+    case AF_INET6:
+        addr = &((struct sockaddr_in6 *)&server->addr)->sin6_addr;
+        break;
+    }
+    if(addr)
+        inet_ntop(server->addr.ss_family, addr, server->addr_str, sizeof(server->addr_str));
+}
+
+BOOL server_addresses_valid(server_t *server)
+{
+    BOOL ret;
+
+    EnterCriticalSection(&server_addr_cs);
+    ret = server->addr_len && GetTickCount64() < server->addr_expiry;
+    LeaveCriticalSection(&server_addr_cs);
+    return ret;
+}
+
+void set_server_addresses(server_t *server, const struct sockaddr_storage *addrs, const int *lens, unsigned int count)
+{
+    unsigned int i;
+
+    assert(count && count <= MAX_SERVER_ADDRS);
+
+    EnterCriticalSection(&server_addr_cs);
+    server->addr = addrs[0];
+    server->addr_len = lens[0];
+    for(i = 1; i < count; i++) {
+        server->alt_addr[i-1] = addrs[i];
+        server->alt_addr_len[i-1] = lens[i];
+    }
+    server->alt_addr_count = count - 1;
+    server->addr_expiry = GetTickCount64() + ADDRESS_CACHE_TIME;
+    update_addr_str(server);
+    LeaveCriticalSection(&server_addr_cs);
+}
+
+/* Makes the address that won a connection race the first one tried next time. */
+static void promote_server_address(server_t *server, const struct sockaddr_storage *addr, int addr_len)
+{
+    struct sockaddr_storage tmp;
+    unsigned int i;
+
+    EnterCriticalSection(&server_addr_cs);
+    for(i = 0; i < server->alt_addr_count; i++) {
+        if(server->alt_addr_len[i] != addr_len || memcmp(&server->alt_addr[i], addr, addr_len))
+            continue;
+
+        tmp = server->addr;
+        server->addr = server->alt_addr[i];
+        server->alt_addr[i] = tmp;
+        server->alt_addr_len[i] = server->addr_len;
+        server->addr_len = addr_len;
+        update_addr_str(server);
+        break;
+    }
+    LeaveCriticalSection(&server_addr_cs);
+}
+
+static int start_connect(const struct sockaddr_storage *addr, int addr_len, BOOL *connected)
+{
+    ULONG arg = 1;
+    DWORD res;
+    int s;
+
+    *connected = FALSE;
+
+    s = socket(addr->ss_family, SOCK_STREAM, 0);
+    if(s == -1)
+        return -1;
+
+    ioctlsocket(s, FIONBIO, &arg);
+    if(!connect(s, (const struct sockaddr*)addr, addr_len)) {
+        *connected = TRUE;
+        return s;
+    }
+
+    res = WSAGetLastError();
+    if(res == WSAEINPROGRESS || res == WSAEWOULDBLOCK)
+        return s;
+
+    closesocket(s);
+    return -1;
+}
+
+/*
+ * Connects to the first reachable server address. Attempts are started
+ * CONNECTION_ATTEMPT_DELAY ms apart, or immediately once all earlier ones
+ * have failed, and the first one to complete wins.
+ */
 static DWORD create_netconn_socket(server_t *server, netconn_t *netconn, DWORD timeout)
 {
-    int result;
+    struct sockaddr_storage addrs[MAX_SERVER_ADDRS];
+    int lens[MAX_SERVER_ADDRS], socks[MAX_SERVER_ADDRS];
+    unsigned int i, count, started = 0, pending = 0;
+    ULONGLONG now, deadline, next_attempt;
+    int winner = -1, result;
+    BOOL connected;
     ULONG flag;
-    DWORD res;
 
     init_winsock();
 
+    EnterCriticalSection(&server_addr_cs);
     assert(server->addr_len);
-    result = netconn->socket = socket(server->addr.ss_family, SOCK_STREAM, 0);
-    if(result != -1) {
-        set_socket_blocking(netconn, FALSE);
-        result = connect(netconn->socket, (struct sockaddr*)&server->addr, server->addr_len);
-        if(result == -1)
-        {
-            res = WSAGetLastError();
-            if (res == WSAEINPROGRESS || res == WSAEWOULDBLOCK) {
-                FD_SET set;
-                int res;
-                socklen_t len = sizeof(res);
-                TIMEVAL timeout_timeval = {0, timeout*1000};
-
-                FD_ZERO(&set);
-                FD_SET(netconn->socket, &set);
-                res = select(netconn->socket+1, NULL, &set, NULL, &timeout_timeval);
-                if(!res || res == SOCKET_ERROR) {
-                    closesocket(netconn->socket);
-                    netconn->socket = -1;
-                    return ERROR_INTERNET_CANNOT_CONNECT;
+    addrs[0] = server->addr;
+    lens[0] = server->addr_len;
+    for(i = 0; i < server->alt_addr_count; i++) {
+        addrs[i+1] = server->alt_addr[i];
+        lens[i+1] = server->alt_addr_len[i];
+    }
+    count = server->alt_addr_count + 1;
+    LeaveCriticalSection(&server_addr_cs);
+
+    now = next_attempt = GetTickCount64();
+    deadline = now + timeout;
+
+    for(;;) {
+        FD_SET wset, eset;
+        TIMEVAL timeout_timeval;
+        ULONGLONG wait;
+
+        if(started < count && now >= next_attempt) {
+            socks[started] = start_connect(&addrs[started], lens[started], &connected);
+            if(socks[started] != -1) {
+                if(connected) {
+                    winner = started++;
+                    break;
                 }
-                if (!getsockopt(netconn->socket, SOL_SOCKET, SO_ERROR, (void *)&res, &len) && !res)
-                    result = 0;
+                pending++;
+                next_attempt = now + CONNECTION_ATTEMPT_DELAY;
             }
+            started++;
+            continue;
+        }
+
+        if((!pending && started == count) || now >= deadline)
+            break;
+
+        wait = deadline - now;
+        if(started < count && next_attempt - now < wait)
+            wait = next_attempt - now;
+        timeout_timeval.tv_sec = wait / 1000;
+        timeout_timeval.tv_usec = (wait % 1000) * 1000;
+
+        FD_ZERO(&wset);
+        FD_ZERO(&eset);
+        for(i = 0; i < started; i++) {
+            if(socks[i] == -1)
+                continue;
+            FD_SET(socks[i], &wset);
+            FD_SET(socks[i], &eset);
         }
-        if(result == -1)
-        {
-            closesocket(netconn->socket);
-            netconn->socket = -1;
+
+        if(select(0, NULL, &wset, &eset, &timeout_timeval) == SOCKET_ERROR)
+            break;
+
+        for(i = 0; i < started; i++) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+
+            if(socks[i] == -1 || (!FD_ISSET(socks[i], &wset) && !FD_ISSET(socks[i], &eset)))
+                continue;
+
+            if(FD_ISSET(socks[i], &wset) && !getsockopt(socks[i], SOL_SOCKET, SO_ERROR, (void*)&err, &len) && !err) {
+                winner = i;
+                break;
+            }
+
+            TRACE("connection attempt %u failed: %d\n", i, err);
+            closesocket(socks[i]);
+            socks[i] = -1;
+            pending--;
+            /* don't wait for the stagger delay once nothing is in flight */
+            if(!pending)
+                next_attempt = 0;
         }
+        if(winner != -1)
+            break;
+
+        now = GetTickCount64();
+    }
+
+    for(i = 0; i < started; i++) {
+        if(i != winner && socks[i] != -1)
+            closesocket(socks[i]);
     }
-    if(result == -1)
+
+    if(winner == -1) {
+        netconn->socket = -1;
         return ERROR_INTERNET_CANNOT_CONNECT;
+    }
+
+    TRACE("connected using address %d of %u\n", winner, count);
+    netconn->socket = socks[winner];
+    netconn->is_blocking = FALSE;
+    if(winner)
+        promote_server_address(server, &addrs[winner], lens[winner]);
 
     flag = 1;
     result = setsockopt(netconn->socket, IPPROTO_TCP, TCP_NODELAY, (void*)&flag, sizeof(flag));
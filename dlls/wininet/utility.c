@@ -178,6 +178,73 @@ BOOL GetAddress(const WCHAR *name, INTERNET_PORT port, struct sockaddr *psa, int
     return TRUE;
 }
 
+static void set_address_port(struct sockaddr_storage *addr, INTERNET_PORT port)
+{
+    switch (addr->ss_family)
+    {
+    case AF_INET:
+        ((struct sockaddr_in *)addr)->sin_port = htons(port);
+        break;
+    case AF_INET6:
+        ((struct sockaddr_in6 *)addr)->sin6_port = htons(port);
+        break;
+    }
+}
+
+/*
+ * Resolves all addresses of name, up to max. The result alternates between
+ * address families, starting with IPv4, so that a connection attempt racing
+ * the first few entries covers both families.
+ */
+unsigned int GetAddressList(const WCHAR *name, INTERNET_PORT port, struct sockaddr_storage *addrs,
+        int *lens, unsigned int max)
+{
+    ADDRINFOW *res, *ai, *next[2], hints;
+    unsigned int count = 0, family = 0;
+    int ret;
+
+    TRACE("%s\n", debugstr_w(name));
+
+    memset( &hints, 0, sizeof(hints) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    ret = GetAddrInfoW(name, NULL, &hints, &res);
+    if (ret != 0)
+    {
+        TRACE("failed to get address of %s\n", debugstr_w(name));
+        return 0;
+    }
+
+    next[0] = next[1] = res;
+    while (count < max)
+    {
+        int wanted = family ? AF_INET6 : AF_INET;
+
+        for (ai = next[family]; ai; ai = ai->ai_next)
+            if (ai->ai_family == wanted && ai->ai_addrlen <= sizeof(*addrs)) break;
+
+        if (ai)
+        {
+            memcpy(&addrs[count], ai->ai_addr, ai->ai_addrlen);
+            lens[count] = ai->ai_addrlen;
+            set_address_port(&addrs[count], port);
+            count++;
+            next[family] = ai->ai_next;
+        }
+        else
+        {
+            next[family] = NULL;
+            if (!next[!family]) break;
+        }
+        family = !family;
+    }
+
+    FreeAddrInfoW(res);
+    TRACE("%s resolved to %u addresses\n", debugstr_w(name), count);
+    return count;
+}
+
 /*
  * Helper function for sending async Callbacks
  */
@@ -26,6 +26,7 @@
 
 #include "windef.h"
 #include "winbase.h"
+#include "winternl.h"
 #include "mmsystem.h"
 
 #include "winemm.h"
@@ -56,6 +57,9 @@ static CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static CRITICAL_SECTION TIME_cbcrst = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+/* outstanding timeBeginPeriod() calls for the periods that affect the timer resolution */
+static    LONG                  TIME_periods[16];
+
 static    HANDLE                TIME_hMMTimer;
 static    CONDITION_VARIABLE    TIME_cv;
 
@@ -366,6 +370,26 @@ MMRESULT WINAPI timeGetDevCaps(LPTIMECAPS lpCaps, UINT wSize)
     return TIMERR_NOERROR;
 }
 
+/**************************************************************************
+ *				TIME_UpdateResolution
+ *
+ * Requests the finest period that has outstanding timeBeginPeriod() calls.
+ * Must be called with WINMM_cs held.
+ */
+static void TIME_UpdateResolution(void)
+{
+    ULONG current;
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(TIME_periods); i++)
+    {
+        if (!TIME_periods[i]) continue;
+        NtSetTimerResolution((i + 1) * 10000, TRUE, &current);
+        return;
+    }
+    NtSetTimerResolution(0, FALSE, &current);
+}
+
 /**************************************************************************
  * 				timeBeginPeriod		[WINMM.@]
  */
@@ -374,9 +398,12 @@ MMRESULT WINAPI timeBeginPeriod(UINT wPeriod)
     if (wPeriod < MMSYSTIME_MININTERVAL || wPeriod > MMSYSTIME_MAXINTERVAL)
 	return TIMERR_NOCANDO;
 
-    if (wPeriod > MMSYSTIME_MININTERVAL)
+    /* coarser periods don't change the resolution */
+    if (wPeriod <= ARRAY_SIZE(TIME_periods))
     {
-        WARN("Stub; we set our timer resolution at minimum\n");
+        EnterCriticalSection(&WINMM_cs);
+        if (!TIME_periods[wPeriod - 1]++) TIME_UpdateResolution();
+        LeaveCriticalSection(&WINMM_cs);
     }
 
     return 0;
@@ -390,9 +417,11 @@ MMRESULT WINAPI timeEndPeriod(UINT wPeriod)
     if (wPeriod < MMSYSTIME_MININTERVAL || wPeriod > MMSYSTIME_MAXINTERVAL)
 	return TIMERR_NOCANDO;
 
-    if (wPeriod > MMSYSTIME_MININTERVAL)
+    if (wPeriod <= ARRAY_SIZE(TIME_periods))
     {
-        WARN("Stub; we set our timer resolution at minimum\n");
+        EnterCriticalSection(&WINMM_cs);
+        if (TIME_periods[wPeriod - 1] && !--TIME_periods[wPeriod - 1]) TIME_UpdateResolution();
+        LeaveCriticalSection(&WINMM_cs);
     }
     return 0;
 }
@@ -64,6 +64,9 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
@@ -161,6 +164,7 @@
 #include "wine/exception.h"
 #include "wine/unicode.h"
 #include "wine/heap.h"
+#include "wine/list.h"
 
 #if defined(linux) && !defined(IP_UNICAST_IF)
 #define IP_UNICAST_IF 50
@@ -670,16 +674,15 @@ struct ws2_accept_async
 
 struct ws2_transmitfile_async
 {
-    struct ws2_async_io   io;
-    char                  *buffer;
-    HANDLE                file;
-    DWORD                 file_read;
-    DWORD                 file_bytes;
-    DWORD                 bytes_per_send;
-    TRANSMIT_FILE_BUFFERS buffers;
-    DWORD                 flags;
-    LARGE_INTEGER         offset;
-    struct ws2_async      write;
+    struct ws2_async_io       io;
+    char                     *buffer;
+    TRANSMIT_PACKETS_ELEMENT *elements;        /* elements left to send */
+    DWORD                     element_count;
+    DWORD                     file_read;       /* bytes sent from the current file element */
+    DWORD                     bytes_per_send;
+    DWORD                     flags;
+    BOOL                      no_sendfile;
+    struct ws2_async          write;
 };
 
 static struct ws2_async_io *async_io_freelist;
@@ -1315,6 +1318,28 @@ static void _enable_event( HANDLE s, unsigned int event,
     SERVER_END_REQ;
 }
 
+/* re-enable an event and post the completion of a successful I/O in a single server call */
+static void _enable_event_completion( SOCKET s, unsigned int event, ULONG_PTR cvalue, ULONG information )
+{
+    NTSTATUS status;
+
+    SERVER_START_REQ( enable_socket_event )
+    {
+        req->handle      = wine_server_obj_handle( SOCKET2HANDLE(s) );
+        req->mask        = event;
+        req->sstate      = 0;
+        req->cstate      = 0;
+        req->cvalue      = cvalue;
+        req->information = information;
+        status = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+
+    /* the handle may not allow changing the socket state, post the completion anyway */
+    if (status == STATUS_ACCESS_DENIED && cvalue)
+        WS_AddCompletion( s, cvalue, STATUS_SUCCESS, information, FALSE );
+}
+
 static DWORD sock_is_blocking(SOCKET s, BOOL *ret)
 {
     DWORD err;
@@ -1523,6 +1548,7 @@ BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID fImpLoad)
     case DLL_PROCESS_DETACH:
         if (fImpLoad) break;
         free_per_thread_data();
+        free_addrinfo_cache();
         DeleteCriticalSection(&csWSgetXXXbyYYY);
         break;
     case DLL_THREAD_DETACH:
@@ -2815,6 +2841,13 @@ static NTSTATUS WS2_ReadFile(HANDLE hFile, PIO_STATUS_BLOCK io_status, char* buf
     return status;
 }
 
+static void WS2_transmitfile_next_element( struct ws2_transmitfile_async *wsa )
+{
+    wsa->elements++;
+    wsa->element_count--;
+    wsa->file_read = 0;
+}
+
 /***********************************************************************
  *     WS2_transmitfile_getbuffer       (INTERNAL)
  *
@@ -2826,37 +2859,43 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
     if (wsa->write.first_iovec < wsa->write.n_iovecs)
         return STATUS_PENDING;
 
-    /* process the header (if applicable) */
-    if (wsa->buffers.Head)
-    {
-        wsa->write.first_iovec       = 0;
-        wsa->write.n_iovecs          = 1;
-        wsa->write.iovec[0].iov_base = wsa->buffers.Head;
-        wsa->write.iovec[0].iov_len  = wsa->buffers.HeadLength;
-        wsa->buffers.Head            = NULL;
-        return STATUS_PENDING;
-    }
-
-    /* process the main file */
-    if (wsa->file)
+    while (wsa->element_count)
     {
-        DWORD bytes_per_send = wsa->bytes_per_send;
-        IO_STATUS_BLOCK iosb;
-        NTSTATUS status;
+        TRANSMIT_PACKETS_ELEMENT *element = wsa->elements;
 
-        iosb.Information = 0;
-        /* when the size of the transfer is limited ensure that we don't go past that limit */
-        if (wsa->file_bytes != 0)
-            bytes_per_send = min(bytes_per_send, wsa->file_bytes - wsa->file_read);
-        status = WS2_ReadFile( wsa->file, &iosb, wsa->buffer, bytes_per_send, &wsa->offset );
-        if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
-            wsa->offset.QuadPart += iosb.Information;
-        if (status == STATUS_END_OF_FILE)
-            wsa->file = NULL; /* continue on to the footer */
-        else if (status != STATUS_SUCCESS)
-            return status;
+        /* process a memory buffer (header and footer for TransmitFile) */
+        if (element->dwElFlags & TP_ELEMENT_MEMORY)
+        {
+            WS2_transmitfile_next_element( wsa );
+            if (!element->cLength) continue;
+            wsa->write.first_iovec       = 0;
+            wsa->write.n_iovecs          = 1;
+            wsa->write.iovec[0].iov_base = element->u.pBuffer;
+            wsa->write.iovec[0].iov_len  = element->cLength;
+            return STATUS_PENDING;
+        }
         else
         {
+            DWORD bytes_per_send = wsa->bytes_per_send;
+            IO_STATUS_BLOCK iosb;
+            NTSTATUS status;
+
+            iosb.Information = 0;
+            /* when the size of the transfer is limited ensure that we don't go past that limit */
+            if (element->cLength != 0)
+                bytes_per_send = min(bytes_per_send, element->cLength - wsa->file_read);
+            status = WS2_ReadFile( element->u.s.hFile, &iosb, wsa->buffer, bytes_per_send,
+                                   &element->u.s.nFileOffset );
+            if (element->u.s.nFileOffset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+                element->u.s.nFileOffset.QuadPart += iosb.Information;
+            if (status == STATUS_END_OF_FILE)
+            {
+                WS2_transmitfile_next_element( wsa );  /* continue on to the next element */
+                continue;
+            }
+            else if (status != STATUS_SUCCESS)
+                return status;
+
             if (iosb.Information)
             {
                 wsa->write.first_iovec       = 0;
@@ -2866,26 +2905,79 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
                 wsa->file_read += iosb.Information;
             }
 
-            if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
-                wsa->file = NULL;
+            if (element->cLength != 0 && wsa->file_read >= element->cLength)
+                WS2_transmitfile_next_element( wsa );
 
             return STATUS_PENDING;
         }
     }
 
-    /* send the footer (if applicable) */
-    if (wsa->buffers.Tail)
+    return STATUS_SUCCESS;
+}
+
+#ifdef HAVE_SYS_SENDFILE_H
+/***********************************************************************
+ *     WS2_transmitfile_sendfile        (INTERNAL)
+ *
+ * Send file elements without copying them through a user buffer. Returns
+ * STATUS_NOT_SUPPORTED when the current element has to go through the regular path.
+ */
+static NTSTATUS WS2_transmitfile_sendfile( int fd, struct ws2_transmitfile_async *wsa )
+{
+    IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
+
+    /* finish sending any buffered data first */
+    if (wsa->no_sendfile || wsa->write.first_iovec < wsa->write.n_iovecs)
+        return STATUS_NOT_SUPPORTED;
+
+    while (wsa->element_count && (wsa->elements->dwElFlags & TP_ELEMENT_FILE))
     {
-        wsa->write.first_iovec       = 0;
-        wsa->write.n_iovecs          = 1;
-        wsa->write.iovec[0].iov_base = wsa->buffers.Tail;
-        wsa->write.iovec[0].iov_len  = wsa->buffers.TailLength;
-        wsa->buffers.Tail            = NULL;
-        return STATUS_PENDING;
-    }
+        TRANSMIT_PACKETS_ELEMENT *element = wsa->elements;
+        size_t count = 0x7ffff000;  /* maximum transfer size of sendfile on Linux */
+        int file_fd, err;
+        ssize_t ret;
 
-    return STATUS_SUCCESS;
+        if (wine_server_handle_to_fd( element->u.s.hFile, FILE_READ_DATA, &file_fd, NULL ))
+            return STATUS_NOT_SUPPORTED;  /* let the regular path report the error */
+
+        if (element->cLength != 0) count = element->cLength - wsa->file_read;
+        if (element->u.s.nFileOffset.QuadPart == FILE_USE_FILE_POINTER_POSITION)
+            ret = sendfile( fd, file_fd, NULL, count );
+        else
+        {
+            off_t offset = element->u.s.nFileOffset.QuadPart;
+            ret = sendfile( fd, file_fd, &offset, count );
+            if (ret > 0) element->u.s.nFileOffset.QuadPart = offset;
+        }
+        err = errno;
+        wine_server_release_fd( element->u.s.hFile, file_fd );
+
+        if (ret > 0)
+        {
+            if (iosb) iosb->Information += ret;
+            wsa->file_read += ret;
+            if (element->cLength != 0 && wsa->file_read >= element->cLength)
+                WS2_transmitfile_next_element( wsa );
+            return STATUS_PENDING;
+        }
+        if (!ret)  /* end of file */
+        {
+            WS2_transmitfile_next_element( wsa );
+            continue;
+        }
+        if (err == EAGAIN || err == EINTR) return STATUS_PENDING;
+        if (err == EINVAL || err == ENOSYS || err == EOVERFLOW)
+        {
+            /* not a file that sendfile supports, fall back to reading it */
+            wsa->no_sendfile = TRUE;
+            return STATUS_NOT_SUPPORTED;
+        }
+        errno = err;
+        return wsaErrStatus();
+    }
+    return STATUS_NOT_SUPPORTED;
 }
+#endif
 
 /***********************************************************************
  *     WS2_transmitfile_base            (INTERNAL)
@@ -2896,6 +2988,11 @@ static NTSTATUS WS2_transmitfile_base( int fd, struct ws2_transmitfile_async *ws
 {
     NTSTATUS status;
 
+#ifdef HAVE_SYS_SENDFILE_H
+    if ((status = WS2_transmitfile_sendfile( fd, wsa )) != STATUS_NOT_SUPPORTED)
+        return status;
+#endif
+
     status = WS2_transmitfile_getbuffer( fd, wsa );
     if (status == STATUS_PENDING)
     {
@@ -2941,63 +3038,43 @@ static NTSTATUS WS2_async_transmitfile( void *user, IO_STATUS_BLOCK *iosb, NTSTA
 }
 
 /***********************************************************************
- *     TransmitFile
+ *     WS2_transmit                     (INTERNAL)
+ *
+ * Shared implementation of TransmitFile and TransmitPackets.
  */
-static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
-                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
-                                     DWORD flags )
+static BOOL WS2_transmit( SOCKET s, int fd, const TRANSMIT_PACKETS_ELEMENT *elements, DWORD count,
+                          DWORD bytes_per_send, LPOVERLAPPED overlapped, DWORD flags )
 {
-    union generic_unix_sockaddr uaddr;
-    socklen_t uaddrlen = sizeof(uaddr);
     struct ws2_transmitfile_async *wsa;
     NTSTATUS status;
-    int fd;
-
-    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
-            buffers, flags );
-
-    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
-    if (fd == -1) return FALSE;
-
-    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
-    {
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAENOTCONN );
-        return FALSE;
-    }
-    if (flags)
-        FIXME("Flags are not currently supported (0x%x).\n", flags);
-
-    if (h && GetFileType( h ) != FILE_TYPE_DISK)
-    {
-        FIXME("Non-disk file handles are not currently supported.\n");
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAEOPNOTSUPP );
-        return FALSE;
-    }
+    DWORD i;
 
     /* set reasonable defaults when requested */
     if (!bytes_per_send)
         bytes_per_send = (1 << 16); /* Depends on OS version: PAGE_SIZE, 2*PAGE_SIZE, or 2^16 */
 
-    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + bytes_per_send,
+    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + count * sizeof(*elements)
+                                                                 + bytes_per_send,
                                                                  WS2_async_transmitfile )))
     {
         release_sock_fd( s, fd );
         WSASetLastError( WSAEFAULT );
         return FALSE;
     }
-    if (buffers)
-        wsa->buffers = *buffers;
-    else
-        memset(&wsa->buffers, 0x0, sizeof(wsa->buffers));
-    wsa->buffer                = (char *)(wsa + 1);
-    wsa->file                  = h;
+    wsa->elements              = (TRANSMIT_PACKETS_ELEMENT *)(wsa + 1);
+    for (i = 0; i < count; i++)
+    {
+        wsa->elements[i] = elements[i];
+        /* an offset of -1 means the current file position */
+        if ((elements[i].dwElFlags & TP_ELEMENT_FILE) && elements[i].u.s.nFileOffset.QuadPart == -1)
+            wsa->elements[i].u.s.nFileOffset.QuadPart = FILE_USE_FILE_POINTER_POSITION;
+    }
+    wsa->element_count         = count;
+    wsa->buffer                = (char *)(wsa->elements + count);
     wsa->file_read             = 0;
-    wsa->file_bytes            = file_bytes;
     wsa->bytes_per_send        = bytes_per_send;
     wsa->flags                 = flags;
-    wsa->offset.QuadPart       = FILE_USE_FILE_POINTER_POSITION;
+    wsa->no_sendfile           = FALSE;
     wsa->write.hSocket         = SOCKET2HANDLE(s);
     wsa->write.addr            = NULL;
     wsa->write.addrlen.val     = 0;
@@ -3012,8 +3089,6 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
         IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)overlapped;
         int status;
 
-        wsa->offset.u.LowPart  = overlapped->u.s.Offset;
-        wsa->offset.u.HighPart = overlapped->u.s.OffsetHigh;
         iosb->u.Status = STATUS_PENDING;
         iosb->Information = 0;
         status = register_async( ASYNC_TYPE_WRITE, SOCKET2HANDLE(s), &wsa->io,
@@ -3043,6 +3118,117 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
     return (status == STATUS_SUCCESS);
 }
 
+/***********************************************************************
+ *     TransmitFile
+ */
+static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
+                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
+                                     DWORD flags )
+{
+    union generic_unix_sockaddr uaddr;
+    socklen_t uaddrlen = sizeof(uaddr);
+    TRANSMIT_PACKETS_ELEMENT elements[3];
+    DWORD count = 0;
+    int fd;
+
+    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
+            buffers, flags );
+
+    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
+    if (fd == -1) return FALSE;
+
+    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAENOTCONN );
+        return FALSE;
+    }
+    if (flags)
+        FIXME("Flags are not currently supported (0x%x).\n", flags);
+
+    if (h && GetFileType( h ) != FILE_TYPE_DISK)
+    {
+        FIXME("Non-disk file handles are not currently supported.\n");
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEOPNOTSUPP );
+        return FALSE;
+    }
+
+    if (buffers && buffers->Head)
+    {
+        elements[count].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[count].cLength   = buffers->HeadLength;
+        elements[count].u.pBuffer = buffers->Head;
+        count++;
+    }
+    if (h)
+    {
+        elements[count].dwElFlags = TP_ELEMENT_FILE;
+        elements[count].cLength   = file_bytes;
+        elements[count].u.s.hFile = h;
+        if (overlapped)
+        {
+            elements[count].u.s.nFileOffset.u.LowPart  = overlapped->u.s.Offset;
+            elements[count].u.s.nFileOffset.u.HighPart = overlapped->u.s.OffsetHigh;
+        }
+        else elements[count].u.s.nFileOffset.QuadPart = FILE_USE_FILE_POINTER_POSITION;
+        count++;
+    }
+    if (buffers && buffers->Tail)
+    {
+        elements[count].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[count].cLength   = buffers->TailLength;
+        elements[count].u.pBuffer = buffers->Tail;
+        count++;
+    }
+
+    return WS2_transmit( s, fd, elements, count, bytes_per_send, overlapped, flags );
+}
+
+/***********************************************************************
+ *     TransmitPackets
+ */
+static BOOL WINAPI WS2_TransmitPackets( SOCKET s, LPTRANSMIT_PACKETS_ELEMENT elements, DWORD count,
+                                        DWORD send_size, LPOVERLAPPED overlapped, DWORD flags )
+{
+    union generic_unix_sockaddr uaddr;
+    socklen_t uaddrlen = sizeof(uaddr);
+    DWORD i;
+    int fd;
+
+    TRACE("(%lx, %p, %u, %u, %p, %#x)\n", s, elements, count, send_size, overlapped, flags );
+
+    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
+    if (fd == -1) return FALSE;
+
+    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAENOTCONN );
+        return FALSE;
+    }
+    if (count && !elements)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    for (i = 0; i < count; i++)
+    {
+        DWORD type = elements[i].dwElFlags & (TP_ELEMENT_MEMORY | TP_ELEMENT_FILE);
+        if (type != TP_ELEMENT_MEMORY && type != TP_ELEMENT_FILE)
+        {
+            release_sock_fd( s, fd );
+            WSASetLastError( WSAEINVAL );
+            return FALSE;
+        }
+    }
+    if (flags)
+        FIXME("Flags are not currently supported (0x%x).\n", flags);
+
+    return WS2_transmit( s, fd, elements, count, send_size, overlapped, flags );
+}
+
 /***********************************************************************
  *     GetAcceptExSockaddrs
  */
@@ -4817,7 +5003,7 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
             EXTENSION_FUNCTION(WSAID_ACCEPTEX, WS2_AcceptEx)
             EXTENSION_FUNCTION(WSAID_GETACCEPTEXSOCKADDRS, WS2_GetAcceptExSockaddrs)
             EXTENSION_FUNCTION(WSAID_TRANSMITFILE, WS2_TransmitFile)
-            /* EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets) */
+            EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets)
             EXTENSION_FUNCTION(WSAID_WSARECVMSG, WS2_WSARecvMsg)
             EXTENSION_FUNCTION(WSAID_WSASENDMSG, WSASendMsg)
         };
@@ -5085,13 +5271,33 @@ int WINAPI WS_recvfrom(SOCKET s, char *buf, INT len, int flags,
         return n;
 }
 
+/* get the per-thread poll array, growing it if needed */
+static struct pollfd *get_poll_buffer( unsigned int count )
+{
+    struct per_thread_data *ptb = get_per_thread_data();
+    struct pollfd *fds;
+
+    if (ptb->fd_count < count)
+    {
+        if (!(fds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(fds[0]))))
+        {
+            SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+            return NULL;
+        }
+        HeapFree(GetProcessHeap(), 0, ptb->fd_cache);
+        ptb->fd_cache = fds;
+        ptb->fd_count = count;
+    }
+    return ptb->fd_cache;
+}
+
 /* allocate a poll array for the corresponding fd sets */
+/* sockets are only checked for being selectable once poll reports them, see filter_poll_results */
 static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set *writefds,
                                        const WS_fd_set *exceptfds, int *count_ptr )
 {
     unsigned int i, j = 0, count = 0;
     struct pollfd *fds;
-    struct per_thread_data *ptb = get_per_thread_data();
 
     if (readfds) count += readfds->fd_count;
     if (writefds) count += writefds->fd_count;
@@ -5103,80 +5309,31 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
         return NULL;
     }
 
-    /* check if the cache can hold all descriptors, if not do the resizing */
-    if (ptb->fd_count < count)
-    {
-        if (!(fds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(fds[0]))))
-        {
-            SetLastError( ERROR_NOT_ENOUGH_MEMORY );
-            return NULL;
-        }
-        HeapFree(GetProcessHeap(), 0, ptb->fd_cache);
-        ptb->fd_cache = fds;
-        ptb->fd_count = count;
-    }
-    else
-        fds = ptb->fd_cache;
+    if (!(fds = get_poll_buffer( count ))) return NULL;
 
     if (readfds)
         for (i = 0; i < readfds->fd_count; i++, j++)
         {
             fds[j].fd = get_sock_fd( readfds->fd_array[i], FILE_READ_DATA, NULL );
             if (fds[j].fd == -1) goto failed;
+            fds[j].events = POLLIN;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
-            {
-                fds[j].events = POLLIN;
-            }
-            else
-            {
-                release_sock_fd( readfds->fd_array[i], fds[j].fd );
-                fds[j].fd = -1;
-                fds[j].events = 0;
-            }
         }
     if (writefds)
         for (i = 0; i < writefds->fd_count; i++, j++)
         {
             fds[j].fd = get_sock_fd( writefds->fd_array[i], FILE_WRITE_DATA, NULL );
             if (fds[j].fd == -1) goto failed;
+            fds[j].events = POLLOUT;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1 ||
-                _get_fd_type(fds[j].fd) == SOCK_DGRAM)
-            {
-                fds[j].events = POLLOUT;
-            }
-            else
-            {
-                release_sock_fd( writefds->fd_array[i], fds[j].fd );
-                fds[j].fd = -1;
-                fds[j].events = 0;
-            }
         }
     if (exceptfds)
         for (i = 0; i < exceptfds->fd_count; i++, j++)
         {
             fds[j].fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
             if (fds[j].fd == -1) goto failed;
+            fds[j].events = POLLHUP | POLLPRI;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
-            {
-                int oob_inlined = 0;
-                socklen_t olen = sizeof(oob_inlined);
-
-                fds[j].events = POLLHUP;
-
-                /* Check if we need to test for urgent data or not */
-                getsockopt(fds[j].fd, SOL_SOCKET, SO_OOBINLINE, (char*) &oob_inlined, &olen);
-                if (!oob_inlined)
-                    fds[j].events |= POLLPRI;
-            }
-            else
-            {
-                release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
-                fds[j].fd = -1;
-                fds[j].events = 0;
-            }
         }
     return fds;
 
@@ -5195,6 +5352,70 @@ failed:
     return NULL;
 }
 
+/* drop a socket that cannot be selected from the poll array */
+static void drop_poll_fd( SOCKET s, struct pollfd *fd )
+{
+    release_sock_fd( s, fd->fd );
+    fd->fd = -1;
+    fd->events = 0;
+    fd->revents = 0;
+}
+
+/* Check the sockets poll reported against the select rules: unbound sockets
+ * never become ready, except for writing on datagram sockets, and urgent data
+ * only counts as an exception if it is not received inline. Doing this after
+ * polling keeps the syscalls off the sockets that aren't ready, which are
+ * usually the vast majority. Returns the number of entries still signaled. */
+static int filter_poll_results( const WS_fd_set *readfds, const WS_fd_set *writefds,
+                                const WS_fd_set *exceptfds, struct pollfd *fds )
+{
+    unsigned int i, j = 0;
+    int total = 0;
+
+    if (readfds)
+        for (i = 0; i < readfds->fd_count; i++, j++)
+        {
+            if (!fds[j].revents) continue;
+            if (is_fd_bound(fds[j].fd, NULL, NULL) != 1)
+                drop_poll_fd( readfds->fd_array[i], &fds[j] );
+            else
+                total++;
+        }
+    if (writefds)
+        for (i = 0; i < writefds->fd_count; i++, j++)
+        {
+            if (!fds[j].revents) continue;
+            if (is_fd_bound(fds[j].fd, NULL, NULL) != 1 && _get_fd_type(fds[j].fd) != SOCK_DGRAM)
+                drop_poll_fd( writefds->fd_array[i], &fds[j] );
+            else
+                total++;
+        }
+    if (exceptfds)
+        for (i = 0; i < exceptfds->fd_count; i++, j++)
+        {
+            if (!fds[j].revents) continue;
+            if (is_fd_bound(fds[j].fd, NULL, NULL) != 1)
+            {
+                drop_poll_fd( exceptfds->fd_array[i], &fds[j] );
+                continue;
+            }
+            if (fds[j].revents & POLLPRI)
+            {
+                int oob_inlined = 0;
+                socklen_t olen = sizeof(oob_inlined);
+
+                getsockopt(fds[j].fd, SOL_SOCKET, SO_OOBINLINE, (char*) &oob_inlined, &olen);
+                if (oob_inlined)
+                {
+                    fds[j].events &= ~POLLPRI;
+                    fds[j].revents &= ~POLLPRI;
+                }
+            }
+            if (fds[j].revents) total++;
+        }
+    return total;
+}
+
 /* release the file descriptor obtained in fd_sets_to_poll */
 /* must be called with the original fd_set arrays, before calling get_poll_results */
 static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefds,
@@ -5309,6 +5530,7 @@ int WINAPI WS_select(int nfds, WS_fd_set *ws_readfds,
 {
     struct pollfd *pollfds;
     int count, ret, timeout = -1;
+    ULONGLONG deadline = 0;
 
     TRACE("read %p, write %p, excp %p timeout %p\n",
           ws_readfds, ws_writefds, ws_exceptfds, ws_timeout);
@@ -5317,9 +5539,28 @@ int WINAPI WS_select(int nfds, WS_fd_set *ws_readfds,
         return SOCKET_ERROR;
 
     if (ws_timeout)
+    {
         timeout = (ws_timeout->tv_sec * 1000) + (ws_timeout->tv_usec + 999) / 1000;
+        deadline = GetTickCount64() + timeout;
+    }
+
+    for (;;)
+    {
+        ret = do_poll(pollfds, count, timeout);
+        if (ret <= 0 || filter_poll_results( ws_readfds, ws_writefds, ws_exceptfds, pollfds )) break;
 
-    ret = do_poll(pollfds, count, timeout);
+        /* only sockets that can't be selected woke us up, they are no longer polled */
+        if (timeout > 0)
+        {
+            ULONGLONG now = GetTickCount64();
+            timeout = now < deadline ? deadline - now : 0;
+        }
+        if (!timeout)
+        {
+            ret = 0;
+            break;
+        }
+    }
     release_poll_fds( ws_readfds, ws_writefds, ws_exceptfds, pollfds );
 
     if (ret == -1) SetLastError(wsaErrno());
@@ -5346,7 +5587,7 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
         return SOCKET_ERROR;
     }
 
-    if (!(ufds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(ufds[0]))))
+    if (!(ufds = get_poll_buffer( count )))
     {
         SetLastError(WSAENOBUFS);
         return SOCKET_ERROR;
@@ -5385,7 +5626,6 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
             wfds[i].revents = WS_POLLNVAL;
     }
 
-    HeapFree(GetProcessHeap(), 0, ufds);
     return ret;
 }
 
@@ -6567,10 +6807,8 @@ static BOOL addrinfo_in_list( const struct WS_addrinfo *list, const struct WS_ad
     return FALSE;
 }
 
-/***********************************************************************
- *		getaddrinfo		(WS2_32.@)
- */
-int WINAPI WS_getaddrinfo(LPCSTR nodename, LPCSTR servname, const struct WS_addrinfo *hints, struct WS_addrinfo **res)
+static int do_getaddrinfo(const char *nodename, const char *servname, const struct WS_addrinfo *hints,
+                          struct WS_addrinfo **res)
 {
 #ifdef HAVE_GETADDRINFO
     struct addrinfo *unixaires = NULL;
@@ -6778,6 +7016,276 @@ outofmem:
 #endif
 }
 
+/* getaddrinfo(3) does not report record TTLs, so host lookups are cached for
+ * a fixed time. Entries that are still in use shortly before they expire are
+ * refreshed in the background, so that busy names never block on the resolver. */
+#define ADDRINFO_CACHE_TIME    60000
+#define ADDRINFO_REFRESH_TIME  10000
+#define ADDRINFO_NEGATIVE_TIME 5000
+#define ADDRINFO_CACHE_SIZE    64
+
+struct addrinfo_key
+{
+    char *nodename;
+    char *servname;
+    BOOL  has_hints;
+    int   flags;
+    int   family;
+    int   socktype;
+    int   protocol;
+};
+
+struct addrinfo_cache_entry
+{
+    struct list          entry;
+    struct addrinfo_key  key;
+    int                  result;
+    struct WS_addrinfo  *ai;
+    ULONGLONG            expiry;
+    BOOL                 refreshing;
+};
+
+static struct list addrinfo_cache = LIST_INIT( addrinfo_cache );
+static unsigned int addrinfo_cache_count;
+DECLARE_CRITICAL_SECTION(cs_addrinfo_cache);
+
+static void init_addrinfo_key( struct addrinfo_key *key, const char *nodename, const char *servname,
+                               const struct WS_addrinfo *hints )
+{
+    key->nodename  = (char *)nodename;
+    key->servname  = (char *)servname;
+    key->has_hints = hints != NULL;
+    key->flags     = hints ? hints->ai_flags : 0;
+    key->family    = hints ? hints->ai_family : 0;
+    key->socktype  = hints ? hints->ai_socktype : 0;
+    key->protocol  = hints ? hints->ai_protocol : 0;
+}
+
+static BOOL addrinfo_key_equal( const struct addrinfo_key *a, const struct addrinfo_key *b )
+{
+    if (strcasecmp( a->nodename, b->nodename )) return FALSE;
+    if (!a->servname != !b->servname) return FALSE;
+    if (a->servname && strcmp( a->servname, b->servname )) return FALSE;
+    return a->has_hints == b->has_hints && a->flags == b->flags && a->family == b->family &&
+           a->socktype == b->socktype && a->protocol == b->protocol;
+}
+
+static char *strdupA( const char *str )
+{
+    char *ret = HeapAlloc( GetProcessHeap(), 0, strlen(str) + 1 );
+    if (ret) strcpy( ret, str );
+    return ret;
+}
+
+static BOOL copy_addrinfo_key( struct addrinfo_key *dst, const struct addrinfo_key *src )
+{
+    *dst = *src;
+    dst->servname = NULL;
+    if (!(dst->nodename = strdupA( src->nodename ))) return FALSE;
+    if (src->servname && !(dst->servname = strdupA( src->servname )))
+    {
+        HeapFree( GetProcessHeap(), 0, dst->nodename );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void free_addrinfo_key( struct addrinfo_key *key )
+{
+    HeapFree( GetProcessHeap(), 0, key->nodename );
+    HeapFree( GetProcessHeap(), 0, key->servname );
+}
+
+static struct WS_addrinfo *copy_addrinfo_list( const struct WS_addrinfo *src )
+{
+    struct WS_addrinfo *ret = NULL, **next = &ret, *ai;
+
+    for (; src; src = src->ai_next)
+    {
+        if (!(ai = HeapAlloc( GetProcessHeap(), 0, sizeof(*ai) ))) goto failed;
+        *ai = *src;
+        ai->ai_next = NULL;
+        ai->ai_canonname = NULL;
+        *next = ai;
+        next = &ai->ai_next;
+
+        if (!(ai->ai_addr = HeapAlloc( GetProcessHeap(), 0, src->ai_addrlen ))) goto failed;
+        memcpy( ai->ai_addr, src->ai_addr, src->ai_addrlen );
+        if (src->ai_canonname && !(ai->ai_canonname = strdupA( src->ai_canonname ))) goto failed;
+    }
+    return ret;
+
+failed:
+    WS_freeaddrinfo( ret );
+    return NULL;
+}
+
+static void free_addrinfo_cache_entry( struct addrinfo_cache_entry *cached )
+{
+    list_remove( &cached->entry );
+    addrinfo_cache_count--;
+    free_addrinfo_key( &cached->key );
+    WS_freeaddrinfo( cached->ai );
+    HeapFree( GetProcessHeap(), 0, cached );
+}
+
+/* must be called with cs_addrinfo_cache held */
+static struct addrinfo_cache_entry *find_addrinfo_cache_entry( const struct addrinfo_key *key )
+{
+    struct addrinfo_cache_entry *cached;
+
+    LIST_FOR_EACH_ENTRY( cached, &addrinfo_cache, struct addrinfo_cache_entry, entry )
+        if (addrinfo_key_equal( &cached->key, key )) return cached;
+    return NULL;
+}
+
+static void addrinfo_cache_store( const struct addrinfo_key *key, int result, const struct WS_addrinfo *ai )
+{
+    struct addrinfo_cache_entry *cached, *old;
+
+    EnterCriticalSection( &cs_addrinfo_cache );
+
+    old = find_addrinfo_cache_entry( key );
+
+    /* transient failures are not cached, let the old entry run out instead */
+    if (result && result != WS_EAI_NONAME)
+    {
+        if (old) old->refreshing = FALSE;
+        LeaveCriticalSection( &cs_addrinfo_cache );
+        return;
+    }
+
+    if (old) free_addrinfo_cache_entry( old );
+
+    if ((cached = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cached) )))
+    {
+        if (copy_addrinfo_key( &cached->key, key ) && (!ai || (cached->ai = copy_addrinfo_list( ai ))))
+        {
+            cached->result = result;
+            cached->expiry = GetTickCount64() + (result ? ADDRINFO_NEGATIVE_TIME : ADDRINFO_CACHE_TIME);
+            list_add_head( &addrinfo_cache, &cached->entry );
+            if (++addrinfo_cache_count > ADDRINFO_CACHE_SIZE)
+                free_addrinfo_cache_entry( LIST_ENTRY( list_tail( &addrinfo_cache ),
+                                                       struct addrinfo_cache_entry, entry ));
+        }
+        else
+        {
+            free_addrinfo_key( &cached->key );
+            HeapFree( GetProcessHeap(), 0, cached );
+        }
+    }
+
+    LeaveCriticalSection( &cs_addrinfo_cache );
+}
+
+static void WINAPI addrinfo_refresh_callback( TP_CALLBACK_INSTANCE *instance, void *context )
+{
+    struct addrinfo_key *key = context;
+    struct WS_addrinfo hints, *res = NULL;
+    int result;
+
+    TRACE( "refreshing %s\n", debugstr_a(key->nodename) );
+
+    memset( &hints, 0, sizeof(hints) );
+    hints.ai_flags    = key->flags;
+    hints.ai_family   = key->family;
+    hints.ai_socktype = key->socktype;
+    hints.ai_protocol = key->protocol;
+
+    result = do_getaddrinfo( key->nodename, key->servname, key->has_hints ? &hints : NULL, &res );
+    addrinfo_cache_store( key, result, res );
+    if (!result) WS_freeaddrinfo( res );
+
+    free_addrinfo_key( key );
+    HeapFree( GetProcessHeap(), 0, key );
+}
+
+/* must be called with cs_addrinfo_cache held */
+static void queue_addrinfo_refresh( struct addrinfo_cache_entry *cached )
+{
+    struct addrinfo_key *key;
+
+    if (!(key = HeapAlloc( GetProcessHeap(), 0, sizeof(*key) ))) return;
+    if (!copy_addrinfo_key( key, &cached->key ))
+    {
+        HeapFree( GetProcessHeap(), 0, key );
+        return;
+    }
+    if (!TrySubmitThreadpoolCallback( addrinfo_refresh_callback, key, NULL ))
+    {
+        free_addrinfo_key( key );
+        HeapFree( GetProcessHeap(), 0, key );
+        return;
+    }
+    cached->refreshing = TRUE;
+}
+
+static BOOL addrinfo_cache_lookup( const struct addrinfo_key *key, int *result, struct WS_addrinfo **res )
+{
+    struct addrinfo_cache_entry *cached;
+    ULONGLONG now = GetTickCount64();
+    BOOL ret = FALSE;
+
+    EnterCriticalSection( &cs_addrinfo_cache );
+
+    if ((cached = find_addrinfo_cache_entry( key )))
+    {
+        if (cached->expiry <= now)
+            free_addrinfo_cache_entry( cached );
+        else if (!cached->ai || (*res = copy_addrinfo_list( cached->ai )))
+        {
+            *result = cached->result;
+            ret = TRUE;
+
+            list_remove( &cached->entry );
+            list_add_head( &addrinfo_cache, &cached->entry );
+
+            if (!cached->result && !cached->refreshing && cached->expiry - now < ADDRINFO_REFRESH_TIME)
+                queue_addrinfo_refresh( cached );
+        }
+    }
+
+    LeaveCriticalSection( &cs_addrinfo_cache );
+    return ret;
+}
+
+static void free_addrinfo_cache(void)
+{
+    struct addrinfo_cache_entry *cached, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( cached, next, &addrinfo_cache, struct addrinfo_cache_entry, entry )
+        free_addrinfo_cache_entry( cached );
+}
+
+/***********************************************************************
+ *		getaddrinfo		(WS2_32.@)
+ */
+int WINAPI WS_getaddrinfo(LPCSTR nodename, LPCSTR servname, const struct WS_addrinfo *hints, struct WS_addrinfo **res)
+{
+    struct addrinfo_key key;
+    int result;
+
+    /* only host names go through the resolver, there is nothing to cache for
+     * numeric or local addresses */
+    if (!nodename || !nodename[0] || (hints && (hints->ai_flags & WS_AI_NUMERICHOST)))
+        return do_getaddrinfo( nodename, servname, hints, res );
+
+    init_addrinfo_key( &key, nodename, servname, hints );
+
+    *res = NULL;
+    if (addrinfo_cache_lookup( &key, &result, res ))
+    {
+        TRACE( "%s, %s %p -> %p %d (cached)\n", debugstr_a(nodename), debugstr_a(servname), hints, *res, result );
+        SetLastError( result );
+        return result;
+    }
+
+    result = do_getaddrinfo( nodename, servname, hints, res );
+    addrinfo_cache_store( &key, result, *res );
+    SetLastError( result );
+    return result;
+}
+
 static ADDRINFOEXW *addrinfo_AtoW(const struct WS_addrinfo *ai)
 {
     ADDRINFOEXW *ret;
@@ -8017,13 +8525,16 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
             iosb->Information = n;
             if (!wsa->completion_func)
             {
-                if (cvalue) WS_AddCompletion( s, cvalue, STATUS_SUCCESS, n, FALSE );
+                _enable_event_completion( s, FD_READ, cvalue, n );
                 if (lpOverlapped->hEvent) SetEvent( lpOverlapped->hEvent );
                 HeapFree( GetProcessHeap(), 0, wsa );
             }
-            else NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)ws2_async_apc,
-                                   (ULONG_PTR)wsa, (ULONG_PTR)iosb, 0 );
-            _enable_event(SOCKET2HANDLE(s), FD_READ, 0, 0);
+            else
+            {
+                NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)ws2_async_apc,
+                                  (ULONG_PTR)wsa, (ULONG_PTR)iosb, 0 );
+                _enable_event(SOCKET2HANDLE(s), FD_READ, 0, 0);
+            }
             return 0;
         }
 
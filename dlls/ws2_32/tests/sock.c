@@ -8027,7 +8027,10 @@ static void test_TransmitFile(void)
 {
     DWORD num_bytes, err, file_size, total_sent;
     GUID transmitFileGuid = WSAID_TRANSMITFILE;
+    GUID transmitPacketsGuid = WSAID_TRANSMITPACKETS;
     LPFN_TRANSMITFILE pTransmitFile = NULL;
+    LPFN_TRANSMITPACKETS pTransmitPackets = NULL;
+    TRANSMIT_PACKETS_ELEMENT elements[3];
     HANDLE file = INVALID_HANDLE_VALUE;
     char header_msg[] = "hello world";
     char footer_msg[] = "goodbye!!!";
@@ -8185,6 +8188,38 @@ static void test_TransmitFile(void)
     ok(memcmp(buf, &footer_msg[0], sizeof(footer_msg)) == 0,
        "TransmitFile footer buffer did not match!\n");
 
+    /* Test TransmitPackets with memory and file elements */
+    iret = WSAIoctl(client, SIO_GET_EXTENSION_FUNCTION_POINTER, &transmitPacketsGuid, sizeof(transmitPacketsGuid),
+                    &pTransmitPackets, sizeof(pTransmitPackets), &num_bytes, NULL, NULL);
+    ok(!iret, "failed to get TransmitPackets, error %u\n", GetLastError());
+    memset(elements, 0, sizeof(elements));
+    elements[0].dwElFlags = TP_ELEMENT_MEMORY;
+    elements[0].cLength = sizeof(header_msg);
+    elements[0].pBuffer = header_msg;
+    elements[1].dwElFlags = TP_ELEMENT_FILE;
+    elements[1].hFile = file;
+    elements[1].nFileOffset.QuadPart = 10;
+    elements[2].dwElFlags = TP_ELEMENT_MEMORY;
+    elements[2].cLength = sizeof(footer_msg);
+    elements[2].pBuffer = footer_msg;
+    bret = pTransmitPackets(client, elements, ARRAY_SIZE(elements), 0, NULL, 0);
+    ok(bret, "TransmitPackets failed, error %u\n", WSAGetLastError());
+    iret = recv(dest, buf, sizeof(header_msg), 0);
+    ok(iret == sizeof(header_msg), "got %d\n", iret);
+    ok(!memcmp(buf, header_msg, sizeof(header_msg)), "TransmitPackets header buffer did not match!\n");
+    compare_file(file, dest, 10);
+    iret = recv(dest, buf, sizeof(footer_msg), 0);
+    ok(iret == sizeof(footer_msg), "got %d\n", iret);
+    ok(!memcmp(buf, footer_msg, sizeof(footer_msg)), "TransmitPackets footer buffer did not match!\n");
+
+    /* Test TransmitPackets with a limited file length */
+    elements[1].cLength = 16;
+    elements[1].nFileOffset.QuadPart = 0;
+    bret = pTransmitPackets(client, elements + 1, 1, 0, NULL, 0);
+    ok(bret, "TransmitPackets failed, error %u\n", WSAGetLastError());
+    iret = recv(dest, buf, sizeof(buf), 0);
+    ok(iret == 16, "got %d\n", iret);
+
     /* Test TransmitFile with a UDP datagram socket */
     closesocket(client);
     client = socket(AF_INET, SOCK_DGRAM, 0);
@@ -1701,6 +1701,11 @@ DWORD WINAPI engine_thread(void *user)
 {
     XA2VoiceImpl *This = user;
 
+    /* All voices are mixed on this thread once per quantum, and a late pass
+     * is an audible glitch. Native runs its processing thread at the same
+     * priority. */
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
     pthread_mutex_lock(&This->engine_lock);
 
     pthread_cond_broadcast(&This->engine_done);
@@ -26,6 +26,10 @@ extern "C" {
 #define EVENT_LEVEL_MIN 0x00
 #define EVENT_LEVEL_MAX 0xff
 
+#define EVENT_CONTROL_CODE_DISABLE_PROVIDER 0
+#define EVENT_CONTROL_CODE_ENABLE_PROVIDER  1
+#define EVENT_CONTROL_CODE_CAPTURE_STATE    2
+
 typedef ULONGLONG REGHANDLE, *PREGHANDLE;
 
 typedef struct _EVENT_DATA_DESCRIPTOR
@@ -1188,6 +1188,8 @@ typedef struct COPYFILE2_EXTENDED_PARAMETERS
 #define FILE_MAP_ALL_ACCESS             0x000f001f
 #define FILE_MAP_EXECUTE                0x00000020
 
+#define NUMA_NO_PREFERRED_NODE          ((DWORD)-1)
+
 #define MOVEFILE_REPLACE_EXISTING       0x00000001
 #define MOVEFILE_COPY_ALLOWED           0x00000002
 #define MOVEFILE_DELAY_UNTIL_REBOOT     0x00000004
@@ -830,57 +830,42 @@ typedef struct
     lparam_t info;
 } cursor_pos_t;
 
-struct cpu_topology_override
-{
-    unsigned int cpu_count;
-    unsigned char host_cpu_id[64];
-};
 
-struct shared_cursor
+typedef struct
 {
-    int                  x;
-    int                  y;
-    unsigned int         last_change;
-    rectangle_t          clip;
-};
+    user_handle_t  window;
+    unsigned int   key;
+    lparam_t       data;
+} shm_property_t;
+
+#define SHM_PROPERTY_NAME_KEY 0x80000000
+#define SHM_PROPERTY_COUNT    1024
+#define SHM_PROPERTY_SLOT(window,key) (((window) ^ ((key) * 0x9e3779b1u)) % SHM_PROPERTY_COUNT)
 
-struct desktop_shared_memory
-{
-    unsigned int         seq;
-    struct shared_cursor cursor;
-    unsigned char        keystate[256];
-    thread_id_t          foreground_tid;
-};
 
-struct queue_shared_memory
+typedef struct
 {
-    unsigned int         seq;
-    unsigned int         wake_bits;
-    unsigned int         changed_bits;
-    unsigned int         wake_mask;
-    unsigned int         changed_mask;
-    thread_id_t          input_tid;
-};
+    unsigned int   seq;
+    int            cursor_x;
+    int            cursor_y;
+    unsigned int   cursor_last_change;
+    unsigned char  keystate[256];
+    shm_property_t properties[SHM_PROPERTY_COUNT];
+} desktop_shm_t;
 
-struct input_shared_memory
+struct cpu_topology_override
 {
-    unsigned int         seq;
-    thread_id_t          tid;
-    user_handle_t        focus;
-    user_handle_t        capture;
-    user_handle_t        active;
-    user_handle_t        menu_owner;
-    user_handle_t        move_size;
-    user_handle_t        caret;
-    user_handle_t        cursor;
-    rectangle_t          caret_rect;
-    int                  cursor_count;
-    unsigned char        keystate[256];
+    unsigned int cpu_count;
+    unsigned char host_cpu_id[64];
 };
 
 
-#define SEQUENCE_MASK_BITS  4
-#define SEQUENCE_MASK ((1UL << SEQUENCE_MASK_BITS) - 1)
+struct shared_handle_entry
+{
+    unsigned int   access;
+    unsigned short type;
+    unsigned short flags;
+};
 
 
 
@@ -1337,6 +1322,18 @@ struct dup_handle_reply
 
 
 
+struct get_shared_handle_table_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_shared_handle_table_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct make_temporary_request
 {
     struct request_header __header;
@@ -1873,6 +1870,8 @@ struct enable_socket_event_request
     unsigned int sstate;
     unsigned int cstate;
     char __pad_28[4];
+    apc_param_t  cvalue;
+    apc_param_t  information;
 };
 struct enable_socket_event_reply
 {
@@ -2672,7 +2671,7 @@ struct get_msg_queue_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
-    char __pad_12[4];
+    unsigned int status_idx;
 };
 
 
@@ -2795,6 +2794,7 @@ struct send_hardware_message_reply
     int             prev_y;
     int             new_x;
     int             new_y;
+    /* VARARG(keystate,bytes); */
     char __pad_28[4];
 };
 #define SEND_HWMSG_INJECTED    0x01
@@ -2825,9 +2825,9 @@ struct get_message_reply
     int             x;
     int             y;
     unsigned int    time;
+    unsigned int    active_hooks;
     data_size_t     total;
     /* VARARG(data,message_data); */
-    char __pad_52[4];
 };
 
 
@@ -3879,10 +3879,14 @@ struct get_thread_input_reply
     user_handle_t  focus;
     user_handle_t  capture;
     user_handle_t  active;
+    user_handle_t  foreground;
     user_handle_t  menu_owner;
     user_handle_t  move_size;
     user_handle_t  caret;
+    user_handle_t  cursor;
+    int            show_count;
     rectangle_t    rect;
+    char __pad_60[4];
 };
 
 
@@ -4040,20 +4044,6 @@ enum caret_state
 
 
 
-struct get_active_hooks_request
-{
-    struct request_header __header;
-    char __pad_12[4];
-};
-struct get_active_hooks_reply
-{
-    struct reply_header __header;
-    unsigned int   active_hooks;
-    char __pad_12[4];
-};
-
-
-
 struct set_hook_request
 {
     struct request_header __header;
@@ -5280,6 +5270,19 @@ struct set_cursor_reply
 #define SET_CURSOR_NOCLIP 0x10
 
 
+struct get_desktop_shared_mapping_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_desktop_shared_mapping_reply
+{
+    struct reply_header __header;
+    obj_handle_t   handle;
+    char __pad_12[4];
+};
+
+
 struct get_cursor_history_request
 {
     struct request_header __header;
@@ -5701,6 +5704,7 @@ enum request
     REQ_close_handle,
     REQ_set_handle_info,
     REQ_dup_handle,
+    REQ_get_shared_handle_table,
     REQ_make_temporary,
     REQ_open_process,
     REQ_open_thread,
@@ -5862,7 +5866,6 @@ enum request
     REQ_set_capture_window,
     REQ_set_caret_window,
     REQ_set_caret_info,
-    REQ_get_active_hooks,
     REQ_set_hook,
     REQ_remove_hook,
     REQ_start_hook_chain,
@@ -5937,6 +5940,7 @@ enum request
     REQ_alloc_user_handle,
     REQ_free_user_handle,
     REQ_set_cursor,
+    REQ_get_desktop_shared_mapping,
     REQ_get_cursor_history,
     REQ_get_rawinput_buffer,
     REQ_update_rawinput_devices,
@@ -5995,6 +5999,7 @@ union generic_request
     struct close_handle_request close_handle_request;
     struct set_handle_info_request set_handle_info_request;
     struct dup_handle_request dup_handle_request;
+    struct get_shared_handle_table_request get_shared_handle_table_request;
     struct make_temporary_request make_temporary_request;
     struct open_process_request open_process_request;
     struct open_thread_request open_thread_request;
@@ -6156,7 +6161,6 @@ union generic_request
     struct set_capture_window_request set_capture_window_request;
     struct set_caret_window_request set_caret_window_request;
     struct set_caret_info_request set_caret_info_request;
-    struct get_active_hooks_request get_active_hooks_request;
     struct set_hook_request set_hook_request;
     struct remove_hook_request remove_hook_request;
     struct start_hook_chain_request start_hook_chain_request;
@@ -6231,6 +6235,7 @@ union generic_request
     struct alloc_user_handle_request alloc_user_handle_request;
     struct free_user_handle_request free_user_handle_request;
     struct set_cursor_request set_cursor_request;
+    struct get_desktop_shared_mapping_request get_desktop_shared_mapping_request;
     struct get_cursor_history_request get_cursor_history_request;
     struct get_rawinput_buffer_request get_rawinput_buffer_request;
     struct update_rawinput_devices_request update_rawinput_devices_request;
@@ -6287,6 +6292,7 @@ union generic_reply
     struct close_handle_reply close_handle_reply;
     struct set_handle_info_reply set_handle_info_reply;
     struct dup_handle_reply dup_handle_reply;
+    struct get_shared_handle_table_reply get_shared_handle_table_reply;
     struct make_temporary_reply make_temporary_reply;
     struct open_process_reply open_process_reply;
     struct open_thread_reply open_thread_reply;
@@ -6448,7 +6454,6 @@ union generic_reply
     struct set_capture_window_reply set_capture_window_reply;
     struct set_caret_window_reply set_caret_window_reply;
     struct set_caret_info_reply set_caret_info_reply;
-    struct get_active_hooks_reply get_active_hooks_reply;
     struct set_hook_reply set_hook_reply;
     struct remove_hook_reply remove_hook_reply;
     struct start_hook_chain_reply start_hook_chain_reply;
@@ -6523,6 +6528,7 @@ union generic_reply
     struct alloc_user_handle_reply alloc_user_handle_reply;
     struct free_user_handle_reply free_user_handle_reply;
     struct set_cursor_reply set_cursor_reply;
+    struct get_desktop_shared_mapping_reply get_desktop_shared_mapping_reply;
     struct get_cursor_history_reply get_cursor_history_reply;
     struct get_rawinput_buffer_reply get_rawinput_buffer_reply;
     struct update_rawinput_devices_reply update_rawinput_devices_reply;
@@ -6553,7 +6559,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 693
+#define SERVER_PROTOCOL_VERSION 698
 
 /* ### protocol_version end ### */
 
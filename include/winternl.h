@@ -1688,6 +1688,24 @@ typedef struct _RTL_HEAP_DEFINITION {
     ULONG Unknown[11];
 } RTL_HEAP_DEFINITION, *PRTL_HEAP_DEFINITION;
 
+/* Wine extension: sampled allocation profile, enabled with WINE_HEAP_PROFILE=<bytes> */
+#define HeapWineProfileInformation ((HEAP_INFORMATION_CLASS)0x57494e00)
+
+#define HEAP_PROFILE_MAX_FRAMES 16
+
+typedef struct _HEAP_PROFILE_ENTRY {
+    SIZE_T Samples;      /* number of sampled allocations from this stack */
+    SIZE_T Bytes;        /* total size of the sampled allocations */
+    USHORT FrameCount;
+    PVOID  Frames[HEAP_PROFILE_MAX_FRAMES];
+} HEAP_PROFILE_ENTRY, *PHEAP_PROFILE_ENTRY;
+
+typedef struct _HEAP_PROFILE_INFORMATION {
+    SIZE_T SampleRate;   /* average number of allocated bytes between samples, 0 if disabled */
+    ULONG  EntryCount;
+    HEAP_PROFILE_ENTRY Entries[1];
+} HEAP_PROFILE_INFORMATION, *PHEAP_PROFILE_INFORMATION;
+
 typedef struct _RTL_RWLOCK {
     RTL_CRITICAL_SECTION rtlCS;
 
@@ -3531,6 +3549,7 @@ NTSYSAPI BOOLEAN   WINAPI RtlAreAllAccessesGranted(ACCESS_MASK,ACCESS_MASK);
 NTSYSAPI BOOLEAN   WINAPI RtlAreAnyAccessesGranted(ACCESS_MASK,ACCESS_MASK);
 NTSYSAPI BOOLEAN   WINAPI RtlAreBitsSet(PCRTL_BITMAP,ULONG,ULONG);
 NTSYSAPI BOOLEAN   WINAPI RtlAreBitsClear(PCRTL_BITMAP,ULONG,ULONG);
+NTSYSAPI USHORT    WINAPI RtlCaptureStackBackTrace(ULONG,ULONG,PVOID*,ULONG*);
 NTSYSAPI NTSTATUS  WINAPI RtlCharToInteger(PCSZ,ULONG,PULONG);
 NTSYSAPI NTSTATUS  WINAPI RtlCheckRegistryKey(ULONG, PWSTR);
 NTSYSAPI void      WINAPI RtlClearAllBits(PRTL_BITMAP);
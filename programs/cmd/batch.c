@@ -73,6 +73,8 @@ void WCMD_batch (WCHAR *file, WCHAR *command, BOOL called, WCHAR *startLabel, HA
   memset(context -> shift_count, 0x00, sizeof(context -> shift_count));
   context -> prev_context = prev_context;
   context -> skip_rest = FALSE;
+  context -> labels = NULL;
+  context -> label_count = 0;
 
   /* If processing a call :label, 'goto' the label in question */
   if (startLabel) {
@@ -110,6 +112,7 @@ void WCMD_batch (WCHAR *file, WCHAR *command, BOOL called, WCHAR *startLabel, HA
  *	to the caller's caller.
  */
 
+  WCMD_free_labels(context);
   heap_free(context->batchfileW);
   LocalFree (context);
   if ((prev_context != NULL) && (!called)) {
@@ -2541,10 +2541,135 @@ void WCMD_give_help (const WCHAR *args)
   return;
 }
 
+/****************************************************************************
+ * WCMD_get_label
+ *
+ * Returns the label defined on a batch file line, or NULL if the line is not
+ * a label. The line is modified in place.
+ */
+static WCHAR *WCMD_get_label(WCHAR *str) {
+
+  WCHAR *labelend;
+
+  /* Ignore leading whitespace or no-echo character */
+  while (*str=='@' || iswspace (*str)) str++;
+
+  /* If the first real character is a : then this is a label */
+  if (*str != ':') return NULL;
+  str++;
+
+  /* Skip spaces between : and label */
+  while (iswspace (*str)) str++;
+  WINE_TRACE("str before brk %s\n", wine_dbgstr_w(str));
+
+  /* Label ends at whitespace or redirection characters */
+  labelend = wcspbrk(str, L"><|& :\t");
+  if (labelend) *labelend = 0x00;
+  return str;
+}
+
+/****************************************************************************
+ * WCMD_free_labels
+ *
+ * Frees the label index of a batch context.
+ */
+void WCMD_free_labels (BATCH_CONTEXT *ctx) {
+
+  int i;
+
+  for (i = 0; i < ctx->label_count; i++) heap_free(ctx->labels[i].name);
+  heap_free(ctx->labels);
+  ctx->labels = NULL;
+  ctx->label_count = 0;
+}
+
+/****************************************************************************
+ * WCMD_index_labels
+ *
+ * Scans the whole batch file once, recording the position of every label so
+ * that loops built out of goto statements don't rescan the file each time.
+ */
+static void WCMD_index_labels (BATCH_CONTEXT *ctx, WCHAR *string, DWORD len) {
+
+  LARGE_INTEGER zero, pos, saved;
+  int size = 16;
+  WCHAR *label;
+
+  zero.QuadPart = 0;
+  if (!GetFileSizeEx(ctx->h, &ctx->labels_size)) return;
+  SetFilePointerEx(ctx->h, zero, &saved, FILE_CURRENT);
+  SetFilePointerEx(ctx->h, zero, NULL, FILE_BEGIN);
+
+  ctx->labels = heap_xalloc(size * sizeof(*ctx->labels));
+  pos.QuadPart = 0;
+  while (WCMD_fgets(string, len, ctx->h)) {
+    if ((label = WCMD_get_label(string))) {
+      if (ctx->label_count == size) {
+        BATCH_LABEL *labels = heap_xalloc(2 * size * sizeof(*labels));
+        memcpy(labels, ctx->labels, size * sizeof(*labels));
+        heap_free(ctx->labels);
+        ctx->labels = labels;
+        size *= 2;
+      }
+      ctx->labels[ctx->label_count].name = heap_strdupW(label);
+      ctx->labels[ctx->label_count++].pos = pos;
+    }
+    SetFilePointerEx(ctx->h, zero, &pos, FILE_CURRENT);
+  }
+  WINE_TRACE("indexed %d labels\n", ctx->label_count);
+
+  SetFilePointerEx(ctx->h, saved, NULL, FILE_BEGIN);
+}
+
+/****************************************************************************
+ * WCMD_find_indexed_label
+ *
+ * Moves the file pointer after the given label using the label index.
+ * Returns FALSE if the label isn't indexed or the index is out of date, in
+ * which case the caller has to scan the file.
+ */
+static BOOL WCMD_find_indexed_label (BATCH_CONTEXT *ctx, const WCHAR *name,
+                                     WCHAR *string, DWORD len) {
+
+  LARGE_INTEGER zero, cur, size;
+  WCHAR *label;
+  int i, found = -1;
+
+  zero.QuadPart = 0;
+  if (ctx->labels && (!GetFileSizeEx(ctx->h, &size) || size.QuadPart != ctx->labels_size.QuadPart))
+    WCMD_free_labels(ctx);
+  if (!ctx->labels) WCMD_index_labels(ctx, string, len);
+  if (!ctx->labels) return FALSE;
+
+  /* Look from the current file position to the end first, then wrap around */
+  SetFilePointerEx(ctx->h, zero, &cur, FILE_CURRENT);
+  for (i = 0; i < ctx->label_count; i++) {
+    if (lstrcmpiW(ctx->labels[i].name, name)) continue;
+    if (found == -1) found = i;
+    if (ctx->labels[i].pos.QuadPart >= cur.QuadPart) {
+      found = i;
+      break;
+    }
+  }
+  if (found == -1) return FALSE;
+
+  /* Make sure the batch file wasn't rewritten under us */
+  SetFilePointerEx(ctx->h, ctx->labels[found].pos, NULL, FILE_BEGIN);
+  if (WCMD_fgets(string, len, ctx->h) && (label = WCMD_get_label(string)) &&
+      !lstrcmpiW(label, name))
+    return TRUE;
+
+  WINE_TRACE("Label index out of date\n");
+  WCMD_free_labels(ctx);
+  SetFilePointerEx(ctx->h, cur, NULL, FILE_BEGIN);
+  return FALSE;
+}
+
 /****************************************************************************
  * WCMD_go_to
  *
- * Batch file jump instruction. Not the most efficient algorithm ;-)
+ * Batch file jump instruction. Labels are looked up in an index of the batch
+ * file, falling back to scanning it when the index doesn't know the label.
  * Prints error message if the specified label cannot be found - the file pointer is
  * then at EOF, effectively stopping the batch file.
  * FIXME: DOS is supposed to allow labels with spaces - we don't.
@@ -2579,6 +2704,9 @@ void WCMD_goto (CMD_LIST **cmdList) {
     if (labelend) *labelend = 0x00;
     WINE_TRACE("goto label: '%s'\n", wine_dbgstr_w(paramStart));
 
+    if (*paramStart && WCMD_find_indexed_label(context, paramStart, string, ARRAY_SIZE(string)))
+      return;
+
     /* Loop through potentially twice - once from current file position
        through to the end, and second time from start to current file
        position                                                         */
@@ -2598,24 +2726,9 @@ void WCMD_goto (CMD_LIST **cmdList) {
             }
 
             while (WCMD_fgets (string, ARRAY_SIZE(string), context -> h)) {
-              str = string;
-
-              /* Ignore leading whitespace or no-echo character */
-              while (*str=='@' || iswspace (*str)) str++;
-
               /* If the first real character is a : then this is a label */
-              if (*str == ':') {
-                str++;
-
-                /* Skip spaces between : and label */
-                while (iswspace (*str)) str++;
-                WINE_TRACE("str before brk %s\n", wine_dbgstr_w(str));
-
-                /* Label ends at whitespace or redirection characters */
-                labelend = wcspbrk(str, labelEndsW);
-                if (labelend) *labelend = 0x00;
+              if ((str = WCMD_get_label(string))) {
                 WINE_TRACE("comparing found label %s\n", wine_dbgstr_w(str));
-
                 if (lstrcmpiW (str, paramStart) == 0) return;
               }
 
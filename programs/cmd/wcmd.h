@@ -150,6 +150,11 @@ int evaluate_if_condition(WCHAR *p, WCHAR **command, int *test, int *negate);
 
 /* Data structure to hold context when executing batch files */
 
+typedef struct _BATCH_LABEL {
+  WCHAR *name;          /* Label name, without the leading ':' */
+  LARGE_INTEGER pos;    /* Offset of the line holding the label */
+} BATCH_LABEL;
+
 typedef struct _BATCH_CONTEXT {
   WCHAR *command;	/* The command which invoked the batch file */
   HANDLE h;             /* Handle to the open batch file */
@@ -158,8 +163,13 @@ typedef struct _BATCH_CONTEXT {
   struct _BATCH_CONTEXT *prev_context; /* Pointer to the previous context block */
   BOOL  skip_rest;      /* Skip the rest of the batch program and exit */
   CMD_LIST *toExecute;  /* Commands left to be executed */
+  BATCH_LABEL *labels;  /* Index of the labels in the batch file, built on first goto */
+  int label_count;      /* Number of entries in the label index */
+  LARGE_INTEGER labels_size; /* Batch file size when the label index was built */
 } BATCH_CONTEXT;
 
+void WCMD_free_labels (BATCH_CONTEXT *ctx);
+
 /* Data structure to handle building lists during recursive calls */
 
 struct env_stack
@@ -287,7 +287,7 @@ static void tty_sync( struct console *console )
     }
     else if (console->tty_cursor_visible)
         hide_tty_cursor( console );
-    tty_flush( console );
+    if (!console->tty_batch) tty_flush( console );
 }
 
 static void init_tty_output( struct console *console )
@@ -323,9 +323,10 @@ static void scroll_to_cursor( struct screen_buffer *screen_buffer )
 
 static void update_output( struct screen_buffer *screen_buffer, RECT *rect )
 {
-    int x, y, size, trailing_spaces;
+    int x, y, end, len, size, trailing_spaces;
     char_info_t *ch;
-    char buf[8];
+    WCHAR run[256];
+    char buf[1024];
 
     if (!is_active( screen_buffer ) || rect->top > rect->bottom || rect->right < rect->left)
         return;
@@ -350,7 +351,8 @@ static void update_output( struct screen_buffer *screen_buffer, RECT *rect )
         }
         if (trailing_spaces < 4) trailing_spaces = 0;
 
-        for (x = rect->left; x <= rect->right; x++)
+        end = min( rect->right + 1, screen_buffer->width - trailing_spaces );
+        for (x = rect->left; x <= rect->right; x += len)
         {
             ch = &screen_buffer->data[y * screen_buffer->width + x];
             set_tty_attr( screen_buffer->console, ch->attr );
@@ -362,10 +364,13 @@ static void update_output( struct screen_buffer *screen_buffer, RECT *rect )
                 break;
             }
 
+            /* convert the whole run of cells sharing the same attributes at once */
+            for (len = 0; x + len < end && len < ARRAY_SIZE(run) && ch[len].attr == ch->attr; len++)
+                run[len] = ch[len].ch;
             size = WideCharToMultiByte( get_tty_cp( screen_buffer->console ), 0,
-                                        &ch->ch, 1, buf, sizeof(buf), NULL, NULL );
+                                        run, len, buf, sizeof(buf), NULL, NULL );
             tty_write( screen_buffer->console, buf, size );
-            screen_buffer->console->tty_cursor_x++;
+            screen_buffer->console->tty_cursor_x += len;
         }
     }
 
@@ -2552,6 +2557,9 @@ static NTSTATUS process_console_ioctls( struct console *console )
     int output;
     NTSTATUS status = STATUS_SUCCESS;
 
+    /* coalesce the output of all queued requests into a single tty write */
+    console->tty_batch = TRUE;
+
     for (;;)
     {
         if (status) out_size = 0;
@@ -2572,17 +2580,21 @@ static NTSTATUS process_console_ioctls( struct console *console )
         }
         SERVER_END_REQ;
 
-        if (status == STATUS_PENDING) return STATUS_SUCCESS;
+        if (status == STATUS_PENDING) break;
         if (status == STATUS_BUFFER_OVERFLOW)
         {
-            if (!alloc_ioctl_buffer( out_size )) return STATUS_NO_MEMORY;
-            status = STATUS_SUCCESS;
-            continue;
+            if (alloc_ioctl_buffer( out_size ))
+            {
+                status = STATUS_SUCCESS;
+                continue;
+            }
+            status = STATUS_NO_MEMORY;
+            break;
         }
         if (status)
         {
             TRACE( "failed to get next request: %#x\n", status );
-            return status;
+            break;
         }
 
         if (code == IOCTL_CONDRV_INIT_OUTPUT)
@@ -2612,6 +2624,10 @@ static NTSTATUS process_console_ioctls( struct console *console )
             }
         }
     }
+
+    console->tty_batch = FALSE;
+    tty_flush( console );
+    return status == STATUS_PENDING ? STATUS_SUCCESS : status;
 }
 
 static int main_loop( struct console *console, HANDLE signal )
@@ -100,8 +100,9 @@ struct console
     HANDLE                 input_thread;        /* input thread handle */
     HANDLE                 tty_input;           /* handle to tty input stream */
     HANDLE                 tty_output;          /* handle to tty output stream */
-    char                   tty_buffer[4096];    /* tty output buffer */
+    char                   tty_buffer[16384];   /* tty output buffer */
     size_t                 tty_buffer_count;    /* tty buffer size */
+    int                    tty_batch;           /* defer tty flush until the ioctl queue is empty */
     unsigned int           tty_cursor_x;        /* tty cursor position */
     unsigned int           tty_cursor_y;
     unsigned int           tty_attr;            /* current tty char attributes */
@@ -440,6 +440,113 @@ static BOOL is_root_pnp_service(HDEVINFO set, const struct service_entry *servic
     return FALSE;
 }
 
+#define MAX_PARALLEL_AUTOSTART 8
+
+enum autostart_state
+{
+    AUTOSTART_PENDING,
+    AUTOSTART_RUNNING,
+    AUTOSTART_DONE
+};
+
+static DWORD WINAPI autostart_thread(void *arg)
+{
+    struct service_entry *service = arg;
+    DWORD err;
+
+    TRACE("starting %s\n", wine_dbgstr_w(service->name));
+    err = service_start(service, 0, NULL);
+    if (err != ERROR_SUCCESS)
+        WINE_FIXME("Auto-start service %s failed to start: %d\n",
+                   wine_dbgstr_w(service->name), err);
+    return err;
+}
+
+/* check that the services and groups a service depends on have been started */
+static BOOL autostart_dependencies_done(struct service_entry **services, const BYTE *state,
+                                        unsigned int count, const struct service_entry *service)
+{
+    const WCHAR *ptr;
+    unsigned int i;
+
+    for (i = 0; i < count; i++)
+    {
+        const WCHAR *group = services[i]->config.lpLoadOrderGroup;
+
+        if (state[i] == AUTOSTART_DONE || services[i] == service) continue;
+
+        if (service->dependOnServices)
+            for (ptr = service->dependOnServices; *ptr; ptr += lstrlenW(ptr) + 1)
+                if (!wcsicmp(ptr, services[i]->name)) return FALSE;
+
+        if (service->dependOnGroups && group && *group)
+            for (ptr = service->dependOnGroups; *ptr; ptr += lstrlenW(ptr) + 1)
+                if (!wcsicmp(ptr, group)) return FALSE;
+    }
+    return TRUE;
+}
+
+/* start services in parallel, each one once its dependencies have been started */
+static void autostart_services(struct service_entry **services, unsigned int count)
+{
+    HANDLE threads[MAX_PARALLEL_AUTOSTART];
+    unsigned int slots[MAX_PARALLEL_AUTOSTART];
+    unsigned int i, running = 0, done = 0;
+    DWORD res;
+    BYTE *state;
+
+    if (!(state = heap_alloc_zero(count)))
+    {
+        for (i = 0; i < count; i++) autostart_thread(services[i]);
+        return;
+    }
+
+    while (done < count)
+    {
+        for (i = 0; i < count && running < MAX_PARALLEL_AUTOSTART; i++)
+        {
+            if (state[i] != AUTOSTART_PENDING) continue;
+            if (!autostart_dependencies_done(services, state, count, services[i])) continue;
+
+            if (!(threads[running] = CreateThread(NULL, 0, autostart_thread, services[i], 0, NULL)))
+            {
+                autostart_thread(services[i]);
+                state[i] = AUTOSTART_DONE;
+                done++;
+                continue;
+            }
+            state[i] = AUTOSTART_RUNNING;
+            slots[running++] = i;
+        }
+
+        if (!running)
+        {
+            /* circular or unsatisfiable dependencies, start the next one anyway */
+            for (i = 0; state[i] != AUTOSTART_PENDING; i++);
+            autostart_thread(services[i]);
+            state[i] = AUTOSTART_DONE;
+            done++;
+            continue;
+        }
+
+        res = WaitForMultipleObjects(running, threads, FALSE, INFINITE);
+        if (res >= WAIT_OBJECT_0 + running)
+        {
+            WINE_ERR("failed to wait for services to start, error %u\n", GetLastError());
+            WaitForMultipleObjects(running, threads, TRUE, INFINITE);
+            while (running) CloseHandle(threads[--running]);
+            break;
+        }
+        res -= WAIT_OBJECT_0;
+        CloseHandle(threads[res]);
+        state[slots[res]] = AUTOSTART_DONE;
+        done++;
+        threads[res] = threads[--running];
+        slots[res] = slots[running];
+    }
+    heap_free(state);
+}
+
 static void scmdatabase_autostart_services(struct scmdatabase *db)
 {
     static const WCHAR rootW[] = {'R','O','O','T',0};
@@ -484,23 +591,22 @@ static void scmdatabase_autostart_services(struct scmdatabase *db)
     qsort(services_list, size, sizeof(services_list[0]), compare_tags);
     scmdatabase_lock_startup(db, INFINITE);
 
+    /* move delayed services to the front, keeping the tag order of the others */
     for (i = 0; i < size; i++)
     {
-        DWORD err;
         service = services_list[i];
         if (service->delayed_autostart)
         {
             TRACE("delayed starting %s\n", wine_dbgstr_w(service->name));
+            memmove(services_list + delayed_cnt + 1, services_list + delayed_cnt,
+                    (i - delayed_cnt) * sizeof(services_list[0]));
             services_list[delayed_cnt++] = service;
-            continue;
         }
-        err = service_start(service, 0, NULL);
-        if (err != ERROR_SUCCESS)
-            WINE_FIXME("Auto-start service %s failed to start: %d\n",
-                       wine_dbgstr_w(service->name), err);
-        release_service(service);
     }
 
+    autostart_services(services_list + delayed_cnt, size - delayed_cnt);
+    for (i = delayed_cnt; i < size; i++) release_service(services_list[i]);
+
     scmdatabase_unlock_startup(db);
 
     if (!delayed_cnt || !schedule_delayed_autostart(services_list, delayed_cnt))
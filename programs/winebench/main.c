@@ -0,0 +1,480 @@
+/*
+ * Microbenchmarks for ntdll and wineserver hot paths
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ *
+ * NOTES:
+ *  Each benchmark runs a fixed number of iterations of one operation and
+ *  is repeated a fixed number of times, so that runs on different builds
+ *  can be compared directly. The results are written to stdout as tab
+ *  separated values, one line per benchmark, with the time per operation
+ *  in nanoseconds:
+ *
+ *   name  iterations  repeats  min_ns  median_ns  max_ns
+ *
+ *  Lines starting with '#' are comments.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winbase.h"
+#include "winternl.h"
+#include "winreg.h"
+#include "winuser.h"
+
+#define BENCH_VERSION     1
+#define DEFAULT_REPEATS   5
+#define MAX_REPEATS       64
+#define ENUM_FILE_COUNT   64
+
+struct benchmark
+{
+    const char *name;
+    unsigned int iterations;
+    BOOL (*setup)(void);
+    void (*run)(unsigned int iterations);
+    void (*cleanup)(void);
+};
+
+static HANDLE bench_events[2];
+static HKEY bench_key;
+static WCHAR bench_dir[MAX_PATH];
+static WCHAR bench_file[MAX_PATH];
+static WCHAR bench_pattern[MAX_PATH];
+static CRITICAL_SECTION bench_cs;
+static SRWLOCK bench_srwlock = SRWLOCK_INIT;
+static volatile LONG bench_counter;
+
+static const WCHAR bench_keyW[] = {'S','o','f','t','w','a','r','e','\\','W','i','n','e','\\',
+                                   'W','i','n','e','B','e','n','c','h',0};
+static const WCHAR valueW[] = {'V','a','l','u','e',0};
+static const WCHAR file_fmtW[] = {'%','s','\\','f','i','l','e','%','u','.','t','x','t',0};
+
+/* server round trips */
+
+static BOOL events_setup(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(bench_events); i++)
+        if (NtCreateEvent(&bench_events[i], EVENT_ALL_ACCESS, NULL, NotificationEvent, TRUE))
+            return FALSE;
+    return TRUE;
+}
+
+static void events_cleanup(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(bench_events); i++)
+    {
+        NtClose(bench_events[i]);
+        bench_events[i] = 0;
+    }
+}
+
+static void run_event_create_close(unsigned int iterations)
+{
+    HANDLE handle;
+
+    while (iterations--)
+    {
+        NtCreateEvent(&handle, EVENT_ALL_ACCESS, NULL, NotificationEvent, FALSE);
+        NtClose(handle);
+    }
+}
+
+static void run_dup_close(unsigned int iterations)
+{
+    HANDLE handle;
+
+    while (iterations--)
+    {
+        NtDuplicateObject(GetCurrentProcess(), bench_events[0], GetCurrentProcess(), &handle,
+                          0, 0, DUPLICATE_SAME_ACCESS);
+        NtClose(handle);
+    }
+}
+
+static void run_query_object(unsigned int iterations)
+{
+    OBJECT_BASIC_INFORMATION info;
+
+    while (iterations--)
+        NtQueryObject(bench_events[0], ObjectBasicInformation, &info, sizeof(info), NULL);
+}
+
+/* waits and locks */
+
+static void run_wait_any(unsigned int iterations)
+{
+    LARGE_INTEGER timeout;
+
+    timeout.QuadPart = 0;
+    while (iterations--)
+        NtWaitForMultipleObjects(ARRAY_SIZE(bench_events), bench_events, TRUE, FALSE, &timeout);
+}
+
+static void run_wait_all(unsigned int iterations)
+{
+    LARGE_INTEGER timeout;
+
+    timeout.QuadPart = 0;
+    while (iterations--)
+        NtWaitForMultipleObjects(ARRAY_SIZE(bench_events), bench_events, FALSE, FALSE, &timeout);
+}
+
+static void run_srwlock(unsigned int iterations)
+{
+    while (iterations--)
+    {
+        AcquireSRWLockExclusive(&bench_srwlock);
+        ReleaseSRWLockExclusive(&bench_srwlock);
+    }
+}
+
+static BOOL cs_setup(void)
+{
+    InitializeCriticalSection(&bench_cs);
+    bench_counter = 0;
+    return TRUE;
+}
+
+static void cs_cleanup(void)
+{
+    DeleteCriticalSection(&bench_cs);
+}
+
+static void run_critsec(unsigned int iterations)
+{
+    while (iterations--)
+    {
+        EnterCriticalSection(&bench_cs);
+        LeaveCriticalSection(&bench_cs);
+    }
+}
+
+static DWORD WINAPI critsec_thread(void *arg)
+{
+    unsigned int iterations = (UINT_PTR)arg;
+
+    while (iterations--)
+    {
+        EnterCriticalSection(&bench_cs);
+        bench_counter++;
+        LeaveCriticalSection(&bench_cs);
+    }
+    return 0;
+}
+
+/* two threads hammering the same critical section; iterations counts the
+ * operations of both threads together */
+static void run_critsec_contended(unsigned int iterations)
+{
+    HANDLE threads[2];
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+        threads[i] = CreateThread(NULL, 0, critsec_thread,
+                                  (void *)(UINT_PTR)(iterations / ARRAY_SIZE(threads)), 0, NULL);
+    WaitForMultipleObjects(ARRAY_SIZE(threads), threads, TRUE, INFINITE);
+    for (i = 0; i < ARRAY_SIZE(threads); i++)
+        CloseHandle(threads[i]);
+}
+
+/* heap */
+
+static void run_heap_small(unsigned int iterations)
+{
+    HANDLE heap = GetProcessHeap();
+
+    while (iterations--)
+        RtlFreeHeap(heap, 0, RtlAllocateHeap(heap, 0, 64));
+}
+
+static void run_heap_mixed(unsigned int iterations)
+{
+    static const SIZE_T sizes[] = {16, 200, 24, 4096, 48, 1000, 8, 70000};
+    HANDLE heap = GetProcessHeap();
+    void *ptrs[ARRAY_SIZE(sizes)];
+    unsigned int i;
+
+    while (iterations)
+    {
+        for (i = 0; i < ARRAY_SIZE(sizes) && iterations; i++, iterations--)
+            ptrs[i] = RtlAllocateHeap(heap, 0, sizes[i]);
+        while (i--)
+            RtlFreeHeap(heap, 0, ptrs[i]);
+    }
+}
+
+/* files */
+
+static BOOL files_setup(void)
+{
+    static const WCHAR dirW[] = {'w','i','n','e','b','e','n','c','h',0};
+    static const WCHAR patternW[] = {'%','s','\\','*',0};
+    WCHAR path[MAX_PATH];
+    unsigned int i;
+    HANDLE file;
+
+    GetTempPathW(ARRAY_SIZE(bench_dir), bench_dir);
+    lstrcatW(bench_dir, dirW);
+    CreateDirectoryW(bench_dir, NULL);
+
+    for (i = 0; i < ENUM_FILE_COUNT; i++)
+    {
+        wsprintfW(path, file_fmtW, bench_dir, i);
+        file = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+        if (file == INVALID_HANDLE_VALUE) return FALSE;
+        CloseHandle(file);
+    }
+    wsprintfW(bench_file, file_fmtW, bench_dir, 0);
+    wsprintfW(bench_pattern, patternW, bench_dir);
+    return TRUE;
+}
+
+static void files_cleanup(void)
+{
+    WCHAR path[MAX_PATH];
+    unsigned int i;
+
+    for (i = 0; i < ENUM_FILE_COUNT; i++)
+    {
+        wsprintfW(path, file_fmtW, bench_dir, i);
+        DeleteFileW(path);
+    }
+    RemoveDirectoryW(bench_dir);
+}
+
+static void run_file_open(unsigned int iterations)
+{
+    while (iterations--)
+        CloseHandle(CreateFileW(bench_file, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                NULL, OPEN_EXISTING, 0, NULL));
+}
+
+static void run_file_stat(unsigned int iterations)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+
+    while (iterations--)
+        GetFileAttributesExW(bench_file, GetFileExInfoStandard, &data);
+}
+
+/* one iteration enumerates the whole directory */
+static void run_file_enum(unsigned int iterations)
+{
+    WIN32_FIND_DATAW data;
+    HANDLE find;
+
+    while (iterations--)
+    {
+        if ((find = FindFirstFileW(bench_pattern, &data)) == INVALID_HANDLE_VALUE) continue;
+        while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+}
+
+/* registry */
+
+static BOOL reg_setup(void)
+{
+    DWORD value = 42;
+
+    if (RegCreateKeyExW(HKEY_CURRENT_USER, bench_keyW, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &bench_key, NULL))
+        return FALSE;
+    return !RegSetValueExW(bench_key, valueW, 0, REG_DWORD, (const BYTE *)&value, sizeof(value));
+}
+
+static void reg_cleanup(void)
+{
+    RegCloseKey(bench_key);
+    RegDeleteKeyW(HKEY_CURRENT_USER, bench_keyW);
+}
+
+static void run_reg_query(unsigned int iterations)
+{
+    DWORD value, size;
+
+    while (iterations--)
+    {
+        size = sizeof(value);
+        RegQueryValueExW(bench_key, valueW, NULL, NULL, (BYTE *)&value, &size);
+    }
+}
+
+static void run_reg_open(unsigned int iterations)
+{
+    HKEY key;
+
+    while (iterations--)
+    {
+        if (!RegOpenKeyExW(HKEY_CURRENT_USER, bench_keyW, 0, KEY_READ, &key))
+            RegCloseKey(key);
+    }
+}
+
+/* messages */
+
+static BOOL msg_setup(void)
+{
+    MSG msg;
+
+    /* make sure the thread has a message queue */
+    PeekMessageW(&msg, NULL, 0, 0, PM_NOREMOVE);
+    return TRUE;
+}
+
+static void run_post_message(unsigned int iterations)
+{
+    DWORD tid = GetCurrentThreadId();
+    MSG msg;
+
+    while (iterations--)
+    {
+        PostThreadMessageW(tid, WM_USER, 0, 0);
+        PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE);
+    }
+}
+
+static const struct benchmark benchmarks[] =
+{
+    { "event_create_close",  20000, NULL,         run_event_create_close, NULL },
+    { "dup_close",           20000, events_setup, run_dup_close,          events_cleanup },
+    { "query_object",        20000, events_setup, run_query_object,       events_cleanup },
+    { "wait_any",            20000, events_setup, run_wait_any,           events_cleanup },
+    { "wait_all",            20000, events_setup, run_wait_all,           events_cleanup },
+    { "srwlock",           1000000, NULL,         run_srwlock,            NULL },
+    { "critsec",           1000000, cs_setup,     run_critsec,            cs_cleanup },
+    { "critsec_contended",  200000, cs_setup,     run_critsec_contended,  cs_cleanup },
+    { "heap_small",        1000000, NULL,         run_heap_small,         NULL },
+    { "heap_mixed",         200000, NULL,         run_heap_mixed,         NULL },
+    { "file_open",           5000, files_setup,  run_file_open,          files_cleanup },
+    { "file_stat",           5000, files_setup,  run_file_stat,          files_cleanup },
+    { "file_enum",            500, files_setup,  run_file_enum,          files_cleanup },
+    { "reg_query",           20000, reg_setup,    run_reg_query,          reg_cleanup },
+    { "reg_open",            20000, reg_setup,    run_reg_open,           reg_cleanup },
+    { "post_message",        20000, msg_setup,    run_post_message,       NULL },
+};
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run_benchmark(const struct benchmark *bench, unsigned int repeats, double scale)
+{
+    unsigned int iterations = max(1, (unsigned int)(bench->iterations * scale));
+    double results[MAX_REPEATS];
+    LARGE_INTEGER freq, start, end;
+    unsigned int i;
+
+    if (bench->setup && !bench->setup())
+    {
+        printf("# %s: setup failed, error %u\n", bench->name, GetLastError());
+        if (bench->cleanup) bench->cleanup();
+        return;
+    }
+
+    QueryPerformanceFrequency(&freq);
+
+    /* warm up caches and lazily initialized state first */
+    bench->run(min(iterations, 100));
+
+    for (i = 0; i < repeats; i++)
+    {
+        QueryPerformanceCounter(&start);
+        bench->run(iterations);
+        QueryPerformanceCounter(&end);
+        results[i] = (double)(end.QuadPart - start.QuadPart) * 1e9 / freq.QuadPart / iterations;
+    }
+
+    if (bench->cleanup) bench->cleanup();
+
+    qsort(results, repeats, sizeof(results[0]), compare_double);
+    printf("%s\t%u\t%u\t%.1f\t%.1f\t%.1f\n", bench->name, iterations, repeats,
+           results[0], results[repeats / 2], results[repeats - 1]);
+    fflush(stdout);
+}
+
+static void usage(void)
+{
+    unsigned int i;
+
+    printf("Usage: winebench [-r repeats] [-s scale] [-l] [benchmark...]\n\n");
+    printf("  -r repeats  number of timed runs of each benchmark (default %u)\n", DEFAULT_REPEATS);
+    printf("  -s scale    multiply the iteration counts by scale\n");
+    printf("  -l          list the available benchmarks\n\n");
+    printf("Benchmarks:\n");
+    for (i = 0; i < ARRAY_SIZE(benchmarks); i++)
+        printf("  %s\n", benchmarks[i].name);
+}
+
+int __cdecl main(int argc, char *argv[])
+{
+    unsigned int repeats = DEFAULT_REPEATS;
+    double scale = 1.0;
+    BOOL selected;
+    unsigned int i;
+    int arg, first;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if (!strcmp(argv[arg], "-r") && arg + 1 < argc)
+            repeats = atoi(argv[++arg]);
+        else if (!strcmp(argv[arg], "-s") && arg + 1 < argc)
+            scale = atof(argv[++arg]);
+        else if (!strcmp(argv[arg], "-l"))
+        {
+            for (i = 0; i < ARRAY_SIZE(benchmarks); i++)
+                printf("%s\n", benchmarks[i].name);
+            return 0;
+        }
+        else if (argv[arg][0] == '-')
+        {
+            usage();
+            return 1;
+        }
+        else break;
+    }
+    first = arg;
+
+    if (!repeats || repeats > MAX_REPEATS || scale <= 0.0)
+    {
+        usage();
+        return 1;
+    }
+
+    printf("# winebench version=%u repeats=%u scale=%g\n", BENCH_VERSION, repeats, scale);
+    printf("# name\titerations\trepeats\tmin_ns\tmedian_ns\tmax_ns\n");
+
+    for (i = 0; i < ARRAY_SIZE(benchmarks); i++)
+    {
+        selected = first == argc;
+        for (arg = first; arg < argc && !selected; arg++)
+            selected = !strcmp(argv[arg], benchmarks[i].name);
+        if (selected) run_benchmark(&benchmarks[i], repeats, scale);
+    }
+
+    return 0;
+}
@@ -1550,25 +1550,31 @@ static void update_wineprefix( BOOL force )
 
     if (update_timestamp( config_dir, st.st_mtime ) || force)
     {
-        HANDLE process;
+        HANDLE processes[2];
         DWORD count = 0;
 
-        if ((process = start_rundll32( inf_path, FALSE )))
+        /* the native and wow64 installs write to separate directories and registry views,
+         * run them in parallel */
+        if ((processes[count] = start_rundll32( inf_path, FALSE ))) count++;
+        if ((processes[count] = start_rundll32( inf_path, TRUE ))) count++;
+
+/*        HWND hwnd = show_wait_window();*/
+        while (count)
         {
-/*            HWND hwnd = show_wait_window();*/
-            for (;;)
+            MSG msg;
+            DWORD res = MsgWaitForMultipleObjects( count, processes, FALSE, INFINITE, QS_ALLINPUT );
+            if (res < WAIT_OBJECT_0 + count)
+            {
+                CloseHandle( processes[res - WAIT_OBJECT_0] );
+                processes[res - WAIT_OBJECT_0] = processes[--count];
+            }
+            else if (res == WAIT_OBJECT_0 + count)
             {
-                MSG msg;
-                DWORD res = MsgWaitForMultipleObjects( 1, &process, FALSE, INFINITE, QS_ALLINPUT );
-                if (res == WAIT_OBJECT_0)
-                {
-                    CloseHandle( process );
-                    if (count++ || !(process = start_rundll32( inf_path, TRUE ))) break;
-                }
-                else while (PeekMessageW( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageW( &msg );
+                while (PeekMessageW( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageW( &msg );
             }
-/*            DestroyWindow( hwnd );*/
+            else while (count) CloseHandle( processes[--count] );
         }
+/*        DestroyWindow( hwnd );*/
         install_root_pnp_devices();
         update_user_profile();
         update_win_version();
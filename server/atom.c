@@ -361,6 +361,19 @@ void release_global_atom( struct winstation *winstation, atom_t atom )
     }
 }
 
+/* retrieve the name of a global string atom; used for window properties */
+const WCHAR *get_global_atom_name( struct winstation *winstation, atom_t atom, data_size_t *len )
+{
+    struct atom_table *table;
+    struct atom_entry *entry;
+
+    if (atom < MIN_STR_ATOM) return NULL;
+    if (!(table = get_global_table( winstation, 0 ))) return NULL;
+    if (atom > MIN_STR_ATOM + table->last || !(entry = table->handles[atom - MIN_STR_ATOM])) return NULL;
+    *len = entry->len;
+    return entry->str;
+}
+
 /* add a global atom */
 DECL_HANDLER(add_atom)
 {
@@ -93,6 +93,7 @@ struct dir
     int            subtree;  /* do we want to watch subdirectories? */
     struct list    change_records;   /* data for the change */
     struct list    in_entry; /* entry in the inode dirs list */
+    struct list    wake_entry; /* entry in the list of dirs to wake up after an inotify read */
     struct inode  *inode;    /* inode of the associated directory */
     struct process *client_process;  /* client process that has a cache for this directory */
     int             client_entry;    /* entry in client process cache */
@@ -660,6 +661,9 @@ static int inotify_get_poll_events( struct fd *fd )
     return POLLIN;
 }
 
+/* dirs with new changes, woken up once all events of a read have been processed */
+static struct list wake_list = LIST_INIT(wake_list);
+
 static void inotify_do_change_notify( struct dir *dir, unsigned int action,
                                       unsigned int cookie, const char *relpath )
 {
@@ -670,6 +674,16 @@ static void inotify_do_change_notify( struct dir *dir, unsigned int action,
     if (dir->want_data)
     {
         size_t len = strlen(relpath);
+
+        /* writes typically generate a burst of identical modification events */
+        if (action == FILE_ACTION_MODIFIED && !list_empty( &dir->change_records ))
+        {
+            record = LIST_ENTRY( list_tail( &dir->change_records ), struct change_record, entry );
+            if (record->event.action == action && record->event.len == len &&
+                !memcmp( record->event.name, relpath, len ))
+                return;
+        }
+
         record = malloc( offsetof(struct change_record, event.name[len]) );
         if (!record)
             return;
@@ -682,7 +696,27 @@ static void inotify_do_change_notify( struct dir *dir, unsigned int action,
         list_add_tail( &dir->change_records, &record->entry );
     }
 
-    fd_async_wake_up( dir->fd, ASYNC_TYPE_WAIT, STATUS_ALERTED );
+    if (list_empty( &dir->wake_entry ))
+    {
+        grab_object( dir );
+        list_add_tail( &wake_list, &dir->wake_entry );
+    }
+}
+
+/* complete pending waits once per read, so that they get all the changes at once */
+static void inotify_wake_dirs(void)
+{
+    struct list *ptr;
+
+    while ((ptr = list_head( &wake_list )))
+    {
+        struct dir *dir = LIST_ENTRY( ptr, struct dir, wake_entry );
+
+        list_remove( &dir->wake_entry );
+        list_init( &dir->wake_entry );
+        fd_async_wake_up( dir->fd, ASYNC_TYPE_WAIT, STATUS_ALERTED );
+        release_object( dir );
+    }
 }
 
 static unsigned int filter_from_event( struct inotify_event *ie )
@@ -901,6 +935,7 @@ static void inotify_poll_event( struct fd *fd, int event )
         if (ofs > r) break;
         if (ie->len) inotify_notify_all( ie );
     }
+    inotify_wake_dirs();
 }
 
 static inline struct fd *create_inotify_fd( void )
@@ -1135,6 +1170,7 @@ struct object *create_dir_obj( struct fd *fd, unsigned int access, mode_t mode )
         return NULL;
 
     list_init( &dir->change_records );
+    list_init( &dir->wake_entry );
     dir->filter = 0;
     dir->notified = 0;
     dir->want_data = 0;
@@ -250,7 +250,7 @@ static void directory_destroy( struct object *obj )
 {
     struct directory *dir = (struct directory *)obj;
     assert( obj->ops == &directory_ops );
-    free( dir->entries );
+    free_namespace( dir->entries );
 }
 
 static struct directory *create_directory( struct object *root, const struct unicode_str *name,
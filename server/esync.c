@@ -172,12 +172,28 @@ static unsigned int esync_map_access( struct object *obj, unsigned int access )
     return access & ~(GENERIC_READ | GENERIC_WRITE | GENERIC_EXECUTE | GENERIC_ALL);
 }
 
+/* Eventfds of destroyed objects are kept around for reuse, which saves
+ * creating a new one for applications that churn through events. Semaphores
+ * use EFD_SEMAPHORE, which can't be changed afterwards, so they're not pooled. */
+#define ESYNC_FD_POOL_SIZE 64
+
+static int fd_pool[ESYNC_FD_POOL_SIZE];
+static unsigned int fd_pool_count;
+
 static void esync_destroy( struct object *obj )
 {
     struct esync *esync = (struct esync *)obj;
     if (esync->type == ESYNC_MUTEX)
         list_remove( &esync->mutex_entry );
-    close( esync->fd );
+
+    if (esync->type != ESYNC_SEMAPHORE && fd_pool_count < ESYNC_FD_POOL_SIZE)
+    {
+        /* without EFD_SEMAPHORE a single read resets the counter */
+        esync_clear( esync->fd );
+        fd_pool[fd_pool_count++] = esync->fd;
+    }
+    else
+        close( esync->fd );
 }
 
 static int type_matches( enum esync_type type1, enum esync_type type2 )
@@ -261,7 +277,18 @@ struct esync *create_esync( struct object *root, const struct unicode_str *name,
                 flags |= EFD_SEMAPHORE;
 
             /* initialize it if it didn't already exist */
-            esync->fd = eventfd( initval, flags );
+            if (type != ESYNC_SEMAPHORE && fd_pool_count)
+            {
+                esync->fd = fd_pool[--fd_pool_count];
+                if (initval)
+                {
+                    uint64_t value = initval;
+                    if (write( esync->fd, &value, sizeof(value) ) == -1)
+                        perror( "esync: write" );
+                }
+            }
+            else
+                esync->fd = eventfd( initval, flags );
             if (esync->fd == -1)
             {
                 perror( "eventfd" );
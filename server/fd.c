@@ -21,6 +21,7 @@
 
 #include "config.h"
 #include "wine/port.h"
+#include "wine/rbtree.h"
 
 #include <assert.h>
 #include <dirent.h>
@@ -162,6 +163,14 @@ static inline int epoll_wait( int epfd, struct epoll_event *events, int maxevent
 # define USE_EVENT_PORTS
 #endif /* HAVE_PORT_H && HAVE_PORT_CREATE */
 
+#if defined(USE_EPOLL) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+# include <sys/mman.h>
+# include <linux/io_uring.h>
+# ifdef IORING_FEAT_EXT_ARG
+#  define USE_IO_URING
+# endif
+#endif
+
 /* Because of the stupid Posix locking semantics, we need to keep
  * track of all file descriptors referencing a given file, and not
  * close a single one until all the locks are gone (sigh).
@@ -389,14 +398,42 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    struct wine_rb_entry  rb_entry;   /* entry in timeout tree */
+    struct wine_rb_tree  *tree;       /* tree containing the timeout, NULL once expired */
+    struct list           entry;      /* entry in expired list */
     abstime_t             when;       /* timeout expiry */
+    unsigned int          serial;     /* insertion order, newest first for equal expiry */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list abs_timeout_list = LIST_INIT(abs_timeout_list); /* sorted absolute timeouts list */
-static struct list rel_timeout_list = LIST_INIT(rel_timeout_list); /* sorted relative timeouts list */
+static int compare_timeout_serial( const struct timeout_user *key, const struct timeout_user *timeout )
+{
+    if (key->serial == timeout->serial) return 0;
+    return (int)(timeout->serial - key->serial);
+}
+
+static int compare_abs_timeout( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct timeout_user *user = key;
+    const struct timeout_user *timeout = WINE_RB_ENTRY_VALUE( entry, const struct timeout_user, rb_entry );
+
+    if (user->when != timeout->when) return user->when < timeout->when ? -1 : 1;
+    return compare_timeout_serial( user, timeout );
+}
+
+static int compare_rel_timeout( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct timeout_user *user = key;
+    const struct timeout_user *timeout = WINE_RB_ENTRY_VALUE( entry, const struct timeout_user, rb_entry );
+
+    if (user->when != timeout->when) return user->when > timeout->when ? -1 : 1;
+    return compare_timeout_serial( user, timeout );
+}
+
+static struct wine_rb_tree abs_timeout_tree = { compare_abs_timeout }; /* absolute timeouts by expiry */
+static struct wine_rb_tree rel_timeout_tree = { compare_rel_timeout }; /* relative timeouts by expiry */
+static unsigned int timeout_serial;
 timeout_t current_time;
 timeout_t monotonic_time;
 
@@ -454,42 +491,43 @@ void set_current_time(void)
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
 
     if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
     user->when     = timeout_to_abstime( when );
+    user->serial   = timeout_serial++;
     user->callback = func;
     user->private  = private;
 
-    /* Now insert it in the linked list */
+    /* Now insert it in the tree, the serial number makes the key unique */
 
-    if (user->when > 0)
-    {
-        LIST_FOR_EACH( ptr, &abs_timeout_list )
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when >= user->when) break;
-        }
-    }
-    else
-    {
-        LIST_FOR_EACH( ptr, &rel_timeout_list )
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when <= user->when) break;
-        }
-    }
-    list_add_before( ptr, &user->entry );
+    user->tree = user->when > 0 ? &abs_timeout_tree : &rel_timeout_tree;
+    wine_rb_put( user->tree, user, &user->rb_entry );
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
+    if (user->tree) wine_rb_remove( user->tree, &user->rb_entry );
+    else list_remove( &user->entry );
     free( user );
 }
 
+/* return the first timeout to expire in a tree */
+static struct timeout_user *get_first_timeout( struct wine_rb_tree *tree )
+{
+    struct wine_rb_entry *entry = wine_rb_head( tree->root );
+    return entry ? WINE_RB_ENTRY_VALUE( entry, struct timeout_user, rb_entry ) : NULL;
+}
+
+/* move a timeout from its tree to the expired list */
+static void expire_timeout( struct timeout_user *timeout, struct list *expired_list )
+{
+    wine_rb_remove( timeout->tree, &timeout->rb_entry );
+    timeout->tree = NULL;
+    list_add_tail( expired_list, &timeout->entry );
+}
+
 /* return a text description of a timeout for debugging purposes */
 const char *get_timeout_str( timeout_t timeout )
 {
@@ -543,12 +581,273 @@ static inline void fd_poll_event( struct fd *fd, int event )
     fd->fd_ops->poll_event( fd, event );
 }
 
+#ifdef USE_IO_URING
+
+/* io_uring backend: poll requests are one-shot, and all the changes done while
+ * processing events are submitted together with the next wait, so that the
+ * whole loop iteration costs a single syscall. */
+
+#define URING_ENTRIES     256
+#define URING_CQ_ENTRIES  4096
+#define URING_IGNORE      (~(__u64)0)
+
+static int uring_fd = -1;
+static unsigned int uring_to_submit;        /* number of queued but not submitted sqes */
+static unsigned int *uring_gens;            /* generation of the armed poll of each user, 0 if none */
+static int uring_gens_size;
+static unsigned int uring_gen;              /* last generation used */
+
+static struct
+{
+    unsigned int *head, *tail, *mask, *entries, *array;
+    struct io_uring_sqe *sqes;
+} uring_sq;
+
+static struct
+{
+    unsigned int *head, *tail, *mask;
+    struct io_uring_cqe *cqes;
+} uring_cq;
+
+static inline int io_uring_setup( unsigned int entries, struct io_uring_params *params )
+{
+    return syscall( __NR_io_uring_setup, entries, params );
+}
+
+static inline int io_uring_enter( int fd, unsigned int to_submit, unsigned int min_complete,
+                                  unsigned int flags, void *arg, size_t size )
+{
+    return syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, size );
+}
+
+static int init_io_uring(void)
+{
+    struct io_uring_params params;
+    size_t sq_size, cq_size;
+    char *sq_ring, *cq_ring;
+    void *sqes;
+    const char *env = getenv( "WINEIOURING" );
+
+    if (!env || !atoi( env )) return 0;
+
+    memset( &params, 0, sizeof(params) );
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_CQ_ENTRIES;
+    if ((uring_fd = io_uring_setup( URING_ENTRIES, &params )) == -1) return 0;
+
+    /* we need to wait with a timeout, and we can't afford losing completions */
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP) ||
+        !(params.features & IORING_FEAT_SINGLE_MMAP))
+        goto failed;
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (cq_size > sq_size) sq_size = cq_size;
+
+    sq_ring = mmap( NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    uring_fd, IORING_OFF_SQ_RING );
+    if (sq_ring == MAP_FAILED) goto failed;
+    cq_ring = sq_ring;
+
+    sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, uring_fd, IORING_OFF_SQES );
+    if (sqes == MAP_FAILED)
+    {
+        munmap( sq_ring, sq_size );
+        goto failed;
+    }
+
+    uring_sq.head    = (unsigned int *)(sq_ring + params.sq_off.head);
+    uring_sq.tail    = (unsigned int *)(sq_ring + params.sq_off.tail);
+    uring_sq.mask    = (unsigned int *)(sq_ring + params.sq_off.ring_mask);
+    uring_sq.entries = (unsigned int *)(sq_ring + params.sq_off.ring_entries);
+    uring_sq.array   = (unsigned int *)(sq_ring + params.sq_off.array);
+    uring_sq.sqes    = sqes;
+    uring_cq.head    = (unsigned int *)(cq_ring + params.cq_off.head);
+    uring_cq.tail    = (unsigned int *)(cq_ring + params.cq_off.tail);
+    uring_cq.mask    = (unsigned int *)(cq_ring + params.cq_off.ring_mask);
+    uring_cq.cqes    = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+    return 1;
+
+failed:
+    close( uring_fd );
+    uring_fd = -1;
+    return 0;
+}
+
+/* submit the queued sqes, optionally waiting for a completion */
+static int uring_submit( int wait, int timeout )
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    unsigned int flags = 0;
+    int ret;
+
+    memset( &arg, 0, sizeof(arg) );
+    if (wait)
+    {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (timeout != -1)
+        {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+            arg.ts = (unsigned long)&ts;
+        }
+    }
+
+    ret = io_uring_enter( uring_fd, uring_to_submit, wait ? 1 : 0, flags,
+                          wait ? &arg : NULL, wait ? sizeof(arg) : 0 );
+    if (ret >= 0) uring_to_submit -= min( ret, uring_to_submit );
+    else if (errno != EINTR && errno != ETIME && errno != EBUSY) perror( "io_uring_enter" );
+    return ret;
+}
+
+static struct io_uring_sqe *uring_get_sqe(void)
+{
+    unsigned int tail = *uring_sq.tail, idx;
+    struct io_uring_sqe *sqe;
+
+    /* the ring is full, flush it to the kernel */
+    while (tail - __atomic_load_n( uring_sq.head, __ATOMIC_ACQUIRE ) >= *uring_sq.entries)
+        if (uring_submit( 0, 0 ) == -1 && errno != EINTR) return NULL;
+
+    idx = tail & *uring_sq.mask;
+    sqe = &uring_sq.sqes[idx];
+    memset( sqe, 0, sizeof(*sqe) );
+    uring_sq.array[idx] = idx;
+    __atomic_store_n( uring_sq.tail, tail + 1, __ATOMIC_RELEASE );
+    uring_to_submit++;
+    return sqe;
+}
+
+static inline __u64 uring_user_data( int user, unsigned int gen )
+{
+    return ((__u64)user << 32) | gen;
+}
+
+static void uring_arm_poll( struct fd *fd, int user, int events )
+{
+    struct io_uring_sqe *sqe;
+
+    if (user >= uring_gens_size)
+    {
+        int new_size = max( allocated_users, user + 1 );
+        unsigned int *new_gens;
+
+        if (!(new_gens = realloc( uring_gens, new_size * sizeof(*uring_gens) ))) return;
+        memset( new_gens + uring_gens_size, 0, (new_size - uring_gens_size) * sizeof(*uring_gens) );
+        uring_gens = new_gens;
+        uring_gens_size = new_size;
+    }
+    if (!(sqe = uring_get_sqe())) return;
+
+    if (!++uring_gen) ++uring_gen;  /* 0 means not armed */
+    uring_gens[user] = uring_gen;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd->unix_fd;
+    sqe->poll_events = events;
+    sqe->user_data = uring_user_data( user, uring_gen );
+}
+
+static void uring_disarm_poll( int user )
+{
+    struct io_uring_sqe *sqe;
+
+    if (user >= uring_gens_size || !uring_gens[user]) return;
+    if (!(sqe = uring_get_sqe())) return;
+
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->addr = uring_user_data( user, uring_gens[user] );
+    sqe->user_data = URING_IGNORE;
+    uring_gens[user] = 0;  /* completions of the old request are now ignored */
+}
+
+static inline int uring_is_armed( int user )
+{
+    return user < uring_gens_size && uring_gens[user];
+}
+
+/* set the events that io_uring polls for on this fd; helper for set_fd_events */
+static void set_fd_uring_events( struct fd *fd, int user, int events )
+{
+    if (events == -1)  /* stop waiting on this fd completely */
+    {
+        uring_disarm_poll( user );
+        return;
+    }
+    if (pollfd[user].fd == -1 && pollfd[user].events) return;  /* stopped waiting on it, don't restart */
+    if (uring_is_armed( user ))
+    {
+        if (pollfd[user].events == events) return;  /* nothing to do */
+        uring_disarm_poll( user );
+    }
+    uring_arm_poll( fd, user, events );
+}
+
+static void main_loop_uring(void)
+{
+    int users[128];
+    int i, count, timeout;
+
+    while (active_users)
+    {
+        unsigned int head, tail;
+
+        timeout = get_next_timeout();
+
+        if (!active_users) break;  /* last user removed by a timeout */
+
+        head = *uring_cq.head;
+        if (head == __atomic_load_n( uring_cq.tail, __ATOMIC_ACQUIRE ) || uring_to_submit)
+            uring_submit( 1, timeout );
+        set_current_time();
+
+        /* put the events into the pollfd array first, like poll does */
+        tail = __atomic_load_n( uring_cq.tail, __ATOMIC_ACQUIRE );
+        for (count = 0; head != tail && count < ARRAY_SIZE(users); head++)
+        {
+            struct io_uring_cqe *cqe = &uring_cq.cqes[head & *uring_cq.mask];
+            int user = cqe->user_data >> 32;
+            unsigned int gen = cqe->user_data;
+
+            if (cqe->user_data == URING_IGNORE) continue;
+            if (user >= uring_gens_size || uring_gens[user] != gen) continue;  /* stale */
+
+            uring_gens[user] = 0;  /* one-shot poll has completed */
+            pollfd[user].revents = cqe->res < 0 ? POLLERR : cqe->res;
+            users[count++] = user;
+        }
+        __atomic_store_n( uring_cq.head, head, __ATOMIC_RELEASE );
+
+        /* read events from the pollfd array, as set_fd_events may modify them */
+        for (i = 0; i < count; i++)
+        {
+            int user = users[i];
+            if (pollfd[user].revents) fd_poll_event( poll_users[user], pollfd[user].revents );
+        }
+
+        /* rearm the users that are still interested in events */
+        for (i = 0; i < count; i++)
+        {
+            int user = users[i];
+            if (pollfd[user].fd == -1 || uring_is_armed( user )) continue;
+            uring_arm_poll( poll_users[user], user, pollfd[user].events );
+        }
+    }
+}
+
+#endif /* USE_IO_URING */
+
 #ifdef USE_EPOLL
 
 static int epoll_fd = -1;
 
 static inline void init_epoll(void)
 {
+#ifdef USE_IO_URING
+    if (init_io_uring()) return;
+#endif
     epoll_fd = epoll_create( 128 );
 }
 
@@ -558,6 +857,13 @@ static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
     struct epoll_event ev;
     int ctl;
 
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        set_fd_uring_events( fd, user, events );
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     if (events == -1)  /* stop waiting on this fd completely */
@@ -593,6 +899,13 @@ static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
 
 static inline void remove_epoll_user( struct fd *fd, int user )
 {
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        uring_disarm_poll( user );
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     if (pollfd[user].fd != -1)
@@ -612,6 +925,13 @@ static inline void main_loop_epoll(void)
     assert( POLLERR == EPOLLERR );
     assert( POLLHUP == EPOLLHUP );
 
+#ifdef USE_IO_URING
+    if (uring_fd != -1)
+    {
+        main_loop_uring();
+        return;
+    }
+#endif
     if (epoll_fd == -1) return;
 
     while (active_users)
@@ -934,58 +1254,39 @@ static int get_next_timeout(void)
 {
     int ret = user_shared_data ? user_shared_data_timeout : -1;
 
-    if (!list_empty( &abs_timeout_list ) || !list_empty( &rel_timeout_list ))
+    if (abs_timeout_tree.root || rel_timeout_tree.root)
     {
+        struct timeout_user *timeout;
         struct list expired_list, *ptr;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the trees */
 
         list_init( &expired_list );
-        while ((ptr = list_head( &abs_timeout_list )) != NULL)
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
-        }
-        while ((ptr = list_head( &rel_timeout_list )) != NULL)
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (-timeout->when <= monotonic_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
-        }
+        while ((timeout = get_first_timeout( &abs_timeout_tree )) && timeout->when <= current_time)
+            expire_timeout( timeout, &expired_list );
+        while ((timeout = get_first_timeout( &rel_timeout_tree )) && -timeout->when <= monotonic_time)
+            expire_timeout( timeout, &expired_list );
 
         /* now call the callback for all the removed timers */
 
         while ((ptr = list_head( &expired_list )) != NULL)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
             list_remove( &timeout->entry );
             timeout->callback( timeout->private );
             free( timeout );
         }
 
-        if ((ptr = list_head( &abs_timeout_list )) != NULL)
+        if ((timeout = get_first_timeout( &abs_timeout_tree )))
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
             timeout_t diff = (timeout->when - current_time + 9999) / 10000;
             if (diff > INT_MAX) diff = INT_MAX;
             else if (diff < 0) diff = 0;
             if (ret == -1 || diff < ret) ret = diff;
         }
 
-        if ((ptr = list_head( &rel_timeout_list )) != NULL)
+        if ((timeout = get_first_timeout( &rel_timeout_tree )))
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
             timeout_t diff = (-timeout->when - monotonic_time + 9999) / 10000;
             if (diff > INT_MAX) diff = INT_MAX;
             else if (diff < 0) diff = 0;
@@ -3057,14 +3358,21 @@ DECL_HANDLER(set_completion_info)
     }
 }
 
+/* push new completion msg into the completion queue attached to the fd, if any */
+void fd_add_completion( struct fd *fd, apc_param_t cvalue, unsigned int status,
+                        apc_param_t information, int async )
+{
+    if (fd->completion && (async || !(fd->comp_flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS)))
+        add_completion( fd->completion, fd->comp_key, cvalue, status, information );
+}
+
 /* push new completion msg into a completion queue attached to the fd */
 DECL_HANDLER(add_fd_completion)
 {
     struct fd *fd = get_handle_fd_obj( current->process, req->handle, 0 );
     if (fd)
     {
-        if (fd->completion && (req->async || !(fd->comp_flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS)))
-            add_completion( fd->completion, fd->comp_key, req->cvalue, req->status, req->information );
+        fd_add_completion( fd, req->cvalue, req->status, req->information, req->async );
         release_object( fd );
     }
 }
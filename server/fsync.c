@@ -353,6 +353,18 @@ void fsync_wake_futex( unsigned int shm_idx )
         futex_wake( &event->signaled, INT_MAX );
 }
 
+/* store a value readable by clients without waking anybody */
+void fsync_store_shm( unsigned int shm_idx, int value )
+{
+    int *shm;
+
+    if (!shm_idx)
+        return;
+
+    shm = get_shm( shm_idx );
+    __atomic_store_n( &shm[0], value, __ATOMIC_SEQ_CST );
+}
+
 void fsync_wake_up( struct object *obj )
 {
     enum fsync_type type;
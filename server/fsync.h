@@ -23,6 +23,7 @@ extern void fsync_init(void);
 extern unsigned int fsync_alloc_shm( int low, int high );
 extern void fsync_wake_futex( unsigned int shm_idx );
 extern void fsync_clear_futex( unsigned int shm_idx );
+extern void fsync_store_shm( unsigned int shm_idx, int value );
 extern void fsync_wake_up( struct object *obj );
 extern void fsync_clear( struct object *obj );
 
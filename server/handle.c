@@ -27,12 +27,17 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
 #include "windef.h"
 #include "winternl.h"
 
+#include "file.h"
 #include "handle.h"
 #include "process.h"
 #include "thread.h"
@@ -53,6 +58,9 @@ struct handle_table
     int                  last;        /* last used entry */
     int                  free;        /* first entry that may be free */
     struct handle_entry *entries;     /* handle entries */
+    int                  shared_fd;   /* fd of the table copy shared with the client */
+    int                  shared_count; /* number of entries in the shared copy */
+    struct shared_handle_entry *shared; /* mapping of the shared copy */
 };
 
 static struct handle_table *global_table;
@@ -97,6 +105,81 @@ static inline obj_handle_t handle_global_to_local( obj_handle_t handle )
     return handle ^ HANDLE_OBFUSCATOR;
 }
 
+/* create the copy of a process handle table that is shared read-only with the client */
+static void init_shared_table( struct handle_table *table )
+{
+    void *ptr;
+
+    table->shared_fd    = -1;
+    table->shared_count = 0;
+    table->shared       = NULL;
+    if (!table->process) return;
+    if ((table->shared_fd = create_temp_file( table->count * sizeof(*table->shared) )) == -1)
+    {
+        clear_error();  /* no shared table is not fatal, the client will use the server */
+        return;
+    }
+    ptr = mmap( NULL, table->count * sizeof(*table->shared), PROT_READ | PROT_WRITE,
+                MAP_SHARED, table->shared_fd, 0 );
+    if (ptr == MAP_FAILED)
+    {
+        close( table->shared_fd );
+        table->shared_fd = -1;
+        return;
+    }
+    table->shared       = ptr;
+    table->shared_count = table->count;
+}
+
+/* free the shared copy of the handle table */
+static void free_shared_table( struct handle_table *table )
+{
+    if (table->shared) munmap( table->shared, table->shared_count * sizeof(*table->shared) );
+    if (table->shared_fd != -1) close( table->shared_fd );
+    table->shared = NULL;
+    table->shared_fd = -1;
+}
+
+/* grow the shared copy of the handle table */
+/* the file is never shrunk, so that client mappings stay valid */
+static int grow_shared_table( struct handle_table *table, int count )
+{
+    void *ptr;
+
+    if (!table->shared || count <= table->shared_count) return 1;
+    if (ftruncate( table->shared_fd, count * sizeof(*table->shared) ) == -1) return 0;
+    ptr = mmap( NULL, count * sizeof(*table->shared), PROT_READ | PROT_WRITE,
+                MAP_SHARED, table->shared_fd, 0 );
+    if (ptr == MAP_FAILED) return 0;
+    munmap( table->shared, table->shared_count * sizeof(*table->shared) );
+    table->shared       = ptr;
+    table->shared_count = count;
+    return 1;
+}
+
+/* publish the state of a handle entry to the shared copy of the table */
+static void update_shared_entry( struct handle_table *table, int index )
+{
+    const struct handle_entry *entry = table->entries + index;
+    struct shared_handle_entry shared = { 0 };
+
+    if (!table->shared || index >= table->shared_count) return;
+    if (entry->ptr)
+    {
+        shared.access = entry->access & ~RESERVED_ALL;
+        shared.type   = entry->ptr->ops->type->index + 1;
+        shared.flags  = (entry->access & RESERVED_ALL) >> RESERVED_SHIFT;
+    }
+    table->shared[index] = shared;
+}
+
+/* publish the state of a process handle to the shared copy of the table */
+static void update_shared_handle( struct process *process, obj_handle_t handle )
+{
+    if (handle_is_global( handle ) || !process->handles) return;  /* global handles are not shared */
+    update_shared_entry( process->handles, handle_to_index( handle ));
+}
+
 /* grab an object and increment its handle count */
 static struct object *grab_object_for_handle( struct object *obj )
 {
@@ -193,6 +276,7 @@ static void handle_table_destroy( struct object *obj )
         if (obj) release_object_from_handle( obj );
     }
     free( table->entries );
+    free_shared_table( table );
 }
 
 /* close all the process handles and free the handle table */
@@ -216,7 +300,13 @@ struct handle_table *alloc_handle_table( struct process *process, int count )
     table->count   = count;
     table->last    = -1;
     table->free    = 0;
-    if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
+    if ((table->entries = mem_alloc( count * sizeof(*table->entries) )))
+    {
+        init_shared_table( table );
+        return table;
+    }
+    table->shared_fd = -1;
+    table->shared    = NULL;
     release_object( table );
     return NULL;
 }
@@ -228,6 +318,7 @@ static int grow_handle_table( struct handle_table *table )
     int count = min( table->count * 2, MAX_HANDLE_ENTRIES );
 
     if (count == table->count ||
+        !grow_shared_table( table, count ) ||
         !(new_entries = realloc( table->entries, count * sizeof(struct handle_entry) )))
     {
         set_error( STATUS_INSUFFICIENT_RESOURCES );
@@ -255,6 +346,7 @@ static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned
     table->free = i + 1;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
+    update_shared_entry( table, i );
     return index_to_handle(i);
 }
 
@@ -373,6 +465,33 @@ static void inherit_handle( struct process *parent, const obj_handle_t handle, s
     grab_object_for_handle( src->ptr );
     dst[index] = *src;
     table->last = max( table->last, index );
+    update_shared_entry( table, index );
+}
+
+/* return the index of the last handle that a child process would inherit, or -1 if none */
+static int get_last_inherited( struct process *parent, const obj_handle_t *handles,
+                               unsigned int handle_count, const obj_handle_t *std_handles )
+{
+    struct handle_table *parent_table = parent->handles;
+    struct handle_entry *entry;
+    unsigned int i;
+    int last = -1;
+
+    if (handles)
+    {
+        for (i = 0; i < handle_count + 3; i++)
+        {
+            obj_handle_t handle = i < handle_count ? handles[i] : std_handles[i - handle_count];
+
+            if (!(entry = get_handle( parent, handle )) || !(entry->access & RESERVED_INHERIT)) continue;
+            last = max( last, handle_to_index( handle ));
+        }
+        return last;
+    }
+
+    for (last = parent_table->last, entry = parent_table->entries + last; last >= 0; last--, entry--)
+        if (entry->ptr && (entry->access & RESERVED_INHERIT)) break;
+    return last;
 }
 
 /* copy the handle table of the parent process */
@@ -383,17 +502,19 @@ struct handle_table *copy_handle_table( struct process *process, struct process
 {
     struct handle_table *parent_table = parent->handles;
     struct handle_table *table;
-    int i;
+    int i, last;
 
     assert( parent_table );
     assert( parent_table->obj.ops == &handle_table_ops );
 
-    if (!(table = alloc_handle_table( process, parent_table->count )))
+    /* only allocate room for the inherited handles, not for the whole parent table */
+    last = get_last_inherited( parent, handles, handle_count, std_handles );
+    if (!(table = alloc_handle_table( process, last + 1 )))
         return NULL;
 
     if (handles)
     {
-        memset( table->entries, 0, parent_table->count * sizeof(*table->entries) );
+        memset( table->entries, 0, table->count * sizeof(*table->entries) );
 
         for (i = 0; i < handle_count; i++)
         {
@@ -405,22 +526,18 @@ struct handle_table *copy_handle_table( struct process *process, struct process
             inherit_handle( parent, std_handles[i], table );
         }
     }
-    else
+    else if ((table->last = last) >= 0)
     {
-        if ((table->last = parent_table->last) >= 0)
+        struct handle_entry *ptr = table->entries;
+        memcpy( ptr, parent_table->entries, (table->last + 1) * sizeof(struct handle_entry) );
+        for (i = 0; i <= table->last; i++, ptr++)
         {
-            struct handle_entry *ptr = table->entries;
-            memcpy( ptr, parent_table->entries, (table->last + 1) * sizeof(struct handle_entry) );
-            for (i = 0; i <= table->last; i++, ptr++)
-            {
-                if (!ptr->ptr) continue;
-                if (ptr->access & RESERVED_INHERIT) grab_object_for_handle( ptr->ptr );
-                else ptr->ptr = NULL; /* don't inherit this entry */
-            }
+            if (!ptr->ptr) continue;
+            if (ptr->access & RESERVED_INHERIT) grab_object_for_handle( ptr->ptr );
+            else ptr->ptr = NULL; /* don't inherit this entry */
+            update_shared_entry( table, i );
         }
     }
-    /* attempt to shrink the table */
-    shrink_handle_table( table );
     return table;
 }
 
@@ -437,6 +554,7 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
     entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
+    update_shared_entry( table, entry - table->entries );
     if (entry < table->entries + table->free) table->free = entry - table->entries;
     if (entry == table->entries + table->last) shrink_handle_table( table );
     release_object_from_handle( obj );
@@ -549,6 +667,7 @@ static int set_handle_flags( struct process *process, obj_handle_t handle, int m
     mask  = (mask << RESERVED_SHIFT) & RESERVED_ALL;
     flags = (flags << RESERVED_SHIFT) & mask;
     entry->access = (entry->access & ~mask) | flags;
+    update_shared_handle( process, handle );
     return (old_access & RESERVED_ALL) >> RESERVED_SHIFT;
 }
 
@@ -597,6 +716,7 @@ obj_handle_t duplicate_handle( struct process *src, obj_handle_t src_handle, str
         {
             if (attr & OBJ_INHERIT) access |= RESERVED_INHERIT;
             entry->access = access;
+            update_shared_handle( src, src_handle );
             res = src_handle;
         }
         else
@@ -865,6 +985,19 @@ DECL_HANDLER(get_system_handles)
     }
 }
 
+/* retrieve the fd of the shared copy of the process handle table */
+DECL_HANDLER(get_shared_handle_table)
+{
+    struct handle_table *table = current->process->handles;
+
+    if (!table || !table->shared)
+    {
+        set_error( STATUS_NOT_SUPPORTED );
+        return;
+    }
+    send_client_fd( current->process, table->shared_fd, 0 );
+}
+
 DECL_HANDLER(make_temporary)
 {
     struct object *obj;
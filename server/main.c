@@ -143,6 +143,8 @@ int main( int argc, char *argv[] )
     sock_init();
     open_master_socket();
 
+    if (getenv( "WINESERVERSTATS" )) init_request_stats();
+
     if (do_fsync())
         fsync_init();
 
@@ -25,10 +25,15 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -287,13 +292,65 @@ static int check_current_dir_for_exec(void)
     return (ret != MAP_FAILED);
 }
 
+#if defined(__linux__) && defined(__NR_memfd_create)
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC       0x0001
+#define MFD_ALLOW_SEALING 0x0002
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS       1033
+#define F_SEAL_SEAL       0x0001
+#define F_SEAL_SHRINK     0x0002
+#define F_SEAL_GROW       0x0004
+#endif
+
+static int use_memfd = 1;
+
+/* create an anonymous memory file; returns -2 if not supported by the kernel */
+static int create_memfd( file_pos_t size )
+{
+    int fd;
+
+    if ((fd = syscall( __NR_memfd_create, "wine-anonmap", MFD_CLOEXEC | MFD_ALLOW_SEALING )) == -1)
+    {
+        if (errno != ENOSYS && errno != EINVAL)
+        {
+            file_set_error();
+            return -1;
+        }
+        use_memfd = 0;
+        return -2;
+    }
+    if (!grow_file( fd, size ))
+    {
+        close( fd );
+        return -1;
+    }
+    return fd;
+}
+
+#endif
+
+/* prevent the size of a temp file from changing once it's mapped */
+static void seal_temp_file_size( int fd )
+{
+#if defined(__linux__) && defined(__NR_memfd_create)
+    if (use_memfd) fcntl( fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL );
+#endif
+}
+
 /* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+int create_temp_file( file_pos_t size )
 {
     static int temp_dir_fd = -1;
     char tmpfn[] = "anonmap.XXXXXX";
     int fd;
 
+#if defined(__linux__) && defined(__NR_memfd_create)
+    if (use_memfd && (fd = create_memfd( size )) != -2) return fd;
+#endif
+
     if (temp_dir_fd == -1)
     {
         temp_dir_fd = server_dir_fd;
@@ -543,6 +600,7 @@ static int build_shared_mapping( struct mapping *mapping, int fd,
     /* create a temp file for the mapping */
 
     if ((shared_fd = create_temp_file( total_size )) == -1) return 0;
+    seal_temp_file_size( shared_fd );
     if (!(file = create_file_for_fd( shared_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 ))) return 0;
 
     if (!(buffer = malloc( max_size ))) goto error;
@@ -939,6 +997,7 @@ static struct mapping *create_mapping( struct object *root, const struct unicode
         if ((flags & SEC_RESERVE) && !(mapping->committed = create_ranges())) goto error;
         mapping->size = (mapping->size + page_mask) & ~((mem_size_t)page_mask);
         if ((unix_fd = create_temp_file( mapping->size )) == -1) goto error;
+        seal_temp_file_size( unix_fd );
         if (!(mapping->fd = create_anonymous_fd( &mapping_fd_ops, unix_fd, &mapping->obj,
                                                  FILE_SYNCHRONOUS_IO_NONALERT ))) goto error;
         allow_fd_caching( mapping->fd );
@@ -1107,6 +1166,24 @@ struct object *create_user_data_mapping( struct object *root, const struct unico
     return &mapping->obj;
 }
 
+/* create an anonymous mapping which the server keeps mapped writable at *ptr */
+struct object *create_shared_mapping( mem_size_t size, void **ptr )
+{
+    struct mapping *mapping;
+    void *addr;
+
+    if (!(mapping = create_mapping( NULL, NULL, 0, size, SEC_COMMIT, 0,
+                                    FILE_READ_DATA | FILE_WRITE_DATA, NULL ))) return NULL;
+    addr = mmap( NULL, mapping->size, PROT_READ | PROT_WRITE, MAP_SHARED, get_unix_fd( mapping->fd ), 0 );
+    if (addr == MAP_FAILED)
+    {
+        release_object( mapping );
+        return NULL;
+    }
+    *ptr = addr;
+    return &mapping->obj;
+}
+
 /* create a file mapping */
 DECL_HANDLER(create_mapping)
 {
@@ -64,6 +64,7 @@ struct pipe_end
     process_id_t         server_pid; /* process that created the server */
     data_size_t          buffer_size;/* size of buffered data that doesn't block caller */
     struct list          message_queue;
+    data_size_t          queued_size;/* unread bytes in the message queue */
     struct async_queue   read_q;     /* read queue */
     struct async_queue   write_q;    /* write queue */
 };
@@ -390,6 +391,7 @@ static struct pipe_message *queue_message( struct pipe_end *pipe_end, struct ios
     message->async = NULL;
     message->read_pos = 0;
     list_add_tail( &pipe_end->message_queue, &message->entry );
+    pipe_end->queued_size += iosb->in_size;
     return message;
 }
 
@@ -406,10 +408,14 @@ static void wake_message( struct pipe_message *message, data_size_t result )
     release_object( async );
 }
 
-static void free_message( struct pipe_message *message )
+static void free_message( struct pipe_end *pipe_end, struct pipe_message *message )
 {
     list_remove( &message->entry );
-    if (message->iosb) release_object( message->iosb );
+    if (message->iosb)
+    {
+        pipe_end->queued_size -= message->iosb->in_size - message->read_pos;
+        release_object( message->iosb );
+    }
     free( message );
 }
 
@@ -428,7 +434,7 @@ static void pipe_end_disconnect( struct pipe_end *pipe_end, unsigned int status
     LIST_FOR_EACH_ENTRY_SAFE( message, next, &pipe_end->message_queue, struct pipe_message, entry )
     {
         async = message->async;
-        if (async || status == STATUS_PIPE_DISCONNECTED) free_message( message );
+        if (async || status == STATUS_PIPE_DISCONNECTED) free_message( pipe_end, message );
         if (!async) continue;
         async_terminate( async, status );
         release_object( async );
@@ -453,7 +459,7 @@ static void pipe_end_destroy( struct object *obj )
     {
         message = LIST_ENTRY( list_head(&pipe_end->message_queue), struct pipe_message, entry );
         assert( !message->async );
-        free_message( message );
+        free_message( pipe_end, message );
     }
 
     free_async_queue( &pipe_end->read_q );
@@ -537,7 +543,7 @@ static void named_pipe_device_destroy( struct object *obj )
 {
     struct named_pipe_device *device = (struct named_pipe_device*)obj;
     assert( obj->ops == &named_pipe_device_ops );
-    free( device->pipes );
+    free_namespace( device->pipes );
 }
 
 struct object *create_named_pipe_device( struct object *root, const struct unicode_str *name,
@@ -716,7 +722,7 @@ static void pipe_end_get_file_info( struct fd *fd, obj_handle_t handle, unsigned
             pipe_info->MaximumInstances    = pipe->maxinstances;
             pipe_info->CurrentInstances    = pipe->instances;
             pipe_info->InboundQuota        = pipe->insize;
-            pipe_info->ReadDataAvailable   = 0; /* FIXME */
+            pipe_info->ReadDataAvailable   = pipe_end->queued_size;
             pipe_info->OutboundQuota       = pipe->outsize;
             pipe_info->WriteQuotaAvailable = 0; /* FIXME */
             pipe_info->NamedPipeState      = pipe_end->state;
@@ -788,13 +794,7 @@ static void message_queue_read( struct pipe_end *pipe_end, struct iosb *iosb )
     }
     else
     {
-        data_size_t avail = 0;
-        LIST_FOR_EACH_ENTRY( message, &pipe_end->message_queue, struct pipe_message, entry )
-        {
-            avail += message->iosb->in_size - message->read_pos;
-            if (avail >= iosb->out_size) break;
-        }
-        iosb->out_size = min( iosb->out_size, avail );
+        iosb->out_size = min( iosb->out_size, pipe_end->queued_size );
         iosb->status = STATUS_SUCCESS;
     }
 
@@ -804,7 +804,7 @@ static void message_queue_read( struct pipe_end *pipe_end, struct iosb *iosb )
         iosb->out_data = message->iosb->in_data;
         message->iosb->in_data = NULL;
         wake_message( message, message->iosb->in_size );
-        free_message( message );
+        free_message( pipe_end, message );
     }
     else
     {
@@ -825,10 +825,11 @@ static void message_queue_read( struct pipe_end *pipe_end, struct iosb *iosb )
             if (writing) memcpy( buf + write_pos, (const char *)message->iosb->in_data + message->read_pos, writing );
             write_pos += writing;
             message->read_pos += writing;
+            pipe_end->queued_size -= writing;
             if (message->read_pos == message->iosb->in_size)
             {
                 wake_message(message, message->iosb->in_size);
-                free_message(message);
+                free_message(pipe_end, message);
             }
         } while (write_pos < iosb->out_size);
     }
@@ -883,7 +884,7 @@ static void reselect_write_queue( struct pipe_end *pipe_end )
         {
             release_object( message->async );
             message->async = NULL;
-            free_message( message );
+            free_message( reader, message );
         }
         else
         {
@@ -895,7 +896,7 @@ static void reselect_write_queue( struct pipe_end *pipe_end )
             else if (message->async && (pipe_end->flags & NAMED_PIPE_NONBLOCKING_MODE))
             {
                 wake_message( message, message->read_pos );
-                free_message( message );
+                free_message( reader, message );
             }
         }
     }
@@ -992,7 +993,7 @@ static int pipe_end_peek( struct pipe_end *pipe_end )
     unsigned reply_size = get_reply_max_size();
     FILE_PIPE_PEEK_BUFFER *buffer;
     struct pipe_message *message;
-    data_size_t avail = 0;
+    data_size_t avail = pipe_end->queued_size;
     data_size_t message_length = 0;
 
     if (reply_size < offsetof( FILE_PIPE_PEEK_BUFFER, Data ))
@@ -1015,8 +1016,6 @@ static int pipe_end_peek( struct pipe_end *pipe_end )
         return 0;
     }
 
-    LIST_FOR_EACH_ENTRY( message, &pipe_end->message_queue, struct pipe_message, entry )
-        avail += message->iosb->in_size - message->read_pos;
     reply_size = min( reply_size, avail );
 
     if (avail && pipe_end->pipe->message_mode)
@@ -1231,6 +1230,7 @@ static void init_pipe_end( struct pipe_end *pipe_end, struct named_pipe *pipe,
     pipe_end->flags = pipe_flags;
     pipe_end->connection = NULL;
     pipe_end->buffer_size = buffer_size;
+    pipe_end->queued_size = 0;
     init_async_queue( &pipe_end->read_q );
     init_async_queue( &pipe_end->write_q );
     list_init( &pipe_end->message_queue );
@@ -46,7 +46,8 @@
 struct namespace
 {
     unsigned int        hash_size;       /* size of hash table */
-    struct list         names[1];        /* array of hash entry lists */
+    unsigned int        count;           /* names added since the table was last checked */
+    struct list        *names;           /* array of hash entry lists */
 };
 
 
@@ -134,10 +135,42 @@ void *memdup( const void *data, size_t len )
 
 /*****************************************************************/
 
+/* grow the hash table once it has more names than buckets */
+static void rehash_namespace( struct namespace *namespace )
+{
+    struct object_name *ptr, *next;
+    struct list *names;
+    unsigned int i, hash, count = 0, size;
+
+    /* names are removed without telling the namespace, so count them again */
+    for (i = 0; i < namespace->hash_size; i++) count += list_count( &namespace->names[i] );
+    namespace->count = count;
+    if (count <= namespace->hash_size) return;
+
+    /* the namespace keeps working with long chains if this fails */
+    size = namespace->hash_size * 4 + 1;
+    if (!(names = malloc( size * sizeof(*names) ))) return;
+    for (i = 0; i < size; i++) list_init( &names[i] );
+    for (i = 0; i < namespace->hash_size; i++)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( ptr, next, &namespace->names[i], struct object_name, entry )
+        {
+            hash = hash_strW( ptr->name, ptr->len, size );
+            list_remove( &ptr->entry );
+            list_add_tail( &names[hash], &ptr->entry );
+        }
+    }
+    free( namespace->names );
+    namespace->names = names;
+    namespace->hash_size = size;
+}
+
 void namespace_add( struct namespace *namespace, struct object_name *ptr )
 {
-    unsigned int hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
+    unsigned int hash;
 
+    if (++namespace->count > 2 * namespace->hash_size) rehash_namespace( namespace );
+    hash = hash_strW( ptr->name, ptr->len, namespace->hash_size );
     list_add_head( &namespace->names[hash], &ptr->entry );
 }
 
@@ -495,15 +528,26 @@ struct namespace *create_namespace( unsigned int hash_size )
     struct namespace *namespace;
     unsigned int i;
 
-    namespace = mem_alloc( sizeof(*namespace) + (hash_size - 1) * sizeof(namespace->names[0]) );
-    if (namespace)
+    if (!(namespace = mem_alloc( sizeof(*namespace) ))) return NULL;
+    if (!(namespace->names = mem_alloc( hash_size * sizeof(namespace->names[0]) )))
     {
-        namespace->hash_size      = hash_size;
-        for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
+        free( namespace );
+        return NULL;
     }
+    namespace->hash_size      = hash_size;
+    namespace->count          = 0;
+    for (i = 0; i < hash_size; i++) list_init( &namespace->names[i] );
     return namespace;
 }
 
+/* free a namespace */
+void free_namespace( struct namespace *namespace )
+{
+    if (!namespace) return;
+    free( namespace->names );
+    free( namespace );
+}
+
 /* functions for unimplemented/default object operations */
 
 int no_add_queue( struct object *obj, struct wait_queue_entry *entry )
@@ -149,6 +149,7 @@ struct msg_queue
     int                    esync_in_msgwait; /* our thread is currently waiting on us */
     unsigned int           fsync_idx;
     int                    fsync_in_msgwait; /* our thread is currently waiting on us */
+    unsigned int           status_idx;      /* fsync shm index mirroring wake_bits for the client */
 };
 
 struct hotkey
@@ -327,6 +328,7 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->esync_in_msgwait = 0;
         queue->fsync_idx       = 0;
         queue->fsync_in_msgwait = 0;
+        queue->status_idx      = 0;
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
@@ -334,7 +336,10 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         for (i = 0; i < NB_MSG_KINDS; i++) list_init( &queue->msg_list[i] );
 
         if (do_fsync())
+        {
             queue->fsync_idx = fsync_alloc_shm( 0, 0 );
+            queue->status_idx = fsync_alloc_shm( 0, 0 );
+        }
 
         if (do_esync())
             queue->esync_fd = esync_create_fd( 0, 0 );
@@ -436,6 +441,7 @@ static int update_desktop_cursor_pos( struct desktop *desktop, int x, int y )
     desktop->cursor.x = x;
     desktop->cursor.y = y;
     desktop->cursor.last_change = get_tick_count();
+    update_desktop_shared( desktop );
 
     return updated;
 }
@@ -539,6 +545,7 @@ static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
     }
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    if (queue->status_idx) fsync_store_shm( queue->status_idx, queue->wake_bits );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -547,6 +554,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
 {
     queue->wake_bits &= ~bits;
     queue->changed_bits &= ~bits;
+    if (queue->status_idx) fsync_store_shm( queue->status_idx, queue->wake_bits );
     if (!(queue->wake_bits & (QS_KEY | QS_MOUSEBUTTON)))
     {
         if (queue->keystate_lock) unlock_input_keystate( queue->input );
@@ -612,12 +620,62 @@ static inline unsigned int get_unique_id(void)
     return id;
 }
 
+/* number of pending WM_INPUT messages after which relative mouse motion gets merged */
+#define RAWINPUT_MERGE_BACKLOG 64
+
+/* try to merge a relative mouse WM_INPUT message into the previous one; return 1 if successful */
+static int merge_rawinput_message( struct thread_input *input, const struct message *msg )
+{
+    const unsigned int move_flags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE | MOUSEEVENTF_VIRTUALDESK;
+    struct hardware_msg_data *prev_data, *msg_data = msg->data;
+    struct message *prev, *other;
+    struct list *ptr, *cur;
+    unsigned int backlog = 0;
+
+    if (msg->type != MSG_HARDWARE || !msg_data) return 0;
+    if (msg_data->rawinput.type != RIM_TYPEMOUSE || msg_data->rawinput.mouse.data) return 0;
+    if (msg_data->flags & ~move_flags) return 0;
+
+    /* only merge with the last WM_INPUT, possibly followed by the merged WM_MOUSEMOVE */
+    if (!(ptr = list_tail( &input->msg_list ))) return 0;
+    prev = LIST_ENTRY( ptr, struct message, entry );
+    if (prev->msg == WM_MOUSEMOVE && !prev->unique_id)
+    {
+        if (!(ptr = list_prev( &input->msg_list, ptr ))) return 0;
+        prev = LIST_ENTRY( ptr, struct message, entry );
+    }
+    if (prev->msg != WM_INPUT || prev->type != MSG_HARDWARE || prev->result || prev->unique_id) return 0;
+    if (prev->win != msg->win || prev->wparam != msg->wparam) return 0;
+    if (!(prev_data = prev->data)) return 0;
+    if (prev_data->rawinput.type != RIM_TYPEMOUSE || prev_data->rawinput.mouse.data) return 0;
+    if (prev_data->flags != msg_data->flags || prev_data->info != msg_data->info) return 0;
+    if (memcmp( &prev_data->source, &msg_data->source, sizeof(prev_data->source) )) return 0;
+
+    /* every sample is kept as long as the application keeps up with them */
+    for (cur = ptr; cur && backlog < RAWINPUT_MERGE_BACKLOG; cur = list_prev( &input->msg_list, cur ))
+    {
+        other = LIST_ENTRY( cur, struct message, entry );
+        if (other->msg != WM_INPUT) break;
+        backlog++;
+    }
+    if (backlog < RAWINPUT_MERGE_BACKLOG) return 0;
+
+    /* now we can merge it, accumulating the relative motion */
+    prev_data->rawinput.mouse.x += msg_data->rawinput.mouse.x;
+    prev_data->rawinput.mouse.y += msg_data->rawinput.mouse.y;
+    prev->x    = msg->x;
+    prev->y    = msg->y;
+    prev->time = msg->time;
+    return 1;
+}
+
 /* try to merge a message with the last in the list; return 1 if successful */
 static int merge_message( struct thread_input *input, const struct message *msg )
 {
     struct message *prev;
     struct list *ptr;
 
+    if (msg->msg == WM_INPUT) return merge_rawinput_message( input, msg );
     if (msg->msg != WM_MOUSEMOVE) return 0;
     for (ptr = list_tail( &input->msg_list ); ptr; ptr = list_prev( &input->msg_list, ptr ))
     {
@@ -1455,6 +1513,7 @@ static void update_input_key_state( struct desktop *desktop, unsigned char *keys
         }
         break;
     }
+    if (keystate == desktop->keystate) update_desktop_shared( desktop );
 }
 
 /* update the desktop key state according to a mouse message flags */
@@ -1859,6 +1918,7 @@ static int queue_mouse_message( struct desktop *desktop, user_handle_t win, cons
     };
 
     desktop->cursor.last_change = get_tick_count();
+    update_desktop_shared( desktop );
     flags = input->mouse.flags;
     time  = input->mouse.time;
     if (!time) time = desktop->cursor.last_change;
@@ -2484,7 +2544,12 @@ DECL_HANDLER(get_msg_queue)
     struct msg_queue *queue = get_current_queue();
 
     reply->handle = 0;
-    if (queue) reply->handle = alloc_handle( current->process, queue, SYNCHRONIZE, 0 );
+    reply->status_idx = 0;
+    if (queue)
+    {
+        reply->handle = alloc_handle( current->process, queue, SYNCHRONIZE, 0 );
+        reply->status_idx = queue->status_idx;
+    }
 }
 
 
@@ -3171,6 +3236,7 @@ DECL_HANDLER(get_key_state)
         {
             reply->state = desktop->keystate[req->key & 0xff];
             desktop->keystate[req->key & 0xff] &= ~0x40;
+            update_desktop_shared( desktop );
         }
         set_reply_data( desktop->keystate, size );
         release_object( desktop );
@@ -3201,6 +3267,7 @@ DECL_HANDLER(set_key_state)
     if (req->async && (desktop = get_thread_desktop( current, 0 )))
     {
         memcpy( desktop->keystate, get_req_data(), size );
+        update_desktop_shared( desktop );
         release_object( desktop );
     }
 }
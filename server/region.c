@@ -758,6 +758,16 @@ struct region *copy_region( struct region *dst, const struct region *src )
     return dst;
 }
 
+/* check if a rectangle region entirely covers the extents of another region */
+static inline int region_covers( const struct region *rect_region, const struct region *region )
+{
+    return (rect_region->num_rects == 1 &&
+            rect_region->extents.left <= region->extents.left &&
+            rect_region->extents.top <= region->extents.top &&
+            rect_region->extents.right >= region->extents.right &&
+            rect_region->extents.bottom >= region->extents.bottom);
+}
+
 /* compute the intersection of two regions into dst, which can be one of the source regions */
 struct region *intersect_region( struct region *dst, const struct region *src1,
                                  const struct region *src2 )
@@ -771,6 +781,20 @@ struct region *intersect_region( struct region *dst, const struct region *src1,
         dst->extents.bottom = 0;
         return dst;
     }
+    /* fast paths for simple rectangles, which are by far the most common case */
+    if (region_covers( src2, src1 )) return copy_region( dst, src1 );
+    if (region_covers( src1, src2 )) return copy_region( dst, src2 );
+    if (src1->num_rects == 1 && src2->num_rects == 1)
+    {
+        rectangle_t rect;
+
+        rect.left   = max( src1->extents.left, src2->extents.left );
+        rect.top    = max( src1->extents.top, src2->extents.top );
+        rect.right  = min( src1->extents.right, src2->extents.right );
+        rect.bottom = min( src1->extents.bottom, src2->extents.bottom );
+        set_region_rect( dst, &rect );
+        return dst;
+    }
     if (!region_op( dst, src1, src2, intersect_overlapping, NULL, NULL )) return NULL;
     set_region_extents( dst );
     return dst;
@@ -783,6 +807,12 @@ struct region *subtract_region( struct region *dst, const struct region *src1,
     if (!src1->num_rects || !src2->num_rects || !EXTENTCHECK(&src1->extents, &src2->extents))
         return copy_region( dst, src1 );
 
+    if (region_covers( src2, src1 ))
+    {
+        set_region_rect( dst, &empty_rect );
+        return dst;
+    }
+
     if (!region_op( dst, src1, src2, subtract_overlapping,
                     subtract_non_overlapping, NULL )) return NULL;
     set_region_extents( dst );
@@ -797,19 +827,8 @@ struct region *union_region( struct region *dst, const struct region *src1,
     if (!src1->num_rects) return copy_region( dst, src2 );
     if (!src2->num_rects) return copy_region( dst, src1 );
 
-    if ((src1->num_rects == 1) &&
-        (src1->extents.left <= src2->extents.left) &&
-        (src1->extents.top <= src2->extents.top) &&
-        (src1->extents.right >= src2->extents.right) &&
-        (src1->extents.bottom >= src2->extents.bottom))
-        return copy_region( dst, src1 );
-
-    if ((src2->num_rects == 1) &&
-        (src2->extents.left <= src1->extents.left) &&
-        (src2->extents.top <= src1->extents.top) &&
-        (src2->extents.right >= src1->extents.right) &&
-        (src2->extents.bottom >= src1->extents.bottom))
-        return copy_region( dst, src2 );
+    if (region_covers( src1, src2 )) return copy_region( dst, src1 );
+    if (region_covers( src2, src1 )) return copy_region( dst, src2 );
 
     if (!region_op( dst, src1, src2, union_overlapping,
                     union_non_overlapping, union_non_overlapping )) return NULL;
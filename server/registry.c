@@ -35,6 +35,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -86,6 +89,9 @@ struct key
     int               last_subkey; /* last in use subkey */
     int               nb_subkeys;  /* count of allocated subkeys */
     struct key      **subkeys;     /* subkeys array */
+    struct key      **subkey_hash; /* hash table of subkeys, for keys with many subkeys */
+    unsigned int      subkey_hash_size; /* size of the subkey hash table */
+    struct key       *hash_next;   /* next key in the parent subkey hash chain */
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
@@ -114,6 +120,7 @@ struct key_value
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
+#define MIN_SUBKEY_HASH 64  /* min. number of subkeys to index them in a hash table */
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
@@ -123,7 +130,9 @@ static struct key *root_key;
 
 static const timeout_t ticks_1601_to_1970 = (timeout_t)86400 * (369 * 365 + 89) * TICKS_PER_SEC;
 static const timeout_t save_period = 30 * -TICKS_PER_SEC;  /* delay between periodic saves */
+static const timeout_t save_check_period = -TICKS_PER_SEC / 10;  /* delay between background save checks */
 static struct timeout_user *save_timeout_user;  /* saving timer */
+static struct timeout_user *save_check_user;  /* background save completion timer */
 static enum prefix_type { PREFIX_UNKNOWN, PREFIX_32BIT, PREFIX_64BIT } prefix_type;
 
 static const WCHAR root_name[] = { '\\','R','e','g','i','s','t','r','y','\\' };
@@ -139,6 +148,8 @@ struct save_branch_info
 {
     struct key  *key;
     const char  *path;
+    pid_t        pid;        /* process saving the branch in the background, 0 if none */
+    int          result_fd;  /* pipe the background save result is read from */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
@@ -156,6 +167,9 @@ struct file_load_info
     int         line;     /* current input line */
     WCHAR      *tmp;      /* temp buffer to use while parsing input */
     size_t      tmplen;   /* length of temp buffer */
+    struct key *last_key; /* last key loaded, starting point to look up the next one */
+    WCHAR      *last_name; /* path of the last key relative to the base key */
+    data_size_t last_len; /* length of the last key path */
 };
 
 
@@ -457,6 +471,7 @@ static void key_destroy( struct object *obj )
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_hash );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -519,6 +534,9 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->last_subkey = -1;
         key->nb_subkeys  = 0;
         key->subkeys     = NULL;
+        key->subkey_hash = NULL;
+        key->subkey_hash_size = 0;
+        key->hash_next   = NULL;
         key->nb_values   = 0;
         key->last_value  = -1;
         key->values      = NULL;
@@ -608,6 +626,42 @@ static int grow_subkeys( struct key *key )
     return 1;
 }
 
+/* add a subkey to the hash table of its parent */
+static void hash_subkey( struct key *parent, struct key *key )
+{
+    unsigned int hash = hash_strW( key->name, key->namelen, parent->subkey_hash_size );
+
+    key->hash_next = parent->subkey_hash[hash];
+    parent->subkey_hash[hash] = key;
+}
+
+/* remove a subkey from the hash table of its parent */
+static void unhash_subkey( struct key *parent, struct key *key )
+{
+    struct key **ptr = &parent->subkey_hash[hash_strW( key->name, key->namelen, parent->subkey_hash_size )];
+
+    while (*ptr != key) ptr = &(*ptr)->hash_next;
+    *ptr = key->hash_next;
+    key->hash_next = NULL;
+}
+
+/* create or grow the subkey hash table once the key has enough subkeys */
+static void rehash_subkeys( struct key *key )
+{
+    unsigned int i, count = key->last_subkey + 1, size;
+    struct key **hash;
+
+    if (count < MIN_SUBKEY_HASH || count <= key->subkey_hash_size) return;
+
+    /* the binary search on the subkeys array still works if this fails */
+    size = count * 2 + 1;
+    if (!(hash = calloc( size, sizeof(*hash) ))) return;
+    free( key->subkey_hash );
+    key->subkey_hash = hash;
+    key->subkey_hash_size = size;
+    for (i = 0; i < count; i++) hash_subkey( key, key->subkeys[i] );
+}
+
 /* allocate a subkey for a given key, and return its index */
 static struct key *alloc_subkey( struct key *parent, const struct unicode_str *name,
                                  int index, timeout_t modif )
@@ -631,6 +685,8 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
         for (i = ++parent->last_subkey; i > index; i--)
             parent->subkeys[i] = parent->subkeys[i-1];
         parent->subkeys[index] = key;
+        if (parent->subkey_hash) hash_subkey( parent, key );
+        rehash_subkeys( parent );
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
     }
@@ -647,6 +703,7 @@ static void free_subkey( struct key *parent, int index )
     assert( index <= parent->last_subkey );
 
     key = parent->subkeys[index];
+    if (parent->subkey_hash) unhash_subkey( parent, key );
     for (i = index; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
     parent->last_subkey--;
     key->flags |= KEY_DELETED;
@@ -667,8 +724,8 @@ static void free_subkey( struct key *parent, int index )
     }
 }
 
-/* find the named child of a given key and return its index */
-static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
+/* find the named child of a given key in the sorted array and return its index */
+static struct key *find_subkey_index( const struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
     data_size_t len;
@@ -693,6 +750,23 @@ static struct key *find_subkey( const struct key *key, const struct unicode_str
     return NULL;
 }
 
+/* find the named child of a given key */
+/* the index is only set if the child doesn't exist, to where it should be inserted */
+static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
+{
+    struct key *subkey;
+
+    if (!key->subkey_hash) return find_subkey_index( key, name, index );
+
+    for (subkey = key->subkey_hash[hash_strW( name->str, name->len, key->subkey_hash_size )];
+         subkey; subkey = subkey->hash_next)
+    {
+        if (subkey->namelen == name->len && !memicmp_strW( subkey->name, name->str, name->len ))
+            return subkey;
+    }
+    return find_subkey_index( key, name, index );
+}
+
 /* return the wow64 variant of the key, or the key itself if none */
 static struct key *find_wow64_subkey( struct key *key, const struct unicode_str *name )
 {
@@ -1004,6 +1078,7 @@ static int delete_key( struct key *key, int recurse )
 {
     int index;
     struct key *parent = key->parent;
+    struct unicode_str name;
 
     /* must find parent and index */
     if (key == root_key)
@@ -1017,9 +1092,10 @@ static int delete_key( struct key *key, int recurse )
         if (0 > delete_key(key->subkeys[key->last_subkey], 1))
             return -1;
 
-    for (index = 0; index <= parent->last_subkey; index++)
-        if (parent->subkeys[index] == key) break;
-    assert( index <= parent->last_subkey );
+    name.str = key->name;
+    name.len = key->namelen;
+    find_subkey_index( parent, &name, &index );
+    assert( parent->subkeys[index] == key );
 
     /* we can only delete a key that has no subkeys */
     if (key->last_subkey >= 0)
@@ -1372,6 +1448,79 @@ static int get_data_type( const char *buffer, int *type, int *parse_type )
     return 0;
 }
 
+/* check that a key is the one found by walking a path from the base key, without following symlinks */
+static int is_key_path( const struct key *key, const struct key *base, const struct unicode_str *path )
+{
+    const WCHAR *end = path->str + path->len / sizeof(WCHAR), *p;
+
+    while (end > path->str)
+    {
+        for (p = end; p > path->str && p[-1] != '\\'; p--) ;
+        if (!key || p == end || key->namelen != (end - p) * sizeof(WCHAR) ||
+            memicmp_strW( key->name, p, key->namelen ))
+            return 0;
+        key = key->parent;
+        end = p > path->str ? p - 1 : p;
+        if (p > path->str && end == path->str) return 0;  /* leading backslash */
+    }
+    return key == base;
+}
+
+/* create a key from the input file, starting from the deepest key it shares with the previous one */
+static struct key *create_loaded_key( struct key *base, const struct unicode_str *name,
+                                      struct file_load_info *info )
+{
+    struct key *key = base, *ret;
+    struct unicode_str rest = *name;
+    data_size_t i, start = 0, len;
+    WCHAR *last_name;
+
+    if (info->last_key)
+    {
+        /* keys are saved in order, so most of the path is usually the same as the previous one */
+        len = min( name->len, info->last_len ) / sizeof(WCHAR);
+        for (i = 0; i < len; i++)
+        {
+            if (memicmp_strW( name->str + i, info->last_name + i, sizeof(WCHAR) )) break;
+            if (name->str[i] == '\\') start = i + 1;
+        }
+        if (i == len && ((name->len == info->last_len) ||
+                         (name->len > info->last_len && name->str[len] == '\\') ||
+                         (name->len < info->last_len && info->last_name[len] == '\\')))
+            start = len + 1;
+
+        /* go up from the previous key to the one at the end of the common path */
+        key = info->last_key;
+        if (start <= info->last_len / sizeof(WCHAR))
+        {
+            key = key->parent;
+            for (i = start; i < info->last_len / sizeof(WCHAR); i++)
+                if (info->last_name[i] == '\\') key = key->parent;
+        }
+        if (start >= name->len / sizeof(WCHAR)) return (struct key *)grab_object( key );
+        rest.str = name->str + start;
+        rest.len = name->len - start * sizeof(WCHAR);
+        if (rest.str[0] == '\\')  /* empty path element, let the full lookup deal with it */
+        {
+            key = base;
+            rest = *name;
+        }
+    }
+
+    if (!(ret = create_key_recursive( key, &rest, 0 ))) return NULL;
+
+    if (info->last_key) release_object( info->last_key );
+    info->last_key = NULL;
+    if (is_key_path( ret, base, name ) && (last_name = realloc( info->last_name, name->len )))
+    {
+        memcpy( last_name, name->str, name->len );
+        info->last_name = last_name;
+        info->last_len  = name->len;
+        info->last_key  = (struct key *)grab_object( ret );
+    }
+    return ret;
+}
+
 /* load and create a key from the input file */
 static struct key *load_key( struct key *base, const char *buffer, int prefix_len,
                              struct file_load_info *info, timeout_t *modif )
@@ -1410,7 +1559,7 @@ static struct key *load_key( struct key *base, const char *buffer, int prefix_le
     }
     name.str = p;
     name.len = len - (p - info->tmp + 1) * sizeof(WCHAR);
-    return create_key_recursive( base, &name, 0 );
+    return create_loaded_key( base, &name, info );
 }
 
 /* update the modification time of a key (and its parents) after it has been loaded from a file */
@@ -1652,6 +1801,9 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
     info.len    = 4;
     info.tmplen = 4;
     info.line   = 0;
+    info.last_key  = NULL;
+    info.last_name = NULL;
+    info.last_len  = 0;
     if (!(info.buffer = mem_alloc( info.len ))) return;
     if (!(info.tmp = mem_alloc( info.tmplen )))
     {
@@ -1706,6 +1858,8 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
         update_key_time( subkey, modif );
         release_object( subkey );
     }
+    if (info.last_key) release_object( info.last_key );
+    free( info.last_name );
     free( info.buffer );
     free( info.tmp );
 }
@@ -1932,20 +2086,14 @@ static void save_registry( struct key *key, obj_handle_t handle )
     }
 }
 
-/* save a registry branch to a file */
-static int save_branch( struct key *key, const char *path )
+/* write a registry branch to a file, without changing its dirty state */
+static int write_branch( struct key *key, const char *path )
 {
     struct stat st;
     char *p, *tmp = NULL;
     int fd, count = 0, ret = 0;
     FILE *f;
 
-    if (!(key->flags & KEY_DIRTY))
-    {
-        if (debug_level > 1) dump_operation( key, NULL, "Not saving clean" );
-        return 1;
-    }
-
     /* test the file type */
 
     if ((fd = open( path, O_WRONLY )) != -1)
@@ -2002,10 +2150,93 @@ static int save_branch( struct key *key, const char *path )
 
 done:
     free( tmp );
-    if (ret) make_clean( key );
     return ret;
 }
 
+/* save a registry branch to a file */
+static int save_branch( struct key *key, const char *path )
+{
+    if (!(key->flags & KEY_DIRTY))
+    {
+        if (debug_level > 1) dump_operation( key, NULL, "Not saving clean" );
+        return 1;
+    }
+    if (!write_branch( key, path )) return 0;
+    make_clean( key );
+    return 1;
+}
+
+/* collect the result of a background save; return 0 if it is still running */
+static int finish_background_save( struct save_branch_info *info, int wait )
+{
+    char result = 0;
+    int ret;
+
+    if (wait) waitpid( info->pid, NULL, 0 );
+    if ((ret = read( info->result_fd, &result, 1 )) == -1 && errno == EAGAIN) return 0;
+
+    close( info->result_fd );
+    if (!wait) waitpid( info->pid, NULL, WNOHANG );
+    info->pid = 0;
+    /* the branch was marked clean when the save started, make sure it gets saved again */
+    if (ret != 1 || !result) make_dirty( info->key );
+    return 1;
+}
+
+static void check_background_saves( void *arg )
+{
+    int i, pending = 0;
+
+    save_check_user = NULL;
+    for (i = 0; i < save_branch_count; i++)
+        if (save_branch_info[i].pid && !finish_background_save( &save_branch_info[i], 0 )) pending = 1;
+    if (pending) save_check_user = add_timeout_user( save_check_period, check_background_saves, NULL );
+}
+
+/* save a branch in a forked process working on a copy-on-write snapshot of the registry */
+static void save_branch_background( struct save_branch_info *info )
+{
+    char result;
+    pid_t pid;
+    int i, max_fd, fd[2];
+
+    if (info->pid) return;  /* still saving, it stays dirty for the next period */
+    if (!(info->key->flags & KEY_DIRTY))
+    {
+        if (debug_level > 1) dump_operation( info->key, NULL, "Not saving clean" );
+        return;
+    }
+    if (pipe( fd ) == -1)
+    {
+        save_branch( info->key, info->path );
+        return;
+    }
+
+    if (!(pid = fork()))
+    {
+        /* don't keep client sockets and files alive while saving */
+        max_fd = sysconf( _SC_OPEN_MAX );
+        for (i = 3; i < max_fd; i++) if (i != fd[1]) close( i );
+        result = write_branch( info->key, info->path );
+        write( fd[1], &result, 1 );
+        _exit( 0 );
+    }
+    close( fd[1] );
+    if (pid == -1)
+    {
+        close( fd[0] );
+        save_branch( info->key, info->path );
+        return;
+    }
+
+    fcntl( fd[0], F_SETFL, O_NONBLOCK );
+    info->pid = pid;
+    info->result_fd = fd[0];
+    /* changes made from now on aren't part of the snapshot and dirty the branch again */
+    make_clean( info->key );
+    if (!save_check_user) save_check_user = add_timeout_user( save_check_period, check_background_saves, NULL );
+}
+
 /* periodic saving of the registry */
 static void periodic_save( void *arg )
 {
@@ -2013,8 +2244,7 @@ static void periodic_save( void *arg )
 
     if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
-    for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
+    for (i = 0; i < save_branch_count; i++) save_branch_background( &save_branch_info[i] );
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
     set_periodic_save_timer();
 }
@@ -2034,6 +2264,8 @@ void flush_registry(void)
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
+        /* don't let a running background save overwrite the file later on */
+        if (save_branch_info[i].pid) finish_background_save( &save_branch_info[i], 1 );
         if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
         {
             fprintf( stderr, "wineserver: could not save registry branch to %s",
@@ -230,6 +230,8 @@ const void *get_req_data_after_objattr( const struct object_attributes *attr, da
     return (const char *)get_req_data() + size;
 }
 
+static void handle_buffered_requests( struct thread *thread );
+
 /* write the remaining part of the reply */
 void write_reply( struct thread *thread )
 {
@@ -246,6 +248,7 @@ void write_reply( struct thread *thread )
             /* sent everything, can go back to waiting for requests */
             set_fd_events( thread->request_fd, POLLIN );
             set_fd_events( thread->reply_fd, 0 );
+            handle_buffered_requests( thread );
         }
         return;
     }
@@ -302,6 +305,7 @@ static void call_req_handler( struct thread *thread )
 {
     union generic_reply reply;
     enum request req = thread->req.request_header.req;
+    timeout_t start = 0;
 
     current = thread;
     current->reply_size = 0;
@@ -309,12 +313,15 @@ static void call_req_handler( struct thread *thread )
     memset( &reply, 0, sizeof(reply) );
 
     if (debug_level) trace_request();
+    if (request_stats) start = monotonic_counter();
 
     if (req < REQ_NB_REQUESTS)
         req_handlers[req]( &current->req, &reply );
     else
         set_error( STATUS_NOT_IMPLEMENTED );
 
+    if (request_stats) add_request_stats( req, monotonic_counter() - start );
+
     if (current)
     {
         if (current->reply_fd)
@@ -333,27 +340,68 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
-/* read a request from a thread */
-void read_request( struct thread *thread )
+/* free the variable-size data of the current request */
+void free_req_data( struct thread *thread )
 {
-    int ret;
+    if (thread->req_data != thread->req_buffer + sizeof(thread->req)) free( thread->req_data );
+    thread->req_data = NULL;
+}
 
-    if (!thread->req_toread)  /* no pending request */
+/* handle the requests that are complete in the request buffer */
+/* a client may queue several requests at once, the replies are sent in order */
+static void handle_buffered_requests( struct thread *thread )
+{
+    data_size_t size, avail;
+
+    while (thread->req_buffered >= sizeof(thread->req))
     {
-        if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
-                         sizeof(thread->req) )) != sizeof(thread->req)) goto error;
-        if (!(thread->req_toread = thread->req.request_header.request_size))
+        /* wait until the previous reply has been sent */
+        if (thread->reply_towrite || thread->state == TERMINATED) return;
+
+        memcpy( &thread->req, thread->req_buffer, sizeof(thread->req) );
+        size  = thread->req.request_header.request_size;
+        avail = thread->req_buffered - sizeof(thread->req);
+
+        if (size <= avail)
         {
-            /* no data, handle request at once */
+            thread->req_data = thread->req_buffer + sizeof(thread->req);
             call_req_handler( thread );
-            return;
+            thread->req_data = NULL;
+            size += sizeof(thread->req);
+            if (thread->req_buffered < size) return;  /* the thread has been killed */
+            memmove( thread->req_buffer, thread->req_buffer + size, thread->req_buffered - size );
+            thread->req_buffered -= size;
+            continue;
         }
-        if (!(thread->req_data = malloc( thread->req_toread )))
+
+        /* wait for the rest of the data if it fits in the buffer */
+        if (size <= sizeof(thread->req_buffer) - sizeof(thread->req)) return;
+
+        if (!(thread->req_data = malloc( size )))
         {
             fatal_protocol_error( thread, "no memory for %u bytes request %d\n",
-                                  thread->req_toread, thread->req.request_header.req );
+                                  size, thread->req.request_header.req );
             return;
         }
+        memcpy( thread->req_data, thread->req_buffer + sizeof(thread->req), avail );
+        thread->req_toread = size - avail;
+        thread->req_buffered = 0;
+        return;
+    }
+}
+
+/* read a request from a thread */
+void read_request( struct thread *thread )
+{
+    int ret;
+
+    if (!thread->req_toread)  /* no pending request */
+    {
+        if ((ret = read( get_unix_fd( thread->request_fd ), thread->req_buffer + thread->req_buffered,
+                         sizeof(thread->req_buffer) - thread->req_buffered )) <= 0) goto error;
+        thread->req_buffered += ret;
+        handle_buffered_requests( thread );
+        return;
     }
 
     /* read the variable sized data */
@@ -367,8 +415,7 @@ void read_request( struct thread *thread )
         if (!(thread->req_toread -= ret))
         {
             call_req_handler( thread );
-            free( thread->req_data );
-            thread->req_data = NULL;
+            free_req_data( thread );
             return;
         }
     }
@@ -53,6 +53,7 @@ extern const void *get_req_data_after_objattr( const struct object_attributes *a
 extern int receive_fd( struct process *process );
 extern int send_client_fd( struct process *process, int fd, obj_handle_t handle );
 extern void read_request( struct thread *thread );
+extern void free_req_data( struct thread *thread );
 extern void write_reply( struct thread *thread );
 extern timeout_t monotonic_counter(void);
 extern void open_master_socket(void);
@@ -65,6 +66,9 @@ extern int server_dir_fd, config_dir_fd;
 
 extern void trace_request(void);
 extern void trace_reply( enum request req, const union generic_reply *reply );
+extern void init_request_stats(void);
+extern void add_request_stats( enum request req, timeout_t time );
+extern int request_stats;
 
 /* get current tick count to return to client */
 static inline unsigned int get_tick_count(void)
@@ -144,6 +148,7 @@ DECL_HANDLER(get_apc_result);
 DECL_HANDLER(close_handle);
 DECL_HANDLER(set_handle_info);
 DECL_HANDLER(dup_handle);
+DECL_HANDLER(get_shared_handle_table);
 DECL_HANDLER(make_temporary);
 DECL_HANDLER(open_process);
 DECL_HANDLER(open_thread);
@@ -305,7 +310,6 @@ DECL_HANDLER(set_active_window);
 DECL_HANDLER(set_capture_window);
 DECL_HANDLER(set_caret_window);
 DECL_HANDLER(set_caret_info);
-DECL_HANDLER(get_active_hooks);
 DECL_HANDLER(set_hook);
 DECL_HANDLER(remove_hook);
 DECL_HANDLER(start_hook_chain);
@@ -380,6 +384,7 @@ DECL_HANDLER(set_window_layered_info);
 DECL_HANDLER(alloc_user_handle);
 DECL_HANDLER(free_user_handle);
 DECL_HANDLER(set_cursor);
+DECL_HANDLER(get_desktop_shared_mapping);
 DECL_HANDLER(get_cursor_history);
 DECL_HANDLER(get_rawinput_buffer);
 DECL_HANDLER(update_rawinput_devices);
@@ -437,6 +442,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_close_handle,
     (req_handler)req_set_handle_info,
     (req_handler)req_dup_handle,
+    (req_handler)req_get_shared_handle_table,
     (req_handler)req_make_temporary,
     (req_handler)req_open_process,
     (req_handler)req_open_thread,
@@ -598,7 +604,6 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_capture_window,
     (req_handler)req_set_caret_window,
     (req_handler)req_set_caret_info,
-    (req_handler)req_get_active_hooks,
     (req_handler)req_set_hook,
     (req_handler)req_remove_hook,
     (req_handler)req_start_hook_chain,
@@ -673,6 +678,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_alloc_user_handle,
     (req_handler)req_free_user_handle,
     (req_handler)req_set_cursor,
+    (req_handler)req_get_desktop_shared_mapping,
     (req_handler)req_get_cursor_history,
     (req_handler)req_get_rawinput_buffer,
     (req_handler)req_update_rawinput_devices,
@@ -909,6 +915,7 @@ C_ASSERT( FIELD_OFFSET(struct dup_handle_reply, handle) == 8 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_reply, self) == 12 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_reply, closed) == 16 );
 C_ASSERT( sizeof(struct dup_handle_reply) == 24 );
+C_ASSERT( sizeof(struct get_shared_handle_table_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct make_temporary_request, handle) == 12 );
 C_ASSERT( sizeof(struct make_temporary_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct open_process_request, pid) == 12 );
@@ -1095,7 +1102,9 @@ C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, mask) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, sstate) == 20 );
 C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, cstate) == 24 );
-C_ASSERT( sizeof(struct enable_socket_event_request) == 32 );
+C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, cvalue) == 32 );
+C_ASSERT( FIELD_OFFSET(struct enable_socket_event_request, information) == 40 );
+C_ASSERT( sizeof(struct enable_socket_event_request) == 48 );
 C_ASSERT( FIELD_OFFSET(struct set_socket_deferred_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_socket_deferred_request, deferred) == 16 );
 C_ASSERT( sizeof(struct set_socket_deferred_request) == 24 );
@@ -1331,6 +1340,7 @@ C_ASSERT( FIELD_OFFSET(struct get_atom_information_reply, total) == 16 );
 C_ASSERT( sizeof(struct get_atom_information_reply) == 24 );
 C_ASSERT( sizeof(struct get_msg_queue_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_msg_queue_reply, handle) == 8 );
+C_ASSERT( FIELD_OFFSET(struct get_msg_queue_reply, status_idx) == 12 );
 C_ASSERT( sizeof(struct get_msg_queue_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_queue_fd_request, handle) == 12 );
 C_ASSERT( sizeof(struct set_queue_fd_request) == 16 );
@@ -1387,7 +1397,8 @@ C_ASSERT( FIELD_OFFSET(struct get_message_reply, type) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, x) == 36 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, y) == 40 );
 C_ASSERT( FIELD_OFFSET(struct get_message_reply, time) == 44 );
-C_ASSERT( FIELD_OFFSET(struct get_message_reply, total) == 48 );
+C_ASSERT( FIELD_OFFSET(struct get_message_reply, active_hooks) == 48 );
+C_ASSERT( FIELD_OFFSET(struct get_message_reply, total) == 52 );
 C_ASSERT( sizeof(struct get_message_reply) == 56 );
 C_ASSERT( FIELD_OFFSET(struct reply_message_request, remove) == 12 );
 C_ASSERT( FIELD_OFFSET(struct reply_message_request, result) == 16 );
@@ -1741,11 +1752,14 @@ C_ASSERT( sizeof(struct get_thread_input_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, focus) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, capture) == 12 );
 C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, active) == 16 );
-C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, menu_owner) == 20 );
-C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, move_size) == 24 );
-C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, caret) == 28 );
-C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, rect) == 32 );
-C_ASSERT( sizeof(struct get_thread_input_reply) == 48 );
+C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, foreground) == 20 );
+C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, menu_owner) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, move_size) == 28 );
+C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, caret) == 32 );
+C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, cursor) == 36 );
+C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, show_count) == 40 );
+C_ASSERT( FIELD_OFFSET(struct get_thread_input_reply, rect) == 44 );
+C_ASSERT( sizeof(struct get_thread_input_reply) == 64 );
 C_ASSERT( sizeof(struct get_last_input_time_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_last_input_time_reply, time) == 8 );
 C_ASSERT( sizeof(struct get_last_input_time_reply) == 16 );
@@ -1797,9 +1811,6 @@ C_ASSERT( FIELD_OFFSET(struct set_caret_info_reply, old_rect) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_caret_info_reply, old_hide) == 28 );
 C_ASSERT( FIELD_OFFSET(struct set_caret_info_reply, old_state) == 32 );
 C_ASSERT( sizeof(struct set_caret_info_reply) == 40 );
-C_ASSERT( sizeof(struct get_active_hooks_request) == 16 );
-C_ASSERT( FIELD_OFFSET(struct get_active_hooks_reply, active_hooks) == 8 );
-C_ASSERT( sizeof(struct get_active_hooks_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_hook_request, id) == 12 );
 C_ASSERT( FIELD_OFFSET(struct set_hook_request, pid) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_hook_request, tid) == 20 );
@@ -2216,6 +2227,9 @@ C_ASSERT( FIELD_OFFSET(struct set_cursor_reply, new_y) == 28 );
 C_ASSERT( FIELD_OFFSET(struct set_cursor_reply, new_clip) == 32 );
 C_ASSERT( FIELD_OFFSET(struct set_cursor_reply, last_change) == 48 );
 C_ASSERT( sizeof(struct set_cursor_reply) == 56 );
+C_ASSERT( sizeof(struct get_desktop_shared_mapping_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_desktop_shared_mapping_reply, handle) == 8 );
+C_ASSERT( sizeof(struct get_desktop_shared_mapping_reply) == 16 );
 C_ASSERT( sizeof(struct get_cursor_history_request) == 16 );
 C_ASSERT( sizeof(struct get_cursor_history_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_rawinput_buffer_request, rawinput_size) == 12 );
@@ -1886,6 +1886,9 @@ DECL_HANDLER(enable_socket_event)
                                                FILE_WRITE_ATTRIBUTES, &sock_ops)))
         return;
 
+    /* queue the completion first, as reselecting may complete pending asyncs */
+    if (req->cvalue) fd_add_completion( sock->fd, req->cvalue, STATUS_SUCCESS, req->information, FALSE );
+
     if (get_unix_fd( sock->fd ) == -1) return;
 
     /* for event-based notification, windows erases stale events */
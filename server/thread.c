@@ -283,6 +283,7 @@ static inline void init_thread_structure( struct thread *thread )
     thread->error           = 0;
     thread->req_data        = NULL;
     thread->req_toread      = 0;
+    thread->req_buffered    = 0;
     thread->reply_data      = NULL;
     thread->reply_towrite   = 0;
     thread->request_fd      = NULL;
@@ -466,7 +467,7 @@ static void cleanup_thread( struct thread *thread )
     }
     clear_apc_queue( &thread->system_apc );
     clear_apc_queue( &thread->user_apc );
-    free( thread->req_data );
+    free_req_data( thread );
     free( thread->reply_data );
     if (thread->request_fd) release_object( thread->request_fd );
     if (thread->reply_fd) release_object( thread->reply_fd );
@@ -485,6 +486,7 @@ static void cleanup_thread( struct thread *thread )
     }
     free( thread->desc );
     thread->req_data = NULL;
+    thread->req_buffered = 0;
     thread->reply_data = NULL;
     thread->request_fd = NULL;
     thread->reply_fd = NULL;
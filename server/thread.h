@@ -45,6 +45,7 @@ struct inflight_fd
     int server;  /* fd on the server side */
 };
 #define MAX_INFLIGHT_FDS 16  /* max number of fds in flight per thread */
+#define REQ_BUFFER_SIZE 1024  /* size of the buffer for incoming requests */
 
 struct thread
 {
@@ -67,6 +68,8 @@ struct thread
     unsigned int           error;         /* current error code */
     union generic_request  req;           /* current request */
     void                  *req_data;      /* variable-size data for request */
+    unsigned int           req_buffered;  /* amount of data in the request buffer */
+    char                   req_buffer[REQ_BUFFER_SIZE]; /* buffer for incoming requests */
     unsigned int           req_toread;    /* amount of data still to read in request */
     void                  *reply_data;    /* variable-size data for reply */
     unsigned int           reply_size;    /* size of reply data */
@@ -24,6 +24,7 @@
 #include <ctype.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/types.h>
 
 #ifdef HAVE_SYS_UIO_H
@@ -1706,6 +1707,10 @@ static void dump_dup_handle_reply( const struct dup_handle_reply *req )
     fprintf( stderr, ", closed=%d", req->closed );
 }
 
+static void dump_get_shared_handle_table_request( const struct get_shared_handle_table_request *req )
+{
+}
+
 static void dump_make_temporary_request( const struct make_temporary_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -2097,6 +2102,8 @@ static void dump_enable_socket_event_request( const struct enable_socket_event_r
     fprintf( stderr, ", mask=%08x", req->mask );
     fprintf( stderr, ", sstate=%08x", req->sstate );
     fprintf( stderr, ", cstate=%08x", req->cstate );
+    dump_uint64( ", cvalue=", &req->cvalue );
+    dump_uint64( ", information=", &req->information );
 }
 
 static void dump_set_socket_deferred_request( const struct set_socket_deferred_request *req )
@@ -2603,6 +2610,7 @@ static void dump_get_msg_queue_request( const struct get_msg_queue_request *req
 static void dump_get_msg_queue_reply( const struct get_msg_queue_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", status_idx=%08x", req->status_idx );
 }
 
 static void dump_set_queue_fd_request( const struct set_queue_fd_request *req )
@@ -2677,6 +2685,7 @@ static void dump_send_hardware_message_reply( const struct send_hardware_message
     fprintf( stderr, ", prev_y=%d", req->prev_y );
     fprintf( stderr, ", new_x=%d", req->new_x );
     fprintf( stderr, ", new_y=%d", req->new_y );
+    dump_varargs_bytes( ", keystate=", cur_size );
 }
 
 static void dump_get_message_request( const struct get_message_request *req )
@@ -2700,6 +2709,7 @@ static void dump_get_message_reply( const struct get_message_reply *req )
     fprintf( stderr, ", x=%d", req->x );
     fprintf( stderr, ", y=%d", req->y );
     fprintf( stderr, ", time=%08x", req->time );
+    fprintf( stderr, ", active_hooks=%08x", req->active_hooks );
     fprintf( stderr, ", total=%u", req->total );
     dump_varargs_message_data( ", data=", cur_size );
 }
@@ -3404,9 +3414,12 @@ static void dump_get_thread_input_reply( const struct get_thread_input_reply *re
     fprintf( stderr, " focus=%08x", req->focus );
     fprintf( stderr, ", capture=%08x", req->capture );
     fprintf( stderr, ", active=%08x", req->active );
+    fprintf( stderr, ", foreground=%08x", req->foreground );
     fprintf( stderr, ", menu_owner=%08x", req->menu_owner );
     fprintf( stderr, ", move_size=%08x", req->move_size );
     fprintf( stderr, ", caret=%08x", req->caret );
+    fprintf( stderr, ", cursor=%08x", req->cursor );
+    fprintf( stderr, ", show_count=%d", req->show_count );
     dump_rectangle( ", rect=", &req->rect );
 }
 
@@ -3514,15 +3527,6 @@ static void dump_set_caret_info_reply( const struct set_caret_info_reply *req )
     fprintf( stderr, ", old_state=%d", req->old_state );
 }
 
-static void dump_get_active_hooks_request( const struct get_active_hooks_request *req )
-{
-}
-
-static void dump_get_active_hooks_reply( const struct get_active_hooks_reply *req )
-{
-    fprintf( stderr, " active_hooks=%08x", req->active_hooks );
-}
-
 static void dump_set_hook_request( const struct set_hook_request *req )
 {
     fprintf( stderr, " id=%d", req->id );
@@ -4369,6 +4373,15 @@ static void dump_set_cursor_reply( const struct set_cursor_reply *req )
     fprintf( stderr, ", last_change=%08x", req->last_change );
 }
 
+static void dump_get_desktop_shared_mapping_request( const struct get_desktop_shared_mapping_request *req )
+{
+}
+
+static void dump_get_desktop_shared_mapping_reply( const struct get_desktop_shared_mapping_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_get_cursor_history_request( const struct get_cursor_history_request *req )
 {
 }
@@ -4635,6 +4648,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_close_handle_request,
     (dump_func)dump_set_handle_info_request,
     (dump_func)dump_dup_handle_request,
+    (dump_func)dump_get_shared_handle_table_request,
     (dump_func)dump_make_temporary_request,
     (dump_func)dump_open_process_request,
     (dump_func)dump_open_thread_request,
@@ -4796,7 +4810,6 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_capture_window_request,
     (dump_func)dump_set_caret_window_request,
     (dump_func)dump_set_caret_info_request,
-    (dump_func)dump_get_active_hooks_request,
     (dump_func)dump_set_hook_request,
     (dump_func)dump_remove_hook_request,
     (dump_func)dump_start_hook_chain_request,
@@ -4871,6 +4884,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_alloc_user_handle_request,
     (dump_func)dump_free_user_handle_request,
     (dump_func)dump_set_cursor_request,
+    (dump_func)dump_get_desktop_shared_mapping_request,
     (dump_func)dump_get_cursor_history_request,
     (dump_func)dump_get_rawinput_buffer_request,
     (dump_func)dump_update_rawinput_devices_request,
@@ -4926,6 +4940,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_handle_info_reply,
     (dump_func)dump_dup_handle_reply,
     NULL,
+    NULL,
     (dump_func)dump_open_process_reply,
     (dump_func)dump_open_thread_reply,
     (dump_func)dump_select_reply,
@@ -5086,7 +5101,6 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_capture_window_reply,
     (dump_func)dump_set_caret_window_reply,
     (dump_func)dump_set_caret_info_reply,
-    (dump_func)dump_get_active_hooks_reply,
     (dump_func)dump_set_hook_reply,
     (dump_func)dump_remove_hook_reply,
     (dump_func)dump_start_hook_chain_reply,
@@ -5161,6 +5175,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_alloc_user_handle_reply,
     NULL,
     (dump_func)dump_set_cursor_reply,
+    (dump_func)dump_get_desktop_shared_mapping_reply,
     (dump_func)dump_get_cursor_history_reply,
     (dump_func)dump_get_rawinput_buffer_reply,
     NULL,
@@ -5215,6 +5230,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "close_handle",
     "set_handle_info",
     "dup_handle",
+    "get_shared_handle_table",
     "make_temporary",
     "open_process",
     "open_thread",
@@ -5376,7 +5392,6 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_capture_window",
     "set_caret_window",
     "set_caret_info",
-    "get_active_hooks",
     "set_hook",
     "remove_hook",
     "start_hook_chain",
@@ -5451,6 +5466,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "alloc_user_handle",
     "free_user_handle",
     "set_cursor",
+    "get_desktop_shared_mapping",
     "get_cursor_history",
     "get_rawinput_buffer",
     "update_rawinput_devices",
@@ -5708,3 +5724,40 @@ void trace_reply( enum request req, const union generic_reply *reply )
     else fprintf( stderr, "%04x: %d() = %s\n",
                   current->id, req, get_status_name(current->error) );
 }
+
+/* request statistics, collected when WINESERVERSTATS is set */
+
+int request_stats = 0;
+
+static struct
+{
+    unsigned int count;  /* number of calls */
+    timeout_t    time;   /* total time spent in the handler */
+} request_stats_table[REQ_NB_REQUESTS];
+
+static void dump_request_stats(void)
+{
+    unsigned int i;
+
+    fprintf( stderr, "wineserver: request statistics\n" );
+    for (i = 0; i < REQ_NB_REQUESTS; i++)
+    {
+        if (!request_stats_table[i].count) continue;
+        fprintf( stderr, "  %-32s %8u calls, %12.3f ms total, %8.3f us average\n", req_names[i],
+                 request_stats_table[i].count, request_stats_table[i].time / 10000.0,
+                 request_stats_table[i].time / 10.0 / request_stats_table[i].count );
+    }
+}
+
+void init_request_stats(void)
+{
+    request_stats = 1;
+    atexit( dump_request_stats );
+}
+
+void add_request_stats( enum request req, timeout_t time )
+{
+    if (req >= REQ_NB_REQUESTS) return;
+    request_stats_table[req].count++;
+    request_stats_table[req].time += time;
+}
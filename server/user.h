@@ -77,8 +77,12 @@ struct desktop
     unsigned int         users;            /* processes and threads using this desktop */
     struct global_cursor cursor;           /* global cursor information */
     unsigned char        keystate[256];    /* asynchronous key state */
+    struct object       *shared_mapping;   /* mapping of the state shared with clients */
+    desktop_shm_t       *shared;           /* server side view of the shared state */
 };
 
+extern void update_desktop_shared( struct desktop *desktop );
+
 /* user handles functions */
 
 extern user_handle_t alloc_user_handle( void *ptr, enum user_object type );
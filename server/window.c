@@ -74,6 +74,9 @@ struct window
     rectangle_t      client_rect;     /* client rectangle (relative to parent client area) */
     struct region   *win_region;      /* region for shaped windows (relative to window rect) */
     struct region   *update_region;   /* update region (relative to window rect) */
+    struct region   *vis_region;      /* cached visible region (relative to window or client rect) */
+    unsigned int     vis_flags;       /* DCX flags the cached visible region was computed for */
+    unsigned int     vis_serial;      /* visible_region_serial when the cache was filled */
     unsigned int     style;           /* window style */
     unsigned int     ex_style;        /* window extended style */
     unsigned int     id;              /* window id */
@@ -188,9 +191,19 @@ static unsigned int get_monitor_dpi( struct window *win )
     return win->dpi ? win->dpi : USER_DEFAULT_SCREEN_DPI;
 }
 
+/* incremented whenever a change can affect the visible region of any window */
+static unsigned int visible_region_serial;
+
+static inline void invalidate_visible_regions(void)
+{
+    visible_region_serial++;
+}
+
 /* link a window at the right place in the siblings list */
 static void link_window( struct window *win, struct window *previous )
 {
+    invalidate_visible_regions();
+
     if (previous == WINPTR_NOTOPMOST)
     {
         if (!(win->ex_style & WS_EX_TOPMOST) && win->is_linked) return;  /* nothing to do */
@@ -282,6 +295,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         list_remove( &win->entry );  /* unlink it from the previous location */
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
+        invalidate_visible_regions();
     }
     return 1;
 }
@@ -306,6 +320,54 @@ static int add_handle_to_array( struct user_handle_array *array, user_handle_t h
     return 1;
 }
 
+/* compute the cache key of a property name, must match the computation in user32 */
+static unsigned int get_property_name_key( const WCHAR *name, data_size_t len )
+{
+    unsigned int key = 2166136261u;
+    data_size_t i;
+
+    for (i = 0; i < len / sizeof(WCHAR); i++)
+    {
+        WCHAR ch = name[i];
+        if (ch >= 'A' && ch <= 'Z') ch += 'a' - 'A';
+        key = (key ^ ch) * 16777619u;
+    }
+    return key | SHM_PROPERTY_NAME_KEY;
+}
+
+static void update_shared_property_key( desktop_shm_t *shared, user_handle_t handle, unsigned int key,
+                                        lparam_t data, int remove )
+{
+    shm_property_t *prop = &shared->properties[SHM_PROPERTY_SLOT( handle, key )];
+
+    if (remove)
+    {
+        if (prop->window == handle && prop->key == key) prop->window = 0;
+        return;
+    }
+    prop->window = handle;
+    prop->key    = key;
+    prop->data   = data;
+}
+
+/* publish a property change to the cache in the desktop shared memory */
+/* this must be done while the property still holds a reference to the atom */
+static void update_shared_property( struct window *win, atom_t atom, lparam_t data, int remove )
+{
+    desktop_shm_t *shared = win->desktop->shared;
+    const WCHAR *name;
+    data_size_t len;
+
+    if (!shared) return;
+
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    update_shared_property_key( shared, win->handle, atom, data, remove );
+    if ((name = get_global_atom_name( NULL, atom, &len )))
+        update_shared_property_key( shared, win->handle, get_property_name_key( name, len ), data, remove );
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_RELEASE );
+}
+
 /* set a window property */
 static void set_property( struct window *win, atom_t atom, lparam_t data, enum property_type type )
 {
@@ -324,6 +386,7 @@ static void set_property( struct window *win, atom_t atom, lparam_t data, enum p
         {
             win->properties[i].type = type;
             win->properties[i].data = data;
+            update_shared_property( win, atom, data, 0 );
             return;
         }
     }
@@ -351,6 +414,7 @@ static void set_property( struct window *win, atom_t atom, lparam_t data, enum p
     win->properties[free].atom = atom;
     win->properties[free].type = type;
     win->properties[free].data = data;
+    update_shared_property( win, atom, data, 0 );
 }
 
 /* remove a window property */
@@ -363,6 +427,7 @@ static lparam_t remove_property( struct window *win, atom_t atom )
         if (win->properties[i].type == PROP_TYPE_FREE) continue;
         if (win->properties[i].atom == atom)
         {
+            update_shared_property( win, atom, 0, 1 );
             release_global_atom( NULL, atom );
             win->properties[i].type = PROP_TYPE_FREE;
             return win->properties[i].data;
@@ -395,6 +460,7 @@ static inline void destroy_properties( struct window *win )
     for (i = 0; i < win->prop_inuse; i++)
     {
         if (win->properties[i].type == PROP_TYPE_FREE) continue;
+        update_shared_property( win, win->properties[i].atom, 0, 1 );
         release_global_atom( NULL, win->properties[i].atom );
     }
     free( win->properties );
@@ -496,6 +562,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     win->last_active    = win->handle;
     win->win_region     = NULL;
     win->update_region  = NULL;
+    win->vis_region     = NULL;
     win->style          = 0;
     win->ex_style       = 0;
     win->id             = 0;
@@ -1018,7 +1085,7 @@ static inline struct window *get_top_clipping_window( struct window *win )
 
 
 /* compute the visible region of a window, in window coordinates */
-static struct region *get_visible_region( struct window *win, unsigned int flags )
+static struct region *compute_visible_region( struct window *win, unsigned int flags )
 {
     struct region *tmp = NULL, *region;
     int offset_x, offset_y;
@@ -1097,6 +1164,39 @@ error:
 }
 
 
+/* get the visible region of a window, reusing the cached one if nothing changed since */
+static struct region *get_visible_region( struct window *win, unsigned int flags )
+{
+    struct region *region;
+
+    flags &= DCX_PARENTCLIP | DCX_WINDOW | DCX_CLIPCHILDREN;
+
+    if (win->vis_region && win->vis_serial == visible_region_serial && win->vis_flags == flags)
+    {
+        if (!(region = create_empty_region())) return NULL;
+        if (copy_region( region, win->vis_region )) return region;
+        free_region( region );
+        return NULL;
+    }
+
+    if (!(region = compute_visible_region( win, flags ))) return NULL;
+
+    if (!win->vis_region) win->vis_region = create_empty_region();
+    if (win->vis_region && copy_region( win->vis_region, region ))
+    {
+        win->vis_flags  = flags;
+        win->vis_serial = visible_region_serial;
+    }
+    else
+    {
+        if (win->vis_region) free_region( win->vis_region );
+        win->vis_region = NULL;
+        clear_error();  /* the cache is optional */
+    }
+    return region;
+}
+
+
 /* clip all children with a custom pixel format out of the visible region */
 static struct region *clip_pixel_format_children( struct window *parent, struct region *parent_clip,
                                                   struct region *region, int offset_x, int offset_y )
@@ -1704,6 +1804,8 @@ static void set_window_pos( struct window *win, struct window *previous,
     else if (swp_flags & SWP_HIDEWINDOW) win->style &= ~WS_VISIBLE;
 
     /* keep children at the same position relative to top right corner when the parent is mirrored */
+    invalidate_visible_regions();
+
     if (win->ex_style & WS_EX_LAYOUTRTL)
     {
         struct window *child;
@@ -1857,6 +1959,7 @@ static void set_window_region( struct window *win, struct region *region, int re
 
     if (win->win_region) free_region( win->win_region );
     win->win_region = region;
+    invalidate_visible_regions();
 
     /* expose anything revealed by the change */
     if (old_vis_rgn && ((exposed_rgn = expose_window( win, &win->window_rect, old_vis_rgn ))))
@@ -1878,6 +1981,7 @@ void destroy_window( struct window *win )
     {
         struct region *vis_rgn = get_visible_region( win, DCX_WINDOW );
         win->style &= ~WS_VISIBLE;
+        invalidate_visible_regions();
         if (vis_rgn)
         {
             struct region *exposed_rgn = expose_window( win, &win->window_rect, vis_rgn );
@@ -1904,6 +2008,7 @@ void destroy_window( struct window *win )
     free_user_handle( win->handle );
     destroy_properties( win );
     list_remove( &win->entry );
+    invalidate_visible_regions();
     if (is_desktop_window(win))
     {
         struct desktop *desktop = win->desktop;
@@ -1919,6 +2024,7 @@ void destroy_window( struct window *win )
     detach_window_thread( win );
     if (win->win_region) free_region( win->win_region );
     if (win->update_region) free_region( win->update_region );
+    if (win->vis_region) free_region( win->vis_region );
     if (win->class) release_class( win->class );
     free( win->text );
     memset( win, 0x55, sizeof(*win) + win->nb_extra_bytes - 1 );
@@ -2139,6 +2245,7 @@ DECL_HANDLER(set_window_info)
         else win->ex_style = (req->ex_style & ~WS_EX_TOPMOST) | (win->ex_style & WS_EX_TOPMOST);
         if (!(win->ex_style & WS_EX_LAYERED)) win->is_layered = 0;
     }
+    if (req->flags & (SET_WIN_STYLE | SET_WIN_EXSTYLE)) invalidate_visible_regions();
     if (req->flags & SET_WIN_ID) win->id = req->id;
     if (req->flags & SET_WIN_INSTANCE) win->instance = req->instance;
     if (req->flags & SET_WIN_UNICODE) win->is_unicode = req->is_unicode;
@@ -2670,6 +2777,7 @@ DECL_HANDLER(update_window_zorder)
         {
             list_remove( &win->entry );
             list_add_before( &ptr->entry, &win->entry );
+            invalidate_visible_regions();
         }
         break;
     }
@@ -23,6 +23,9 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -204,7 +207,7 @@ static void winstation_destroy( struct object *obj )
     list_remove( &winstation->entry );
     if (winstation->clipboard) release_object( winstation->clipboard );
     if (winstation->atom_table) release_object( winstation->atom_table );
-    free( winstation->desktop_names );
+    free_namespace( winstation->desktop_names );
 }
 
 /* retrieve the process window station, checking the handle access rights */
@@ -241,6 +244,11 @@ static struct desktop *create_desktop( const struct unicode_str *name, unsigned
             desktop->users = 0;
             memset( &desktop->cursor, 0, sizeof(desktop->cursor) );
             memset( desktop->keystate, 0, sizeof(desktop->keystate) );
+            desktop->shared = NULL;
+            /* no shared state is not fatal, clients will use the server */
+            if (!(desktop->shared_mapping = create_shared_mapping( sizeof(*desktop->shared),
+                                                                   (void **)&desktop->shared )))
+                clear_error();
             list_add_tail( &winstation->desktops, &desktop->entry );
             list_init( &desktop->hotkeys );
         }
@@ -295,10 +303,27 @@ static void desktop_destroy( struct object *obj )
     if (desktop->msg_window) destroy_window( desktop->msg_window );
     if (desktop->global_hooks) release_object( desktop->global_hooks );
     if (desktop->close_timeout) remove_timeout_user( desktop->close_timeout );
+    if (desktop->shared) munmap( (void *)desktop->shared, sizeof(*desktop->shared) );
+    if (desktop->shared_mapping) release_object( desktop->shared_mapping );
     list_remove( &desktop->entry );
     release_object( desktop->winstation );
 }
 
+/* publish the cursor position and async key state to the shared desktop state */
+void update_desktop_shared( struct desktop *desktop )
+{
+    desktop_shm_t *shared = desktop->shared;
+
+    if (!shared) return;
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    shared->cursor_x           = desktop->cursor.x;
+    shared->cursor_y           = desktop->cursor.y;
+    shared->cursor_last_change = desktop->cursor.last_change;
+    memcpy( shared->keystate, desktop->keystate, sizeof(shared->keystate) );
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_RELEASE );
+}
+
 /* retrieve the thread desktop, checking the handle access rights */
 struct desktop *get_thread_desktop( struct thread *thread, unsigned int access )
 {
@@ -597,6 +622,19 @@ DECL_HANDLER(get_thread_desktop)
 }
 
 
+/* get a section mapping the shared state of the current thread desktop */
+DECL_HANDLER(get_desktop_shared_mapping)
+{
+    struct desktop *desktop;
+
+    if (!(desktop = get_thread_desktop( current, 0 ))) return;
+    if (desktop->shared_mapping)
+        reply->handle = alloc_handle( current->process, desktop->shared_mapping,
+                                      SECTION_MAP_READ | SECTION_QUERY, 0 );
+    release_object( desktop );
+}
+
+
 /* set the thread current desktop */
 DECL_HANDLER(set_thread_desktop)
 {